@@ -0,0 +1,173 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/hot_config.h"
+
+#include <gflags/gflags.h>
+
+#if defined(__linux__)
+#include <signal.h>
+#endif
+#include <string.h>
+
+#include <vector>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/muxer_options.h"
+#include "packager/media/file/file.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+#if defined(__linux__)
+// Set from the SIGHUP handler and polled by the watcher thread.
+// sig_atomic_t keeps the handler async-signal-safe.
+volatile sig_atomic_t g_reload_requested = 0;
+
+void HandleSighup(int signal_number) {
+  g_reload_requested = 1;
+}
+#endif  // defined(__linux__)
+
+// How often the watcher thread polls for a pending reload request.
+const int64_t kPollIntervalMs = 500;
+
+// gflags that are safe to change while a job runs because the code that uses
+// them reads the flag at use time instead of copying it at startup. Flags
+// that are resolved into MuxerOptions, MpdOptions etc. when the job starts
+// do not belong here; reloading them would silently have no effect.
+const char* const kReloadableFlags[] = {
+    "ts_segment_deadline_factor",
+};
+
+bool IsReloadableFlag(const std::string& name) {
+  for (size_t i = 0; i < arraysize(kReloadableFlags); ++i) {
+    if (name == kReloadableFlags[i])
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+HotConfigReloader::HotConfigReloader(const std::string& config_file_path)
+    : SimpleThread("HotConfigReloader"),
+      config_file_path_(config_file_path),
+      stop_event_(true, false),
+      started_(false) {}
+
+HotConfigReloader::~HotConfigReloader() {
+  StopWatching();
+}
+
+bool HotConfigReloader::StartWatching() {
+#if defined(__linux__)
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = HandleSighup;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  if (sigaction(SIGHUP, &action, NULL) != 0) {
+    LOG(ERROR) << "Cannot install SIGHUP handler for hot config reload.";
+    return false;
+  }
+  Start();
+  started_ = true;
+  return true;
+#else
+  LOG(ERROR) << "Hot config reload is only supported on Linux.";
+  return false;
+#endif
+}
+
+void HotConfigReloader::StopWatching() {
+  if (!started_)
+    return;
+  started_ = false;
+  stop_event_.Signal();
+  Join();
+#if defined(__linux__)
+  signal(SIGHUP, SIG_DFL);
+#endif
+}
+
+void HotConfigReloader::Run() {
+#if defined(__linux__)
+  while (!stop_event_.TimedWait(
+      base::TimeDelta::FromMilliseconds(kPollIntervalMs))) {
+    if (g_reload_requested) {
+      g_reload_requested = 0;
+      ApplyConfigFile();
+    }
+  }
+#endif
+}
+
+void HotConfigReloader::ApplyConfigFile() {
+  std::string content;
+  if (!File::ReadFileToString(config_file_path_.c_str(), &content)) {
+    LOG(WARNING) << "Cannot read hot config file '" << config_file_path_
+                 << "'; keeping the current configuration.";
+    return;
+  }
+
+  std::vector<std::string> lines;
+  base::SplitString(content, '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::string line;
+    base::TrimWhitespaceASCII(lines[i], base::TRIM_ALL, &line);
+    if (line.empty() || line[0] == '#')
+      continue;
+    const size_t separator = line.find(' ');
+    if (separator == std::string::npos) {
+      LOG(WARNING) << "Malformed hot config line '" << line << "' ignored.";
+      continue;
+    }
+    const std::string name = line.substr(0, separator);
+    std::string value;
+    base::TrimWhitespaceASCII(line.substr(separator + 1), base::TRIM_ALL,
+                              &value);
+
+    if (name == "segment_duration") {
+      double duration_in_seconds = 0;
+      if (!base::StringToDouble(value, &duration_in_seconds) ||
+          duration_in_seconds <= 0) {
+        LOG(WARNING) << "Invalid segment_duration '" << value << "' ignored.";
+        continue;
+      }
+      MuxerOptions::SetSegmentDurationOverride(duration_in_seconds);
+      LOG(INFO) << "Hot config: segment_duration set to "
+                << duration_in_seconds
+                << " seconds, effective at the next segment boundary.";
+    } else if (name == "minloglevel") {
+      int log_level = 0;
+      if (!base::StringToInt(value, &log_level)) {
+        LOG(WARNING) << "Invalid minloglevel '" << value << "' ignored.";
+        continue;
+      }
+      logging::SetMinLogLevel(log_level);
+      LOG(INFO) << "Hot config: minimum log level set to " << log_level << ".";
+    } else if (IsReloadableFlag(name)) {
+      if (google::SetCommandLineOption(name.c_str(), value.c_str()).empty()) {
+        LOG(WARNING) << "Invalid value '" << value << "' for flag '" << name
+                     << "' ignored.";
+      } else {
+        LOG(INFO) << "Hot config: --" << name << " set to " << value << ".";
+      }
+    } else {
+      LOG(WARNING) << "Setting '" << name
+                   << "' is not hot-reloadable and was ignored.";
+    }
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,60 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef APP_HOT_CONFIG_H_
+#define APP_HOT_CONFIG_H_
+
+#include <string>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/simple_thread.h"
+
+namespace shaka {
+namespace media {
+
+/// Applies safe configuration changes to a running job without tearing the
+/// pipeline down. While started, sending the process a SIGHUP makes the
+/// watcher thread re-read the config file and apply the settings it
+/// contains. Only settings that are consulted while the job runs can be
+/// reloaded; settings that affect segmentation take effect at the next
+/// segment boundary of every running muxer. The file holds one
+/// "<name> <value>" pair per line; empty lines and lines starting with '#'
+/// are ignored, and unknown names are logged and skipped. Linux only;
+/// Start() fails elsewhere.
+class HotConfigReloader : public base::SimpleThread {
+ public:
+  /// @param config_file_path is the file re-read on every SIGHUP.
+  explicit HotConfigReloader(const std::string& config_file_path);
+  ~HotConfigReloader() override;
+
+  /// Install the signal handler and start the watcher thread.
+  /// @return true on success.
+  bool StartWatching();
+
+  /// Stop the watcher thread and join it. Pending reload requests are
+  /// dropped. No-op if StartWatching() did not succeed.
+  void StopWatching();
+
+ private:
+  // base::SimpleThread implementation. Waits for reload requests and applies
+  // the config file until StopWatching() is called.
+  void Run() override;
+
+  // Re-read the config file and apply the settings it contains.
+  void ApplyConfigFile();
+
+  const std::string config_file_path_;
+  base::WaitableEvent stop_event_;
+  bool started_;
+
+  DISALLOW_COPY_AND_ASSIGN(HotConfigReloader);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // APP_HOT_CONFIG_H_
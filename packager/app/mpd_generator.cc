@@ -4,13 +4,21 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <algorithm>
+
 #include "packager/app/mpd_generator_flags.h"
 #include "packager/app/vlog_flags.h"
 #include "packager/base/at_exit.h"
 #include "packager/base/command_line.h"
 #include "packager/base/logging.h"
+#include "packager/base/macros.h"
+#include "packager/base/stl_util.h"
 #include "packager/base/strings/string_split.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/sys_info.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/media/file/file.h"
 #include "packager/mpd/util/mpd_writer.h"
 #include "packager/version/version.h"
 
@@ -27,16 +35,30 @@ const char kUsage[] =
     "audio, and 1 text.\n"
     "Sample Usage:\n"
     "%s --input=\"video1.media_info,video2.media_info,audio1.media_info\" "
-    "--output=\"video_audio.mpd\"";
+    "--output=\"video_audio.mpd\"\n"
+    "For bulk generation, use --batch_input to process many MPDs with a "
+    "worker pool.\n"
+    "MediaInfo files from time-range shards of one stream (--shard_time_range "
+    "packaging runs) are stitched into a single Representation.";
 
 enum ExitStatus {
   kSuccess = 0,
   kEmptyInputError,
   kEmptyOutputError,
-  kFailedToWriteMpdToFileError
+  kFailedToWriteMpdToFileError,
+  kBatchFlagsConflictError,
+  kFailedToReadBatchInputError
 };
 
 ExitStatus CheckRequiredFlags() {
+  if (!FLAGS_batch_input.empty()) {
+    if (!FLAGS_input.empty() || !FLAGS_output.empty()) {
+      LOG(ERROR) << "--input and --output cannot be used with --batch_input.";
+      return kBatchFlagsConflictError;
+    }
+    return kSuccess;
+  }
+
   if (FLAGS_input.empty()) {
     LOG(ERROR) << "--input is required.";
     return kEmptyInputError;
@@ -50,6 +72,71 @@ ExitStatus CheckRequiredFlags() {
   return kSuccess;
 }
 
+// One MPD to generate in --batch_input mode.
+struct BatchJob {
+  std::string output_path;
+  std::vector<std::string> input_files;
+};
+
+// Worker thread for --batch_input. Workers claim the next unprocessed job and
+// write the finished MPD out immediately, so completed manifests stream to
+// disk while the rest of the batch is still in flight.
+class BatchWorker : public base::SimpleThread {
+ public:
+  BatchWorker(const std::vector<BatchJob>& jobs,
+              const std::vector<std::string>& base_urls,
+              base::Lock* lock,
+              size_t* next_job_index,
+              size_t* num_failures)
+      : base::SimpleThread("MpdBatchWorker"),
+        jobs_(jobs),
+        base_urls_(base_urls),
+        lock_(lock),
+        next_job_index_(next_job_index),
+        num_failures_(num_failures) {}
+  ~BatchWorker() override {}
+
+  void Run() override {
+    while (true) {
+      size_t job_index;
+      {
+        base::AutoLock auto_lock(*lock_);
+        if (*next_job_index_ == jobs_.size())
+          return;
+        job_index = (*next_job_index_)++;
+      }
+
+      const BatchJob& job = jobs_[job_index];
+      MpdWriter mpd_writer;
+      for (size_t i = 0; i < base_urls_.size(); ++i)
+        mpd_writer.AddBaseUrl(base_urls_[i]);
+      for (size_t i = 0; i < job.input_files.size(); ++i) {
+        if (!mpd_writer.AddFile(job.input_files[i], job.output_path)) {
+          LOG(WARNING) << "MpdWriter failed to read " << job.input_files[i]
+                       << ", skipping.";
+        }
+      }
+
+      if (mpd_writer.WriteMpdToFile(job.output_path.c_str())) {
+        VLOG(1) << "Wrote MPD to " << job.output_path;
+      } else {
+        LOG(ERROR) << "Failed to write MPD to " << job.output_path;
+        base::AutoLock auto_lock(*lock_);
+        ++*num_failures_;
+      }
+    }
+  }
+
+ private:
+  const std::vector<BatchJob>& jobs_;
+  const std::vector<std::string>& base_urls_;
+  base::Lock* const lock_;
+  size_t* const next_job_index_;
+  size_t* const num_failures_;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchWorker);
+};
+
 ExitStatus RunMpdGenerator() {
   DCHECK_EQ(CheckRequiredFlags(), kSuccess);
   std::vector<std::string> base_urls;
@@ -80,6 +167,76 @@ ExitStatus RunMpdGenerator() {
   return kSuccess;
 }
 
+ExitStatus RunMpdGeneratorBatch() {
+  DCHECK_EQ(CheckRequiredFlags(), kSuccess);
+  std::string batch_content;
+  if (!media::File::ReadFileToString(FLAGS_batch_input.c_str(),
+                                     &batch_content)) {
+    LOG(ERROR) << "Failed to read batch input file " << FLAGS_batch_input;
+    return kFailedToReadBatchInputError;
+  }
+
+  std::vector<std::string> base_urls;
+  if (!FLAGS_base_urls.empty())
+    base::SplitString(FLAGS_base_urls, ',', &base_urls);
+
+  std::vector<std::string> lines;
+  base::SplitString(batch_content, '\n', &lines);
+
+  std::vector<BatchJob> jobs;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::string line = lines[i];
+    if (!line.empty() && *line.rbegin() == '\r')
+      line.resize(line.size() - 1);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    const size_t separator_pos = line.find('=');
+    BatchJob job;
+    if (separator_pos != std::string::npos && separator_pos > 0) {
+      job.output_path = line.substr(0, separator_pos);
+      base::SplitString(line.substr(separator_pos + 1), ',', &job.input_files);
+    }
+    if (job.output_path.empty() || job.input_files.empty()) {
+      LOG(WARNING) << "Malformed batch input line '" << line << "', skipping.";
+      continue;
+    }
+    jobs.push_back(job);
+  }
+
+  if (jobs.empty()) {
+    LOG(ERROR) << "No jobs found in batch input file " << FLAGS_batch_input;
+    return kFailedToReadBatchInputError;
+  }
+
+  const size_t num_threads = std::min(
+      jobs.size(),
+      static_cast<size_t>(FLAGS_batch_threads > 0
+                              ? FLAGS_batch_threads
+                              : base::SysInfo::NumberOfProcessors()));
+
+  base::Lock lock;
+  size_t next_job_index = 0;
+  size_t num_failures = 0;
+  std::vector<BatchWorker*> workers;
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers.push_back(
+        new BatchWorker(jobs, base_urls, &lock, &next_job_index,
+                        &num_failures));
+    workers.back()->Start();
+  }
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i]->Join();
+  STLDeleteElements(&workers);
+
+  if (num_failures > 0) {
+    LOG(ERROR) << num_failures << " of " << jobs.size()
+               << " MPDs failed to generate.";
+    return kFailedToWriteMpdToFileError;
+  }
+  return kSuccess;
+}
+
 int MpdMain(int argc, char** argv) {
   base::AtExitManager exit;
   // Needed to enable VLOG/DVLOG through --vmodule or --v.
@@ -97,7 +254,8 @@ int MpdMain(int argc, char** argv) {
     return status;
   }
 
-  return RunMpdGenerator();
+  return FLAGS_batch_input.empty() ? RunMpdGenerator()
+                                   : RunMpdGeneratorBatch();
 }
 
 }  // namespace
@@ -15,4 +15,15 @@ DEFINE_string(base_urls,
               "",
               "Comma separated BaseURLs for the MPD. The values will be added "
               "as <BaseURL> element(s) immediately under the <MPD> element.");
+DEFINE_string(batch_input,
+              "",
+              "Path to a batch file for generating many MPDs in one run. Each "
+              "line has the form "
+              "'<output MPD file>=<comma separated MediaInfo input files>'. "
+              "Empty lines and lines starting with '#' are ignored. Cannot be "
+              "used together with --input or --output.");
+DEFINE_int32(batch_threads,
+             0,
+             "Number of worker threads to use with --batch_input. 0 uses one "
+             "thread per CPU core.");
 #endif  // APP_MPD_GENERATOR_FLAGS_H_
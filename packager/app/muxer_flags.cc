@@ -26,18 +26,71 @@ DEFINE_double(segment_duration,
               "this parameter sets the duration of a subsegment; otherwise, "
               "this parameter sets the duration of a segment. Actual segment "
               "durations may not be exactly as requested.");
+DEFINE_string(shard_time_range,
+              "",
+              "'start:end' presentation time range in seconds to package, "
+              "e.g. '600:1200'. Used to fan one VOD title across hosts: a "
+              "coordinator runs one packager per shard with the same stream "
+              "descriptors and disjoint ranges, each shard writes its "
+              "segments plus a partial media info file (--output_media_info), "
+              "and mpd_generator stitches the media info files into one "
+              "manifest. Segment numbering is offset automatically so shard "
+              "outputs share one segment template namespace. Ranges should "
+              "start at key frames; video samples before the first key frame "
+              "in range are dropped. Empty packages the whole input.");
 DEFINE_bool(segment_sap_aligned,
             true,
             "Force segments to begin with stream access points.");
+DEFINE_uint64(segment_target_size_bytes,
+              0,
+              "For multi-segment output only. If nonzero, cut segments at "
+              "the first key frame once the estimated segment size reaches "
+              "this many bytes instead of waiting for --segment_duration, "
+              "which then bounds the maximum segment duration; "
+              "--segment_min_duration bounds the minimum. Produces more "
+              "uniform segment sizes for VBR content. 0 keeps duration-based "
+              "segmentation.");
+DEFINE_double(segment_min_duration,
+              0,
+              "Minimum segment duration in seconds when "
+              "--segment_target_size_bytes is set; a key frame arriving "
+              "earlier never cuts a segment even if the byte target has been "
+              "reached.");
 DEFINE_double(fragment_duration,
               10.0f,
               "Fragment duration in seconds. Should not be larger than "
               "the segment duration. Actual fragment durations may not be "
               "exactly as requested.");
+DEFINE_double(audio_fragment_duration,
+              0,
+              "Fragment duration for audio streams in seconds. If 0, audio "
+              "uses --fragment_duration. Audio fragments carry little data "
+              "per fragment, so a 4-8x longer cadence than video batches "
+              "samples into fewer, larger moof+mdat pairs and cuts "
+              "per-fragment overhead; fragments are still cut at segment "
+              "boundaries so segments stay aligned across streams.");
 DEFINE_bool(fragment_sap_aligned,
             true,
             "Force fragments to begin with stream access points. This flag "
             "implies segment_sap_aligned.");
+DEFINE_bool(chunked_fragments,
+            false,
+            "For ISO BMFF live output with a segment template only. Write "
+            "each completed fragment (a moof/mdat pair) through to the "
+            "in-progress segment file immediately, so the origin can serve "
+            "the segment with chunked transfer while it is still being "
+            "produced. Combine with a small --fragment_duration (down to 0 "
+            "with --fragment_sap_aligned=false for per-frame chunks) for "
+            "sub-second end-to-end latency. No SIDX box is emitted for "
+            "chunked segments.");
+DEFINE_string(ad_cues,
+              "",
+              "Semicolon separated list of ad cue points, in presentation "
+              "seconds, e.g. '600;1260.5'. Segments are cut at each cue "
+              "point (at the first key frame at or after it when "
+              "--segment_sap_aligned is set), so ad periods can be spliced "
+              "on segment boundaries without restarting the packaging "
+              "pipeline. Cue points must be strictly increasing.");
 DEFINE_int32(num_subsegments_per_sidx,
              1,
              "For ISO BMFF only. Set the number of subsegments in each "
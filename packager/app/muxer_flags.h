@@ -16,9 +16,15 @@ DECLARE_double(clear_lead);
 DECLARE_bool(single_segment);
 DECLARE_double(segment_duration);
 DECLARE_bool(segment_sap_aligned);
+DECLARE_uint64(segment_target_size_bytes);
+DECLARE_double(segment_min_duration);
 DECLARE_double(fragment_duration);
+DECLARE_double(audio_fragment_duration);
 DECLARE_bool(fragment_sap_aligned);
+DECLARE_bool(chunked_fragments);
+DECLARE_string(ad_cues);
 DECLARE_int32(num_subsegments_per_sidx);
 DECLARE_string(temp_dir);
+DECLARE_string(shard_time_range);
 
 #endif  // APP_MUXER_FLAGS_H_
@@ -0,0 +1,879 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/packager.h"
+
+#include <gflags/gflags.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#include "packager/app/fixed_key_encryption_flags.h"
+#include "packager/app/hls_flags.h"
+#include "packager/app/hot_config.h"
+#include "packager/app/mpd_flags.h"
+#include "packager/app/muxer_flags.h"
+#include "packager/app/packager_util.h"
+#include "packager/app/sampling_profiler.h"
+#include "packager/app/widevine_encryption_flags.h"
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/logging.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/sys_info.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/base/time/clock.h"
+#include "packager/hls/base/hls_notifier.h"
+#include "packager/hls/base/simple_hls_notifier.h"
+#include "packager/media/base/aes_cryptor.h"
+#include "packager/media/base/allocation_tracker.h"
+#include "packager/media/base/container_names.h"
+#include "packager/media/base/demuxer.h"
+#include "packager/media/base/fourccs.h"
+#include "packager/media/base/key_source.h"
+#include "packager/media/base/muxer_options.h"
+#include "packager/media/base/muxer_util.h"
+#include "packager/media/base/producer_consumer_queue.h"
+#include "packager/media/event/checkpointing_muxer_listener.h"
+#include "packager/media/event/hls_notify_muxer_listener.h"
+#include "packager/media/event/mpd_notify_muxer_listener.h"
+#include "packager/media/event/threaded_muxer_listener.h"
+#include "packager/media/event/vod_media_info_dump_muxer_listener.h"
+#include "packager/media/file/file.h"
+#include "packager/media/formats/mp2t/ts_muxer.h"
+#include "packager/media/formats/mp4/mp4_muxer.h"
+#include "packager/media/formats/webm/webm_muxer.h"
+#include "packager/mpd/base/dash_iop_mpd_notifier.h"
+#include "packager/mpd/base/media_info.pb.h"
+#include "packager/mpd/base/mpd_builder.h"
+#include "packager/mpd/base/simple_mpd_notifier.h"
+
+DEFINE_bool(use_fake_clock_for_muxer,
+            false,
+            "Set to true to use a fake clock for muxer. With this flag set, "
+            "creation time and modification time in outputs are set to 0. "
+            "Should only be used for testing.");
+DEFINE_int32(segment_event_queue_size,
+             64,
+             "Maximum number of segment events queued to the manifest thread "
+             "per stream. When the queue is full, e.g. because the manifest "
+             "output is slow, segment production blocks until the manifest "
+             "thread catches up.");
+DEFINE_string(profile_output,
+              "",
+              "If set, sample the packager's own threads with a profiling "
+              "timer for the duration of the job and write a folded-stack "
+              "report (flame graph input) to this file. Linux only.");
+DEFINE_int32(profile_sampling_frequency,
+             97,
+             "Target number of profile samples per second of consumed CPU "
+             "time. Only used when --profile_output is set. A prime "
+             "frequency avoids lockstep with periodic work.");
+DEFINE_int32(max_concurrent_jobs,
+             -1,
+             "Maximum number of input remux jobs to run concurrently when "
+             "multiple inputs are packaged in one process. As jobs finish,"
+             " pending jobs are started to keep this many in flight. A value "
+             "of -1 (the default) sizes the limit to the number of processor "
+             "cores; 0 runs all jobs at once.");
+DEFINE_bool(fault_tolerant_parsing,
+            false,
+            "Skip damaged input ranges and resynchronize instead of aborting "
+            "the job on a mid-stream parser error. Skipped bytes are counted "
+            "and logged. Errors during stream initialization remain fatal.");
+DEFINE_bool(checkpoint_segments,
+            false,
+            "Write a per-stream checkpoint file (<output>.checkpoint) after "
+            "every completed segment of multi-segment output, recording how "
+            "many segments have been written. Used with --resume to restart "
+            "a live channel without renumbering segments.");
+DEFINE_bool(resume,
+            false,
+            "Continue a live channel from existing checkpoint files written "
+            "with --checkpoint_segments: segment numbering resumes where the "
+            "previous process stopped. Streams without a readable checkpoint "
+            "start fresh.");
+DEFINE_string(hot_config_file,
+              "",
+              "File re-read on SIGHUP while a job runs, applying safe "
+              "configuration changes (e.g. segment_duration, minloglevel) "
+              "without restarting the pipeline. One '<name> <value>' pair "
+              "per line; '#' starts a comment. Changes that affect "
+              "segmentation take effect at the next segment boundary. Empty "
+              "disables hot reload. Linux only.");
+DEFINE_string(deterministic_iv_seed,
+              "",
+              "Hex string. When set, generated initialization vectors are "
+              "derived from this seed and a counter instead of the system "
+              "RNG, so reruns of the same job produce byte-identical "
+              "encrypted output (combine with --use_fake_clock_for_muxer for "
+              "MP4). Only reuse a seed to re-encrypt the same content with "
+              "the same key; sharing it across contents repeats ivs.");
+DEFINE_bool(enable_numa_pinning,
+            false,
+            "Pin each remux job and the threads it spawns to a single NUMA "
+            "node, round-robining nodes across jobs, so that samples are "
+            "demuxed, encrypted and muxed on the node where they were "
+            "allocated. Linux only; has no effect on single-node hosts.");
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kMediaInfoSuffix[] = ".media_info";
+const char kCheckpointSuffix[] = ".checkpoint";
+
+// TODO(rkuroiwa): Write TTML and WebVTT parser (demuxing) for a better check
+// and for supporting live/segmenting (muxing).  With a demuxer and a muxer,
+// CreateRemuxJobs() shouldn't treat text as a special case.
+std::string DetermineTextFileFormat(const std::string& file) {
+  std::string content;
+  if (!File::ReadFileToString(file.c_str(), &content)) {
+    LOG(ERROR) << "Failed to open file " << file
+               << " to determine file format.";
+    return "";
+  }
+  MediaContainerName container_name = DetermineContainer(
+      reinterpret_cast<const uint8_t*>(content.data()), content.size());
+  if (container_name == CONTAINER_WEBVTT) {
+    return "vtt";
+  } else if (container_name == CONTAINER_TTML) {
+    return "ttml";
+  }
+
+  return "";
+}
+
+FourCC GetProtectionScheme(const std::string& protection_scheme) {
+  if (protection_scheme == "cenc") {
+    return FOURCC_cenc;
+  } else if (protection_scheme == "cens") {
+    return FOURCC_cens;
+  } else if (protection_scheme == "cbc1") {
+    return FOURCC_cbc1;
+  } else if (protection_scheme == "cbcs") {
+    return FOURCC_cbcs;
+  } else {
+    LOG(ERROR) << "Unknown protection scheme: " << protection_scheme;
+    return FOURCC_NULL;
+  }
+}
+
+#if defined(__linux__)
+// Parses a sysfs cpulist string such as "0-7,16-23" into a cpu_set_t.
+bool ParseCpuList(const std::string& cpulist, cpu_set_t* cpus) {
+  CPU_ZERO(cpus);
+  std::vector<std::string> ranges;
+  base::SplitString(cpulist, ',', &ranges);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    const std::string range =
+        base::CollapseWhitespaceASCII(ranges[i], true /* trim */);
+    if (range.empty())
+      continue;
+    int begin = 0;
+    int end = 0;
+    const size_t dash = range.find('-');
+    if (dash == std::string::npos) {
+      if (!base::StringToInt(range, &begin))
+        return false;
+      end = begin;
+    } else {
+      if (!base::StringToInt(range.substr(0, dash), &begin) ||
+          !base::StringToInt(range.substr(dash + 1), &end)) {
+        return false;
+      }
+    }
+    for (int cpu = begin; cpu <= end && cpu < CPU_SETSIZE; ++cpu)
+      CPU_SET(cpu, cpus);
+  }
+  return CPU_COUNT(cpus) > 0;
+}
+
+// Reads the CPU sets of the host's NUMA nodes from sysfs. Returns an empty
+// vector if the topology cannot be read or the host has a single node, in
+// which case pinning is pointless.
+std::vector<cpu_set_t> ReadNumaTopology() {
+  std::vector<cpu_set_t> nodes;
+  for (int node = 0;; ++node) {
+    std::string cpulist;
+    if (!base::ReadFileToString(
+            base::FilePath(base::StringPrintf(
+                "/sys/devices/system/node/node%d/cpulist", node)),
+            &cpulist)) {
+      break;
+    }
+    cpu_set_t cpus;
+    if (!ParseCpuList(cpulist, &cpus)) {
+      LOG(WARNING) << "Failed to parse CPU list for NUMA node " << node;
+      return std::vector<cpu_set_t>();
+    }
+    nodes.push_back(cpus);
+  }
+  if (nodes.size() < 2)
+    return std::vector<cpu_set_t>();
+  return nodes;
+}
+#endif  // defined(__linux__)
+
+// A fake clock that always return time 0 (epoch). Should only be used for
+// testing.
+class FakeClock : public base::Clock {
+ public:
+  base::Time Now() override { return base::Time(); }
+};
+
+// Runs CreateEncryptionKeySource() on a worker thread so that the key server
+// round trip overlaps opening and sniffing the inputs. For short jobs the
+// fetch dominates startup, so the overlap directly shortens time to first
+// output byte. Get() and Take() must be called from the thread that started
+// the fetcher.
+class EncryptionKeySourceFetcher : public base::SimpleThread {
+ public:
+  EncryptionKeySourceFetcher()
+      : SimpleThread("EncryptionKeySourceFetcher"), joined_(false) {}
+
+  ~EncryptionKeySourceFetcher() override {
+    if (HasBeenStarted() && !joined_)
+      Join();
+  }
+
+  // Blocks until the fetch finishes. Returns NULL if the fetch failed. The
+  // fetcher retains ownership of the key source.
+  KeySource* Get() {
+    EnsureJoined();
+    return key_source_.get();
+  }
+
+  // Blocks until the fetch finishes and releases ownership of the result.
+  scoped_ptr<KeySource> Take() {
+    EnsureJoined();
+    return key_source_.Pass();
+  }
+
+ private:
+  void Run() override { key_source_ = CreateEncryptionKeySource(); }
+
+  void EnsureJoined() {
+    if (!joined_) {
+      Join();
+      joined_ = true;
+    }
+  }
+
+  scoped_ptr<KeySource> key_source_;
+  bool joined_;
+
+  DISALLOW_COPY_AND_ASSIGN(EncryptionKeySourceFetcher);
+};
+
+// Demux, Mux(es) and worker thread used to remux a source file/stream.
+class RemuxJob : public base::SimpleThread {
+ public:
+  RemuxJob(scoped_ptr<Demuxer> demuxer)
+      : SimpleThread("RemuxJob"),
+        demuxer_(demuxer.Pass()),
+        estimated_cost_(0),
+#if defined(__linux__)
+        has_cpu_affinity_(false),
+#endif
+        completion_queue_(NULL) {}
+
+  ~RemuxJob() override {
+    STLDeleteElements(&muxers_);
+  }
+
+  void AddMuxer(scoped_ptr<Muxer> mux) {
+    muxers_.push_back(mux.release());
+  }
+
+  // Set the queue this job announces its completion on. Must be set before
+  // Start and outlive the job thread.
+  void set_completion_queue(ProducerConsumerQueue<RemuxJob*>* queue) {
+    completion_queue_ = queue;
+  }
+
+  // Estimated amount of work in this job, used to order job startup. The
+  // value is only compared against other jobs' estimates.
+  void set_estimated_cost(int64_t estimated_cost) {
+    estimated_cost_ = estimated_cost;
+  }
+  int64_t estimated_cost() const { return estimated_cost_; }
+
+#if defined(__linux__)
+  // Restrict this job to |cpus| (typically one NUMA node). Must be set
+  // before Start().
+  void set_cpu_affinity(const cpu_set_t& cpus) {
+    cpus_ = cpus;
+    has_cpu_affinity_ = true;
+  }
+#endif
+
+  Demuxer* demuxer() { return demuxer_.get(); }
+  Status status() { return status_; }
+
+ private:
+  void Run() override {
+    DCHECK(demuxer_);
+#if defined(__linux__)
+    // Pin before any work runs. Threads spawned by this job (threaded file
+    // IO, muxer listener threads) inherit the affinity, and with the
+    // kernel's first-touch policy the samples this job allocates land on
+    // the same node they are later encrypted and muxed on.
+    if (has_cpu_affinity_ &&
+        sched_setaffinity(0, sizeof(cpus_), &cpus_) != 0) {
+      PLOG(WARNING) << "Failed to set CPU affinity for " << name();
+    }
+#endif
+    status_ = demuxer_->Run();
+    if (completion_queue_)
+      completion_queue_->Push(this, kInfiniteTimeout);
+  }
+
+  scoped_ptr<Demuxer> demuxer_;
+  std::vector<Muxer*> muxers_;
+  int64_t estimated_cost_;
+#if defined(__linux__)
+  cpu_set_t cpus_;
+  bool has_cpu_affinity_;
+#endif
+  Status status_;
+  ProducerConsumerQueue<RemuxJob*>* completion_queue_;
+
+  DISALLOW_COPY_AND_ASSIGN(RemuxJob);
+};
+
+bool StreamInfoToTextMediaInfo(const StreamDescriptor& stream_descriptor,
+                               const MuxerOptions& stream_muxer_options,
+                               MediaInfo* text_media_info) {
+  const std::string& language = stream_descriptor.language;
+  std::string format = DetermineTextFileFormat(stream_descriptor.input);
+  if (format.empty()) {
+    LOG(ERROR) << "Failed to determine the text file format for "
+               << stream_descriptor.input;
+    return false;
+  }
+
+  if (!File::Copy(stream_descriptor.input.c_str(),
+                  stream_muxer_options.output_file_name.c_str())) {
+    LOG(ERROR) << "Failed to copy the input file (" << stream_descriptor.input
+               << ") to output file (" << stream_muxer_options.output_file_name
+               << ").";
+    return false;
+  }
+
+  text_media_info->set_media_file_name(stream_muxer_options.output_file_name);
+  text_media_info->set_container_type(MediaInfo::CONTAINER_TEXT);
+
+  if (stream_muxer_options.bandwidth != 0) {
+    text_media_info->set_bandwidth(stream_muxer_options.bandwidth);
+  } else {
+    // Text files are usually small and since the input is one file; there's no
+    // way for the player to do ranged requests. So set this value to something
+    // reasonable.
+    text_media_info->set_bandwidth(256);
+  }
+
+  MediaInfo::TextInfo* text_info = text_media_info->mutable_text_info();
+  text_info->set_format(format);
+  if (!language.empty())
+    text_info->set_language(language);
+
+  return true;
+}
+
+scoped_ptr<Muxer> CreateOutputMuxer(const MuxerOptions& options,
+                                    MediaContainerName container) {
+  if (container == CONTAINER_WEBM) {
+    return scoped_ptr<Muxer>(new webm::WebMMuxer(options));
+  } else if (container == CONTAINER_MPEG2TS) {
+    return scoped_ptr<Muxer>(new mp2t::TsMuxer(options));
+  } else {
+    DCHECK_EQ(container, CONTAINER_MOV);
+    return scoped_ptr<Muxer>(new mp4::MP4Muxer(options));
+  }
+}
+
+// Returns the set of stream types selected for |input| across all stream
+// descriptors, for pushing selection down into the demuxer. Returns an empty
+// set (parse everything) when the selection cannot be narrowed: a numeric
+// stream selector addresses streams by zero-based index, which requires the
+// full stream list.
+std::set<StreamType> GetDemuxerStreamSelection(
+    const StreamDescriptorList& stream_descriptors,
+    const std::string& input) {
+  std::set<StreamType> stream_types;
+  for (StreamDescriptorList::const_iterator stream_iter =
+           stream_descriptors.begin();
+       stream_iter != stream_descriptors.end(); ++stream_iter) {
+    if (stream_iter->input != input)
+      continue;
+    if (stream_iter->stream_selector == "audio") {
+      stream_types.insert(kStreamAudio);
+    } else if (stream_iter->stream_selector == "video") {
+      stream_types.insert(kStreamVideo);
+    } else if (stream_iter->stream_selector == "text") {
+      stream_types.insert(kStreamText);
+    } else {
+      return std::set<StreamType>();
+    }
+  }
+  return stream_types;
+}
+
+bool CreateRemuxJobs(const StreamDescriptorList& stream_descriptors,
+                     const MuxerOptions& muxer_options,
+                     FakeClock* fake_clock,
+                     KeySource* key_source,
+                     EncryptionKeySourceFetcher* key_source_fetcher,
+                     MpdNotifier* mpd_notifier,
+                     hls::HlsNotifier* hls_notifier,
+                     std::vector<RemuxJob*>* remux_jobs) {
+  DCHECK(remux_jobs);
+
+  std::string previous_input;
+  int stream_number = 0;
+  for (StreamDescriptorList::const_iterator
+           stream_iter = stream_descriptors.begin();
+       stream_iter != stream_descriptors.end();
+       ++stream_iter, ++stream_number) {
+    // Process stream descriptor.
+    MuxerOptions stream_muxer_options(muxer_options);
+    stream_muxer_options.output_file_name = stream_iter->output;
+    if (!stream_iter->segment_template.empty()) {
+      if (!ValidateSegmentTemplate(stream_iter->segment_template)) {
+        LOG(ERROR) << "ERROR: segment template with '"
+                   << stream_iter->segment_template << "' is invalid.";
+        return false;
+      }
+      stream_muxer_options.segment_template = stream_iter->segment_template;
+      if (stream_muxer_options.single_segment) {
+        LOG(WARNING) << "Segment template and single segment are incompatible, "
+                        "setting single segment to false.";
+        stream_muxer_options.single_segment = false;
+      }
+    }
+    stream_muxer_options.bandwidth = stream_iter->bandwidth;
+    stream_muxer_options.trick_play_factor = stream_iter->trick_play_factor;
+
+    // Checkpointing records the per-stream segment count so a restarted
+    // live channel can continue numbering instead of starting over.
+    std::string checkpoint_file_path;
+    if (FLAGS_checkpoint_segments &&
+        !stream_muxer_options.segment_template.empty()) {
+      checkpoint_file_path = stream_iter->output + kCheckpointSuffix;
+      uint64_t checkpointed_segments = 0;
+      if (FLAGS_resume &&
+          CheckpointingMuxerListener::ReadCheckpoint(checkpoint_file_path,
+                                                     &checkpointed_segments)) {
+        LOG(INFO) << "Resuming " << stream_iter->output << " after "
+                  << checkpointed_segments << " checkpointed segments.";
+        stream_muxer_options.initial_segment_number = checkpointed_segments;
+      }
+    }
+
+    // Time-range shards share one segment template namespace: offset this
+    // shard's numbering by the segments the preceding shards own, so the
+    // stitched manifest sees one contiguous sequence.
+    if (stream_muxer_options.shard_end_seconds >
+            stream_muxer_options.shard_start_seconds &&
+        !stream_muxer_options.segment_template.empty() &&
+        stream_muxer_options.initial_segment_number == 0 &&
+        stream_muxer_options.segment_duration > 0) {
+      stream_muxer_options.initial_segment_number =
+          static_cast<uint64_t>(stream_muxer_options.shard_start_seconds /
+                                stream_muxer_options.segment_duration);
+    }
+
+    // Handle text input.
+    if (stream_iter->stream_selector == "text") {
+      MediaInfo text_media_info;
+      if (!StreamInfoToTextMediaInfo(*stream_iter, stream_muxer_options,
+                                     &text_media_info)) {
+        return false;
+      }
+
+      if (mpd_notifier) {
+        uint32 unused;
+        if (!mpd_notifier->NotifyNewContainer(text_media_info, &unused)) {
+          LOG(ERROR) << "Failed to process text file " << stream_iter->input;
+        } else {
+          mpd_notifier->Flush();
+        }
+      } else if (FLAGS_output_media_info) {
+        VodMediaInfoDumpMuxerListener::WriteMediaInfoToFile(
+            text_media_info,
+            stream_muxer_options.output_file_name + kMediaInfoSuffix);
+      } else {
+        NOTIMPLEMENTED()
+            << "--mpd_output or --output_media_info flags are "
+               "required for text output. Skipping manifest related output for "
+            << stream_iter->input;
+      }
+      continue;
+    }
+
+    if (stream_iter->input != previous_input) {
+      // New remux job needed. Create demux and job thread.
+      scoped_ptr<Demuxer> demuxer(new Demuxer(stream_iter->input));
+      if (FLAGS_fault_tolerant_parsing)
+        demuxer->EnableFaultTolerantParsing();
+      // Dumping stream info needs the full stream list, so only narrow the
+      // parse when it is not requested.
+      if (!FLAGS_dump_stream_info) {
+        const std::set<StreamType> selected_stream_types =
+            GetDemuxerStreamSelection(stream_descriptors, stream_iter->input);
+        if (!selected_stream_types.empty())
+          demuxer->SetSelectedStreamTypes(selected_stream_types);
+      }
+      // With a shard time range the demuxer can skip sample processing
+      // outside the range and stop parsing at its end; the muxer-side shard
+      // filter remains the precise boundary.
+      if (muxer_options.shard_end_seconds > muxer_options.shard_start_seconds) {
+        demuxer->SetTimeRange(muxer_options.shard_start_seconds,
+                              muxer_options.shard_end_seconds);
+      }
+      if (FLAGS_enable_widevine_decryption ||
+          FLAGS_enable_fixed_key_decryption) {
+        scoped_ptr<KeySource> key_source(CreateDecryptionKeySource());
+        if (!key_source)
+          return false;
+        demuxer->SetKeySource(key_source.Pass());
+      }
+      Status status = demuxer->Initialize();
+      if (!status.ok()) {
+        LOG(ERROR) << "Demuxer failed to initialize: " << status.ToString();
+        return false;
+      }
+      if (FLAGS_dump_stream_info) {
+        printf("\nFile \"%s\":\n", stream_iter->input.c_str());
+        DumpStreamInfo(demuxer->streams());
+        if (stream_iter->output.empty())
+          continue;  // just need stream info.
+      }
+      remux_jobs->push_back(new RemuxJob(demuxer.Pass()));
+      // Estimate job cost by input size. Unknown sizes (e.g. network
+      // streams) are treated as large so those jobs start early.
+      const int64_t input_size = File::GetFileSize(stream_iter->input.c_str());
+      remux_jobs->back()->set_estimated_cost(
+          input_size < 0 ? std::numeric_limits<int64_t>::max() : input_size);
+      previous_input = stream_iter->input;
+    }
+    DCHECK(!remux_jobs->empty());
+
+    scoped_ptr<Muxer> muxer(
+        CreateOutputMuxer(stream_muxer_options, stream_iter->output_format));
+    if (FLAGS_use_fake_clock_for_muxer) muxer->set_clock(fake_clock);
+
+    if (key_source_fetcher) {
+      // First muxer that needs keys; the fetch has been running since before
+      // the inputs were opened, so this typically does not block.
+      key_source = key_source_fetcher->Get();
+      if (!key_source) {
+        LOG(ERROR) << "Failed to create the encryption key source.";
+        return false;
+      }
+    }
+    if (key_source) {
+      muxer->SetKeySource(key_source,
+                          FLAGS_max_sd_pixels,
+                          FLAGS_clear_lead,
+                          FLAGS_crypto_period_duration,
+                          GetProtectionScheme(FLAGS_protection_scheme));
+    }
+
+    scoped_ptr<MuxerListener> muxer_listener;
+    DCHECK(!(FLAGS_output_media_info && mpd_notifier));
+    if (FLAGS_output_media_info) {
+      const std::string output_media_info_file_name =
+          stream_muxer_options.output_file_name + kMediaInfoSuffix;
+      scoped_ptr<VodMediaInfoDumpMuxerListener>
+          vod_media_info_dump_muxer_listener(
+              new VodMediaInfoDumpMuxerListener(output_media_info_file_name));
+      muxer_listener = vod_media_info_dump_muxer_listener.Pass();
+    }
+    // When both MPD and HLS outputs are specified, a stream feeds the HLS
+    // playlists when its descriptor names a playlist and the MPD otherwise.
+    // This allows packaging both formats from a single demux of the input by
+    // listing the same input stream twice with different outputs.
+    const bool use_hls_listener =
+        hls_notifier &&
+        (!mpd_notifier || !stream_iter->hls_playlist_name.empty());
+    if (mpd_notifier && !use_hls_listener) {
+      scoped_ptr<MpdNotifyMuxerListener> mpd_notify_muxer_listener(
+          new MpdNotifyMuxerListener(mpd_notifier));
+      muxer_listener = mpd_notify_muxer_listener.Pass();
+    }
+
+    if (use_hls_listener) {
+      // TODO(rkuroiwa): Do some smart stuff to group the audios, e.g. detect
+      // languages.
+      std::string group_id = stream_iter->hls_group_id;
+      std::string name = stream_iter->hls_name;
+      std::string hls_playlist_name = stream_iter->hls_playlist_name;
+      if (group_id.empty())
+        group_id = "audio";
+      if (name.empty())
+        name = base::StringPrintf("stream_%d", stream_number);
+      if (hls_playlist_name.empty())
+        hls_playlist_name = base::StringPrintf("stream_%d.m3u8", stream_number);
+
+      muxer_listener.reset(new HlsNotifyMuxerListener(hls_playlist_name, name,
+                                                      group_id, hls_notifier));
+    }
+
+    if (!checkpoint_file_path.empty()) {
+      // The wrapped listener may be NULL when there is no manifest output;
+      // segments are still checkpointed.
+      muxer_listener.reset(new CheckpointingMuxerListener(
+          muxer_listener.Pass(), checkpoint_file_path,
+          stream_muxer_options.initial_segment_number));
+    }
+
+    if (muxer_listener) {
+      // Deliver segment events from a dedicated thread so that manifest
+      // updates never block segment production.
+      muxer_listener.reset(new ThreadedMuxerListener(
+          muxer_listener.Pass(),
+          static_cast<size_t>(FLAGS_segment_event_queue_size)));
+      muxer->SetMuxerListener(muxer_listener.Pass());
+    }
+
+    if (!AddStreamToMuxer(remux_jobs->back()->demuxer()->streams(),
+                          stream_iter->stream_selector,
+                          stream_iter->language,
+                          muxer.get())) {
+      return false;
+    }
+    remux_jobs->back()->AddMuxer(muxer.Pass());
+  }
+
+  return true;
+}
+
+bool CompareJobCost(RemuxJob* a, RemuxJob* b) {
+  return a->estimated_cost() > b->estimated_cost();
+}
+
+Status RunRemuxJobs(const std::vector<RemuxJob*>& remux_jobs) {
+  // Number of jobs to keep in flight at once. Each job runs its own demuxer
+  // thread, so running every input at once on a many-input invocation
+  // oversubscribes the host; by default the limit follows the core count.
+  size_t max_concurrent_jobs = remux_jobs.size();
+  if (FLAGS_max_concurrent_jobs < 0) {
+    const int num_cores = base::SysInfo::NumberOfProcessors();
+    if (num_cores > 0 &&
+        static_cast<size_t>(num_cores) < max_concurrent_jobs) {
+      max_concurrent_jobs = num_cores;
+    }
+  } else if (FLAGS_max_concurrent_jobs > 0 &&
+             static_cast<size_t>(FLAGS_max_concurrent_jobs) <
+                 max_concurrent_jobs) {
+    max_concurrent_jobs = FLAGS_max_concurrent_jobs;
+  }
+
+  // Start the most expensive jobs first (longest-processing-time-first).
+  // With a heterogeneous mix, e.g. one 4K video and several small audio
+  // inputs, this keeps the big job from being scheduled last and becoming
+  // the tail that runs alone while the other cores idle.
+  std::vector<RemuxJob*> pending_jobs(remux_jobs);
+  std::sort(pending_jobs.begin(), pending_jobs.end(), CompareJobCost);
+
+#if defined(__linux__)
+  if (FLAGS_enable_numa_pinning) {
+    const std::vector<cpu_set_t> numa_nodes = ReadNumaTopology();
+    if (!numa_nodes.empty()) {
+      // Rotate the starting node across calls so that repeated single-job
+      // runs in one process do not all land on node 0.
+      static size_t next_node = 0;
+      for (size_t i = 0; i < pending_jobs.size(); ++i) {
+        pending_jobs[i]->set_cpu_affinity(
+            numa_nodes[next_node % numa_nodes.size()]);
+        ++next_node;
+      }
+    }
+  }
+#endif
+
+  ProducerConsumerQueue<RemuxJob*> completed_jobs(kUnlimitedCapacity);
+  size_t num_jobs_started = 0;
+  for (; num_jobs_started < max_concurrent_jobs; ++num_jobs_started) {
+    pending_jobs[num_jobs_started]->set_completion_queue(&completed_jobs);
+    pending_jobs[num_jobs_started]->Start();
+  }
+
+  // Wait for the jobs to complete, keeping up to |max_concurrent_jobs| in
+  // flight until all jobs have been started or an error occurs.
+  Status status;
+  size_t num_jobs_finished = 0;
+  while (num_jobs_finished < num_jobs_started) {
+    RemuxJob* finished_job = NULL;
+    CHECK(completed_jobs.Pop(&finished_job, kInfiniteTimeout).ok());
+    finished_job->Join();
+    ++num_jobs_finished;
+    if (status.ok())
+      status = finished_job->status();
+
+    if (status.ok() && num_jobs_started < pending_jobs.size()) {
+      pending_jobs[num_jobs_started]->set_completion_queue(&completed_jobs);
+      pending_jobs[num_jobs_started]->Start();
+      ++num_jobs_started;
+    }
+  }
+
+  return status;
+}
+
+}  // namespace
+
+Packager::Packager() {}
+
+Packager::~Packager() {}
+
+Status Packager::Run(const StreamDescriptorList& stream_descriptors) {
+  // The profiler covers the whole job and writes its report when this scope
+  // unwinds, on both success and failure paths.
+  scoped_ptr<SamplingProfiler> profiler;
+  if (!FLAGS_profile_output.empty()) {
+    profiler.reset(new SamplingProfiler(FLAGS_profile_output,
+                                        FLAGS_profile_sampling_frequency));
+    if (!profiler->Start()) {
+      LOG(WARNING) << "Profiling disabled for this job.";
+      profiler.reset();
+    }
+  }
+
+  const FourCC protection_scheme = GetProtectionScheme(FLAGS_protection_scheme);
+  if (protection_scheme == FOURCC_NULL) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Unknown protection scheme: " + FLAGS_protection_scheme);
+  }
+
+  if (!FLAGS_deterministic_iv_seed.empty()) {
+    std::vector<uint8_t> iv_seed;
+    if (!base::HexStringToBytes(FLAGS_deterministic_iv_seed, &iv_seed)) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Invalid hex string for --deterministic_iv_seed.");
+    }
+    AesCryptor::SetIvSeed(iv_seed);
+  }
+
+  if (!AssignFlagsFromProfile())
+    return Status(error::INVALID_ARGUMENT, "Invalid profile.");
+
+  if (FLAGS_output_media_info && !FLAGS_mpd_output.empty()) {
+    return Status(error::INVALID_ARGUMENT,
+                  "--output_media_info and --mpd_output do not work together.");
+  }
+  if (FLAGS_output_media_info && !FLAGS_single_segment) {
+    // TODO(rkuroiwa, kqyang): Support partial media info dump for live.
+    return Status(error::INVALID_ARGUMENT,
+                  "--output_media_info is only supported if --single_segment "
+                  "is true.");
+  }
+
+  // Get basic muxer options.
+  MuxerOptions muxer_options;
+  if (!GetMuxerOptions(&muxer_options))
+    return Status(error::INVALID_ARGUMENT, "Invalid muxer options.");
+
+  MpdOptions mpd_options;
+  if (!GetMpdOptions(&mpd_options))
+    return Status(error::INVALID_ARGUMENT, "Invalid MPD options.");
+
+  // Create the encryption key source on the first job that needs it. The
+  // source, and with it any key server connection, is kept for later jobs.
+  // The creation, which for Widevine includes a blocking key fetch, runs on
+  // a worker thread so that it overlaps opening and sniffing the inputs.
+  scoped_ptr<EncryptionKeySourceFetcher> key_source_fetcher;
+  if (FLAGS_enable_widevine_encryption || FLAGS_enable_fixed_key_encryption) {
+    if (!encryption_key_source_) {
+      key_source_fetcher.reset(new EncryptionKeySourceFetcher());
+      key_source_fetcher->Start();
+    }
+  } else {
+    encryption_key_source_.reset();
+  }
+
+  scoped_ptr<MpdNotifier> mpd_notifier;
+  if (!FLAGS_mpd_output.empty()) {
+    DashProfile profile =
+        FLAGS_single_segment ? kOnDemandProfile : kLiveProfile;
+    std::vector<std::string> base_urls;
+    base::SplitString(FLAGS_base_urls, ',', &base_urls);
+    if (FLAGS_generate_dash_if_iop_compliant_mpd) {
+      mpd_notifier.reset(new DashIopMpdNotifier(profile, mpd_options, base_urls,
+                                                FLAGS_mpd_output));
+    } else {
+      mpd_notifier.reset(new SimpleMpdNotifier(profile, mpd_options, base_urls,
+                                               FLAGS_mpd_output));
+    }
+    if (!mpd_notifier->Init())
+      return Status(error::UNKNOWN, "MpdNotifier failed to initialize.");
+  }
+
+  scoped_ptr<hls::HlsNotifier> hls_notifier;
+  if (!FLAGS_hls_master_playlist_output.empty()) {
+    base::FilePath master_playlist_path(FLAGS_hls_master_playlist_output);
+    base::FilePath master_playlist_name = master_playlist_path.BaseName();
+
+    hls_notifier.reset(new hls::SimpleHlsNotifier(
+        hls::HlsNotifier::HlsProfile::kOnDemandProfile, FLAGS_hls_base_url,
+        master_playlist_path.DirName().AsEndingWithSeparator().value(),
+        master_playlist_name.value()));
+  }
+
+  std::vector<RemuxJob*> remux_jobs;
+  STLElementDeleter<std::vector<RemuxJob*> > scoped_jobs_deleter(&remux_jobs);
+  FakeClock fake_clock;
+  if (!CreateRemuxJobs(stream_descriptors, muxer_options, &fake_clock,
+                       encryption_key_source_.get(), key_source_fetcher.get(),
+                       mpd_notifier.get(), hls_notifier.get(), &remux_jobs)) {
+    return Status(error::INVALID_ARGUMENT, "Failed to create remux jobs.");
+  }
+  // Keep the fetched key source for later jobs. Muxers hold a raw pointer to
+  // it, so ownership must move to the member before the jobs run.
+  if (key_source_fetcher)
+    encryption_key_source_ = key_source_fetcher->Take();
+
+  // Watch for SIGHUP-triggered config reloads while the jobs run.
+  scoped_ptr<HotConfigReloader> config_reloader;
+  if (!FLAGS_hot_config_file.empty()) {
+    config_reloader.reset(new HotConfigReloader(FLAGS_hot_config_file));
+    if (!config_reloader->StartWatching()) {
+      LOG(WARNING) << "Hot config reload disabled for this job.";
+      config_reloader.reset();
+    }
+  }
+
+  Status status = RunRemuxJobs(remux_jobs);
+  if (config_reloader)
+    config_reloader->StopWatching();
+  AllocationTracker::DumpHighWaterMarks();
+  if (!status.ok())
+    return status;
+
+  if (hls_notifier) {
+    if (!hls_notifier->Flush())
+      return Status(error::UNKNOWN, "Failed to flush HLS playlists.");
+  }
+  if (mpd_notifier) {
+    if (!mpd_notifier->Flush())
+      return Status(error::UNKNOWN, "Failed to flush the MPD.");
+  }
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace shaka
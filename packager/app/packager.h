@@ -0,0 +1,51 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef APP_PACKAGER_H_
+#define APP_PACKAGER_H_
+
+#include "packager/app/libcrypto_threading.h"
+#include "packager/app/stream_descriptor.h"
+#include "packager/base/macros.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/status.h"
+
+namespace shaka {
+namespace media {
+
+class KeySource;
+
+/// Library entry point for packaging. This is the same pipeline the packager
+/// binary runs, exposed as a reusable object so an embedding application can
+/// package many jobs in one process instead of forking a binary per job.
+/// Process-lifetime state — libcrypto threading callbacks and the encryption
+/// key source connection — is set up once and shared across Run() calls.
+/// Packaging options are read from the usual gflags flags; an embedder sets
+/// them programmatically (e.g. google::SetCommandLineOption) before Run().
+class Packager {
+ public:
+  Packager();
+  ~Packager();
+
+  /// Package the streams described by @a stream_descriptors. May be called
+  /// repeatedly on the same object; each call is one complete packaging job.
+  /// Not thread safe: callers must serialize Run() calls.
+  /// @return OK on success.
+  Status Run(const StreamDescriptorList& stream_descriptors);
+
+ private:
+  LibcryptoThreading libcrypto_threading_;
+  // Created on the first Run() that needs encryption and reused afterwards so
+  // key server connections stay warm across jobs.
+  scoped_ptr<KeySource> encryption_key_source_;
+
+  DISALLOW_COPY_AND_ASSIGN(Packager);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // APP_PACKAGER_H_
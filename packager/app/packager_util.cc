@@ -15,6 +15,7 @@
 #include "packager/app/widevine_encryption_flags.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_split.h"
 #include "packager/media/base/fixed_key_source.h"
 #include "packager/media/base/media_stream.h"
 #include "packager/media/base/muxer.h"
@@ -151,9 +152,20 @@ bool GetMuxerOptions(MuxerOptions* muxer_options) {
   muxer_options->single_segment = FLAGS_single_segment;
   muxer_options->segment_duration = FLAGS_segment_duration;
   muxer_options->fragment_duration = FLAGS_fragment_duration;
+  muxer_options->audio_fragment_duration = FLAGS_audio_fragment_duration;
   muxer_options->segment_sap_aligned = FLAGS_segment_sap_aligned;
+  muxer_options->segment_target_size_bytes = FLAGS_segment_target_size_bytes;
+  muxer_options->segment_min_duration_seconds = FLAGS_segment_min_duration;
+  if (FLAGS_segment_target_size_bytes > 0 &&
+      FLAGS_segment_min_duration > FLAGS_segment_duration) {
+    LOG(ERROR) << "--segment_min_duration (" << FLAGS_segment_min_duration
+               << ") must not exceed --segment_duration ("
+               << FLAGS_segment_duration << ").";
+    return false;
+  }
   muxer_options->fragment_sap_aligned = FLAGS_fragment_sap_aligned;
   muxer_options->num_subsegments_per_sidx = FLAGS_num_subsegments_per_sidx;
+  muxer_options->chunked_fragments = FLAGS_chunked_fragments;
 
   if (FLAGS_mp4_use_decoding_timestamp_in_timeline) {
     LOG(WARNING) << "Flag --mp4_use_decoding_timestamp_in_timeline is set. "
@@ -165,6 +177,41 @@ bool GetMuxerOptions(MuxerOptions* muxer_options) {
       FLAGS_mp4_use_decoding_timestamp_in_timeline;
 
   muxer_options->temp_dir = FLAGS_temp_dir;
+
+  if (!FLAGS_ad_cues.empty()) {
+    std::vector<std::string> cues;
+    base::SplitString(FLAGS_ad_cues, ';', &cues);
+    for (size_t i = 0; i < cues.size(); ++i) {
+      double cue_point = 0;
+      if (!base::StringToDouble(cues[i], &cue_point) || cue_point < 0 ||
+          (!muxer_options->ad_cue_points_seconds.empty() &&
+           cue_point <= muxer_options->ad_cue_points_seconds.back())) {
+        LOG(ERROR) << "Malformed --ad_cues '" << FLAGS_ad_cues
+                   << "'; expecting a strictly increasing semicolon "
+                      "separated list of times in seconds.";
+        return false;
+      }
+      muxer_options->ad_cue_points_seconds.push_back(cue_point);
+    }
+  }
+
+  if (!FLAGS_shard_time_range.empty()) {
+    const size_t separator = FLAGS_shard_time_range.find(':');
+    double start = 0;
+    double end = 0;
+    if (separator == std::string::npos ||
+        !base::StringToDouble(FLAGS_shard_time_range.substr(0, separator),
+                              &start) ||
+        !base::StringToDouble(FLAGS_shard_time_range.substr(separator + 1),
+                              &end) ||
+        start < 0 || end <= start) {
+      LOG(ERROR) << "Invalid --shard_time_range '" << FLAGS_shard_time_range
+                 << "', expecting 'start:end' in seconds with end > start.";
+      return false;
+    }
+    muxer_options->shard_start_seconds = start;
+    muxer_options->shard_end_seconds = end;
+  }
   return true;
 }
 
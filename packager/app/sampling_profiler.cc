@@ -0,0 +1,216 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/sampling_profiler.h"
+
+#if defined(__linux__)
+#include <execinfo.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#endif
+
+#include <map>
+
+#include "packager/base/atomicops.h"
+#include "packager/base/logging.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/media/file/file.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+#if defined(__linux__)
+
+const int kMaxFrames = 64;
+// At the default 97 Hz this is over ten minutes of fully busy CPU; samples
+// beyond the buffer are counted but dropped.
+const int kMaxSamples = 1 << 16;
+
+struct Sample {
+  int num_frames;
+  void* frames[kMaxFrames];
+};
+
+// Sample storage is global because it is filled from a signal handler. Only
+// one SamplingProfiler may be active at a time; |g_samples| is non-NULL
+// exactly while one is started.
+Sample* g_samples = NULL;
+base::subtle::AtomicWord g_num_samples = 0;
+
+void ProfileSignalHandler(int signal_number) {
+  // Everything here must be async-signal-safe. backtrace() is safe once the
+  // first call has forced libgcc to be resolved; Start() makes that call.
+  const base::subtle::AtomicWord index =
+      base::subtle::NoBarrier_AtomicIncrement(&g_num_samples, 1) - 1;
+  if (index >= kMaxSamples)
+    return;
+  Sample* sample = &g_samples[index];
+  sample->num_frames = backtrace(sample->frames, kMaxFrames);
+}
+
+// Extracts a readable frame name from a backtrace_symbols() entry of the
+// form "module(function+0x1a) [0x...]", falling back to the module name for
+// frames without symbol information.
+std::string FrameName(const char* symbol) {
+  const std::string entry(symbol);
+  const size_t open_paren = entry.find('(');
+  if (open_paren != std::string::npos) {
+    const size_t end = entry.find_first_of("+)", open_paren + 1);
+    if (end != std::string::npos && end > open_paren + 1)
+      return entry.substr(open_paren + 1, end - open_paren - 1);
+  }
+  const size_t space = entry.find(' ');
+  return space == std::string::npos ? entry : entry.substr(0, space);
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(const std::string& output_path,
+                                   int sampling_frequency)
+    : output_path_(output_path),
+      sampling_frequency_(sampling_frequency),
+      started_(false) {}
+
+SamplingProfiler::~SamplingProfiler() {
+  if (started_)
+    Stop();
+}
+
+#if defined(__linux__)
+
+bool SamplingProfiler::Start() {
+  DCHECK(!started_);
+  if (sampling_frequency_ <= 0) {
+    LOG(ERROR) << "Invalid profile sampling frequency: "
+               << sampling_frequency_;
+    return false;
+  }
+  if (g_samples) {
+    LOG(ERROR) << "Only one sampling profiler may be active at a time.";
+    return false;
+  }
+
+  // Resolve backtrace() machinery outside the signal handler.
+  void* warmup_frames[2];
+  backtrace(warmup_frames, arraysize(warmup_frames));
+
+  g_samples = new Sample[kMaxSamples];
+  base::subtle::NoBarrier_Store(&g_num_samples, 0);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = ProfileSignalHandler;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, NULL) != 0) {
+    LOG(ERROR) << "Failed to install SIGPROF handler.";
+    delete[] g_samples;
+    g_samples = NULL;
+    return false;
+  }
+
+  // ITIMER_PROF counts CPU time consumed by the whole process and delivers
+  // SIGPROF to a running thread, so demuxer, muxer and worker threads are
+  // all sampled in proportion to the CPU they use.
+  const long interval_usec = 1000000L / sampling_frequency_;
+  struct itimerval timer;
+  timer.it_interval.tv_sec = interval_usec / 1000000L;
+  timer.it_interval.tv_usec = interval_usec % 1000000L;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+    LOG(ERROR) << "Failed to start profiling timer.";
+    signal(SIGPROF, SIG_DFL);
+    delete[] g_samples;
+    g_samples = NULL;
+    return false;
+  }
+
+  started_ = true;
+  return true;
+}
+
+bool SamplingProfiler::Stop() {
+  DCHECK(started_);
+  started_ = false;
+
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, NULL);
+  signal(SIGPROF, SIG_IGN);
+
+  const base::subtle::AtomicWord num_taken =
+      base::subtle::NoBarrier_Load(&g_num_samples);
+  const int num_samples =
+      num_taken < kMaxSamples ? static_cast<int>(num_taken) : kMaxSamples;
+  if (num_taken > kMaxSamples) {
+    LOG(WARNING) << "Profile sample buffer full: dropped "
+                 << num_taken - kMaxSamples << " samples.";
+  }
+
+  // Aggregate identical stacks into folded lines, root first.
+  std::map<std::string, int> folded_counts;
+  for (int i = 0; i < num_samples; ++i) {
+    const Sample& sample = g_samples[i];
+    // Skip the handler frame and the kernel signal trampoline.
+    const int kSkippedFrames = 2;
+    char** symbols = backtrace_symbols(sample.frames, sample.num_frames);
+    if (!symbols)
+      continue;
+    std::string folded;
+    for (int frame = sample.num_frames - 1; frame >= kSkippedFrames; --frame) {
+      if (!folded.empty())
+        folded += ';';
+      folded += FrameName(symbols[frame]);
+    }
+    free(symbols);
+    if (!folded.empty())
+      ++folded_counts[folded];
+  }
+  delete[] g_samples;
+  g_samples = NULL;
+
+  std::string report;
+  for (std::map<std::string, int>::const_iterator it = folded_counts.begin();
+       it != folded_counts.end(); ++it) {
+    base::StringAppendF(&report, "%s %d\n", it->first.c_str(), it->second);
+  }
+
+  File* file = File::Open(output_path_.c_str(), "w");
+  if (!file) {
+    LOG(ERROR) << "Failed to open profile output " << output_path_;
+    return false;
+  }
+  if (!report.empty() &&
+      file->Write(report.data(), report.size()) <
+          static_cast<int64_t>(report.size())) {
+    LOG(ERROR) << "Failed to write profile output " << output_path_;
+    file->Close();
+    return false;
+  }
+  return file->Close();
+}
+
+#else
+
+bool SamplingProfiler::Start() {
+  LOG(ERROR) << "The sampling profiler is only supported on Linux.";
+  return false;
+}
+
+bool SamplingProfiler::Stop() {
+  started_ = false;
+  return false;
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,55 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef APP_SAMPLING_PROFILER_H_
+#define APP_SAMPLING_PROFILER_H_
+
+#include <string>
+
+#include "packager/base/macros.h"
+
+namespace shaka {
+namespace media {
+
+/// Opt-in timer based sampling profiler for production jobs where attaching
+/// an external profiler is not possible. While started, a profiling timer
+/// periodically samples the stack of whichever of the packager's threads is
+/// running on CPU. Stop() aggregates the samples and writes a folded-stack
+/// file (one "frame;frame;frame count" line per unique stack) suitable for
+/// flame graph tooling. Linux only; Start() fails elsewhere.
+///
+/// At most one profiler may be active in a process at a time.
+class SamplingProfiler {
+ public:
+  /// @param output_path is the file the folded-stack report is written to.
+  /// @param sampling_frequency is the target number of samples per second of
+  ///        consumed CPU time.
+  SamplingProfiler(const std::string& output_path, int sampling_frequency);
+
+  /// Stops sampling and writes the report if Stop() has not been called.
+  ~SamplingProfiler();
+
+  /// Start sampling.
+  /// @return true on success.
+  bool Start();
+
+  /// Stop sampling, aggregate the collected samples and write the
+  /// folded-stack report to the output path.
+  /// @return true if the report was written successfully.
+  bool Stop();
+
+ private:
+  const std::string output_path_;
+  const int sampling_frequency_;
+  bool started_;
+
+  DISALLOW_COPY_AND_ASSIGN(SamplingProfiler);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // APP_SAMPLING_PROFILER_H_
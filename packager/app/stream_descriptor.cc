@@ -7,10 +7,12 @@
 #include "packager/app/stream_descriptor.h"
 
 #include "packager/app/packager_util.h"
+#include "packager/app/stream_descriptor_preset.pb.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_split.h"
 #include "packager/media/base/container_names.h"
+#include "packager/media/file/file.h"
 #include "packager/mpd/base/language_utils.h"
 
 namespace shaka {
@@ -30,6 +32,7 @@ enum FieldType {
   kHlsNameField,
   kHlsGroupIdField,
   kHlsPlaylistNameField,
+  kTrickPlayFactorField,
 };
 
 struct FieldNameToTypeMapping {
@@ -57,6 +60,7 @@ const FieldNameToTypeMapping kFieldNameTypeMappings[] = {
     {"hls_name", kHlsNameField},
     {"hls_group_id", kHlsGroupIdField},
     {"playlist_name", kHlsPlaylistNameField},
+    {"trick_play_factor", kTrickPlayFactorField},
 };
 
 FieldType GetFieldType(const std::string& field_name) {
@@ -70,7 +74,7 @@ FieldType GetFieldType(const std::string& field_name) {
 }  // anonymous namespace
 
 StreamDescriptor::StreamDescriptor()
-    : bandwidth(0), output_format(CONTAINER_UNKNOWN) {}
+    : bandwidth(0), trick_play_factor(0), output_format(CONTAINER_UNKNOWN) {}
 
 StreamDescriptor::~StreamDescriptor() {}
 
@@ -143,6 +147,15 @@ bool InsertStreamDescriptor(const std::string& descriptor_string,
         descriptor.hls_playlist_name = iter->second;
         break;
       }
+      case kTrickPlayFactorField: {
+        unsigned factor;
+        if (!base::StringToUint(iter->second, &factor) || factor == 0) {
+          LOG(ERROR) << "Trick play factor should be a positive integer.";
+          return false;
+        }
+        descriptor.trick_play_factor = factor;
+        break;
+      }
       default:
         LOG(ERROR) << "Unknown field in stream descriptor (\"" << iter->first
                    << "\").";
@@ -200,5 +213,82 @@ bool InsertStreamDescriptor(const std::string& descriptor_string,
   return true;
 }
 
+bool WriteStreamDescriptorsToFile(const StreamDescriptorList& descriptor_list,
+                                  const std::string& file_name) {
+  StreamDescriptorPresetProto preset;
+  for (StreamDescriptorList::const_iterator iter = descriptor_list.begin();
+       iter != descriptor_list.end(); ++iter) {
+    StreamDescriptorProto* descriptor = preset.add_stream_descriptors();
+    descriptor->set_stream_selector(iter->stream_selector);
+    descriptor->set_input(iter->input);
+    descriptor->set_output(iter->output);
+    descriptor->set_segment_template(iter->segment_template);
+    descriptor->set_bandwidth(iter->bandwidth);
+    descriptor->set_trick_play_factor(iter->trick_play_factor);
+    descriptor->set_language(iter->language);
+    descriptor->set_output_format(iter->output_format);
+    descriptor->set_hls_name(iter->hls_name);
+    descriptor->set_hls_group_id(iter->hls_group_id);
+    descriptor->set_hls_playlist_name(iter->hls_playlist_name);
+  }
+
+  std::string serialized_preset;
+  if (!preset.SerializeToString(&serialized_preset)) {
+    LOG(ERROR) << "Failed to serialize stream descriptor preset.";
+    return false;
+  }
+
+  File* file = File::Open(file_name.c_str(), "w");
+  if (!file) {
+    LOG(ERROR) << "Failed to open " << file_name;
+    return false;
+  }
+  if (file->Write(serialized_preset.data(), serialized_preset.size()) <
+      static_cast<int64_t>(serialized_preset.size())) {
+    LOG(ERROR) << "Failed to write stream descriptor preset to " << file_name;
+    file->Close();
+    return false;
+  }
+  return file->Close();
+}
+
+bool ReadStreamDescriptorsFromFile(const std::string& file_name,
+                                   StreamDescriptorList* descriptor_list) {
+  DCHECK(descriptor_list);
+
+  std::string serialized_preset;
+  if (!File::ReadFileToString(file_name.c_str(), &serialized_preset)) {
+    LOG(ERROR) << "Failed to read stream descriptor preset " << file_name;
+    return false;
+  }
+  StreamDescriptorPresetProto preset;
+  if (!preset.ParseFromString(serialized_preset)) {
+    LOG(ERROR) << "Failed to parse stream descriptor preset " << file_name;
+    return false;
+  }
+
+  // The preset was validated when it was written, so the descriptors are
+  // inserted directly without re-running the string parser.
+  for (int i = 0; i < preset.stream_descriptors_size(); ++i) {
+    const StreamDescriptorProto& descriptor_proto =
+        preset.stream_descriptors(i);
+    StreamDescriptor descriptor;
+    descriptor.stream_selector = descriptor_proto.stream_selector();
+    descriptor.input = descriptor_proto.input();
+    descriptor.output = descriptor_proto.output();
+    descriptor.segment_template = descriptor_proto.segment_template();
+    descriptor.bandwidth = descriptor_proto.bandwidth();
+    descriptor.trick_play_factor = descriptor_proto.trick_play_factor();
+    descriptor.language = descriptor_proto.language();
+    descriptor.output_format =
+        static_cast<MediaContainerName>(descriptor_proto.output_format());
+    descriptor.hls_name = descriptor_proto.hls_name();
+    descriptor.hls_group_id = descriptor_proto.hls_group_id();
+    descriptor.hls_playlist_name = descriptor_proto.hls_playlist_name();
+    descriptor_list->insert(descriptor);
+  }
+  return true;
+}
+
 }  // namespace media
 }  // namespace shaka
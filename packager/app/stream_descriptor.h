@@ -28,6 +28,8 @@ struct StreamDescriptor {
   std::string output;
   std::string segment_template;
   uint32_t bandwidth;
+  // 0 means no trick play output; N keeps every Nth key frame only.
+  uint32_t trick_play_factor;
   std::string language;
   MediaContainerName output_format;
   std::string hls_name;
@@ -56,6 +58,21 @@ typedef std::multiset<StreamDescriptor, StreamDescriptorCompareFn>
 bool InsertStreamDescriptor(const std::string& descriptor_string,
                             StreamDescriptorList* descriptor_list);
 
+/// Writes the already-validated descriptors in @a descriptor_list to
+/// @a file_name as a binary preset. A controller that launches the same
+/// config repeatedly can compile it once and have later invocations load the
+/// preset directly.
+/// @return true if successful, false otherwise. May print error messages.
+bool WriteStreamDescriptorsToFile(const StreamDescriptorList& descriptor_list,
+                                  const std::string& file_name);
+
+/// Loads descriptors from a binary preset previously written by
+/// WriteStreamDescriptorsToFile(), skipping descriptor parsing and
+/// validation, and inserts them into @a descriptor_list.
+/// @return true if successful, false otherwise. May print error messages.
+bool ReadStreamDescriptorsFromFile(const std::string& file_name,
+                                   StreamDescriptorList* descriptor_list);
+
 }  // namespace media
 }  // namespace shaka
 
@@ -57,6 +57,12 @@ bool MasterPlaylist::WriteAllPlaylists(const std::string& base_url,
           << "Target duration was already set for " << file_path;
     }
 
+    // Only rewrite playlists that changed since they were last written. A
+    // segment posted to one stream should not cost a rewrite of every
+    // rendition's playlist.
+    if (!playlist->Dirty())
+      continue;
+
     scoped_ptr<media::File, media::FileCloser> file(
         media::File::Open(file_path.c_str(), "w"));
     if (!file) {
@@ -76,12 +82,6 @@ bool MasterPlaylist::WriteAllPlaylists(const std::string& base_url,
 bool MasterPlaylist::WriteMasterPlaylist(const std::string& base_url,
                                          const std::string& output_dir) {
   std::string file_path = output_dir + file_name_;
-  scoped_ptr<media::File, media::FileCloser> file(
-      media::File::Open(file_path.c_str(), "w"));
-  if (!file) {
-    LOG(ERROR) << "Failed to open file " << file_path;
-    return false;
-  }
 
   // TODO(rkuroiwa): This can be done in AddMediaPlaylist(), no need to create
   // map and list on the fly.
@@ -158,6 +158,18 @@ bool MasterPlaylist::WriteMasterPlaylist(const std::string& base_url,
 
   std::string content =
       "#EXTM3U\n" + version_line + audio_output + video_output;
+
+  // The variant metadata rarely changes once the bitrates settle, so skip the
+  // write when the output would be identical to what was last written.
+  if (content == written_playlist_)
+    return true;
+
+  scoped_ptr<media::File, media::FileCloser> file(
+      media::File::Open(file_path.c_str(), "w"));
+  if (!file) {
+    LOG(ERROR) << "Failed to open file " << file_path;
+    return false;
+  }
   int64_t bytes_written = file->Write(content.data(), content.size());
   if (bytes_written < 0) {
     LOG(ERROR) << "Error while writing master playlist " << file_path;
@@ -169,6 +181,7 @@ bool MasterPlaylist::WriteMasterPlaylist(const std::string& base_url,
     return false;
   }
 
+  written_playlist_.swap(content);
   return true;
 }
 
@@ -59,6 +59,10 @@ class MasterPlaylist {
 
   bool has_set_playlist_target_duration_ = false;
 
+  // The content most recently written by WriteMasterPlaylist(). Used to skip
+  // rewriting the master playlist when the variant metadata has not changed.
+  std::string written_playlist_;
+
   DISALLOW_COPY_AND_ASSIGN(MasterPlaylist);
 };
 
@@ -37,6 +37,8 @@ class SegmentInfoEntry : public HlsEntry {
 
   std::string ToString() override;
 
+  double duration() const { return duration_; }
+
  private:
   const std::string file_name_;
   const double duration_;
@@ -170,11 +172,17 @@ bool MediaPlaylist::SetMediaInfo(const MediaInfo& media_info) {
 void MediaPlaylist::AddSegment(const std::string& file_name,
                                uint64_t duration,
                                uint64_t size) {
+  dirty_ = true;
   if (time_scale_ == 0) {
     LOG(WARNING) << "Timescale is not set and the duration for " << duration
                  << " cannot be calculated. The output will be wrong.";
 
-    entries_.push_back(new SegmentInfoEntry(file_name, 0.0));
+    SegmentInfoEntry* entry = new SegmentInfoEntry(file_name, 0.0);
+    const std::string entry_text = entry->ToString();
+    if (body_cache_valid_)
+      body_cache_ += entry_text;
+    WriteToSpillFile(entry_text);
+    entries_.push_back(entry);
     return;
   }
 
@@ -186,7 +194,15 @@ void MediaPlaylist::AddSegment(const std::string& file_name,
   const int kBitsInByte = 8;
   const uint64_t bitrate = kBitsInByte * size / segment_duration_seconds;
   max_bitrate_ = std::max(max_bitrate_, bitrate);
-  entries_.push_back(new SegmentInfoEntry(file_name, segment_duration_seconds));
+  SegmentInfoEntry* entry =
+      new SegmentInfoEntry(file_name, segment_duration_seconds);
+  const std::string entry_text = entry->ToString();
+  if (body_cache_valid_)
+    body_cache_ += entry_text;
+  WriteToSpillFile(entry_text);
+  entries_.push_back(entry);
+  current_window_duration_ += segment_duration_seconds;
+  EvictSegmentsOutsideWindow();
 }
 
 // TODO(rkuroiwa): This works for single key format but won't work for multiple
@@ -205,12 +221,35 @@ void MediaPlaylist::RemoveOldestSegment() {
       "This algorithm assumes std::list.");
   if (entries_.empty())
     return;
+  dirty_ = true;
   if (entries_.front()->type() == HlsEntry::EntryType::kExtInf) {
+    if (body_cache_valid_) {
+      // Slide the cached body forward past the removed entry; compact once
+      // more than half of the cache is dead bytes.
+      body_cache_head_ += entries_.front()->ToString().size();
+      if (body_cache_head_ * 2 > body_cache_.size()) {
+        body_cache_.erase(0, body_cache_head_);
+        body_cache_head_ = 0;
+      }
+    }
+    current_window_duration_ -=
+        static_cast<SegmentInfoEntry*>(entries_.front())->duration();
     delete entries_.front();
     entries_.pop_front();
+    // If the playlist now starts with an EXT-X-KEY entry, the discontinuity
+    // tag that preceded it no longer belongs in the output.
+    if (!entries_.empty() &&
+        entries_.front()->type() == HlsEntry::EntryType::kExtKey) {
+      body_cache_valid_ = false;
+    }
     return;
   }
 
+  // The remaining cases drop entries from around EXT-X-KEY entries. They only
+  // happen on key rotation, so just rebuild the cached body on the next
+  // write.
+  body_cache_valid_ = false;
+
   // Make sure that the first EXT-X-KEY entry doesn't get popped out until the
   // next EXT-X-KEY entry because the first EXT-X-KEY applies to all the
   // segments following until the next one.
@@ -227,6 +266,8 @@ void MediaPlaylist::RemoveOldestSegment() {
       delete entries_.front();
       entries_.pop_front();
     } else {
+      current_window_duration_ -=
+          static_cast<SegmentInfoEntry*>(*entries_itr)->duration();
       delete *entries_itr;
       entries_.erase(entries_itr);
     }
@@ -237,6 +278,8 @@ void MediaPlaylist::RemoveOldestSegment() {
   ++entries_itr;
   if ((*entries_itr)->type() == HlsEntry::EntryType::kExtInf) {
     DCHECK((*entries_itr)->type() == HlsEntry::EntryType::kExtInf);
+    current_window_duration_ -=
+        static_cast<SegmentInfoEntry*>(*entries_itr)->duration();
     delete *entries_itr;
     entries_.erase(entries_itr);
     return;
@@ -246,6 +289,8 @@ void MediaPlaylist::RemoveOldestSegment() {
   // This assumes that there is a segment between 2 EXT-X-KEY entries.
   // Which should be the case due to logic in AddEncryptionInfo().
   DCHECK((*entries_itr)->type() == HlsEntry::EntryType::kExtInf);
+  current_window_duration_ -=
+      static_cast<SegmentInfoEntry*>(*entries_itr)->duration();
   delete *entries_itr;
   entries_.erase(entries_itr);
   delete entries_.front();
@@ -257,15 +302,22 @@ void MediaPlaylist::AddEncryptionInfo(MediaPlaylist::EncryptionMethod method,
                                       const std::string& iv,
                                       const std::string& key_format,
                                       const std::string& key_format_versions) {
+  // Key changes may replace the previous EXT-X-KEY entry and can move the
+  // discontinuity tag; they are rare, so rebuild the cached body on the next
+  // write instead of patching it.
+  body_cache_valid_ = false;
+  dirty_ = true;
   if (!entries_.empty()) {
     // No reason to have two consecutive EXT-X-KEY entries. Remove the previous
     // one.
     if (entries_.back()->type() == HlsEntry::EntryType::kExtKey)
       entries_.pop_back();
   }
-  entries_.push_back(
-      new EncryptionInfoEntry(
-          method, url, iv, key_format, key_format_versions));
+  EncryptionInfoEntry* entry =
+      new EncryptionInfoEntry(method, url, iv, key_format,
+                              key_format_versions);
+  WriteToSpillFile(entry->ToString());
+  entries_.push_back(entry);
 }
 
 bool MediaPlaylist::WriteToFile(media::File* file) {
@@ -292,22 +344,12 @@ bool MediaPlaylist::WriteToFile(media::File* file) {
     header += "#EXT-X-PLAYLIST-TYPE:VOD\n";
   }
 
-  std::string body;
-  if (!entries_.empty()) {
-    const bool first_is_ext_key =
-        entries_.front()->type() == HlsEntry::EntryType::kExtKey;
-    bool inserted_discontinuity_tag = false;
-    for (const auto& entry : entries_) {
-      if (!first_is_ext_key && !inserted_discontinuity_tag &&
-          entry->type() == HlsEntry::EntryType::kExtKey) {
-        body.append("#EXT-X-DISCONTINUITY\n");
-        inserted_discontinuity_tag = true;
-      }
-      body.append(entry->ToString());
-    }
-  }
+  if (!body_cache_valid_)
+    RebuildBodyCache();
 
-  std::string content = header + body;
+  std::string content = header;
+  content.append(body_cache_, body_cache_head_,
+                 body_cache_.size() - body_cache_head_);
 
   if (type_ == MediaPlaylistType::kVod) {
     content += "#EXT-X-ENDLIST\n";
@@ -328,9 +370,86 @@ bool MediaPlaylist::WriteToFile(media::File* file) {
     return false;
   }
 
+  dirty_ = false;
   return true;
 }
 
+void MediaPlaylist::RebuildBodyCache() {
+  body_cache_.clear();
+  body_cache_head_ = 0;
+  if (!entries_.empty()) {
+    const bool first_is_ext_key =
+        entries_.front()->type() == HlsEntry::EntryType::kExtKey;
+    bool inserted_discontinuity_tag = false;
+    for (const auto& entry : entries_) {
+      if (!first_is_ext_key && !inserted_discontinuity_tag &&
+          entry->type() == HlsEntry::EntryType::kExtKey) {
+        body_cache_.append("#EXT-X-DISCONTINUITY\n");
+        inserted_discontinuity_tag = true;
+      }
+      body_cache_.append(entry->ToString());
+    }
+  }
+  body_cache_valid_ = true;
+}
+
+bool MediaPlaylist::Dirty() const {
+  return dirty_;
+}
+
+void MediaPlaylist::SetWindowDuration(double window_duration_seconds) {
+  window_duration_seconds_ = window_duration_seconds;
+}
+
+bool MediaPlaylist::SetSegmentSpillFile(const std::string& file_path) {
+  spill_file_.reset(media::File::Open(file_path.c_str(), "w"));
+  if (!spill_file_) {
+    LOG(ERROR) << "Failed to open spill file " << file_path;
+    return false;
+  }
+  return true;
+}
+
+void MediaPlaylist::EvictSegmentsOutsideWindow() {
+  if (type_ == MediaPlaylistType::kVod || window_duration_seconds_ <= 0.0)
+    return;
+
+  // In addition to the configured window, the playlist must always span at
+  // least three target durations, per the HLS specification.
+  const double min_duration =
+      std::max(window_duration_seconds_, 3.0 * target_duration_);
+  while (!entries_.empty()) {
+    // Find the oldest segment entry; anything before it is key metadata that
+    // RemoveOldestSegment() knows how to handle.
+    SegmentInfoEntry* oldest_segment = NULL;
+    for (HlsEntry* entry : entries_) {
+      if (entry->type() == HlsEntry::EntryType::kExtInf) {
+        oldest_segment = static_cast<SegmentInfoEntry*>(entry);
+        break;
+      }
+    }
+    if (!oldest_segment)
+      return;
+    if (current_window_duration_ - oldest_segment->duration() < min_duration)
+      return;
+    RemoveOldestSegment();
+  }
+}
+
+void MediaPlaylist::WriteToSpillFile(const std::string& entry_text) {
+  if (!spill_file_)
+    return;
+  const int64_t bytes_written =
+      spill_file_->Write(entry_text.data(), entry_text.size());
+  if (bytes_written < 0 ||
+      static_cast<size_t>(bytes_written) != entry_text.size()) {
+    LOG(ERROR) << "Failed to write to playlist spill file "
+               << spill_file_->file_name()
+               << "; dropping the spill journal.";
+    spill_file_.reset();
+  }
+}
+
 uint64_t MediaPlaylist::Bitrate() const {
   if (media_info_.has_bandwidth())
     return media_info_.bandwidth();
@@ -349,6 +468,7 @@ bool MediaPlaylist::SetTargetDuration(uint32_t target_duration) {
   }
   target_duration_ = target_duration;
   target_duration_set_ = true;
+  dirty_ = true;
   return true;
 }
 
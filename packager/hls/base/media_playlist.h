@@ -13,6 +13,7 @@
 #include "packager/base/macros.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/base/stl_util.h"
+#include "packager/media/file/file_closer.h"
 #include "packager/mpd/base/media_info.pb.h"
 
 namespace shaka {
@@ -140,6 +141,26 @@ class MediaPlaylist {
   ///         segments have been added.
   virtual double GetLongestSegmentDuration() const;
 
+  /// Set the maximum duration, in seconds, covered by segments kept in a
+  /// non-VOD playlist. As new segments are added, the oldest ones are evicted
+  /// once the playlist spans more than the window; at least three target
+  /// durations worth of segments are always kept, as required by the HLS
+  /// specification. The default (0) keeps every segment, which makes a 24/7
+  /// channel hold its whole lifetime of entries in memory.
+  virtual void SetWindowDuration(double window_duration_seconds);
+
+  /// Journal every entry added to this playlist to @a file_path, so the full
+  /// timeline survives window eviction and the stream can be converted to VOD
+  /// at stream end: prepending a VOD header to the journal yields the
+  /// complete playlist body. Must be called before adding segments.
+  /// @return true on success, false if the file cannot be opened.
+  virtual bool SetSegmentSpillFile(const std::string& file_path);
+
+  /// @return true if the playlist has changed since it was last successfully
+  ///         written with WriteToFile(). A playlist that has never been
+  ///         written is dirty.
+  virtual bool Dirty() const;
+
   /// Set the target duration of this MediaPlaylist.
   /// In other words this is the value for EXT-X-TARGETDURATION.
   /// If this is not called before calling Write(), it will estimate the best
@@ -151,6 +172,18 @@ class MediaPlaylist {
   virtual bool SetTargetDuration(uint32_t target_duration);
 
  private:
+  // Rebuilds |body_cache_| from |entries_|.
+  void RebuildBodyCache();
+
+  // Evicts segments from the head of a windowed playlist until it spans no
+  // more than the configured window. No-op for VOD playlists or when no
+  // window is set.
+  void EvictSegmentsOutsideWindow();
+
+  // Appends |entry_text| to the spill journal, if one is set. Write failures
+  // drop the journal with an error rather than failing the playlist.
+  void WriteToSpillFile(const std::string& entry_text);
+
   // Mainly for MasterPlaylist to use these values.
   const std::string file_name_;
   const std::string name_;
@@ -174,6 +207,28 @@ class MediaPlaylist {
   std::list<HlsEntry*> entries_;
   STLElementDeleter<decltype(entries_)> entries_deleter_;
 
+  // Serialized form of |entries_| (the playlist body). Segment appends and
+  // oldest-segment removals are maintained incrementally so that writing the
+  // playlist does not re-serialize every entry in the window. Operations that
+  // restructure the playlist, e.g. key rotation, invalidate the cache and it
+  // is rebuilt on the next WriteToFile(). |body_cache_head_| is the number of
+  // bytes logically removed from the front as the window slides; the cache is
+  // compacted once more than half of it is dead.
+  std::string body_cache_;
+  size_t body_cache_head_ = 0;
+  bool body_cache_valid_ = true;
+
+  // See Dirty().
+  bool dirty_ = true;
+
+  // See SetWindowDuration(). |current_window_duration_| is the number of
+  // seconds covered by the segments currently in |entries_|.
+  double window_duration_seconds_ = 0.0;
+  double current_window_duration_ = 0.0;
+
+  // See SetSegmentSpillFile().
+  scoped_ptr<media::File, media::FileCloser> spill_file_;
+
   DISALLOW_COPY_AND_ASSIGN(MediaPlaylist);
 };
 
@@ -14,6 +14,7 @@
 #include "packager/base/strings/stringprintf.h"
 #include "packager/hls/base/media_playlist.h"
 #include "packager/media/base/fixed_key_source.h"
+#include "packager/media/base/string_codecs.h"
 #include "packager/media/base/widevine_key_source.h"
 #include "packager/media/base/widevine_pssh_data.pb.h"
 
@@ -86,11 +87,11 @@ bool WidevinePsshToJson(const std::vector<uint8_t>& pssh_data,
   base::DictionaryValue pssh_dict;
   pssh_dict.SetString("provider", pssh_proto.provider());
   if (pssh_proto.has_content_id()) {
-    std::string content_id_base64;
-    base::Base64Encode(base::StringPiece(pssh_proto.content_id().data(),
-                                         pssh_proto.content_id().size()),
-                       &content_id_base64);
-    pssh_dict.SetString("content_id", content_id_base64);
+    pssh_dict.SetString(
+        "content_id",
+        media::Base64EncodeData(
+            reinterpret_cast<const uint8_t*>(pssh_proto.content_id().data()),
+            pssh_proto.content_id().size()));
   }
   base::ListValue* key_ids = new base::ListValue();
   key_ids->AppendString(base::HexEncode(key_id.data(), key_id.size()));
@@ -130,6 +131,7 @@ SimpleHlsNotifier::SimpleHlsNotifier(HlsProfile profile,
     : HlsNotifier(profile),
       prefix_(prefix),
       output_dir_(output_dir),
+      window_duration_seconds_(0.0),
       media_playlist_factory_(new MediaPlaylistFactory()),
       master_playlist_(new MasterPlaylist(master_playlist_name)),
       media_playlist_map_deleter_(&media_playlist_map_) {}
@@ -169,6 +171,8 @@ bool SimpleHlsNotifier::NotifyNewStream(const MediaInfo& media_info,
     LOG(ERROR) << "Failed to set media info for playlist " << playlist_name;
     return false;
   }
+  if (window_duration_seconds_ > 0.0)
+    media_playlist->SetWindowDuration(window_duration_seconds_);
 
   *stream_id = sequence_number_.GetNext();
   base::AutoLock auto_lock(lock_);
@@ -211,18 +215,35 @@ bool SimpleHlsNotifier::NotifyEncryptionUpdate(
   }
 
   std::string key_format;
-  std::string key_uri_data;
+  std::string key_uri;
   if (IsWidevineSystemId(system_id)) {
     key_format = "com.widevine";
-    if (!WidevinePsshToJson(protection_system_specific_data, key_id,
-                            &key_uri_data)) {
-      return false;
+    // A rotation event posts the same key information to every rendition.
+    // Converting the PSSH proto to a data URI is comparatively expensive, so
+    // compute it once and share it across playlists.
+    const WidevineKeyUriCache::key_type cache_key(
+        key_id, protection_system_specific_data);
+    WidevineKeyUriCache::const_iterator cached =
+        widevine_key_uri_cache_.find(cache_key);
+    if (cached != widevine_key_uri_cache_.end()) {
+      key_uri = cached->second;
+    } else {
+      std::string key_uri_data;
+      if (!WidevinePsshToJson(protection_system_specific_data, key_id,
+                              &key_uri_data)) {
+        return false;
+      }
+      std::string key_uri_data_base64;
+      base::Base64Encode(key_uri_data, &key_uri_data_base64);
+      key_uri = "data:text/plain;base64," + key_uri_data_base64;
+      widevine_key_uri_cache_[cache_key] = key_uri;
     }
   } else if (IsCommonSystemId(system_id)) {
     key_format = "identity";
     // Use key_id as the key_uri. The player needs to have custom logic to
     // convert it to the actual key url.
-    key_uri_data.assign(key_id.begin(), key_id.end());
+    key_uri = "data:text/plain;base64," +
+              media::Base64EncodeData(key_id.data(), key_id.size());
   } else {
     LOG(ERROR) << "Unknown system ID: "
                << base::HexEncode(system_id.data(), system_id.size());
@@ -234,12 +255,9 @@ bool SimpleHlsNotifier::NotifyEncryptionUpdate(
   if (!iv.empty()) {
     iv_string = "0x" + base::HexEncode(iv.data(), iv.size());
   }
-  std::string key_uri_data_base64;
-  base::Base64Encode(key_uri_data, &key_uri_data_base64);
   media_playlist->AddEncryptionInfo(
-      MediaPlaylist::EncryptionMethod::kSampleAes,
-      "data:text/plain;base64," + key_uri_data_base64, iv_string, key_format,
-      "" /* key_format_versions */);
+      MediaPlaylist::EncryptionMethod::kSampleAes, key_uri, iv_string,
+      key_format, "" /* key_format_versions */);
   return true;
 }
 
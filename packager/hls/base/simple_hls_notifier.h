@@ -9,6 +9,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "packager/base/atomic_sequence_num.h"
@@ -74,11 +75,20 @@ class SimpleHlsNotifier : public HlsNotifier {
   bool Flush() override;
   /// }@
 
+  /// Set the maximum duration, in seconds, covered by segments kept in each
+  /// media playlist created after this call. See
+  /// MediaPlaylist::SetWindowDuration(). Only meaningful for live profile;
+  /// the default (0) keeps every segment.
+  void set_window_duration(double window_duration_seconds) {
+    window_duration_seconds_ = window_duration_seconds;
+  }
+
  private:
   friend class SimpleHlsNotifierTest;
 
   const std::string prefix_;
   const std::string output_dir_;
+  double window_duration_seconds_;
 
   scoped_ptr<MediaPlaylistFactory> media_playlist_factory_;
   scoped_ptr<MasterPlaylist> master_playlist_;
@@ -87,6 +97,13 @@ class SimpleHlsNotifier : public HlsNotifier {
 
   base::AtomicSequenceNumber sequence_number_;
 
+  // Maps (key ID, PSSH data) to the key URI for Widevine key rotation.
+  // Rotation posts the same key information to every rendition, so the PSSH
+  // proto is parsed and encoded once and the URI shared across playlists.
+  typedef std::map<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>,
+                   std::string> WidevineKeyUriCache;
+  WidevineKeyUriCache widevine_key_uri_cache_;
+
   base::Lock lock_;
 
   DISALLOW_COPY_AND_ASSIGN(SimpleHlsNotifier);
@@ -9,6 +9,19 @@
     '../common.gypi',
   ],
   'targets': [
+    {
+      'target_name': 'hls_bench',
+      'type': 'executable',
+      'sources': [
+        'test/hls_bench.cc',
+      ],
+      'dependencies': [
+        '../base/base.gyp:base',
+        '../media/file/file.gyp:file',
+        '../third_party/gflags/gflags.gyp:gflags',
+        'hls_builder',
+      ],
+    },
     {
       'target_name': 'hls_builder',
       'type': '<(component)',
@@ -0,0 +1,181 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for live HLS playlist generation. Drives SimpleHlsNotifier with a
+// multi-rendition ladder, a sliding live window and periodic key rotation,
+// reporting per-event latency and the total number of manifest bytes written.
+// The defaults simulate 24 hours of 2 second segments on 40 renditions.
+// Playlists are written to memory files so the benchmark measures manifest
+// generation, not disk speed.
+
+#include <gflags/gflags.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/at_exit.h"
+#include "packager/base/command_line.h"
+#include "packager/base/logging.h"
+#include "packager/base/macros.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/time/time.h"
+#include "packager/hls/base/hls_notifier.h"
+#include "packager/hls/base/simple_hls_notifier.h"
+#include "packager/media/base/fixed_key_source.h"
+#include "packager/media/file/memory_file.h"
+#include "packager/mpd/base/media_info.pb.h"
+
+DEFINE_int32(num_streams, 40, "Number of media playlists (renditions).");
+DEFINE_int32(num_segment_updates,
+             43200,
+             "Number of segments added to every media playlist. The default "
+             "simulates 24 hours of 2 second segments.");
+DEFINE_double(segment_duration, 2.0, "Segment duration in seconds.");
+DEFINE_double(window_duration,
+              60.0,
+              "Live window in seconds kept in each media playlist. 0 keeps "
+              "every segment.");
+DEFINE_int32(encryption_update_period,
+             150,
+             "Number of segments between NotifyEncryptionUpdate calls (key "
+             "rotation). The default simulates a 5 minute crypto period. 0 "
+             "disables rotation.");
+
+namespace shaka {
+namespace {
+
+const uint32_t kTimeScale = 90000;
+const uint64_t kSegmentSizeBytes = 100 * 1024;
+const char kOutputDir[] = "memory://hls_bench/";
+
+// Accumulates per-event latency for one kind of notifier call.
+struct EventStats {
+  EventStats() : num_events(0) {}
+
+  void Add(base::TimeDelta elapsed) {
+    ++num_events;
+    total_time += elapsed;
+    if (max_time < elapsed)
+      max_time = elapsed;
+  }
+
+  void Print(const char* name) const {
+    if (num_events == 0)
+      return;
+    printf("  %-24s %10" PRId64 " events, %8.1f us avg, %8" PRId64
+           " us max\n",
+           name, num_events,
+           total_time.InMicroseconds() / static_cast<double>(num_events),
+           max_time.InMicroseconds());
+  }
+
+  int64_t num_events;
+  base::TimeDelta total_time;
+  base::TimeDelta max_time;
+};
+
+MediaInfo MakeVideoMediaInfo(int index) {
+  MediaInfo media_info;
+  media_info.set_bandwidth(500000 + index * 100000);
+  media_info.set_segment_template(
+      base::StringPrintf("%svideo_%d_$Number$.ts", kOutputDir, index));
+
+  MediaInfo::VideoInfo* video_info = media_info.mutable_video_info();
+  video_info->set_codec("avc1.4d401f");
+  video_info->set_time_scale(kTimeScale);
+  video_info->set_width(640 + 16 * index);
+  video_info->set_height(360 + 9 * index);
+  return media_info;
+}
+
+int BenchMain(int argc, char** argv) {
+  base::AtExitManager exit;
+  base::CommandLine::Init(argc, argv);
+  CHECK(logging::InitLogging(logging::LoggingSettings()));
+
+  google::SetUsageMessage("Benchmark live HLS playlist generation.");
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  hls::SimpleHlsNotifier notifier(hls::HlsNotifier::HlsProfile::kLiveProfile,
+                                  "" /* prefix */, kOutputDir, "master.m3u8");
+  notifier.set_window_duration(FLAGS_window_duration);
+  CHECK(notifier.Init());
+
+  std::vector<uint32_t> stream_ids;
+  for (int i = 0; i < FLAGS_num_streams; ++i) {
+    uint32_t stream_id = 0;
+    CHECK(notifier.NotifyNewStream(
+        MakeVideoMediaInfo(i), base::StringPrintf("stream_%d.m3u8", i),
+        base::StringPrintf("stream_%d", i), "video", &stream_id));
+    stream_ids.push_back(stream_id);
+  }
+
+  const std::vector<uint8_t> system_id(
+      media::kCommonSystemId,
+      media::kCommonSystemId + arraysize(media::kCommonSystemId));
+  const std::vector<uint8_t> iv(16, 0x42);
+  const std::vector<uint8_t> no_pssh_data;
+
+  media::MemoryFile::ResetTotalBytesWritten();
+  EventStats segment_stats;
+  EventStats encryption_stats;
+  EventStats flush_stats;
+
+  const uint64_t segment_duration =
+      static_cast<uint64_t>(FLAGS_segment_duration * kTimeScale);
+  const base::TimeTicks bench_start = base::TimeTicks::Now();
+  for (int update = 0; update < FLAGS_num_segment_updates; ++update) {
+    if (FLAGS_encryption_update_period > 0 &&
+        update % FLAGS_encryption_update_period == 0) {
+      // Rotate to a new key; every rendition receives the same key.
+      std::vector<uint8_t> key_id(16, 0);
+      key_id[0] = update & 0xff;
+      key_id[1] = (update >> 8) & 0xff;
+      for (size_t i = 0; i < stream_ids.size(); ++i) {
+        const base::TimeTicks start = base::TimeTicks::Now();
+        CHECK(notifier.NotifyEncryptionUpdate(stream_ids[i], key_id, system_id,
+                                              iv, no_pssh_data));
+        encryption_stats.Add(base::TimeTicks::Now() - start);
+      }
+    }
+
+    const uint64_t start_time = update * segment_duration;
+    for (size_t i = 0; i < stream_ids.size(); ++i) {
+      const std::string segment_name = base::StringPrintf(
+          "%svideo_%zu_%d.ts", kOutputDir, i, update);
+      const base::TimeTicks start = base::TimeTicks::Now();
+      CHECK(notifier.NotifyNewSegment(stream_ids[i], segment_name, start_time,
+                                      segment_duration, kSegmentSizeBytes));
+      segment_stats.Add(base::TimeTicks::Now() - start);
+    }
+
+    // Rewrite the playlists once per segment, as a live packager would.
+    const base::TimeTicks start = base::TimeTicks::Now();
+    CHECK(notifier.Flush());
+    flush_stats.Add(base::TimeTicks::Now() - start);
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - bench_start;
+
+  printf("SimpleHlsNotifier: %d streams, %d segment updates\n",
+         FLAGS_num_streams, FLAGS_num_segment_updates);
+  segment_stats.Print("NotifyNewSegment");
+  encryption_stats.Print("NotifyEncryptionUpdate");
+  flush_stats.Print("Flush");
+  printf("  total %.1f s, manifest bytes written %" PRIu64 "\n",
+         elapsed.InSecondsF(), media::MemoryFile::total_bytes_written());
+
+  media::MemoryFile::DeleteAll();
+  return 0;
+}
+
+}  // namespace
+}  // namespace shaka
+
+int main(int argc, char** argv) {
+  return shaka::BenchMain(argc, argv);
+}
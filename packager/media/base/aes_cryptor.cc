@@ -6,13 +6,17 @@
 
 #include "packager/media/base/aes_cryptor.h"
 
+#include <string.h>
+
 #include <string>
 #include <vector>
 
 #include <openssl/aes.h>
 #include <openssl/err.h>
 #include <openssl/rand.h>
+#include <openssl/sha.h>
 
+#include "packager/base/atomicops.h"
 #include "packager/base/logging.h"
 #include "packager/base/stl_util.h"
 
@@ -24,6 +28,13 @@ bool IsIvSizeValid(size_t iv_size) {
   return iv_size == 8 || iv_size == 16;
 }
 
+// Seed state for deterministic iv generation (see AesCryptor::SetIvSeed).
+// The seed is stored as its SHA-256 digest so the derivation works on a
+// fixed size block. The counter keeps successive ivs within a run distinct.
+bool g_iv_seed_set = false;
+uint8_t g_iv_seed_digest[SHA256_DIGEST_LENGTH];
+base::subtle::AtomicWord g_iv_counter = 0;
+
 }  // namespace
 
 namespace shaka {
@@ -117,6 +128,20 @@ bool AesCryptor::GenerateRandomIv(FourCC protection_scheme,
           ? 8
           : 16;
   iv->resize(iv_size);
+  if (g_iv_seed_set) {
+    // Derive the iv from the seed digest and a monotonic counter: each call
+    // yields a distinct iv and identical reruns see the same sequence.
+    const uint64_t counter = static_cast<uint64_t>(
+        base::subtle::NoBarrier_AtomicIncrement(&g_iv_counter, 1));
+    uint8_t block[SHA256_DIGEST_LENGTH + sizeof(counter)];
+    memcpy(block, g_iv_seed_digest, SHA256_DIGEST_LENGTH);
+    for (size_t i = 0; i < sizeof(counter); ++i)
+      block[SHA256_DIGEST_LENGTH + i] = (counter >> (8 * (7 - i))) & 0xFF;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256(block, sizeof(block), digest);
+    memcpy(iv->data(), digest, iv_size);
+    return true;
+  }
   if (RAND_bytes(iv->data(), iv_size) != 1) {
     LOG(ERROR) << "RAND_bytes failed with error: "
                << ERR_error_string(ERR_get_error(), NULL);
@@ -125,6 +150,16 @@ bool AesCryptor::GenerateRandomIv(FourCC protection_scheme,
   return true;
 }
 
+void AesCryptor::SetIvSeed(const std::vector<uint8_t>& seed) {
+  if (seed.empty()) {
+    g_iv_seed_set = false;
+  } else {
+    SHA256(seed.data(), seed.size(), g_iv_seed_digest);
+    g_iv_seed_set = true;
+  }
+  base::subtle::NoBarrier_Store(&g_iv_counter, 0);
+}
+
 size_t AesCryptor::NumPaddingBytes(size_t size) const {
   // No padding by default.
   return 0;
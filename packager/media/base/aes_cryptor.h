@@ -90,6 +90,17 @@ class AesCryptor {
   static bool GenerateRandomIv(FourCC protection_scheme,
                                std::vector<uint8_t>* iv);
 
+  /// Seed deterministic iv generation. With a non-empty @a seed,
+  /// GenerateRandomIv derives ivs from the seed and an internal counter
+  /// instead of the system RNG, so reruns of the same job generate the same
+  /// iv sequence and, with fixed timestamps, byte-identical output. The seed
+  /// applies process-wide and must be set before ivs are generated; an empty
+  /// @a seed restores the system RNG and resets the counter. Only reuse a
+  /// seed to re-encrypt the same content with the same key — sharing it
+  /// across contents repeats ivs.
+  /// @param seed is the seed bytes, e.g. derived from the key id.
+  static void SetIvSeed(const std::vector<uint8_t>& seed);
+
  protected:
   const AES_KEY* aes_key() const { return aes_key_.get(); }
   AES_KEY* mutable_aes_key() { return aes_key_.get(); }
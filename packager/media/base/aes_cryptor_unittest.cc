@@ -242,6 +242,33 @@ TEST_F(AesCtrEncryptorTest, GenerateRandomIv) {
   LOG(INFO) << "Random IV: " << base::HexEncode(iv.data(), iv.size());
 }
 
+TEST_F(AesCtrEncryptorTest, GenerateSeededIv) {
+  const uint8_t kSeed[] = {0x01, 0x02, 0x03, 0x04};
+  std::vector<uint8_t> seed(kSeed, kSeed + arraysize(kSeed));
+
+  AesCryptor::SetIvSeed(seed);
+  std::vector<uint8_t> iv1;
+  std::vector<uint8_t> iv2;
+  ASSERT_TRUE(AesCryptor::GenerateRandomIv(FOURCC_cenc, &iv1));
+  ASSERT_TRUE(AesCryptor::GenerateRandomIv(FOURCC_cbcs, &iv2));
+  EXPECT_EQ(8u, iv1.size());
+  EXPECT_EQ(16u, iv2.size());
+  // Successive ivs differ even with the same seed.
+  EXPECT_NE(iv1, std::vector<uint8_t>(iv2.begin(), iv2.begin() + 8));
+
+  // Re-seeding resets the counter, so the same sequence is generated again.
+  AesCryptor::SetIvSeed(seed);
+  std::vector<uint8_t> iv3;
+  std::vector<uint8_t> iv4;
+  ASSERT_TRUE(AesCryptor::GenerateRandomIv(FOURCC_cenc, &iv3));
+  ASSERT_TRUE(AesCryptor::GenerateRandomIv(FOURCC_cbcs, &iv4));
+  EXPECT_EQ(iv1, iv3);
+  EXPECT_EQ(iv2, iv4);
+
+  // Restore the system RNG for other tests.
+  AesCryptor::SetIvSeed(std::vector<uint8_t>());
+}
+
 TEST_F(AesCtrEncryptorTest, UnsupportedKeySize) {
   std::vector<uint8_t> key(kInvalidKey, kInvalidKey + arraysize(kInvalidKey));
   ASSERT_FALSE(encryptor_.InitializeWithIv(key, iv_));
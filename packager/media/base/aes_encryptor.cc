@@ -6,9 +6,29 @@
 
 #include "packager/media/base/aes_encryptor.h"
 
+#include <limits.h>
 #include <openssl/aes.h>
+#include <openssl/evp.h>
+#include <string.h>
 
+#include <algorithm>
+
+#include <gflags/gflags.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
 #include "packager/base/logging.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/worker_pool.h"
+
+DEFINE_uint64(keystream_lookahead_bytes,
+              0,
+              "If nonzero, AES-CTR encryptors precompute this many bytes of "
+              "keystream in the background on the worker pool, staying ahead "
+              "of the encrypt position. Sample encryption on the muxer "
+              "thread then reduces to a XOR against the buffered keystream. "
+              "Zero disables the lookahead.");
 
 namespace {
 
@@ -22,6 +42,25 @@ bool Increment64(uint8_t* counter) {
   return true;
 }
 
+// Advance an 8-byte big-endian counter by |num_blocks|.
+void Advance64(uint8_t* counter, uint64_t num_blocks) {
+  DCHECK(counter);
+  uint64_t increment = num_blocks;
+  for (int i = 7; increment > 0 && i >= 0; --i) {
+    increment += counter[i];
+    counter[i] = increment & 0xFF;
+    increment >>= 8;
+  }
+}
+
+// Read an 8-byte big-endian counter.
+uint64_t Load64(const uint8_t* counter) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i)
+    value = (value << 8) | counter[i];
+  return value;
+}
+
 // AES defines three key sizes: 128, 192 and 256 bits.
 bool IsKeySizeValidForAes(size_t key_size) {
   return key_size == 16 || key_size == 24 || key_size == 32;
@@ -32,6 +71,163 @@ bool IsKeySizeValidForAes(size_t key_size) {
 namespace shaka {
 namespace media {
 
+// Generates AES-CTR keystream ahead of the consumer on the worker pool. Two
+// chunks are kept in flight: while the encryptor XORs plaintext against the
+// front chunk, the back chunk is refilled in the background. Restarted from
+// the fresh counter whenever the IV changes; if the consumer ever advances
+// its counter through another path, the buffered keystream no longer lines
+// up and the prefetcher stays idle until the next restart.
+class AesCtrKeystreamPrefetcher {
+ public:
+  AesCtrKeystreamPrefetcher(const EVP_CIPHER* cipher,
+                            const std::vector<uint8_t>& key,
+                            size_t chunk_size)
+      : chunk_size_(chunk_size),
+        cipher_ctx_(EVP_CIPHER_CTX_new()),
+        invalidated_(true),
+        active_(0),
+        next_counter_(AES_BLOCK_SIZE, 0) {
+    DCHECK_GE(chunk_size_, static_cast<size_t>(AES_BLOCK_SIZE));
+    DCHECK_EQ(0u, chunk_size_ % AES_BLOCK_SIZE);
+    if (cipher_ctx_ &&
+        EVP_EncryptInit_ex(cipher_ctx_, cipher, NULL, key.data(), NULL) != 1) {
+      EVP_CIPHER_CTX_free(cipher_ctx_);
+      cipher_ctx_ = NULL;
+    }
+  }
+
+  ~AesCtrKeystreamPrefetcher() {
+    WaitForFills();
+    if (cipher_ctx_)
+      EVP_CIPHER_CTX_free(cipher_ctx_);
+  }
+
+  // Whether the cipher context was set up successfully.
+  bool valid() const { return cipher_ctx_ != NULL; }
+
+  // Discards buffered keystream and restarts generation at |counter|.
+  void Restart(const std::vector<uint8_t>& counter) {
+    DCHECK_EQ(counter.size(), static_cast<size_t>(AES_BLOCK_SIZE));
+    WaitForFills();
+    invalidated_ = false;
+    active_ = 0;
+    next_counter_ = counter;
+    for (int i = 0; i < 2; ++i) {
+      chunks_[i].ready.Reset();
+      ScheduleFill(&chunks_[i]);
+    }
+  }
+
+  // Stops serving keystream until the next Restart. Called when the consumer
+  // advances its counter outside of Consume.
+  void Invalidate() { invalidated_ = true; }
+
+  // Points |*keystream| at up to |max_bytes| of buffered keystream and
+  // returns the number of bytes available, a multiple of the block size;
+  // waits for background generation if necessary. Returns 0 if prefetch is
+  // not serviceable, in which case the caller should fall back.
+  size_t Acquire(size_t max_bytes, const uint8_t** keystream) {
+    if (invalidated_)
+      return 0;
+    Chunk& chunk = chunks_[active_];
+    chunk.ready.Wait();
+    if (chunk.offset >= chunk.data.size())
+      return 0;
+    const size_t available =
+        std::min(max_bytes, chunk.data.size() - chunk.offset);
+    *keystream = &chunk.data[chunk.offset];
+    return available;
+  }
+
+  // Releases |num_bytes| of keystream returned by Acquire and schedules a
+  // refill once a chunk is drained.
+  void Consume(size_t num_bytes) {
+    DCHECK_EQ(0u, num_bytes % AES_BLOCK_SIZE);
+    Chunk& chunk = chunks_[active_];
+    chunk.offset += num_bytes;
+    DCHECK_LE(chunk.offset, chunk.data.size());
+    if (chunk.offset == chunk.data.size()) {
+      chunk.ready.Reset();
+      ScheduleFill(&chunk);
+      active_ ^= 1;
+    }
+  }
+
+ private:
+  struct Chunk {
+    // |ready| starts signaled so WaitForFills works before the first fill.
+    Chunk() : offset(0), ready(true, true) {}
+
+    std::vector<uint8_t> data;
+    size_t offset;
+    base::WaitableEvent ready;
+  };
+
+  // Fills |chunk| with keystream starting at |counter|; runs on the worker
+  // pool. An empty chunk is published on cipher failure.
+  static void FillChunkTask(AesCtrKeystreamPrefetcher* prefetcher,
+                            Chunk* chunk,
+                            std::vector<uint8_t> counter) {
+    {
+      base::AutoLock lock(prefetcher->fill_lock_);
+      chunk->offset = 0;
+      chunk->data.assign(prefetcher->chunk_size_, 0);
+      int output_size = 0;
+      const int chunk_size = static_cast<int>(prefetcher->chunk_size_);
+      // Encrypting zeros in counter mode yields the raw keystream.
+      if (EVP_EncryptInit_ex(prefetcher->cipher_ctx_, NULL, NULL, NULL,
+                             counter.data()) != 1 ||
+          EVP_EncryptUpdate(prefetcher->cipher_ctx_, &chunk->data[0],
+                            &output_size, &chunk->data[0], chunk_size) != 1 ||
+          output_size != chunk_size) {
+        chunk->data.clear();
+      }
+    }
+    chunk->ready.Signal();
+  }
+
+  // Hands |chunk| to the worker pool with the next counter range. Counters
+  // are assigned here, on the consumer thread, so concurrent fills cannot
+  // reorder the keystream.
+  void ScheduleFill(Chunk* chunk) {
+    const uint64_t num_blocks = chunk_size_ / AES_BLOCK_SIZE;
+    const uint64_t counter_low = Load64(&next_counter_[8]);
+    if (counter_low + num_blocks < counter_low) {
+      // Per CENC only the low 64 counter bits are incremented; do not
+      // generate keystream across the wrap. The consumer falls back.
+      chunk->data.clear();
+      chunk->offset = 0;
+      chunk->ready.Signal();
+      return;
+    }
+    std::vector<uint8_t> counter = next_counter_;
+    Advance64(&next_counter_[8], num_blocks);
+    base::WorkerPool::PostTask(
+        FROM_HERE,
+        base::Bind(&AesCtrKeystreamPrefetcher::FillChunkTask, this, chunk,
+                   counter),
+        true /* task_is_slow */);
+  }
+
+  // Waits until no fill task is in flight.
+  void WaitForFills() {
+    for (int i = 0; i < 2; ++i)
+      chunks_[i].ready.Wait();
+  }
+
+  const size_t chunk_size_;
+  // Serializes fill tasks' use of |cipher_ctx_|.
+  base::Lock fill_lock_;
+  EVP_CIPHER_CTX* cipher_ctx_;
+  bool invalidated_;
+  size_t active_;
+  Chunk chunks_[2];
+  // Counter for the next scheduled chunk; consumer thread only.
+  std::vector<uint8_t> next_counter_;
+
+  DISALLOW_COPY_AND_ASSIGN(AesCtrKeystreamPrefetcher);
+};
+
 AesEncryptor::AesEncryptor(ConstantIvFlag constant_iv_flag)
     : AesCryptor(constant_iv_flag) {}
 AesEncryptor::~AesEncryptor() {}
@@ -53,10 +249,61 @@ bool AesEncryptor::InitializeWithIv(const std::vector<uint8_t>& key,
 AesCtrEncryptor::AesCtrEncryptor()
     : AesEncryptor(kDontUseConstantIv),
       block_offset_(0),
-      encrypted_counter_(AES_BLOCK_SIZE, 0) {}
+      encrypted_counter_(AES_BLOCK_SIZE, 0),
+      cipher_ctx_(NULL) {}
 
-AesCtrEncryptor::~AesCtrEncryptor() {}
+AesCtrEncryptor::~AesCtrEncryptor() {
+  if (cipher_ctx_)
+    EVP_CIPHER_CTX_free(cipher_ctx_);
+}
 
+bool AesCtrEncryptor::InitializeWithIv(const std::vector<uint8_t>& key,
+                                       const std::vector<uint8_t>& iv) {
+  // The batched cipher uses hardware AES instructions through the library's
+  // runtime CPU dispatch, processing many counter blocks per call; the
+  // block-by-block path below remains as the fallback.
+  const EVP_CIPHER* cipher = NULL;
+  switch (key.size()) {
+    case 16:
+      cipher = EVP_aes_128_ctr();
+      break;
+    case 32:
+      cipher = EVP_aes_256_ctr();
+      break;
+    default:
+      // No batched cipher for this key size; invalid sizes are rejected by
+      // AesEncryptor::InitializeWithIv below.
+      break;
+  }
+  if (cipher) {
+    if (!cipher_ctx_)
+      cipher_ctx_ = EVP_CIPHER_CTX_new();
+    if (cipher_ctx_ &&
+        EVP_EncryptInit_ex(cipher_ctx_, cipher, NULL, key.data(), NULL) != 1) {
+      LOG(WARNING) << "Failed to set up batched AES-CTR cipher; falling back "
+                      "to block-by-block encryption.";
+      EVP_CIPHER_CTX_free(cipher_ctx_);
+      cipher_ctx_ = NULL;
+    }
+  }
+
+  keystream_prefetcher_.reset();
+  if (cipher && FLAGS_keystream_lookahead_bytes > 0) {
+    // Two chunks are in flight, so each covers half the configured lookahead.
+    size_t chunk_size = static_cast<size_t>(FLAGS_keystream_lookahead_bytes / 2);
+    chunk_size -= chunk_size % AES_BLOCK_SIZE;
+    chunk_size = std::max(chunk_size, static_cast<size_t>(AES_BLOCK_SIZE));
+    scoped_ptr<AesCtrKeystreamPrefetcher> prefetcher(
+        new AesCtrKeystreamPrefetcher(cipher, key, chunk_size));
+    if (prefetcher->valid()) {
+      keystream_prefetcher_ = prefetcher.Pass();
+    } else {
+      LOG(WARNING) << "Failed to set up the keystream prefetcher; encrypting "
+                      "inline.";
+    }
+  }
+  return AesEncryptor::InitializeWithIv(key, iv);
+}
 
 bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
                                     size_t plaintext_size,
@@ -74,9 +321,62 @@ bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
   }
   *ciphertext_size = plaintext_size;
 
-  for (size_t i = 0; i < plaintext_size; ++i) {
+  size_t remaining_size = plaintext_size;
+  // Consume the remainder of a keystream block left over from the previous
+  // call, to get to a block boundary for the batched path.
+  while (remaining_size > 0 && block_offset_ != 0) {
+    *ciphertext++ = *plaintext++ ^ encrypted_counter_[block_offset_];
+    block_offset_ = (block_offset_ + 1) % AES_BLOCK_SIZE;
+    --remaining_size;
+  }
+
+  // XOR whole blocks against keystream generated in the background. The
+  // simple loop vectorizes; the cipher work has already happened off-thread.
+  size_t num_whole_blocks = remaining_size / AES_BLOCK_SIZE;
+  if (keystream_prefetcher_) {
+    const uint8_t* keystream = NULL;
+    size_t available;
+    while (num_whole_blocks > 0 &&
+           (available = keystream_prefetcher_->Acquire(
+                num_whole_blocks * AES_BLOCK_SIZE, &keystream)) > 0) {
+      for (size_t i = 0; i < available; ++i)
+        ciphertext[i] = plaintext[i] ^ keystream[i];
+      keystream_prefetcher_->Consume(available);
+      Advance64(&counter_[8], available / AES_BLOCK_SIZE);
+      plaintext += available;
+      ciphertext += available;
+      remaining_size -= available;
+      num_whole_blocks = remaining_size / AES_BLOCK_SIZE;
+    }
+  }
+
+  if (num_whole_blocks > 0) {
+    // The prefetched keystream no longer matches the counter after this.
+    if (keystream_prefetcher_)
+      keystream_prefetcher_->Invalidate();
+    if (EncryptWholeBlocks(plaintext, ciphertext, num_whole_blocks)) {
+      const size_t whole_blocks_size = num_whole_blocks * AES_BLOCK_SIZE;
+      plaintext += whole_blocks_size;
+      ciphertext += whole_blocks_size;
+      remaining_size -= whole_blocks_size;
+    }
+  }
+
+  for (size_t i = 0; i < remaining_size; ++i) {
     if (block_offset_ == 0) {
-      AES_encrypt(&counter_[0], &encrypted_counter_[0], aes_key());
+      const uint8_t* keystream = NULL;
+      if (keystream_prefetcher_ &&
+          keystream_prefetcher_->Acquire(AES_BLOCK_SIZE, &keystream) >=
+              static_cast<size_t>(AES_BLOCK_SIZE)) {
+        // Serve the partial block from the prefetched keystream so the
+        // lookahead stays aligned with the counter.
+        memcpy(&encrypted_counter_[0], keystream, AES_BLOCK_SIZE);
+        keystream_prefetcher_->Consume(AES_BLOCK_SIZE);
+      } else {
+        if (keystream_prefetcher_)
+          keystream_prefetcher_->Invalidate();
+        AES_encrypt(&counter_[0], &encrypted_counter_[0], aes_key());
+      }
       // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
       // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
       // simple 64 bit unsigned integer that is incremented by one for each
@@ -90,10 +390,46 @@ bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
   return true;
 }
 
+bool AesCtrEncryptor::EncryptWholeBlocks(const uint8_t* plaintext,
+                                         uint8_t* ciphertext,
+                                         size_t num_blocks) {
+  DCHECK_EQ(0u, block_offset_);
+  if (!cipher_ctx_)
+    return false;
+  const size_t size = num_blocks * AES_BLOCK_SIZE;
+  if (size > static_cast<size_t>(INT_MAX))
+    return false;
+  // Per CENC only the low 64 bits of the counter block are incremented,
+  // while the batched cipher carries into the high bits. Fall back if the
+  // low half would wrap within this span, so the two paths always produce
+  // identical output.
+  const uint64_t counter_low = Load64(&counter_[8]);
+  if (counter_low + num_blocks < counter_low)
+    return false;
+
+  if (EVP_EncryptInit_ex(cipher_ctx_, NULL, NULL, NULL, counter_.data()) != 1)
+    return false;
+  int output_size = 0;
+  if (EVP_EncryptUpdate(cipher_ctx_, ciphertext, &output_size, plaintext,
+                        static_cast<int>(size)) != 1 ||
+      output_size != static_cast<int>(size)) {
+    LOG(ERROR) << "Batched AES-CTR encryption failed.";
+    return false;
+  }
+
+  // Advance the counter past the encrypted blocks.
+  Advance64(&counter_[8], num_blocks);
+  return true;
+}
+
 void AesCtrEncryptor::SetIvInternal() {
   block_offset_ = 0;
   counter_ = iv();
   counter_.resize(AES_BLOCK_SIZE, 0);
+  // Kick off generation for the new counter sequence; it proceeds in the
+  // background while the caller assembles the next sample.
+  if (keystream_prefetcher_)
+    keystream_prefetcher_->Restart(counter_);
 }
 
 AesCbcEncryptor::AesCbcEncryptor(CbcPaddingScheme padding_scheme)
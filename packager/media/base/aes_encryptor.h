@@ -16,9 +16,13 @@
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/aes_cryptor.h"
 
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
 namespace shaka {
 namespace media {
 
+class AesCtrKeystreamPrefetcher;
+
 class AesEncryptor : public AesCryptor {
  public:
   /// @param constant_iv_flag indicates whether a constant iv is used,
@@ -45,6 +49,13 @@ class AesCtrEncryptor : public AesEncryptor {
   AesCtrEncryptor();
   ~AesCtrEncryptor() override;
 
+  /// Initialize the encryptor with specified key and IV. Also sets up a
+  /// batched counter-mode cipher, which uses hardware AES instructions where
+  /// the platform provides them.
+  /// @return true on successful initialization, false otherwise.
+  bool InitializeWithIv(const std::vector<uint8_t>& key,
+                        const std::vector<uint8_t>& iv) override;
+
   uint32_t block_offset() const { return block_offset_; }
 
  private:
@@ -54,12 +65,27 @@ class AesCtrEncryptor : public AesEncryptor {
                      size_t* ciphertext_size) override;
   void SetIvInternal() override;
 
+  // Encrypts |num_blocks| whole blocks in one batched call, starting at a
+  // block boundary. Returns false if the batched cipher is unavailable or
+  // cannot be used for this span, in which case nothing has been consumed
+  // and the caller falls back to the block-by-block path.
+  bool EncryptWholeBlocks(const uint8_t* plaintext,
+                          uint8_t* ciphertext,
+                          size_t num_blocks);
+
   // Current block offset.
   uint32_t block_offset_;
   // Current AES-CTR counter.
   std::vector<uint8_t> counter_;
   // Encrypted counter.
   std::vector<uint8_t> encrypted_counter_;
+  // Cipher context for the batched counter-mode path, NULL if the key size
+  // has no batched cipher.
+  EVP_CIPHER_CTX* cipher_ctx_;
+  // Generates keystream ahead of the encrypt position on the worker pool,
+  // so encryption degrades to a XOR on this thread. NULL unless enabled via
+  // --keystream_lookahead_bytes.
+  scoped_ptr<AesCtrKeystreamPrefetcher> keystream_prefetcher_;
 
   DISALLOW_COPY_AND_ASSIGN(AesCtrEncryptor);
 };
@@ -62,26 +62,42 @@ bool AesPatternCryptor::CryptInternal(const uint8_t* text,
     return true;
   }
 
-  while (text_size > 0) {
-    const size_t crypt_byte_size = crypt_byte_block_ * AES_BLOCK_SIZE;
-    if (NeedEncrypt(text_size, crypt_byte_size)) {
-      if (!cryptor_->Crypt(text, crypt_byte_size, crypt_text))
-        return false;
-    } else {
-      // If there is not enough data, just keep it in clear.
-      memcpy(crypt_text, text, text_size);
-      return true;
-    }
-    text += crypt_byte_size;
-    text_size -= crypt_byte_size;
-    crypt_text += crypt_byte_size;
-
-    const size_t skip_byte_size = std::min(
-        static_cast<size_t>(skip_byte_block_ * AES_BLOCK_SIZE), text_size);
-    memcpy(crypt_text, text, skip_byte_size);
-    text += skip_byte_size;
-    text_size -= skip_byte_size;
-    crypt_text += skip_byte_size;
+  const size_t crypt_byte_size = crypt_byte_block_ * AES_BLOCK_SIZE;
+  const size_t skip_byte_size = skip_byte_block_ * AES_BLOCK_SIZE;
+
+  // Gather all pattern blocks into one contiguous buffer and encrypt them in
+  // a single call. The wrapped cryptor chains its state across calls (cipher
+  // block chain or counter), so this produces the same bytes as encrypting
+  // one crypt_byte_block at a time, without a cryptor round trip per block.
+  size_t encrypted_size = 0;
+  for (size_t remaining = text_size; NeedEncrypt(remaining, crypt_byte_size);) {
+    encrypted_size += crypt_byte_size;
+    remaining -= crypt_byte_size;
+    remaining -= std::min(skip_byte_size, remaining);
+  }
+
+  // One wide copy covers the skip blocks and the clear remainder.
+  if (crypt_text != text)
+    memcpy(crypt_text, text, text_size);
+  if (encrypted_size == 0)
+    return true;
+
+  crypt_buffer_.resize(encrypted_size);
+  uint8_t* gather = &crypt_buffer_[0];
+  for (size_t offset = 0; gather != &crypt_buffer_[0] + encrypted_size;
+       offset += crypt_byte_size + skip_byte_size) {
+    memcpy(gather, text + offset, crypt_byte_size);
+    gather += crypt_byte_size;
+  }
+
+  if (!cryptor_->Crypt(&crypt_buffer_[0], encrypted_size, &crypt_buffer_[0]))
+    return false;
+
+  const uint8_t* scatter = &crypt_buffer_[0];
+  for (size_t offset = 0; scatter != &crypt_buffer_[0] + encrypted_size;
+       offset += crypt_byte_size + skip_byte_size) {
+    memcpy(crypt_text + offset, scatter, crypt_byte_size);
+    scatter += crypt_byte_size;
   }
   return true;
 }
@@ -4,6 +4,8 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <vector>
+
 #include "packager/media/base/aes_cryptor.h"
 
 #include "packager/base/macros.h"
@@ -75,6 +77,9 @@ class AesPatternCryptor : public AesCryptor {
   const uint8_t skip_byte_block_;
   const PatternEncryptionMode encryption_mode_;
   scoped_ptr<AesCryptor> cryptor_;
+  // Scratch buffer the pattern blocks are gathered into, so they can be
+  // encrypted in one batched call.
+  std::vector<uint8_t> crypt_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(AesPatternCryptor);
 };
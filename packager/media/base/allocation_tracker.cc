@@ -0,0 +1,87 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/allocation_tracker.h"
+
+#if defined(PACKAGER_TRACK_ALLOCATIONS)
+
+#include "packager/base/atomicops.h"
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+
+const char* kScopeNames[AllocationTracker::kNumScopes] = {
+    "untagged", "parser", "muxer", "manifest",
+};
+
+// Live bytes and high-water marks per scope. Updated from multiple pipeline
+// threads; a charge created on one thread may be released on another.
+base::subtle::AtomicWord g_live_bytes[AllocationTracker::kNumScopes];
+base::subtle::AtomicWord g_high_water[AllocationTracker::kNumScopes];
+
+// Scope that new charges on this thread are attributed to.
+thread_local AllocationTracker::Scope tls_scope =
+    AllocationTracker::kScopeUntagged;
+
+void AdjustLiveBytes(AllocationTracker::Scope scope, intptr_t delta) {
+  const base::subtle::AtomicWord live =
+      base::subtle::NoBarrier_AtomicIncrement(&g_live_bytes[scope], delta);
+  // Raise the high-water mark if this thread observed a new peak. The loop
+  // retries until the mark is at least |live| or someone else raised it
+  // higher.
+  for (;;) {
+    const base::subtle::AtomicWord high_water =
+        base::subtle::NoBarrier_Load(&g_high_water[scope]);
+    if (live <= high_water)
+      break;
+    if (base::subtle::NoBarrier_CompareAndSwap(&g_high_water[scope],
+                                               high_water, live) == high_water)
+      break;
+  }
+}
+
+}  // namespace
+
+AllocationTracker::Charge::Charge() : scope_(tls_scope), bytes_(0) {}
+
+AllocationTracker::Charge::~Charge() {
+  UpdateTo(0);
+}
+
+void AllocationTracker::Charge::UpdateTo(size_t bytes) {
+  if (bytes == bytes_)
+    return;
+  AdjustLiveBytes(scope_, static_cast<intptr_t>(bytes) -
+                              static_cast<intptr_t>(bytes_));
+  bytes_ = bytes;
+}
+
+// static
+void AllocationTracker::DumpHighWaterMarks() {
+  for (int i = 0; i < kNumScopes; ++i) {
+    LOG(INFO) << "Allocation high-water mark [" << kScopeNames[i]
+              << "]: " << base::subtle::NoBarrier_Load(&g_high_water[i])
+              << " bytes (live at dump: "
+              << base::subtle::NoBarrier_Load(&g_live_bytes[i]) << " bytes)";
+  }
+}
+
+ScopedAllocationScope::ScopedAllocationScope(AllocationTracker::Scope scope)
+    : previous_scope_(tls_scope) {
+  tls_scope = scope;
+}
+
+ScopedAllocationScope::~ScopedAllocationScope() {
+  tls_scope = previous_scope_;
+}
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // defined(PACKAGER_TRACK_ALLOCATIONS)
@@ -0,0 +1,98 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_ALLOCATION_TRACKER_H_
+#define MEDIA_BASE_ALLOCATION_TRACKER_H_
+
+#include <stddef.h>
+
+#include "packager/base/macros.h"
+
+namespace shaka {
+namespace media {
+
+/// Attributes heap bytes held by the media/base allocating types
+/// (BufferWriter, ByteQueue, MediaSample) to the pipeline subsystem that
+/// created them, and records a per-subsystem high-water mark. Only active in
+/// builds with PACKAGER_TRACK_ALLOCATIONS defined (GYP_DEFINES=
+/// "packager_track_allocations=1"); in regular builds every hook compiles to
+/// nothing.
+class AllocationTracker {
+ public:
+  /// Subsystem the bytes are attributed to. An allocation is charged to the
+  /// scope that is current on the allocating thread (see
+  /// ScopedAllocationScope), which stays charged until the owning object
+  /// releases the bytes, regardless of which thread frees them.
+  enum Scope {
+    kScopeUntagged = 0,
+    kScopeParser,
+    kScopeMuxer,
+    kScopeManifest,
+    kNumScopes
+  };
+
+  /// Tracks the heap bytes held by one object. Embed an instance in the
+  /// owning class and call UpdateTo() whenever the object's heap footprint
+  /// changes; the destructor releases whatever is still charged.
+  class Charge {
+   public:
+#if defined(PACKAGER_TRACK_ALLOCATIONS)
+    Charge();
+    ~Charge();
+
+    /// Adjust the live byte count of this charge's scope so that this object
+    /// accounts for @a bytes heap bytes in total.
+    void UpdateTo(size_t bytes);
+
+   private:
+    Scope scope_;
+    size_t bytes_;
+#else
+    Charge() {}
+    ~Charge() {}
+    void UpdateTo(size_t /* bytes */) {}
+
+   private:
+#endif
+    DISALLOW_COPY_AND_ASSIGN(Charge);
+  };
+
+  /// Log the per-scope high-water marks. Intended to be called once at the
+  /// end of a packaging job. No-op in regular builds.
+#if defined(PACKAGER_TRACK_ALLOCATIONS)
+  static void DumpHighWaterMarks();
+#else
+  static void DumpHighWaterMarks() {}
+#endif
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(AllocationTracker);
+};
+
+/// Sets the calling thread's allocation scope for the lifetime of the object
+/// and restores the previous scope on destruction. Charges created while the
+/// scope is active are attributed to it.
+class ScopedAllocationScope {
+ public:
+#if defined(PACKAGER_TRACK_ALLOCATIONS)
+  explicit ScopedAllocationScope(AllocationTracker::Scope scope);
+  ~ScopedAllocationScope();
+
+ private:
+  AllocationTracker::Scope previous_scope_;
+#else
+  explicit ScopedAllocationScope(AllocationTracker::Scope /* scope */) {}
+  ~ScopedAllocationScope() {}
+
+ private:
+#endif
+  DISALLOW_COPY_AND_ASSIGN(ScopedAllocationScope);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_ALLOCATION_TRACKER_H_
@@ -12,15 +12,22 @@ namespace media {
 
 AudioTimestampHelper::AudioTimestampHelper(uint32_t timescale,
                                            uint32_t samples_per_second)
-    : base_timestamp_(kNoTimestamp), frame_count_(0) {
+    : timescale_(timescale),
+      samples_per_second_(samples_per_second),
+      base_timestamp_(kNoTimestamp),
+      frame_count_(0),
+      accumulated_ticks_(0),
+      remainder_(0) {
   DCHECK_GT(samples_per_second, 0u);
-  double fps = samples_per_second;
-  ticks_per_frame_ = timescale / fps;
+  ticks_per_frame_ = timescale / samples_per_second;
+  ticks_remainder_ = timescale % samples_per_second;
 }
 
 void AudioTimestampHelper::SetBaseTimestamp(int64_t base_timestamp) {
   base_timestamp_ = base_timestamp;
   frame_count_ = 0;
+  accumulated_ticks_ = 0;
+  remainder_ = 0;
 }
 
 int64_t AudioTimestampHelper::base_timestamp() const {
@@ -31,10 +38,24 @@ void AudioTimestampHelper::AddFrames(int64_t frame_count) {
   DCHECK_GE(frame_count, 0);
   DCHECK(base_timestamp_ != kNoTimestamp);
   frame_count_ += frame_count;
+
+  // Batched fixed point accumulation: add the whole-tick part of the
+  // increment directly and fold the fractional part into |remainder_|.
+  // |whole_seconds| worth of frames contribute exactly |ticks_remainder_|
+  // ticks each second, which keeps the remainder product small enough to
+  // never overflow.
+  const int64_t whole_seconds = frame_count / samples_per_second_;
+  const int64_t rest_frames = frame_count % samples_per_second_;
+  accumulated_ticks_ +=
+      frame_count * ticks_per_frame_ + whole_seconds * ticks_remainder_;
+  remainder_ += rest_frames * ticks_remainder_;
+  accumulated_ticks_ += remainder_ / samples_per_second_;
+  remainder_ %= samples_per_second_;
 }
 
 int64_t AudioTimestampHelper::GetTimestamp() const {
-  return ComputeTimestamp(frame_count_);
+  DCHECK(base_timestamp_ != kNoTimestamp);
+  return base_timestamp_ + accumulated_ticks_;
 }
 
 int64_t AudioTimestampHelper::GetFrameDuration(int64_t frame_count) const {
@@ -58,17 +79,22 @@ int64_t AudioTimestampHelper::GetFramesToTarget(int64_t target) const {
   int64_t delta_from_base = target - base_timestamp_;
 
   // Compute frame count for the time delta. This computation rounds to
-  // the nearest whole number of frames.
-  double threshold = ticks_per_frame_ / 2;
-  int64_t target_frame_count = (delta_from_base + threshold) / ticks_per_frame_;
+  // the nearest whole number of frames. The arithmetic is the integer form
+  // of (delta_from_base + ticks_per_frame / 2) / ticks_per_frame.
+  int64_t target_frame_count =
+      (delta_from_base * samples_per_second_ + timescale_ / 2) / timescale_;
   return target_frame_count - frame_count_;
 }
 
 int64_t AudioTimestampHelper::ComputeTimestamp(int64_t frame_count) const {
   DCHECK_GE(frame_count, 0);
   DCHECK(base_timestamp_ != kNoTimestamp);
-  double frames_ticks = ticks_per_frame_ * frame_count;
-  return base_timestamp_ + frames_ticks;
+  // Exact rational conversion, rounded down, split to avoid overflow of
+  // frame_count * timescale for long streams.
+  const int64_t whole_seconds = frame_count / samples_per_second_;
+  const int64_t rest_frames = frame_count % samples_per_second_;
+  return base_timestamp_ + whole_seconds * timescale_ +
+         rest_frames * timescale_ / samples_per_second_;
 }
 
 }  // namespace media
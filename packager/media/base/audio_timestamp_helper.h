@@ -60,13 +60,28 @@ class AudioTimestampHelper {
  private:
   int64_t ComputeTimestamp(int64_t frame_count) const;
 
-  double ticks_per_frame_;
+  uint32_t timescale_;
+  uint32_t samples_per_second_;
+
+  // Precomputed per-frame increment: one frame advances the timestamp by
+  // |ticks_per_frame_| whole ticks plus |ticks_remainder_| /
+  // |samples_per_second_| of a tick.
+  int64_t ticks_per_frame_;
+  int64_t ticks_remainder_;
 
   int64_t base_timestamp_;
 
   // Number of frames accumulated by AddFrames() calls.
   int64_t frame_count_;
 
+  // Whole ticks accumulated for |frame_count_| frames, and the exact
+  // fractional remainder in units of 1 / |samples_per_second_| of a tick.
+  // Keeping the remainder makes batched accumulation drift-free: the total
+  // always equals the rational value frame_count_ * timescale /
+  // samples_per_second, rounded down.
+  int64_t accumulated_ticks_;
+  int64_t remainder_;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(AudioTimestampHelper);
 };
 
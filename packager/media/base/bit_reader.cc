@@ -6,6 +6,13 @@
 
 #include <algorithm>
 
+namespace {
+
+// Width of the bit cache, in bits.
+const int kCacheWidthInBits = 64;
+
+}  // namespace
+
 namespace shaka {
 namespace media {
 
@@ -13,10 +20,11 @@ BitReader::BitReader(const uint8_t* data, off_t size)
     : data_(data),
       initial_size_(size),
       bytes_left_(size),
-      num_remaining_bits_in_curr_byte_(0) {
+      curr_cache_(0),
+      num_remaining_bits_in_curr_cache_(0) {
   DCHECK(data_ != NULL && bytes_left_ > 0);
 
-  UpdateCurrByte();
+  Refill();
 }
 
 BitReader::~BitReader() {}
@@ -24,28 +32,33 @@ BitReader::~BitReader() {}
 bool BitReader::SkipBits(int num_bits) {
   DCHECK_GE(num_bits, 0);
 
-  // Skip any bits in the current byte waiting to be processed, then
-  // process full bytes until less than 8 bits remaining.
-  if (num_bits > num_remaining_bits_in_curr_byte_) {
-    num_bits -= num_remaining_bits_in_curr_byte_;
-    num_remaining_bits_in_curr_byte_ = 0;
-
-    int num_bytes = num_bits / 8;
-    num_bits %= 8;
-    if (bytes_left_ < num_bytes) {
-      bytes_left_ = 0;
-      return false;
+  if (num_bits <= num_remaining_bits_in_curr_cache_) {
+    // Fast path: the skipped bits are all in the cache. The double shift
+    // keeps the shift count below 64; shifting a 64-bit value by 64 is
+    // undefined.
+    if (num_bits > 0) {
+      curr_cache_ <<= num_bits - 1;
+      curr_cache_ <<= 1;
+      num_remaining_bits_in_curr_cache_ -= num_bits;
     }
-    bytes_left_ -= num_bytes;
-    data_ += num_bytes;
-    UpdateCurrByte();
-
-    // If there is no more data remaining, only return true if we
-    // skipped all that were requested.
-    if (num_remaining_bits_in_curr_byte_ == 0)
-      return (num_bits == 0);
+    return true;
   }
 
+  num_bits -= num_remaining_bits_in_curr_cache_;
+  num_remaining_bits_in_curr_cache_ = 0;
+  curr_cache_ = 0;
+
+  // Skip whole bytes by advancing the stream pointer, without loading the
+  // skipped bytes into the cache.
+  const off_t num_bytes = num_bits / 8;
+  num_bits %= 8;
+  if (num_bytes > bytes_left_) {
+    bytes_left_ = 0;
+    return false;
+  }
+  data_ += num_bytes;
+  bytes_left_ -= num_bytes;
+
   // Less than 8 bits remaining to skip. Use ReadBitsInternal to verify
   // that the remaining bits we need exist, and adjust them as necessary
   // for subsequent operations.
@@ -54,52 +67,80 @@ bool BitReader::SkipBits(int num_bits) {
 }
 
 bool BitReader::SkipBytes(int num_bytes) {
-  if (num_remaining_bits_in_curr_byte_ != 8)
-    return false;
-  if (num_bytes == 0)
-    return true;
+  DCHECK_GE(num_bytes, 0);
 
-  data_ += num_bytes - 1;  // One additional byte in curr_byte_.
-  if (num_bytes > bytes_left_ + 1)
+  if (num_remaining_bits_in_curr_cache_ % 8 != 0)
     return false;
-  bytes_left_ -= num_bytes - 1;
-  num_remaining_bits_in_curr_byte_ = 0;
-  UpdateCurrByte();
-  return true;
+  return SkipBits(num_bytes * 8);
 }
 
 bool BitReader::ReadBitsInternal(int num_bits, uint64_t* out) {
-  DCHECK_LE(num_bits, 64);
+  DCHECK_LE(num_bits, kCacheWidthInBits);
 
   *out = 0;
+  if (num_bits == 0)
+    return true;
 
-  while (num_remaining_bits_in_curr_byte_ != 0 && num_bits != 0) {
-    int bits_to_take = std::min(num_remaining_bits_in_curr_byte_, num_bits);
-
-    *out <<= bits_to_take;
-    *out += curr_byte_ >> (num_remaining_bits_in_curr_byte_ - bits_to_take);
-    num_bits -= bits_to_take;
-    num_remaining_bits_in_curr_byte_ -= bits_to_take;
-    curr_byte_ &= (1 << num_remaining_bits_in_curr_byte_) - 1;
+  if (num_bits <= num_remaining_bits_in_curr_cache_) {
+    // Fast path: the read is served entirely from the cache. See SkipBits
+    // for why the shifts are doubled.
+    *out = curr_cache_ >> (kCacheWidthInBits - num_bits);
+    curr_cache_ <<= num_bits - 1;
+    curr_cache_ <<= 1;
+    num_remaining_bits_in_curr_cache_ -= num_bits;
+    return true;
+  }
 
-    if (num_remaining_bits_in_curr_byte_ == 0)
-      UpdateCurrByte();
+  if (num_bits > bits_available()) {
+    // Not enough bits in the stream. Consume what is left so that further
+    // operations keep failing, per the API contract.
+    num_remaining_bits_in_curr_cache_ = 0;
+    curr_cache_ = 0;
+    bytes_left_ = 0;
+    return false;
   }
 
-  return num_bits == 0;
+  // Take what is left in the cache, refill it and take the rest from the
+  // new cache contents. At most one refill is needed since the cache holds
+  // up to 64 bits and |num_bits| cannot exceed 64.
+  uint64_t value = 0;
+  if (num_remaining_bits_in_curr_cache_ > 0) {
+    value = curr_cache_ >>
+            (kCacheWidthInBits - num_remaining_bits_in_curr_cache_);
+    num_bits -= num_remaining_bits_in_curr_cache_;
+    num_remaining_bits_in_curr_cache_ = 0;
+  }
+  Refill();
+  DCHECK_LE(num_bits, num_remaining_bits_in_curr_cache_);
+
+  value <<= num_bits - 1;
+  value <<= 1;
+  value |= curr_cache_ >> (kCacheWidthInBits - num_bits);
+  curr_cache_ <<= num_bits - 1;
+  curr_cache_ <<= 1;
+  num_remaining_bits_in_curr_cache_ -= num_bits;
+  *out = value;
+  return true;
 }
 
-void BitReader::UpdateCurrByte() {
-  DCHECK_EQ(num_remaining_bits_in_curr_byte_, 0);
+void BitReader::Refill() {
+  DCHECK_EQ(num_remaining_bits_in_curr_cache_, 0);
 
-  if (bytes_left_ == 0)
+  const int num_bytes = static_cast<int>(
+      std::min<off_t>(static_cast<off_t>(sizeof(curr_cache_)), bytes_left_));
+  if (num_bytes == 0)
     return;
 
-  // Load a new byte and advance pointers.
-  curr_byte_ = *data_;
-  ++data_;
-  --bytes_left_;
-  num_remaining_bits_in_curr_byte_ = 8;
+  // Load the bytes big endian and left align them in the cache. The byte
+  // loop compiles down to a word load plus byte swap on full refills.
+  uint64_t cache = 0;
+  for (int i = 0; i < num_bytes; ++i)
+    cache = (cache << 8) | data_[i];
+  curr_cache_ = cache << (8 * (sizeof(curr_cache_) - num_bytes));
+
+  data_ += num_bytes;
+  bytes_left_ -= num_bytes;
+  num_remaining_bits_in_curr_cache_ = 8 * num_bytes;
 }
 
 }  // namespace media
@@ -74,7 +74,7 @@ class BitReader {
 
   /// @return The number of bits available for reading.
   int bits_available() const {
-    return 8 * bytes_left_ + num_remaining_bits_in_curr_byte_;
+    return 8 * bytes_left_ + num_remaining_bits_in_curr_cache_;
   }
 
   /// @return The current bit position.
@@ -84,27 +84,27 @@ class BitReader {
   // Help function used by ReadBits to avoid inlining the bit reading logic.
   bool ReadBitsInternal(int num_bits, uint64_t* out);
 
-  // Advance to the next byte, loading it into curr_byte_.
-  // If the num_remaining_bits_in_curr_byte_ is 0 after this function returns,
-  // the stream has reached the end.
-  void UpdateCurrByte();
+  // Load up to 8 bytes from the stream into curr_cache_. If
+  // num_remaining_bits_in_curr_cache_ is 0 after this function returns, the
+  // stream has reached the end.
+  void Refill();
 
-  // Pointer to the next unread (not in curr_byte_) byte in the stream.
+  // Pointer to the next unread (not in curr_cache_) byte in the stream.
   const uint8_t* data_;
 
   // Initial size of the input data.
   // TODO(kqyang): Use size_t instead of off_t instead.
   off_t initial_size_;
 
-  // Bytes left in the stream (without the curr_byte_).
+  // Bytes left in the stream (without the curr_cache_).
   off_t bytes_left_;
 
-  // Contents of the current byte; first unread bit starting at position
-  // 8 - num_remaining_bits_in_curr_byte_ from MSB.
-  uint8_t curr_byte_;
+  // Cache of up to 8 bytes of stream contents, left aligned: the next unread
+  // bit is the most significant bit of curr_cache_.
+  uint64_t curr_cache_;
 
-  // Number of bits remaining in curr_byte_
-  int num_remaining_bits_in_curr_byte_;
+  // Number of bits remaining in curr_cache_.
+  int num_remaining_bits_in_curr_cache_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BitReader);
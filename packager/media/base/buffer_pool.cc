@@ -0,0 +1,116 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/buffer_pool.h"
+
+#include "packager/base/logging.h"
+#include "packager/base/stl_util.h"
+
+namespace {
+// Smallest size class. Requests below this are rounded up; pooling tiny
+// buffers separately is not worth the extra classes.
+const size_t kMinClassSize = 1024u;
+}  // namespace
+
+namespace shaka {
+namespace media {
+
+BufferPool::Stats::Stats()
+    : hits(0),
+      misses(0),
+      returns(0),
+      discards(0),
+      buffers_pooled(0),
+      bytes_pooled(0) {}
+
+BufferPool::BufferPool(size_t max_buffers_per_class, size_t max_buffer_size)
+    : max_buffers_per_class_(max_buffers_per_class),
+      max_buffer_size_(max_buffer_size) {
+  DCHECK_GT(max_buffers_per_class, 0u);
+  DCHECK_GE(max_buffer_size, kMinClassSize);
+  for (size_t class_size = kMinClassSize; class_size <= max_buffer_size_;
+       class_size *= 2) {
+    class_sizes_.push_back(class_size);
+  }
+  free_buffers_.resize(class_sizes_.size());
+}
+
+BufferPool::~BufferPool() {
+  base::AutoLock auto_lock(lock_);
+  for (size_t i = 0; i < free_buffers_.size(); ++i)
+    STLDeleteElements(&free_buffers_[i]);
+}
+
+void BufferPool::Allocate(size_t size, std::vector<uint8_t>* buffer) {
+  DCHECK(buffer);
+  const size_t class_index = ClassForAllocation(size);
+  if (class_index < class_sizes_.size()) {
+    base::AutoLock auto_lock(lock_);
+    if (!free_buffers_[class_index].empty()) {
+      std::vector<uint8_t>* pooled = free_buffers_[class_index].back();
+      free_buffers_[class_index].pop_back();
+      ++stats_.hits;
+      --stats_.buffers_pooled;
+      stats_.bytes_pooled -= pooled->capacity();
+      buffer->swap(*pooled);
+      delete pooled;
+      buffer->resize(size);
+      return;
+    }
+    ++stats_.misses;
+  } else {
+    base::AutoLock auto_lock(lock_);
+    ++stats_.misses;
+  }
+
+  buffer->clear();
+  if (class_index < class_sizes_.size())
+    buffer->reserve(class_sizes_[class_index]);
+  buffer->resize(size);
+}
+
+void BufferPool::Release(std::vector<uint8_t>* buffer) {
+  DCHECK(buffer);
+  const size_t class_index = ClassForRelease(buffer->capacity());
+  base::AutoLock auto_lock(lock_);
+  ++stats_.returns;
+  if (class_index >= class_sizes_.size() ||
+      free_buffers_[class_index].size() >= max_buffers_per_class_) {
+    ++stats_.discards;
+    std::vector<uint8_t>().swap(*buffer);
+    return;
+  }
+  std::vector<uint8_t>* pooled = new std::vector<uint8_t>();
+  pooled->swap(*buffer);
+  pooled->clear();
+  ++stats_.buffers_pooled;
+  stats_.bytes_pooled += pooled->capacity();
+  free_buffers_[class_index].push_back(pooled);
+}
+
+BufferPool::Stats BufferPool::GetStats() const {
+  base::AutoLock auto_lock(lock_);
+  return stats_;
+}
+
+size_t BufferPool::ClassForAllocation(size_t size) const {
+  for (size_t i = 0; i < class_sizes_.size(); ++i) {
+    if (class_sizes_[i] >= size)
+      return i;
+  }
+  return class_sizes_.size();
+}
+
+size_t BufferPool::ClassForRelease(size_t capacity) const {
+  for (size_t i = class_sizes_.size(); i > 0; --i) {
+    if (class_sizes_[i - 1] <= capacity)
+      return i - 1;
+  }
+  return class_sizes_.size();
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,86 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_BUFFER_POOL_H_
+#define MEDIA_BASE_BUFFER_POOL_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+namespace media {
+
+/// Thread safe pool of sample payload buffers, bucketed by power-of-two size
+/// class. High frame rate jobs allocate and free a payload vector for every
+/// sample; drawing the vectors from a pool avoids the per-sample heap
+/// round-trips. Install a pool with MediaSample::set_buffer_pool before
+/// starting the pipeline; use GetStats to size the pool per deployment.
+class BufferPool {
+ public:
+  /// Usage counters. All counters are cumulative except @a buffers_pooled
+  /// and @a bytes_pooled, which reflect the current pool contents.
+  struct Stats {
+    Stats();
+
+    uint64_t hits;       // Allocations served from the pool.
+    uint64_t misses;     // Allocations that fell through to the heap.
+    uint64_t returns;    // Buffers returned to the pool.
+    uint64_t discards;   // Returned buffers dropped because a class was full.
+    size_t buffers_pooled;
+    size_t bytes_pooled;
+  };
+
+  /// @param max_buffers_per_class is the maximum number of free buffers kept
+  ///        per size class; returns beyond this are released to the heap.
+  /// @param max_buffer_size is the largest payload size served from the pool.
+  ///        Larger requests always fall through to the heap.
+  BufferPool(size_t max_buffers_per_class, size_t max_buffer_size);
+  ~BufferPool();
+
+  /// Fill @a buffer with a zeroed-length buffer of capacity at least @a size,
+  /// drawn from the pool if possible. The previous contents of @a buffer are
+  /// released to the heap.
+  /// @param size is the requested capacity in bytes.
+  /// @param[out] buffer receives the buffer, resized to @a size.
+  void Allocate(size_t size, std::vector<uint8_t>* buffer);
+
+  /// Return the contents of @a buffer to the pool. @a buffer is emptied by
+  /// this call. Buffers that do not fit any size class, or whose class is
+  /// full, are released to the heap instead.
+  void Release(std::vector<uint8_t>* buffer);
+
+  /// @return A snapshot of the pool usage counters.
+  Stats GetStats() const;
+
+ private:
+  // Index of the smallest size class with size >= |size|, or the number of
+  // classes if |size| exceeds |max_buffer_size_|.
+  size_t ClassForAllocation(size_t size) const;
+  // Index of the largest size class with size <= |capacity|, or the number of
+  // classes if |capacity| is smaller than the smallest class.
+  size_t ClassForRelease(size_t capacity) const;
+
+  const size_t max_buffers_per_class_;
+  const size_t max_buffer_size_;
+  // Size in bytes of each size class, in increasing order.
+  std::vector<size_t> class_sizes_;
+
+  mutable base::Lock lock_;
+  // Free buffers per size class, protected by |lock_|.
+  std::vector<std::vector<std::vector<uint8_t>*> > free_buffers_;
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_BUFFER_POOL_H_
@@ -0,0 +1,66 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/media/base/buffer_pool.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+const size_t kMaxBuffersPerClass = 2u;
+const size_t kMaxBufferSize = 4096u;
+}  // namespace
+
+TEST(BufferPoolTest, AllocateMissThenHit) {
+  BufferPool pool(kMaxBuffersPerClass, kMaxBufferSize);
+
+  std::vector<uint8_t> buffer;
+  pool.Allocate(100, &buffer);
+  EXPECT_EQ(100u, buffer.size());
+  EXPECT_EQ(1u, pool.GetStats().misses);
+
+  pool.Release(&buffer);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(1u, pool.GetStats().buffers_pooled);
+
+  pool.Allocate(200, &buffer);
+  EXPECT_EQ(200u, buffer.size());
+  EXPECT_EQ(1u, pool.GetStats().hits);
+  EXPECT_EQ(0u, pool.GetStats().buffers_pooled);
+}
+
+TEST(BufferPoolTest, OversizedRequestFallsThrough) {
+  BufferPool pool(kMaxBuffersPerClass, kMaxBufferSize);
+
+  std::vector<uint8_t> buffer;
+  pool.Allocate(kMaxBufferSize + 1, &buffer);
+  EXPECT_EQ(kMaxBufferSize + 1, buffer.size());
+  EXPECT_EQ(1u, pool.GetStats().misses);
+
+  pool.Release(&buffer);
+  // The buffer is too large for any size class and must not be pooled.
+  EXPECT_EQ(1u, pool.GetStats().discards);
+  EXPECT_EQ(0u, pool.GetStats().buffers_pooled);
+}
+
+TEST(BufferPoolTest, FullClassDiscardsReturns) {
+  BufferPool pool(kMaxBuffersPerClass, kMaxBufferSize);
+
+  std::vector<std::vector<uint8_t> > buffers(kMaxBuffersPerClass + 1);
+  for (size_t i = 0; i < buffers.size(); ++i)
+    pool.Allocate(100, &buffers[i]);
+  for (size_t i = 0; i < buffers.size(); ++i)
+    pool.Release(&buffers[i]);
+
+  BufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(kMaxBuffersPerClass, stats.buffers_pooled);
+  EXPECT_EQ(1u, stats.discards);
+}
+
+}  // namespace media
+}  // namespace shaka
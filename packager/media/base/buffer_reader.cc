@@ -6,11 +6,33 @@
 
 #include "packager/media/base/buffer_reader.h"
 
+#include <string.h>
+
 #include "packager/base/logging.h"
+#include "packager/base/sys_byteorder.h"
 
 namespace shaka {
 namespace media {
 
+namespace {
+
+// Overloads mapping each integer width to the matching byte swap, so the
+// templated read below picks the right one at compile time.
+inline uint16_t NetToHost(uint16_t v) { return base::NetToHost16(v); }
+inline uint32_t NetToHost(uint32_t v) { return base::NetToHost32(v); }
+inline uint64_t NetToHost(uint64_t v) { return base::NetToHost64(v); }
+inline int16_t NetToHost(int16_t v) {
+  return static_cast<int16_t>(base::NetToHost16(static_cast<uint16_t>(v)));
+}
+inline int32_t NetToHost(int32_t v) {
+  return static_cast<int32_t>(base::NetToHost32(static_cast<uint32_t>(v)));
+}
+inline int64_t NetToHost(int64_t v) {
+  return static_cast<int64_t>(base::NetToHost64(static_cast<uint64_t>(v)));
+}
+
+}  // namespace
+
 bool BufferReader::Read1(uint8_t* v) {
   DCHECK(v != NULL);
   if (!HasBytes(1))
@@ -69,9 +91,41 @@ bool BufferReader::SkipBytes(size_t num_bytes) {
   return true;
 }
 
+bool BufferReader::ReadToVector4(std::vector<uint32_t>* vec, size_t count) {
+  return ReadArray(vec, count);
+}
+bool BufferReader::ReadToVector8(std::vector<uint64_t>* vec, size_t count) {
+  return ReadArray(vec, count);
+}
+
 template <typename T>
 bool BufferReader::Read(T* v) {
-  return ReadNBytes(v, sizeof(*v));
+  DCHECK(v != NULL);
+  if (!HasBytes(sizeof(*v)))
+    return false;
+  // Unaligned load plus byte swap; compiles to a single wide load and bswap
+  // instead of a per-byte assembly loop.
+  T tmp;
+  memcpy(&tmp, buf_ + pos_, sizeof(tmp));
+  pos_ += sizeof(tmp);
+  *v = NetToHost(tmp);
+  return true;
+}
+
+template <typename T>
+bool BufferReader::ReadArray(std::vector<T>* vec, size_t count) {
+  DCHECK(vec != NULL);
+  // Division avoids overflow of count * sizeof(T) for hostile counts.
+  if (count > (size_ - pos_) / sizeof(T))
+    return false;
+  vec->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    T tmp;
+    memcpy(&tmp, buf_ + pos_, sizeof(tmp));
+    pos_ += sizeof(tmp);
+    (*vec)[i] = NetToHost(tmp);
+  }
+  return true;
 }
 
 template <typename T>
@@ -56,6 +56,20 @@ class BufferReader {
   bool ReadToVector(std::vector<uint8_t>* t, size_t count) WARN_UNUSED_RESULT;
   bool ReadToString(std::string* str, size_t size) WARN_UNUSED_RESULT;
 
+  /// Read @a count big endian integers from the stream in one batch,
+  /// performing endian correction, and advance the stream pointer. Intended
+  /// for box payloads that are plain integer arrays (e.g. chunk offsets,
+  /// sync sample numbers), which would otherwise be read one field at a
+  /// time.
+  /// @return false if there are not enough bytes in the buffer; the stream
+  ///         position is unchanged in that case.
+  /// @{
+  bool ReadToVector4(std::vector<uint32_t>* vec,
+                     size_t count) WARN_UNUSED_RESULT;
+  bool ReadToVector8(std::vector<uint64_t>* vec,
+                     size_t count) WARN_UNUSED_RESULT;
+  /// @}
+
   /// Advance the stream by this many bytes.
   /// @return false if there are not enough bytes in the buffer, true otherwise.
   bool SkipBytes(size_t num_bytes) WARN_UNUSED_RESULT;
@@ -71,6 +85,8 @@ class BufferReader {
   bool Read(T* t) WARN_UNUSED_RESULT;
   template <typename T>
   bool ReadNBytes(T* t, size_t num_bytes) WARN_UNUSED_RESULT;
+  template <typename T>
+  bool ReadArray(std::vector<T>* vec, size_t count) WARN_UNUSED_RESULT;
 
   const uint8_t* buf_;
   size_t size_;
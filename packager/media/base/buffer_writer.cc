@@ -16,14 +16,17 @@ namespace media {
 BufferWriter::BufferWriter() {
   const size_t kDefaultReservedCapacity = 0x40000;  // 256KB.
   buf_.reserve(kDefaultReservedCapacity);
+  UpdateCharge();
 }
 BufferWriter::BufferWriter(size_t reserved_size_in_bytes) {
   buf_.reserve(reserved_size_in_bytes);
+  UpdateCharge();
 }
 BufferWriter::~BufferWriter() {}
 
 void BufferWriter::AppendInt(uint8_t v) {
   buf_.push_back(v);
+  UpdateCharge();
 }
 void BufferWriter::AppendInt(uint16_t v) {
   AppendInternal(base::HostToNet16(v));
@@ -53,14 +56,17 @@ void BufferWriter::AppendNBytes(uint64_t v, size_t num_bytes) {
 
 void BufferWriter::AppendVector(const std::vector<uint8_t>& v) {
   buf_.insert(buf_.end(), v.begin(), v.end());
+  UpdateCharge();
 }
 
 void BufferWriter::AppendArray(const uint8_t* buf, size_t size) {
   buf_.insert(buf_.end(), buf, buf + size);
+  UpdateCharge();
 }
 
 void BufferWriter::AppendBuffer(const BufferWriter& buffer) {
   buf_.insert(buf_.end(), buffer.buf_.begin(), buffer.buf_.end());
+  UpdateCharge();
 }
 
 Status BufferWriter::WriteToFile(File* file) {
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "packager/base/macros.h"
+#include "packager/media/base/allocation_tracker.h"
 #include "packager/media/base/status.h"
 
 namespace shaka {
@@ -50,11 +51,29 @@ class BufferWriter {
   void AppendArray(const uint8_t* buf, size_t size);
   void AppendBuffer(const BufferWriter& buffer);
 
-  void Swap(BufferWriter* buffer) { buf_.swap(buffer->buf_); }
-  void SwapBuffer(std::vector<uint8_t>* buffer) { buf_.swap(*buffer); }
-
+  void Swap(BufferWriter* buffer) {
+    buf_.swap(buffer->buf_);
+    UpdateCharge();
+    buffer->UpdateCharge();
+  }
+  void SwapBuffer(std::vector<uint8_t>* buffer) {
+    buf_.swap(*buffer);
+    UpdateCharge();
+  }
+
+  /// Clear the buffer contents. The underlying allocation is retained, so a
+  /// cleared BufferWriter can be reused as a scratch buffer without
+  /// reallocating in steady state.
   void Clear() { buf_.clear(); }
+  /// Grow the underlying allocation to hold at least @a capacity bytes
+  /// without further reallocation. Does not change the buffer size.
+  void Reserve(size_t capacity) {
+    buf_.reserve(capacity);
+    UpdateCharge();
+  }
   size_t Size() const { return buf_.size(); }
+  /// @return Number of bytes the buffer can hold without reallocating.
+  size_t Capacity() const { return buf_.capacity(); }
   /// @return Underlying buffer. Behavior is undefined if the buffer size is 0.
   const uint8_t* Buffer() const { return buf_.data(); }
 
@@ -69,7 +88,12 @@ class BufferWriter {
   template <typename T>
   void AppendInternal(T v);
 
+  // Re-attribute the current capacity to the allocation tracker. No-op in
+  // regular builds.
+  void UpdateCharge() { charge_.UpdateTo(buf_.capacity()); }
+
   std::vector<uint8_t> buf_;
+  AllocationTracker::Charge charge_;
 
   DISALLOW_COPY_AND_ASSIGN(BufferWriter);
 };
@@ -110,6 +110,52 @@ TEST_F(BufferWriterTest, AppendVector) {
   ASSERT_EQ(v, data_read);
 }
 
+TEST_F(BufferWriterTest, ReadToTypedVector) {
+  std::vector<uint32_t> values4;
+  values4.push_back(0);
+  values4.push_back(0xDEADBEEF);
+  values4.push_back(std::numeric_limits<uint32_t>::max());
+  for (size_t i = 0; i < values4.size(); ++i)
+    writer_->AppendInt(values4[i]);
+
+  std::vector<uint64_t> values8;
+  values8.push_back(0x0123456789ABCDEFULL);
+  values8.push_back(std::numeric_limits<uint64_t>::max());
+  for (size_t i = 0; i < values8.size(); ++i)
+    writer_->AppendInt(values8[i]);
+
+  CreateReader();
+  std::vector<uint32_t> read4;
+  ASSERT_TRUE(reader_->ReadToVector4(&read4, values4.size()));
+  ASSERT_EQ(values4, read4);
+  std::vector<uint64_t> read8;
+  ASSERT_TRUE(reader_->ReadToVector8(&read8, values8.size()));
+  ASSERT_EQ(values8, read8);
+
+  // Asking for more integers than remain fails and leaves the position
+  // unchanged.
+  const size_t position = reader_->pos();
+  ASSERT_FALSE(reader_->ReadToVector4(&read4, 1));
+  ASSERT_EQ(position, reader_->pos());
+}
+
+TEST_F(BufferWriterTest, ClearRetainsCapacityForReuse) {
+  writer_->AppendArray(kuint8Array, sizeof(kuint8Array));
+  const size_t capacity = writer_->Capacity();
+  ASSERT_GE(capacity, sizeof(kuint8Array));
+
+  writer_->Clear();
+  ASSERT_EQ(0u, writer_->Size());
+  ASSERT_EQ(capacity, writer_->Capacity());
+}
+
+TEST_F(BufferWriterTest, Reserve) {
+  const size_t kReservedCapacity = 0x100000;  // 1MB.
+  writer_->Reserve(kReservedCapacity);
+  ASSERT_EQ(0u, writer_->Size());
+  ASSERT_GE(writer_->Capacity(), kReservedCapacity);
+}
+
 TEST_F(BufferWriterTest, AppendArray) {
   writer_->AppendArray(kuint8Array, sizeof(kuint8Array));
   ASSERT_EQ(sizeof(kuint8Array), writer_->Size());
@@ -4,84 +4,157 @@
 
 #include "packager/media/base/byte_queue.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "packager/base/logging.h"
 
 namespace shaka {
 namespace media {
 
-// Default starting size for the queue.
-enum { kDefaultQueueSize = 1024 };
+namespace {
+
+// Size of each storage chunk. Large enough that typical parser working sets
+// (a few TS packets, a WebM cluster header) fit in the front chunk and are
+// peeked without staging.
+const size_t kChunkSize = 64 * 1024;
+
+}  // namespace
 
 ByteQueue::ByteQueue()
-    : buffer_(new uint8_t[kDefaultQueueSize]),
-      size_(kDefaultQueueSize),
-      offset_(0),
-      used_(0) {
+    : front_offset_(0),
+      write_offset_(0),
+      used_(0),
+      peek_buffer_size_(0),
+      peek_offset_(0),
+      peek_valid_(false) {
+  chunks_.push_back(new uint8_t[kChunkSize]);
+  UpdateCharge();
 }
 
-ByteQueue::~ByteQueue() {}
+ByteQueue::~ByteQueue() {
+  for (size_t i = 0; i < chunks_.size(); ++i)
+    delete[] chunks_[i];
+  for (size_t i = 0; i < free_chunks_.size(); ++i)
+    delete[] free_chunks_[i];
+}
 
 void ByteQueue::Reset() {
-  offset_ = 0;
+  while (chunks_.size() > 1) {
+    RecycleChunk(chunks_.back());
+    chunks_.pop_back();
+  }
+  front_offset_ = 0;
+  write_offset_ = 0;
   used_ = 0;
+  peek_valid_ = false;
 }
 
 void ByteQueue::Push(const uint8_t* data, int size) {
   DCHECK(data);
   DCHECK_GT(size, 0);
 
-  size_t size_needed = used_ + size;
-
-  // Check to see if we need a bigger buffer.
-  if (size_needed > size_) {
-    size_t new_size = 2 * size_;
-    while (size_needed > new_size && new_size > size_)
-      new_size *= 2;
-
-    // Sanity check to make sure we didn't overflow.
-    CHECK_GT(new_size, size_);
-
-    scoped_ptr<uint8_t[]> new_buffer(new uint8_t[new_size]);
-
-    // Copy the data from the old buffer to the start of the new one.
-    if (used_ > 0)
-      memcpy(new_buffer.get(), front(), used_);
-
-    buffer_.reset(new_buffer.release());
-    size_ = new_size;
-    offset_ = 0;
-  } else if ((offset_ + used_ + size) > size_) {
-    // The buffer is big enough, but we need to move the data in the queue.
-    memmove(buffer_.get(), front(), used_);
-    offset_ = 0;
+  peek_valid_ = false;
+  while (size > 0) {
+    if (write_offset_ == kChunkSize) {
+      chunks_.push_back(AllocateChunk());
+      write_offset_ = 0;
+    }
+    const int copy_size =
+        std::min(size, static_cast<int>(kChunkSize - write_offset_));
+    memcpy(chunks_.back() + write_offset_, data, copy_size);
+    write_offset_ += copy_size;
+    used_ += copy_size;
+    data += copy_size;
+    size -= copy_size;
   }
-
-  memcpy(front() + used_, data, size);
-  used_ += size;
+  UpdateCharge();
 }
 
 void ByteQueue::Peek(const uint8_t** data, int* size) const {
   DCHECK(data);
   DCHECK(size);
-  *data = front();
+
   *size = used_;
+  // Fast path: all queued bytes live in the front chunk.
+  if (chunks_.size() == 1) {
+    *data = chunks_.front() + front_offset_;
+    return;
+  }
+
+  if (!peek_valid_) {
+    if (peek_buffer_size_ < static_cast<size_t>(used_)) {
+      size_t new_size = peek_buffer_size_ ? peek_buffer_size_ : kChunkSize;
+      while (new_size < static_cast<size_t>(used_))
+        new_size *= 2;
+      peek_buffer_.reset(new uint8_t[new_size]);
+      peek_buffer_size_ = new_size;
+      UpdateCharge();
+    }
+    // Assemble the cross-chunk bytes into the staging buffer.
+    uint8_t* dest = peek_buffer_.get();
+    size_t offset = front_offset_;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      const size_t chunk_end =
+          (i == chunks_.size() - 1) ? write_offset_ : kChunkSize;
+      memcpy(dest, chunks_[i] + offset, chunk_end - offset);
+      dest += chunk_end - offset;
+      offset = 0;
+    }
+    DCHECK_EQ(used_, dest - peek_buffer_.get());
+    peek_offset_ = 0;
+    peek_valid_ = true;
+  }
+  *data = peek_buffer_.get() + peek_offset_;
 }
 
 void ByteQueue::Pop(int count) {
   DCHECK_LE(count, used_);
 
-  offset_ += count;
+  // The staging view stays valid across Pop(): only its start moves.
+  if (peek_valid_)
+    peek_offset_ += count;
   used_ -= count;
 
-  // Move the offset back to 0 if we have reached the end of the buffer.
-  if (offset_ == size_) {
-    DCHECK_EQ(used_, 0);
-    offset_ = 0;
+  while (count > 0) {
+    const size_t front_chunk_end =
+        chunks_.size() == 1 ? write_offset_ : kChunkSize;
+    const int front_chunk_left =
+        static_cast<int>(front_chunk_end - front_offset_);
+    if (count < front_chunk_left) {
+      front_offset_ += count;
+      break;
+    }
+    count -= front_chunk_left;
+    if (chunks_.size() == 1) {
+      // Queue drained; rewind the remaining chunk instead of recycling it.
+      DCHECK_EQ(0, used_);
+      front_offset_ = 0;
+      write_offset_ = 0;
+      break;
+    }
+    RecycleChunk(chunks_.front());
+    chunks_.pop_front();
+    front_offset_ = 0;
   }
 }
 
-uint8_t* ByteQueue::front() const {
-  return buffer_.get() + offset_;
+uint8_t* ByteQueue::AllocateChunk() {
+  if (free_chunks_.empty())
+    return new uint8_t[kChunkSize];
+  uint8_t* chunk = free_chunks_.back();
+  free_chunks_.pop_back();
+  return chunk;
+}
+
+void ByteQueue::RecycleChunk(uint8_t* chunk) {
+  free_chunks_.push_back(chunk);
+}
+
+void ByteQueue::UpdateCharge() const {
+  charge_.UpdateTo((chunks_.size() + free_chunks_.size()) * kChunkSize +
+                   peek_buffer_size_);
 }
 
 }  // namespace media
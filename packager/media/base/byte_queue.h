@@ -7,16 +7,23 @@
 
 #include <stdint.h>
 
+#include <deque>
+#include <vector>
+
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/allocation_tracker.h"
 
 namespace shaka {
 namespace media {
 
 /// Represents a queue of bytes.
 /// Data is added to the end of the queue via an Push() and removed via Pop().
-/// The contents of the queue can be observed via the Peek() method. This class
-/// manages the underlying storage of the queue and tries to minimize the
-/// number of buffer copies when data is appended and removed.
+/// The contents of the queue can be observed via the Peek() method. Storage
+/// is a list of fixed size chunks that are recycled as the queue drains, so
+/// sustained streaming does not regrow or move a large contiguous buffer.
+/// Peek() returns a direct pointer into the front chunk when possible and
+/// falls back to a contiguous staging view when the queued bytes span
+/// chunks.
 class ByteQueue {
  public:
   ByteQueue();
@@ -37,20 +44,41 @@ class ByteQueue {
   void Pop(int count);
 
  private:
-  // Returns a pointer to the front of the queue.
-  uint8_t* front() const;
-
-  scoped_ptr<uint8_t[]> buffer_;
-
-  // Size of |buffer_|.
-  size_t size_;
-
-  // Offset from the start of |buffer_| that marks the front of the queue.
-  size_t offset_;
+  // Return a chunk from the free list, or a newly allocated one if the free
+  // list is empty.
+  uint8_t* AllocateChunk();
+  // Re-attribute the bytes held in chunks and the staging buffer to the
+  // allocation tracker. No-op in regular builds.
+  void UpdateCharge() const;
+  // Put a drained chunk on the free list for reuse by a later Push().
+  void RecycleChunk(uint8_t* chunk);
+
+  // Chunks holding the queued bytes, in queue order. Never empty; bytes
+  // start at |front_offset_| in the front chunk and end at |write_offset_|
+  // in the back chunk.
+  std::deque<uint8_t*> chunks_;
+  std::vector<uint8_t*> free_chunks_;
+
+  // Read position in chunks_.front().
+  size_t front_offset_;
+
+  // Write position in chunks_.back().
+  size_t write_offset_;
 
   // Number of bytes stored in the queue.
   int used_;
 
+  // Staging buffer that materializes a contiguous view for Peek() when the
+  // queued bytes span chunks. Rebuilt lazily after a Push() invalidates it;
+  // Pop() only advances |peek_offset_| so repeated Peek/Pop cycles between
+  // pushes reuse the same staging contents.
+  mutable scoped_ptr<uint8_t[]> peek_buffer_;
+  mutable size_t peek_buffer_size_;
+  mutable size_t peek_offset_;
+  mutable bool peek_valid_;
+
+  mutable AllocationTracker::Charge charge_;
+
   DISALLOW_COPY_AND_ASSIGN(ByteQueue);
 };
 
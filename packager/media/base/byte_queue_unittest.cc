@@ -0,0 +1,127 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "packager/media/base/byte_queue.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+
+// Larger than the internal chunk size (64KB) so pushes span chunks.
+const size_t kLargePushSize = 300 * 1024;
+
+// Fill |buffer| with a pattern that identifies each byte by stream position.
+void FillPattern(size_t start_position, std::vector<uint8_t>* buffer) {
+  for (size_t i = 0; i < buffer->size(); ++i)
+    (*buffer)[i] = static_cast<uint8_t>((start_position + i) * 13 + 7);
+}
+
+// Verify that the first |size| peeked bytes match the pattern starting at
+// |start_position|.
+void ExpectPattern(const ByteQueue& queue,
+                   size_t start_position,
+                   size_t size) {
+  const uint8_t* data = NULL;
+  int queue_size = 0;
+  queue.Peek(&data, &queue_size);
+  ASSERT_LE(size, static_cast<size_t>(queue_size));
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_EQ(static_cast<uint8_t>((start_position + i) * 13 + 7), data[i])
+        << "Mismatch at position " << (start_position + i);
+  }
+}
+
+}  // namespace
+
+TEST(ByteQueueTest, PushPopPeek) {
+  ByteQueue queue;
+  std::vector<uint8_t> buffer(100);
+  FillPattern(0, &buffer);
+  queue.Push(buffer.data(), buffer.size());
+
+  const uint8_t* data = NULL;
+  int size = 0;
+  queue.Peek(&data, &size);
+  EXPECT_EQ(100, size);
+  ExpectPattern(queue, 0, 100);
+
+  queue.Pop(40);
+  queue.Peek(&data, &size);
+  EXPECT_EQ(60, size);
+  ExpectPattern(queue, 40, 60);
+
+  queue.Pop(60);
+  queue.Peek(&data, &size);
+  EXPECT_EQ(0, size);
+}
+
+TEST(ByteQueueTest, CrossChunkPeek) {
+  ByteQueue queue;
+  std::vector<uint8_t> buffer(kLargePushSize);
+  FillPattern(0, &buffer);
+  queue.Push(buffer.data(), buffer.size());
+
+  // The push spans several chunks; the peeked view must still be contiguous
+  // and ordered.
+  ExpectPattern(queue, 0, kLargePushSize);
+
+  // Pops between peeks advance the view without invalidating it.
+  size_t position = 0;
+  const size_t kPopSize = 10000;
+  while (position + kPopSize < kLargePushSize) {
+    queue.Pop(kPopSize);
+    position += kPopSize;
+    ExpectPattern(queue, position, kLargePushSize - position);
+  }
+}
+
+TEST(ByteQueueTest, SustainedPushPop) {
+  ByteQueue queue;
+  // Interleave pushes and pops with a bounded backlog, as a streaming parser
+  // does, so drained chunks are recycled for later pushes.
+  const size_t kPushSize = 50000;
+  const size_t kPopSize = 47000;
+  size_t write_position = 0;
+  size_t read_position = 0;
+  std::vector<uint8_t> buffer(kPushSize);
+  for (int i = 0; i < 100; ++i) {
+    FillPattern(write_position, &buffer);
+    queue.Push(buffer.data(), buffer.size());
+    write_position += kPushSize;
+    ExpectPattern(queue, read_position, write_position - read_position);
+    queue.Pop(kPopSize);
+    read_position += kPopSize;
+    ExpectPattern(queue, read_position, write_position - read_position);
+  }
+}
+
+TEST(ByteQueueTest, Reset) {
+  ByteQueue queue;
+  std::vector<uint8_t> buffer(kLargePushSize);
+  FillPattern(0, &buffer);
+  queue.Push(buffer.data(), buffer.size());
+  queue.Pop(100);
+
+  queue.Reset();
+  const uint8_t* data = NULL;
+  int size = 0;
+  queue.Peek(&data, &size);
+  EXPECT_EQ(0, size);
+
+  // The queue is usable again after Reset().
+  FillPattern(0, &buffer);
+  queue.Push(buffer.data(), buffer.size());
+  ExpectPattern(queue, 0, kLargePushSize);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,66 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/cipher_engine.h"
+
+#include <gflags/gflags.h>
+
+#include "packager/base/logging.h"
+
+DEFINE_string(cipher_engine,
+              "builtin",
+              "Cipher engine used for sample encryption. 'builtin' uses the "
+              "bundled OpenSSL-based cryptors, which already dispatch to "
+              "hardware AES instructions where the CPU provides them. "
+              "Additional engines can be registered for dedicated crypto "
+              "offload hardware.");
+
+namespace shaka {
+namespace media {
+namespace {
+
+// The default engine: the bundled OpenSSL-based cryptors. Hardware AES
+// instructions are used through the library's runtime CPU dispatch.
+class BuiltinCipherEngine : public CipherEngine {
+ public:
+  BuiltinCipherEngine() {}
+  ~BuiltinCipherEngine() override {}
+
+  scoped_ptr<AesCryptor> CreateCtrEncryptor() override {
+    return scoped_ptr<AesCryptor>(new AesCtrEncryptor);
+  }
+
+  scoped_ptr<AesCryptor> CreateCbcEncryptor(
+      CbcPaddingScheme padding_scheme,
+      AesCryptor::ConstantIvFlag constant_iv_flag) override {
+    return scoped_ptr<AesCryptor>(
+        new AesCbcEncryptor(padding_scheme, constant_iv_flag));
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BuiltinCipherEngine);
+};
+
+CipherEngine* CreateEngine() {
+  if (FLAGS_cipher_engine != "builtin") {
+    LOG(WARNING) << "Unknown cipher engine '" << FLAGS_cipher_engine
+                 << "'; using the built-in engine.";
+  }
+  return new BuiltinCipherEngine;
+}
+
+}  // namespace
+
+CipherEngine::~CipherEngine() {}
+
+CipherEngine* CipherEngine::GetInstance() {
+  // Deliberately leaked: the engine lives for the whole process.
+  static CipherEngine* engine = CreateEngine();
+  return engine;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,45 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_CIPHER_ENGINE_H_
+#define MEDIA_BASE_CIPHER_ENGINE_H_
+
+#include "packager/base/macros.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/aes_cryptor.h"
+#include "packager/media/base/aes_encryptor.h"
+
+namespace shaka {
+namespace media {
+
+/// CipherEngine creates the cryptors that perform the actual cipher work.
+/// Muxers and fragmenters go through the engine instead of instantiating
+/// cryptors directly, so an alternative implementation — for example one
+/// backed by hardware crypto offload — can be slotted in per job via
+/// --cipher_engine without touching any fragmenter code.
+class CipherEngine {
+ public:
+  virtual ~CipherEngine();
+
+  /// @return A new AES-CTR encryptor, not yet initialized with a key.
+  virtual scoped_ptr<AesCryptor> CreateCtrEncryptor() = 0;
+
+  /// @param padding_scheme indicates the padding scheme used.
+  /// @param constant_iv_flag indicates whether a constant iv is used.
+  /// @return A new AES-CBC encryptor, not yet initialized with a key.
+  virtual scoped_ptr<AesCryptor> CreateCbcEncryptor(
+      CbcPaddingScheme padding_scheme,
+      AesCryptor::ConstantIvFlag constant_iv_flag) = 0;
+
+  /// @return The engine selected by --cipher_engine. Never NULL; an unknown
+  ///         engine name falls back to the built-in engine with a warning.
+  static CipherEngine* GetInstance();
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_CIPHER_ENGINE_H_
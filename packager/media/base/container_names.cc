@@ -950,6 +950,32 @@ static bool CheckMpeg4BitStream(const uint8_t* buffer, int buffer_size) {
 }
 
 // Additional checks for a MOV/QuickTime/MPEG4 container.
+// Returns true if |atomtype| is a box that is valid at the top level of an
+// iso-bmff file.
+static bool IsMovTopLevelBox(uint32_t atomtype) {
+  switch (atomtype) {
+    case TAG('f','t','y','p'):
+    case TAG('p','d','i','n'):
+    case TAG('b','l','o','c'):
+    case TAG('m','o','o','v'):
+    case TAG('m','o','o','f'):
+    case TAG('m','f','r','a'):
+    case TAG('m','d','a','t'):
+    case TAG('f','r','e','e'):
+    case TAG('s','k','i','p'):
+    case TAG('m','e','t','a'):
+    case TAG('m','e','c','o'):
+    case TAG('s','t','y','p'):
+    case TAG('s','i','d','x'):
+    case TAG('s','s','i','x'):
+    case TAG('p','r','f','t'):
+    case TAG('u','u','i','d'):
+      return true;
+    default:
+      return false;
+  }
+}
+
 static bool CheckMov(const uint8_t* buffer, int buffer_size) {
   // Reference: ISO/IEC 14496-12:2005(E).
   // (http://standards.iso.org/ittf/PubliclyAvailableStandards/c061988_ISO_IEC_14496-12_2012.zip)
@@ -961,33 +987,13 @@ static bool CheckMov(const uint8_t* buffer, int buffer_size) {
     int atomsize = Read32(buffer + offset);
     uint32_t atomtype = Read32(buffer + offset + 4);
     // Only need to check for ones that are valid at the top level.
-    switch (atomtype) {
-      case TAG('f','t','y','p'):
-      case TAG('p','d','i','n'):
-      case TAG('b','l','o','c'):
-      case TAG('m','o','o','v'):
-      case TAG('m','o','o','f'):
-      case TAG('m','f','r','a'):
-      case TAG('m','d','a','t'):
-      case TAG('f','r','e','e'):
-      case TAG('s','k','i','p'):
-      case TAG('m','e','t','a'):
-      case TAG('m','e','c','o'):
-      case TAG('s','t','y','p'):
-      case TAG('s','i','d','x'):
-      case TAG('s','s','i','x'):
-      case TAG('p','r','f','t'):
-      case TAG('u','u','i','d'):
-        // Assumes that it is an iso-bmff file after seeing two known boxes.
-        // Note that it is correct only for our use cases as we support only
-        // a limited number of containers, and there is no other container
-        // has this behavior.
-        if (++boxes_seen >= 2)
-          return true;
-        break;
-      default:
-        // Ignore unrecognized box.
-        break;
+    if (IsMovTopLevelBox(atomtype)) {
+      // Assumes that it is an iso-bmff file after seeing two known boxes.
+      // Note that it is correct only for our use cases as we support only
+      // a limited number of containers, and there is no other container
+      // has this behavior.
+      if (++boxes_seen >= 2)
+        return true;
     }
     if (atomsize == 1) {
       // Indicates that the length is the next 64bits.
@@ -1668,8 +1674,13 @@ bool CheckTtml(const uint8_t* buffer, int buffer_size) {
 MediaContainerName DetermineContainer(const uint8_t* buffer, int buffer_size) {
   DCHECK(buffer);
 
-  // Since MOV/QuickTime/MPEG4 streams are common, check for them first.
-  if (CheckMov(buffer, buffer_size))
+  // Since MOV/QuickTime/MPEG4 streams are common, check for them first.  The
+  // box walk can cover the whole buffer, so only attempt it up front when the
+  // first box tag already looks like iso-bmff; other inputs retry it below
+  // after the cheap prefix checks have had their chance.
+  const bool has_mov_prefix =
+      buffer_size >= 8 && IsMovTopLevelBox(Read32(buffer + 4));
+  if (has_mov_prefix && CheckMov(buffer, buffer_size))
     return CONTAINER_MOV;
 
   // Next attempt the simple checks, that typically look at just the
@@ -1682,10 +1693,21 @@ MediaContainerName DetermineContainer(const uint8_t* buffer, int buffer_size) {
   if (CheckWebVtt(buffer, buffer_size))
       return CONTAINER_WEBVTT;
 
+  // MPEG2 transport streams are also common and announce themselves with a
+  // sync byte, so confirm them before the generic scans below.
+  const bool has_mpeg2ts_prefix =
+      buffer_size >= 1 && buffer[0] == kMpeg2SyncWord;
+  if (has_mpeg2ts_prefix && CheckMpeg2TransportStream(buffer, buffer_size))
+    return CONTAINER_MPEG2TS;
+
   // Additional checks that may scan a portion of the buffer.
+  if (!has_mov_prefix && CheckMov(buffer, buffer_size))
+    return CONTAINER_MOV;
   if (CheckMpeg2ProgramStream(buffer, buffer_size))
     return CONTAINER_MPEG2PS;
-  if (CheckMpeg2TransportStream(buffer, buffer_size))
+  // Transport streams may hide the sync byte behind a small header, which the
+  // prefix check above misses.
+  if (!has_mpeg2ts_prefix && CheckMpeg2TransportStream(buffer, buffer_size))
     return CONTAINER_MPEG2TS;
   if (CheckMJpeg(buffer, buffer_size))
     return CONTAINER_MJPEG;
@@ -0,0 +1,72 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/crc32.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+
+const uint32_t kCrcPoly = 0x04C11DB7;
+
+// Lookup tables for slice-by-8: table k maps a byte k positions before the
+// end of an 8 byte block to its contribution to the final CRC, so eight
+// table lookups advance the CRC by eight input bytes at once.
+struct Crc32Tables {
+  Crc32Tables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i << 24;
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc & 0x80000000) ? (crc << 1) ^ kCrcPoly : crc << 1;
+      table[0][i] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+      for (uint32_t i = 0; i < 256; ++i)
+        table[k][i] = (table[k - 1][i] << 8) ^ table[0][table[k - 1][i] >> 24];
+    }
+  }
+
+  uint32_t table[8][256];
+};
+
+const Crc32Tables& GetTables() {
+  static const Crc32Tables tables;
+  return tables;
+}
+
+}  // namespace
+
+uint32_t Crc32Mpeg2(const uint8_t* data, size_t size) {
+  return UpdateCrc32Mpeg2(kCrc32Mpeg2InitialValue, data, size);
+}
+
+uint32_t UpdateCrc32Mpeg2(uint32_t crc, const uint8_t* data, size_t size) {
+  const uint32_t(&table)[8][256] = GetTables().table;
+
+  // Process eight bytes per iteration with independent table lookups, which
+  // breaks the one-byte-per-step dependency chain of the classic loop.
+  while (size >= 8) {
+    crc ^= static_cast<uint32_t>(data[0]) << 24 |
+           static_cast<uint32_t>(data[1]) << 16 |
+           static_cast<uint32_t>(data[2]) << 8 | data[3];
+    const uint32_t next = static_cast<uint32_t>(data[4]) << 24 |
+                          static_cast<uint32_t>(data[5]) << 16 |
+                          static_cast<uint32_t>(data[6]) << 8 | data[7];
+    crc = table[7][crc >> 24] ^ table[6][(crc >> 16) & 0xFF] ^
+          table[5][(crc >> 8) & 0xFF] ^ table[4][crc & 0xFF] ^
+          table[3][next >> 24] ^ table[2][(next >> 16) & 0xFF] ^
+          table[1][(next >> 8) & 0xFF] ^ table[0][next & 0xFF];
+    data += 8;
+    size -= 8;
+  }
+  for (size_t i = 0; i < size; ++i)
+    crc = table[0][((crc >> 24) ^ data[i]) & 0xFF] ^ (crc << 8);
+  return crc;
+}
+
+}  // namespace media
+}  // namespace shaka
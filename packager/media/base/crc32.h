@@ -0,0 +1,35 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_CRC32_H_
+#define MEDIA_BASE_CRC32_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace shaka {
+namespace media {
+
+/// Initial value for UpdateCrc32Mpeg2().
+const uint32_t kCrc32Mpeg2InitialValue = 0xFFFFFFFF;
+
+/// Compute the CRC32/MPEG-2 checksum of @a data (polynomial 0x04C11DB7,
+/// MSB first, initial value 0xFFFFFFFF, no final inversion). This is the
+/// checksum carried by PSI sections in MPEG-2 transport streams. Computing
+/// the checksum over a section including its trailing CRC field yields 0.
+uint32_t Crc32Mpeg2(const uint8_t* data, size_t size);
+
+/// Incremental form of Crc32Mpeg2() for checksumming data that arrives in
+/// pieces, e.g. whole-segment checksums accumulated while writing.
+/// @param crc is kCrc32Mpeg2InitialValue for the first piece, thereafter the
+///        return value of the previous call.
+/// @return the checksum of all pieces fed so far.
+uint32_t UpdateCrc32Mpeg2(uint32_t crc, const uint8_t* data, size_t size);
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_CRC32_H_
@@ -0,0 +1,55 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/crc32.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace shaka {
+namespace media {
+
+TEST(Crc32Test, CheckValue) {
+  // CRC32/MPEG-2 check value for "123456789", per the CRC catalogue.
+  const uint8_t kInput[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  EXPECT_EQ(0x0376E6E7u, Crc32Mpeg2(kInput, sizeof(kInput)));
+}
+
+TEST(Crc32Test, EmptyInput) {
+  EXPECT_EQ(kCrc32Mpeg2InitialValue, Crc32Mpeg2(NULL, 0));
+}
+
+TEST(Crc32Test, SectionWithTrailingCrcChecksumsToZero) {
+  // Sized to exercise both the 8 byte blocks and the byte tail.
+  std::vector<uint8_t> section(123);
+  for (size_t i = 0; i < section.size(); ++i)
+    section[i] = static_cast<uint8_t>(i * 7 + 3);
+
+  const uint32_t crc = Crc32Mpeg2(&section[0], section.size());
+  section.push_back(static_cast<uint8_t>(crc >> 24));
+  section.push_back(static_cast<uint8_t>(crc >> 16));
+  section.push_back(static_cast<uint8_t>(crc >> 8));
+  section.push_back(static_cast<uint8_t>(crc));
+  EXPECT_EQ(0u, Crc32Mpeg2(&section[0], section.size()));
+}
+
+TEST(Crc32Test, IncrementalMatchesOneShot) {
+  std::vector<uint8_t> data(1021);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 31 + 11);
+
+  const uint32_t expected = Crc32Mpeg2(&data[0], data.size());
+  // Feed the data in uneven pieces, including ones smaller than a block.
+  uint32_t crc = kCrc32Mpeg2InitialValue;
+  crc = UpdateCrc32Mpeg2(crc, &data[0], 5);
+  crc = UpdateCrc32Mpeg2(crc, &data[5], 700);
+  crc = UpdateCrc32Mpeg2(crc, &data[705], data.size() - 705);
+  EXPECT_EQ(expected, crc);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -19,7 +19,8 @@ DecryptorSource::DecryptorSource(KeySource* key_source)
   CHECK(key_source);
 }
 DecryptorSource::~DecryptorSource() {
-  STLDeleteValues(&decryptor_map_);
+  for (auto& entry : decryptor_pool_)
+    STLDeleteElements(&entry.second);
 }
 
 bool DecryptorSource::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
@@ -28,72 +29,51 @@ bool DecryptorSource::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
   DCHECK(decrypt_config);
   DCHECK(buffer);
 
-  // Get the decryptor object.
-  AesCryptor* decryptor;
-  auto found = decryptor_map_.find(decrypt_config->key_id());
-  if (found == decryptor_map_.end()) {
-    // Create new AesDecryptor based on decryption mode.
-    EncryptionKey key;
-    Status status(key_source_->GetKey(decrypt_config->key_id(), &key));
-    if (!status.ok()) {
-      LOG(ERROR) << "Error retrieving decryption key: " << status;
-      return false;
-    }
+  scoped_ptr<AesCryptor> decryptor = AcquireDecryptor(decrypt_config);
+  if (!decryptor)
+    return false;
+  const bool success = CryptBufferInternal(decryptor.get(), NULL,
+                                           decrypt_config, buffer, buffer_size);
+  ReleaseDecryptor(decrypt_config->key_id(), decryptor.Pass());
+  return success;
+}
 
-    scoped_ptr<AesCryptor> aes_decryptor;
-    switch (decrypt_config->protection_scheme()) {
-      case FOURCC_cenc:
-        aes_decryptor.reset(new AesCtrDecryptor);
-        break;
-      case FOURCC_cbc1:
-        aes_decryptor.reset(new AesCbcDecryptor(kNoPadding));
-        break;
-      case FOURCC_cens:
-        aes_decryptor.reset(new AesPatternCryptor(
-            decrypt_config->crypt_byte_block(),
-            decrypt_config->skip_byte_block(),
-            AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
-            AesCryptor::kDontUseConstantIv,
-            scoped_ptr<AesCryptor>(new AesCtrDecryptor())));
-        break;
-      case FOURCC_cbcs:
-        aes_decryptor.reset(new AesPatternCryptor(
-            decrypt_config->crypt_byte_block(),
-            decrypt_config->skip_byte_block(),
-            AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
-            AesCryptor::kUseConstantIv,
-            scoped_ptr<AesCryptor>(new AesCbcDecryptor(kNoPadding))));
-        break;
-      default:
-        LOG(ERROR) << "Unsupported protection scheme: "
-                   << decrypt_config->protection_scheme();
-        return false;
-    }
+bool DecryptorSource::TransformSampleBuffer(const DecryptConfig* decrypt_config,
+                                            AesCryptor* re_encryptor,
+                                            uint8_t* buffer,
+                                            size_t buffer_size) {
+  DCHECK(decrypt_config);
+  DCHECK(re_encryptor);
+  DCHECK(buffer);
 
-    if (!aes_decryptor->InitializeWithIv(key.key, decrypt_config->iv())) {
-      LOG(ERROR) << "Failed to initialize AesDecryptor for decryption.";
-      return false;
-    }
-    decryptor = aes_decryptor.release();
-    decryptor_map_[decrypt_config->key_id()] = decryptor;
-  } else {
-    decryptor = found->second;
-  }
-  if (!decryptor->SetIv(decrypt_config->iv())) {
-    LOG(ERROR) << "Invalid initialization vector.";
+  scoped_ptr<AesCryptor> decryptor = AcquireDecryptor(decrypt_config);
+  if (!decryptor)
     return false;
-  }
+  const bool success = CryptBufferInternal(decryptor.get(), re_encryptor,
+                                           decrypt_config, buffer, buffer_size);
+  ReleaseDecryptor(decrypt_config->key_id(), decryptor.Pass());
+  return success;
+}
 
+bool DecryptorSource::CryptBufferInternal(AesCryptor* decryptor,
+                                          AesCryptor* re_encryptor,
+                                          const DecryptConfig* decrypt_config,
+                                          uint8_t* buffer,
+                                          size_t buffer_size) {
   if (decrypt_config->subsamples().empty()) {
     // Sample not encrypted using subsample encryption. Decrypt whole.
-    if (!decryptor->Crypt(buffer, buffer_size, buffer)) {
+    if (!decryptor->Crypt(buffer, buffer_size, buffer) ||
+        (re_encryptor &&
+         !re_encryptor->Crypt(buffer, buffer_size, buffer))) {
       LOG(ERROR) << "Error during bulk sample decryption.";
       return false;
     }
     return true;
   }
 
-  // Subsample decryption.
+  // One walk over the subsample map; for transcryption each protected region
+  // is re-encrypted right after it is decrypted, while it is still warm in
+  // cache.
   const std::vector<SubsampleEntry>& subsamples = decrypt_config->subsamples();
   uint8_t* current_ptr = buffer;
   const uint8_t* const buffer_end = buffer + buffer_size;
@@ -104,7 +84,10 @@ bool DecryptorSource::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
       return false;
     }
     current_ptr += subsample.clear_bytes;
-    if (!decryptor->Crypt(current_ptr, subsample.cipher_bytes, current_ptr)) {
+    if (!decryptor->Crypt(current_ptr, subsample.cipher_bytes, current_ptr) ||
+        (re_encryptor &&
+         !re_encryptor->Crypt(current_ptr, subsample.cipher_bytes,
+                              current_ptr))) {
       LOG(ERROR) << "Error decrypting subsample buffer.";
       return false;
     }
@@ -113,5 +96,82 @@ bool DecryptorSource::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
   return true;
 }
 
+scoped_ptr<AesCryptor> DecryptorSource::AcquireDecryptor(
+    const DecryptConfig* decrypt_config) {
+  EncryptionKey key;
+  {
+    base::AutoLock auto_lock(lock_);
+    std::vector<AesCryptor*>& pool = decryptor_pool_[decrypt_config->key_id()];
+    if (!pool.empty()) {
+      scoped_ptr<AesCryptor> decryptor(pool.back());
+      pool.pop_back();
+      if (!decryptor->SetIv(decrypt_config->iv())) {
+        LOG(ERROR) << "Invalid initialization vector.";
+        pool.push_back(decryptor.release());
+        return scoped_ptr<AesCryptor>();
+      }
+      return decryptor.Pass();
+    }
+
+    // Pool is empty: create a new cryptor. The key is fetched once per
+    // key_id and cached, so growing the pool under contention does not
+    // re-query the key source.
+    auto found = key_map_.find(decrypt_config->key_id());
+    if (found == key_map_.end()) {
+      Status status(key_source_->GetKey(decrypt_config->key_id(), &key));
+      if (!status.ok()) {
+        LOG(ERROR) << "Error retrieving decryption key: " << status;
+        return scoped_ptr<AesCryptor>();
+      }
+      key_map_[decrypt_config->key_id()] = key;
+    } else {
+      key = found->second;
+    }
+  }
+
+  scoped_ptr<AesCryptor> aes_decryptor;
+  switch (decrypt_config->protection_scheme()) {
+    case FOURCC_cenc:
+      aes_decryptor.reset(new AesCtrDecryptor);
+      break;
+    case FOURCC_cbc1:
+      aes_decryptor.reset(new AesCbcDecryptor(kNoPadding));
+      break;
+    case FOURCC_cens:
+      aes_decryptor.reset(new AesPatternCryptor(
+          decrypt_config->crypt_byte_block(),
+          decrypt_config->skip_byte_block(),
+          AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
+          AesCryptor::kDontUseConstantIv,
+          scoped_ptr<AesCryptor>(new AesCtrDecryptor())));
+      break;
+    case FOURCC_cbcs:
+      aes_decryptor.reset(new AesPatternCryptor(
+          decrypt_config->crypt_byte_block(),
+          decrypt_config->skip_byte_block(),
+          AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
+          AesCryptor::kUseConstantIv,
+          scoped_ptr<AesCryptor>(new AesCbcDecryptor(kNoPadding))));
+      break;
+    default:
+      LOG(ERROR) << "Unsupported protection scheme: "
+                 << decrypt_config->protection_scheme();
+      return scoped_ptr<AesCryptor>();
+  }
+
+  if (!aes_decryptor->InitializeWithIv(key.key, decrypt_config->iv())) {
+    LOG(ERROR) << "Failed to initialize AesDecryptor for decryption.";
+    return scoped_ptr<AesCryptor>();
+  }
+  return aes_decryptor.Pass();
+}
+
+void DecryptorSource::ReleaseDecryptor(const std::vector<uint8_t>& key_id,
+                                       scoped_ptr<AesCryptor> decryptor) {
+  DCHECK(decryptor);
+  base::AutoLock auto_lock(lock_);
+  decryptor_pool_[key_id].push_back(decryptor.release());
+}
+
 }  // namespace media
 }  // namespace shaka
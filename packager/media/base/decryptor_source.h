@@ -10,6 +10,8 @@
 #include <map>
 #include <vector>
 
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/lock.h"
 #include "packager/media/base/aes_decryptor.h"
 #include "packager/media/base/decrypt_config.h"
 #include "packager/media/base/key_source.h"
@@ -18,6 +20,9 @@ namespace shaka {
 namespace media {
 
 /// DecryptorSource wraps KeySource and is responsible for decryptor management.
+/// Thread safe: each call checks a cryptor out of a per-key pool for the
+/// duration of the sample, so samples sharing a key can be decrypted
+/// concurrently instead of serializing on one cryptor's state.
 class DecryptorSource {
  public:
   explicit DecryptorSource(KeySource* key_source);
@@ -27,9 +32,45 @@ class DecryptorSource {
                            uint8_t* buffer,
                            size_t buffer_size);
 
+  /// Decrypt and immediately re-encrypt @a buffer in place with a single walk
+  /// over the subsample map, for DRM migration jobs. Each protected region is
+  /// decrypted and re-encrypted before the next region is touched, so the
+  /// buffer is read and written once and the full sample never exists in
+  /// cleartext. The re-encrypted regions are those of @a decrypt_config, so
+  /// this is only usable when the migration keeps the subsample layout of the
+  /// source; @a re_encryptor must already be initialized with the output key
+  /// and positioned at the IV recorded for this sample.
+  /// @return true on success.
+  bool TransformSampleBuffer(const DecryptConfig* decrypt_config,
+                             AesCryptor* re_encryptor,
+                             uint8_t* buffer,
+                             size_t buffer_size);
+
  private:
+  // Checks a decryptor for |decrypt_config|'s key out of the pool, creating
+  // one if the pool is empty. The key is fetched from the key source the
+  // first time a key_id is seen and cached after that, so growing the pool
+  // does not re-query the key source. Returns NULL on failure.
+  scoped_ptr<AesCryptor> AcquireDecryptor(const DecryptConfig* decrypt_config);
+  // Returns |decryptor| to the pool for |key_id|.
+  void ReleaseDecryptor(const std::vector<uint8_t>& key_id,
+                        scoped_ptr<AesCryptor> decryptor);
+
+  // Decryption loops shared by DecryptSampleBuffer and TransformSampleBuffer;
+  // |re_encryptor| is NULL for plain decryption.
+  bool CryptBufferInternal(AesCryptor* decryptor,
+                           AesCryptor* re_encryptor,
+                           const DecryptConfig* decrypt_config,
+                           uint8_t* buffer,
+                           size_t buffer_size);
+
   KeySource* key_source_;
-  std::map<std::vector<uint8_t>, AesCryptor*> decryptor_map_;
+
+  base::Lock lock_;
+  // Keys already fetched from |key_source_|, by key_id.
+  std::map<std::vector<uint8_t>, EncryptionKey> key_map_;
+  // Idle cryptors by key_id; owned.
+  std::map<std::vector<uint8_t>, std::vector<AesCryptor*> > decryptor_pool_;
 
   DISALLOW_COPY_AND_ASSIGN(DecryptorSource);
 };
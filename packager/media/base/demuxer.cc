@@ -9,10 +9,13 @@
 #include "packager/base/bind.h"
 #include "packager/base/logging.h"
 #include "packager/base/stl_util.h"
+#include "packager/media/base/allocation_tracker.h"
+#include "packager/media/base/closure_thread.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/media_stream.h"
+#include "packager/media/base/spsc_queue.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/media/file/file.h"
 #include "packager/media/formats/mp2t/mp2t_media_parser.h"
@@ -29,24 +32,77 @@ const size_t kBufSize = 0x200000;  // 2MB
 // samples before seeing init_event, something is not right. The number
 // set here is arbitrary though.
 const size_t kQueuedSamplesLimit = 10000;
+// Default per-stream queue capacity in threaded dispatch mode. Deep enough to
+// ride out transient muxer stalls without consuming excessive memory.
+const size_t kDefaultDispatchQueueCapacity = 128;
+// Maximum number of samples a dispatch worker delivers to its stream in one
+// batch. Batching amortizes per-sample dispatch overhead while keeping
+// delivery latency bounded.
+const size_t kMaxDispatchBatchSize = 64;
 }
 
 namespace shaka {
 namespace media {
 
+struct Demuxer::StreamDispatcher {
+  StreamDispatcher(MediaStream* stream, size_t queue_capacity)
+      : stream(stream), queue(queue_capacity) {}
+
+  MediaStream* stream;
+  // The parsing thread is the only producer and the worker thread the only
+  // consumer, so the lock-free SPSC queue applies.
+  SpscQueue<scoped_refptr<MediaSample> > queue;
+  scoped_ptr<ClosureThread> thread;
+  // Written by the worker thread before it exits; read after Join.
+  Status status;
+};
+
 Demuxer::Demuxer(const std::string& file_name)
     : file_name_(file_name),
       media_file_(NULL),
       init_event_received_(false),
       container_name_(CONTAINER_UNKNOWN),
       buffer_(new uint8_t[kBufSize]),
-      cancelled_(false) {
+      cancelled_(false),
+      fault_tolerant_(false),
+      downstream_error_(false),
+      input_position_(0),
+      skipped_bytes_(0),
+      parse_error_count_(0),
+      threaded_dispatch_(false),
+      dispatch_queue_capacity_(kDefaultDispatchQueueCapacity),
+      range_start_seconds_(0),
+      range_end_seconds_(0) {
 }
 
 Demuxer::~Demuxer() {
   if (media_file_)
     media_file_->Close();
   STLDeleteElements(&streams_);
+  DCHECK(dispatchers_.empty());
+}
+
+void Demuxer::EnableThreadedDispatch(size_t queue_capacity) {
+  DCHECK(dispatchers_.empty());
+  threaded_dispatch_ = true;
+  if (queue_capacity > 0)
+    dispatch_queue_capacity_ = queue_capacity;
+}
+
+void Demuxer::EnableFaultTolerantParsing() {
+  fault_tolerant_ = true;
+}
+
+void Demuxer::SetSelectedStreamTypes(
+    const std::set<StreamType>& stream_types) {
+  DCHECK(!parser_);
+  selected_stream_types_ = stream_types;
+}
+
+void Demuxer::SetTimeRange(double start_seconds, double end_seconds) {
+  DCHECK(!parser_);
+  range_start_seconds_ = start_seconds;
+  range_end_seconds_ = end_seconds;
 }
 
 void Demuxer::SetKeySource(scoped_ptr<KeySource> key_source) {
@@ -100,6 +156,11 @@ Status Demuxer::Initialize() {
       return Status(error::UNIMPLEMENTED, "Container not supported.");
   }
 
+  if (!selected_stream_types_.empty())
+    parser_->SetSelectedStreamTypes(selected_stream_types_);
+  if (range_end_seconds_ > range_start_seconds_)
+    parser_->SetTimeRange(range_start_seconds_, range_end_seconds_);
+
   parser_->Init(base::Bind(&Demuxer::ParserInitEvent, base::Unretained(this)),
                 base::Bind(&Demuxer::NewSampleEvent, base::Unretained(this)),
                 key_source_.get());
@@ -130,8 +191,9 @@ void Demuxer::ParserInitEvent(
   }
 }
 
-Demuxer::QueuedSample::QueuedSample(uint32_t local_track_id,
-                                      scoped_refptr<MediaSample> local_sample)
+Demuxer::QueuedSample::QueuedSample(
+    uint32_t local_track_id,
+    const scoped_refptr<MediaSample>& local_sample)
     : track_id(local_track_id), sample(local_sample) {}
 Demuxer::QueuedSample::~QueuedSample() {}
 
@@ -157,12 +219,34 @@ bool Demuxer::NewSampleEvent(uint32_t track_id,
 
 bool Demuxer::PushSample(uint32_t track_id,
                          const scoped_refptr<MediaSample>& sample) {
+  if (!dispatchers_.empty()) {
+    std::vector<StreamDispatcher*>::iterator it = dispatchers_.begin();
+    for (; it != dispatchers_.end(); ++it) {
+      if (track_id == (*it)->stream->info()->track_id()) {
+        Status status = (*it)->queue.Push(sample);
+        // A stopped queue means the worker exited on error; report the worker
+        // status instead of the generic STOPPED.
+        if (status.error_code() == error::STOPPED && !(*it)->status.ok())
+          status = (*it)->status;
+        if (!status.ok()) {
+          LOG(ERROR) << "Demuxer::PushSample failed with " << status;
+          downstream_error_ = true;
+        }
+        return status.ok();
+      }
+    }
+    LOG(ERROR) << "Track " << track_id << " not found.";
+    return false;
+  }
+
   std::vector<MediaStream*>::iterator it = streams_.begin();
   for (; it != streams_.end(); ++it) {
     if (track_id == (*it)->info()->track_id()) {
       Status status = (*it)->PushSample(sample);
-      if (!status.ok())
+      if (!status.ok()) {
         LOG(ERROR) << "Demuxer::PushSample failed with " << status;
+        downstream_error_ = true;
+      }
       return status.ok();
     }
   }
@@ -172,6 +256,7 @@ bool Demuxer::PushSample(uint32_t track_id,
 
 Status Demuxer::Run() {
   Status status;
+  ScopedAllocationScope allocation_scope(AllocationTracker::kScopeParser);
 
   LOG(INFO) << "Demuxer::Run() on file '" << file_name_ << "'.";
 
@@ -184,26 +269,114 @@ Status Demuxer::Run() {
       return status;
   }
 
+  if (threaded_dispatch_)
+    StartStreamDispatchers();
+
   while (!cancelled_ && (status = Parse()).ok())
     continue;
 
   if (cancelled_ && status.ok())
-    return Status(error::CANCELLED, "Demuxer run cancelled");
+    status = Status(error::CANCELLED, "Demuxer run cancelled");
 
   if (status.error_code() == error::END_OF_STREAM) {
     // Push EOS sample to muxer to indicate end of stream.
     const scoped_refptr<MediaSample>& sample = MediaSample::CreateEOSBuffer();
-    for (std::vector<MediaStream*>::iterator it = streams_.begin();
-         it != streams_.end();
-         ++it) {
-      status = (*it)->PushSample(sample);
-      if (!status.ok())
-        return status;
+    if (!dispatchers_.empty()) {
+      for (std::vector<StreamDispatcher*>::iterator it = dispatchers_.begin();
+           it != dispatchers_.end();
+           ++it) {
+        Status push_status = (*it)->queue.Push(sample);
+        // Worker failures are collected in StopStreamDispatchers below.
+        if (!push_status.ok() && push_status.error_code() != error::STOPPED)
+          status.Update(push_status);
+      }
+    } else {
+      for (std::vector<MediaStream*>::iterator it = streams_.begin();
+           it != streams_.end();
+           ++it) {
+        Status push_status = (*it)->PushSample(sample);
+        if (!push_status.ok()) {
+          status.Update(push_status);
+          break;
+        }
+      }
     }
   }
+
+  if (!dispatchers_.empty()) {
+    Status dispatch_status = StopStreamDispatchers();
+    if (status.error_code() == error::END_OF_STREAM)
+      status = dispatch_status;
+    else
+      status.Update(dispatch_status);
+  }
+
+  if (skipped_bytes_ > 0) {
+    LOG(WARNING) << "Fault-tolerant parsing skipped " << skipped_bytes_
+                 << " bytes over " << parse_error_count_
+                 << " damaged range(s) in '" << file_name_ << "'.";
+  }
+  VLOG(1) << stats_.ToString("demux[" + file_name_ + "]");
   return status;
 }
 
+void Demuxer::StartStreamDispatchers() {
+  DCHECK(dispatchers_.empty());
+  for (std::vector<MediaStream*>::iterator it = streams_.begin();
+       it != streams_.end();
+       ++it) {
+    StreamDispatcher* dispatcher =
+        new StreamDispatcher(*it, dispatch_queue_capacity_);
+    dispatcher->thread.reset(new ClosureThread(
+        "StreamDispatcher",
+        base::Bind(&Demuxer::DispatchSamplesTask, base::Unretained(this),
+                   dispatcher)));
+    dispatchers_.push_back(dispatcher);
+    dispatcher->thread->Start();
+  }
+}
+
+Status Demuxer::StopStreamDispatchers() {
+  Status status;
+  for (std::vector<StreamDispatcher*>::iterator it = dispatchers_.begin();
+       it != dispatchers_.end();
+       ++it) {
+    (*it)->queue.Stop();
+    (*it)->thread->Join();
+    status.Update((*it)->status);
+  }
+  STLDeleteElements(&dispatchers_);
+  return status;
+}
+
+void Demuxer::DispatchSamplesTask(StreamDispatcher* dispatcher) {
+  Status status;
+  std::deque<scoped_refptr<MediaSample> > batch;
+  while (status.ok()) {
+    scoped_refptr<MediaSample> sample;
+    Status pop_status = dispatcher->queue.Pop(&sample);
+    if (pop_status.error_code() == error::STOPPED)
+      break;
+    if (!pop_status.ok()) {
+      status = pop_status;
+      break;
+    }
+    // Drain whatever else is already queued, up to the batch limit, and
+    // deliver the whole batch with one call.
+    batch.clear();
+    batch.push_back(sample);
+    while (batch.size() < kMaxDispatchBatchSize &&
+           dispatcher->queue.TryPop(&sample)) {
+      batch.push_back(sample);
+    }
+    status = dispatcher->stream->PushSamples(batch);
+  }
+  dispatcher->status = status;
+  // Unblock the parsing thread if we exit on error.
+  if (!status.ok())
+    dispatcher->queue.Stop();
+}
+
 Status Demuxer::Parse() {
   DCHECK(media_file_);
   DCHECK(parser_);
@@ -216,17 +389,43 @@ Status Demuxer::Parse() {
 
   int64_t bytes_read = media_file_->Read(buffer_.get(), kBufSize);
   if (bytes_read == 0) {
-    if (!parser_->Flush())
-      return Status(error::PARSER_FAILURE, "Failed to flush.");
+    if (!parser_->Flush()) {
+      if (!fault_tolerant_ || !init_event_received_ || downstream_error_)
+        return Status(error::PARSER_FAILURE, "Failed to flush.");
+      LOG(WARNING) << "Discarded incomplete data at the end of " << file_name_;
+    }
     return Status(error::END_OF_STREAM, "");
   } else if (bytes_read < 0) {
     return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
   }
 
-  return parser_->Parse(buffer_.get(), bytes_read)
-             ? Status::OK
-             : Status(error::PARSER_FAILURE,
-                      "Cannot parse media file " + file_name_);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const bool parse_ok = parser_->Parse(buffer_.get(), bytes_read);
+  stats_.AddSample(bytes_read, base::TimeTicks::Now() - start);
+  input_position_ += bytes_read;
+  if (parse_ok) {
+    // When a time range is set, stop reading as soon as every stream has
+    // passed its end instead of streaming the rest of the file through the
+    // parser.
+    if (parser_->IsParsingComplete())
+      return Status(error::END_OF_STREAM, "");
+    return Status::OK;
+  }
+  if (fault_tolerant_ && init_event_received_ && !downstream_error_) {
+    // Damaged input range. Reset the parser so that it can accept data at a
+    // new position and resume with the next buffer; the parser picks up at
+    // the next valid boundary it recognizes (sync byte, box header).
+    skipped_bytes_ += bytes_read;
+    ++parse_error_count_;
+    LOG(WARNING) << "Parse error in " << file_name_ << " near offset "
+                 << input_position_ - bytes_read << "; skipping " << bytes_read
+                 << " bytes and resynchronizing.";
+    if (!parser_->Flush())
+      VLOG(1) << "Parser flush after parse error failed; continuing.";
+    return Status::OK;
+  }
+  return Status(error::PARSER_FAILURE,
+                "Cannot parse media file " + file_name_);
 }
 
 void Demuxer::Cancel() {
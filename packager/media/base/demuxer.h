@@ -8,13 +8,16 @@
 #define MEDIA_BASE_DEMUXER_H_
 
 #include <deque>
+#include <set>
 #include <vector>
 
 #include "packager/base/compiler_specific.h"
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/container_names.h"
+#include "packager/media/base/pipeline_stats.h"
 #include "packager/media/base/status.h"
+#include "packager/media/base/stream_info.h"
 
 namespace shaka {
 namespace media {
@@ -43,6 +46,23 @@ class Demuxer {
   ///        demuxed.
   void SetKeySource(scoped_ptr<KeySource> key_source);
 
+  /// Restrict demuxing to streams of the given types. The media parser
+  /// skips the per-stream setup and sample processing of unselected streams
+  /// where the container format allows it, so e.g. audio-only extraction
+  /// does not pay for parsing the video track. Must be called before
+  /// @a Initialize; an empty set (the default) selects all streams.
+  void SetSelectedStreamTypes(const std::set<StreamType>& stream_types);
+
+  /// Restrict demuxing to the given presentation time range, in seconds.
+  /// Where the media parser supports it, samples outside the range are
+  /// skipped without data processing and parsing stops once every stream has
+  /// passed @a end_seconds, so clipping a range out of a long title does not
+  /// demux the whole file. The range is coarse (keyframe granularity);
+  /// downstream consumers needing exact bounds must still filter, e.g. via
+  /// the muxer shard range. Must be called before @a Initialize; disabled
+  /// when @a end_seconds <= @a start_seconds.
+  void SetTimeRange(double start_seconds, double end_seconds);
+
   /// Initialize the Demuxer. Calling other public methods of this class
   /// without this method returning OK, results in an undefined behavior.
   /// This method primes the demuxer by parsing portions of the media file to
@@ -61,6 +81,28 @@ class Demuxer {
   /// status of type CANCELLED.
   void Cancel();
 
+  /// Enable threaded sample dispatch in @a Run. Each stream gets a dedicated
+  /// worker thread with a bounded sample queue, so a slow muxer on one stream
+  /// does not stall delivery to the other streams. Must be called before
+  /// @a Run.
+  /// @param queue_capacity is the maximum number of samples buffered per
+  ///        stream before the parsing thread blocks. A value of zero picks a
+  ///        default capacity.
+  void EnableThreadedDispatch(size_t queue_capacity);
+
+  /// Enable fault-tolerant parsing in @a Run. Instead of aborting the job on
+  /// a mid-stream parser error, the demuxer resets the parser and resumes
+  /// with the next input buffer, skipping the damaged range; the parser then
+  /// resynchronizes on the next valid boundary it recognizes in later data.
+  /// Skipped bytes are counted and reported. Initialization errors and
+  /// downstream (muxer) failures remain fatal. Must be called before @a Run.
+  void EnableFaultTolerantParsing();
+
+  /// @return Number of input bytes skipped over damaged ranges when
+  ///         fault-tolerant parsing is enabled. Meaningful after @a Run has
+  ///         returned.
+  uint64_t skipped_bytes() const { return skipped_bytes_; }
+
   /// @return Streams in the media container being demuxed. The caller cannot
   ///         add or remove streams from the returned vector, but the caller is
   ///         allowed to change the internal state of the streams in the vector
@@ -71,15 +113,23 @@ class Demuxer {
   ///         is not initialized.
   MediaContainerName container_name() { return container_name_; }
 
+  /// @return Parse stage counters: bytes read and time spent in the media
+  ///         parser. Meaningful after Run has returned.
+  const StageStats& stats() const { return stats_; }
+
  private:
   struct QueuedSample {
-    QueuedSample(uint32_t track_id, scoped_refptr<MediaSample> sample);
+    QueuedSample(uint32_t track_id, const scoped_refptr<MediaSample>& sample);
     ~QueuedSample();
 
     uint32_t track_id;
     scoped_refptr<MediaSample> sample;
   };
 
+  // Per-stream dispatch state for threaded dispatch mode: a bounded sample
+  // queue consumed by a dedicated worker thread.
+  struct StreamDispatcher;
+
   // Parser init event.
   void ParserInitEvent(const std::vector<scoped_refptr<StreamInfo> >& streams);
   // Parser new sample event handler. Queues the samples if init event has not
@@ -87,8 +137,19 @@ class Demuxer {
   // corresponding stream.
   bool NewSampleEvent(uint32_t track_id,
                       const scoped_refptr<MediaSample>& sample);
-  // Helper function to push the sample to corresponding stream.
+  // Helper function to push the sample to corresponding stream. In threaded
+  // dispatch mode the sample is queued for the stream's worker thread instead,
+  // blocking if the queue is at capacity.
   bool PushSample(uint32_t track_id, const scoped_refptr<MediaSample>& sample);
+  // Worker thread body for |dispatcher|. Pops samples from the dispatcher
+  // queue and pushes them to the associated stream until the queue is stopped
+  // or a push fails.
+  void DispatchSamplesTask(StreamDispatcher* dispatcher);
+  // Create and start one dispatcher per stream.
+  void StartStreamDispatchers();
+  // Stop all dispatchers, join their threads and return the first error
+  // status encountered by any worker, if any.
+  Status StopStreamDispatchers();
 
   std::string file_name_;
   File* media_file_;
@@ -97,11 +158,29 @@ class Demuxer {
   // Queued samples received in NewSampleEvent() before ParserInitEvent().
   std::deque<QueuedSample> queued_samples_;
   scoped_ptr<MediaParser> parser_;
+  // Empty means all streams are selected.
+  std::set<StreamType> selected_stream_types_;
+  // Presentation time range to demux; disabled when end <= start.
+  double range_start_seconds_;
+  double range_end_seconds_;
   std::vector<MediaStream*> streams_;
   MediaContainerName container_name_;
   scoped_ptr<uint8_t[]> buffer_;
   scoped_ptr<KeySource> key_source_;
   bool cancelled_;
+  // Fault-tolerant parsing state. |downstream_error_| distinguishes sample
+  // delivery failures, which stay fatal, from input corruption.
+  bool fault_tolerant_;
+  bool downstream_error_;
+  uint64_t input_position_;
+  uint64_t skipped_bytes_;
+  uint32_t parse_error_count_;
+  // Threaded dispatch state. |dispatchers_| is non-empty only while Run() is
+  // executing with threaded dispatch enabled.
+  bool threaded_dispatch_;
+  size_t dispatch_queue_capacity_;
+  std::vector<StreamDispatcher*> dispatchers_;
+  StageStats stats_;
 
   DISALLOW_COPY_AND_ASSIGN(Demuxer);
 };
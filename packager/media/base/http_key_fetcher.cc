@@ -8,31 +8,18 @@
 
 #include <curl/curl.h>
 
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/stringprintf.h"
 #include "packager/base/synchronization/lock.h"
+#include "packager/base/threading/worker_pool.h"
 
 namespace shaka {
 
 namespace {
 const char kUserAgentString[] = "shaka-packager-http_fetcher/1.0";
 
-// Scoped CURL implementation which cleans up itself when goes out of scope.
-class ScopedCurl {
- public:
-  ScopedCurl() { ptr_ = curl_easy_init(); }
-  ~ScopedCurl() {
-    if (ptr_)
-      curl_easy_cleanup(ptr_);
-  }
-
-  CURL* get() { return ptr_; }
-
- private:
-  CURL* ptr_;
-  DISALLOW_COPY_AND_ASSIGN(ScopedCurl);
-};
-
 size_t AppendToString(char* ptr, size_t size, size_t nmemb, std::string* response) {
   DCHECK(ptr);
   DCHECK(response);
@@ -70,12 +57,15 @@ class LibCurlInitializer {
 
 namespace media {
 
-HttpKeyFetcher::HttpKeyFetcher() : timeout_in_seconds_(0) {}
+HttpKeyFetcher::HttpKeyFetcher() : timeout_in_seconds_(0), curl_(NULL) {}
 
 HttpKeyFetcher::HttpKeyFetcher(uint32_t timeout_in_seconds)
-    : timeout_in_seconds_(timeout_in_seconds) {}
+    : timeout_in_seconds_(timeout_in_seconds), curl_(NULL) {}
 
-HttpKeyFetcher::~HttpKeyFetcher() {}
+HttpKeyFetcher::~HttpKeyFetcher() {
+  if (curl_)
+    curl_easy_cleanup(curl_);
+}
 
 Status HttpKeyFetcher::FetchKeys(const std::string& url,
                                  const std::string& request,
@@ -93,6 +83,42 @@ Status HttpKeyFetcher::Post(const std::string& path,
   return FetchInternal(POST, path, data, response);
 }
 
+HttpKeyFetcher::PendingFetch::PendingFetch() : done_(false, false) {}
+
+HttpKeyFetcher::PendingFetch::~PendingFetch() {
+  // The worker task writes into this object; wait for it even if the caller
+  // abandons the fetch.
+  done_.Wait();
+}
+
+Status HttpKeyFetcher::PendingFetch::WaitForResponse(std::string* response) {
+  DCHECK(response);
+  done_.Wait();
+  if (status_.ok())
+    *response = response_;
+  return status_;
+}
+
+scoped_ptr<HttpKeyFetcher::PendingFetch> HttpKeyFetcher::PostAsync(
+    const std::string& url,
+    const std::string& data) {
+  scoped_ptr<PendingFetch> pending(new PendingFetch);
+  base::WorkerPool::PostTask(
+      FROM_HERE, base::Bind(&HttpKeyFetcher::FetchTask, base::Unretained(this),
+                            url, data, pending.get()),
+      true /* task_is_slow */);
+  return pending.Pass();
+}
+
+// static
+void HttpKeyFetcher::FetchTask(HttpKeyFetcher* fetcher,
+                               const std::string& url,
+                               const std::string& data,
+                               PendingFetch* pending) {
+  pending->status_ = fetcher->Post(url, data, &pending->response_);
+  pending->done_.Signal();
+}
+
 Status HttpKeyFetcher::FetchInternal(HttpMethod method,
                                      const std::string& path,
                                      const std::string& data,
@@ -101,8 +127,13 @@ Status HttpKeyFetcher::FetchInternal(HttpMethod method,
 
   static LibCurlInitializer lib_curl_initializer;
 
-  ScopedCurl scoped_curl;
-  CURL* curl = scoped_curl.get();
+  // Reuse one handle for the lifetime of the fetcher: curl keeps the
+  // connection and TLS session alive between requests, so only the first
+  // fetch pays for the handshakes.
+  base::AutoLock scoped_lock(curl_lock_);
+  if (!curl_)
+    curl_ = curl_easy_init();
+  CURL* curl = curl_;
   if (!curl) {
     LOG(ERROR) << "curl_easy_init() failed.";
     return Status(error::HTTP_FAILURE, "curl_easy_init() failed.");
@@ -114,11 +145,16 @@ Status HttpKeyFetcher::FetchInternal(HttpMethod method,
   curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_in_seconds_);
   curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AppendToString);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
   if (method == POST) {
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
     curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data.size());
+  } else {
+    // The handle is reused; reset the method in case the previous request
+    // was a POST.
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
   }
 
   CURLcode res = curl_easy_perform(curl);
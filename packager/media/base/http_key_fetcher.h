@@ -12,13 +12,21 @@
 #define MEDIA_BASE_HTTP_KEY_FETCHER_H_
 
 #include "packager/base/compiler_specific.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
 #include "packager/media/base/key_fetcher.h"
 #include "packager/media/base/status.h"
 
+typedef void CURL;
+
 namespace shaka {
 namespace media {
 
 /// A KeyFetcher implementation that retrieves keys over HTTP(s).
+/// The underlying connection is kept alive across requests, so repeated
+/// fetches against the same server reuse the TCP connection and TLS session
+/// instead of re-handshaking.
 /// This class is not fully thread safe. It can be used in multi-thread
 /// environment once constructed, but it may not be safe to create a
 /// HttpKeyFetcher object when any other thread is running due to use of
@@ -53,6 +61,41 @@ class HttpKeyFetcher : public KeyFetcher {
                       const std::string& data,
                       std::string* response);
 
+  /// Handle to an asynchronous fetch started by PostAsync(). Destroying the
+  /// handle blocks until the fetch has completed.
+  class PendingFetch {
+   public:
+    ~PendingFetch();
+
+    /// Blocks until the fetch completes.
+    /// @param[out] response will contain the body of the http response on
+    ///             success. It should not be NULL.
+    /// @return the status of the fetch.
+    Status WaitForResponse(std::string* response);
+
+   private:
+    friend class HttpKeyFetcher;
+    PendingFetch();
+
+    Status status_;
+    std::string response_;
+    base::WaitableEvent done_;
+
+    DISALLOW_COPY_AND_ASSIGN(PendingFetch);
+  };
+
+  /// Start a HTTP POST on a worker thread and return immediately, so the
+  /// caller can overlap the round trip to the server with other work, e.g.
+  /// prefetching the next crypto period's keys during rotation. The fetch
+  /// runs through the same fetcher, so it reuses the persistent connection
+  /// and serializes with other requests on this object.
+  /// This fetcher must outlive the returned handle.
+  /// @param url specifies the content URL.
+  /// @param data is the request body.
+  /// @return a handle to wait on for the response; never NULL.
+  scoped_ptr<PendingFetch> PostAsync(const std::string& url,
+                                     const std::string& data);
+
  private:
   enum HttpMethod {
     GET,
@@ -64,7 +107,18 @@ class HttpKeyFetcher : public KeyFetcher {
   Status FetchInternal(HttpMethod method, const std::string& url,
                        const std::string& data, std::string* response);
 
+  // Runs |pending|'s POST on the worker pool and signals completion.
+  static void FetchTask(HttpKeyFetcher* fetcher,
+                        const std::string& url,
+                        const std::string& data,
+                        PendingFetch* pending);
+
   const uint32_t timeout_in_seconds_;
+  // Serializes requests on the shared handle.
+  base::Lock curl_lock_;
+  // Persistent handle so curl keeps connections and TLS sessions alive
+  // across requests. Created lazily on first fetch.
+  CURL* curl_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpKeyFetcher);
 };
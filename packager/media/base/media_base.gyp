@@ -21,22 +21,30 @@
         'aes_encryptor.h',
         'aes_pattern_cryptor.cc',
         'aes_pattern_cryptor.h',
+        'allocation_tracker.cc',
+        'allocation_tracker.h',
         'audio_stream_info.cc',
         'audio_stream_info.h',
         'audio_timestamp_helper.cc',
         'audio_timestamp_helper.h',
         'bit_reader.cc',
         'bit_reader.h',
+        'buffer_pool.cc',
+        'buffer_pool.h',
         'buffer_reader.cc',
         'buffer_reader.h',
         'buffer_writer.cc',
         'buffer_writer.h',
         'byte_queue.cc',
         'byte_queue.h',
+        'cipher_engine.cc',
+        'cipher_engine.h',
         'closure_thread.cc',
         'closure_thread.h',
         'container_names.cc',
         'container_names.h',
+        'crc32.cc',
+        'crc32.h',
         'demuxer.cc',
         'demuxer.h',
         'decrypt_config.cc',
@@ -70,24 +78,32 @@
         'network_util.h',
         'offset_byte_queue.cc',
         'offset_byte_queue.h',
+        'pipeline_stats.cc',
+        'pipeline_stats.h',
         'producer_consumer_queue.h',
         'protection_system_specific_info.cc',
         'protection_system_specific_info.h',
         'rcheck.h',
+        'reorder_buffer.h',
         'request_signer.cc',
         'request_signer.h',
         'rsa_key.cc',
         'rsa_key.h',
+        'spsc_queue.h',
         'status.cc',
         'status.h',
         'stream_info.cc',
         'stream_info.h',
+        'string_codecs.cc',
+        'string_codecs.h',
         'text_stream_info.cc',
         'text_stream_info.h',
         'text_track.h',
         'text_track_config.cc',
         'text_track_config.h',
         'timestamp.h',
+        'timestamp_validator.cc',
+        'timestamp_validator.h',
         'video_stream_info.cc',
         'video_stream_info.h',
         'widevine_key_source.cc',
@@ -123,9 +139,12 @@
         'aes_pattern_cryptor_unittest.cc',
         'audio_timestamp_helper_unittest.cc',
         'bit_reader_unittest.cc',
+        'buffer_pool_unittest.cc',
         'buffer_writer_unittest.cc',
+        'byte_queue_unittest.cc',
         'closure_thread_unittest.cc',
         'container_names_unittest.cc',
+        'crc32_unittest.cc',
         'decryptor_source_unittest.cc',
         'fixed_key_source_unittest.cc',
         'http_key_fetcher_unittest.cc',
@@ -133,9 +152,13 @@
         'offset_byte_queue_unittest.cc',
         'producer_consumer_queue_unittest.cc',
         'protection_system_specific_info_unittest.cc',
+        'reorder_buffer_unittest.cc',
         'rsa_key_unittest.cc',
+        'spsc_queue_unittest.cc',
         'status_test_util_unittest.cc',
         'status_unittest.cc',
+        'string_codecs_unittest.cc',
+        'timestamp_validator_unittest.cc',
         'test/fake_prng.cc',  # For rsa_key_unittest
         'test/fake_prng.h',   # For rsa_key_unittest
         'test/rsa_test_data.cc',  # For rsa_key_unittest
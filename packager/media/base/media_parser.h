@@ -7,6 +7,7 @@
 #ifndef MEDIA_BASE_MEDIA_PARSER_H_
 #define MEDIA_BASE_MEDIA_PARSER_H_
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,7 @@
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/container_names.h"
+#include "packager/media/base/stream_info.h"
 
 namespace shaka {
 namespace media {
@@ -63,6 +65,32 @@ class MediaParser {
   /// @return true if successful.
   virtual bool Parse(const uint8_t* buf, int size) WARN_UNUSED_RESULT = 0;
 
+  /// Restrict parsing to streams of the given types. Parsers that support
+  /// selection skip the per-stream setup and sample processing of other
+  /// streams entirely and emit neither stream info nor samples for them;
+  /// the default implementation ignores the selection and parses everything.
+  /// Since skipping streams changes zero-based stream indices, callers that
+  /// address streams by index must not narrow the selection.
+  /// Must be called before Parse(); an empty set selects all streams.
+  virtual void SetSelectedStreamTypes(
+      const std::set<StreamType>& stream_types) {}
+
+  /// Restrict parsing to the given presentation time range, in seconds.
+  /// Parsers that support ranges skip the sample processing (data copy,
+  /// decryption, emission) of samples outside the range and report parsing
+  /// complete once every stream has passed @a end_seconds, so the rest of
+  /// the input is never parsed. The range is coarse: a parser may emit
+  /// samples slightly outside it, so callers needing exact bounds must still
+  /// filter downstream. The default implementation ignores the range.
+  /// Must be called before Parse(); disabled when
+  /// @a end_seconds <= @a start_seconds.
+  virtual void SetTimeRange(double start_seconds, double end_seconds) {}
+
+  /// @return true once the parser knows that no further samples will be
+  ///         emitted, e.g. every stream has passed the end of the time range
+  ///         set via SetTimeRange(). The caller may then stop feeding input.
+  virtual bool IsParsingComplete() const { return false; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(MediaParser);
 };
@@ -8,12 +8,31 @@
 
 #include <inttypes.h>
 
+#include <string.h>
+
 #include "packager/base/logging.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/media/base/buffer_pool.h"
 
 namespace shaka {
 namespace media {
 
+namespace {
+// Payloads at or below this size bypass the shared buffer pool. Text samples
+// (caption cues, metadata) are typically tens of bytes; routing them through
+// the pool would take the pool lock twice per sample and pin a buffer of at
+// least the pool's smallest size class for a few dozen bytes of payload.
+const size_t kSmallPayloadSize = 256u;
+}  // namespace
+
+// static
+BufferPool* MediaSample::buffer_pool_ = NULL;
+
+// static
+void MediaSample::set_buffer_pool(BufferPool* pool) {
+  buffer_pool_ = pool;
+}
+
 MediaSample::MediaSample(const uint8_t* data,
                          size_t size,
                          const uint8_t* side_data,
@@ -28,9 +47,15 @@ MediaSample::MediaSample(const uint8_t* data,
     CHECK_EQ(size, 0u);
   }
 
-  data_.assign(data, data + size);
+  if (buffer_pool_ && size > kSmallPayloadSize) {
+    buffer_pool_->Allocate(size, &data_);
+    memcpy(&data_[0], data, size);
+  } else {
+    data_.assign(data, data + size);
+  }
   if (side_data)
     side_data_.assign(side_data, side_data + side_data_size);
+  UpdateCharge();
 }
 
 MediaSample::MediaSample() : dts_(0),
@@ -39,7 +64,10 @@ MediaSample::MediaSample() : dts_(0),
                              is_key_frame_(false),
                              is_encrypted_(false) {}
 
-MediaSample::~MediaSample() {}
+MediaSample::~MediaSample() {
+  if (buffer_pool_ && data_.capacity() > kSmallPayloadSize)
+    buffer_pool_->Release(&data_);
+}
 
 // static
 scoped_refptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
@@ -63,6 +91,20 @@ scoped_refptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
       data, data_size, side_data, side_data_size, is_key_frame));
 }
 
+// static
+scoped_refptr<MediaSample> MediaSample::TransferData(
+    std::vector<uint8_t>* data,
+    bool is_key_frame) {
+  // If you hit this CHECK you likely have a bug in a demuxer. Go fix it.
+  // An empty buffer is indistinguishable from an end of stream sample.
+  CHECK(data);
+  CHECK(!data->empty());
+  scoped_refptr<MediaSample> media_sample(new MediaSample());
+  media_sample->data_.swap(*data);
+  media_sample->is_key_frame_ = is_key_frame;
+  return media_sample;
+}
+
 // static
 scoped_refptr<MediaSample> MediaSample::FromMetadata(const uint8_t* metadata,
                                                      size_t metadata_size) {
@@ -81,6 +123,21 @@ scoped_refptr<MediaSample> MediaSample::CreateEOSBuffer() {
   return make_scoped_refptr(new MediaSample(NULL, 0, NULL, 0, false));
 }
 
+scoped_refptr<MediaSample> MediaSample::Clone() const {
+  if (end_of_stream())
+    return CreateEOSBuffer();
+  scoped_refptr<MediaSample> clone(new MediaSample(
+      &data_[0], data_.size(),
+      side_data_.empty() ? NULL : &side_data_[0], side_data_.size(),
+      is_key_frame_));
+  clone->dts_ = dts_;
+  clone->pts_ = pts_;
+  clone->duration_ = duration_;
+  clone->is_encrypted_ = is_encrypted_;
+  clone->config_id_ = config_id_;
+  return clone;
+}
+
 std::string MediaSample::ToString() const {
   if (end_of_stream())
     return "End of stream sample\n";
@@ -14,13 +14,25 @@
 #include "packager/base/logging.h"
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/allocation_tracker.h"
 
 namespace shaka {
 namespace media {
 
+class BufferPool;
+
 /// Class to hold a media sample.
 class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
  public:
+  /// Install a payload buffer pool shared by all MediaSample instances.
+  /// CopyFrom draws payload buffers from the pool and the destructor returns
+  /// them. Small payloads (e.g. text cues) are stored inline with a plain
+  /// exact-size allocation and never touch the pool. Must be installed before
+  /// the pipeline starts and stay alive until all samples are destroyed;
+  /// pass NULL to go back to plain allocation.
+  /// @param pool is the pool to install. Ownership stays with the caller.
+  static void set_buffer_pool(BufferPool* pool);
+
   /// Create a MediaSample object from input.
   /// @param data points to the buffer containing the sample data.
   ///        Must not be NULL.
@@ -45,6 +57,15 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
                                              size_t side_data_size,
                                              bool is_key_frame);
 
+  /// Create a MediaSample object by adopting the contents of @a data, i.e.
+  /// without copying the sample payload. Prefer this over CopyFrom when the
+  /// caller owns a buffer it no longer needs.
+  /// @param data contains the sample data and is emptied by this call.
+  ///        Must not be NULL or empty.
+  /// @param is_key_frame indicates whether the sample is a key frame.
+  static scoped_refptr<MediaSample> TransferData(std::vector<uint8_t>* data,
+                                                 bool is_key_frame);
+
   /// Create a MediaSample object from metadata.
   /// Unlike other factory methods, this cannot be a key frame. It must be only
   /// for metadata.
@@ -62,6 +83,10 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
   /// is disallowed.
   static scoped_refptr<MediaSample> CreateEOSBuffer();
 
+  /// Create a deep copy of this sample, so that the copy's payload can be
+  /// modified, e.g. encrypted in place, without affecting this sample.
+  scoped_refptr<MediaSample> Clone() const;
+
   int64_t dts() const {
     DCHECK(!end_of_stream());
     return dts_;
@@ -120,10 +145,20 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
 
   void set_data(const uint8_t* data, const size_t data_size) {
     data_.assign(data, data + data_size);
+    UpdateCharge();
+  }
+
+  /// Replace the sample data by adopting the contents of @a data without
+  /// copying. @a data is emptied by this call.
+  void transfer_data(std::vector<uint8_t>* data) {
+    data_.swap(*data);
+    data->clear();
+    UpdateCharge();
   }
 
   void resize_data(const size_t data_size) {
     data_.resize(data_size);
+    UpdateCharge();
   }
 
   void set_is_key_frame(bool value) {
@@ -159,6 +194,12 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
   MediaSample();
   virtual ~MediaSample();
 
+  // Re-attribute the payload capacity to the allocation tracker. No-op in
+  // regular builds.
+  void UpdateCharge() {
+    charge_.UpdateTo(data_.capacity() + side_data_.capacity());
+  }
+
   // Decoding time stamp.
   int64_t dts_;
   // Presentation time stamp.
@@ -179,6 +220,11 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
   // For now this is the cue identifier for WebVTT.
   std::string config_id_;
 
+  // Optional process-wide payload buffer pool, NULL if not installed.
+  static BufferPool* buffer_pool_;
+
+  AllocationTracker::Charge charge_;
+
   DISALLOW_COPY_AND_ASSIGN(MediaSample);
 };
 
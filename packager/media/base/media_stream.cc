@@ -17,13 +17,30 @@ namespace shaka {
 namespace media {
 
 MediaStream::MediaStream(scoped_refptr<StreamInfo> info, Demuxer* demuxer)
-    : info_(info), demuxer_(demuxer), muxer_(NULL), state_(kIdle) {}
+    : info_(info),
+      demuxer_(demuxer),
+      state_(kIdle),
+      key_frame_tap_queue_(NULL),
+      key_frame_tap_skipped_(0) {}
 
-MediaStream::~MediaStream() {}
+MediaStream::~MediaStream() {
+  if (key_frame_tap_skipped_ > 0) {
+    LOG(INFO) << "Key frame tap skipped " << key_frame_tap_skipped_
+              << " key frame(s) due to backpressure.";
+  }
+}
+
+void MediaStream::InstallKeyFrameTap(
+    ProducerConsumerQueue<scoped_refptr<MediaSample> >* tap_queue) {
+  DCHECK(tap_queue);
+  DCHECK(state_ == kIdle || state_ == kConnected);
+  key_frame_tap_queue_ = tap_queue;
+}
 
 Status MediaStream::PullSample(scoped_refptr<MediaSample>* sample) {
   DCHECK_EQ(state_, kPulling);
 
+  const base::TimeTicks start = base::TimeTicks::Now();
   // Trigger a new parse in demuxer if no more samples.
   while (samples_.empty()) {
     Status status = demuxer_->Parse();
@@ -31,8 +48,11 @@ Status MediaStream::PullSample(scoped_refptr<MediaSample>* sample) {
       return status;
   }
 
-  *sample = samples_.front();
+  // Swap to take ownership of the queued reference without refcount churn.
+  sample->swap(samples_.front());
   samples_.pop_front();
+  stats_.AddSample((*sample)->end_of_stream() ? 0 : (*sample)->data_size(),
+                   base::TimeTicks::Now() - start);
   return Status::OK;
 }
 
@@ -44,8 +64,68 @@ Status MediaStream::PushSample(const scoped_refptr<MediaSample>& sample) {
       return Status::OK;
     case kDisconnected:
       return Status::OK;
-    case kPushing:
-      return muxer_->AddSample(this, sample);
+    case kPushing: {
+      const base::TimeTicks start = base::TimeTicks::Now();
+      Status status = DispatchSample(sample);
+      stats_.AddSample(sample->end_of_stream() ? 0 : sample->data_size(),
+                       base::TimeTicks::Now() - start);
+      return status;
+    }
+    default:
+      NOTREACHED() << "Unexpected State " << state_;
+      return Status::UNKNOWN;
+  }
+}
+
+Status MediaStream::PushSamples(
+    const std::deque<scoped_refptr<MediaSample> >& samples) {
+  switch (state_) {
+    case kIdle:
+    case kPulling:
+      samples_.insert(samples_.end(), samples.begin(), samples.end());
+      return Status::OK;
+    case kDisconnected:
+      return Status::OK;
+    case kPushing: {
+      const base::TimeTicks start = base::TimeTicks::Now();
+      // Offer key frames to the tap before dispatching: muxers may modify
+      // the payloads in place afterwards.
+      if (key_frame_tap_queue_) {
+        for (std::deque<scoped_refptr<MediaSample> >::const_iterator it =
+                 samples.begin();
+             it != samples.end(); ++it) {
+          if (!(*it)->end_of_stream())
+            OfferToKeyFrameTap(*it);
+        }
+      }
+      Status status;
+      if (muxers_.size() == 1) {
+        status = muxers_[0]->AddSamples(this, samples);
+      } else {
+        // Muxers may modify the sample payloads in place, e.g. encrypt them,
+        // so every muxer except the last gets its own deep copy of the batch.
+        DCHECK(!muxers_.empty());
+        for (size_t i = 0; i + 1 < muxers_.size(); ++i) {
+          std::deque<scoped_refptr<MediaSample> > copies;
+          for (std::deque<scoped_refptr<MediaSample> >::const_iterator it =
+                   samples.begin();
+               it != samples.end(); ++it) {
+            copies.push_back((*it)->Clone());
+          }
+          status.Update(muxers_[i]->AddSamples(this, copies));
+        }
+        status.Update(muxers_.back()->AddSamples(this, samples));
+      }
+      uint64_t total_bytes = 0;
+      for (std::deque<scoped_refptr<MediaSample> >::const_iterator it =
+               samples.begin();
+           it != samples.end(); ++it) {
+        if (!(*it)->end_of_stream())
+          total_bytes += (*it)->data_size();
+      }
+      stats_.AddSample(total_bytes, base::TimeTicks::Now() - start);
+      return status;
+    }
     default:
       NOTREACHED() << "Unexpected State " << state_;
       return Status::UNKNOWN;
@@ -54,9 +134,9 @@ Status MediaStream::PushSample(const scoped_refptr<MediaSample>& sample) {
 
 void MediaStream::Connect(Muxer* muxer) {
   DCHECK(muxer);
-  DCHECK(!muxer_);
+  DCHECK(state_ == kIdle || state_ == kConnected);
   state_ = kConnected;
-  muxer_ = muxer;
+  muxers_.push_back(muxer);
 }
 
 Status MediaStream::Start(MediaStreamOperation operation) {
@@ -70,11 +150,17 @@ Status MediaStream::Start(MediaStreamOperation operation) {
       samples_.clear();
       return Status::OK;
     case kConnected:
+      // A pulling muxer consumes the samples, so fan-out requires push mode.
+      if (operation == kPull && muxers_.size() > 1) {
+        return Status(error::INVALID_ARGUMENT,
+                      "A stream connected to multiple muxers cannot be "
+                      "pulled from.");
+      }
       state_ = (operation == kPush) ? kPushing : kPulling;
       if (operation == kPush) {
         // Push samples in the queue to muxer if there is any.
         while (!samples_.empty()) {
-          Status status = muxer_->AddSample(this, samples_.front());
+          Status status = DispatchSample(samples_.front());
           if (!status.ok())
             return status;
           samples_.pop_front();
@@ -98,6 +184,36 @@ Status MediaStream::Start(MediaStreamOperation operation) {
   }
 }
 
+Status MediaStream::DispatchSample(
+    const scoped_refptr<MediaSample>& sample) {
+  DCHECK(!muxers_.empty());
+  // Offer key frames to the tap before dispatching: muxers may modify the
+  // payload in place afterwards.
+  if (key_frame_tap_queue_ && !sample->end_of_stream())
+    OfferToKeyFrameTap(sample);
+  if (muxers_.size() == 1)
+    return muxers_[0]->AddSample(this, sample);
+
+  Status status;
+  for (size_t i = 0; i + 1 < muxers_.size(); ++i)
+    status.Update(muxers_[i]->AddSample(this, sample->Clone()));
+  status.Update(muxers_.back()->AddSample(this, sample));
+  return status;
+}
+
+void MediaStream::OfferToKeyFrameTap(
+    const scoped_refptr<MediaSample>& sample) {
+  DCHECK(key_frame_tap_queue_);
+  if (!sample->is_key_frame())
+    return;
+  // The tap gets its own deep copy since muxers may modify the payload in
+  // place. A zero timeout makes a full queue drop the key frame instead of
+  // blocking: the tap must never slow the mux down.
+  Status status = key_frame_tap_queue_->Push(sample->Clone(), 0);
+  if (!status.ok())
+    ++key_frame_tap_skipped_;
+}
+
 const scoped_refptr<StreamInfo> MediaStream::info() const { return info_; }
 
 std::string MediaStream::ToString() const {
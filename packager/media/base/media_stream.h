@@ -8,9 +8,12 @@
 #define MEDIA_BASE_MEDIA_STREAM_H_
 
 #include <deque>
+#include <vector>
 
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/pipeline_stats.h"
+#include "packager/media/base/producer_consumer_queue.h"
 #include "packager/media/base/status.h"
 
 namespace shaka {
@@ -22,7 +25,10 @@ class MediaSample;
 class StreamInfo;
 
 /// MediaStream connects Demuxer to Muxer. It is an abstraction for a media
-/// elementary stream.
+/// elementary stream. In push mode a stream may be connected to several
+/// muxers, e.g. a TS muxer and an MP4 muxer packaging the same content for
+/// HLS and DASH, in which case the samples are fanned out to every connected
+/// muxer and the input is demuxed and parsed only once.
 class MediaStream {
  public:
   enum MediaStreamOperation {
@@ -34,7 +40,8 @@ class MediaStream {
   MediaStream(scoped_refptr<StreamInfo> info, Demuxer* demuxer);
   ~MediaStream();
 
-  /// Connect the stream to Muxer.
+  /// Connect the stream to Muxer. May be called more than once to fan the
+  /// stream out to several muxers; fan-out is only supported in push mode.
   /// @param muxer cannot be NULL.
   void Connect(Muxer* muxer);
 
@@ -44,11 +51,35 @@ class MediaStream {
   /// Push sample to Muxer (triggered by Demuxer).
   Status PushSample(const scoped_refptr<MediaSample>& sample);
 
+  /// Push a batch of samples to Muxer in one call (triggered by Demuxer).
+  /// Batching amortizes the per-sample dispatch overhead on the push path.
+  Status PushSamples(const std::deque<scoped_refptr<MediaSample> >& samples);
+
   /// Pull sample from Demuxer (triggered by Muxer).
   Status PullSample(scoped_refptr<MediaSample>* sample);
 
+  /// Install a tap that receives a copy of every key frame sample flowing
+  /// through the stream in push mode, so downstream tooling (thumbnails,
+  /// preview sprites) can consume key frames in the same pass without a
+  /// second demux. The tap never blocks the mux: a key frame arriving while
+  /// @a tap_queue is full is skipped and counted. Install on a video stream;
+  /// on audio streams every sample is a key frame. The queue is owned by the
+  /// caller, which should Stop() it when packaging completes.
+  /// @param tap_queue is the queue receiving key frame copies. Must stay
+  ///        valid throughout the life time of the stream.
+  void InstallKeyFrameTap(
+      ProducerConsumerQueue<scoped_refptr<MediaSample> >* tap_queue);
+
+  /// @return Number of key frames skipped because the tap queue was full.
+  uint64_t key_frame_tap_skipped() const { return key_frame_tap_skipped_; }
+
   Demuxer* demuxer() { return demuxer_; }
-  Muxer* muxer() { return muxer_; }
+  const std::vector<Muxer*>& muxers() const { return muxers_; }
+
+  /// @return Stream delivery counters: samples/bytes delivered through this
+  ///         stream and time spent in the connected muxer (push mode) or
+  ///         waiting for the demuxer (pull mode).
+  const StageStats& stats() const { return stats_; }
   const scoped_refptr<StreamInfo> info() const;
 
   /// @return a human-readable string describing |*this|.
@@ -64,12 +95,25 @@ class MediaStream {
     kPulling,
   };
 
+  // Fans |sample| out to every connected muxer. Muxers may modify the sample
+  // payload in place, e.g. encrypt it, so when there are several muxers each
+  // one gets its own deep copy.
+  Status DispatchSample(const scoped_refptr<MediaSample>& sample);
+
+  // Offers a copy of |sample| to the key frame tap if it is a key frame.
+  // Never blocks; skips the sample if the tap queue is full.
+  void OfferToKeyFrameTap(const scoped_refptr<MediaSample>& sample);
+
   scoped_refptr<StreamInfo> info_;
   Demuxer* demuxer_;
-  Muxer* muxer_;
+  std::vector<Muxer*> muxers_;
   State state_;
   // An internal buffer to store samples temporarily.
   std::deque<scoped_refptr<MediaSample> > samples_;
+  StageStats stats_;
+  // Optional key frame tap, NULL if not installed. Not owned.
+  ProducerConsumerQueue<scoped_refptr<MediaSample> >* key_frame_tap_queue_;
+  uint64_t key_frame_tap_skipped_;
 
   DISALLOW_COPY_AND_ASSIGN(MediaStream);
 };
@@ -6,12 +6,55 @@
 
 #include "packager/media/base/muxer.h"
 
+#include "packager/base/time/time.h"
+#include "packager/media/base/allocation_tracker.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/media_stream.h"
+#include "packager/media/base/stream_info.h"
 
 namespace shaka {
 namespace media {
+namespace {
+
+// Cap on the rate of progress callbacks. Embedders may forward progress
+// updates over IPC, and segmenters report progress as often as once per
+// sample, which for high frame rate content is tens of thousands of callbacks
+// per job.
+const int kMaxProgressUpdatesPerSecond = 10;
+
+// ProgressListener decorator that drops updates arriving faster than the
+// configured rate. Completion (progress 1.0) is always reported.
+class RateLimitedProgressListener : public ProgressListener {
+ public:
+  RateLimitedProgressListener(scoped_ptr<ProgressListener> listener,
+                              int max_updates_per_second)
+      : listener_(listener.Pass()),
+        min_interval_(
+            base::TimeDelta::FromMilliseconds(1000 / max_updates_per_second)) {
+    DCHECK(listener_);
+  }
+  ~RateLimitedProgressListener() override {}
+
+  void OnProgress(double progress) override {
+    const base::TimeTicks now = base::TimeTicks::Now();
+    if (progress < 1.0 && !last_update_time_.is_null() &&
+        now - last_update_time_ < min_interval_) {
+      return;
+    }
+    last_update_time_ = now;
+    listener_->OnProgress(progress);
+  }
+
+ private:
+  scoped_ptr<ProgressListener> listener_;
+  const base::TimeDelta min_interval_;
+  base::TimeTicks last_update_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(RateLimitedProgressListener);
+};
+
+}  // namespace
 
 Muxer::Muxer(const MuxerOptions& options)
     : options_(options),
@@ -48,6 +91,7 @@ void Muxer::AddStream(MediaStream* stream) {
 Status Muxer::Run() {
   DCHECK(!streams_.empty());
 
+  ScopedAllocationScope allocation_scope(AllocationTracker::kScopeMuxer);
   Status status;
   // Start the streams.
   for (std::vector<MediaStream*>::iterator it = streams_.begin();
@@ -76,7 +120,24 @@ Status Muxer::Run() {
     }
   }
   // Finalize the muxer after reaching end of stream.
-  return status.error_code() == error::END_OF_STREAM ? Finalize() : status;
+  if (status.error_code() == error::END_OF_STREAM) {
+    status = FlushTrickPlaySamples();
+    if (status.ok())
+      status = Finalize();
+  }
+  VLOG(1) << stats_.ToString("mux[" + options_.output_file_name + "]");
+  return status;
+}
+
+Status Muxer::Flush() {
+  // Nothing is buffered before the muxer is initialized.
+  if (!initialized_)
+    return Status::OK;
+  return DoFlush();
+}
+
+Status Muxer::DoFlush() {
+  return Status::OK;
 }
 
 void Muxer::Cancel() {
@@ -89,11 +150,16 @@ void Muxer::SetMuxerListener(scoped_ptr<MuxerListener> muxer_listener) {
 
 void Muxer::SetProgressListener(
     scoped_ptr<ProgressListener> progress_listener) {
-  progress_listener_ = progress_listener.Pass();
+  if (!progress_listener) {
+    progress_listener_.reset();
+    return;
+  }
+  progress_listener_.reset(new RateLimitedProgressListener(
+      progress_listener.Pass(), kMaxProgressUpdatesPerSecond));
 }
 
 Status Muxer::AddSample(const MediaStream* stream,
-                        scoped_refptr<MediaSample> sample) {
+                        const scoped_refptr<MediaSample>& sample) {
   DCHECK(std::find(streams_.begin(), streams_.end(), stream) != streams_.end());
 
   if (!initialized_) {
@@ -106,12 +172,177 @@ Status Muxer::AddSample(const MediaStream* stream,
     // EOS sample should be sent only when the sample was pushed from Demuxer
     // to Muxer. In this case, there should be only one stream in Muxer.
     DCHECK_EQ(1u, streams_.size());
+    Status status = FlushTrickPlaySamples();
+    if (!status.ok())
+      return status;
     return Finalize();
   } else if (sample->is_encrypted()) {
     LOG(ERROR) << "Unable to multiplex encrypted media sample";
     return Status(error::INTERNAL_ERROR, "Encrypted media sample.");
   }
-  return DoAddSample(stream, sample);
+  if (!InShardRange(stream, sample))
+    return Status::OK;
+  if (options_.trick_play_factor > 0) {
+    scoped_refptr<MediaSample> trick_play_sample;
+    if (!FilterTrickPlaySample(stream, sample, &trick_play_sample))
+      return Status::OK;
+    const base::TimeTicks start = base::TimeTicks::Now();
+    Status status = DoAddSample(stream, trick_play_sample);
+    stats_.AddSample(trick_play_sample->data_size(),
+                     base::TimeTicks::Now() - start);
+    return status;
+  }
+  const base::TimeTicks start = base::TimeTicks::Now();
+  Status status = DoAddSample(stream, sample);
+  stats_.AddSample(sample->data_size(), base::TimeTicks::Now() - start);
+  return status;
+}
+
+Status Muxer::AddSamples(
+    const MediaStream* stream,
+    const std::deque<scoped_refptr<MediaSample> >& samples) {
+  DCHECK(std::find(streams_.begin(), streams_.end(), stream) != streams_.end());
+
+  if (samples.empty())
+    return Status::OK;
+  if (!initialized_) {
+    Status status = Initialize();
+    if (!status.ok())
+      return status;
+    initialized_ = true;
+  }
+
+  std::deque<scoped_refptr<MediaSample> > batch;
+  for (std::deque<scoped_refptr<MediaSample> >::const_iterator it =
+           samples.begin();
+       it != samples.end(); ++it) {
+    if ((*it)->end_of_stream()) {
+      // EOS sample should be sent only when the sample was pushed from Demuxer
+      // to Muxer. In this case, there should be only one stream in Muxer.
+      DCHECK_EQ(1u, streams_.size());
+      if (!batch.empty()) {
+        Status status = DoAddSamples(stream, batch);
+        if (!status.ok())
+          return status;
+      }
+      Status status = FlushTrickPlaySamples();
+      if (!status.ok())
+        return status;
+      return Finalize();
+    } else if ((*it)->is_encrypted()) {
+      LOG(ERROR) << "Unable to multiplex encrypted media sample";
+      return Status(error::INTERNAL_ERROR, "Encrypted media sample.");
+    }
+    if (!InShardRange(stream, *it))
+      continue;
+    if (options_.trick_play_factor > 0) {
+      scoped_refptr<MediaSample> trick_play_sample;
+      if (FilterTrickPlaySample(stream, *it, &trick_play_sample))
+        batch.push_back(trick_play_sample);
+      continue;
+    }
+    batch.push_back(*it);
+  }
+  uint64_t total_bytes = 0;
+  for (std::deque<scoped_refptr<MediaSample> >::const_iterator it =
+           batch.begin();
+       it != batch.end(); ++it) {
+    total_bytes += (*it)->data_size();
+  }
+  const base::TimeTicks start = base::TimeTicks::Now();
+  Status status = DoAddSamples(stream, batch);
+  stats_.AddSample(total_bytes, base::TimeTicks::Now() - start);
+  return status;
+}
+
+bool Muxer::InShardRange(const MediaStream* stream,
+                         const scoped_refptr<MediaSample>& sample) {
+  const double start = options_.shard_start_seconds;
+  const double end = options_.shard_end_seconds;
+  if (end <= start)
+    return true;
+
+  const double timestamp_in_seconds =
+      static_cast<double>(sample->pts()) / stream->info()->time_scale();
+  if (timestamp_in_seconds < start || timestamp_in_seconds >= end)
+    return false;
+
+  // A shard's video output has to start at a key frame to be decodable on
+  // its own; the coordinator is expected to pick range boundaries at key
+  // frames, anything before the first one in range is dropped.
+  if (stream->info()->stream_type() == kStreamVideo &&
+      shard_started_streams_.count(stream) == 0) {
+    if (!sample->is_key_frame())
+      return false;
+    shard_started_streams_.insert(stream);
+  }
+  return true;
+}
+
+bool Muxer::FilterTrickPlaySample(const MediaStream* stream,
+                                  const scoped_refptr<MediaSample>& sample,
+                                  scoped_refptr<MediaSample>* output) {
+  DCHECK_GT(options_.trick_play_factor, 0u);
+  // Only video streams have key frames to thin out; anything else goes
+  // through untouched.
+  if (stream->info()->stream_type() != kStreamVideo) {
+    *output = sample;
+    return true;
+  }
+
+  TrickPlayState& state = trick_play_states_[stream];
+  const bool kept_key_frame =
+      sample->is_key_frame() &&
+      state.key_frames_seen++ % options_.trick_play_factor == 0;
+  if (!kept_key_frame) {
+    // Fold the dropped frame's duration into the held key frame so the
+    // trick play timeline stays gapless. The sample is this muxer's own
+    // copy when the stream is fanned out, so extending it in place does
+    // not affect the main track.
+    if (state.held_sample) {
+      state.held_sample->set_duration(state.held_sample->duration() +
+                                      sample->duration());
+    }
+    return false;
+  }
+
+  if (!state.held_sample) {
+    state.held_sample = sample;
+    return false;
+  }
+  output->swap(state.held_sample);
+  state.held_sample = sample;
+  return true;
+}
+
+Status Muxer::FlushTrickPlaySamples() {
+  if (options_.trick_play_factor == 0)
+    return Status::OK;
+  for (std::map<const MediaStream*, TrickPlayState>::iterator it =
+           trick_play_states_.begin();
+       it != trick_play_states_.end(); ++it) {
+    if (!it->second.held_sample)
+      continue;
+    Status status = DoAddSample(it->first, it->second.held_sample);
+    it->second.held_sample = NULL;
+    if (!status.ok())
+      return status;
+  }
+  return Status::OK;
+}
+
+Status Muxer::DoAddSamples(
+    const MediaStream* stream,
+    const std::deque<scoped_refptr<MediaSample> >& samples) {
+  Status status;
+  for (std::deque<scoped_refptr<MediaSample> >::const_iterator it =
+           samples.begin();
+       it != samples.end(); ++it) {
+    status = DoAddSample(stream, *it);
+    if (!status.ok())
+      return status;
+  }
+  return status;
 }
 
 }  // namespace media
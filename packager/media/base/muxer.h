@@ -9,6 +9,9 @@
 #ifndef MEDIA_BASE_MUXER_H_
 #define MEDIA_BASE_MUXER_H_
 
+#include <deque>
+#include <map>
+#include <set>
 #include <vector>
 
 #include "packager/base/memory/ref_counted.h"
@@ -16,6 +19,7 @@
 #include "packager/base/time/clock.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/muxer_options.h"
+#include "packager/media/base/pipeline_stats.h"
 #include "packager/media/base/status.h"
 #include "packager/media/event/muxer_listener.h"
 #include "packager/media/event/progress_listener.h"
@@ -59,6 +63,12 @@ class Muxer {
   /// Drive the remuxing from muxer side (pull).
   Status Run();
 
+  /// Flush buffered samples to the output without finalizing the muxer. The
+  /// current fragment/segment is cut short so its samples reach the output
+  /// now instead of at Finalize, which bounds end-of-stream latency. Safe to
+  /// call repeatedly; more samples may be added afterwards.
+  Status Flush();
+
   /// Cancel a muxing job in progress. Will cause @a Run to exit with an error
   /// status of type CANCELLED.
   void Cancel();
@@ -67,12 +77,19 @@ class Muxer {
   /// @param muxer_listener should not be NULL.
   void SetMuxerListener(scoped_ptr<MuxerListener> muxer_listener);
 
-  /// Set a ProgressListener event handler for this object.
+  /// Set a ProgressListener event handler for this object. Progress updates
+  /// are rate limited: the listener receives a bounded number of updates per
+  /// second no matter how often the segmenter reports progress, though
+  /// completion is always reported.
   /// @param progress_listener should not be NULL.
   void SetProgressListener(scoped_ptr<ProgressListener> progress_listener);
 
   const std::vector<MediaStream*>& streams() const { return streams_; }
 
+  /// @return Mux stage counters: samples/bytes muxed and time spent in the
+  ///         muxer implementation. Meaningful after muxing has finished.
+  const StageStats& stats() const { return stats_; }
+
   /// Inject clock, mainly used for testing.
   /// The injected clock will be used to generate the creation time-stamp and
   /// modification time-stamp of the muxer output.
@@ -103,7 +120,12 @@ class Muxer {
 
   // Add new media sample.
   Status AddSample(const MediaStream* stream,
-                   scoped_refptr<MediaSample> sample);
+                   const scoped_refptr<MediaSample>& sample);
+
+  // Add a batch of media samples with one virtual dispatch. EOS and
+  // encryption checks are applied per sample as in AddSample.
+  Status AddSamples(const MediaStream* stream,
+                    const std::deque<scoped_refptr<MediaSample> >& samples);
 
   // Initialize the muxer.
   virtual Status Initialize() = 0;
@@ -111,9 +133,38 @@ class Muxer {
   // Final clean up.
   virtual Status Finalize() = 0;
 
+  // Flush implementation. The default is a no-op, which is correct for
+  // muxers that do not buffer samples across AddSample calls.
+  virtual Status DoFlush();
+
   // AddSample implementation.
   virtual Status DoAddSample(const MediaStream* stream,
-                             scoped_refptr<MediaSample> sample) = 0;
+                             const scoped_refptr<MediaSample>& sample) = 0;
+
+  // AddSamples implementation. The default implementation loops over
+  // DoAddSample; muxers with a cheaper batch path may override it.
+  virtual Status DoAddSamples(
+      const MediaStream* stream,
+      const std::deque<scoped_refptr<MediaSample> >& samples);
+
+  // @return true if @a sample falls inside the shard time range configured
+  //         in the muxer options (always true when sharding is disabled).
+  //         Video samples in range are additionally held back until the
+  //         first key frame of the shard has been seen.
+  bool InShardRange(const MediaStream* stream,
+                    const scoped_refptr<MediaSample>& sample);
+
+  // Trick play filtering (MuxerOptions::trick_play_factor). Key frames are
+  // held back one step so the duration of dropped frames can be folded into
+  // the frame preceding them, keeping the timeline gapless.
+  // @return true with |*output| set when a sample is released downstream;
+  //         false when |sample| was absorbed into the held key frame.
+  bool FilterTrickPlaySample(const MediaStream* stream,
+                             const scoped_refptr<MediaSample>& sample,
+                             scoped_refptr<MediaSample>* output);
+  // Release the key frames still held by trick play filtering. Called on
+  // end of stream before Finalize().
+  Status FlushTrickPlaySamples();
 
   MuxerOptions options_;
   bool initialized_;
@@ -124,6 +175,20 @@ class Muxer {
   double crypto_period_duration_in_seconds_;
   FourCC protection_scheme_;
   bool cancelled_;
+  StageStats stats_;
+
+  // Streams that have emitted their first in-shard key frame. Only used
+  // when a shard time range is configured.
+  std::set<const MediaStream*> shard_started_streams_;
+
+  // Per-stream trick play filtering state. Only used when trick_play_factor
+  // is nonzero.
+  struct TrickPlayState {
+    TrickPlayState() : key_frames_seen(0) {}
+    uint64_t key_frames_seen;
+    scoped_refptr<MediaSample> held_sample;
+  };
+  std::map<const MediaStream*, TrickPlayState> trick_play_states_;
 
   scoped_ptr<MuxerListener> muxer_listener_;
   scoped_ptr<ProgressListener> progress_listener_;
@@ -6,6 +6,17 @@
 
 #include "packager/media/base/muxer_options.h"
 
+#include "packager/base/atomicops.h"
+
+namespace {
+
+// Live segment duration override in milliseconds, shared by every muxer in
+// the process. Stored as an integer so it can be read and written atomically
+// without a lock; zero means no override.
+base::subtle::AtomicWord g_segment_duration_override_ms = 0;
+
+}  // namespace
+
 namespace shaka {
 namespace media {
 
@@ -13,12 +24,38 @@ MuxerOptions::MuxerOptions()
     : single_segment(false),
       segment_duration(0),
       fragment_duration(0),
+      audio_fragment_duration(0),
       segment_sap_aligned(false),
       fragment_sap_aligned(false),
       num_subsegments_per_sidx(0),
       mp4_use_decoding_timestamp_in_timeline(false),
-      bandwidth(0) {}
+      bandwidth(0),
+      trick_play_factor(0),
+      threaded_segment_write(false),
+      chunked_fragments(false),
+      segment_size_hint(0),
+      segment_target_size_bytes(0),
+      segment_min_duration_seconds(0),
+      shard_start_seconds(0),
+      shard_end_seconds(0),
+      initial_segment_number(0) {}
 MuxerOptions::~MuxerOptions() {}
 
+double MuxerOptions::GetEffectiveSegmentDuration() const {
+  const base::subtle::AtomicWord override_ms =
+      base::subtle::NoBarrier_Load(&g_segment_duration_override_ms);
+  if (override_ms > 0)
+    return override_ms / 1000.0;
+  return segment_duration;
+}
+
+void MuxerOptions::SetSegmentDurationOverride(double duration_in_seconds) {
+  const base::subtle::AtomicWord override_ms =
+      duration_in_seconds > 0
+          ? static_cast<base::subtle::AtomicWord>(duration_in_seconds * 1000)
+          : 0;
+  base::subtle::NoBarrier_Store(&g_segment_duration_override_ms, override_ms);
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -10,6 +10,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 namespace shaka {
 namespace media {
@@ -33,6 +34,14 @@ struct MuxerOptions {
   /// duration.
   double fragment_duration;
 
+  /// Fragment duration for audio streams, in seconds. If zero, audio uses
+  /// fragment_duration. Audio samples are tiny compared to the per-fragment
+  /// moof overhead (box serialization, per-fragment senc entries), so audio
+  /// can use a several times longer cadence than video without hurting
+  /// switching; segment boundaries still cut audio fragments short, keeping
+  /// segments aligned across streams.
+  double audio_fragment_duration;
+
   /// Force segments to begin with stream access points. Segment duration may
   /// not be exactly what specified by segment_duration.
   bool segment_sap_aligned;
@@ -73,6 +82,88 @@ struct MuxerOptions {
   /// User-specified bit rate for the media stream. If zero, the muxer will
   /// attempt to estimate.
   uint32_t bandwidth;
+
+  /// If nonzero, the muxer produces a trick play track from the video
+  /// stream: only every Nth key frame is kept and its duration is extended
+  /// to cover the dropped frames, so the timeline stays gapless. Connected
+  /// to the same MediaStream as the main track's muxer, this generates
+  /// I-frame-only renditions in the same demux pass. Non-video streams are
+  /// not affected.
+  uint32_t trick_play_factor;
+
+  /// For ISO BMFF multi-segment output only.
+  /// If true, completed segments are handed to a dedicated writer thread so
+  /// the next segment can be built while the previous one is written out.
+  /// Write errors are reported on a later segment finalization or at muxer
+  /// finalization, and segment events may fire before the segment is durable
+  /// on disk.
+  bool threaded_segment_write;
+
+  /// For ISO BMFF multi-segment output with a segment template only.
+  /// If true, each completed fragment (a moof/mdat pair) is written through
+  /// to the in-progress segment file and flushed immediately, so an origin
+  /// can deliver the segment via chunked transfer while it is still being
+  /// produced. No 'sidx' box is emitted for chunked segments, and
+  /// threaded_segment_write is ignored since segments are written
+  /// incrementally on the muxer thread.
+  bool chunked_fragments;
+
+  /// Expected segment size in bytes, used as a preallocation hint for output
+  /// files on storage that supports it, so segments are laid out in few
+  /// extents. If zero, the muxer uses the actual size of each completed
+  /// segment. The hint does not limit the actual segment size.
+  uint64_t segment_size_hint;
+
+  /// For multi-segment output only.
+  /// Target segment size in bytes. If nonzero, segments are cut at the first
+  /// key frame once the estimated segment size reaches this target instead
+  /// of waiting for segment_duration, which then serves as the upper
+  /// duration bound; segment_min_duration_seconds is the lower one. This
+  /// yields more uniform segment sizes for VBR content. Zero keeps
+  /// duration-based segmentation.
+  uint64_t segment_target_size_bytes;
+
+  /// Lower duration bound in seconds for byte-budget segmentation: a key
+  /// frame arriving earlier than this never cuts a segment even if the byte
+  /// target has been reached. Only used when segment_target_size_bytes is
+  /// nonzero.
+  double segment_min_duration_seconds;
+
+  /// Ad cue points in presentation seconds, sorted ascending. Segmenters
+  /// force a segment boundary at each cue point (at the first key frame at
+  /// or after it when SAP alignment is requested), so ad periods can be
+  /// spliced in on segment boundaries without restarting the pipeline.
+  /// Empty disables cue-driven segmentation.
+  std::vector<double> ad_cue_points_seconds;
+
+  /// Presentation time range to package, in seconds. Samples outside
+  /// [shard_start_seconds, shard_end_seconds) are dropped, so one VOD title
+  /// can be fanned out across hosts as disjoint time-range shards that share
+  /// a segment template namespace. Video output starts at the first key
+  /// frame inside the range. Disabled when shard_end_seconds <=
+  /// shard_start_seconds (the defaults).
+  double shard_start_seconds;
+  double shard_end_seconds;
+
+  /// For multi-segment output only.
+  /// Number of segments written by previous processes for this stream.
+  /// Segment numbering from segment_template starts after this value, so a
+  /// restarted live channel can resume $Number$ where the previous process
+  /// stopped. Default 0 (fresh start).
+  uint64_t initial_segment_number;
+
+  /// @return The process-wide live override if one is set (see
+  ///         SetSegmentDurationOverride), otherwise @a segment_duration.
+  ///         Segmenters consult this when deciding whether to cut a segment,
+  ///         so an override takes effect at the next segment boundary of
+  ///         every running muxer without pipeline teardown.
+  double GetEffectiveSegmentDuration() const;
+
+  /// Set or clear a process-wide segment duration override for running and
+  /// future muxers. Safe to call from any thread while jobs are running.
+  /// @param duration_in_seconds is the new segment duration; a value of zero
+  ///        or less clears the override.
+  static void SetSegmentDurationOverride(double duration_in_seconds);
 };
 
 }  // namespace media
@@ -99,10 +99,8 @@ bool ValidateSegmentTemplate(const std::string& segment_template) {
   return true;
 }
 
-std::string GetSegmentName(const std::string& segment_template,
-                           uint64_t segment_start_time,
-                           uint32_t segment_index,
-                           uint32_t bandwidth) {
+SegmentNameTemplate::SegmentNameTemplate(
+    const std::string& segment_template) {
   DCHECK(ValidateSegmentTemplate(segment_template));
 
   std::vector<std::string> splits;
@@ -110,17 +108,23 @@ std::string GetSegmentName(const std::string& segment_template,
   // "$" always appears in pairs, so there should be odd number of splits.
   DCHECK_EQ(1u, splits.size() % 2);
 
-  std::string segment_name;
   for (size_t i = 0; i < splits.size(); ++i) {
+    Piece piece;
     // Every second substring in split output should be an identifier.
-    // Simply copy the non-identifier part.
+    // Simply keep the non-identifier part as literal text.
     if (i % 2 == 0) {
-      segment_name += splits[i];
+      if (splits[i].empty())
+        continue;
+      piece.type = kLiteral;
+      piece.literal = splits[i];
+      pieces_.push_back(piece);
       continue;
     }
     if (splits[i].empty()) {
       // "$$" is an escape sequence, replaced with a single "$".
-      segment_name += "$";
+      piece.type = kLiteral;
+      piece.literal = "$";
+      pieces_.push_back(piece);
       continue;
     }
     size_t format_pos = splits[i].find('%');
@@ -128,32 +132,68 @@ std::string GetSegmentName(const std::string& segment_template,
     DCHECK(identifier == "Number" || identifier == "Time" ||
            identifier == "Bandwidth");
 
-    std::string format_tag;
     if (format_pos != std::string::npos) {
-      format_tag = splits[i].substr(format_pos);
-      DCHECK(ValidateFormatTag(format_tag));
+      piece.format_tag = splits[i].substr(format_pos);
+      DCHECK(ValidateFormatTag(piece.format_tag));
       // Replace %d formatting to correctly format uint64_t.
-      format_tag = format_tag.substr(0, format_tag.size() - 1) + PRIu64;
+      piece.format_tag =
+          piece.format_tag.substr(0, piece.format_tag.size() - 1) + PRIu64;
     } else {
       // Default format tag "%01d", modified to format uint64_t correctly.
-      format_tag = "%01" PRIu64;
+      piece.format_tag = "%01" PRIu64;
     }
 
     if (identifier == "Number") {
-      // SegmentNumber starts from 1.
-      segment_name += base::StringPrintf(
-          format_tag.c_str(), static_cast<uint64_t>(segment_index + 1));
+      piece.type = kNumber;
     } else if (identifier == "Time") {
-      segment_name +=
-          base::StringPrintf(format_tag.c_str(), segment_start_time);
-    } else if (identifier == "Bandwidth") {
-      segment_name += base::StringPrintf(format_tag.c_str(),
-                                         static_cast<uint64_t>(bandwidth));
+      piece.type = kTime;
+    } else {
+      DCHECK_EQ("Bandwidth", identifier);
+      piece.type = kBandwidth;
+    }
+    pieces_.push_back(piece);
+  }
+}
+
+SegmentNameTemplate::~SegmentNameTemplate() {}
+
+std::string SegmentNameTemplate::GetName(uint64_t segment_start_time,
+                                         uint32_t segment_index,
+                                         uint32_t bandwidth) const {
+  std::string segment_name;
+  for (size_t i = 0; i < pieces_.size(); ++i) {
+    const Piece& piece = pieces_[i];
+    switch (piece.type) {
+      case kLiteral:
+        segment_name += piece.literal;
+        break;
+      case kNumber:
+        // SegmentNumber starts from 1.
+        base::StringAppendF(&segment_name, piece.format_tag.c_str(),
+                            static_cast<uint64_t>(segment_index + 1));
+        break;
+      case kTime:
+        base::StringAppendF(&segment_name, piece.format_tag.c_str(),
+                            segment_start_time);
+        break;
+      case kBandwidth:
+        base::StringAppendF(&segment_name, piece.format_tag.c_str(),
+                            static_cast<uint64_t>(bandwidth));
+        break;
     }
   }
   return segment_name;
 }
 
+std::string GetSegmentName(const std::string& segment_template,
+                           uint64_t segment_start_time,
+                           uint32_t segment_index,
+                           uint32_t bandwidth) {
+  DCHECK(ValidateSegmentTemplate(segment_template));
+  return SegmentNameTemplate(segment_template)
+      .GetName(segment_start_time, segment_index, bandwidth);
+}
+
 KeySource::TrackType GetTrackTypeForEncryption(const StreamInfo& stream_info,
                                                uint32_t max_sd_pixels) {
   if (stream_info.stream_type() == kStreamAudio)
@@ -12,7 +12,9 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
+#include "packager/base/macros.h"
 #include "packager/media/base/key_source.h"
 
 namespace shaka {
@@ -27,7 +29,51 @@ class StreamInfo;
 //          ISO/IEC 23009-1:2012 5.3.9.4.4, false otherwise.
 bool ValidateSegmentTemplate(const std::string& segment_template);
 
-/// Build the segment name from provided input.
+/// Precompiled form of a segment name template. The template is split into
+/// literal text and identifier pieces once at construction, so building each
+/// segment name is a plain substitution instead of a parse of the template.
+/// Segmenters produce one name per segment, so this matters at short segment
+/// durations.
+class SegmentNameTemplate {
+ public:
+  /// @param segment_template is the segment template pattern, which should
+  ///        comply with ISO/IEC 23009-1:2012 5.3.9.4.4. Must be valid per
+  ///        ValidateSegmentTemplate().
+  explicit SegmentNameTemplate(const std::string& segment_template);
+  ~SegmentNameTemplate();
+
+  /// Build the segment name from provided input.
+  /// @param segment_start_time specifies the segment start time.
+  /// @param segment_index specifies the segment index.
+  /// @param bandwidth represents the bit rate, in bits/sec, of the stream.
+  /// @return The segment name with identifier substituted.
+  std::string GetName(uint64_t segment_start_time,
+                      uint32_t segment_index,
+                      uint32_t bandwidth) const;
+
+ private:
+  enum PieceType {
+    kLiteral,
+    kNumber,
+    kTime,
+    kBandwidth,
+  };
+  struct Piece {
+    PieceType type;
+    // Literal text for kLiteral pieces; empty otherwise.
+    std::string literal;
+    // printf format tag for identifier pieces; empty otherwise.
+    std::string format_tag;
+  };
+
+  std::vector<Piece> pieces_;
+
+  DISALLOW_COPY_AND_ASSIGN(SegmentNameTemplate);
+};
+
+/// Build the segment name from provided input. Parses the template on every
+/// call; prefer SegmentNameTemplate when generating many names from the same
+/// template.
 /// @param segment_template is the segment template pattern, which should
 ///        comply with ISO/IEC 23009-1:2012 5.3.9.4.4.
 /// @param segment_start_time specifies the segment start time.
@@ -153,5 +153,24 @@ TEST(MuxerUtilTest, GetSegmentNameLargeTime) {
                            kBandwidth));
 }
 
+TEST(MuxerUtilTest, SegmentNameTemplateReuse) {
+  const uint32_t kBandwidth = 1234;
+
+  // A precompiled template produces the same names as GetSegmentName() when
+  // reused across segments.
+  SegmentNameTemplate name_template("foo$$_$Number%03d$-$Bandwidth$.m4s");
+  for (uint32_t segment_index = 0; segment_index < 5; ++segment_index) {
+    const uint64_t segment_start_time = segment_index * 90000;
+    EXPECT_EQ(GetSegmentName("foo$$_$Number%03d$-$Bandwidth$.m4s",
+                             segment_start_time, segment_index, kBandwidth),
+              name_template.GetName(segment_start_time, segment_index,
+                                    kBandwidth));
+  }
+
+  SegmentNameTemplate time_template("$Time$.ts");
+  EXPECT_EQ("1601599839840.ts",
+            time_template.GetName(1601599839840ULL, 0, kBandwidth));
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -11,7 +11,8 @@
 namespace shaka {
 namespace media {
 
-OffsetByteQueue::OffsetByteQueue() : buf_(NULL), size_(0), head_(0) {}
+OffsetByteQueue::OffsetByteQueue()
+    : buf_(NULL), size_(0), head_(0), pin_offset_(-1) {}
 OffsetByteQueue::~OffsetByteQueue() {}
 
 void OffsetByteQueue::Reset() {
@@ -19,6 +20,7 @@ void OffsetByteQueue::Reset() {
   buf_ = NULL;
   size_ = 0;
   head_ = 0;
+  pin_offset_ = -1;
 }
 
 void OffsetByteQueue::Push(const uint8_t* buf, int size) {
@@ -49,6 +51,9 @@ void OffsetByteQueue::PeekAt(int64_t offset, const uint8_t** buf, int* size) {
 }
 
 bool OffsetByteQueue::Trim(int64_t max_offset) {
+  // Keep pinned bytes buffered; the caller gets them back via Unpin().
+  if (pin_offset_ >= 0 && max_offset > pin_offset_)
+    max_offset = pin_offset_;
   if (max_offset < head_) return true;
   if (max_offset > tail()) {
     Pop(size_);
@@ -58,6 +63,16 @@ bool OffsetByteQueue::Trim(int64_t max_offset) {
   return true;
 }
 
+bool OffsetByteQueue::PinAt(int64_t offset) {
+  if (offset < head()) return false;
+  pin_offset_ = offset;
+  return true;
+}
+
+void OffsetByteQueue::Unpin() {
+  pin_offset_ = -1;
+}
+
 void OffsetByteQueue::Sync() {
   queue_.Peek(&buf_, &size_);
 }
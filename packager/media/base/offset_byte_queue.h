@@ -46,8 +46,27 @@ class OffsetByteQueue {
   ///         head.
   /// @return false if @a max_offset > tail() (although all bytes currently
   ///         buffered are still cleared).
+  ///
+  /// If a pin is active (see PinAt), trimming stops at the pin offset and
+  /// the pinned bytes stay buffered.
   bool Trim(int64_t max_offset);
 
+  /// Pin the bytes at and after @a offset: Trim() will not discard them
+  /// regardless of the trim offset, so spans starting at @a offset can be
+  /// re-resolved with PeekAt() across Parse calls without copying them out
+  /// while the rest of the queue is recycled. The offset may be beyond
+  /// tail() to pin data that has not been pushed yet. Only one pin is active
+  /// at a time; pinning again moves the pin. Pointers returned by Peek() and
+  /// PeekAt() are still only valid until the next Push() or Pop(); callers
+  /// must re-resolve them after mutating the queue.
+  /// @return true on success, false if @a offset is before the current head
+  ///         (those bytes are already gone).
+  bool PinAt(int64_t offset);
+
+  /// Release the pin set by PinAt(). The retained bytes become eligible for
+  /// the next Trim(). No-op if nothing is pinned.
+  void Unpin();
+
   /// @return The head position, in terms of the file's absolute offset.
   int64_t head() { return head_; }
   /// @return The tail position (exclusive), in terms of the file's absolute
@@ -62,6 +81,8 @@ class OffsetByteQueue {
   const uint8_t* buf_;
   int size_;
   int64_t head_;
+  // Absolute offset of the active pin, or -1 if nothing is pinned.
+  int64_t pin_offset_;
 
   DISALLOW_COPY_AND_ASSIGN(OffsetByteQueue);
 };
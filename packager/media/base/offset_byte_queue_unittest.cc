@@ -90,5 +90,51 @@ TEST_F(OffsetByteQueueTest, Trim) {
   EXPECT_TRUE(queue_->Trim(512));
 }
 
+TEST_F(OffsetByteQueueTest, PinAt) {
+  // Pinning before the head fails; those bytes are already gone.
+  EXPECT_FALSE(queue_->PinAt(256));
+
+  EXPECT_TRUE(queue_->PinAt(400));
+
+  // Trims stop at the pin offset, so the pinned span stays addressable.
+  EXPECT_TRUE(queue_->Trim(480));
+  EXPECT_EQ(400, queue_->head());
+
+  const uint8_t* buf;
+  int size;
+  queue_->PeekAt(400, &buf, &size);
+  EXPECT_EQ(queue_->tail() - 400, size);
+  EXPECT_EQ(400 - 256, buf[0]);
+
+  // Trims below the pin are unaffected.
+  EXPECT_TRUE(queue_->Trim(300));
+  EXPECT_EQ(400, queue_->head());
+
+  // After Unpin() the retained bytes are trimmable again.
+  queue_->Unpin();
+  EXPECT_TRUE(queue_->Trim(480));
+  EXPECT_EQ(480, queue_->head());
+}
+
+TEST_F(OffsetByteQueueTest, PinBeyondTail) {
+  // A pin beyond the tail protects bytes that have not been pushed yet.
+  EXPECT_TRUE(queue_->PinAt(600));
+  EXPECT_FALSE(queue_->Trim(700));
+  EXPECT_EQ(512, queue_->head());
+
+  uint8_t buf[256];
+  for (int i = 0; i < 256; i++) {
+    buf[i] = i;
+  }
+  queue_->Push(buf, sizeof(buf));
+  EXPECT_TRUE(queue_->Trim(700));
+  EXPECT_EQ(600, queue_->head());
+
+  const uint8_t* data;
+  int size;
+  queue_->PeekAt(600, &data, &size);
+  EXPECT_EQ(queue_->tail() - 600, size);
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -0,0 +1,44 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/pipeline_stats.h"
+
+#include <inttypes.h>
+
+#include "packager/base/strings/stringprintf.h"
+
+namespace shaka {
+namespace media {
+
+StageStats::StageStats() : num_samples(0), total_bytes(0) {}
+
+void StageStats::AddSample(uint64_t num_bytes, base::TimeDelta elapsed) {
+  ++num_samples;
+  total_bytes += num_bytes;
+  processing_time += elapsed;
+  if (elapsed > max_sample_time)
+    max_sample_time = elapsed;
+}
+
+double StageStats::bytes_per_second() const {
+  const double seconds = processing_time.InSecondsF();
+  if (seconds <= 0)
+    return 0;
+  return total_bytes / seconds;
+}
+
+std::string StageStats::ToString(const std::string& stage_name) const {
+  return base::StringPrintf(
+      "%s: samples=%" PRIu64 " bytes=%" PRIu64
+      " processing_time_ms=%" PRId64 " max_sample_time_us=%" PRId64
+      " throughput_MBps=%.2f",
+      stage_name.c_str(), num_samples, total_bytes,
+      processing_time.InMilliseconds(), max_sample_time.InMicroseconds(),
+      bytes_per_second() / (1024 * 1024));
+}
+
+}  // namespace media
+}  // namespace shaka
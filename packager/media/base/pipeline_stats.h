@@ -0,0 +1,46 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_PIPELINE_STATS_H_
+#define MEDIA_BASE_PIPELINE_STATS_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "packager/base/time/time.h"
+
+namespace shaka {
+namespace media {
+
+/// Throughput and latency counters for one pipeline stage (demux, stream
+/// fan-out, mux). Counters are updated from the stage's own thread and are
+/// meant to be read after the stage has finished or from the same thread.
+struct StageStats {
+  StageStats();
+
+  /// Record that @a num_bytes of sample data spent @a elapsed in this stage.
+  void AddSample(uint64_t num_bytes, base::TimeDelta elapsed);
+
+  /// @return Throughput in bytes per second over the accumulated processing
+  ///         time, or 0 if nothing has been recorded.
+  double bytes_per_second() const;
+
+  /// @return a human-readable one line summary, prefixed with @a stage_name.
+  std::string ToString(const std::string& stage_name) const;
+
+  uint64_t num_samples;
+  uint64_t total_bytes;
+  // Total time spent processing samples in this stage.
+  base::TimeDelta processing_time;
+  // Largest single-sample processing time seen.
+  base::TimeDelta max_sample_time;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_PIPELINE_STATS_H_
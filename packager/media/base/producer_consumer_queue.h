@@ -164,7 +164,7 @@ Status ProducerConsumerQueue<T>::Push(const T& element, int64_t timeout_ms) {
 
   // Check for queue shutdown.
   if (stop_requested_)
-    return Status(error::STOPPED, "");
+    return Status(error::STOPPED);
 
   base::ElapsedTimer timer;
   base::TimeDelta timeout_delta = base::TimeDelta::FromMilliseconds(timeout_ms);
@@ -181,12 +181,12 @@ Status ProducerConsumerQueue<T>::Push(const T& element, int64_t timeout_ms) {
           not_full_cv_.TimedWait(timeout_delta - elapsed);
         } else {
           // We're through waiting.
-          return Status(error::TIME_OUT, "Time out on pushing.");
+          return Status(error::TIME_OUT);
         }
       }
       // Re-check for queue shutdown after waking from Wait.
       if (stop_requested_)
-        return Status(error::STOPPED, "");
+        return Status(error::STOPPED);
 
       woken = true;
     }
@@ -216,7 +216,7 @@ Status ProducerConsumerQueue<T>::Pop(T* element, int64_t timeout_ms) {
 
   while (q_.empty()) {
     if (stop_requested_)
-      return Status(error::STOPPED, "");
+      return Status(error::STOPPED);
 
     if (timeout_ms < 0) {
       // Wait forever, or until Stop.
@@ -228,7 +228,7 @@ Status ProducerConsumerQueue<T>::Pop(T* element, int64_t timeout_ms) {
         not_empty_cv_.TimedWait(timeout_delta - elapsed);
       } else {
         // We're through waiting.
-        return Status(error::TIME_OUT, "Time out on popping.");
+        return Status(error::TIME_OUT);
       }
     }
     woken = true;
@@ -270,7 +270,7 @@ Status ProducerConsumerQueue<T>::Peek(size_t pos,
 
   while (pos >= head_pos_ + q_.size()) {
     if (stop_requested_)
-      return Status(error::STOPPED, "");
+      return Status(error::STOPPED);
 
     if (timeout_ms < 0) {
       // Wait forever, or until Stop.
@@ -282,7 +282,7 @@ Status ProducerConsumerQueue<T>::Peek(size_t pos,
         new_element_cv_.TimedWait(timeout_delta - elapsed);
       } else {
         // We're through waiting.
-        return Status(error::TIME_OUT, "Time out on peeking.");
+        return Status(error::TIME_OUT);
       }
     }
     // Move head to create some space (move the sliding window centered @ pos).
@@ -47,6 +47,7 @@ bool ProtectionSystemSpecificInfo::Parse(const uint8_t* data,
   uint32_t box_type;
   uint32_t version_and_flags;
   BufferReader reader(data, data_size);
+  cached_box_.clear();
 
   RCHECK(reader.Read4(&size));
   RCHECK(reader.Read4(&box_type));
@@ -80,9 +81,12 @@ bool ProtectionSystemSpecificInfo::Parse(const uint8_t* data,
   return true;
 }
 
-std::vector<uint8_t> ProtectionSystemSpecificInfo::CreateBox() const {
+const std::vector<uint8_t>& ProtectionSystemSpecificInfo::CreateBox() const {
   DCHECK_EQ(kSystemIdSize, system_id_.size());
 
+  if (!cached_box_.empty())
+    return cached_box_;
+
   const uint32_t box_type = FOURCC_pssh;
   const uint32_t version_and_flags = (static_cast<uint32_t>(version_) << 24);
   const uint32_t pssh_data_size = pssh_data_.size();
@@ -112,7 +116,8 @@ std::vector<uint8_t> ProtectionSystemSpecificInfo::CreateBox() const {
   writer.AppendVector(pssh_data_);
 
   DCHECK_EQ(total_size, writer.Size());
-  return std::vector<uint8_t>(writer.Buffer(), writer.Buffer() + writer.Size());
+  cached_box_.assign(writer.Buffer(), writer.Buffer() + writer.Size());
+  return cached_box_;
 }
 
 }  // namespace media
@@ -33,8 +33,13 @@ class ProtectionSystemSpecificInfo {
   /// @return true on success; false on failure.
   bool Parse(const uint8_t* data, size_t data_size);
 
-  /// Creates a PSSH box for the current data.
-  std::vector<uint8_t> CreateBox() const;
+  /// Creates a PSSH box for the current data. The serialized box is cached in
+  /// this object (and travels with copies of it), so repeated calls — e.g.
+  /// once per key rotation fragment, or from several muxers packaging
+  /// renditions that share the same keys — do not re-serialize the box. The
+  /// returned reference points at the cache and is valid until a field of
+  /// this object changes; callers that need the bytes beyond that must copy.
+  const std::vector<uint8_t>& CreateBox() const;
 
   uint8_t pssh_box_version() const { return version_; }
   const std::vector<uint8_t>& system_id() const { return system_id_; }
@@ -44,18 +49,25 @@ class ProtectionSystemSpecificInfo {
   void set_pssh_box_version(uint8_t version) {
     DCHECK_LT(version, 2);
     version_ = version;
+    cached_box_.clear();
   }
   void set_system_id(const uint8_t* system_id, size_t system_id_size) {
     DCHECK_EQ(16u, system_id_size);
     system_id_.assign(system_id, system_id + system_id_size);
+    cached_box_.clear();
   }
   void add_key_id(const std::vector<uint8_t>& key_id) {
     DCHECK_EQ(16u, key_id.size());
     key_ids_.push_back(key_id);
+    cached_box_.clear();
+  }
+  void clear_key_ids() {
+    key_ids_.clear();
+    cached_box_.clear();
   }
-  void clear_key_ids() { key_ids_.clear(); }
   void set_pssh_data(const std::vector<uint8_t>& pssh_data) {
     pssh_data_ = pssh_data;
+    cached_box_.clear();
   }
 
  private:
@@ -63,6 +75,9 @@ class ProtectionSystemSpecificInfo {
   std::vector<uint8_t> system_id_;
   std::vector<std::vector<uint8_t>> key_ids_;
   std::vector<uint8_t> pssh_data_;
+  // Serialized pssh box, built lazily by CreateBox() and cleared whenever a
+  // field changes.
+  mutable std::vector<uint8_t> cached_box_;
 
   // Don't use DISALLOW_COPY_AND_ASSIGN since the data stored here should be
   // small, so the performance impact should be minimal.
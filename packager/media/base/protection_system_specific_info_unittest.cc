@@ -126,6 +126,22 @@ TEST_F(PsshTest, CreateBox_MakesV0Boxes) {
   EXPECT_EQ(v0_box_, info.CreateBox());
 }
 
+TEST_F(PsshTest, CreateBox_CachedBoxFollowsFieldChanges) {
+  ProtectionSystemSpecificInfo info;
+  info.set_system_id(kTestSystemIdArray, arraysize(kTestSystemIdArray));
+  info.set_pssh_data(test_pssh_data_);
+  info.set_pssh_box_version(0);
+
+  // Repeated calls serve the cached serialization.
+  EXPECT_EQ(v0_box_, info.CreateBox());
+  EXPECT_EQ(v0_box_, info.CreateBox());
+
+  // Changing a field invalidates the cached box.
+  info.add_key_id(test_key_id_);
+  info.set_pssh_box_version(1);
+  EXPECT_EQ(v1_box_, info.CreateBox());
+}
+
 TEST_F(PsshTest, CreateBox_MakesV1Boxes) {
   ProtectionSystemSpecificInfo info;
   info.add_key_id(test_key_id_);
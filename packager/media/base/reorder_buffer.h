@@ -0,0 +1,237 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_REORDER_BUFFER_H_
+#define MEDIA_BASE_REORDER_BUFFER_H_
+
+#include <map>
+
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/timer/elapsed_timer.h"
+#include "packager/media/base/status.h"
+
+namespace shaka {
+namespace media {
+
+/// A thread safe buffer restoring sequence order over elements completed out
+/// of order, e.g. by a pool of worker threads. Producers post each element
+/// with the sequence number assigned to it on dispatch; the consumer pops
+/// elements in strict sequence order. Memory is bounded by a sequence window:
+/// posting an element @a capacity or more sequence numbers ahead of the next
+/// undelivered one blocks until the consumer catches up. The element that
+/// unblocks the consumer is always inside the window, so posting cannot
+/// deadlock. Companion to ProducerConsumerQueue, which keeps arrival order
+/// instead.
+template <class T>
+class ReorderBuffer {
+ public:
+  /// Create a ReorderBuffer expecting sequence number 0 first.
+  /// @param capacity is the size of the sequence window, i.e. the maximum
+  ///        number of elements that can be pending at once. A value of zero
+  ///        means unlimited capacity.
+  explicit ReorderBuffer(size_t capacity);
+
+  /// Create a ReorderBuffer expecting the indicated sequence number first.
+  /// @param capacity is the size of the sequence window, i.e. the maximum
+  ///        number of elements that can be pending at once. A value of zero
+  ///        means unlimited capacity.
+  /// @param starting_sequence is the first sequence number to be delivered.
+  ReorderBuffer(size_t capacity, size_t starting_sequence);
+
+  ~ReorderBuffer();
+
+  /// Post a completed element. If @a sequence is outside the sequence window,
+  /// block until the consumer catches up or time out or stopped.
+  /// @param sequence is the sequence number assigned to the element.
+  /// @param element refers to the element to be posted.
+  /// @param timeout_ms indicates timeout in milliseconds. A value of zero
+  ///        means return immediately. A negative value means waiting
+  ///        indefinitely.
+  /// @return OK if the element was posted successfully, INVALID_ARGUMENT if
+  ///         @a sequence was already delivered or posted, STOPPED if Stop has
+  ///         been called, TIME_OUT if times out.
+  Status Post(size_t sequence, const T& element, int64_t timeout_ms);
+
+  /// Pop the element carrying the next sequence number. If it has not been
+  /// posted yet, block until it is or time out or stopped.
+  /// @param[out] element receives the popped element.
+  /// @param timeout_ms indicates timeout in milliseconds. A value of zero
+  ///        means return immediately. A negative value means waiting
+  ///        indefinitely.
+  /// @return STOPPED if Stop has been called and the next element in sequence
+  ///         is not available, TIME_OUT if times out, OK otherwise.
+  Status Pop(T* element, int64_t timeout_ms);
+
+  /// Terminate Pop requests once the elements consumable in order are
+  /// drained. Also terminate all waiting and future Post requests
+  /// immediately. Stop cannot stall.
+  void Stop() {
+    base::AutoLock l(lock_);
+    stop_requested_ = true;
+    next_element_cv_.Broadcast();
+    not_full_cv_.Broadcast();
+  }
+
+  /// @return true if there are no pending elements.
+  bool Empty() const {
+    base::AutoLock l(lock_);
+    return pending_.empty();
+  }
+
+  /// @return The number of pending elements, delivered and not.
+  size_t Size() const {
+    base::AutoLock l(lock_);
+    return pending_.size();
+  }
+
+  /// @return The sequence number the next Pop will deliver.
+  size_t NextSequence() const {
+    base::AutoLock l(lock_);
+    return next_sequence_;
+  }
+
+  /// @return true if the buffer has been stopped using Stop(). This allows
+  ///         producers to check if they can post new elements.
+  bool Stopped() const {
+    base::AutoLock l(lock_);
+    return stop_requested_;
+  }
+
+ private:
+  const size_t capacity_;  // Sequence window size; zero means unlimited.
+  mutable base::Lock lock_;  // Lock protecting all other variables below.
+  size_t next_sequence_;     // Sequence number the next Pop delivers.
+  std::map<size_t, T> pending_;  // Posted elements keyed by sequence number.
+  base::ConditionVariable next_element_cv_;
+  base::ConditionVariable not_full_cv_;
+  bool stop_requested_;  // True after Stop has been called.
+
+  DISALLOW_COPY_AND_ASSIGN(ReorderBuffer);
+};
+
+// Implementations of non-inline functions.
+template <class T>
+ReorderBuffer<T>::ReorderBuffer(size_t capacity)
+    : capacity_(capacity),
+      next_sequence_(0),
+      next_element_cv_(&lock_),
+      not_full_cv_(&lock_),
+      stop_requested_(false) {}
+
+template <class T>
+ReorderBuffer<T>::ReorderBuffer(size_t capacity, size_t starting_sequence)
+    : capacity_(capacity),
+      next_sequence_(starting_sequence),
+      next_element_cv_(&lock_),
+      not_full_cv_(&lock_),
+      stop_requested_(false) {}
+
+template <class T>
+ReorderBuffer<T>::~ReorderBuffer() {}
+
+template <class T>
+Status ReorderBuffer<T>::Post(size_t sequence,
+                              const T& element,
+                              int64_t timeout_ms) {
+  base::AutoLock l(lock_);
+
+  // Check for buffer shutdown.
+  if (stop_requested_)
+    return Status(error::STOPPED);
+
+  if (sequence < next_sequence_) {
+    return Status(error::INVALID_ARGUMENT,
+                  base::StringPrintf(
+                      "sequence (%zu) was already delivered; expecting %zu "
+                      "or later.",
+                      sequence, next_sequence_));
+  }
+
+  base::ElapsedTimer timer;
+  base::TimeDelta timeout_delta = base::TimeDelta::FromMilliseconds(timeout_ms);
+
+  if (capacity_) {
+    while (sequence >= next_sequence_ + capacity_) {
+      if (timeout_ms < 0) {
+        // Wait forever, or until Stop.
+        not_full_cv_.Wait();
+      } else {
+        base::TimeDelta elapsed = timer.Elapsed();
+        if (elapsed < timeout_delta) {
+          // Wait with timeout, or until Stop.
+          not_full_cv_.TimedWait(timeout_delta - elapsed);
+        } else {
+          // We're through waiting.
+          return Status(error::TIME_OUT);
+        }
+      }
+      // Re-check for buffer shutdown after waking from Wait.
+      if (stop_requested_)
+        return Status(error::STOPPED);
+    }
+    DCHECK_LT(sequence, next_sequence_ + capacity_);
+  }
+
+  if (!pending_.insert(std::make_pair(sequence, element)).second) {
+    return Status(
+        error::INVALID_ARGUMENT,
+        base::StringPrintf("sequence (%zu) was already posted.", sequence));
+  }
+
+  // Signal the consumer if this is the element it is waiting for.
+  if (sequence == next_sequence_)
+    next_element_cv_.Signal();
+  return Status::OK;
+}
+
+template <class T>
+Status ReorderBuffer<T>::Pop(T* element, int64_t timeout_ms) {
+  base::AutoLock l(lock_);
+
+  base::ElapsedTimer timer;
+  base::TimeDelta timeout_delta = base::TimeDelta::FromMilliseconds(timeout_ms);
+
+  while (pending_.empty() || pending_.begin()->first != next_sequence_) {
+    // Out-of-order leftovers can never be delivered once stopped.
+    if (stop_requested_)
+      return Status(error::STOPPED);
+
+    if (timeout_ms < 0) {
+      // Wait forever, or until Stop.
+      next_element_cv_.Wait();
+    } else {
+      base::TimeDelta elapsed = timer.Elapsed();
+      if (elapsed < timeout_delta) {
+        // Wait with timeout, or until Stop.
+        next_element_cv_.TimedWait(timeout_delta - elapsed);
+      } else {
+        // We're through waiting.
+        return Status(error::TIME_OUT);
+      }
+    }
+  }
+
+  *element = pending_.begin()->second;
+  pending_.erase(pending_.begin());
+  ++next_sequence_;
+
+  // The sequence window advanced. Waiting producers block on different
+  // sequence numbers, so wake all of them to re-evaluate; a plain Signal
+  // could wake one whose sequence is still outside the window.
+  not_full_cv_.Broadcast();
+
+  // Signal other consumers if the next element is already available.
+  if (!pending_.empty() && pending_.begin()->first == next_sequence_)
+    next_element_cv_.Signal();
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_REORDER_BUFFER_H_
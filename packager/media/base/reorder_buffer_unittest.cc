@@ -0,0 +1,194 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/media/base/closure_thread.h"
+// For kUnlimitedCapacity and kInfiniteTimeout.
+#include "packager/media/base/producer_consumer_queue.h"
+#include "packager/media/base/reorder_buffer.h"
+#include "packager/media/base/test/status_test_util.h"
+
+namespace shaka {
+namespace {
+const size_t kCapacity = 10u;
+const int64_t kTimeout = 100;  // 0.1s.
+
+// Verify that the |delta| is approximately |expected_time_in_milliseconds|.
+void ExpectTimeApproxEqual(int64_t expected_time_in_milliseconds,
+                           const base::TimeDelta& delta) {
+  const int64_t kOverhead = 50;  // 0.05s.
+  EXPECT_NEAR(delta.InMilliseconds(), expected_time_in_milliseconds, kOverhead);
+}
+
+}  // namespace
+
+namespace media {
+
+TEST(ReorderBufferTest, CheckEmpty) {
+  ReorderBuffer<int> buffer(kUnlimitedCapacity);
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(0u, buffer.NextSequence());
+}
+
+TEST(ReorderBufferTest, InOrderPostPop) {
+  ReorderBuffer<size_t> buffer(kCapacity);
+  for (size_t i = 0; i < kCapacity; ++i)
+    ASSERT_OK(buffer.Post(i, i, kInfiniteTimeout));
+
+  EXPECT_EQ(kCapacity, buffer.Size());
+  for (size_t i = 0; i < kCapacity; ++i) {
+    size_t val;
+    ASSERT_OK(buffer.Pop(&val, kInfiniteTimeout));
+    EXPECT_EQ(i, val);
+    EXPECT_EQ(i + 1, buffer.NextSequence());
+  }
+  EXPECT_TRUE(buffer.Empty());
+}
+
+TEST(ReorderBufferTest, OutOfOrderPostPop) {
+  ReorderBuffer<size_t> buffer(kCapacity);
+  // Post the window in reverse order; elements must still pop in sequence.
+  for (size_t i = kCapacity; i > 0; --i)
+    ASSERT_OK(buffer.Post(i - 1, i - 1, kInfiniteTimeout));
+
+  for (size_t i = 0; i < kCapacity; ++i) {
+    size_t val;
+    ASSERT_OK(buffer.Pop(&val, kInfiniteTimeout));
+    EXPECT_EQ(i, val);
+  }
+}
+
+TEST(ReorderBufferTest, StaleAndDuplicatePost) {
+  ReorderBuffer<size_t> buffer(kCapacity);
+  ASSERT_OK(buffer.Post(0, 0, kInfiniteTimeout));
+  ASSERT_EQ(error::INVALID_ARGUMENT,
+            buffer.Post(0, 0, kInfiniteTimeout).error_code());
+
+  size_t val;
+  ASSERT_OK(buffer.Pop(&val, kInfiniteTimeout));
+  ASSERT_EQ(error::INVALID_ARGUMENT,
+            buffer.Post(0, 0, kInfiniteTimeout).error_code());
+}
+
+TEST(ReorderBufferTest, PostOutsideWindowWithTimeout) {
+  scoped_ptr<base::ElapsedTimer> timer;
+  ReorderBuffer<size_t> buffer(kCapacity);
+
+  timer.reset(new base::ElapsedTimer());
+  ASSERT_EQ(error::TIME_OUT,
+            buffer.Post(kCapacity, kCapacity, kTimeout).error_code());
+  // Expect elapsed time exceeds defined timeout.
+  ExpectTimeApproxEqual(kTimeout, timer->Elapsed());
+
+  // Consuming one element admits exactly one more sequence number.
+  ASSERT_OK(buffer.Post(0, 0, kInfiniteTimeout));
+  size_t val;
+  ASSERT_OK(buffer.Pop(&val, kInfiniteTimeout));
+  timer.reset(new base::ElapsedTimer());
+  ASSERT_OK(buffer.Post(kCapacity, kCapacity, kTimeout));
+  // Expect Post to return instantly without waiting.
+  ExpectTimeApproxEqual(0, timer->Elapsed());
+}
+
+TEST(ReorderBufferTest, PopWithTimeout) {
+  scoped_ptr<base::ElapsedTimer> timer;
+  ReorderBuffer<size_t> buffer(kCapacity);
+
+  // Sequence 0 is missing, so sequence 1 is not consumable yet.
+  ASSERT_OK(buffer.Post(1, 1, kInfiniteTimeout));
+  size_t val;
+  timer.reset(new base::ElapsedTimer());
+  ASSERT_EQ(error::TIME_OUT, buffer.Pop(&val, kTimeout).error_code());
+  // Expect elapsed time exceeds defined timeout.
+  ExpectTimeApproxEqual(kTimeout, timer->Elapsed());
+
+  ASSERT_OK(buffer.Post(0, 0, kInfiniteTimeout));
+  ASSERT_OK(buffer.Pop(&val, kTimeout));
+  EXPECT_EQ(0u, val);
+  ASSERT_OK(buffer.Pop(&val, kTimeout));
+  EXPECT_EQ(1u, val);
+}
+
+TEST(ReorderBufferTest, CheckStop) {
+  scoped_ptr<base::ElapsedTimer> timer;
+  ReorderBuffer<size_t> buffer(kUnlimitedCapacity);
+
+  // The in-sequence prefix is still consumable after Stop; the element
+  // behind the gap is not.
+  ASSERT_OK(buffer.Post(0, 0, kInfiniteTimeout));
+  ASSERT_OK(buffer.Post(2, 2, kInfiniteTimeout));
+
+  ASSERT_FALSE(buffer.Stopped());
+  buffer.Stop();
+  ASSERT_TRUE(buffer.Stopped());
+
+  EXPECT_EQ(error::STOPPED, buffer.Post(1, 1, kInfiniteTimeout).error_code());
+
+  size_t val;
+  ASSERT_OK(buffer.Pop(&val, kInfiniteTimeout));
+  EXPECT_EQ(0u, val);
+  timer.reset(new base::ElapsedTimer());
+  EXPECT_EQ(error::STOPPED, buffer.Pop(&val, kInfiniteTimeout).error_code());
+  // Expect Pop to return instantly without waiting.
+  ExpectTimeApproxEqual(0, timer->Elapsed());
+}
+
+class MultiThreadReorderBufferTest : public ::testing::Test {
+ public:
+  MultiThreadReorderBufferTest()
+      : even_thread_("Even Post Thread",
+                     base::Bind(&MultiThreadReorderBufferTest::PostTask,
+                                base::Unretained(this),
+                                0u)),
+        odd_thread_("Odd Post Thread",
+                    base::Bind(&MultiThreadReorderBufferTest::PostTask,
+                               base::Unretained(this),
+                               1u)),
+        buffer_(kCapacity) {}
+  ~MultiThreadReorderBufferTest() override {}
+
+ protected:
+  void SetUp() override {
+    even_thread_.Start();
+    odd_thread_.Start();
+  }
+
+  void TearDown() override {
+    buffer_.Stop();
+    even_thread_.Join();
+    odd_thread_.Join();
+  }
+
+  void PostTask(size_t start) {
+    // Post every other sequence number until stopped; the two threads
+    // interleave arbitrarily, so elements arrive out of order.
+    for (size_t sequence = start;
+         buffer_.Post(sequence, sequence, kInfiniteTimeout).ok();
+         sequence += 2) {
+    }
+  }
+
+  ClosureThread even_thread_;
+  ClosureThread odd_thread_;
+  ReorderBuffer<size_t> buffer_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MultiThreadReorderBufferTest);
+};
+
+TEST_F(MultiThreadReorderBufferTest, Pop) {
+  size_t val;
+  for (size_t i = 0; i < kCapacity * 3; ++i) {
+    ASSERT_OK(buffer_.Pop(&val, kInfiniteTimeout));
+    EXPECT_EQ(i, val);
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
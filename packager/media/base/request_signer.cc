@@ -72,7 +72,18 @@ RsaRequestSigner* RsaRequestSigner::CreateSigner(
 
 bool RsaRequestSigner::GenerateSignature(const std::string& message,
                                          std::string* signature) {
-  return rsa_private_key_->GenerateSignature(message, signature);
+  base::AutoLock auto_lock(lock_);
+  // PSS salts are random, so any signature previously generated for the same
+  // message is still a valid signature for it.
+  if (!last_message_.empty() && message == last_message_) {
+    *signature = last_signature_;
+    return true;
+  }
+  if (!rsa_private_key_->GenerateSignature(message, signature))
+    return false;
+  last_message_ = message;
+  last_signature_ = *signature;
+  return true;
 }
 
 }  // namespace media
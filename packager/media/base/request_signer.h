@@ -10,6 +10,7 @@
 #include <string>
 
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/lock.h"
 
 namespace shaka {
 namespace media {
@@ -74,6 +75,9 @@ class RsaRequestSigner : public RequestSigner {
                                         const std::string& pkcs1_rsa_key);
 
   /// RequestSigner implementation override.
+  /// RSA-PSS signing is expensive and key rotation retries sign the same
+  /// request message repeatedly, so the signature generated for the last
+  /// message is cached and reused when the message repeats.
   bool GenerateSignature(const std::string& message,
                          std::string* signature) override;
 
@@ -83,6 +87,12 @@ class RsaRequestSigner : public RequestSigner {
 
   scoped_ptr<RsaPrivateKey> rsa_private_key_;
 
+  // Protects the signature cache below; signatures may be requested both from
+  // the main thread and from the key production thread.
+  base::Lock lock_;
+  std::string last_message_;
+  std::string last_signature_;
+
   DISALLOW_COPY_AND_ASSIGN(RsaRequestSigner);
 };
 
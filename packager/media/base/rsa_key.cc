@@ -63,6 +63,15 @@ RSA* DeserializeRsaPrivateKey(const std::string& serialized_key) {
     RSA_free(rsa_key);
     return NULL;
   }
+  // Set up the blinding context once here instead of lazily on the first
+  // private key operation. Montgomery and blinding state then live in the
+  // RSA object and are reused across signatures.
+  if (RSA_blinding_on(rsa_key, NULL) != 1) {
+    LOG(ERROR) << "RSA blinding failure: " << ERR_error_string(
+                                                  ERR_get_error(), NULL);
+    RSA_free(rsa_key);
+    return NULL;
+  }
   return rsa_key;
 }
 
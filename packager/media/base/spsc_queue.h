@@ -0,0 +1,176 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_SPSC_QUEUE_H_
+#define MEDIA_BASE_SPSC_QUEUE_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "packager/base/atomicops.h"
+#include "packager/base/logging.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/media/base/status.h"
+
+namespace shaka {
+namespace media {
+
+/// A lock-free single-producer single-consumer bounded queue. Unlike
+/// ProducerConsumerQueue there is no lock and no condition variable on the
+/// Push/Pop fast path; producer and consumer synchronize through two atomic
+/// ring indices only. Intended for the demuxer to muxer hot path where
+/// exactly one thread pushes and exactly one thread pops. Full/empty waits
+/// spin briefly and then yield the CPU.
+template <class T>
+class SpscQueue {
+ public:
+  /// Create an SpscQueue.
+  /// @param capacity is the maximum number of elements the queue can hold at
+  ///        once; it is rounded up to the next power of two. Must be > 0.
+  explicit SpscQueue(size_t capacity);
+  ~SpscQueue();
+
+  /// Push an element to the back of the queue, blocking while the queue is
+  /// full. Must be called from the producer thread only.
+  /// @param element refers to the element to be pushed.
+  /// @return OK if the element was pushed, STOPPED if Stop has been called.
+  Status Push(const T& element);
+
+  /// Pop an element from the front of the queue, blocking while the queue is
+  /// empty. Must be called from the consumer thread only.
+  /// @param[out] element receives the popped element.
+  /// @return OK if an element was popped, STOPPED if Stop has been called and
+  ///         the queue has drained entirely.
+  Status Pop(T* element);
+
+  /// Pop an element from the front of the queue without blocking. Must be
+  /// called from the consumer thread only.
+  /// @param[out] element receives the popped element.
+  /// @return true if an element was popped, false if the queue is empty.
+  bool TryPop(T* element);
+
+  /// Terminate waiting and future Push requests immediately and terminate Pop
+  /// requests once the queue drains entirely. May be called from any thread.
+  void Stop() { base::subtle::Release_Store(&stop_requested_, 1); }
+
+  /// @return true if Stop has been called.
+  bool Stopped() const {
+    return base::subtle::Acquire_Load(&stop_requested_) != 0;
+  }
+
+  /// @return true if there are no elements in the queue. Only an estimate
+  ///         unless called from the consumer thread.
+  bool Empty() const {
+    return base::subtle::Acquire_Load(&head_pos_) ==
+           base::subtle::Acquire_Load(&tail_pos_);
+  }
+
+  /// @return The number of elements in the queue. Only an estimate unless
+  ///         both producer and consumer are quiescent.
+  size_t Size() const {
+    return base::subtle::Acquire_Load(&tail_pos_) -
+           base::subtle::Acquire_Load(&head_pos_);
+  }
+
+ private:
+  // Number of spin iterations on a full/empty queue before yielding.
+  static const int kSpinsBeforeYield = 100;
+
+  const size_t capacity_;  // Always a power of two.
+  const size_t mask_;
+  std::vector<T> ring_;
+  // Monotonically increasing element positions; the ring slot is the position
+  // masked with |mask_|. |head_pos_| is advanced by the consumer only and
+  // |tail_pos_| by the producer only.
+  base::subtle::AtomicWord head_pos_;
+  base::subtle::AtomicWord tail_pos_;
+  base::subtle::AtomicWord stop_requested_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpscQueue);
+};
+
+namespace internal {
+
+inline size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result *= 2;
+  return result;
+}
+
+}  // namespace internal
+
+template <class T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+    : capacity_(internal::RoundUpToPowerOfTwo(capacity)),
+      mask_(capacity_ - 1),
+      ring_(capacity_),
+      head_pos_(0),
+      tail_pos_(0),
+      stop_requested_(0) {
+  DCHECK_GT(capacity, 0u);
+}
+
+template <class T>
+SpscQueue<T>::~SpscQueue() {}
+
+template <class T>
+Status SpscQueue<T>::Push(const T& element) {
+  const base::subtle::AtomicWord tail =
+      base::subtle::NoBarrier_Load(&tail_pos_);
+  int spins = 0;
+  while (static_cast<size_t>(tail - base::subtle::Acquire_Load(&head_pos_)) ==
+         capacity_) {
+    if (Stopped())
+      return Status(error::STOPPED, "");
+    if (++spins >= kSpinsBeforeYield) {
+      spins = 0;
+      base::PlatformThread::YieldCurrentThread();
+    }
+  }
+  if (Stopped())
+    return Status(error::STOPPED, "");
+  ring_[tail & mask_] = element;
+  base::subtle::Release_Store(&tail_pos_, tail + 1);
+  return Status::OK;
+}
+
+template <class T>
+Status SpscQueue<T>::Pop(T* element) {
+  const base::subtle::AtomicWord head =
+      base::subtle::NoBarrier_Load(&head_pos_);
+  int spins = 0;
+  while (base::subtle::Acquire_Load(&tail_pos_) == head) {
+    if (Stopped())
+      return Status(error::STOPPED, "");
+    if (++spins >= kSpinsBeforeYield) {
+      spins = 0;
+      base::PlatformThread::YieldCurrentThread();
+    }
+  }
+  // Swap rather than assign so element types with reference semantics
+  // (e.g. scoped_refptr) transfer ownership without touching refcounts; the
+  // slot is left holding the consumer's previous, typically empty, value.
+  std::swap(*element, ring_[head & mask_]);
+  base::subtle::Release_Store(&head_pos_, head + 1);
+  return Status::OK;
+}
+
+template <class T>
+bool SpscQueue<T>::TryPop(T* element) {
+  const base::subtle::AtomicWord head =
+      base::subtle::NoBarrier_Load(&head_pos_);
+  if (base::subtle::Acquire_Load(&tail_pos_) == head)
+    return false;
+  std::swap(*element, ring_[head & mask_]);
+  base::subtle::Release_Store(&head_pos_, head + 1);
+  return true;
+}
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_SPSC_QUEUE_H_
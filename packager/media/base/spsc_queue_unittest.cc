@@ -0,0 +1,78 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/spsc_queue.h"
+#include "packager/media/base/test/status_test_util.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+const size_t kCapacity = 8u;
+const int kNumElements = 10000;
+
+void ConsumeElements(SpscQueue<int>* queue, int* num_popped) {
+  int expected = 0;
+  int element = 0;
+  while (queue->Pop(&element).ok()) {
+    EXPECT_EQ(expected, element);
+    ++expected;
+    ++*num_popped;
+  }
+}
+}  // namespace
+
+TEST(SpscQueueTest, PushPop) {
+  SpscQueue<int> queue(kCapacity);
+  EXPECT_TRUE(queue.Empty());
+
+  ASSERT_OK(queue.Push(1));
+  ASSERT_OK(queue.Push(2));
+  EXPECT_EQ(2u, queue.Size());
+
+  int element = 0;
+  ASSERT_OK(queue.Pop(&element));
+  EXPECT_EQ(1, element);
+  ASSERT_OK(queue.Pop(&element));
+  EXPECT_EQ(2, element);
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(SpscQueueTest, StopDrainsBeforeStoppingPop) {
+  SpscQueue<int> queue(kCapacity);
+  ASSERT_OK(queue.Push(1));
+  queue.Stop();
+
+  ASSERT_EQ(error::STOPPED, queue.Push(2).error_code());
+
+  // The queued element is still delivered after Stop.
+  int element = 0;
+  ASSERT_OK(queue.Pop(&element));
+  EXPECT_EQ(1, element);
+  ASSERT_EQ(error::STOPPED, queue.Pop(&element).error_code());
+}
+
+TEST(SpscQueueTest, ProducerConsumerThreads) {
+  SpscQueue<int> queue(kCapacity);
+  int num_popped = 0;
+  ClosureThread consumer(
+      "Consumer", base::Bind(&ConsumeElements, &queue, &num_popped));
+  consumer.Start();
+
+  for (int i = 0; i < kNumElements; ++i)
+    ASSERT_OK(queue.Push(i));
+  queue.Stop();
+  consumer.Join();
+
+  EXPECT_EQ(kNumElements, num_popped);
+}
+
+}  // namespace media
+}  // namespace shaka
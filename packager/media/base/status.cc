@@ -6,6 +6,9 @@
 
 #include "packager/media/base/status.h"
 
+#include <inttypes.h>
+
+#include "packager/base/atomicops.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/stringprintf.h"
 
@@ -54,9 +57,45 @@ std::string ErrorCodeToString(Code error_code) {
 }  // namespace
 }  // namespace error
 
+namespace {
+
+// One past the largest error code, for sizing the counter array.
+const int kNumStatusCodes = error::NOT_FOUND + 1;
+base::subtle::AtomicWord g_status_counts[kNumStatusCodes] = {0};
+
+}  // namespace
+
 const Status Status::OK = Status(error::OK, "");
 const Status Status::UNKNOWN = Status(error::UNKNOWN, "");
 
+// static
+void Status::Count(error::Code error_code) {
+  if (error_code < 0 || error_code >= kNumStatusCodes)
+    return;
+  base::subtle::NoBarrier_AtomicIncrement(&g_status_counts[error_code], 1);
+}
+
+// static
+int64_t Status::CountForErrorCode(error::Code error_code) {
+  if (error_code < 0 || error_code >= kNumStatusCodes)
+    return 0;
+  return base::subtle::NoBarrier_Load(&g_status_counts[error_code]);
+}
+
+// static
+std::string Status::CountersToString() {
+  std::string output;
+  for (int i = 0; i < kNumStatusCodes; ++i) {
+    const int64_t count = base::subtle::NoBarrier_Load(&g_status_counts[i]);
+    if (count == 0)
+      continue;
+    base::StringAppendF(
+        &output, "%s: %" PRId64 "\n",
+        error::ErrorCodeToString(static_cast<error::Code>(i)).c_str(), count);
+  }
+  return output;
+}
+
 std::string Status::ToString() const {
   if (error_code_ == error::OK)
     return "OK";
@@ -7,6 +7,8 @@
 #ifndef MEDIA_BASE_STATUS_H_
 #define MEDIA_BASE_STATUS_H_
 
+#include <stdint.h>
+
 #include <iostream>
 #include <string>
 
@@ -86,6 +88,15 @@ class Status {
       error_message_ = error_message;
   }
 
+  /// Create a status with the specified code and no error message. This is
+  /// the cheap path for statuses used as expected control flow, e.g. queue
+  /// timeouts: no message string is built, and the construction is counted
+  /// so that how often each code fires can be reported.
+  explicit Status(error::Code error_code) : error_code_(error_code) {
+    if (!ok())
+      Count(error_code);
+  }
+
   ~Status() {}
 
   /// @name Some pre-defined Status objects.
@@ -142,6 +153,16 @@ class Status {
   /// @return A combination of the error code name and message.
   std::string ToString() const;
 
+  /// @return The number of times a Status with @a error_code has been created
+  ///         through the message-less constructor since the process started.
+  ///         This accounts for the statuses used as expected control flow,
+  ///         e.g. how often queue operations timed out.
+  static int64_t CountForErrorCode(error::Code error_code);
+
+  /// @return A human-readable list of all non-zero per-code counters, one
+  ///         per line. Empty if no counted status has been created.
+  static std::string CountersToString();
+
   void Swap(Status* other) {
     error::Code error_code = error_code_;
     error_code_ = other->error_code_;
@@ -150,6 +171,9 @@ class Status {
   }
 
  private:
+  // Bumps the counter for |error_code|. Thread safe.
+  static void Count(error::Code error_code);
+
   error::Code error_code_;
   std::string error_message_;
 
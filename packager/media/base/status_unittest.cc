@@ -57,6 +57,22 @@ TEST(Status, Unknown) {
   CheckStatus(Status::UNKNOWN, error::UNKNOWN, "");
 }
 
+TEST(Status, CodeOnlyConstructor) {
+  CheckStatus(Status(error::CANCELLED), error::CANCELLED, "");
+}
+
+TEST(Status, CodeOnlyConstructorOK) {
+  CheckStatus(Status(error::OK), error::OK, "");
+}
+
+TEST(Status, CountForErrorCode) {
+  const int64_t count_before = Status::CountForErrorCode(error::TIME_OUT);
+  Status status(error::TIME_OUT);
+  Status copy(status);
+  EXPECT_EQ(count_before + 1, Status::CountForErrorCode(error::TIME_OUT));
+  EXPECT_THAT(Status::CountersToString(), testing::HasSubstr("TIME_OUT"));
+}
+
 TEST(Status, Filled) {
   CheckStatus(Status(error::CANCELLED, "message"), error::CANCELLED, "message");
 }
@@ -0,0 +1,35 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/string_codecs.h"
+
+#include "packager/base/base64.h"
+#include "packager/base/strings/string_piece.h"
+
+namespace shaka {
+namespace media {
+
+std::string HexEncodeLower(const uint8_t* data, size_t size) {
+  static const char kHexChars[] = "0123456789abcdef";
+
+  std::string hex;
+  hex.resize(size * 2);
+  for (size_t i = 0; i < size; ++i) {
+    hex[2 * i] = kHexChars[data[i] >> 4];
+    hex[2 * i + 1] = kHexChars[data[i] & 0x0f];
+  }
+  return hex;
+}
+
+std::string Base64EncodeData(const uint8_t* data, size_t size) {
+  std::string base64;
+  base::Base64Encode(
+      base::StringPiece(reinterpret_cast<const char*>(data), size), &base64);
+  return base64;
+}
+
+}  // namespace media
+}  // namespace shaka
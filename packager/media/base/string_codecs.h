@@ -0,0 +1,32 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_STRING_CODECS_H_
+#define MEDIA_BASE_STRING_CODECS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace shaka {
+namespace media {
+
+/// Encode @a size bytes starting at @a data as lower-case hexadecimal in a
+/// single pass. Equivalent to lower-casing base::HexEncode() output but
+/// without the intermediate upper-case string and second pass over it.
+std::string HexEncodeLower(const uint8_t* data, size_t size);
+
+/// Encode @a size bytes starting at @a data as standard base64 with padding.
+/// Convenience wrapper over base::Base64Encode() for raw byte ranges, shared
+/// by the manifest writers so key ids and PSSH boxes are formatted the same
+/// way everywhere.
+std::string Base64EncodeData(const uint8_t* data, size_t size);
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_STRING_CODECS_H_
@@ -0,0 +1,38 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/macros.h"
+#include "packager/media/base/string_codecs.h"
+
+namespace shaka {
+namespace media {
+
+TEST(StringCodecsTest, HexEncodeLowerEmpty) {
+  EXPECT_EQ("", HexEncodeLower(NULL, 0));
+}
+
+TEST(StringCodecsTest, HexEncodeLower) {
+  const uint8_t kData[] = {0x00, 0x01, 0x9a, 0xbc, 0xde, 0xff};
+  EXPECT_EQ("00019abcdeff", HexEncodeLower(kData, arraysize(kData)));
+}
+
+TEST(StringCodecsTest, Base64EncodeDataEmpty) {
+  EXPECT_EQ("", Base64EncodeData(NULL, 0));
+}
+
+TEST(StringCodecsTest, Base64EncodeData) {
+  // "Man" is the canonical RFC 4648 example; the second case exercises
+  // padding.
+  const uint8_t kMan[] = {'M', 'a', 'n'};
+  EXPECT_EQ("TWFu", Base64EncodeData(kMan, arraysize(kMan)));
+  const uint8_t kMa[] = {'M', 'a'};
+  EXPECT_EQ("TWE=", Base64EncodeData(kMa, arraysize(kMa)));
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,74 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/timestamp_validator.h"
+
+#include <gflags/gflags.h>
+#include <stdlib.h>
+
+#include "packager/base/logging.h"
+
+DEFINE_bool(strict_timestamp_checks,
+            false,
+            "Fail the muxer when a sample's decoding timestamp goes backward "
+            "or does not line up with the previous sample's timestamp plus "
+            "duration, instead of counting and warning.");
+
+namespace shaka {
+namespace media {
+
+namespace {
+
+// Log the first few anomalies per stream; afterwards they are only counted.
+const uint64_t kMaxLoggedAnomalies = 5;
+
+// Timestamps computed through timescale rescaling can be off by a tick, so a
+// mismatch of at most this many units is not treated as a gap.
+const int64_t kTimestampJitterTolerance = 1;
+
+}  // namespace
+
+TimestampValidator::TimestampValidator()
+    : has_previous_sample_(false),
+      previous_dts_(0),
+      expected_dts_(0),
+      num_backward_dts_(0),
+      num_duration_gaps_(0) {}
+
+TimestampValidator::~TimestampValidator() {
+  if (num_backward_dts_ > 0 || num_duration_gaps_ > 0) {
+    LOG(WARNING) << "Timestamp anomalies in muxed stream: "
+                 << num_backward_dts_ << " backward dts, "
+                 << num_duration_gaps_ << " duration gap(s).";
+  }
+}
+
+bool TimestampValidator::AddSample(int64_t dts, int64_t duration) {
+  bool valid = true;
+  if (has_previous_sample_) {
+    if (dts < previous_dts_) {
+      ++num_backward_dts_;
+      LOG_IF(WARNING, num_backward_dts_ <= kMaxLoggedAnomalies)
+          << "Sample dts " << dts << " went backward from " << previous_dts_
+          << ".";
+      valid = false;
+    } else if (llabs(dts - expected_dts_) > kTimestampJitterTolerance) {
+      ++num_duration_gaps_;
+      LOG_IF(WARNING, num_duration_gaps_ <= kMaxLoggedAnomalies)
+          << "Sample dts " << dts << " does not line up with previous dts "
+          << previous_dts_ << " plus duration; expected " << expected_dts_
+          << ".";
+      valid = false;
+    }
+  }
+  has_previous_sample_ = true;
+  previous_dts_ = dts;
+  expected_dts_ = dts + duration;
+  return valid || !FLAGS_strict_timestamp_checks;
+}
+
+}  // namespace media
+}  // namespace shaka
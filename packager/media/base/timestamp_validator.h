@@ -0,0 +1,58 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_TIMESTAMP_VALIDATOR_H_
+#define MEDIA_BASE_TIMESTAMP_VALIDATOR_H_
+
+#include <stdint.h>
+
+#include "packager/base/macros.h"
+
+namespace shaka {
+namespace media {
+
+/// Rolling timestamp invariant checks for the muxer hot path. One instance
+/// tracks one stream: each sample is compared against the previous one in
+/// O(1) to catch decoding timestamps going backward and samples that do not
+/// line up with the previous sample's timestamp plus duration. Anomalies are
+/// counted and the first few are logged; with --strict_timestamp_checks the
+/// offending sample fails validation so the muxer can fail fast instead of
+/// producing a broken output. Replaces a separate verification pass that
+/// costs a full extra read of every output.
+class TimestampValidator {
+ public:
+  TimestampValidator();
+  /// Logs a summary if any anomalies were counted.
+  ~TimestampValidator();
+
+  /// Check @a dts and @a duration against the previous sample and update the
+  /// rolling state.
+  /// @return false if --strict_timestamp_checks is set and the sample breaks
+  ///         an invariant; true otherwise.
+  bool AddSample(int64_t dts, int64_t duration);
+
+  /// @return Number of samples whose dts was smaller than the previous one.
+  uint64_t num_backward_dts() const { return num_backward_dts_; }
+
+  /// @return Number of samples whose dts did not line up with the previous
+  ///         sample's dts plus duration.
+  uint64_t num_duration_gaps() const { return num_duration_gaps_; }
+
+ private:
+  bool has_previous_sample_;
+  int64_t previous_dts_;
+  // Expected dts of the next sample: previous dts plus previous duration.
+  int64_t expected_dts_;
+  uint64_t num_backward_dts_;
+  uint64_t num_duration_gaps_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimestampValidator);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_BASE_TIMESTAMP_VALIDATOR_H_
@@ -0,0 +1,59 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include "packager/media/base/timestamp_validator.h"
+
+DECLARE_bool(strict_timestamp_checks);
+
+namespace shaka {
+namespace media {
+
+TEST(TimestampValidatorTest, ContiguousSamples) {
+  TimestampValidator validator;
+  EXPECT_TRUE(validator.AddSample(0, 10));
+  EXPECT_TRUE(validator.AddSample(10, 10));
+  EXPECT_TRUE(validator.AddSample(20, 10));
+  EXPECT_EQ(0u, validator.num_backward_dts());
+  EXPECT_EQ(0u, validator.num_duration_gaps());
+}
+
+TEST(TimestampValidatorTest, JitterTolerated) {
+  TimestampValidator validator;
+  EXPECT_TRUE(validator.AddSample(0, 10));
+  // Off by one tick, which rescaling can legitimately produce.
+  EXPECT_TRUE(validator.AddSample(11, 10));
+  EXPECT_TRUE(validator.AddSample(20, 10));
+  EXPECT_EQ(0u, validator.num_duration_gaps());
+}
+
+TEST(TimestampValidatorTest, CountsAnomalies) {
+  TimestampValidator validator;
+  EXPECT_TRUE(validator.AddSample(0, 10));
+  // A gap: expected dts 10.
+  EXPECT_TRUE(validator.AddSample(30, 10));
+  // Backward dts.
+  EXPECT_TRUE(validator.AddSample(20, 10));
+  EXPECT_EQ(1u, validator.num_backward_dts());
+  EXPECT_EQ(1u, validator.num_duration_gaps());
+}
+
+TEST(TimestampValidatorTest, StrictModeFailsFast) {
+  const bool saved_flag = FLAGS_strict_timestamp_checks;
+  FLAGS_strict_timestamp_checks = true;
+
+  TimestampValidator validator;
+  EXPECT_TRUE(validator.AddSample(0, 10));
+  EXPECT_FALSE(validator.AddSample(30, 10));
+  EXPECT_FALSE(validator.AddSample(20, 10));
+
+  FLAGS_strict_timestamp_checks = saved_flag;
+}
+
+}  // namespace media
+}  // namespace shaka
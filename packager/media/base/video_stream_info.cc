@@ -77,7 +77,8 @@ VideoStreamInfo::VideoStreamInfo(int track_id,
       pixel_width_(pixel_width),
       pixel_height_(pixel_height),
       trick_play_rate_(trick_play_rate),
-      nalu_length_size_(nalu_length_size) {
+      nalu_length_size_(nalu_length_size),
+      nominal_sample_duration_(0) {
 }
 
 VideoStreamInfo::~VideoStreamInfo() {}
@@ -66,12 +66,19 @@ class VideoStreamInfo : public StreamInfo {
   uint32_t pixel_height() const { return pixel_height_; }
   uint8_t nalu_length_size() const { return nalu_length_size_; }
   int16_t trick_play_rate() const { return trick_play_rate_; }
+  /// Nominal duration of one sample in stream timescale units, derived from
+  /// codec-level timing information (e.g. the H.264 SPS VUI).
+  /// @return 0 if unknown.
+  uint32_t nominal_sample_duration() const { return nominal_sample_duration_; }
 
   void set_codec(VideoCodec codec) { codec_ = codec; }
   void set_width(uint32_t width) { width_ = width; }
   void set_height(uint32_t height) { height_ = height; }
   void set_pixel_width(uint32_t pixel_width) { pixel_width_ = pixel_width; }
   void set_pixel_height(uint32_t pixel_height) { pixel_height_ = pixel_height; }
+  void set_nominal_sample_duration(uint32_t nominal_sample_duration) {
+    nominal_sample_duration_ = nominal_sample_duration;
+  }
 
  private:
   ~VideoStreamInfo() override;
@@ -91,6 +98,10 @@ class VideoStreamInfo : public StreamInfo {
   // (H.264).
   uint8_t nalu_length_size_;
 
+  // Nominal sample duration in stream timescale units from codec-level
+  // timing information. 0 if unknown.
+  uint32_t nominal_sample_duration_;
+
   // Not using DISALLOW_COPY_AND_ASSIGN here intentionally to allow the compiler
   // generated copy constructor and assignment operator. Since the extra data is
   // typically small, the performance impact is minimal.
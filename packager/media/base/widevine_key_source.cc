@@ -6,14 +6,23 @@
 
 #include "packager/media/base/widevine_key_source.h"
 
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
 #include <set>
 
+#include <gflags/gflags.h>
+
 #include "packager/base/base64.h"
 #include "packager/base/bind.h"
+#include "packager/base/files/file_util.h"
 #include "packager/base/json/json_reader.h"
 #include "packager/base/json/json_writer.h"
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/stl_util.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/media/base/aes_decryptor.h"
+#include "packager/media/base/aes_encryptor.h"
 #include "packager/media/base/fixed_key_source.h"
 #include "packager/media/base/http_key_fetcher.h"
 #include "packager/media/base/producer_consumer_queue.h"
@@ -22,6 +31,26 @@
 #include "packager/media/base/request_signer.h"
 #include "packager/media/base/widevine_pssh_data.pb.h"
 
+DEFINE_bool(coalesce_key_requests,
+            false,
+            "Share one license request between concurrent key sources that "
+            "ask for identical content, and cache successful non-rotation "
+            "responses for the life of the process.");
+DEFINE_string(key_cache_dir,
+              "",
+              "Directory holding encrypted license responses, consulted "
+              "before contacting the license server and surviving process "
+              "restarts. Requires --key_cache_key; empty disables the "
+              "cache. Only non key rotation requests are cached.");
+DEFINE_string(key_cache_key,
+              "",
+              "AES-128 key in hex used to encrypt entries of "
+              "--key_cache_dir.");
+DEFINE_int32(key_cache_ttl_seconds,
+             86400,
+             "Ignore --key_cache_dir entries older than this many seconds. "
+             "Zero means entries never expire.");
+
 namespace shaka {
 namespace {
 
@@ -43,6 +72,10 @@ const int kDefaultCryptoPeriodCount = 10;
 const int kGetKeyTimeoutInSeconds = 5 * 60;  // 5 minutes.
 const int kKeyFetchTimeoutInSeconds = 60;  // 1 minute.
 
+// A crypto period key lookup that completes faster than this was served from
+// already produced keys; anything slower blocked on the license server.
+const int kRotationWaitThresholdMs = 1;
+
 bool Base64StringToBytes(const std::string& base64_string,
                          std::vector<uint8_t>* bytes) {
   DCHECK(bytes);
@@ -110,6 +143,214 @@ bool GetPsshDataFromTrack(const base::DictionaryValue& track_dict,
 }  // namespace
 
 namespace media {
+namespace {
+
+// Coalesces identical key requests within this process and caches successful
+// responses, so concurrent jobs packaging the same content issue a single
+// license request and later jobs reuse the response without another round
+// trip.
+class KeyRequestCoalescer {
+ public:
+  KeyRequestCoalescer() {}
+
+  // Fetches |message| from |url| through |fetcher|, reusing an identical
+  // in-flight or cached request when one exists. When |cache_response| is
+  // false the response is still shared with concurrent identical requests,
+  // but dropped once the fetch completes.
+  Status Fetch(KeyFetcher* fetcher,
+               const std::string& url,
+               const std::string& message,
+               bool cache_response,
+               std::string* response) {
+    const std::string request_key = RequestKey(url, message);
+    scoped_refptr<PendingRequest> pending;
+    bool is_leader = false;
+    {
+      base::AutoLock scoped_lock(lock_);
+      std::map<std::string, scoped_refptr<PendingRequest> >::iterator iter =
+          requests_.find(request_key);
+      if (iter != requests_.end()) {
+        pending = iter->second;
+      } else {
+        pending = new PendingRequest;
+        requests_[request_key] = pending;
+        is_leader = true;
+      }
+    }
+
+    if (!is_leader) {
+      pending->done.Wait();
+      *response = pending->response;
+      return pending->status;
+    }
+
+    pending->status = fetcher->FetchKeys(url, message, &pending->response);
+    pending->done.Signal();
+    if (!pending->status.ok() || !cache_response)
+      Remove(request_key, pending);
+    *response = pending->response;
+    return pending->status;
+  }
+
+  // Drops the cached response for |url| and |message|, if any, so the next
+  // fetch contacts the server again. Used when a cached response turns out
+  // to be unusable, e.g. it carries a transient server error.
+  void Invalidate(const std::string& url, const std::string& message) {
+    base::AutoLock scoped_lock(lock_);
+    std::map<std::string, scoped_refptr<PendingRequest> >::iterator iter =
+        requests_.find(RequestKey(url, message));
+    if (iter != requests_.end() && iter->second->done.IsSignaled())
+      requests_.erase(iter);
+  }
+
+ private:
+  struct PendingRequest : public base::RefCountedThreadSafe<PendingRequest> {
+    PendingRequest() : done(true, false) {}
+
+    base::WaitableEvent done;
+    Status status;
+    std::string response;
+
+   private:
+    friend class base::RefCountedThreadSafe<PendingRequest>;
+    ~PendingRequest() {}
+  };
+
+  static std::string RequestKey(const std::string& url,
+                                const std::string& message) {
+    return url + '\n' + message;
+  }
+
+  // Removes |request_key| if it still maps to |pending|.
+  void Remove(const std::string& request_key,
+              const scoped_refptr<PendingRequest>& pending) {
+    base::AutoLock scoped_lock(lock_);
+    std::map<std::string, scoped_refptr<PendingRequest> >::iterator iter =
+        requests_.find(request_key);
+    if (iter != requests_.end() && iter->second == pending)
+      requests_.erase(iter);
+  }
+
+  base::Lock lock_;
+  std::map<std::string, scoped_refptr<PendingRequest> > requests_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyRequestCoalescer);
+};
+
+KeyRequestCoalescer* GetKeyRequestCoalescer() {
+  // Deliberately leaked: shared by key sources for the whole process life.
+  static KeyRequestCoalescer* coalescer = new KeyRequestCoalescer;
+  return coalescer;
+}
+
+// Cache entries are the raw license response, AES-CBC encrypted with the
+// --key_cache_key and a per-entry random IV stored in front of the
+// ciphertext. The file name is a digest of the server url and the signed
+// request message, which covers content id, policy and all other request
+// fields.
+const size_t kKeyCacheIvSize = 16;
+
+bool KeyCacheEnabled() {
+  if (FLAGS_key_cache_dir.empty())
+    return false;
+  if (FLAGS_key_cache_key.empty()) {
+    LOG(WARNING) << "--key_cache_dir requires --key_cache_key; the key cache "
+                    "is disabled.";
+    return false;
+  }
+  return true;
+}
+
+bool GetKeyCacheKey(std::vector<uint8_t>* key) {
+  DCHECK(key);
+  if (!base::HexStringToBytes(FLAGS_key_cache_key, key) || key->size() != 16) {
+    LOG(WARNING) << "--key_cache_key must be 32 hex characters; the key "
+                    "cache is disabled.";
+    return false;
+  }
+  return true;
+}
+
+base::FilePath KeyCachePath(const std::string& url,
+                            const std::string& message) {
+  const std::string request = url + '\n' + message;
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const uint8_t*>(request.data()), request.size(),
+         digest);
+  return base::FilePath(FLAGS_key_cache_dir)
+      .AppendASCII(base::HexEncode(digest, sizeof(digest)) + ".lic");
+}
+
+bool ReadFromKeyCache(const base::FilePath& path, std::string* raw_response) {
+  DCHECK(raw_response);
+  std::vector<uint8_t> cache_key;
+  if (!GetKeyCacheKey(&cache_key))
+    return false;
+
+  if (FLAGS_key_cache_ttl_seconds > 0) {
+    base::File::Info info;
+    if (!base::GetFileInfo(path, &info))
+      return false;
+    if ((base::Time::Now() - info.last_modified).InSeconds() >=
+        FLAGS_key_cache_ttl_seconds) {
+      VLOG(1) << "Expired key cache entry " << path.value();
+      return false;
+    }
+  }
+
+  std::string contents;
+  if (!base::ReadFileToString(path, &contents))
+    return false;
+  if (contents.size() <= kKeyCacheIvSize)
+    return false;
+  const std::vector<uint8_t> iv(contents.begin(),
+                                contents.begin() + kKeyCacheIvSize);
+  const std::vector<uint8_t> ciphertext(contents.begin() + kKeyCacheIvSize,
+                                        contents.end());
+
+  AesCbcDecryptor decryptor(kPkcs5Padding, AesCryptor::kUseConstantIv);
+  std::vector<uint8_t> plaintext;
+  if (!decryptor.InitializeWithIv(cache_key, iv) ||
+      !decryptor.Crypt(ciphertext, &plaintext)) {
+    LOG(WARNING) << "Failed to decrypt key cache entry " << path.value();
+    return false;
+  }
+  raw_response->assign(plaintext.begin(), plaintext.end());
+  return true;
+}
+
+void WriteToKeyCache(const base::FilePath& path,
+                     const std::string& raw_response) {
+  std::vector<uint8_t> cache_key;
+  if (!GetKeyCacheKey(&cache_key))
+    return;
+  std::vector<uint8_t> iv(kKeyCacheIvSize);
+  if (RAND_bytes(iv.data(), iv.size()) != 1)
+    return;
+
+  AesCbcEncryptor encryptor(kPkcs5Padding, AesCryptor::kUseConstantIv);
+  const std::vector<uint8_t> plaintext(raw_response.begin(),
+                                       raw_response.end());
+  std::vector<uint8_t> ciphertext;
+  if (!encryptor.InitializeWithIv(cache_key, iv) ||
+      !encryptor.Crypt(plaintext, &ciphertext)) {
+    return;
+  }
+
+  if (!base::CreateDirectory(path.DirName())) {
+    LOG(WARNING) << "Failed to create key cache directory "
+                 << path.DirName().value();
+    return;
+  }
+  std::string contents(iv.begin(), iv.end());
+  contents.append(ciphertext.begin(), ciphertext.end());
+  if (base::WriteFile(path, contents.data(), contents.size()) !=
+      static_cast<int>(contents.size())) {
+    LOG(WARNING) << "Failed to write key cache entry " << path.value();
+  }
+}
+
+}  // namespace
 
 // A ref counted wrapper for EncryptionKeyMap.
 class WidevineKeySource::RefCountedEncryptionKeyMap
@@ -145,7 +386,9 @@ WidevineKeySource::WidevineKeySource(const std::string& server_url,
       add_common_pssh_(add_common_pssh),
       key_production_started_(false),
       start_key_production_(false, false),
-      first_crypto_period_index_(0) {
+      first_crypto_period_index_(0),
+      num_rotation_key_requests_(0),
+      num_rotation_key_waits_(0) {
   key_production_thread_.Start();
 }
 
@@ -158,6 +401,13 @@ WidevineKeySource::~WidevineKeySource() {
     start_key_production_.Signal();
     key_production_thread_.Join();
   }
+  if (num_rotation_key_waits_ > 0) {
+    LOG(INFO) << "Key rotation: " << num_rotation_key_waits_ << " of "
+              << num_rotation_key_requests_
+              << " crypto period key requests blocked on key production, "
+              << rotation_key_wait_time_.InMilliseconds() << " ms total, "
+              << max_rotation_key_wait_time_.InMilliseconds() << " ms max.";
+  }
   STLDeleteValues(&encryption_key_map_);
 }
 
@@ -258,25 +508,26 @@ Status WidevineKeySource::GetKey(const std::vector<uint8_t>& key_id,
 Status WidevineKeySource::GetCryptoPeriodKey(uint32_t crypto_period_index,
                                              TrackType track_type,
                                              EncryptionKey* key) {
-  DCHECK(key_production_thread_.HasBeenStarted());
-  // TODO(kqyang): This is not elegant. Consider refactoring later.
-  {
-    base::AutoLock scoped_lock(lock_);
-    if (!key_production_started_) {
-      // Another client may have a slightly smaller starting crypto period
-      // index. Set the initial value to account for that.
-      first_crypto_period_index_ =
-          crypto_period_index ? crypto_period_index - 1 : 0;
-      DCHECK(!key_pool_);
-      key_pool_.reset(new EncryptionKeyQueue(crypto_period_count_,
-                                             first_crypto_period_index_));
-      start_key_production_.Signal();
-      key_production_started_ = true;
-    }
-  }
+  // Another client may have a slightly smaller starting crypto period
+  // index. Set the initial value to account for that.
+  PrefetchCryptoPeriodKeys(crypto_period_index ? crypto_period_index - 1 : 0);
   return GetKeyInternal(crypto_period_index, track_type, key);
 }
 
+void WidevineKeySource::PrefetchCryptoPeriodKeys(
+    uint32_t first_crypto_period_index) {
+  DCHECK(key_production_thread_.HasBeenStarted());
+  base::AutoLock scoped_lock(lock_);
+  if (key_production_started_)
+    return;
+  first_crypto_period_index_ = first_crypto_period_index;
+  DCHECK(!key_pool_);
+  key_pool_.reset(new EncryptionKeyQueue(crypto_period_count_,
+                                         first_crypto_period_index_));
+  start_key_production_.Signal();
+  key_production_started_ = true;
+}
+
 void WidevineKeySource::set_signer(scoped_ptr<RequestSigner> signer) {
   signer_ = signer.Pass();
 }
@@ -294,9 +545,22 @@ Status WidevineKeySource::GetKeyInternal(uint32_t crypto_period_index,
   DCHECK_NE(track_type, TRACK_TYPE_UNKNOWN);
 
   scoped_refptr<RefCountedEncryptionKeyMap> ref_counted_encryption_key_map;
+  const base::TimeTicks start = base::TimeTicks::Now();
   Status status =
       key_pool_->Peek(crypto_period_index, &ref_counted_encryption_key_map,
                       kGetKeyTimeoutInSeconds * 1000);
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  {
+    base::AutoLock scoped_lock(lock_);
+    ++num_rotation_key_requests_;
+    if (elapsed >=
+        base::TimeDelta::FromMilliseconds(kRotationWaitThresholdMs)) {
+      ++num_rotation_key_waits_;
+      rotation_key_wait_time_ += elapsed;
+      if (elapsed > max_rotation_key_wait_time_)
+        max_rotation_key_wait_time_ = elapsed;
+    }
+  }
   if (!status.ok()) {
     if (status.error_code() == error::STOPPED) {
       CHECK(!common_encryption_request_status_.ok());
@@ -347,18 +611,51 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
     return status;
   VLOG(1) << "Message: " << message;
 
+  // Re-runs of the same content skip the license server round trip entirely
+  // when a cached response is still valid. Key rotation requests are never
+  // cached.
+  const bool use_key_cache = !enable_key_rotation && KeyCacheEnabled();
+  base::FilePath key_cache_path;
+  if (use_key_cache) {
+    key_cache_path = KeyCachePath(server_url_, message);
+    std::string cached_response;
+    if (ReadFromKeyCache(key_cache_path, &cached_response)) {
+      std::string response;
+      bool transient_error = false;
+      if (DecodeResponse(cached_response, &response) &&
+          ExtractEncryptionKey(enable_key_rotation, widevine_classic, response,
+                               &transient_error)) {
+        VLOG(1) << "Reused cached license response.";
+        return Status::OK;
+      }
+      LOG(WARNING) << "Ignoring unusable key cache entry "
+                   << key_cache_path.value();
+    }
+  }
+
   std::string raw_response;
   int64_t sleep_duration = kFirstRetryDelayMilliseconds;
 
   // Perform client side retries if seeing server transient error to workaround
   // server limitation.
   for (int i = 0; i < kNumTransientErrorRetries; ++i) {
-    status = key_fetcher_->FetchKeys(server_url_, message, &raw_response);
+    if (FLAGS_coalesce_key_requests) {
+      // Identical requests from concurrent key sources share one fetch, and
+      // one-shot (non rotation) responses are cached for later jobs. Key
+      // rotation batches are only coalesced, not cached.
+      status = GetKeyRequestCoalescer()->Fetch(key_fetcher_.get(), server_url_,
+                                               message, !enable_key_rotation,
+                                               &raw_response);
+    } else {
+      status = key_fetcher_->FetchKeys(server_url_, message, &raw_response);
+    }
     if (status.ok()) {
       VLOG(1) << "Retry [" << i << "] Response:" << raw_response;
 
       std::string response;
       if (!DecodeResponse(raw_response, &response)) {
+        if (FLAGS_coalesce_key_requests)
+          GetKeyRequestCoalescer()->Invalidate(server_url_, message);
         return Status(error::SERVER_ERROR,
                       "Failed to decode response '" + raw_response + "'.");
       }
@@ -367,9 +664,16 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
       if (ExtractEncryptionKey(enable_key_rotation,
                                widevine_classic,
                                response,
-                               &transient_error))
+                               &transient_error)) {
+        if (use_key_cache)
+          WriteToKeyCache(key_cache_path, raw_response);
         return Status::OK;
+      }
 
+      // Do not let the next attempt, or a later job, see this response
+      // again.
+      if (FLAGS_coalesce_key_requests)
+        GetKeyRequestCoalescer()->Invalidate(server_url_, message);
       if (!transient_error) {
         return Status(
             error::SERVER_ERROR,
@@ -11,6 +11,7 @@
 
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/time/time.h"
 #include "packager/base/values.h"
 #include "packager/media/base/closure_thread.h"
 #include "packager/media/base/key_source.h"
@@ -56,6 +57,34 @@ class WidevineKeySource : public KeySource {
   Status FetchKeys(const std::vector<uint8_t>& content_id,
                    const std::string& policy);
 
+  /// Start key rotation fetches in the background, so a later
+  /// GetCryptoPeriodKey does not have to wait on the license server for a
+  /// crypto period that has already been produced. Only the first call
+  /// starts production; later calls, including the implicit one from
+  /// GetCryptoPeriodKey, are no-ops.
+  /// @param first_crypto_period_index is the crypto period index key
+  ///        production starts from.
+  void PrefetchCryptoPeriodKeys(uint32_t first_crypto_period_index);
+
+  /// @name Key rotation wait counters.
+  /// A wait is recorded whenever GetCryptoPeriodKey blocks on key
+  /// production, i.e. whenever license server latency leaked into the
+  /// packaging pipeline instead of being hidden by the background fetches.
+  /// The counters are updated under an internal lock; read them after
+  /// packaging has completed.
+  /// @{
+  uint64_t num_rotation_key_requests() const {
+    return num_rotation_key_requests_;
+  }
+  uint64_t num_rotation_key_waits() const { return num_rotation_key_waits_; }
+  base::TimeDelta rotation_key_wait_time() const {
+    return rotation_key_wait_time_;
+  }
+  base::TimeDelta max_rotation_key_wait_time() const {
+    return max_rotation_key_wait_time_;
+  }
+  /// @}
+
   /// Set signer for the key source.
   /// @param signer signs the request message.
   void set_signer(scoped_ptr<RequestSigner> signer);
@@ -126,6 +155,12 @@ class WidevineKeySource : public KeySource {
   EncryptionKeyMap encryption_key_map_;  // For non key rotation request.
   Status common_encryption_request_status_;
 
+  // Key rotation wait counters, protected by |lock_|.
+  uint64_t num_rotation_key_requests_;
+  uint64_t num_rotation_key_waits_;
+  base::TimeDelta rotation_key_wait_time_;
+  base::TimeDelta max_rotation_key_wait_time_;
+
   DISALLOW_COPY_AND_ASSIGN(WidevineKeySource);
 };
 
@@ -12,6 +12,7 @@
 #include "packager/base/base64.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/base/threading/platform_thread.h"
 #include "packager/media/base/fixed_key_source.h"
 #include "packager/media/base/key_fetcher.h"
 #include "packager/media/base/request_signer.h"
@@ -514,6 +515,66 @@ TEST_P(WidevineKeySourceTest, KeyRotationTest) {
   EXPECT_EQ(error::INVALID_ARGUMENT, status.error_code());
 }
 
+namespace {
+
+// Injects license server latency into a mocked fetch.
+ACTION_P(SleepForMilliseconds, milliseconds) {
+  base::PlatformThread::Sleep(
+      base::TimeDelta::FromMilliseconds(milliseconds));
+}
+
+}  // namespace
+
+TEST_P(WidevineKeySourceTest, KeyRotationWaitCounters) {
+  const uint32_t kFirstCryptoPeriodIndex = 8;
+  const uint32_t kCryptoPeriodCount = 10;
+  const int64_t kFetchDelayMs = 20;
+
+  EXPECT_CALL(*mock_request_signer_, GenerateSignature(_, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(kMockSignature), Return(true)));
+
+  std::string mock_response = base::StringPrintf(
+      kHttpResponseFormat, Base64Encode(GenerateMockLicenseResponse()).c_str());
+  std::string mock_rotation_response = base::StringPrintf(
+      kHttpResponseFormat,
+      Base64Encode(GenerateMockKeyRotationLicenseResponse(
+                       kFirstCryptoPeriodIndex - 1, kCryptoPeriodCount))
+          .c_str());
+  // The rotation fetch is delayed to simulate a slow license server, so the
+  // first GetCryptoPeriodKey has to wait on key production. Further fetches
+  // fail, which stops key production after the first crypto period batch;
+  // the produced keys remain available.
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(mock_response), Return(Status::OK)))
+      .WillOnce(DoAll(SleepForMilliseconds(kFetchDelayMs),
+                      SetArgPointee<2>(mock_rotation_response),
+                      Return(Status::OK)))
+      .WillRepeatedly(Return(Status(error::UNKNOWN, "Mock fetch failure.")));
+
+  CreateWidevineKeySource();
+  widevine_key_source_->set_signer(mock_request_signer_.Pass());
+  ASSERT_OK(widevine_key_source_->FetchKeys(content_id_, kPolicy));
+
+  // The first request starts key production, so it blocks on the delayed
+  // license fetch and is recorded as a wait.
+  EncryptionKey encryption_key;
+  ASSERT_OK(widevine_key_source_->GetCryptoPeriodKey(
+      kFirstCryptoPeriodIndex, KeySource::TRACK_TYPE_SD, &encryption_key));
+  EXPECT_EQ(1u, widevine_key_source_->num_rotation_key_requests());
+  EXPECT_EQ(1u, widevine_key_source_->num_rotation_key_waits());
+  EXPECT_GE(widevine_key_source_->rotation_key_wait_time(),
+            base::TimeDelta::FromMilliseconds(kFetchDelayMs));
+  EXPECT_GE(widevine_key_source_->max_rotation_key_wait_time(),
+            base::TimeDelta::FromMilliseconds(kFetchDelayMs));
+
+  // A key from the same batch is already in the pool and is served without
+  // waiting.
+  ASSERT_OK(widevine_key_source_->GetCryptoPeriodKey(
+      kFirstCryptoPeriodIndex + 1, KeySource::TRACK_TYPE_SD, &encryption_key));
+  EXPECT_EQ(2u, widevine_key_source_->num_rotation_key_requests());
+  EXPECT_EQ(1u, widevine_key_source_->num_rotation_key_waits());
+}
+
 INSTANTIATE_TEST_CASE_P(WidevineKeySourceInstance,
                         WidevineKeySourceTest,
                         ::testing::Bool());
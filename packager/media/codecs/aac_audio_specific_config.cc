@@ -125,8 +125,11 @@ bool AACAudioSpecificConfig::Parse(const std::vector<uint8_t>& data) {
          channel_config_ <= 7;
 }
 
-bool AACAudioSpecificConfig::ConvertToADTS(std::vector<uint8_t>* buffer) const {
-  size_t size = buffer->size() + kADTSHeaderSize;
+bool AACAudioSpecificConfig::ConvertToADTS(
+    const uint8_t* data,
+    size_t data_size,
+    std::vector<uint8_t>* audio_frame) const {
+  size_t size = data_size + kADTSHeaderSize;
 
   DCHECK(audio_object_type_ >= 1 && audio_object_type_ <= 4 &&
          frequency_index_ != 0xf && channel_config_ <= 7);
@@ -135,9 +138,11 @@ bool AACAudioSpecificConfig::ConvertToADTS(std::vector<uint8_t>* buffer) const {
   if (size >= (1 << 13))
     return false;
 
-  std::vector<uint8_t>& adts = *buffer;
+  std::vector<uint8_t>& adts = *audio_frame;
 
-  adts.insert(buffer->begin(), kADTSHeaderSize, 0);
+  audio_frame->clear();
+  audio_frame->reserve(size);
+  audio_frame->resize(kADTSHeaderSize);
   adts[0] = 0xff;
   adts[1] = 0xf1;
   adts[2] = ((audio_object_type_ - 1) << 6) + (frequency_index_ << 2) +
@@ -147,6 +152,7 @@ bool AACAudioSpecificConfig::ConvertToADTS(std::vector<uint8_t>* buffer) const {
   adts[5] = ((size & 7) << 5) + 0x1f;
   adts[6] = 0xfc;
 
+  audio_frame->insert(audio_frame->end(), data, data + data_size);
   return true;
 }
 
@@ -34,11 +34,14 @@ class AACAudioSpecificConfig {
   virtual bool Parse(const std::vector<uint8_t>& data);
 
   /// Convert a raw AAC frame into an AAC frame with an ADTS header.
-  /// @param[in,out] buffer contains the raw AAC frame on input, and the
-  ///                converted frame on output if successful; it is untouched
-  ///                on failure.
+  /// @param data is the raw AAC frame.
+  /// @param data_size is the size of the raw AAC frame.
+  /// @param[out] audio_frame contains the converted frame on success; the
+  ///             content is undefined on failure.
   /// @return true on success, false otherwise.
-  virtual bool ConvertToADTS(std::vector<uint8_t>* buffer) const;
+  virtual bool ConvertToADTS(const uint8_t* data,
+                             size_t data_size,
+                             std::vector<uint8_t>* audio_frame) const;
 
   /// @param sbr_in_mimetype indicates whether SBR mode is specified in the
   ///        mimetype, i.e. codecs parameter contains mp4a.40.5.
@@ -55,6 +55,18 @@
         '../../base/base.gyp:base',
       ],
     },
+    {
+      'target_name': 'media_codecs_bench',
+      'type': 'executable',
+      'sources': [
+        'codecs_benchmark.cc',
+      ],
+      'dependencies': [
+        '../../base/base.gyp:base',
+        '../test/media_test.gyp:media_test_support',
+        'codecs',
+      ],
+    },
     {
       'target_name': 'codecs_unittest',
       'type': '<(gtest_target_type)',
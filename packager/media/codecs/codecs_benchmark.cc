@@ -0,0 +1,178 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Throughput benchmark for the codec parsers. Each benchmark runs one of the
+// parsers repeatedly over a stream committed under packager/media/test/data
+// and reports MB/s, printing one JSON object per line to stdout so results
+// can be compared across releases:
+//
+//   media_codecs_bench > codecs_bench.json
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "packager/base/at_exit.h"
+#include "packager/base/time/time.h"
+#include "packager/media/codecs/h264_byte_to_unit_stream_converter.h"
+#include "packager/media/codecs/h264_parser.h"
+#include "packager/media/codecs/h265_byte_to_unit_stream_converter.h"
+#include "packager/media/codecs/h265_parser.h"
+#include "packager/media/codecs/nalu_reader.h"
+#include "packager/media/codecs/vp8_parser.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Each benchmark is repeated until it has run at least this long, so short
+// inputs still produce stable numbers.
+const int64_t kMinBenchTimeMicroseconds = 1000000;
+
+typedef bool (*BenchFunc)(const std::vector<uint8_t>& data);
+
+bool BenchNaluReader(const std::vector<uint8_t>& data) {
+  NaluReader reader(Nalu::kH264, kIsAnnexbByteStream, data.data(), data.size());
+  Nalu nalu;
+  while (reader.Advance(&nalu) == NaluReader::kOk)
+    continue;
+  return true;
+}
+
+bool BenchH264Parser(const std::vector<uint8_t>& data) {
+  H264Parser parser;
+  NaluReader reader(Nalu::kH264, kIsAnnexbByteStream, data.data(), data.size());
+  Nalu nalu;
+  while (reader.Advance(&nalu) == NaluReader::kOk) {
+    int id;
+    H264SliceHeader shdr;
+    H264SEIMessage sei_msg;
+    switch (nalu.type()) {
+      case Nalu::H264_IDRSlice:
+      case Nalu::H264_NonIDRSlice:
+        if (parser.ParseSliceHeader(nalu, &shdr) != H264Parser::kOk)
+          return false;
+        break;
+      case Nalu::H264_SPS:
+        if (parser.ParseSps(nalu, &id) != H264Parser::kOk)
+          return false;
+        break;
+      case Nalu::H264_PPS:
+        if (parser.ParsePps(nalu, &id) != H264Parser::kOk)
+          return false;
+        break;
+      case Nalu::H264_SEIMessage:
+        if (parser.ParseSEI(nalu, &sei_msg) != H264Parser::kOk)
+          return false;
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+bool BenchH265Parser(const std::vector<uint8_t>& data) {
+  H265Parser parser;
+  NaluReader reader(Nalu::kH265, kIsAnnexbByteStream, data.data(), data.size());
+  Nalu nalu;
+  while (reader.Advance(&nalu) == NaluReader::kOk) {
+    int id;
+    switch (nalu.type()) {
+      case Nalu::H265_SPS:
+        if (parser.ParseSps(nalu, &id) != H265Parser::kOk)
+          return false;
+        break;
+      case Nalu::H265_PPS:
+        if (parser.ParsePps(nalu, &id) != H265Parser::kOk)
+          return false;
+        break;
+      default:
+        if (nalu.is_video_slice()) {
+          H265SliceHeader shdr;
+          if (parser.ParseSliceHeader(nalu, &shdr) != H265Parser::kOk)
+            return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+bool BenchH264Conversion(const std::vector<uint8_t>& data) {
+  H264ByteToUnitStreamConverter converter;
+  std::vector<uint8_t> output;
+  return converter.ConvertByteStreamToNalUnitStream(data.data(), data.size(),
+                                                    &output);
+}
+
+bool BenchH265Conversion(const std::vector<uint8_t>& data) {
+  H265ByteToUnitStreamConverter converter;
+  std::vector<uint8_t> output;
+  return converter.ConvertByteStreamToNalUnitStream(data.data(), data.size(),
+                                                    &output);
+}
+
+bool BenchVp8Parser(const std::vector<uint8_t>& data) {
+  VP8Parser parser;
+  std::vector<VPxFrameInfo> frames;
+  return parser.Parse(data.data(), data.size(), &frames);
+}
+
+void RunBenchmark(const char* name, BenchFunc func, const char* file_name) {
+  std::vector<uint8_t> data = ReadTestDataFile(file_name);
+  if (data.empty()) {
+    fprintf(stderr, "Skipping %s: could not read %s.\n", name, file_name);
+    return;
+  }
+  // Warm up and make sure the input actually parses before timing it.
+  if (!func(data)) {
+    fprintf(stderr, "Skipping %s: failed to parse %s.\n", name, file_name);
+    return;
+  }
+
+  int iterations = 0;
+  int64_t elapsed_us = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  do {
+    func(data);
+    ++iterations;
+    elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
+  } while (elapsed_us < kMinBenchTimeMicroseconds);
+
+  const double seconds = elapsed_us / 1000000.0;
+  const double megabytes =
+      static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+  printf(
+      "{\"name\": \"%s\", \"input\": \"%s\", \"iterations\": %d, "
+      "\"bytes_per_iteration\": %d, \"elapsed_us\": %lld, "
+      "\"throughput_mb_per_s\": %.2f}\n",
+      name, file_name, iterations, static_cast<int>(data.size()),
+      static_cast<long long>(elapsed_us), megabytes / seconds);
+}
+
+void RunAllBenchmarks() {
+  RunBenchmark("nalu_reader_scan", BenchNaluReader, "test-25fps.h264");
+  RunBenchmark("h264_parser", BenchH264Parser, "test-25fps.h264");
+  RunBenchmark("h265_parser", BenchH265Parser, "hevc-byte-stream-frame.h265");
+  RunBenchmark("h264_byte_to_unit_stream", BenchH264Conversion,
+               "avc-byte-stream-frame.h264");
+  RunBenchmark("h265_byte_to_unit_stream", BenchH265Conversion,
+               "hevc-byte-stream-frame.h265");
+  RunBenchmark("vp8_parser", BenchVp8Parser, "vp8-I-frame-320x240");
+}
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit;
+  shaka::media::RunAllBenchmarks();
+  return 0;
+}
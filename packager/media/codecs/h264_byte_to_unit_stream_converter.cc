@@ -6,6 +6,8 @@
 
 #include "packager/media/codecs/h264_byte_to_unit_stream_converter.h"
 
+#include <string.h>
+
 #include <limits>
 
 #include "packager/base/logging.h"
@@ -28,6 +30,11 @@ bool H264ByteToUnitStreamConverter::GetDecoderConfigurationRecord(
     return false;
   }
 
+  if (!decoder_config_cache_.empty()) {
+    *decoder_config = decoder_config_cache_;
+    return true;
+  }
+
   // Construct an AVCDecoderConfigurationRecord containing a single SPS and a
   // single PPS NALU. Please refer to ISO/IEC 14496-15 for format specifics.
   BufferWriter buffer(last_sps_.size() + last_pps_.size() + 11);
@@ -48,6 +55,7 @@ bool H264ByteToUnitStreamConverter::GetDecoderConfigurationRecord(
   buffer.AppendVector(last_pps_);
 
   buffer.SwapBuffer(decoder_config);
+  decoder_config_cache_ = *decoder_config;
   return true;
 }
 
@@ -60,12 +68,21 @@ bool H264ByteToUnitStreamConverter::ProcessNalu(const Nalu& nalu) {
 
   switch (nalu.type()) {
     case Nalu::H264_SPS:
-      // Grab SPS NALU.
-      last_sps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+      // Grab SPS NALU. Parameter sets are typically repeated unchanged, so
+      // only a different one invalidates the cached record.
+      if (last_sps_.size() != nalu_size ||
+          memcmp(last_sps_.data(), nalu_ptr, nalu_size) != 0) {
+        last_sps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+        decoder_config_cache_.clear();
+      }
       return true;
     case Nalu::H264_PPS:
       // Grab PPS NALU.
-      last_pps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+      if (last_pps_.size() != nalu_size ||
+          memcmp(last_pps_.data(), nalu_ptr, nalu_size) != 0) {
+        last_pps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+        decoder_config_cache_.clear();
+      }
       return true;
     case Nalu::H264_AUD:
       // Ignore AUD NALU.
@@ -35,6 +35,9 @@ class H264ByteToUnitStreamConverter : public H26xByteToUnitStreamConverter {
 
   std::vector<uint8_t> last_sps_;
   std::vector<uint8_t> last_pps_;
+  // Serialized record built on first request; cleared whenever a different
+  // SPS or PPS is seen in the stream.
+  mutable std::vector<uint8_t> decoder_config_cache_;
 
   DISALLOW_COPY_AND_ASSIGN(H264ByteToUnitStreamConverter);
 };
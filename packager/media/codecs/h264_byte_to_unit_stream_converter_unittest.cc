@@ -42,6 +42,19 @@ TEST(H264ByteToUnitStreamConverter, ConversionSuccess) {
   std::vector<uint8_t> decoder_config;
   ASSERT_TRUE(converter.GetDecoderConfigurationRecord(&decoder_config));
   EXPECT_EQ(expected_decoder_config, decoder_config);
+
+  // Requesting the record again, or after re-converting a frame with the same
+  // parameter sets, returns the cached record.
+  decoder_config.clear();
+  ASSERT_TRUE(converter.GetDecoderConfigurationRecord(&decoder_config));
+  EXPECT_EQ(expected_decoder_config, decoder_config);
+
+  ASSERT_TRUE(converter.ConvertByteStreamToNalUnitStream(input_frame.data(),
+                                                         input_frame.size(),
+                                                         &output_frame));
+  decoder_config.clear();
+  ASSERT_TRUE(converter.GetDecoderConfigurationRecord(&decoder_config));
+  EXPECT_EQ(expected_decoder_config, decoder_config);
 }
 
 TEST(H264ByteToUnitStreamConverter, ConversionFailure) {
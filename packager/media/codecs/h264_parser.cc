@@ -4,6 +4,8 @@
 
 #include "packager/media/codecs/h264_parser.h"
 
+#include <string.h>
+
 #include "packager/base/logging.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/base/stl_util.h"
@@ -182,6 +184,32 @@ static const int kTableSarHeight[] = {
 COMPILE_ASSERT(arraysize(kTableSarWidth) == arraysize(kTableSarHeight),
                sar_tables_must_have_same_size);
 
+// Returns the id of the entry in |cache| whose NALU bytes equal those of
+// |nalu|, or -1 if there is none. The cache holds at most one entry per
+// parameter set id, so a linear scan is cheap.
+static int FindParameterSetByNaluBytes(
+    const std::map<int, std::vector<uint8_t> >& cache,
+    const Nalu& nalu) {
+  const uint64_t nalu_size = nalu.header_size() + nalu.payload_size();
+  for (std::map<int, std::vector<uint8_t> >::const_iterator it = cache.begin();
+       it != cache.end(); ++it) {
+    if (it->second.size() == nalu_size &&
+        memcmp(&it->second[0], nalu.data(), nalu_size) == 0) {
+      return it->first;
+    }
+  }
+  return -1;
+}
+
+static void StoreParameterSetNaluBytes(
+    const Nalu& nalu,
+    int id,
+    std::map<int, std::vector<uint8_t> >* cache) {
+  const uint8_t* nalu_bytes = nalu.data();
+  (*cache)[id].assign(
+      nalu_bytes, nalu_bytes + nalu.header_size() + nalu.payload_size());
+}
+
 H264Parser::H264Parser() {}
 
 H264Parser::~H264Parser() {
@@ -534,14 +562,18 @@ H264Parser::Result H264Parser::ParseVUIParameters(H26xBitReader* br,
     READ_UE_OR_RETURN(&data);  // chroma_sample_loc_type_bottom_field
   }
 
-  // Read and ignore timing info.
-  READ_BOOL_OR_RETURN(&data);  // timing_info_present_flag
-  if (data) {
-    READ_BITS_OR_RETURN(16, &data);  // num_units_in_tick
-    READ_BITS_OR_RETURN(16, &data);  // num_units_in_tick
-    READ_BITS_OR_RETURN(16, &data);  // time_scale
-    READ_BITS_OR_RETURN(16, &data);  // time_scale
-    READ_BOOL_OR_RETURN(&data);  // fixed_frame_rate_flag
+  READ_BOOL_OR_RETURN(&sps->timing_info_present_flag);
+  if (sps->timing_info_present_flag) {
+    // Both fields are 32 bits wide; the bit reader caps reads at 31 bits,
+    // so read them in two halves.
+    int high;
+    READ_BITS_OR_RETURN(16, &high);
+    READ_BITS_OR_RETURN(16, &data);
+    sps->num_units_in_tick = (high << 16) | data;
+    READ_BITS_OR_RETURN(16, &high);
+    READ_BITS_OR_RETURN(16, &data);
+    sps->time_scale = (high << 16) | data;
+    READ_BOOL_OR_RETURN(&sps->fixed_frame_rate_flag);
   }
 
   // Read and ignore NAL HRD parameters, if present.
@@ -596,6 +628,15 @@ H264Parser::Result H264Parser::ParseSps(const Nalu& nalu, int* sps_id) {
 
   *sps_id = -1;
 
+  // Live encoders typically repeat the same SPS in-band ahead of every IDR;
+  // skip re-parsing when the bytes match an already active SPS.
+  const int cached_sps_id =
+      FindParameterSetByNaluBytes(active_sps_nalu_bytes_, nalu);
+  if (cached_sps_id != -1) {
+    *sps_id = cached_sps_id;
+    return kOk;
+  }
+
   scoped_ptr<H264Sps> sps(new H264Sps());
 
   READ_BITS_OR_RETURN(8, &sps->profile_idc);
@@ -705,6 +746,11 @@ H264Parser::Result H264Parser::ParseSps(const Nalu& nalu, int* sps_id) {
   delete active_SPSes_[*sps_id];
   active_SPSes_[*sps_id] = sps.release();
 
+  StoreParameterSetNaluBytes(nalu, *sps_id, &active_sps_nalu_bytes_);
+  // A PPS parse reads the active SPS (e.g. for scaling list fallbacks), so
+  // cached PPS bytes cannot be trusted once an SPS changes.
+  active_pps_nalu_bytes_.clear();
+
   return kOk;
 }
 
@@ -718,6 +764,15 @@ H264Parser::Result H264Parser::ParsePps(const Nalu& nalu, int* pps_id) {
 
   *pps_id = -1;
 
+  // As with SPSes, identical PPS repetitions are common; skip re-parsing
+  // when the bytes match an already active PPS.
+  const int cached_pps_id =
+      FindParameterSetByNaluBytes(active_pps_nalu_bytes_, nalu);
+  if (cached_pps_id != -1) {
+    *pps_id = cached_pps_id;
+    return kOk;
+  }
+
   scoped_ptr<H264Pps> pps(new H264Pps());
 
   READ_UE_OR_RETURN(&pps->pic_parameter_set_id);
@@ -779,6 +834,8 @@ H264Parser::Result H264Parser::ParsePps(const Nalu& nalu, int* pps_id) {
   delete active_PPSes_[*pps_id];
   active_PPSes_[*pps_id] = pps.release();
 
+  StoreParameterSetNaluBytes(nalu, *pps_id, &active_pps_nalu_bytes_);
+
   return kOk;
 }
 
@@ -1128,13 +1185,41 @@ H264Parser::Result H264Parser::ParseSliceHeader(const Nalu& nalu,
   return kOk;
 }
 
-H264Parser::Result H264Parser::ParseSEI(const Nalu& nalu,
-                                        H264SEIMessage* sei_msg) {
-  int byte;
+H264Parser::Result H264Parser::ParseSliceHeaderUpToPpsId(
+    const Nalu& nalu,
+    H264SliceHeader* shdr) {
+  // See 7.4.3. Reads only the fields before the parameter set dependent part
+  // of the header; everything after pic_parameter_set_id is skipped.
   H26xBitReader reader;
   reader.Initialize(nalu.data() + nalu.header_size(), nalu.payload_size());
   H26xBitReader* br = &reader;
 
+  memset(shdr, 0, sizeof(*shdr));
+
+  shdr->idr_pic_flag = (nalu.type() == 5);
+  shdr->nal_ref_idc = nalu.ref_idc();
+  shdr->nalu_data = nalu.data() + nalu.header_size();
+  shdr->nalu_size = nalu.payload_size();
+
+  READ_UE_OR_RETURN(&shdr->first_mb_in_slice);
+  READ_UE_OR_RETURN(&shdr->slice_type);
+  TRUE_OR_RETURN(shdr->slice_type < 10);
+
+  READ_UE_OR_RETURN(&shdr->pic_parameter_set_id);
+
+  // Still resolve the referenced parameter sets so a slice referencing a
+  // missing PPS or SPS fails here, as it does in the full parse.
+  const H264Pps* pps = GetPps(shdr->pic_parameter_set_id);
+  TRUE_OR_RETURN(pps);
+  TRUE_OR_RETURN(GetSps(pps->seq_parameter_set_id));
+
+  return kOk;
+}
+
+H264Parser::Result H264Parser::ParseSEIMessage(H26xBitReader* br,
+                                               H264SEIMessage* sei_msg) {
+  int byte;
+
   memset(sei_msg, 0, sizeof(*sei_msg));
 
   READ_BITS_OR_RETURN(8, &byte);
@@ -1154,7 +1239,20 @@ H264Parser::Result H264Parser::ParseSEI(const Nalu& nalu,
   DVLOG(4) << "Found SEI message type: " << sei_msg->type
            << " payload size: " << sei_msg->payload_size;
 
+  const off_t bits_left_before_payload = br->NumBitsLeft();
+
   switch (sei_msg->type) {
+    case H264SEIMessage::kSEIUserDataRegisteredItuTT35:
+      if (sei_msg->payload_size <=
+          H264SEIUserDataRegistered::kMaxPayloadSize) {
+        for (int i = 0; i < sei_msg->payload_size; ++i) {
+          READ_BITS_OR_RETURN(8, &byte);
+          sei_msg->user_data_registered.payload[i] = byte;
+        }
+        sei_msg->user_data_registered.payload_size = sei_msg->payload_size;
+      }
+      break;
+
     case H264SEIMessage::kSEIRecoveryPoint:
       READ_UE_OR_RETURN(&sei_msg->recovery_point.recovery_frame_cnt);
       READ_BOOL_OR_RETURN(&sei_msg->recovery_point.exact_match_flag);
@@ -1167,6 +1265,39 @@ H264Parser::Result H264Parser::ParseSEI(const Nalu& nalu,
       break;
   }
 
+  // Skip over any unread payload bits (unsupported or oversized messages,
+  // byte-alignment padding of parsed messages), so the reader is positioned
+  // at the next SEI message of the NALU.
+  const off_t payload_bits = static_cast<off_t>(sei_msg->payload_size) * 8;
+  const off_t bits_read = bits_left_before_payload - br->NumBitsLeft();
+  TRUE_OR_RETURN(bits_read <= payload_bits);
+  if (bits_read < payload_bits)
+    TRUE_OR_RETURN(br->SkipBits(payload_bits - bits_read));
+
+  return kOk;
+}
+
+H264Parser::Result H264Parser::ParseSEI(const Nalu& nalu,
+                                        H264SEIMessage* sei_msg) {
+  H26xBitReader reader;
+  reader.Initialize(nalu.data() + nalu.header_size(), nalu.payload_size());
+  return ParseSEIMessage(&reader, sei_msg);
+}
+
+H264Parser::Result H264Parser::ParseAllSEI(
+    const Nalu& nalu,
+    std::vector<H264SEIMessage>* sei_msgs) {
+  H26xBitReader reader;
+  reader.Initialize(nalu.data() + nalu.header_size(), nalu.payload_size());
+
+  sei_msgs->clear();
+  while (reader.HasMoreRBSPData()) {
+    H264SEIMessage sei_msg;
+    Result result = ParseSEIMessage(&reader, &sei_msg);
+    if (result != kOk)
+      return result;
+    sei_msgs->push_back(sei_msg);
+  }
   return kOk;
 }
 
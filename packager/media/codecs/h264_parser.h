@@ -11,6 +11,7 @@
 #include <stdlib.h>
 
 #include <map>
+#include <vector>
 
 #include "packager/media/codecs/h26x_bit_reader.h"
 #include "packager/media/codecs/nalu_reader.h"
@@ -81,6 +82,10 @@ struct H264Sps {
   bool vui_parameters_present_flag;
   int sar_width;    // Set to 0 when not specified.
   int sar_height;   // Set to 0 when not specified.
+  bool timing_info_present_flag;
+  int num_units_in_tick;       // Valid iff timing_info_present_flag.
+  int time_scale;              // Valid iff timing_info_present_flag.
+  bool fixed_frame_rate_flag;  // Valid iff timing_info_present_flag.
   bool bitstream_restriction_flag;
   int max_num_reorder_frames;
   int max_dec_frame_buffering;
@@ -223,10 +228,20 @@ struct H264SEIRecoveryPoint {
   int changing_slice_group_idc;
 };
 
+struct H264SEIUserDataRegistered {
+  // Large enough for ATSC A/72 caption payloads, which carry at most 31
+  // 3-byte cc constructs; larger payloads are skipped and leave
+  // |payload_size| at 0.
+  enum { kMaxPayloadSize = 255 };
+  uint8_t payload[kMaxPayloadSize];
+  int payload_size;
+};
+
 struct H264SEIMessage {
   H264SEIMessage();
 
   enum Type {
+    kSEIUserDataRegisteredItuTT35 = 4,
     kSEIRecoveryPoint = 6,
   };
 
@@ -236,6 +251,7 @@ struct H264SEIMessage {
     // Placeholder; in future more supported types will contribute to more
     // union members here.
     H264SEIRecoveryPoint recovery_point;
+    H264SEIUserDataRegistered user_data_registered;
   };
 };
 
@@ -280,11 +296,28 @@ class H264Parser {
   // the NALU returned from AdvanceToNextNALU() and corresponding to |*shdr|.
   Result ParseSliceHeader(const Nalu& nalu, H264SliceHeader* shdr);
 
-  // Parse a SEI message, returning it in |*sei_msg|, provided and managed
-  // by the caller.
+  // Lazy variant of ParseSliceHeader: parses only the leading fields up to
+  // and including pic_parameter_set_id and verifies the referenced parameter
+  // sets are known, leaving the remaining fields of |*shdr| zeroed. Much
+  // cheaper than a full parse when the caller only needs the slice type and
+  // PPS id, e.g. for access unit boundary detection. |shdr->header_bit_size|
+  // is not computed; use ParseSliceHeader when it is needed.
+  Result ParseSliceHeaderUpToPpsId(const Nalu& nalu, H264SliceHeader* shdr);
+
+  // Parse the first SEI message of a SEI NALU, returning it in |*sei_msg|,
+  // provided and managed by the caller.
   Result ParseSEI(const Nalu& nalu, H264SEIMessage* sei_msg);
 
+  // Parse all SEI messages of a SEI NALU, appending them to |*sei_msgs|.
+  // Unsupported message types are returned with only |type| and
+  // |payload_size| set.
+  Result ParseAllSEI(const Nalu& nalu, std::vector<H264SEIMessage>* sei_msgs);
+
  private:
+  // Parse a single SEI message at the current position of |br|, skipping over
+  // any unread payload bytes so the reader ends up at the next message.
+  Result ParseSEIMessage(H26xBitReader* br, H264SEIMessage* sei_msg);
+
   // Parse scaling lists (see spec).
   Result ParseScalingList(H26xBitReader* br,
                           int size,
@@ -329,6 +362,12 @@ class H264Parser {
   SpsById active_SPSes_;
   PpsById active_PPSes_;
 
+  // Raw NALU bytes of the active parameter sets above, used by ParseSps and
+  // ParsePps to skip re-parsing parameter sets that encoders repeat in-band
+  // with identical content.
+  std::map<int, std::vector<uint8_t> > active_sps_nalu_bytes_;
+  std::map<int, std::vector<uint8_t> > active_pps_nalu_bytes_;
+
   DISALLOW_COPY_AND_ASSIGN(H264Parser);
 };
 
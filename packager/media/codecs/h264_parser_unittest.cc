@@ -41,9 +41,19 @@ TEST(H264ParserTest, StreamFileParsing) {
     int id;
     switch (nalu.type()) {
       case Nalu::H264_IDRSlice:
-      case Nalu::H264_NonIDRSlice:
+      case Nalu::H264_NonIDRSlice: {
         ASSERT_EQ(parser.ParseSliceHeader(nalu, &shdr), H264Parser::kOk);
+
+        // The lazy parse must agree with the full parse on the fields it
+        // extracts.
+        H264SliceHeader lazy_shdr;
+        ASSERT_EQ(parser.ParseSliceHeaderUpToPpsId(nalu, &lazy_shdr),
+                  H264Parser::kOk);
+        EXPECT_EQ(shdr.first_mb_in_slice, lazy_shdr.first_mb_in_slice);
+        EXPECT_EQ(shdr.slice_type, lazy_shdr.slice_type);
+        EXPECT_EQ(shdr.pic_parameter_set_id, lazy_shdr.pic_parameter_set_id);
         break;
+      }
 
       case Nalu::H264_SPS:
         ASSERT_EQ(parser.ParseSps(nalu, &id), H264Parser::kOk);
@@ -65,6 +75,27 @@ TEST(H264ParserTest, StreamFileParsing) {
   }
 }
 
+TEST(H264ParserTest, RepeatedSpsReturnsSameId) {
+  const uint8_t kSps[] = {0x67, 0x64, 0x00, 0x1E, 0xAC, 0xD9, 0x40, 0xB4,
+                          0x2F, 0xF9, 0x7F, 0xF0, 0x00, 0x80, 0x00, 0x91,
+                          0x00, 0x00, 0x03, 0x03, 0xE9, 0x00, 0x00, 0xEA,
+                          0x60, 0x0F, 0x16, 0x2D, 0x96};
+
+  H264Parser parser;
+  int sps_id = 0;
+  Nalu nalu;
+  ASSERT_TRUE(nalu.Initialize(Nalu::kH264, kSps, arraysize(kSps)));
+  ASSERT_EQ(H264Parser::kOk, parser.ParseSps(nalu, &sps_id));
+  const H264Sps* sps = parser.GetSps(sps_id);
+  ASSERT_TRUE(sps);
+
+  // A repeated identical SPS short-circuits to the active one.
+  int repeated_sps_id = -1;
+  ASSERT_EQ(H264Parser::kOk, parser.ParseSps(nalu, &repeated_sps_id));
+  EXPECT_EQ(sps_id, repeated_sps_id);
+  EXPECT_EQ(sps, parser.GetSps(repeated_sps_id));
+}
+
 TEST(H264ParserTest, ExtractResolutionFromSpsData) {
   const uint8_t kSps[] = {0x67, 0x64, 0x00, 0x1E, 0xAC, 0xD9, 0x40, 0xB4,
                           0x2F, 0xF9, 0x7F, 0xF0, 0x00, 0x80, 0x00, 0x91,
@@ -115,5 +146,49 @@ TEST(H264ParserTest, ExtractResolutionFromSpsDataWithCropping) {
   EXPECT_EQ(1u, pixel_height);
 }
 
+TEST(H264ParserTest, ParseAllSEIMessages) {
+  // A SEI NALU with two messages: a recovery point followed by a
+  // user_data_registered_itu_t_t35 message carrying an ATSC A/72 caption
+  // payload with two cc constructs.
+  const uint8_t kSei[] = {
+      // NALU header.
+      0x06,
+      // Recovery point: type 6, payload size 1, payload (recovery_frame_cnt
+      // 0, exact_match_flag 1, broken_link_flag 0, changing_slice_group_idc
+      // 0, alignment bits).
+      0x06, 0x01, 0xC4,
+      // User data registered: type 4, payload size 17.
+      0x04, 0x11,
+      // Country code, provider code, 'GA94', user_data_type_code.
+      0xB5, 0x00, 0x31, 0x47, 0x41, 0x39, 0x34, 0x03,
+      // process_cc_data_flag set, cc_count 2; em_data.
+      0x42, 0xFF,
+      // Two cc constructs.
+      0xFC, 0x20, 0x41, 0xFD, 0x42, 0x43,
+      // marker_bits.
+      0xFF,
+      // rbsp_trailing_bits.
+      0x80};
+
+  H264Parser parser;
+  Nalu nalu;
+  ASSERT_TRUE(nalu.Initialize(Nalu::kH264, kSei, arraysize(kSei)));
+
+  std::vector<H264SEIMessage> sei_msgs;
+  ASSERT_EQ(H264Parser::kOk, parser.ParseAllSEI(nalu, &sei_msgs));
+  ASSERT_EQ(2u, sei_msgs.size());
+
+  EXPECT_EQ(H264SEIMessage::kSEIRecoveryPoint, sei_msgs[0].type);
+  EXPECT_EQ(0, sei_msgs[0].recovery_point.recovery_frame_cnt);
+  EXPECT_TRUE(sei_msgs[0].recovery_point.exact_match_flag);
+  EXPECT_FALSE(sei_msgs[0].recovery_point.broken_link_flag);
+
+  EXPECT_EQ(H264SEIMessage::kSEIUserDataRegisteredItuTT35, sei_msgs[1].type);
+  ASSERT_EQ(17, sei_msgs[1].user_data_registered.payload_size);
+  EXPECT_EQ(0xB5, sei_msgs[1].user_data_registered.payload[0]);
+  EXPECT_EQ(0xFC, sei_msgs[1].user_data_registered.payload[10]);
+  EXPECT_EQ(0x43, sei_msgs[1].user_data_registered.payload[15]);
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -6,6 +6,8 @@
 
 #include "packager/media/codecs/h265_byte_to_unit_stream_converter.h"
 
+#include <string.h>
+
 #include <limits>
 
 #include "packager/base/logging.h"
@@ -29,6 +31,11 @@ bool H265ByteToUnitStreamConverter::GetDecoderConfigurationRecord(
     return false;
   }
 
+  if (!decoder_config_cache_.empty()) {
+    *decoder_config = decoder_config_cache_;
+    return true;
+  }
+
   // We need to parse the SPS to get the data to add to the record.
   int id;
   Nalu nalu;
@@ -88,6 +95,7 @@ bool H265ByteToUnitStreamConverter::GetDecoderConfigurationRecord(
   buffer.AppendVector(last_vps_);
 
   buffer.SwapBuffer(decoder_config);
+  decoder_config_cache_ = *decoder_config;
   return true;
 }
 
@@ -100,16 +108,29 @@ bool H265ByteToUnitStreamConverter::ProcessNalu(const Nalu& nalu) {
 
   switch (nalu.type()) {
     case Nalu::H265_SPS:
-      // Grab SPS NALU.
-      last_sps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+      // Grab SPS NALU. Parameter sets are typically repeated unchanged, so
+      // only a different one invalidates the cached record.
+      if (last_sps_.size() != nalu_size ||
+          memcmp(last_sps_.data(), nalu_ptr, nalu_size) != 0) {
+        last_sps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+        decoder_config_cache_.clear();
+      }
       return true;
     case Nalu::H265_PPS:
       // Grab PPS NALU.
-      last_pps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+      if (last_pps_.size() != nalu_size ||
+          memcmp(last_pps_.data(), nalu_ptr, nalu_size) != 0) {
+        last_pps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+        decoder_config_cache_.clear();
+      }
       return true;
     case Nalu::H265_VPS:
       // Grab VPS NALU.
-      last_vps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+      if (last_vps_.size() != nalu_size ||
+          memcmp(last_vps_.data(), nalu_ptr, nalu_size) != 0) {
+        last_vps_.assign(nalu_ptr, nalu_ptr + nalu_size);
+        decoder_config_cache_.clear();
+      }
       return true;
     case Nalu::H265_AUD:
       // Ignore AUD NALU.
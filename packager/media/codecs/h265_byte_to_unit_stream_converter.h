@@ -36,6 +36,10 @@ class H265ByteToUnitStreamConverter : public H26xByteToUnitStreamConverter {
   std::vector<uint8_t> last_sps_;
   std::vector<uint8_t> last_pps_;
   std::vector<uint8_t> last_vps_;
+  // Serialized record built on first request; cleared whenever a different
+  // parameter set is seen in the stream. Rebuilding it involves a full SPS
+  // parse, so the cache saves real work when parameter sets repeat.
+  mutable std::vector<uint8_t> decoder_config_cache_;
 
   DISALLOW_COPY_AND_ASSIGN(H265ByteToUnitStreamConverter);
 };
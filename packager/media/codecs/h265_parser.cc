@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <math.h>
+#include <string.h>
 
 #include "packager/base/logging.h"
 #include "packager/base/stl_util.h"
@@ -33,6 +34,32 @@ namespace shaka {
 namespace media {
 
 namespace {
+
+// Looks up the entry in |cache| whose NALU bytes equal those of |nalu| and
+// returns its id, or -1 when nothing matches. There is at most one entry per
+// parameter set id, so the scan only touches a handful of entries.
+int FindParameterSetByNaluBytes(
+    const std::map<int, std::vector<uint8_t> >& cache,
+    const Nalu& nalu) {
+  const uint64_t nalu_size = nalu.header_size() + nalu.payload_size();
+  for (std::map<int, std::vector<uint8_t> >::const_iterator it = cache.begin();
+       it != cache.end(); ++it) {
+    if (it->second.size() == nalu_size &&
+        memcmp(&it->second[0], nalu.data(), nalu_size) == 0) {
+      return it->first;
+    }
+  }
+  return -1;
+}
+
+void StoreParameterSetNaluBytes(const Nalu& nalu,
+                                int id,
+                                std::map<int, std::vector<uint8_t> >* cache) {
+  const uint8_t* nalu_bytes = nalu.data();
+  (*cache)[id].assign(
+      nalu_bytes, nalu_bytes + nalu.header_size() + nalu.payload_size());
+}
+
 int GetNumPicTotalCurr(const H265SliceHeader& slice_header,
                        const H265Sps& sps) {
   int num_pic_total_curr = 0;
@@ -401,6 +428,35 @@ H265Parser::Result H265Parser::ParseSliceHeader(const Nalu& nalu,
   return kOk;
 }
 
+H265Parser::Result H265Parser::ParseSliceHeaderUpToPpsId(
+    const Nalu& nalu,
+    H265SliceHeader* slice_header) {
+  DCHECK(nalu.is_video_slice());
+  *slice_header = H265SliceHeader();
+
+  // Parses only the fields before the parameter set dependent part of the
+  // header; everything after pic_parameter_set_id is skipped.
+  H26xBitReader reader;
+  reader.Initialize(nalu.data() + nalu.header_size(), nalu.payload_size());
+  H26xBitReader* br = &reader;
+
+  TRUE_OR_RETURN(br->ReadBool(&slice_header->first_slice_segment_in_pic_flag));
+  if (nalu.type() >= Nalu::H265_BLA_W_LP &&
+      nalu.type() <= Nalu::H265_RSV_IRAP_VCL23) {
+    TRUE_OR_RETURN(br->ReadBool(&slice_header->no_output_of_prior_pics_flag));
+  }
+
+  TRUE_OR_RETURN(br->ReadUE(&slice_header->pic_parameter_set_id));
+
+  // Still resolve the referenced parameter sets so a slice referencing a
+  // missing PPS or SPS fails here, as it does in the full parse.
+  const H265Pps* pps = GetPps(slice_header->pic_parameter_set_id);
+  TRUE_OR_RETURN(pps);
+  TRUE_OR_RETURN(GetSps(pps->seq_parameter_set_id));
+
+  return kOk;
+}
+
 H265Parser::Result H265Parser::ParsePps(const Nalu& nalu, int* pps_id) {
   DCHECK_EQ(Nalu::H265_PPS, nalu.type());
 
@@ -410,6 +466,16 @@ H265Parser::Result H265Parser::ParsePps(const Nalu& nalu, int* pps_id) {
   H26xBitReader* br = &reader;
 
   *pps_id = -1;
+
+  // Encoders repeat identical parameter sets in-band; skip re-parsing when
+  // the bytes match an already active PPS.
+  const int cached_pps_id =
+      FindParameterSetByNaluBytes(active_pps_nalu_bytes_, nalu);
+  if (cached_pps_id != -1) {
+    *pps_id = cached_pps_id;
+    return kOk;
+  }
+
   scoped_ptr<H265Pps> pps(new H265Pps);
 
   TRUE_OR_RETURN(br->ReadUE(&pps->pic_parameter_set_id));
@@ -507,6 +573,8 @@ H265Parser::Result H265Parser::ParsePps(const Nalu& nalu, int* pps_id) {
   delete active_ppses_[*pps_id];
   active_ppses_[*pps_id] = pps.release();
 
+  StoreParameterSetNaluBytes(nalu, *pps_id, &active_pps_nalu_bytes_);
+
   return kOk;
 }
 
@@ -520,6 +588,15 @@ H265Parser::Result H265Parser::ParseSps(const Nalu& nalu, int* sps_id) {
 
   *sps_id = -1;
 
+  // Encoders repeat identical parameter sets in-band; skip re-parsing when
+  // the bytes match an already active SPS.
+  const int cached_sps_id =
+      FindParameterSetByNaluBytes(active_sps_nalu_bytes_, nalu);
+  if (cached_sps_id != -1) {
+    *sps_id = cached_sps_id;
+    return kOk;
+  }
+
   scoped_ptr<H265Sps> sps(new H265Sps);
 
   TRUE_OR_RETURN(br->ReadBits(4, &sps->video_parameter_set_id));
@@ -624,6 +701,8 @@ H265Parser::Result H265Parser::ParseSps(const Nalu& nalu, int* sps_id) {
   delete active_spses_[*sps_id];
   active_spses_[*sps_id] = sps.release();
 
+  StoreParameterSetNaluBytes(nalu, *sps_id, &active_sps_nalu_bytes_);
+
   return kOk;
 }
 
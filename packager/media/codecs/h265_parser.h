@@ -291,6 +291,15 @@ class H265Parser {
   /// contents of |*slice_header| are undefined.
   Result ParseSliceHeader(const Nalu& nalu, H265SliceHeader* slice_header);
 
+  /// Lazy variant of ParseSliceHeader: parses only the leading fields up to
+  /// and including pic_parameter_set_id and verifies the referenced parameter
+  /// sets are known, leaving the remaining fields default initialized.  Much
+  /// cheaper than a full parse when the caller only needs the PPS id, e.g.
+  /// for access unit boundary detection.  |slice_header->header_bit_size| is
+  /// not computed; use ParseSliceHeader when it is needed.
+  Result ParseSliceHeaderUpToPpsId(const Nalu& nalu,
+                                   H265SliceHeader* slice_header);
+
   /// Parses a PPS element.  This object is owned and managed by this class.
   /// The unique ID of the parsed PPS is stored in |*pps_id| if kOk is returned.
   Result ParsePps(const Nalu& nalu, int* pps_id);
@@ -348,6 +357,12 @@ class H265Parser {
   SpsById active_spses_;
   PpsById active_ppses_;
 
+  // Raw NALU bytes of the active parameter sets above, used by ParseSps and
+  // ParsePps to skip re-parsing parameter sets that encoders repeat in-band
+  // with identical content.
+  std::map<int, std::vector<uint8_t> > active_sps_nalu_bytes_;
+  std::map<int, std::vector<uint8_t> > active_pps_nalu_bytes_;
+
   DISALLOW_COPY_AND_ASSIGN(H265Parser);
 };
 
@@ -58,6 +58,25 @@ TEST(H265ParserTest, ParseSliceHeader) {
   EXPECT_EQ(85, header.header_bit_size);
 }
 
+TEST(H265ParserTest, ParseSliceHeaderUpToPpsId) {
+  // Parse the SPS and PPS first so the data is available.
+  int id;
+  Nalu nalu;
+  H265Parser parser;
+  ASSERT_TRUE(nalu.Initialize(Nalu::kH265, kSpsData, arraysize(kSpsData)));
+  ASSERT_EQ(H265Parser::kOk, parser.ParseSps(nalu, &id));
+  ASSERT_TRUE(nalu.Initialize(Nalu::kH265, kPpsData, arraysize(kPpsData)));
+  ASSERT_EQ(H265Parser::kOk, parser.ParsePps(nalu, &id));
+
+  // The lazy parse extracts the leading fields only.
+  ASSERT_TRUE(nalu.Initialize(Nalu::kH265, kSliceData, arraysize(kSliceData)));
+  H265SliceHeader header;
+  ASSERT_EQ(H265Parser::kOk, parser.ParseSliceHeaderUpToPpsId(nalu, &header));
+
+  EXPECT_TRUE(header.first_slice_segment_in_pic_flag);
+  EXPECT_EQ(0, header.pic_parameter_set_id);
+}
+
 TEST(H265ParserTest, ParseSliceHeader_NonIDR) {
   // Parse the SPS and PPS first so the data is available.
   int id;
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "packager/base/bits.h"
 #include "packager/base/logging.h"
 #include "packager/media/codecs/h26x_bit_reader.h"
 
@@ -99,16 +100,33 @@ bool H26xBitReader::SkipBits(int num_bits) {
 }
 
 bool H26xBitReader::ReadUE(int* val) {
-  int num_bits = -1;
-  int bit;
+  int num_bits = 0;
   int rest;
 
-  // Count the number of contiguous zero bits.
-  do {
-    if (!ReadBits(1, &bit))
+  // Count the number of contiguous zero bits a byte at a time instead of
+  // calling ReadBits() once per bit. Emulation prevention bytes have to be
+  // stripped during refill, so the stream can only be consumed bytewise;
+  // within a byte the position of the terminating one bit is found with a
+  // leading zero count.
+  while (true) {
+    if (num_remaining_bits_in_curr_byte_ == 0 && !UpdateCurrByte())
       return false;
-    num_bits++;
-  } while (bit == 0);
+
+    const int remaining_bits =
+        curr_byte_ & ((1 << num_remaining_bits_in_curr_byte_) - 1);
+    if (remaining_bits != 0) {
+      // The terminating one bit is in the current byte.
+      const int one_bit_pos = base::bits::Log2Floor(remaining_bits);
+      num_bits += num_remaining_bits_in_curr_byte_ - 1 - one_bit_pos;
+      // Consume the zero run and the terminating one bit.
+      num_remaining_bits_in_curr_byte_ = one_bit_pos;
+      break;
+    }
+
+    // The rest of the current byte is all zeros.
+    num_bits += num_remaining_bits_in_curr_byte_;
+    num_remaining_bits_in_curr_byte_ = 0;
+  }
 
   if (num_bits > 31)
     return false;
@@ -97,6 +97,28 @@ TEST(H26xBitReaderTest, SkipBits) {
   EXPECT_FALSE(reader.SkipBits(5));
 }
 
+TEST(H26xBitReaderTest, ReadUE) {
+  H26xBitReader reader;
+  // Codes: 1 (value 0), 010 (value 1), 00100 (value 3),
+  // 00000000100000001 (value 256), then zero padding.
+  const unsigned char rbsp[] = {0xa2, 0x00, 0x40, 0x40};
+  int value = 0;
+
+  EXPECT_TRUE(reader.Initialize(rbsp, sizeof(rbsp)));
+
+  EXPECT_TRUE(reader.ReadUE(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(reader.ReadUE(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(reader.ReadUE(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_TRUE(reader.ReadUE(&value));
+  EXPECT_EQ(256, value);
+
+  // Only zero bits remain: reading another code runs off the end.
+  EXPECT_FALSE(reader.ReadUE(&value));
+}
+
 TEST(H26xBitReaderTest, StopBitOccupyFullByte) {
   H26xBitReader reader;
   const unsigned char rbsp[] = {0xab, 0x80};
@@ -14,12 +14,6 @@
 namespace shaka {
 namespace media {
 
-namespace {
-// Additional space to reserve for output frame. This value ought to be enough
-// to acommodate frames consisting of 100 NAL units with 3-byte start codes.
-const size_t kStreamConversionOverhead = 100;
-}
-
 H26xByteToUnitStreamConverter::H26xByteToUnitStreamConverter(
     Nalu::CodecType type)
     : type_(type) {}
@@ -32,8 +26,6 @@ bool H26xByteToUnitStreamConverter::ConvertByteStreamToNalUnitStream(
   DCHECK(input_frame);
   DCHECK(output_frame);
 
-  BufferWriter output_buffer(input_frame_size + kStreamConversionOverhead);
-
   Nalu nalu;
   NaluReader reader(type_, kIsAnnexbByteStream, input_frame, input_frame_size);
   if (!reader.StartsWithStartCode()) {
@@ -41,6 +33,11 @@ bool H26xByteToUnitStreamConverter::ConvertByteStreamToNalUnitStream(
     return false;
   }
 
+  // Scan pass: record the NAL units to keep and compute the exact output
+  // size, so the output buffer below is allocated once instead of regrowing
+  // as units are appended.
+  kept_nalus_.clear();
+  size_t output_size = 0;
   while (reader.Advance(&nalu) == NaluReader::kOk) {
     const uint64_t nalu_size = nalu.payload_size() + nalu.header_size();
     DCHECK_LE(nalu_size, std::numeric_limits<uint32_t>::max());
@@ -48,9 +45,18 @@ bool H26xByteToUnitStreamConverter::ConvertByteStreamToNalUnitStream(
     if (ProcessNalu(nalu))
       continue;
 
-    // Append 4-byte length and NAL unit data to the buffer.
-    output_buffer.AppendInt(static_cast<uint32_t>(nalu_size));
-    output_buffer.AppendArray(nalu.data(), nalu_size);
+    NaluRange range;
+    range.data = nalu.data();
+    range.size = static_cast<uint32_t>(nalu_size);
+    kept_nalus_.push_back(range);
+    output_size += kUnitStreamNaluLengthSize + range.size;
+  }
+
+  // Write pass: append 4-byte length and NAL unit data to the buffer.
+  BufferWriter output_buffer(output_size);
+  for (size_t i = 0; i < kept_nalus_.size(); ++i) {
+    output_buffer.AppendInt(kept_nalus_[i].size);
+    output_buffer.AppendArray(kept_nalus_[i].data, kept_nalus_[i].size);
   }
 
   output_buffer.SwapBuffer(output_frame);
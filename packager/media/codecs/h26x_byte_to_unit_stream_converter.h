@@ -52,7 +52,16 @@ class H26xByteToUnitStreamConverter {
   // not be copied to the buffer.
   virtual bool ProcessNalu(const Nalu& nalu) = 0;
 
+  // A NAL unit to be copied to the output stream, recorded during the scan
+  // pass of ConvertByteStreamToNalUnitStream().
+  struct NaluRange {
+    const uint8_t* data;
+    uint32_t size;
+  };
+
   Nalu::CodecType type_;
+  // Reused across frames to avoid a per-frame allocation.
+  std::vector<NaluRange> kept_nalus_;
 
   DISALLOW_COPY_AND_ASSIGN(H26xByteToUnitStreamConverter);
 };
@@ -6,6 +6,8 @@
 
 #include "packager/media/codecs/nal_unit_to_byte_stream_converter.h"
 
+#include <string.h>
+
 #include <list>
 
 #include "packager/base/logging.h"
@@ -51,38 +53,41 @@ void AddAccessUnitDelimiter(BufferWriter* buffer_writer) {
 void EscapeNalByteSequence(const uint8_t* input,
                            size_t input_size,
                            BufferWriter* output_writer) {
-  // Keep track of consecutive zeros that it has seen (not including the current
-  // byte), so that the algorithm doesn't need to go back to check the same
-  // bytes.
-  int consecutive_zero_count = 0;
-  for (size_t i = 0; i < input_size; ++i) {
-    if (consecutive_zero_count <= 1) {
-      output_writer->AppendInt(input[i]);
-    } else if (consecutive_zero_count == 2) {
-      if (input[i] == 0 || input[i] == 1 || input[i] == 2 || input[i] == 3) {
-        // Must be escaped.
-        output_writer->AppendInt(kEmulationPreventionByte);
-      }
-
-      output_writer->AppendInt(input[i]);
-      // Note that input[i] can be 0.
+  // Locate the escape positions (a 00 00 pair followed by 00, 01, 02 or 03)
+  // with memchr and copy everything between them in single appends, so
+  // typical content is moved in large chunks instead of one byte at a time.
+  size_t chunk_start = 0;
+  size_t scan_position = 0;
+  while (scan_position + 2 < input_size) {
+    // The zero pair needs at least two bytes after its first zero.
+    const uint8_t* zero = reinterpret_cast<const uint8_t*>(
+        memchr(input + scan_position, 0x00, input_size - scan_position - 2));
+    if (!zero)
+      break;
+    const size_t zero_position = zero - input;
+    if (input[zero_position + 1] == 0x00 &&
+        input[zero_position + 2] <= kEmulationPreventionByte) {
+      // Must be escaped: emit everything up to and including the zero pair,
+      // then the emulation prevention byte.
+      output_writer->AppendArray(input + chunk_start,
+                                 zero_position + 2 - chunk_start);
+      output_writer->AppendInt(kEmulationPreventionByte);
+      chunk_start = zero_position + 2;
+      // Note that the escaped byte can be 0.
       // 00 00 00 00 00 00 should become
       // 00 00 03 00 00 03 00 00 03
-      // So consecutive_zero_count is reset here and incremented below if
-      // input[i] is 0.
-      consecutive_zero_count = 0;
+      // So the zero run restarts at the escaped byte.
+      scan_position = zero_position + 2;
+    } else {
+      scan_position = zero_position + 1;
     }
-
-    consecutive_zero_count = input[i] == 0 ? consecutive_zero_count + 1 : 0;
   }
+  output_writer->AppendArray(input + chunk_start, input_size - chunk_start);
 
   // ISO 14496-10 Section 7.4.1.1 mentions that if the last byte is 0 (which
   // only happens if RBSP has cabac_zero_word), 0x03 must be appended.
-  if (consecutive_zero_count > 0) {
-    DCHECK_GT(input_size, 0u);
-    DCHECK_EQ(input[input_size - 1], 0u);
+  if (input_size > 0 && input[input_size - 1] == 0x00)
     output_writer->AppendInt(kEmulationPreventionByte);
-  }
 }
 
 NalUnitToByteStreamConverter::NalUnitToByteStreamConverter()
@@ -6,6 +6,7 @@
 
 #include "packager/media/codecs/nalu_reader.h"
 
+#include <cstring>
 #include <iostream>
 
 #include "packager/base/logging.h"
@@ -247,31 +248,40 @@ bool NaluReader::FindStartCode(const uint8_t* data,
                                uint64_t data_size,
                                uint64_t* offset,
                                uint8_t* start_code_size) {
-  uint64_t bytes_left = data_size;
-
-  while (bytes_left >= 3) {
-    if (IsStartCode(data)) {
+  const uint8_t* current = data;
+  const uint8_t* const end = data + data_size;
+
+  // A start code begins with a zero byte, so jump between zero bytes with
+  // memchr instead of inspecting every byte; memchr is vectorized by the C
+  // library on common platforms. The last possible start code position is
+  // |end| - 3.
+  while (end - current >= 3) {
+    const uint8_t* zero = reinterpret_cast<const uint8_t*>(
+        memchr(current, 0x00, end - current - 2));
+    if (!zero)
+      break;
+    if (IsStartCode(zero)) {
       // Found three-byte start code, set pointer at its beginning.
-      *offset = data_size - bytes_left;
+      *offset = zero - data;
       *start_code_size = 3;
 
       // If there is a zero byte before this start code,
       // then it's actually a four-byte start code, so backtrack one byte.
-      if (*offset > 0 && *(data - 1) == 0x00) {
+      if (*offset > 0 && *(zero - 1) == 0x00) {
         --(*offset);
         ++(*start_code_size);
       }
 
       return true;
     }
-
-    ++data;
-    --bytes_left;
+    // Not a start code: if the byte after |zero| is non-zero, no start code
+    // can begin before |zero| + 2 either.
+    current = (zero[1] != 0x00) ? zero + 2 : zero + 1;
   }
 
   // End of data: offset is pointing to the first byte that was not considered
   // as a possible start of a start code.
-  *offset = data_size - bytes_left;
+  *offset = data_size >= 3 ? data_size - 2 : 0;
   *start_code_size = 0;
   return false;
 }
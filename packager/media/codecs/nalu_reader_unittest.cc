@@ -75,6 +75,37 @@ TEST(NaluReaderTest, StartCodeSearchWithStartCodeInsideNalUnit) {
   EXPECT_EQ(NaluReader::kEOStream, reader.Advance(&nalu));
 }
 
+TEST(NaluReaderTest, StartCodeSearchWithManyZeroBytes) {
+  const uint8_t kNaluData[] = {
+      // Zero runs that do not form a start code.
+      0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+      // First NALU, with a long run of leading zeros (four-byte start code).
+      0x00, 0x00, 0x00, 0x01, 0x14, 0x34, 0x56, 0x78,
+      // Second NALU.
+      0x00, 0x00, 0x01, 0x67, 0xbb, 0xcc, 0xdd,
+  };
+
+  NaluReader reader(Nalu::kH264, kIsAnnexbByteStream, kNaluData,
+                    arraysize(kNaluData));
+
+  Nalu nalu;
+  ASSERT_EQ(NaluReader::kOk, reader.Advance(&nalu));
+  EXPECT_EQ(kNaluData + 11, nalu.data());
+  EXPECT_EQ(3u, nalu.payload_size());
+  EXPECT_EQ(1u, nalu.header_size());
+  EXPECT_EQ(0, nalu.ref_idc());
+  EXPECT_EQ(0x14, nalu.type());
+
+  ASSERT_EQ(NaluReader::kOk, reader.Advance(&nalu));
+  EXPECT_EQ(kNaluData + 18, nalu.data());
+  EXPECT_EQ(3u, nalu.payload_size());
+  EXPECT_EQ(1u, nalu.header_size());
+  EXPECT_EQ(3, nalu.ref_idc());
+  EXPECT_EQ(7, nalu.type());
+
+  EXPECT_EQ(NaluReader::kEOStream, reader.Advance(&nalu));
+}
+
 TEST(NaluReaderTest, OneByteNaluLength) {
   const uint8_t kNaluData[] = {
       // First NALU
@@ -24,7 +24,9 @@ class VP9Parser : public VPxParser {
 
   /// Parse @a data with size @a data_size.
   /// @param data_size Size of the sample in bytes. Note that it should be a
-  ///        full sample.
+  ///        full sample: a chunk may be a superframe, whose index is stored at
+  ///        the end of the chunk, so the frame sizes are not known until the
+  ///        whole sample is available.
   /// @param[out] vpx_frames points to the list of VPx frames for the current
   ///             sample on success. Cannot be NULL.
   /// @return true on success, false otherwise.
@@ -0,0 +1,124 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/event/checkpointing_muxer_listener.h"
+
+#include <inttypes.h>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/media/file/file.h"
+
+namespace shaka {
+namespace media {
+
+CheckpointingMuxerListener::CheckpointingMuxerListener(
+    scoped_ptr<MuxerListener> listener,
+    const std::string& checkpoint_file_path,
+    uint64_t initial_segment_number)
+    : listener_(listener.Pass()),
+      checkpoint_file_path_(checkpoint_file_path),
+      segment_number_(initial_segment_number) {}
+
+CheckpointingMuxerListener::~CheckpointingMuxerListener() {}
+
+// static
+bool CheckpointingMuxerListener::ReadCheckpoint(
+    const std::string& checkpoint_file_path,
+    uint64_t* segment_number) {
+  DCHECK(segment_number);
+  std::string content;
+  if (!File::ReadFileToString(checkpoint_file_path.c_str(), &content))
+    return false;
+  base::TrimWhitespaceASCII(content, base::TRIM_ALL, &content);
+  if (!base::StringToUint64(content, segment_number)) {
+    LOG(ERROR) << "Invalid checkpoint " << checkpoint_file_path << ": "
+               << content;
+    return false;
+  }
+  return true;
+}
+
+void CheckpointingMuxerListener::OnEncryptionInfoReady(
+    bool is_initial_encryption_info,
+    FourCC protection_scheme,
+    const std::vector<uint8_t>& key_id,
+    const std::vector<uint8_t>& iv,
+    const std::vector<ProtectionSystemSpecificInfo>& key_system_info) {
+  if (listener_) {
+    listener_->OnEncryptionInfoReady(is_initial_encryption_info,
+                                     protection_scheme, key_id, iv,
+                                     key_system_info);
+  }
+}
+
+void CheckpointingMuxerListener::OnEncryptionStart() {
+  if (listener_)
+    listener_->OnEncryptionStart();
+}
+
+void CheckpointingMuxerListener::OnMediaStart(const MuxerOptions& muxer_options,
+                                              const StreamInfo& stream_info,
+                                              uint32_t time_scale,
+                                              ContainerType container_type) {
+  if (listener_)
+    listener_->OnMediaStart(muxer_options, stream_info, time_scale,
+                            container_type);
+}
+
+void CheckpointingMuxerListener::OnSampleDurationReady(
+    uint32_t sample_duration) {
+  if (listener_)
+    listener_->OnSampleDurationReady(sample_duration);
+}
+
+void CheckpointingMuxerListener::OnMediaEnd(bool has_init_range,
+                                            uint64_t init_range_start,
+                                            uint64_t init_range_end,
+                                            bool has_index_range,
+                                            uint64_t index_range_start,
+                                            uint64_t index_range_end,
+                                            float duration_seconds,
+                                            uint64_t file_size) {
+  if (listener_) {
+    listener_->OnMediaEnd(has_init_range, init_range_start, init_range_end,
+                          has_index_range, index_range_start, index_range_end,
+                          duration_seconds, file_size);
+  }
+}
+
+void CheckpointingMuxerListener::OnNewSegment(const std::string& segment_name,
+                                              uint64_t start_time,
+                                              uint64_t duration,
+                                              uint64_t segment_file_size) {
+  ++segment_number_;
+  WriteCheckpoint();
+  if (listener_)
+    listener_->OnNewSegment(segment_name, start_time, duration,
+                            segment_file_size);
+}
+
+void CheckpointingMuxerListener::WriteCheckpoint() {
+  // The checkpoint is one small write; a failure is logged but does not fail
+  // the stream — it only degrades a future resume.
+  const std::string content =
+      base::StringPrintf("%" PRIu64 "\n", segment_number_);
+  File* file = File::Open(checkpoint_file_path_.c_str(), "w");
+  if (!file) {
+    LOG(WARNING) << "Failed to open checkpoint " << checkpoint_file_path_;
+    return;
+  }
+  if (file->Write(content.data(), content.size()) <
+      static_cast<int64_t>(content.size())) {
+    LOG(WARNING) << "Failed to write checkpoint " << checkpoint_file_path_;
+  }
+  file->Close();
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,86 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_EVENT_CHECKPOINTING_MUXER_LISTENER_H_
+#define MEDIA_EVENT_CHECKPOINTING_MUXER_LISTENER_H_
+
+#include <string>
+
+#include "packager/base/macros.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/event/muxer_listener.h"
+
+namespace shaka {
+namespace media {
+
+/// MuxerListener decorator that persists a small checkpoint file after every
+/// completed segment, recording how many segments have been written for the
+/// stream. After a crash, the checkpoint can be read back and fed to
+/// MuxerOptions::initial_segment_number so a restarted live channel continues
+/// segment numbering where the previous process stopped instead of starting
+/// over. All events are forwarded to the wrapped listener, which may be NULL
+/// when checkpointing is wanted without manifest output.
+class CheckpointingMuxerListener : public MuxerListener {
+ public:
+  /// @param listener is the wrapped listener. May be NULL.
+  /// @param checkpoint_file_path is where the checkpoint is written.
+  /// @param initial_segment_number is the number of segments written by
+  ///        previous processes, i.e. the value read from an existing
+  ///        checkpoint when resuming, or 0 for a fresh start.
+  CheckpointingMuxerListener(scoped_ptr<MuxerListener> listener,
+                             const std::string& checkpoint_file_path,
+                             uint64_t initial_segment_number);
+  ~CheckpointingMuxerListener() override;
+
+  /// Reads the segment number back from a checkpoint written by this
+  /// listener.
+  /// @return true if the checkpoint exists and parses, in which case
+  ///         @a segment_number is set.
+  static bool ReadCheckpoint(const std::string& checkpoint_file_path,
+                             uint64_t* segment_number);
+
+  /// @name MuxerListener implementation overrides.
+  /// @{
+  void OnEncryptionInfoReady(bool is_initial_encryption_info,
+                             FourCC protection_scheme,
+                             const std::vector<uint8_t>& key_id,
+                             const std::vector<uint8_t>& iv,
+                             const std::vector<ProtectionSystemSpecificInfo>&
+                                 key_system_info) override;
+  void OnEncryptionStart() override;
+  void OnMediaStart(const MuxerOptions& muxer_options,
+                    const StreamInfo& stream_info,
+                    uint32_t time_scale,
+                    ContainerType container_type) override;
+  void OnSampleDurationReady(uint32_t sample_duration) override;
+  void OnMediaEnd(bool has_init_range,
+                  uint64_t init_range_start,
+                  uint64_t init_range_end,
+                  bool has_index_range,
+                  uint64_t index_range_start,
+                  uint64_t index_range_end,
+                  float duration_seconds,
+                  uint64_t file_size) override;
+  void OnNewSegment(const std::string& segment_name,
+                    uint64_t start_time,
+                    uint64_t duration,
+                    uint64_t segment_file_size) override;
+  /// @}
+
+ private:
+  void WriteCheckpoint();
+
+  scoped_ptr<MuxerListener> listener_;
+  const std::string checkpoint_file_path_;
+  uint64_t segment_number_;
+
+  DISALLOW_COPY_AND_ASSIGN(CheckpointingMuxerListener);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_EVENT_CHECKPOINTING_MUXER_LISTENER_H_
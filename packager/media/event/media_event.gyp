@@ -13,6 +13,8 @@
       'target_name': 'media_event',
       'type': '<(component)',
       'sources': [
+        'checkpointing_muxer_listener.cc',
+        'checkpointing_muxer_listener.h',
         'hls_notify_muxer_listener.cc',
         'hls_notify_muxer_listener.h',
         'mpd_notify_muxer_listener.cc',
@@ -20,6 +22,8 @@
         'muxer_listener.h',
         'muxer_listener_internal.cc',
         'muxer_listener_internal.h',
+        'threaded_muxer_listener.cc',
+        'threaded_muxer_listener.h',
         'vod_media_info_dump_muxer_listener.cc',
         'vod_media_info_dump_muxer_listener.h',
       ],
@@ -52,6 +56,7 @@
         'mpd_notify_muxer_listener_unittest.cc',
         'muxer_listener_test_helper.cc',
         'muxer_listener_test_helper.h',
+        'threaded_muxer_listener_unittest.cc',
         'vod_media_info_dump_muxer_listener_unittest.cc',
       ],
       'dependencies': [
@@ -64,6 +69,7 @@
         '../../third_party/protobuf/protobuf.gyp:protobuf_full_do_not_use',
         '../test/media_test.gyp:run_tests_with_atexit_manager',
         'media_event',
+        'mock_muxer_listener',
       ],
     },
   ],
@@ -9,6 +9,7 @@
 #include <cmath>
 
 #include "packager/base/logging.h"
+#include "packager/media/base/allocation_tracker.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/video_stream_info.h"
 #include "packager/media/base/protection_system_specific_info.h"
@@ -41,13 +42,16 @@ void MpdNotifyMuxerListener::OnEncryptionInfoReady(
     default_key_id_.assign(key_id.begin(), key_id.end());
     key_system_info_ = key_system_info;
     is_encrypted_ = true;
+    // The content protection fields of any cached MediaInfo are stale now.
+    cached_media_info_key_.clear();
+    cached_media_info_.reset();
     return;
   }
   DCHECK_EQ(protection_scheme, protection_scheme_);
 
   for (const ProtectionSystemSpecificInfo& info : key_system_info) {
     std::string drm_uuid = internal::CreateUUIDString(info.system_id());
-    std::vector<uint8_t> new_pssh = info.CreateBox();
+    const std::vector<uint8_t>& new_pssh = info.CreateBox();
     bool updated = mpd_notifier_->NotifyEncryptionUpdate(
         notification_id_, drm_uuid, key_id, new_pssh);
     LOG_IF(WARNING, !updated) << "Failed to update encryption info.";
@@ -61,26 +65,34 @@ void MpdNotifyMuxerListener::OnMediaStart(
     const StreamInfo& stream_info,
     uint32_t time_scale,
     ContainerType container_type) {
-  scoped_ptr<MediaInfo> media_info(new MediaInfo());
-  if (!internal::GenerateMediaInfo(muxer_options,
-                                   stream_info,
-                                   time_scale,
-                                   container_type,
-                                   media_info.get())) {
-    LOG(ERROR) << "Failed to generate MediaInfo from input.";
-    return;
-  }
-
-  if (is_encrypted_) {
-    internal::SetContentProtectionFields(protection_scheme_, default_key_id_,
-                                         key_system_info_, media_info.get());
+  const std::string cache_key = internal::MediaInfoCacheKey(
+      muxer_options, stream_info, time_scale, container_type);
+  if (!cached_media_info_ || cache_key != cached_media_info_key_) {
+    scoped_ptr<MediaInfo> media_info(new MediaInfo());
+    if (!internal::GenerateMediaInfo(muxer_options,
+                                     stream_info,
+                                     time_scale,
+                                     container_type,
+                                     media_info.get())) {
+      LOG(ERROR) << "Failed to generate MediaInfo from input.";
+      return;
+    }
+
+    if (is_encrypted_) {
+      internal::SetContentProtectionFields(protection_scheme_, default_key_id_,
+                                           key_system_info_, media_info.get());
+    }
+    cached_media_info_ = media_info.Pass();
+    cached_media_info_key_ = cache_key;
   }
 
   if (mpd_notifier_->dash_profile() == kLiveProfile) {
     // TODO(kqyang): Check return result.
-    mpd_notifier_->NotifyNewContainer(*media_info, &notification_id_);
+    mpd_notifier_->NotifyNewContainer(*cached_media_info_, &notification_id_);
   } else {
-    media_info_ = media_info.Pass();
+    // OnMediaEnd() mutates |media_info_|, so give it its own copy and keep
+    // the cached proto pristine.
+    media_info_.reset(new MediaInfo(*cached_media_info_));
   }
 }
 
@@ -117,6 +129,7 @@ void MpdNotifyMuxerListener::OnMediaEnd(bool has_init_range,
                                         uint64_t index_range_end,
                                         float duration_seconds,
                                         uint64_t file_size) {
+  ScopedAllocationScope allocation_scope(AllocationTracker::kScopeManifest);
   if (mpd_notifier_->dash_profile() == kLiveProfile) {
     DCHECK(subsegments_.empty());
     return;
@@ -10,6 +10,7 @@
 #define MEDIA_EVENT_MPD_NOTIFY_MUXER_LISTENER_H_
 
 #include <list>
+#include <string>
 #include <vector>
 
 #include "packager/base/compiler_specific.h"
@@ -71,6 +72,13 @@ class MpdNotifyMuxerListener : public MuxerListener {
   uint32_t notification_id_;
   scoped_ptr<MediaInfo> media_info_;
 
+  // Caches the MediaInfo generated by the last OnMediaStart() together with a
+  // fingerprint of the inputs it was generated from, so restarts of an
+  // identical stream configuration skip rebuilding the proto (codec strings,
+  // PSSH box serialization). Invalidated when new encryption info arrives.
+  std::string cached_media_info_key_;
+  scoped_ptr<MediaInfo> cached_media_info_;
+
   bool is_encrypted_;
   // Storage for values passed to OnEncryptionInfoReady().
   FourCC protection_scheme_;
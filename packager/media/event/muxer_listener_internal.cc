@@ -11,6 +11,7 @@
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/muxer_options.h"
 #include "packager/media/base/protection_system_specific_info.h"
@@ -177,6 +178,45 @@ bool GenerateMediaInfo(const MuxerOptions& muxer_options,
   return true;
 }
 
+std::string MediaInfoCacheKey(const MuxerOptions& muxer_options,
+                              const StreamInfo& stream_info,
+                              uint32_t reference_time_scale,
+                              MuxerListener::ContainerType container_type) {
+  // Every field read by GenerateMediaInfo() goes into the key, with a
+  // separator so that adjacent fields cannot alias each other. The codec
+  // config is appended last as raw bytes; everything before it is free of
+  // embedded '|'.
+  std::string key;
+  base::StringAppendF(&key, "%d|%s|%s|%u|%u|%d|%d|%s|%u|",
+                      muxer_options.single_segment ? 1 : 0,
+                      muxer_options.output_file_name.c_str(),
+                      muxer_options.segment_template.c_str(),
+                      muxer_options.bandwidth, reference_time_scale,
+                      container_type, stream_info.stream_type(),
+                      stream_info.codec_string().c_str(),
+                      stream_info.time_scale());
+  if (stream_info.stream_type() == kStreamAudio) {
+    const AudioStreamInfo& audio_stream_info =
+        static_cast<const AudioStreamInfo&>(stream_info);
+    base::StringAppendF(&key, "%u|%u|%s|",
+                        audio_stream_info.sampling_frequency(),
+                        static_cast<unsigned>(audio_stream_info.num_channels()),
+                        audio_stream_info.language().c_str());
+  } else {
+    DCHECK_EQ(stream_info.stream_type(), kStreamVideo);
+    const VideoStreamInfo& video_stream_info =
+        static_cast<const VideoStreamInfo&>(stream_info);
+    base::StringAppendF(&key, "%u|%u|%u|%u|",
+                        static_cast<unsigned>(video_stream_info.width()),
+                        static_cast<unsigned>(video_stream_info.height()),
+                        video_stream_info.pixel_width(),
+                        video_stream_info.pixel_height());
+  }
+  const std::vector<uint8_t>& codec_config = stream_info.codec_config();
+  key.append(codec_config.begin(), codec_config.end());
+  return key;
+}
+
 bool SetVodInformation(bool has_init_range,
                        uint64_t init_range_start,
                        uint64_t init_range_end,
@@ -237,7 +277,7 @@ void SetContentProtectionFields(
     if (!info.system_id().empty())
       entry->set_uuid(CreateUUIDString(info.system_id()));
 
-    const std::vector<uint8_t> pssh = info.CreateBox();
+    const std::vector<uint8_t>& pssh = info.CreateBox();
     entry->set_pssh(pssh.data(), pssh.size());
   }
 }
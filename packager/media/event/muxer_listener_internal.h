@@ -33,6 +33,15 @@ bool GenerateMediaInfo(const MuxerOptions& muxer_options,
                        MuxerListener::ContainerType container_type,
                        MediaInfo* media_info);
 
+/// Returns a fingerprint of all the inputs read by GenerateMediaInfo(). Two
+/// calls with equal fingerprints generate identical MediaInfo protos, so a
+/// caller can reuse a previously generated proto when the stream
+/// configuration has not changed, e.g. across live restarts.
+std::string MediaInfoCacheKey(const MuxerOptions& muxer_options,
+                              const StreamInfo& stream_info,
+                              uint32_t reference_time_scale,
+                              MuxerListener::ContainerType container_type);
+
 /// @param[in,out] media_info points to the MediaInfo object to be filled.
 /// @return true on success, false otherwise.
 bool SetVodInformation(bool has_init_range,
@@ -0,0 +1,166 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/event/threaded_muxer_listener.h"
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+
+ThreadedMuxerListener::ThreadedMuxerListener(scoped_ptr<MuxerListener> listener,
+                                             size_t queue_capacity)
+    : base::SimpleThread("ThreadedMuxerListener"),
+      listener_(listener.Pass()),
+      queue_capacity_(queue_capacity),
+      event_available_(&lock_),
+      not_full_(&lock_),
+      drained_(&lock_),
+      delivery_in_progress_(false),
+      stopped_(false),
+      max_queue_depth_(0),
+      blocked_post_count_(0) {
+  DCHECK(listener_);
+  DCHECK_GT(queue_capacity, 0u);
+  Start();
+}
+
+ThreadedMuxerListener::~ThreadedMuxerListener() {
+  {
+    base::AutoLock auto_lock(lock_);
+    stopped_ = true;
+    event_available_.Signal();
+  }
+  Join();
+  VLOG(1) << "Maximum segment event queue depth: " << max_queue_depth_;
+  LOG_IF(WARNING, blocked_post_count_ > 0)
+      << "Segment production blocked on manifest updates "
+      << blocked_post_count_ << " time(s); manifest output is too slow.";
+}
+
+void ThreadedMuxerListener::OnEncryptionInfoReady(
+    bool is_initial_encryption_info,
+    FourCC protection_scheme,
+    const std::vector<uint8_t>& key_id,
+    const std::vector<uint8_t>& iv,
+    const std::vector<ProtectionSystemSpecificInfo>& key_system_info) {
+  // Key rotation applies to the segments that follow, so deliver queued
+  // segments first.
+  Drain();
+  listener_->OnEncryptionInfoReady(is_initial_encryption_info,
+                                   protection_scheme, key_id, iv,
+                                   key_system_info);
+}
+
+void ThreadedMuxerListener::OnEncryptionStart() {
+  Drain();
+  listener_->OnEncryptionStart();
+}
+
+void ThreadedMuxerListener::OnMediaStart(const MuxerOptions& muxer_options,
+                                         const StreamInfo& stream_info,
+                                         uint32_t time_scale,
+                                         ContainerType container_type) {
+  Drain();
+  listener_->OnMediaStart(muxer_options, stream_info, time_scale,
+                          container_type);
+}
+
+void ThreadedMuxerListener::OnSampleDurationReady(uint32_t sample_duration) {
+  Event event;
+  event.type = Event::kSampleDurationReady;
+  event.start_time = 0;
+  event.duration = 0;
+  event.segment_file_size = 0;
+  event.sample_duration = sample_duration;
+  Post(event);
+}
+
+void ThreadedMuxerListener::OnMediaEnd(bool has_init_range,
+                                       uint64_t init_range_start,
+                                       uint64_t init_range_end,
+                                       bool has_index_range,
+                                       uint64_t index_range_start,
+                                       uint64_t index_range_end,
+                                       float duration_seconds,
+                                       uint64_t file_size) {
+  Drain();
+  listener_->OnMediaEnd(has_init_range, init_range_start, init_range_end,
+                        has_index_range, index_range_start, index_range_end,
+                        duration_seconds, file_size);
+}
+
+void ThreadedMuxerListener::OnNewSegment(const std::string& segment_name,
+                                         uint64_t start_time,
+                                         uint64_t duration,
+                                         uint64_t segment_file_size) {
+  Event event;
+  event.type = Event::kNewSegment;
+  event.segment_name = segment_name;
+  event.start_time = start_time;
+  event.duration = duration;
+  event.segment_file_size = segment_file_size;
+  event.sample_duration = 0;
+  Post(event);
+}
+
+void ThreadedMuxerListener::Run() {
+  base::AutoLock auto_lock(lock_);
+  while (true) {
+    while (queue_.empty() && !stopped_)
+      event_available_.Wait();
+    // Deliver the remaining events even when stopping.
+    if (queue_.empty())
+      return;
+
+    Event event = queue_.front();
+    queue_.pop_front();
+    not_full_.Signal();
+    delivery_in_progress_ = true;
+    {
+      base::AutoUnlock auto_unlock(lock_);
+      Deliver(event);
+    }
+    delivery_in_progress_ = false;
+    if (queue_.empty())
+      drained_.Broadcast();
+  }
+}
+
+void ThreadedMuxerListener::Post(const Event& event) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK(!stopped_);
+  if (queue_.size() >= queue_capacity_) {
+    ++blocked_post_count_;
+    while (queue_.size() >= queue_capacity_)
+      not_full_.Wait();
+  }
+  queue_.push_back(event);
+  if (queue_.size() > max_queue_depth_)
+    max_queue_depth_ = queue_.size();
+  event_available_.Signal();
+}
+
+void ThreadedMuxerListener::Drain() {
+  base::AutoLock auto_lock(lock_);
+  while (!queue_.empty() || delivery_in_progress_)
+    drained_.Wait();
+}
+
+void ThreadedMuxerListener::Deliver(const Event& event) {
+  switch (event.type) {
+    case Event::kNewSegment:
+      listener_->OnNewSegment(event.segment_name, event.start_time,
+                              event.duration, event.segment_file_size);
+      break;
+    case Event::kSampleDurationReady:
+      listener_->OnSampleDurationReady(event.sample_duration);
+      break;
+  }
+}
+
+}  // namespace media
+}  // namespace shaka
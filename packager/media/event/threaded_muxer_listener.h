@@ -0,0 +1,124 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_EVENT_THREADED_MUXER_LISTENER_H_
+#define MEDIA_EVENT_THREADED_MUXER_LISTENER_H_
+
+#include <deque>
+#include <string>
+
+#include "packager/base/macros.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/media/event/muxer_listener.h"
+
+namespace shaka {
+namespace media {
+
+/// MuxerListener decorator that delivers segment events to the wrapped
+/// listener from a dedicated thread, so that slow manifest updates (e.g. a
+/// playlist written to a slow network file system) do not stall media segment
+/// production. OnNewSegment() and OnSampleDurationReady() are queued on a
+/// bounded queue and return immediately; if the queue is full, the muxer
+/// thread blocks until the manifest thread catches up, which is counted as a
+/// backpressure event. The remaining events are rare and order sensitive with
+/// respect to segments, so they drain the queue and are then delivered
+/// inline. Like any MuxerListener, an instance serves a single muxer.
+class ThreadedMuxerListener : public MuxerListener, public base::SimpleThread {
+ public:
+  /// Constructs a ThreadedMuxerListener and starts the event thread.
+  /// @param listener is the listener that the events are delivered to.
+  /// @param queue_capacity is the maximum number of undelivered segment
+  ///        events before the muxer thread blocks.
+  ThreadedMuxerListener(scoped_ptr<MuxerListener> listener,
+                        size_t queue_capacity);
+
+  /// The destructor delivers all queued events and then joins the thread.
+  ~ThreadedMuxerListener() override;
+
+  /// @name MuxerListener implementation overrides.
+  /// @{
+  void OnEncryptionInfoReady(bool is_initial_encryption_info,
+                             FourCC protection_scheme,
+                             const std::vector<uint8_t>& key_id,
+                             const std::vector<uint8_t>& iv,
+                             const std::vector<ProtectionSystemSpecificInfo>&
+                                 key_system_info) override;
+  void OnEncryptionStart() override;
+  void OnMediaStart(const MuxerOptions& muxer_options,
+                    const StreamInfo& stream_info,
+                    uint32_t time_scale,
+                    ContainerType container_type) override;
+  void OnSampleDurationReady(uint32_t sample_duration) override;
+  void OnMediaEnd(bool has_init_range,
+                  uint64_t init_range_start,
+                  uint64_t init_range_end,
+                  bool has_index_range,
+                  uint64_t index_range_start,
+                  uint64_t index_range_end,
+                  float duration_seconds,
+                  uint64_t file_size) override;
+  void OnNewSegment(const std::string& segment_name,
+                    uint64_t start_time,
+                    uint64_t duration,
+                    uint64_t segment_file_size) override;
+  /// @}
+
+ protected:
+  /// SimpleThread implementation override.
+  void Run() override;
+
+ private:
+  struct Event {
+    enum Type {
+      kNewSegment,
+      kSampleDurationReady,
+    };
+    Type type;
+    std::string segment_name;
+    uint64_t start_time;
+    uint64_t duration;
+    uint64_t segment_file_size;
+    uint32_t sample_duration;
+  };
+
+  // Queues |event| for delivery on the event thread. Blocks if the queue is
+  // at capacity.
+  void Post(const Event& event);
+
+  // Blocks until every queued event has been delivered.
+  void Drain();
+
+  // Delivers |event| to |listener_|. Called on the event thread only.
+  void Deliver(const Event& event);
+
+  scoped_ptr<MuxerListener> listener_;
+  const size_t queue_capacity_;
+
+  base::Lock lock_;
+  // Signaled when |queue_| gains an element or |stopped_| becomes true.
+  base::ConditionVariable event_available_;
+  // Signaled when an element is removed from |queue_|.
+  base::ConditionVariable not_full_;
+  // Signaled when the queue drains completely.
+  base::ConditionVariable drained_;
+  std::deque<Event> queue_;
+  bool delivery_in_progress_;
+  bool stopped_;
+
+  // Backpressure metrics, logged on destruction.
+  size_t max_queue_depth_;
+  size_t blocked_post_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadedMuxerListener);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_EVENT_THREADED_MUXER_LISTENER_H_
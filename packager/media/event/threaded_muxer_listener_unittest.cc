@@ -0,0 +1,81 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/event/mock_muxer_listener.h"
+#include "packager/media/event/threaded_muxer_listener.h"
+
+namespace shaka {
+namespace media {
+
+using ::testing::InSequence;
+using ::testing::StrEq;
+
+namespace {
+const size_t kQueueCapacity = 4;
+}  // namespace
+
+// All the queued events should be delivered before the listener is destroyed.
+TEST(ThreadedMuxerListenerTest, DeliversQueuedEvents) {
+  MockMuxerListener* mock_listener = new MockMuxerListener();
+  EXPECT_CALL(*mock_listener, OnNewSegment(StrEq("file1.mp4"), 100u, 200u,
+                                           300u));
+  EXPECT_CALL(*mock_listener, OnNewSegment(StrEq("file2.mp4"), 300u, 200u,
+                                           400u));
+  EXPECT_CALL(*mock_listener, OnSampleDurationReady(1000u));
+
+  ThreadedMuxerListener listener(scoped_ptr<MuxerListener>(mock_listener),
+                                 kQueueCapacity);
+  listener.OnNewSegment("file1.mp4", 100, 200, 300);
+  listener.OnSampleDurationReady(1000);
+  listener.OnNewSegment("file2.mp4", 300, 200, 400);
+}
+
+// Events that are delivered inline must not overtake queued segment events.
+TEST(ThreadedMuxerListenerTest, DrainsQueueBeforeInlineEvents) {
+  MockMuxerListener* mock_listener = new MockMuxerListener();
+  {
+    InSequence s;
+    EXPECT_CALL(*mock_listener, OnNewSegment(StrEq("file1.mp4"), 100u, 200u,
+                                             300u));
+    EXPECT_CALL(*mock_listener, OnNewSegment(StrEq("file2.mp4"), 300u, 200u,
+                                             400u));
+    EXPECT_CALL(*mock_listener, OnMediaEnd(false, 0u, 0u, false, 0u, 0u, 1.0f,
+                                           1000u));
+  }
+
+  ThreadedMuxerListener listener(scoped_ptr<MuxerListener>(mock_listener),
+                                 kQueueCapacity);
+  listener.OnNewSegment("file1.mp4", 100, 200, 300);
+  listener.OnNewSegment("file2.mp4", 300, 200, 400);
+  listener.OnMediaEnd(false, 0, 0, false, 0, 0, 1.0f, 1000);
+}
+
+// Posting more events than the queue capacity must not drop or reorder any
+// of them; the producer blocks until the consumer catches up.
+TEST(ThreadedMuxerListenerTest, BlocksWhenQueueIsFull) {
+  const int kNumSegments = 100;
+  MockMuxerListener* mock_listener = new MockMuxerListener();
+  {
+    InSequence s;
+    for (int i = 0; i < kNumSegments; ++i) {
+      EXPECT_CALL(*mock_listener,
+                  OnNewSegment(StrEq("file.mp4"), static_cast<uint64_t>(i),
+                               200u, 300u));
+    }
+  }
+
+  ThreadedMuxerListener listener(scoped_ptr<MuxerListener>(mock_listener),
+                                 kQueueCapacity);
+  for (int i = 0; i < kNumSegments; ++i)
+    listener.OnNewSegment("file.mp4", i, 200, 300);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -21,7 +21,9 @@ namespace media {
 
 VodMediaInfoDumpMuxerListener::VodMediaInfoDumpMuxerListener(
     const std::string& output_file_path)
-    : output_file_name_(output_file_path), is_encrypted_(false) {}
+    : output_file_name_(output_file_path),
+      dump_valid_(false),
+      is_encrypted_(false) {}
 
 VodMediaInfoDumpMuxerListener::~VodMediaInfoDumpMuxerListener() {}
 
@@ -60,6 +62,11 @@ void VodMediaInfoDumpMuxerListener::OnMediaStart(
     internal::SetContentProtectionFields(protection_scheme_, default_key_id_,
                                          key_system_info_, media_info_.get());
   }
+
+  // Dump the stable fields right away so that pipelines watching the file can
+  // start downstream work before the media ends; the fields that are only
+  // known at media end are appended in OnMediaEnd().
+  dump_valid_ = WriteMediaInfoToFile(*media_info_, output_file_name_);
 }
 
 void VodMediaInfoDumpMuxerListener::OnEncryptionStart() {}
@@ -69,6 +76,15 @@ void VodMediaInfoDumpMuxerListener::OnSampleDurationReady(
   // Assume one VideoInfo.
   if (media_info_->has_video_info()) {
     media_info_->mutable_video_info()->set_frame_duration(sample_duration);
+    if (dump_valid_) {
+      // Duplicate singular message fields merge in text format, so appending
+      // just the new field keeps the file parseable.
+      MediaInfo frame_duration_delta;
+      frame_duration_delta.mutable_video_info()->set_frame_duration(
+          sample_duration);
+      dump_valid_ =
+          AppendMediaInfoToFile(frame_duration_delta, output_file_name_);
+    }
   }
 }
 
@@ -81,6 +97,7 @@ void VodMediaInfoDumpMuxerListener::OnMediaEnd(bool has_init_range,
                                                float duration_seconds,
                                                uint64_t file_size) {
   DCHECK(media_info_);
+  const bool had_bandwidth = media_info_->has_bandwidth();
   if (!internal::SetVodInformation(has_init_range,
                                    init_range_start,
                                    init_range_end,
@@ -93,6 +110,23 @@ void VodMediaInfoDumpMuxerListener::OnMediaEnd(bool has_init_range,
     LOG(ERROR) << "Failed to generate VOD information from input.";
     return;
   }
+
+  if (dump_valid_) {
+    // Append only the fields set by SetVodInformation(); the rest is already
+    // in the file from OnMediaStart().
+    MediaInfo vod_delta;
+    if (media_info_->has_init_range())
+      *vod_delta.mutable_init_range() = media_info_->init_range();
+    if (media_info_->has_index_range())
+      *vod_delta.mutable_index_range() = media_info_->index_range();
+    vod_delta.set_media_duration_seconds(
+        media_info_->media_duration_seconds());
+    if (!had_bandwidth)
+      vod_delta.set_bandwidth(media_info_->bandwidth());
+    if (AppendMediaInfoToFile(vod_delta, output_file_name_))
+      return;
+  }
+  // Either an earlier write failed or the append did; rewrite the whole file.
   WriteMediaInfoToFile(*media_info_, output_file_name_);
 }
 
@@ -129,5 +163,33 @@ bool VodMediaInfoDumpMuxerListener::WriteMediaInfoToFile(
   return true;
 }
 
+// static
+bool VodMediaInfoDumpMuxerListener::AppendMediaInfoToFile(
+    const MediaInfo& media_info,
+    const std::string& output_file_path) {
+  std::string output_string;
+  if (!google::protobuf::TextFormat::PrintToString(media_info,
+                                                   &output_string)) {
+    LOG(ERROR) << "Failed to serialize MediaInfo to string.";
+    return false;
+  }
+
+  media::File* file = File::Open(output_file_path.c_str(), "a");
+  if (!file) {
+    LOG(ERROR) << "Failed to open " << output_file_path;
+    return false;
+  }
+  if (file->Write(output_string.data(), output_string.size()) <= 0) {
+    LOG(ERROR) << "Failed to append MediaInfo to file.";
+    file->Close();
+    return false;
+  }
+  if (!file->Close()) {
+    LOG(ERROR) << "Failed to close " << output_file_path;
+    return false;
+  }
+  return true;
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -68,9 +68,19 @@ class VodMediaInfoDumpMuxerListener : public MuxerListener {
                                    const std::string& output_file_path);
 
  private:
+  // Appends @a media_info to the dump file in human readable format. Text
+  // format protobufs concatenate: parsing the whole file merges the appended
+  // fields into the message written at OnMediaStart(), so pipelines that tail
+  // the file can pick up the stable fields before the media ends.
+  static bool AppendMediaInfoToFile(const MediaInfo& media_info,
+                                    const std::string& output_file_path);
 
   std::string output_file_name_;
   scoped_ptr<MediaInfo> media_info_;
+  // True while the dump file is a valid, parseable prefix of the final
+  // output. If any write fails, the file is rewritten from scratch at
+  // OnMediaEnd().
+  bool dump_valid_;
 
   bool is_encrypted_;
   // Storage for values passed to OnEncryptionInfoReady().
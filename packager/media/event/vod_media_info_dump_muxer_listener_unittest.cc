@@ -196,6 +196,30 @@ TEST_F(VodMediaInfoDumpMuxerListenerTest, EncryptedStream_Normal) {
   ASSERT_NO_FATAL_FAILURE(ExpectTempFileToEqual(kExpectedProtobufOutput));
 }
 
+// The stable fields should be in the file already at media start, so that
+// pipelines watching the file can start downstream work early. The fields
+// that are only known at media end are appended later.
+TEST_F(VodMediaInfoDumpMuxerListenerTest, UnencryptedStream_DumpedAtStart) {
+  scoped_refptr<StreamInfo> stream_info =
+      CreateVideoStreamInfo(GetDefaultVideoStreamInfoParams());
+
+  FireOnMediaStartWithDefaultMuxerOptions(*stream_info, !kEnableEncryption);
+
+  const char kExpectedProtobufOutput[] =
+      "video_info {\n"
+      "  codec: 'avc1.010101'\n"
+      "  width: 720\n"
+      "  height: 480\n"
+      "  time_scale: 10\n"
+      "  pixel_width: 1\n"
+      "  pixel_height: 1\n"
+      "}\n"
+      "reference_time_scale: 1000\n"
+      "container_type: 1\n"
+      "media_file_name: 'test_output_file_name.mp4'\n";
+  ASSERT_NO_FATAL_FAILURE(ExpectTempFileToEqual(kExpectedProtobufOutput));
+}
+
 // Verify that VideoStreamInfo with non-0 pixel_{width,height} is set in the
 // generated MediaInfo.
 TEST_F(VodMediaInfoDumpMuxerListenerTest, CheckPixelWidthAndHeightSet) {
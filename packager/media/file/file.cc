@@ -11,8 +11,11 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/file/http_file.h"
 #include "packager/media/file/local_file.h"
 #include "packager/media/file/memory_file.h"
+#include "packager/media/file/mmap_file.h"
+#include "packager/media/file/shm_file.h"
 #include "packager/media/file/threaded_io_file.h"
 #include "packager/media/file/udp_file.h"
 #include "packager/base/strings/string_util.h"
@@ -24,6 +27,12 @@ DEFINE_uint64(io_cache_size,
 DEFINE_uint64(io_block_size,
               2ULL << 20,
               "Size of the block size used for threaded I/O, in bytes.");
+DEFINE_bool(mmap_file_reads,
+            false,
+            "Memory map local input files instead of reading them through "
+            "stdio and the threaded I/O cache. Reads become copies from the "
+            "page cache with no read() system calls. Output files are "
+            "unaffected.");
 
 namespace shaka {
 namespace media {
@@ -31,6 +40,9 @@ namespace media {
 const char* kLocalFilePrefix = "file://";
 const char* kUdpFilePrefix = "udp://";
 const char* kMemoryFilePrefix = "memory://";
+const char* kHttpFilePrefix = "http://";
+const char* kHttpsFilePrefix = "https://";
+const char* kShmFilePrefix = "shm://";
 
 namespace {
 
@@ -45,6 +57,8 @@ struct SupportedTypeInfo {
 };
 
 File* CreateLocalFile(const char* file_name, const char* mode) {
+  if (FLAGS_mmap_file_reads && strcmp(mode, "r") == 0)
+    return new MmapFile(file_name);
   return new LocalFile(file_name, mode);
 }
 
@@ -64,11 +78,35 @@ File* CreateMemoryFile(const char* file_name, const char* mode) {
   return new MemoryFile(file_name, mode);
 }
 
+File* CreateHttpFile(const char* file_name, const char* mode) {
+  if (strcmp(mode, "r")) {
+    NOTIMPLEMENTED() << "HttpFile only supports read mode.";
+    return NULL;
+  }
+  return new HttpFile(file_name, std::string(kHttpFilePrefix) + file_name);
+}
+
+File* CreateHttpsFile(const char* file_name, const char* mode) {
+  if (strcmp(mode, "r")) {
+    NOTIMPLEMENTED() << "HttpFile only supports read mode.";
+    return NULL;
+  }
+  return new HttpFile(file_name, std::string(kHttpsFilePrefix) + file_name);
+}
+
 bool DeleteMemoryFile(const char* file_name) {
   MemoryFile::Delete(file_name);
   return true;
 }
 
+File* CreateShmFile(const char* file_name, const char* mode) {
+  return new ShmFile(file_name, mode);
+}
+
+bool DeleteShmFile(const char* file_name) {
+  return ShmFile::Delete(file_name);
+}
+
 static const SupportedTypeInfo kSupportedTypeInfo[] = {
   {
     kLocalFilePrefix,
@@ -88,6 +126,24 @@ static const SupportedTypeInfo kSupportedTypeInfo[] = {
     &CreateMemoryFile,
     &DeleteMemoryFile
   },
+  {
+    kHttpFilePrefix,
+    strlen(kHttpFilePrefix),
+    &CreateHttpFile,
+    NULL
+  },
+  {
+    kHttpsFilePrefix,
+    strlen(kHttpsFilePrefix),
+    &CreateHttpsFile,
+    NULL
+  },
+  {
+    kShmFilePrefix,
+    strlen(kShmFilePrefix),
+    &CreateShmFile,
+    &DeleteShmFile
+  },
 };
 
 }  // namespace
@@ -96,8 +152,19 @@ File* File::Create(const char* file_name, const char* mode) {
   scoped_ptr<File, FileCloser> internal_file(
       CreateInternalFile(file_name, mode));
 
-  if (!strncmp(file_name, kMemoryFilePrefix, strlen(kMemoryFilePrefix))) {
-    // Disable caching for memory files.
+  if (!strncmp(file_name, kMemoryFilePrefix, strlen(kMemoryFilePrefix)) ||
+      !strncmp(file_name, kShmFilePrefix, strlen(kShmFilePrefix))) {
+    // Disable caching for memory backed files: the threaded I/O cache would
+    // only add a copy and a thread handoff.
+    return internal_file.release();
+  }
+
+  const bool is_local_file =
+      !strncmp(file_name, kLocalFilePrefix, strlen(kLocalFilePrefix)) ||
+      strstr(file_name, "://") == NULL;
+  if (FLAGS_mmap_file_reads && !strcmp(mode, "r") && is_local_file) {
+    // Memory mapped reads are served directly from the page cache; the
+    // threaded I/O cache would only add a copy and a thread handoff.
     return internal_file.release();
   }
 
@@ -159,6 +226,26 @@ File* File::OpenWithNoBuffering(const char* file_name, const char* mode) {
   return file;
 }
 
+void File::SetSizeHint(uint64_t size) {}
+
+int64_t File::WriteVectored(const Region* regions, size_t num_regions) {
+  DCHECK(regions || num_regions == 0);
+  int64_t total_bytes_written = 0;
+  for (size_t i = 0; i < num_regions; ++i) {
+    const uint8_t* buffer = static_cast<const uint8_t*>(regions[i].buffer);
+    uint64_t remaining = regions[i].length;
+    while (remaining > 0) {
+      int64_t bytes_written = Write(buffer, remaining);
+      if (bytes_written <= 0)
+        return bytes_written < 0 ? bytes_written : -1;
+      buffer += bytes_written;
+      remaining -= bytes_written;
+      total_bytes_written += bytes_written;
+    }
+  }
+  return total_bytes_written;
+}
+
 bool File::Delete(const char* file_name) {
   for (size_t i = 0; i < arraysize(kSupportedTypeInfo); ++i) {
     const SupportedTypeInfo& type_info = kSupportedTypeInfo[i];
@@ -16,12 +16,17 @@
         'file.cc',
         'file.h',
         'file_closer.h',
+        'http_file.cc',
+        'http_file.h',
         'io_cache.cc',
         'io_cache.h',
         'local_file.cc',
         'local_file.h',
         'memory_file.cc',
         'memory_file.h',
+        'mmap_file.cc',
+        'mmap_file.h',
+        'shm_file.h',
         'threaded_io_file.cc',
         'threaded_io_file.h',
         'udp_file.h',
@@ -29,16 +34,25 @@
       'conditions': [
         ['OS == "win"', {
           'sources': [
+            'shm_file_win.cc',
             'udp_file_win.cc',
           ],
         }, {
           'sources': [
+            'shm_file_posix.cc',
             'udp_file_posix.cc',
           ],
         }],
+        ['OS == "linux"', {
+          # For shm_open and sem_open.
+          'link_settings': {
+            'libraries': ['-lrt'],
+          },
+        }],
       ],
       'dependencies': [
         '../../base/base.gyp:base',
+        '../../third_party/curl/curl.gyp:libcurl',
         '../../third_party/gflags/gflags.gyp:gflags',
         '../base/media_base.gyp:media_base',
       ],
@@ -51,6 +65,13 @@
         'io_cache_unittest.cc',
         'memory_file_unittest.cc',
       ],
+      'conditions': [
+        ['OS != "win"', {
+          'sources': [
+            'shm_file_unittest.cc',
+          ],
+        }],
+      ],
       'dependencies': [
         '../../testing/gtest.gyp:gtest',
         '../../third_party/gflags/gflags.gyp:gflags',
@@ -65,6 +65,29 @@ class File {
   /// @return Number of bytes written, or a value < 0 on error.
   virtual int64_t Write(const void* buffer, uint64_t length) = 0;
 
+  /// A contiguous memory region for vectored writes.
+  struct Region {
+    const void* buffer;
+    uint64_t length;
+  };
+
+  /// Write every region, in order and in full, to the file. The default
+  /// implementation loops over Write; file types backed by a descriptor may
+  /// override it with a true scatter/gather write (e.g. writev) to avoid
+  /// per-region system calls.
+  /// @param regions points to an array of @a num_regions regions.
+  /// @return Total number of bytes written, or a value < 0 on error. Unlike
+  ///         Write, a partial write is reported as an error.
+  virtual int64_t WriteVectored(const Region* regions, size_t num_regions);
+
+  /// Hint the total number of bytes expected to be written to this file.
+  /// Best effort: file types backed by local storage may preallocate space
+  /// so the file is laid out in few extents; other file types ignore it.
+  /// The hint does not change the file size and writing more or fewer bytes
+  /// than hinted is fine.
+  /// @param size is the expected file size in bytes.
+  virtual void SetSizeHint(uint64_t size);
+
   /// @return Size of the file in bytes. A return value less than zero
   ///         indicates a problem getting the size.
   virtual int64_t Size() = 0;
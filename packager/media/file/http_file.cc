@@ -0,0 +1,188 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/file/http_file.h"
+
+#include <curl/curl.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+
+namespace {
+const char kUserAgentString[] = "shaka-packager-http_file/1.0";
+const long kHttpRequestedRangeNotSatisfiable = 416;
+
+// The ranged GET response is written straight into the caller's buffer.
+struct DownloadBuffer {
+  uint8_t* data;
+  size_t capacity;
+  size_t size;
+};
+
+size_t AppendToBuffer(char* ptr, size_t size, size_t nmemb, void* user_data) {
+  DCHECK(ptr);
+  DownloadBuffer* buffer = static_cast<DownloadBuffer*>(user_data);
+  const size_t total_size = size * nmemb;
+  if (buffer->size + total_size > buffer->capacity) {
+    // More data than requested, e.g. the server ignored the Range header and
+    // returned the whole resource. Abort the transfer.
+    return 0;
+  }
+  memcpy(buffer->data + buffer->size, ptr, total_size);
+  buffer->size += total_size;
+  return total_size;
+}
+
+class LibCurlInitializer {
+ public:
+  LibCurlInitializer() : initialized_(false) {
+    base::AutoLock lock(lock_);
+    if (!initialized_) {
+      curl_global_init(CURL_GLOBAL_DEFAULT);
+      initialized_ = true;
+    }
+  }
+
+  ~LibCurlInitializer() {
+    base::AutoLock lock(lock_);
+    if (initialized_) {
+      curl_global_cleanup();
+      initialized_ = false;
+    }
+  }
+
+ private:
+  base::Lock lock_;
+  bool initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(LibCurlInitializer);
+};
+
+}  // namespace
+
+namespace media {
+
+HttpFile::HttpFile(const char* file_name, const std::string& url)
+    : File(file_name), url_(url), position_(0), size_(-1), curl_(NULL) {}
+
+HttpFile::~HttpFile() {
+  if (curl_)
+    curl_easy_cleanup(curl_);
+}
+
+bool HttpFile::Close() {
+  delete this;
+  return true;
+}
+
+int64_t HttpFile::Read(void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK(curl_);
+
+  if (length == 0)
+    return 0;
+  if (size_ >= 0 && position_ >= static_cast<uint64_t>(size_))
+    return 0;
+
+  DownloadBuffer download_buffer;
+  download_buffer.data = static_cast<uint8_t*>(buffer);
+  download_buffer.capacity = length;
+  download_buffer.size = 0;
+
+  const std::string range = base::StringPrintf(
+      "%" PRIu64 "-%" PRIu64, position_, position_ + length - 1);
+  curl_easy_setopt(curl_, CURLOPT_URL, url_.c_str());
+  curl_easy_setopt(curl_, CURLOPT_RANGE, range.c_str());
+  curl_easy_setopt(curl_, CURLOPT_NOBODY, 0L);
+  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, AppendToBuffer);
+  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &download_buffer);
+
+  const CURLcode res = curl_easy_perform(curl_);
+  if (res != CURLE_OK) {
+    long response_code = 0;
+    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response_code);
+    // A range that starts at or past the end of the resource, i.e. EOF.
+    if (res == CURLE_HTTP_RETURNED_ERROR &&
+        response_code == kHttpRequestedRangeNotSatisfiable) {
+      return 0;
+    }
+    LOG(ERROR) << "Ranged GET of " << url_
+               << " failed: " << curl_easy_strerror(res)
+               << " Response code: " << response_code;
+    return -1;
+  }
+
+  position_ += download_buffer.size;
+  return download_buffer.size;
+}
+
+int64_t HttpFile::Write(const void* buffer, uint64_t length) {
+  NOTIMPLEMENTED() << "HttpFile does not support writing.";
+  return -1;
+}
+
+int64_t HttpFile::Size() {
+  return size_;
+}
+
+bool HttpFile::Flush() {
+  // Nothing to flush for reads.
+  return true;
+}
+
+bool HttpFile::Seek(uint64_t position) {
+  // Every Read is an independent ranged GET, so a seek is just a cursor
+  // update.
+  position_ = position;
+  return true;
+}
+
+bool HttpFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool HttpFile::Open() {
+  static LibCurlInitializer lib_curl_initializer;
+
+  curl_ = curl_easy_init();
+  if (!curl_) {
+    LOG(ERROR) << "curl_easy_init() failed.";
+    return false;
+  }
+  curl_easy_setopt(curl_, CURLOPT_USERAGENT, kUserAgentString);
+  curl_easy_setopt(curl_, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
+
+  // Probe the resource with a HEAD request; it validates the URL and gives
+  // the size, which parsers use to bound reads.
+  curl_easy_setopt(curl_, CURLOPT_URL, url_.c_str());
+  curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L);
+  const CURLcode res = curl_easy_perform(curl_);
+  if (res != CURLE_OK) {
+    LOG(ERROR) << "Cannot open " << url_ << ": " << curl_easy_strerror(res);
+    return false;
+  }
+  double content_length = -1;
+  if (curl_easy_getinfo(curl_, CURLINFO_CONTENT_LENGTH_DOWNLOAD,
+                        &content_length) == CURLE_OK &&
+      content_length >= 0) {
+    size_ = static_cast<int64_t>(content_length);
+  }
+  position_ = 0;
+  return true;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,61 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_HTTP_FILE_H_
+#define PACKAGER_FILE_HTTP_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "packager/media/file/file.h"
+
+typedef void CURL;
+
+namespace shaka {
+namespace media {
+
+/// Read-only File implementation for http:// and https:// URLs. Each Read
+/// issues a ranged GET for exactly the requested byte range over a reused
+/// connection, so Seek is cheap and no FUSE mount is needed for object
+/// storage fronted by HTTP. Readahead comes from the ThreadedIoFile wrapper
+/// that File::Create puts on top of every input file.
+class HttpFile : public File {
+ public:
+  /// @param file_name is the URL with the scheme prefix stripped, as passed
+  ///        by the factory.
+  /// @param url is the complete URL, including the scheme.
+  HttpFile(const char* file_name, const std::string& url);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+ protected:
+  ~HttpFile() override;
+
+  bool Open() override;
+
+ private:
+  const std::string url_;
+  uint64_t position_;
+  int64_t size_;
+  CURL* curl_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpFile);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_HTTP_FILE_H_
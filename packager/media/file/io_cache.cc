@@ -13,23 +13,27 @@
 #include "packager/base/logging.h"
 
 namespace shaka {
-
-using base::AutoLock;
-using base::AutoUnlock;
-
 namespace media {
 
+using base::subtle::Acquire_Load;
+using base::subtle::AtomicWord;
+using base::subtle::MemoryBarrier;
+using base::subtle::NoBarrier_Load;
+using base::subtle::NoBarrier_Store;
+using base::subtle::Release_Store;
+
 IoCache::IoCache(uint64_t cache_size)
     : cache_size_(cache_size),
       read_event_(false, false),
       write_event_(false, false),
-      // Make the buffer one byte larger than the cache so that when the
-      // condition r_ptr == w_ptr is unambiguous (buffer empty).
+      // Make the buffer one byte larger than the cache so that the
+      // condition read_pos_ == write_pos_ is unambiguous (buffer empty).
       circular_buffer_(cache_size + 1),
-      end_ptr_(&circular_buffer_[0] + cache_size + 1),
-      r_ptr_(circular_buffer_.data()),
-      w_ptr_(circular_buffer_.data()),
-      closed_(false) {}
+      read_pos_(0),
+      write_pos_(0),
+      reader_waiting_(0),
+      writer_waiting_(0),
+      closed_(0) {}
 
 IoCache::~IoCache() {
   Close();
@@ -38,104 +42,126 @@ IoCache::~IoCache() {
 uint64_t IoCache::Read(void* buffer, uint64_t size) {
   DCHECK(buffer);
 
-  AutoLock lock(lock_);
-  while (!closed_ && (BytesCachedInternal() == 0)) {
-    AutoUnlock unlock(lock_);
+  uint64_t bytes_cached = BytesCachedInternal();
+  while (!closed() && bytes_cached == 0) {
+    // Announce that we are about to sleep, then re-check, so a write that
+    // lands between the check and the wait is guaranteed to either be seen
+    // here or to signal |write_event_|.
+    NoBarrier_Store(&reader_waiting_, 1);
+    MemoryBarrier();
+    bytes_cached = BytesCachedInternal();
+    if (closed() || bytes_cached != 0)
+      break;
     write_event_.Wait();
+    bytes_cached = BytesCachedInternal();
   }
-
-  size = std::min(size, BytesCachedInternal());
-  uint64_t first_chunk_size(std::min(size, static_cast<uint64_t>(
-      end_ptr_ - r_ptr_)));
-  memcpy(buffer, r_ptr_, first_chunk_size);
-  r_ptr_ += first_chunk_size;
-  DCHECK_GE(end_ptr_, r_ptr_);
-  if (r_ptr_ == end_ptr_)
-    r_ptr_ = &circular_buffer_[0];
-  uint64_t second_chunk_size(size - first_chunk_size);
+  NoBarrier_Store(&reader_waiting_, 0);
+  if (bytes_cached == 0)
+    return 0;
+
+  size = std::min(size, bytes_cached);
+  const uint64_t buffer_size = circular_buffer_.size();
+  uint64_t read_pos = static_cast<uint64_t>(NoBarrier_Load(&read_pos_));
+  const uint64_t first_chunk_size = std::min(size, buffer_size - read_pos);
+  memcpy(buffer, &circular_buffer_[read_pos], first_chunk_size);
+  read_pos = (read_pos + first_chunk_size) % buffer_size;
+  const uint64_t second_chunk_size = size - first_chunk_size;
   if (second_chunk_size) {
-    memcpy(static_cast<uint8_t*>(buffer) + first_chunk_size, r_ptr_,
-           second_chunk_size);
-    r_ptr_ += second_chunk_size;
-    DCHECK_GT(end_ptr_, r_ptr_);
+    memcpy(static_cast<uint8_t*>(buffer) + first_chunk_size,
+           &circular_buffer_[0], second_chunk_size);
+    read_pos = second_chunk_size;
   }
-  read_event_.Signal();
+  Release_Store(&read_pos_, static_cast<AtomicWord>(read_pos));
+  // Wake the producer only if it has announced it is blocked on a full
+  // cache; uncontended transfers make no signal or wait calls at all.
+  MemoryBarrier();
+  if (NoBarrier_Load(&writer_waiting_))
+    read_event_.Signal();
   return size;
 }
 
 uint64_t IoCache::Write(const void* buffer, uint64_t size) {
   DCHECK(buffer);
 
-  const uint8_t* r_ptr(static_cast<const uint8_t*>(buffer));
-  uint64_t bytes_left(size);
+  const uint8_t* source = static_cast<const uint8_t*>(buffer);
+  uint64_t bytes_left = size;
   while (bytes_left) {
-    AutoLock lock(lock_);
-    while (!closed_ && (BytesFreeInternal() == 0)) {
-      AutoUnlock unlock(lock_);
+    uint64_t bytes_free = BytesFreeInternal();
+    while (!closed() && bytes_free == 0) {
+      NoBarrier_Store(&writer_waiting_, 1);
+      MemoryBarrier();
+      bytes_free = BytesFreeInternal();
+      if (closed() || bytes_free != 0)
+        break;
       read_event_.Wait();
+      bytes_free = BytesFreeInternal();
     }
-    if (closed_)
+    NoBarrier_Store(&writer_waiting_, 0);
+    if (closed())
       return 0;
 
-    uint64_t write_size(std::min(bytes_left, BytesFreeInternal()));
-    uint64_t first_chunk_size(std::min(write_size, static_cast<uint64_t>(
-        end_ptr_ - w_ptr_)));
-    memcpy(w_ptr_, r_ptr, first_chunk_size);
-    w_ptr_ += first_chunk_size;
-    DCHECK_GE(end_ptr_, w_ptr_);
-    if (w_ptr_ == end_ptr_)
-      w_ptr_ = &circular_buffer_[0];
-    r_ptr += first_chunk_size;
-    uint64_t second_chunk_size(write_size - first_chunk_size);
+    const uint64_t buffer_size = circular_buffer_.size();
+    uint64_t write_pos = static_cast<uint64_t>(NoBarrier_Load(&write_pos_));
+    const uint64_t write_size = std::min(bytes_left, bytes_free);
+    const uint64_t first_chunk_size =
+        std::min(write_size, buffer_size - write_pos);
+    memcpy(&circular_buffer_[write_pos], source, first_chunk_size);
+    write_pos = (write_pos + first_chunk_size) % buffer_size;
+    source += first_chunk_size;
+    const uint64_t second_chunk_size = write_size - first_chunk_size;
     if (second_chunk_size) {
-      memcpy(w_ptr_, r_ptr, second_chunk_size);
-      w_ptr_ += second_chunk_size;
-      DCHECK_GT(end_ptr_, w_ptr_);
-      r_ptr += second_chunk_size;
+      memcpy(&circular_buffer_[0], source, second_chunk_size);
+      write_pos = second_chunk_size;
+      source += second_chunk_size;
     }
+    Release_Store(&write_pos_, static_cast<AtomicWord>(write_pos));
     bytes_left -= write_size;
-    write_event_.Signal();
+    MemoryBarrier();
+    if (NoBarrier_Load(&reader_waiting_))
+      write_event_.Signal();
   }
   return size;
 }
 
 void IoCache::Clear() {
-  AutoLock lock(lock_);
-  r_ptr_ = w_ptr_ = circular_buffer_.data();
+  // Consume everything that has been written so far.
+  Release_Store(&read_pos_, Acquire_Load(&write_pos_));
   // Let any writers know that there is room in the cache.
   read_event_.Signal();
 }
 
 void IoCache::Close() {
-  AutoLock lock(lock_);
-  closed_ = true;
+  NoBarrier_Store(&closed_, 1);
+  MemoryBarrier();
   read_event_.Signal();
   write_event_.Signal();
 }
 
 void IoCache::Reopen() {
-  AutoLock lock(lock_);
-  CHECK(closed_);
-  r_ptr_ = w_ptr_ = circular_buffer_.data();
-  closed_ = false;
+  CHECK(closed());
+  NoBarrier_Store(&read_pos_, 0);
+  NoBarrier_Store(&write_pos_, 0);
+  NoBarrier_Store(&reader_waiting_, 0);
+  NoBarrier_Store(&writer_waiting_, 0);
   read_event_.Reset();
   write_event_.Reset();
+  MemoryBarrier();
+  NoBarrier_Store(&closed_, 0);
 }
 
 uint64_t IoCache::BytesCached() {
-  AutoLock lock(lock_);
   return BytesCachedInternal();
 }
 
 uint64_t IoCache::BytesFree() {
-  AutoLock lock(lock_);
   return BytesFreeInternal();
 }
 
 uint64_t IoCache::BytesCachedInternal() {
-  return (r_ptr_ <= w_ptr_)
-             ? w_ptr_ - r_ptr_
-             : (end_ptr_ - r_ptr_) + (w_ptr_ - circular_buffer_.data());
+  const uint64_t buffer_size = circular_buffer_.size();
+  const uint64_t read_pos = static_cast<uint64_t>(Acquire_Load(&read_pos_));
+  const uint64_t write_pos = static_cast<uint64_t>(Acquire_Load(&write_pos_));
+  return (write_pos + buffer_size - read_pos) % buffer_size;
 }
 
 uint64_t IoCache::BytesFreeInternal() {
@@ -143,11 +169,14 @@ uint64_t IoCache::BytesFreeInternal() {
 }
 
 void IoCache::WaitUntilEmptyOrClosed() {
-  AutoLock lock(lock_);
-  while (!closed_ && BytesCachedInternal()) {
-    AutoUnlock unlock(lock_);
+  while (!closed() && BytesCachedInternal() != 0) {
+    NoBarrier_Store(&writer_waiting_, 1);
+    MemoryBarrier();
+    if (closed() || BytesCachedInternal() == 0)
+      break;
     read_event_.Wait();
   }
+  NoBarrier_Store(&writer_waiting_, 0);
 }
 
 }  // namespace media
@@ -9,14 +9,19 @@
 
 #include <stdint.h>
 #include <vector>
+#include "packager/base/atomicops.h"
 #include "packager/base/macros.h"
-#include "packager/base/synchronization/lock.h"
 #include "packager/base/synchronization/waitable_event.h"
 
 namespace shaka {
 namespace media {
 
 /// Declaration of class which implements a thread-safe circular buffer.
+/// The implementation is a lock-free single-producer/single-consumer ring:
+/// one thread may call Write (the producer) and one thread may call Read
+/// (the consumer). Transfers do not take a lock; a thread blocks only on an
+/// empty (reader) or full (writer) cache, and the peer signals only when the
+/// other side has announced it is waiting.
 class IoCache {
  public:
   explicit IoCache(uint64_t cache_size);
@@ -39,7 +44,8 @@ class IoCache {
   ///         closed.
   uint64_t Write(const void* buffer, uint64_t size);
 
-  /// Empties the cache.
+  /// Empties the cache. Must be called from the consumer thread, or while the
+  /// producer is known not to be writing.
   void Clear();
 
   /// Close the cache. This will call any blocking calls to unblock, and the
@@ -47,7 +53,7 @@ class IoCache {
   void Close();
 
   /// @return true if the cache is closed, false otherwise.
-  bool closed() { return closed_; }
+  bool closed() { return base::subtle::NoBarrier_Load(&closed_) != 0; }
 
   /// Reopens the cache. Any data still in the cache will be lost.
   void Reopen();
@@ -68,14 +74,20 @@ class IoCache {
   uint64_t BytesFreeInternal();
 
   const uint64_t cache_size_;
-  base::Lock lock_;
+  // Signaled by the consumer when it frees room, but only while
+  // |writer_waiting_| is set.
   base::WaitableEvent read_event_;
+  // Signaled by the producer when it adds data, but only while
+  // |reader_waiting_| is set.
   base::WaitableEvent write_event_;
   std::vector<uint8_t> circular_buffer_;
-  const uint8_t* end_ptr_;
-  uint8_t* r_ptr_;
-  uint8_t* w_ptr_;
-  bool closed_;
+  // Offsets into |circular_buffer_|. Each is written by exactly one side:
+  // |read_pos_| by the consumer, |write_pos_| by the producer.
+  base::subtle::AtomicWord read_pos_;
+  base::subtle::AtomicWord write_pos_;
+  base::subtle::Atomic32 reader_waiting_;
+  base::subtle::Atomic32 writer_waiting_;
+  base::subtle::Atomic32 closed_;
 
   DISALLOW_COPY_AND_ASSIGN(IoCache);
 };
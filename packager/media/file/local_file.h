@@ -30,6 +30,8 @@ class LocalFile : public File {
   bool Close() override;
   int64_t Read(void* buffer, uint64_t length) override;
   int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t WriteVectored(const Region* regions, size_t num_regions) override;
+  void SetSizeHint(uint64_t size) override;
   int64_t Size() override;
   bool Flush() override;
   bool Seek(uint64_t position) override;
@@ -47,8 +49,12 @@ class LocalFile : public File {
   bool Open() override;
 
  private:
+  // Issues fdatasync every --fsync_interval_bytes written bytes.
+  void MaybePeriodicSync(int64_t bytes_written);
+
   std::string file_mode_;
   FILE* internal_file_;
+  uint64_t bytes_since_sync_;
 
   DISALLOW_COPY_AND_ASSIGN(LocalFile);
 };
@@ -10,14 +10,18 @@
 
 #include <map>
 
+#include "packager/base/atomicops.h"
 #include "packager/base/logging.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/lock.h"
 
 namespace shaka {
 namespace media {
 namespace {
 
-// A helper filesystem object.  This holds the data for the memory files.
+// A helper filesystem object.  This maps file names to refcounted contents
+// and may be used from multiple threads, e.g. a muxer thread writing the
+// next segment while an embedding application serves the previous one.
 class FileSystem {
  public:
   ~FileSystem() {}
@@ -29,33 +33,56 @@ class FileSystem {
     return g_file_system_.get();
   }
 
-  bool Exists(const std::string& file_name) const {
-    return files_.find(file_name) != files_.end();
+  scoped_refptr<MemoryFileContents> GetFile(const std::string& file_name) {
+    base::AutoLock auto_lock(lock_);
+    std::map<std::string, scoped_refptr<MemoryFileContents> >::iterator it =
+        files_.find(file_name);
+    return it == files_.end() ? scoped_refptr<MemoryFileContents>()
+                              : it->second;
   }
 
-  std::vector<uint8_t>* GetFile(const std::string& file_name) {
-    return &files_[file_name];
+  // Publishes a fresh contents object under |file_name|, detaching the name
+  // from any previous contents without touching them.
+  scoped_refptr<MemoryFileContents> CreateFile(const std::string& file_name) {
+    base::AutoLock auto_lock(lock_);
+    scoped_refptr<MemoryFileContents> contents(new MemoryFileContents);
+    files_[file_name] = contents;
+    return contents;
   }
 
-  void Delete(const std::string& file_name) { files_.erase(file_name); }
+  void Delete(const std::string& file_name) {
+    base::AutoLock auto_lock(lock_);
+    files_.erase(file_name);
+  }
 
-  void DeleteAll() { files_.clear(); }
+  void DeleteAll() {
+    base::AutoLock auto_lock(lock_);
+    files_.clear();
+  }
 
  private:
   FileSystem() {}
 
   static scoped_ptr<FileSystem> g_file_system_;
 
-  std::map<std::string, std::vector<uint8_t> > files_;
+  base::Lock lock_;
+  std::map<std::string, scoped_refptr<MemoryFileContents> > files_;
   DISALLOW_COPY_AND_ASSIGN(FileSystem);
 };
 
 scoped_ptr<FileSystem> FileSystem::g_file_system_;
 
+// See MemoryFile::total_bytes_written().
+base::subtle::AtomicWord g_total_bytes_written = 0;
+
 }  // namespace
 
+MemoryFileContents::MemoryFileContents() {}
+
+MemoryFileContents::~MemoryFileContents() {}
+
 MemoryFile::MemoryFile(const std::string& file_name, const std::string& mode)
-    : File(file_name), mode_(mode), file_(NULL), position_(0) {}
+    : File(file_name), mode_(mode), position_(0) {}
 
 MemoryFile::~MemoryFile() {}
 
@@ -71,25 +98,29 @@ int64_t MemoryFile::Read(void* buffer, uint64_t length) {
     return 0;
 
   const uint64_t bytes_to_read = std::min(length, size - position_);
-  memcpy(buffer, &(*file_)[position_], bytes_to_read);
+  memcpy(buffer, &contents_->data()[position_], bytes_to_read);
   position_ += bytes_to_read;
   return bytes_to_read;
 }
 
 int64_t MemoryFile::Write(const void* buffer, uint64_t length) {
-  const uint64_t size = Size();
+  DCHECK_EQ("w", mode_);
+  std::vector<uint8_t>* data = contents_->mutable_data();
+  const uint64_t size = data->size();
   if (size < position_ + length) {
-    file_->resize(position_ + length);
+    data->resize(position_ + length);
   }
 
-  memcpy(&(*file_)[position_], buffer, length);
+  memcpy(&(*data)[position_], buffer, length);
   position_ += length;
+  base::subtle::NoBarrier_AtomicIncrement(
+      &g_total_bytes_written, static_cast<base::subtle::AtomicWord>(length));
   return length;
 }
 
 int64_t MemoryFile::Size() {
-  DCHECK(file_);
-  return file_->size();
+  DCHECK(contents_);
+  return contents_->data().size();
 }
 
 bool MemoryFile::Flush() {
@@ -112,21 +143,26 @@ bool MemoryFile::Tell(uint64_t* position) {
 bool MemoryFile::Open() {
   FileSystem* file_system = FileSystem::Instance();
   if (mode_ == "r") {
-    if (!file_system->Exists(file_name()))
+    contents_ = file_system->GetFile(file_name());
+    if (!contents_)
       return false;
   } else if (mode_ == "w") {
-    file_system->Delete(file_name());
+    contents_ = file_system->CreateFile(file_name());
   } else {
     NOTIMPLEMENTED() << "File mode " << mode_ << " not supported by MemoryFile";
     return false;
   }
 
-  file_ = file_system->GetFile(file_name());
-  DCHECK(file_);
+  DCHECK(contents_);
   position_ = 0;
   return true;
 }
 
+scoped_refptr<MemoryFileContents> MemoryFile::GetContents(
+    const std::string& file_name) {
+  return FileSystem::Instance()->GetFile(file_name);
+}
+
 void MemoryFile::DeleteAll() {
   FileSystem::Instance()->DeleteAll();
 }
@@ -135,6 +171,14 @@ void MemoryFile::Delete(const std::string& file_name) {
   FileSystem::Instance()->Delete(file_name);
 }
 
+uint64_t MemoryFile::total_bytes_written() {
+  return static_cast<uint64_t>(
+      base::subtle::NoBarrier_Load(&g_total_bytes_written));
+}
+
+void MemoryFile::ResetTotalBytesWritten() {
+  base::subtle::NoBarrier_Store(&g_total_bytes_written, 0);
+}
+
 }  // namespace media
 }  // namespace shaka
-
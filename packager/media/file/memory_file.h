@@ -12,13 +12,41 @@
 #include <string>
 #include <vector>
 
+#include "packager/base/memory/ref_counted.h"
 #include "packager/media/file/file.h"
 
 namespace shaka {
 namespace media {
 
-/// Implements a File that is stored in memory.  This should be only used for
-/// testing, since this does not support larger files.
+/// Refcounted contents of a memory file. The buffer is mutable while a
+/// writing MemoryFile has it open and must be treated as immutable once the
+/// writer is closed. Rewriting or deleting the file detaches the name from
+/// this object but leaves it valid for existing references, so an embedding
+/// application can serve a finished segment zero-copy from another thread
+/// while the muxer writes the next one.
+class MemoryFileContents
+    : public base::RefCountedThreadSafe<MemoryFileContents> {
+ public:
+  MemoryFileContents();
+
+  const std::vector<uint8_t>& data() const { return data_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<MemoryFileContents>;
+  friend class MemoryFile;
+  ~MemoryFileContents();
+
+  std::vector<uint8_t>* mutable_data() { return &data_; }
+
+  std::vector<uint8_t> data_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryFileContents);
+};
+
+/// Implements a File that is stored in memory.  File contents are refcounted:
+/// readers and the embedding application share the writer's buffer without
+/// copying, and a rewrite of the same name publishes a fresh buffer instead
+/// of touching the one existing references point at.
 class MemoryFile : public File {
  public:
   MemoryFile(const std::string& file_name, const std::string& mode);
@@ -34,6 +62,13 @@ class MemoryFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
+  /// Returns the contents published under @a file_name, or NULL if no such
+  /// file exists. The returned snapshot stays valid even if the file is
+  /// rewritten or deleted; treat it as immutable once the writer has closed
+  /// the file.
+  static scoped_refptr<MemoryFileContents> GetContents(
+      const std::string& file_name);
+
   /// Deletes all memory file data created.  This assumes that there are no
   /// MemoryFile objects alive.  Any alive objects will be in an undefined
   /// state.
@@ -42,13 +77,21 @@ class MemoryFile : public File {
   /// with that file name will be in an undefined state.
   static void Delete(const std::string& file_name);
 
+  /// @return The total number of bytes written through memory files since
+  ///         process start or the last ResetTotalBytesWritten(). Useful for
+  ///         measuring output volume in tests and benchmarks.
+  static uint64_t total_bytes_written();
+
+  /// Resets the counter returned by total_bytes_written().
+  static void ResetTotalBytesWritten();
+
  protected:
   ~MemoryFile() override;
   bool Open() override;
 
  private:
   std::string mode_;
-  std::vector<uint8_t>* file_;
+  scoped_refptr<MemoryFileContents> contents_;
   uint64_t position_;
 
   DISALLOW_COPY_AND_ASSIGN(MemoryFile);
@@ -58,4 +101,3 @@ class MemoryFile : public File {
 }  // namespace shaka
 
 #endif  // MEDIA_FILE_MEDIA_FILE_H_
-
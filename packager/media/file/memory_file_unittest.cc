@@ -101,6 +101,31 @@ TEST_F(MemoryFileTest, ReadMissingFileFails) {
   EXPECT_FALSE(file);
 }
 
+TEST_F(MemoryFileTest, RewriteKeepsOldContentsAlive) {
+  scoped_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+  ASSERT_TRUE(writer.release()->Close());
+
+  scoped_refptr<MemoryFileContents> snapshot(
+      MemoryFile::GetContents("file1"));
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(static_cast<size_t>(kWriteBufferSize), snapshot->data().size());
+
+  // Rewriting the file publishes fresh contents; the snapshot is unchanged.
+  scoped_ptr<File, FileCloser> rewriter(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(rewriter);
+  const uint8_t kOtherBuffer[] = {9, 10};
+  ASSERT_EQ(static_cast<int64_t>(sizeof(kOtherBuffer)),
+            rewriter->Write(kOtherBuffer, sizeof(kOtherBuffer)));
+  ASSERT_TRUE(rewriter.release()->Close());
+
+  EXPECT_EQ(static_cast<size_t>(kWriteBufferSize), snapshot->data().size());
+  EXPECT_EQ(0, memcmp(kWriteBuffer, &snapshot->data()[0], kWriteBufferSize));
+  EXPECT_EQ(sizeof(kOtherBuffer),
+            MemoryFile::GetContents("file1")->data().size());
+}
+
 TEST_F(MemoryFileTest, WriteExistingFileDeletes) {
   scoped_ptr<File, FileCloser> file1(File::Open("memory://file1", "w"));
   ASSERT_TRUE(file1);
@@ -0,0 +1,91 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/file/mmap_file.h"
+
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+
+MmapFile::MmapFile(const char* file_name)
+    : File(file_name), position_(0) {}
+
+MmapFile::~MmapFile() {}
+
+bool MmapFile::Close() {
+  delete this;
+  return true;
+}
+
+int64_t MmapFile::Read(void* buffer, uint64_t length) {
+  DCHECK(buffer != NULL);
+  DCHECK(mapping_.IsValid());
+  const uint64_t file_size = mapping_.length();
+  if (position_ >= file_size)
+    return 0;
+  const uint64_t bytes_to_read =
+      std::min(length, file_size - position_);
+  memcpy(buffer, mapping_.data() + position_, bytes_to_read);
+  position_ += bytes_to_read;
+  return bytes_to_read;
+}
+
+int64_t MmapFile::Write(const void* buffer, uint64_t length) {
+  NOTIMPLEMENTED() << "MmapFile is read-only.";
+  return -1;
+}
+
+int64_t MmapFile::Size() {
+  DCHECK(mapping_.IsValid());
+  return mapping_.length();
+}
+
+bool MmapFile::Flush() {
+  // Nothing to flush for a read-only mapping.
+  return true;
+}
+
+bool MmapFile::Seek(uint64_t position) {
+  if (position > static_cast<uint64_t>(mapping_.length()))
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool MmapFile::Tell(uint64_t* position) {
+  DCHECK(position != NULL);
+  *position = position_;
+  return true;
+}
+
+bool MmapFile::Open() {
+  if (!mapping_.Initialize(base::FilePath(file_name()))) {
+    LOG(ERROR) << "Cannot memory map file " << file_name()
+               << "; retry without --mmap_file_reads.";
+    return false;
+  }
+#if defined(__linux__)
+  // Parsers sweep the input mostly sequentially; let readahead know.
+  if (madvise(const_cast<uint8_t*>(mapping_.data()), mapping_.length(),
+              MADV_SEQUENTIAL) != 0) {
+    DLOG(WARNING) << "madvise failed for " << file_name();
+  }
+#endif
+  position_ = 0;
+  return true;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,53 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_MMAP_FILE_H_
+#define PACKAGER_FILE_MMAP_FILE_H_
+
+#include <stdint.h>
+
+#include "packager/base/files/memory_mapped_file.h"
+#include "packager/media/file/file.h"
+
+namespace shaka {
+namespace media {
+
+/// Read-only local file backed by a memory mapping. Read is a straight copy
+/// out of the mapping with no system call or user-space cache, which benefits
+/// parsers that sweep a large input sequentially, e.g. MP4 parsing of big
+/// mezzanine files. Enabled for local reads with --mmap_file_reads.
+class MmapFile : public File {
+ public:
+  /// @param file_name C string containing the name of the file to be opened.
+  explicit MmapFile(const char* file_name);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+ protected:
+  ~MmapFile() override;
+
+  bool Open() override;
+
+ private:
+  base::MemoryMappedFile mapping_;
+  uint64_t position_;
+
+  DISALLOW_COPY_AND_ASSIGN(MmapFile);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_MMAP_FILE_H_
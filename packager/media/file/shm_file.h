@@ -0,0 +1,77 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_FILE_SHM_FILE_H_
+#define MEDIA_FILE_SHM_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "packager/media/file/file.h"
+
+namespace shaka {
+namespace media {
+
+/// File backed by a named POSIX shared memory segment, one segment per file.
+/// Lets a consumer process running next to the packager, e.g. an uploader
+/// sidecar, take finished segments over with no disk I/O at all: the
+/// consumer maps the same name and learns of completion through a named
+/// semaphore (the segment name plus ".ready") which is posted when the
+/// writer closes the file. A small header at the start of the mapping holds
+/// the payload size and a completion flag, so a consumer can also poll
+/// instead of blocking on the semaphore.
+///
+/// Segment names must not contain '/'. Not supported on Windows.
+class ShmFile : public File {
+ public:
+  /// @param file_name is the name of the shared memory segment, without the
+  ///        "shm://" prefix.
+  /// @param mode C string containing a file access mode; "w" and "r" are
+  ///        supported.
+  ShmFile(const char* file_name, const char* mode);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  void SetSizeHint(uint64_t size) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+  /// Removes the shared memory segment and its completion semaphore.
+  /// @return true on success, false otherwise.
+  static bool Delete(const char* file_name);
+
+ protected:
+  ~ShmFile() override;
+
+  bool Open() override;
+
+ private:
+  // Grows the segment so it can hold |new_capacity| payload bytes and
+  // re-establishes the mapping. The existing contents are preserved.
+  bool Remap(uint64_t new_capacity);
+
+  std::string mode_;
+  int fd_;
+  // The segment header followed by the payload, or NULL if not mapped.
+  uint8_t* mapping_;
+  uint64_t mapped_size_;  // Includes the header.
+  uint64_t position_;
+  uint64_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShmFile);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_FILE_SHM_FILE_H_
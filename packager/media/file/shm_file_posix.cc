@@ -0,0 +1,266 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/file/shm_file.h"
+
+#include <fcntl.h>
+#include <semaphore.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "packager/base/atomicops.h"
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint32_t kShmMagic = 0x7368504b;  // 'shPK'.
+const uint32_t kShmVersion = 1;
+// Initial payload capacity of a writable segment; grown by doubling.
+const uint64_t kInitialPayloadCapacity = 256 * 1024;
+const char kReadySemaphoreSuffix[] = ".ready";
+
+// Lives at the start of the segment, followed by the payload.
+struct ShmSegmentHeader {
+  uint32_t magic;
+  uint32_t version;
+  // Number of payload bytes; valid once |complete| is set.
+  uint64_t payload_size;
+  // Set with release semantics after |payload_size|, so a consumer that
+  // observes it nonzero reads a consistent size.
+  base::subtle::Atomic32 complete;
+  uint32_t reserved;
+};
+
+// POSIX shared memory names are a single path component with a leading '/'.
+std::string ShmName(const std::string& file_name) {
+  return "/" + file_name;
+}
+
+}  // namespace
+
+ShmFile::ShmFile(const char* file_name, const char* mode)
+    : File(file_name),
+      mode_(mode),
+      fd_(-1),
+      mapping_(NULL),
+      mapped_size_(0),
+      position_(0),
+      size_(0) {}
+
+ShmFile::~ShmFile() {
+  if (mapping_)
+    munmap(mapping_, mapped_size_);
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+bool ShmFile::Open() {
+  if (mode_ != "r" && mode_ != "w") {
+    NOTIMPLEMENTED() << "ShmFile does not support '" << mode_ << "' mode.";
+    return false;
+  }
+  if (strchr(file_name(), '/') != NULL) {
+    LOG(ERROR) << "Shared memory segment names must not contain '/': "
+               << file_name();
+    return false;
+  }
+  const std::string name = ShmName(file_name());
+
+  if (mode_ == "w") {
+    fd_ = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd_ < 0) {
+      LOG(ERROR) << "Cannot create shared memory segment " << name;
+      return false;
+    }
+    if (!Remap(kInitialPayloadCapacity))
+      return false;
+    ShmSegmentHeader* header = reinterpret_cast<ShmSegmentHeader*>(mapping_);
+    header->magic = kShmMagic;
+    header->version = kShmVersion;
+    header->payload_size = 0;
+    header->complete = 0;
+    header->reserved = 0;
+    return true;
+  }
+
+  fd_ = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd_ < 0) {
+    LOG(ERROR) << "Cannot open shared memory segment " << name;
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd_, &info) != 0 ||
+      static_cast<uint64_t>(info.st_size) < sizeof(ShmSegmentHeader)) {
+    LOG(ERROR) << "Shared memory segment " << name << " is too small.";
+    return false;
+  }
+  mapped_size_ = info.st_size;
+  void* address = mmap(NULL, mapped_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (address == MAP_FAILED) {
+    LOG(ERROR) << "Cannot map shared memory segment " << name;
+    mapped_size_ = 0;
+    return false;
+  }
+  mapping_ = static_cast<uint8_t*>(address);
+
+  const ShmSegmentHeader* header =
+      reinterpret_cast<const ShmSegmentHeader*>(mapping_);
+  if (header->magic != kShmMagic || header->version != kShmVersion) {
+    LOG(ERROR) << "Not a packager shared memory segment: " << name;
+    return false;
+  }
+  if (!base::subtle::Acquire_Load(
+          const_cast<base::subtle::Atomic32*>(&header->complete))) {
+    LOG(ERROR) << "Shared memory segment " << name
+               << " is still being written.";
+    return false;
+  }
+  if (header->payload_size > mapped_size_ - sizeof(ShmSegmentHeader)) {
+    LOG(ERROR) << "Corrupt shared memory segment " << name;
+    return false;
+  }
+  size_ = header->payload_size;
+  return true;
+}
+
+bool ShmFile::Close() {
+  bool result = true;
+  if (mode_ == "w" && mapping_) {
+    ShmSegmentHeader* header = reinterpret_cast<ShmSegmentHeader*>(mapping_);
+    header->payload_size = size_;
+    base::subtle::Release_Store(&header->complete, 1);
+    // Drop the unused tail of the growth capacity so the consumer maps only
+    // what was written.
+    if (ftruncate(fd_, sizeof(ShmSegmentHeader) + size_) != 0)
+      DLOG(WARNING) << "Cannot trim shared memory segment " << file_name();
+    // Wake a consumer waiting for this segment. Whichever side gets here
+    // first creates the semaphore.
+    sem_t* semaphore =
+        sem_open((ShmName(file_name()) + kReadySemaphoreSuffix).c_str(),
+                 O_CREAT, 0600, 0);
+    if (semaphore == SEM_FAILED) {
+      LOG(ERROR) << "Cannot signal completion of shared memory segment "
+                 << file_name();
+      result = false;
+    } else {
+      sem_post(semaphore);
+      sem_close(semaphore);
+    }
+  }
+  if (mapping_) {
+    munmap(mapping_, mapped_size_);
+    mapping_ = NULL;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  delete this;
+  return result;
+}
+
+int64_t ShmFile::Read(void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK(mapping_);
+  if (mode_ != "r")
+    return -1;
+  if (position_ >= size_)
+    return 0;
+  const uint64_t bytes_to_read = std::min(length, size_ - position_);
+  memcpy(buffer, mapping_ + sizeof(ShmSegmentHeader) + position_,
+         bytes_to_read);
+  position_ += bytes_to_read;
+  return bytes_to_read;
+}
+
+int64_t ShmFile::Write(const void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK(mapping_);
+  if (mode_ != "w")
+    return -1;
+  const uint64_t required_capacity = position_ + length;
+  uint64_t capacity = mapped_size_ - sizeof(ShmSegmentHeader);
+  if (required_capacity > capacity) {
+    uint64_t new_capacity = std::max(capacity, kInitialPayloadCapacity);
+    while (new_capacity < required_capacity)
+      new_capacity *= 2;
+    if (!Remap(new_capacity))
+      return -1;
+  }
+  memcpy(mapping_ + sizeof(ShmSegmentHeader) + position_, buffer, length);
+  position_ += length;
+  size_ = std::max(size_, position_);
+  return length;
+}
+
+void ShmFile::SetSizeHint(uint64_t size) {
+  if (mode_ != "w" || size == 0)
+    return;
+  const uint64_t capacity = mapped_size_ - sizeof(ShmSegmentHeader);
+  if (size > capacity && !Remap(size))
+    DLOG(WARNING) << "Cannot presize shared memory segment " << file_name();
+}
+
+int64_t ShmFile::Size() {
+  return size_;
+}
+
+bool ShmFile::Flush() {
+  // The mapping is shared; there is nothing to flush.
+  return true;
+}
+
+bool ShmFile::Seek(uint64_t position) {
+  // Seeking past the end is allowed in write mode; the next write grows the
+  // segment.
+  if (mode_ == "r" && position > size_)
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool ShmFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool ShmFile::Remap(uint64_t new_capacity) {
+  const uint64_t new_mapped_size = sizeof(ShmSegmentHeader) + new_capacity;
+  if (mapping_) {
+    munmap(mapping_, mapped_size_);
+    mapping_ = NULL;
+  }
+  if (ftruncate(fd_, new_mapped_size) != 0) {
+    LOG(ERROR) << "Cannot grow shared memory segment " << file_name();
+    return false;
+  }
+  void* address = mmap(NULL, new_mapped_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd_, 0);
+  if (address == MAP_FAILED) {
+    LOG(ERROR) << "Cannot map shared memory segment " << file_name();
+    mapped_size_ = 0;
+    return false;
+  }
+  mapping_ = static_cast<uint8_t*>(address);
+  mapped_size_ = new_mapped_size;
+  return true;
+}
+
+bool ShmFile::Delete(const char* file_name) {
+  const std::string name = ShmName(file_name);
+  sem_unlink((name + kReadySemaphoreSuffix).c_str());
+  return shm_unlink(name.c_str()) == 0;
+}
+
+}  // namespace media
+}  // namespace shaka
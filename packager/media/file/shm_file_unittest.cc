@@ -0,0 +1,112 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/file/file.h"
+#include "packager/media/file/file_closer.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kShmFileName[] = "shm://shm_file_unittest";
+const uint8_t kWriteBuffer[] = {1, 2, 3, 4, 5, 6, 7, 8};
+const int64_t kWriteBufferSize = sizeof(kWriteBuffer);
+
+}  // namespace
+
+class ShmFileTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    File::Delete(kShmFileName);
+  }
+};
+
+TEST_F(ShmFileTest, WriteThenRead) {
+  scoped_ptr<File, FileCloser> writer(File::Open(kShmFileName, "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+  EXPECT_EQ(kWriteBufferSize, writer->Size());
+  ASSERT_TRUE(writer.release()->Close());
+
+  scoped_ptr<File, FileCloser> reader(File::Open(kShmFileName, "r"));
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(kWriteBufferSize, reader->Size());
+
+  uint8_t read_buffer[kWriteBufferSize];
+  ASSERT_EQ(kWriteBufferSize, reader->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kWriteBuffer, read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, reader->Read(read_buffer, kWriteBufferSize));
+}
+
+TEST_F(ShmFileTest, SeekBackAndRewrite) {
+  scoped_ptr<File, FileCloser> writer(File::Open(kShmFileName, "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+
+  // Patch the first two bytes, like muxers do when they fix up box sizes.
+  const uint8_t kPatch[] = {42, 43};
+  ASSERT_TRUE(writer->Seek(0));
+  ASSERT_EQ(static_cast<int64_t>(sizeof(kPatch)),
+            writer->Write(kPatch, sizeof(kPatch)));
+  EXPECT_EQ(kWriteBufferSize, writer->Size());
+
+  uint64_t position;
+  ASSERT_TRUE(writer->Tell(&position));
+  EXPECT_EQ(sizeof(kPatch), position);
+  ASSERT_TRUE(writer.release()->Close());
+
+  scoped_ptr<File, FileCloser> reader(File::Open(kShmFileName, "r"));
+  ASSERT_TRUE(reader);
+  uint8_t read_buffer[kWriteBufferSize];
+  ASSERT_EQ(kWriteBufferSize, reader->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kPatch, read_buffer, sizeof(kPatch)));
+  EXPECT_EQ(0, memcmp(kWriteBuffer + sizeof(kPatch),
+                      read_buffer + sizeof(kPatch),
+                      kWriteBufferSize - sizeof(kPatch)));
+}
+
+TEST_F(ShmFileTest, GrowsPastInitialCapacity) {
+  // Larger than the initial segment capacity, so writing forces a remap.
+  const size_t kLargeSize = 1024 * 1024;
+  std::vector<uint8_t> large_buffer(kLargeSize);
+  for (size_t i = 0; i < kLargeSize; ++i)
+    large_buffer[i] = static_cast<uint8_t>(i);
+
+  scoped_ptr<File, FileCloser> writer(File::Open(kShmFileName, "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(static_cast<int64_t>(kLargeSize),
+            writer->Write(&large_buffer[0], kLargeSize));
+  ASSERT_TRUE(writer.release()->Close());
+
+  scoped_ptr<File, FileCloser> reader(File::Open(kShmFileName, "r"));
+  ASSERT_TRUE(reader);
+  ASSERT_EQ(static_cast<int64_t>(kLargeSize), reader->Size());
+  std::vector<uint8_t> read_buffer(kLargeSize);
+  ASSERT_EQ(static_cast<int64_t>(kLargeSize),
+            reader->Read(&read_buffer[0], kLargeSize));
+  EXPECT_EQ(0, memcmp(&large_buffer[0], &read_buffer[0], kLargeSize));
+}
+
+TEST_F(ShmFileTest, ReadMissingSegmentFails) {
+  scoped_ptr<File, FileCloser> reader(
+      File::Open("shm://shm_file_unittest_missing", "r"));
+  EXPECT_FALSE(reader);
+}
+
+TEST_F(ShmFileTest, RejectsNameWithSlash) {
+  scoped_ptr<File, FileCloser> writer(
+      File::Open("shm://bad/name", "w"));
+  EXPECT_FALSE(writer);
+}
+
+}  // namespace media
+}  // namespace shaka
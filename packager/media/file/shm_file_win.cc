@@ -0,0 +1,79 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/file/shm_file.h"
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+
+ShmFile::ShmFile(const char* file_name, const char* mode)
+    : File(file_name),
+      mode_(mode),
+      fd_(-1),
+      mapping_(NULL),
+      mapped_size_(0),
+      position_(0),
+      size_(0) {}
+
+ShmFile::~ShmFile() {}
+
+bool ShmFile::Close() {
+  NOTIMPLEMENTED();
+  delete this;
+  return false;
+}
+
+int64_t ShmFile::Read(void* buffer, uint64_t length) {
+  NOTIMPLEMENTED();
+  return -1;
+}
+
+int64_t ShmFile::Write(const void* buffer, uint64_t length) {
+  NOTIMPLEMENTED();
+  return -1;
+}
+
+void ShmFile::SetSizeHint(uint64_t size) {}
+
+int64_t ShmFile::Size() {
+  NOTIMPLEMENTED();
+  return -1;
+}
+
+bool ShmFile::Flush() {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool ShmFile::Seek(uint64_t position) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool ShmFile::Tell(uint64_t* position) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool ShmFile::Open() {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool ShmFile::Remap(uint64_t new_capacity) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool ShmFile::Delete(const char* file_name) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+}  // namespace media
+}  // namespace shaka
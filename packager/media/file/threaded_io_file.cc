@@ -6,11 +6,23 @@
 
 #include "packager/media/file/threaded_io_file.h"
 
+#include <algorithm>
+
+#include <gflags/gflags.h>
+
 #include "packager/base/bind.h"
 #include "packager/base/bind_helpers.h"
 #include "packager/base/location.h"
 #include "packager/base/threading/worker_pool.h"
 
+DEFINE_bool(io_async_flush,
+            false,
+            "Do not block output file flushes on draining the threaded I/O "
+            "cache. The writer thread keeps draining in the background and "
+            "write errors surface on a later write or on close. Removes the "
+            "per-segment flush stall for live output, at the cost of flush "
+            "no longer guaranteeing the data has reached the OS.");
+
 namespace shaka {
 namespace media {
 
@@ -26,6 +38,9 @@ ThreadedIoFile::ThreadedIoFile(scoped_ptr<File, FileCloser> internal_file,
       mode_(mode),
       cache_(io_cache_size),
       io_buffer_(io_block_size),
+      min_block_size_(io_block_size),
+      max_block_size_(std::max(io_block_size, io_cache_size / 4)),
+      block_size_(io_block_size),
       position_(0),
       size_(0),
       eof_(false),
@@ -99,6 +114,11 @@ int64_t ThreadedIoFile::Write(const void* buffer, uint64_t length) {
   return bytes_written;
 }
 
+void ThreadedIoFile::SetSizeHint(uint64_t size) {
+  DCHECK(internal_file_);
+  internal_file_->SetSizeHint(size);
+}
+
 int64_t ThreadedIoFile::Size() {
   DCHECK(internal_file_);
 
@@ -109,6 +129,15 @@ bool ThreadedIoFile::Flush() {
   DCHECK(internal_file_);
   DCHECK_EQ(kOutputMode, mode_);
 
+  if (FLAGS_io_async_flush) {
+    // The writer thread drains the cache in the background; only report
+    // errors it has hit so far. Close() still waits for the full drain.
+    return NoBarrier_Load(&internal_file_error_) == 0;
+  }
+  return FlushBlocking();
+}
+
+bool ThreadedIoFile::FlushBlocking() {
   flushing_ = true;
   cache_.Close();
   flush_complete_event_.Wait();
@@ -117,12 +146,42 @@ bool ThreadedIoFile::Flush() {
 
 bool ThreadedIoFile::Seek(uint64_t position) {
   if (mode_ == kOutputMode) {
-    // Writing. Just flush the cache and seek.
-    if (!Flush()) return false;
+    // Writing. Just flush the cache and seek. The flush must drain the
+    // cache even in async flush mode, or buffered writes would land at the
+    // new position.
+    if (!FlushBlocking()) return false;
     if (!internal_file_->Seek(position)) return false;
   } else {
-    // Reading. Close cache, wait for thread task to exit, seek, and re-post
-    // the task.
+    // Reading. A forward seek landing in already-buffered data, or in a
+    // small gap past it, is served from the cache by discarding the
+    // intervening bytes while the reader task keeps filling ahead. Only
+    // distant or backward seeks pay for the full cache flush and refill
+    // below.
+    if (position >= position_ &&
+        position - position_ <= cache_.BytesCached() + max_block_size_ &&
+        !NoBarrier_Load(&internal_file_error_)) {
+      uint64_t bytes_to_discard = position - position_;
+      std::vector<uint8_t> scratch(std::min(
+          bytes_to_discard, static_cast<uint64_t>(64 * 1024)));
+      bool discarded = true;
+      while (bytes_to_discard > 0) {
+        const uint64_t bytes_read = cache_.Read(
+            &scratch[0], std::min<uint64_t>(bytes_to_discard, scratch.size()));
+        if (bytes_read == 0) {
+          // The cache closed before the gap was consumed (EOF or error).
+          // Fall through to the flush path, which seeks the underlying file
+          // directly.
+          discarded = false;
+          break;
+        }
+        bytes_to_discard -= bytes_read;
+      }
+      if (discarded) {
+        position_ = position;
+        return true;
+      }
+    }
+    // Close cache, wait for thread task to exit, seek, and re-post the task.
     cache_.Close();
     task_exit_event_.Wait();
     bool result = internal_file_->Seek(position);
@@ -134,6 +193,9 @@ bool ThreadedIoFile::Seek(uint64_t position) {
     }
     cache_.Reopen();
     eof_ = false;
+    // Restart with the configured block size: after a seek the first reads
+    // should complete quickly rather than fetch a large speculative block.
+    block_size_ = min_block_size_;
     base::WorkerPool::PostTask(
         FROM_HERE,
         base::Bind(&ThreadedIoFile::TaskHandler, base::Unretained(this)),
@@ -164,14 +226,26 @@ void ThreadedIoFile::RunInInputMode() {
   DCHECK_EQ(kInputMode, mode_);
 
   while (true) {
-    int64_t read_result = internal_file_->Read(&io_buffer_[0],
-                                               io_buffer_.size());
+    if (io_buffer_.size() < block_size_)
+      io_buffer_.resize(block_size_);
+    int64_t read_result = internal_file_->Read(&io_buffer_[0], block_size_);
     if (read_result <= 0) {
       NoBarrier_Store(&eof_, read_result == 0);
       NoBarrier_Store(&internal_file_error_, read_result);
       cache_.Close();
       return;
     }
+    // Adapt the block size to the observed consumer rate. A nearly empty
+    // cache means the consumer is outrunning the storage, so issue larger
+    // reads to amortize per-request latency; a nearly full cache means the
+    // storage is keeping up, so fall back towards the configured block size
+    // and keep the read latency low.
+    const uint64_t bytes_cached = cache_.BytesCached();
+    if (bytes_cached < block_size_) {
+      block_size_ = std::min(block_size_ * 2, max_block_size_);
+    } else if (cache_.BytesFree() < block_size_) {
+      block_size_ = std::max(block_size_ / 2, min_block_size_);
+    }
     if (cache_.Write(&io_buffer_[0], read_result) == 0) {
       return;
     }
@@ -35,6 +35,7 @@ class ThreadedIoFile : public File {
   bool Close() override;
   int64_t Read(void* buffer, uint64_t length) override;
   int64_t Write(const void* buffer, uint64_t length) override;
+  void SetSizeHint(uint64_t size) override;
   int64_t Size() override;
   bool Flush() override;
   bool Seek(uint64_t position) override;
@@ -52,11 +53,23 @@ class ThreadedIoFile : public File {
   void TaskHandler();
   void RunInInputMode();
   void RunInOutputMode();
+  // Drains the cache and flushes the internal file, regardless of
+  // --io_async_flush.
+  bool FlushBlocking();
 
   scoped_ptr<File, FileCloser> internal_file_;
   const Mode mode_;
   IoCache cache_;
   std::vector<uint8_t> io_buffer_;
+  // Current and maximum read block size for input mode. The reader thread
+  // grows |block_size_| while the cache runs dry and shrinks it back towards
+  // the configured block size while the cache stays full, so high-latency
+  // storage is read with fewer, larger requests without hand-tuning
+  // --io_block_size. Only accessed from the reader thread, except for the
+  // reset in Seek, which happens while no task is running.
+  const uint64_t min_block_size_;
+  const uint64_t max_block_size_;
+  uint64_t block_size_;
   uint64_t position_;
   uint64_t size_;
   base::subtle::Atomic32 eof_;
@@ -12,11 +12,17 @@
 #include <string>
 
 #include "packager/base/compiler_specific.h"
+#include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/file/file.h"
 
 namespace shaka {
 namespace media {
 
+#if defined(__linux__)
+// Reusable state for batched datagram receives; see udp_file_posix.cc.
+class UdpPacketBatch;
+#endif
+
 /// Implements UdpFile, which receives UDP unicast and multicast streams.
 class UdpFile : public File {
  public:
@@ -42,6 +48,9 @@ class UdpFile : public File {
 
  private:
   int socket_;
+#if defined(__linux__)
+  scoped_ptr<UdpPacketBatch> packet_batch_;
+#endif
 
   DISALLOW_COPY_AND_ASSIGN(UdpFile);
 };
@@ -9,11 +9,13 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <gflags/gflags.h>
+#include <string.h>
 #include <strings.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 #include <limits>
+#include <vector>
 
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
@@ -24,6 +26,12 @@ DEFINE_string(udp_interface_address,
               "0.0.0.0",
               "IP address of the interface over which to receive UDP unicast"
               " or multicast streams");
+DEFINE_int32(udp_receive_buffer_size,
+             0,
+             "Socket receive buffer size (SO_RCVBUF) for UDP streams, in "
+             "bytes. A large buffer absorbs bursts, e.g. IDR frames on "
+             "high-rate multicast, without packet loss. 0 uses the kernel "
+             "default. The kernel may cap the value; see net.core.rmem_max.");
 
 namespace shaka {
 namespace media {
@@ -31,6 +39,10 @@ namespace media {
 namespace {
 
 const int kInvalidSocket(-1);
+// Large enough for any UDP datagram.
+const size_t kMaxUdpDatagramSize(65536);
+// Number of datagrams received per recvmmsg call.
+const unsigned int kPacketBatchSize(32);
 
 bool StringToIpv4Address(const std::string& addr_in, uint32_t* addr_out) {
   DCHECK(addr_out);
@@ -81,6 +93,112 @@ bool IsIpv4MulticastAddress(uint32_t addr) {
 
 }  // anonymous namespace
 
+#if defined(__linux__)
+// Receives up to kPacketBatchSize datagrams per recvmmsg call into
+// preallocated buffers and copies them out packed back to back, so the
+// per-datagram syscall cost disappears at high multicast rates. Also tracks
+// the kernel drop counter (SO_RXQ_OVFL) delivered as ancillary data.
+class UdpPacketBatch {
+ public:
+  UdpPacketBatch()
+      : buffers_(kPacketBatchSize * kMaxUdpDatagramSize),
+        controls_(kPacketBatchSize * CMSG_SPACE(sizeof(uint32_t))),
+        iovecs_(kPacketBatchSize),
+        headers_(kPacketBatchSize),
+        num_packets_(0),
+        next_packet_(0),
+        kernel_dropped_packets_(0) {
+    for (unsigned int i = 0; i < kPacketBatchSize; ++i) {
+      iovecs_[i].iov_base = &buffers_[i * kMaxUdpDatagramSize];
+      iovecs_[i].iov_len = kMaxUdpDatagramSize;
+      headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+      headers_[i].msg_hdr.msg_iovlen = 1;
+      headers_[i].msg_hdr.msg_control =
+          &controls_[i * CMSG_SPACE(sizeof(uint32_t))];
+    }
+  }
+
+  bool HasPendingPackets() const { return next_packet_ < num_packets_; }
+
+  uint64_t kernel_dropped_packets() const { return kernel_dropped_packets_; }
+
+  /// Blocks until at least one datagram is available, then receives as many
+  /// as the kernel has queued, up to kPacketBatchSize.
+  /// @return the number of datagrams received, or -1 on error.
+  int Receive(int socket) {
+    DCHECK(!HasPendingPackets());
+    for (unsigned int i = 0; i < kPacketBatchSize; ++i) {
+      headers_[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint32_t));
+      headers_[i].msg_len = 0;
+    }
+    int result;
+    do {
+      result = recvmmsg(socket, &headers_[0], kPacketBatchSize,
+                        MSG_WAITFORONE, NULL);
+    } while ((result == -1) && (errno == EINTR));
+    if (result <= 0)
+      return result;
+    num_packets_ = result;
+    next_packet_ = 0;
+    UpdateDropCounter();
+    return result;
+  }
+
+  /// Copies whole received datagrams into @a buffer, packed back to back,
+  /// until the next datagram no longer fits or the batch is drained.
+  /// @return the number of bytes copied.
+  uint64_t CopyOut(void* buffer, uint64_t length) {
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    uint64_t bytes_copied = 0;
+    while (next_packet_ < num_packets_) {
+      const size_t packet_size = headers_[next_packet_].msg_len;
+      if (bytes_copied + packet_size > length)
+        break;
+      memcpy(out + bytes_copied,
+             &buffers_[next_packet_ * kMaxUdpDatagramSize],
+             packet_size);
+      bytes_copied += packet_size;
+      ++next_packet_;
+    }
+    return bytes_copied;
+  }
+
+ private:
+  void UpdateDropCounter() {
+    // SO_RXQ_OVFL reports the cumulative number of datagrams dropped by the
+    // kernel since the socket was created, attached to each datagram.
+    uint32_t total_dropped = 0;
+    bool have_counter = false;
+    for (unsigned int i = 0; i < num_packets_; ++i) {
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&headers_[i].msg_hdr);
+           cmsg != NULL; cmsg = CMSG_NXTHDR(&headers_[i].msg_hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+          memcpy(&total_dropped, CMSG_DATA(cmsg), sizeof(total_dropped));
+          have_counter = true;
+        }
+      }
+    }
+    if (have_counter && total_dropped > kernel_dropped_packets_) {
+      LOG(WARNING) << "UDP receive queue overflowed: dropped "
+                   << (total_dropped - kernel_dropped_packets_)
+                   << " packets (" << total_dropped
+                   << " total). Consider raising --udp_receive_buffer_size.";
+      kernel_dropped_packets_ = total_dropped;
+    }
+  }
+
+  std::vector<uint8_t> buffers_;
+  std::vector<uint8_t> controls_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<struct mmsghdr> headers_;
+  unsigned int num_packets_;
+  unsigned int next_packet_;
+  uint64_t kernel_dropped_packets_;
+
+  DISALLOW_COPY_AND_ASSIGN(UdpPacketBatch);
+};
+#endif  // defined(__linux__)
+
 UdpFile::UdpFile(const char* file_name) :
     File(file_name),
     socket_(kInvalidSocket) {}
@@ -88,6 +206,13 @@ UdpFile::UdpFile(const char* file_name) :
 UdpFile::~UdpFile() {}
 
 bool UdpFile::Close() {
+#if defined(__linux__)
+  if (packet_batch_ && packet_batch_->kernel_dropped_packets() > 0) {
+    LOG(WARNING) << "UDP stream " << file_name() << " dropped "
+                 << packet_batch_->kernel_dropped_packets()
+                 << " packets in the kernel receive queue.";
+  }
+#endif
   if (socket_ != kInvalidSocket) {
     close(socket_);
     socket_ = kInvalidSocket;
@@ -104,12 +229,22 @@ int64_t UdpFile::Read(void* buffer, uint64_t length) {
   if (socket_ == kInvalidSocket)
     return -1;
 
+#if defined(__linux__)
+  DCHECK(packet_batch_);
+  if (!packet_batch_->HasPendingPackets()) {
+    const int result = packet_batch_->Receive(socket_);
+    if (result <= 0)
+      return result;
+  }
+  return packet_batch_->CopyOut(buffer, length);
+#else
   int64_t result;
   do {
     result = recvfrom(socket_, buffer, length, 0, NULL, 0);
   } while ((result == -1) && (errno == EINTR));
 
   return result;
+#endif
 }
 
 int64_t UdpFile::Write(const void* buffer, uint64_t length) {
@@ -182,6 +317,31 @@ bool UdpFile::Open() {
     return false;
   }
 
+  if (FLAGS_udp_receive_buffer_size > 0) {
+    const int receive_buffer_size = FLAGS_udp_receive_buffer_size;
+    if (setsockopt(new_socket.get(),
+                   SOL_SOCKET,
+                   SO_RCVBUF,
+                   &receive_buffer_size,
+                   sizeof(receive_buffer_size)) < 0) {
+      LOG(WARNING) << "Failed to set socket receive buffer size to "
+                   << receive_buffer_size << " bytes.";
+    }
+  }
+
+#if defined(__linux__)
+  // Ask the kernel to report dropped datagrams with each receive.
+  const int enable_rxq_ovfl = 1;
+  if (setsockopt(new_socket.get(),
+                 SOL_SOCKET,
+                 SO_RXQ_OVFL,
+                 &enable_rxq_ovfl,
+                 sizeof(enable_rxq_ovfl)) < 0) {
+    DLOG(WARNING) << "Failed to enable drop accounting (SO_RXQ_OVFL).";
+  }
+  packet_batch_.reset(new UdpPacketBatch);
+#endif
+
   struct sockaddr_in local_sock_addr;
   bzero(&local_sock_addr, sizeof(local_sock_addr));
   local_sock_addr.sin_family = AF_INET;
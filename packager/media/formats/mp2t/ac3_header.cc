@@ -0,0 +1,230 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp2t/ac3_header.h"
+
+#include "packager/media/base/bit_reader.h"
+#include "packager/media/formats/mp2t/mp2t_common.h"
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+
+namespace {
+
+const uint16_t kAc3SyncWord = 0x0B77;
+
+// Bit stream identification. bsid values up to 8 use the AC-3 syntax; values
+// 11 through 16 use the E-AC-3 syntax (ETSI TS 102 366 sections 4.3 and E.1).
+const uint8_t kAc3MaxBsid = 8;
+const uint8_t kEac3MinBsid = 11;
+const uint8_t kEac3MaxBsid = 16;
+
+const uint32_t kAc3SampleRates[] = {48000, 44100, 32000};
+const uint32_t kEac3ReducedSampleRates[] = {24000, 22050, 16000};
+
+// Number of channels indexed by acmod, LFE channel not included.
+const uint8_t kAc3NumChannelsTable[] = {2, 1, 2, 3, 3, 4, 4, 5};
+
+// An AC-3 sync frame always carries 6 audio blocks of 256 samples.
+const size_t kAc3SamplesPerFrame = 1536;
+const size_t kAudioBlockSize = 256;
+
+// Number of audio blocks per E-AC-3 sync frame, indexed by numblkscod.
+const uint8_t kEac3NumBlocksTable[] = {1, 2, 3, 6};
+
+// Frame size in 16-bit words indexed by frmsizecod, for the sampling
+// frequencies 48 kHz, 44.1 kHz and 32 kHz (ATSC A/52 Table 5.18).
+const uint16_t kAc3FrameSizeWordsTable[][3] = {
+    {64, 69, 96},       {64, 70, 96},       {80, 87, 120},
+    {80, 88, 120},      {96, 104, 144},     {96, 105, 144},
+    {112, 121, 168},    {112, 122, 168},    {128, 139, 192},
+    {128, 140, 192},    {160, 174, 240},    {160, 175, 240},
+    {192, 208, 288},    {192, 209, 288},    {224, 243, 336},
+    {224, 244, 336},    {256, 278, 384},    {256, 279, 384},
+    {320, 348, 480},    {320, 349, 480},    {384, 417, 576},
+    {384, 418, 576},    {448, 487, 672},    {448, 488, 672},
+    {512, 557, 768},    {512, 558, 768},    {640, 696, 960},
+    {640, 697, 960},    {768, 835, 1152},   {768, 836, 1152},
+    {896, 975, 1344},   {896, 976, 1344},   {1024, 1114, 1536},
+    {1024, 1115, 1536}, {1152, 1253, 1728}, {1152, 1254, 1728},
+    {1280, 1393, 1920}, {1280, 1394, 1920},
+};
+
+}  // namespace
+
+Ac3Header::Ac3Header()
+    : valid_config_(false),
+      is_eac3_(false),
+      fscod_(0),
+      frmsizecod_(0),
+      bsid_(0),
+      bsmod_(0),
+      acmod_(0),
+      lfeon_(0),
+      sample_rate_(0),
+      frame_size_(0),
+      num_samples_(0) {}
+
+// static
+size_t Ac3Header::GetFrameSize(const uint8_t* data, size_t num_bytes) {
+  if (num_bytes < kHeaderMinSize)
+    return 0;
+  if (data[0] != (kAc3SyncWord >> 8) || data[1] != (kAc3SyncWord & 0xFF))
+    return 0;
+
+  // bsid occupies the same bit position in both syntaxes.
+  const uint8_t bsid = data[5] >> 3;
+  if (bsid <= kAc3MaxBsid) {
+    const uint8_t fscod = data[4] >> 6;
+    const uint8_t frmsizecod = data[4] & 0x3F;
+    if (fscod >= arraysize(kAc3SampleRates) ||
+        frmsizecod >= arraysize(kAc3FrameSizeWordsTable)) {
+      return 0;
+    }
+    return 2 * kAc3FrameSizeWordsTable[frmsizecod][fscod];
+  }
+  if (bsid >= kEac3MinBsid && bsid <= kEac3MaxBsid) {
+    const uint16_t frmsiz = (data[2] & 0x07) << 8 | data[3];
+    return 2 * (frmsiz + 1);
+  }
+  return 0;
+}
+
+bool Ac3Header::Parse(const uint8_t* frame, size_t frame_size) {
+  CHECK(frame);
+
+  valid_config_ = false;
+
+  BitReader reader(frame, frame_size);
+  uint16_t syncword;
+  RCHECK(reader.ReadBits(16, &syncword));
+  RCHECK(syncword == kAc3SyncWord);
+
+  RCHECK(frame_size >= kHeaderMinSize);
+  bsid_ = frame[5] >> 3;
+  if (bsid_ <= kAc3MaxBsid) {
+    is_eac3_ = false;
+    // crc1.
+    RCHECK(reader.SkipBits(16));
+    RCHECK(reader.ReadBits(2, &fscod_));
+    RCHECK(fscod_ < arraysize(kAc3SampleRates));
+    RCHECK(reader.ReadBits(6, &frmsizecod_));
+    RCHECK(frmsizecod_ < arraysize(kAc3FrameSizeWordsTable));
+    // bsid, already extracted above.
+    RCHECK(reader.SkipBits(5));
+    RCHECK(reader.ReadBits(3, &bsmod_));
+    RCHECK(reader.ReadBits(3, &acmod_));
+    // cmixlev.
+    if ((acmod_ & 0x1) && acmod_ != 0x1)
+      RCHECK(reader.SkipBits(2));
+    // surmixlev.
+    if (acmod_ & 0x4)
+      RCHECK(reader.SkipBits(2));
+    // dsurmod.
+    if (acmod_ == 0x2)
+      RCHECK(reader.SkipBits(2));
+    RCHECK(reader.ReadBits(1, &lfeon_));
+
+    sample_rate_ = kAc3SampleRates[fscod_];
+    frame_size_ = 2 * kAc3FrameSizeWordsTable[frmsizecod_][fscod_];
+    num_samples_ = kAc3SamplesPerFrame;
+  } else if (bsid_ >= kEac3MinBsid && bsid_ <= kEac3MaxBsid) {
+    is_eac3_ = true;
+    uint8_t strmtyp;
+    RCHECK(reader.ReadBits(2, &strmtyp));
+    RCHECK(strmtyp != 0x3);
+    if (strmtyp != 0) {
+      NOTIMPLEMENTED() << "E-AC-3 dependent and additional independent "
+                          "substreams are not supported.";
+      return false;
+    }
+    // substreamid.
+    RCHECK(reader.SkipBits(3));
+    uint16_t frmsiz;
+    RCHECK(reader.ReadBits(11, &frmsiz));
+    frame_size_ = 2 * (frmsiz + 1);
+    RCHECK(reader.ReadBits(2, &fscod_));
+    uint8_t num_blocks;
+    if (fscod_ == 0x3) {
+      uint8_t fscod2;
+      RCHECK(reader.ReadBits(2, &fscod2));
+      RCHECK(fscod2 < arraysize(kEac3ReducedSampleRates));
+      sample_rate_ = kEac3ReducedSampleRates[fscod2];
+      num_blocks = 6;
+    } else {
+      uint8_t numblkscod;
+      RCHECK(reader.ReadBits(2, &numblkscod));
+      sample_rate_ = kAc3SampleRates[fscod_];
+      num_blocks = kEac3NumBlocksTable[numblkscod];
+    }
+    RCHECK(reader.ReadBits(3, &acmod_));
+    RCHECK(reader.ReadBits(1, &lfeon_));
+    // bsid, already extracted above.
+    RCHECK(reader.SkipBits(5));
+
+    bsmod_ = 0;
+    num_samples_ = num_blocks * kAudioBlockSize;
+  } else {
+    DVLOG(1) << "Invalid bit stream identification: "
+             << static_cast<int>(bsid_);
+    return false;
+  }
+
+  valid_config_ = true;
+  return true;
+}
+
+bool Ac3Header::GetDecoderConfig(std::vector<uint8_t>* buffer) const {
+  DCHECK(buffer);
+  if (!valid_config_)
+    return false;
+
+  buffer->clear();
+  if (!is_eac3_) {
+    // AC3SpecificBox (ETSI TS 102 366 F.4): fscod (2), bsid (5), bsmod (3),
+    // acmod (3), lfeon (1), bit_rate_code (5), reserved (5).
+    const uint8_t bit_rate_code = frmsizecod_ >> 1;
+    buffer->push_back(fscod_ << 6 | bsid_ << 1 | bsmod_ >> 2);
+    buffer->push_back((bsmod_ & 0x3) << 6 | acmod_ << 3 | lfeon_ << 2 |
+                      bit_rate_code >> 3);
+    buffer->push_back((bit_rate_code & 0x7) << 5);
+    return true;
+  }
+
+  // EC3SpecificBox (ETSI TS 102 366 F.6) for a single independent substream
+  // with no dependent substreams: data_rate (13), num_ind_sub (3), fscod (2),
+  // bsid (5), reserved (1), asvc (1), bsmod (3), acmod (3), lfeon (1),
+  // reserved (3), num_dep_sub (4), reserved (1).
+  const uint32_t data_rate_kbps = static_cast<uint32_t>(
+      frame_size_ * 8 * sample_rate_ / num_samples_ / 1000);
+  buffer->push_back(data_rate_kbps >> 5);
+  buffer->push_back((data_rate_kbps & 0x1F) << 3);
+  buffer->push_back(fscod_ << 6 | bsid_ << 1);
+  buffer->push_back(bsmod_ << 4 | acmod_ << 1 | lfeon_);
+  buffer->push_back(0);
+  return true;
+}
+
+uint32_t Ac3Header::GetSamplingFrequency() const {
+  DCHECK(valid_config_);
+  return sample_rate_;
+}
+
+uint8_t Ac3Header::GetNumChannels() const {
+  DCHECK(valid_config_);
+  DCHECK_LT(acmod_, arraysize(kAc3NumChannelsTable));
+  return kAc3NumChannelsTable[acmod_] + lfeon_;
+}
+
+size_t Ac3Header::GetNumSamples() const {
+  DCHECK(valid_config_);
+  return num_samples_;
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,84 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_FORMATS_MP2T_AC3_HEADER_H_
+#define MEDIA_FORMATS_MP2T_AC3_HEADER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "packager/base/macros.h"
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+
+/// Class which parses AC-3 and E-AC-3 sync frame headers and synthesizes the
+/// decoder configuration record (the payload of the @b dac3 or @b dec3 box)
+/// from the header contents. The two syntaxes are distinguished by the bsid
+/// field, which occupies the same bit position in both.
+class Ac3Header {
+ public:
+  Ac3Header();
+  ~Ac3Header() {}
+
+  /// Number of bytes of a sync frame needed to determine the frame size.
+  static const size_t kHeaderMinSize = 6;
+
+  /// Get the size of the sync frame from a partial or complete frame.
+  /// @param data is a pointer to the beginning of the sync frame.
+  /// @param num_bytes is the number of data bytes at @a data.
+  /// @return Size of the sync frame (header + payload) if successful, or
+  ///         zero otherwise.
+  static size_t GetFrameSize(const uint8_t* data, size_t num_bytes);
+
+  /// Parse a sync frame header, extracting the fields within.
+  /// @param frame is an input parameter pointing to the sync frame.
+  /// @param frame_size is the size, in bytes, of the input frame.
+  /// @return true if successful, false otherwise.
+  bool Parse(const uint8_t* frame, size_t frame_size);
+
+  /// Synthesize a decoder configuration record from the fields within the
+  /// header; the payload of a @b dac3 box for AC-3 and of a @b dec3 box for
+  /// E-AC-3.
+  /// @param [out] buffer is a pointer to a vector to contain the record.
+  /// @return true if successful, false otherwise.
+  bool GetDecoderConfig(std::vector<uint8_t>* buffer) const;
+
+  /// @return true if the parsed frame uses the E-AC-3 syntax.
+  bool IsEac3() const { return is_eac3_; }
+
+  /// @return The sampling frequency for this frame.
+  uint32_t GetSamplingFrequency() const;
+
+  /// @return Number of channels, LFE channel included, for this frame.
+  uint8_t GetNumChannels() const;
+
+  /// @return Number of audio samples per channel in this frame.
+  size_t GetNumSamples() const;
+
+ private:
+  bool valid_config_;
+  bool is_eac3_;
+  uint8_t fscod_;
+  uint8_t frmsizecod_;  // AC-3 only.
+  uint8_t bsid_;
+  uint8_t bsmod_;
+  uint8_t acmod_;
+  uint8_t lfeon_;
+  uint32_t sample_rate_;
+  size_t frame_size_;
+  size_t num_samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(Ac3Header);
+};
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
+
+#endif  // MEDIA_FORMATS_MP2T_AC3_HEADER_H_
@@ -0,0 +1,111 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "packager/base/macros.h"
+#include "packager/media/formats/mp2t/ac3_header.h"
+
+namespace {
+
+// The first bytes of an AC-3 sync frame: syncword, crc1, fscod = 0 (48 kHz),
+// frmsizecod = 14 (224 words), bsid = 8, bsmod = 0, acmod = 7 (3/2),
+// cmixlev, surmixlev, lfeon = 1.
+const uint8_t kValidAc3Header[] = {0x0B, 0x77, 0x00, 0x00, 0x0E,
+                                   0x40, 0xE1, 0x00, 0x00, 0x00};
+
+// The first bytes of an E-AC-3 sync frame: syncword, strmtyp = 0,
+// substreamid = 0, frmsiz = 383 (768 bytes), fscod = 0 (48 kHz),
+// numblkscod = 3 (6 blocks), acmod = 2 (2/0), lfeon = 0, bsid = 16.
+const uint8_t kValidEac3Header[] = {0x0B, 0x77, 0x01, 0x7F, 0x34,
+                                    0x80, 0x00, 0x00, 0x00, 0x00};
+
+const uint8_t kExpectedAc3DecoderConfig[] = {0x10, 0x3C, 0xE0};
+const uint8_t kExpectedEac3DecoderConfig[] = {0x06, 0x00, 0x20, 0x04, 0x00};
+
+}  // anonymous namespace
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+
+TEST(Ac3HeaderTest, ParseAc3Success) {
+  const uint32_t kExpectedSamplingFrequency(48000);
+  const uint8_t kExpectedNumChannels(6);
+  const size_t kExpectedNumSamples(1536);
+  Ac3Header ac3_header;
+  ASSERT_TRUE(ac3_header.Parse(kValidAc3Header, arraysize(kValidAc3Header)));
+  EXPECT_FALSE(ac3_header.IsEac3());
+  EXPECT_EQ(kExpectedSamplingFrequency, ac3_header.GetSamplingFrequency());
+  EXPECT_EQ(kExpectedNumChannels, ac3_header.GetNumChannels());
+  EXPECT_EQ(kExpectedNumSamples, ac3_header.GetNumSamples());
+  std::vector<uint8_t> decoder_config;
+  ASSERT_TRUE(ac3_header.GetDecoderConfig(&decoder_config));
+  EXPECT_EQ(std::vector<uint8_t>(
+                kExpectedAc3DecoderConfig,
+                kExpectedAc3DecoderConfig + arraysize(kExpectedAc3DecoderConfig)),
+            decoder_config);
+}
+
+TEST(Ac3HeaderTest, ParseEac3Success) {
+  const uint32_t kExpectedSamplingFrequency(48000);
+  const uint8_t kExpectedNumChannels(2);
+  const size_t kExpectedNumSamples(1536);
+  Ac3Header ac3_header;
+  ASSERT_TRUE(ac3_header.Parse(kValidEac3Header, arraysize(kValidEac3Header)));
+  EXPECT_TRUE(ac3_header.IsEac3());
+  EXPECT_EQ(kExpectedSamplingFrequency, ac3_header.GetSamplingFrequency());
+  EXPECT_EQ(kExpectedNumChannels, ac3_header.GetNumChannels());
+  EXPECT_EQ(kExpectedNumSamples, ac3_header.GetNumSamples());
+  std::vector<uint8_t> decoder_config;
+  ASSERT_TRUE(ac3_header.GetDecoderConfig(&decoder_config));
+  EXPECT_EQ(
+      std::vector<uint8_t>(kExpectedEac3DecoderConfig,
+                           kExpectedEac3DecoderConfig +
+                               arraysize(kExpectedEac3DecoderConfig)),
+      decoder_config);
+}
+
+TEST(Ac3HeaderTest, ParseFailBadSyncWord) {
+  uint8_t bad_sync_word[arraysize(kValidAc3Header)];
+  memcpy(bad_sync_word, kValidAc3Header, arraysize(kValidAc3Header));
+  bad_sync_word[1] = 0x78;
+  Ac3Header ac3_header;
+  EXPECT_FALSE(ac3_header.Parse(bad_sync_word, arraysize(bad_sync_word)));
+}
+
+TEST(Ac3HeaderTest, ParseFailBadBsid) {
+  uint8_t bad_bsid[arraysize(kValidAc3Header)];
+  memcpy(bad_bsid, kValidAc3Header, arraysize(kValidAc3Header));
+  // bsid = 9 is neither a valid AC-3 nor a valid E-AC-3 value.
+  bad_bsid[5] = 9 << 3;
+  Ac3Header ac3_header;
+  EXPECT_FALSE(ac3_header.Parse(bad_bsid, arraysize(bad_bsid)));
+}
+
+TEST(Ac3HeaderTest, GetAc3FrameSizeSuccess) {
+  const size_t kExpectedFrameSize(448);
+  EXPECT_EQ(kExpectedFrameSize,
+            Ac3Header::GetFrameSize(kValidAc3Header,
+                                    arraysize(kValidAc3Header)));
+}
+
+TEST(Ac3HeaderTest, GetEac3FrameSizeSuccess) {
+  const size_t kExpectedFrameSize(768);
+  EXPECT_EQ(kExpectedFrameSize,
+            Ac3Header::GetFrameSize(kValidEac3Header,
+                                    arraysize(kValidEac3Header)));
+}
+
+TEST(Ac3HeaderTest, GetFrameSizeFailPartialHeader) {
+  EXPECT_EQ(0u, Ac3Header::GetFrameSize(kValidAc3Header,
+                                        Ac3Header::kHeaderMinSize - 1));
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,268 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp2t/es_parser_ac3.h"
+
+#include <stdint.h>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/media/base/audio_timestamp_helper.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/timestamp.h"
+#include "packager/media/formats/mp2t/ac3_header.h"
+#include "packager/media/formats/mp2t/mp2t_common.h"
+
+namespace shaka {
+namespace media {
+
+// Return true if buf corresponds to an AC-3 syncword.
+// |buf| size must be at least 2.
+static bool isAc3SyncWord(const uint8_t* buf) {
+  return buf[0] == 0x0B && buf[1] == 0x77;
+}
+
+// Look for an AC-3 syncword.
+// |new_pos| returns
+// - either the byte position of the sync frame (if found)
+// - or the byte position of 1st byte that was not processed (if not found).
+// In every case, the returned value in |new_pos| is such that new_pos >= pos
+// |frame_sz| returns the size of the sync frame (if found).
+// Return whether a syncword was found.
+static bool LookForSyncWord(const uint8_t* raw_es,
+                            int raw_es_size,
+                            int pos,
+                            int* new_pos,
+                            int* frame_sz) {
+  DCHECK_GE(pos, 0);
+  DCHECK_LE(pos, raw_es_size);
+
+  int max_offset =
+      raw_es_size - static_cast<int>(mp2t::Ac3Header::kHeaderMinSize);
+  if (pos >= max_offset) {
+    // Do not change the position if:
+    // - max_offset < 0: not enough bytes to get a full header
+    //   Since pos >= 0, this is a subcase of the next condition.
+    // - pos >= max_offset: might be the case after reading one full frame,
+    //   |pos| is then incremented by the frame size and might then point
+    //   to the end of the buffer.
+    *new_pos = pos;
+    return false;
+  }
+
+  for (int offset = pos; offset < max_offset; offset++) {
+    const uint8_t* cur_buf = &raw_es[offset];
+
+    if (!isAc3SyncWord(cur_buf))
+      continue;
+
+    int frame_size = static_cast<int>(mp2t::Ac3Header::GetFrameSize(
+        cur_buf, raw_es_size - offset));
+    if (frame_size == 0) {
+      // Not a valid frame header.
+      continue;
+    }
+
+    // Check whether there is another frame |frame_size| apart from the
+    // current one.
+    int remaining_size = raw_es_size - offset;
+    if (remaining_size >= frame_size + 2 &&
+        !isAc3SyncWord(&cur_buf[frame_size])) {
+      continue;
+    }
+
+    *new_pos = offset;
+    *frame_sz = frame_size;
+    return true;
+  }
+
+  *new_pos = max_offset;
+  return false;
+}
+
+namespace mp2t {
+
+EsParserAc3::EsParserAc3(uint32_t pid,
+                         const NewStreamInfoCB& new_stream_info_cb,
+                         const EmitSampleCB& emit_sample_cb)
+    : EsParser(pid),
+      new_stream_info_cb_(new_stream_info_cb),
+      emit_sample_cb_(emit_sample_cb),
+      samples_per_frame_(0) {
+}
+
+EsParserAc3::~EsParserAc3() {
+}
+
+bool EsParserAc3::Parse(const uint8_t* buf,
+                        int size,
+                        int64_t pts,
+                        int64_t dts) {
+  int raw_es_size;
+  const uint8_t* raw_es;
+
+  // The incoming PTS applies to the access unit that comes just after
+  // the beginning of |buf|.
+  if (pts != kNoTimestamp) {
+    es_byte_queue_.Peek(&raw_es, &raw_es_size);
+    pts_list_.push_back(EsPts(raw_es_size, pts));
+  }
+
+  // Copy the input data to the ES buffer.
+  es_byte_queue_.Push(buf, size);
+  es_byte_queue_.Peek(&raw_es, &raw_es_size);
+
+  // Look for every sync frame in the ES buffer starting at offset = 0
+  int es_position = 0;
+  int frame_size;
+  while (LookForSyncWord(raw_es, raw_es_size, es_position,
+                         &es_position, &frame_size)) {
+    const uint8_t* frame_ptr = raw_es + es_position;
+    DVLOG(LOG_LEVEL_ES)
+        << "AC-3 syncword @ pos=" << es_position
+        << " frame_size=" << frame_size;
+    DVLOG(LOG_LEVEL_ES)
+        << "AC-3 header: "
+        << base::HexEncode(frame_ptr, Ac3Header::kHeaderMinSize);
+
+    // Do not process the frame if this one is a partial frame.
+    int remaining_size = raw_es_size - es_position;
+    if (frame_size > remaining_size)
+      break;
+
+    // Update the audio configuration if needed.
+    if (!UpdateAudioConfiguration(frame_ptr, frame_size))
+      return false;
+
+    // Get the PTS & the duration of this access unit.
+    while (!pts_list_.empty() &&
+           pts_list_.front().first <= es_position) {
+      audio_timestamp_helper_->SetBaseTimestamp(pts_list_.front().second);
+      pts_list_.pop_front();
+    }
+
+    int64_t current_pts = audio_timestamp_helper_->GetTimestamp();
+    // Advance the helper to the next frame up front; the exact frame
+    // duration is then the accumulated-tick delta, which saves redoing the
+    // rational frame-to-tick conversion for every frame.
+    audio_timestamp_helper_->AddFrames(samples_per_frame_);
+    int64_t frame_duration =
+        audio_timestamp_helper_->GetTimestamp() - current_pts;
+
+    // Emit an audio frame. The sync frame header stays part of the sample:
+    // AC-3 samples are complete sync frames in downstream containers.
+    bool is_key_frame = true;
+
+    scoped_refptr<MediaSample> sample =
+        MediaSample::CopyFrom(frame_ptr, frame_size, is_key_frame);
+    sample->set_pts(current_pts);
+    sample->set_dts(current_pts);
+    sample->set_duration(frame_duration);
+    emit_sample_cb_.Run(pid(), sample);
+
+    // Skip the current frame.
+    es_position += frame_size;
+  }
+
+  // Discard all the bytes that have been processed.
+  DiscardEs(es_position);
+
+  return true;
+}
+
+void EsParserAc3::Flush() {
+}
+
+void EsParserAc3::Reset() {
+  es_byte_queue_.Reset();
+  pts_list_.clear();
+  last_audio_decoder_config_ = scoped_refptr<AudioStreamInfo>();
+}
+
+bool EsParserAc3::UpdateAudioConfiguration(const uint8_t* frame,
+                                           size_t frame_size) {
+  const uint8_t kAc3SampleSizeBits(16);
+
+  Ac3Header ac3_header;
+  if (!ac3_header.Parse(frame, frame_size)) {
+    LOG(ERROR) << "Error parsing AC-3 frame header.";
+    return false;
+  }
+  std::vector<uint8_t> decoder_config;
+  if (!ac3_header.GetDecoderConfig(&decoder_config))
+    return false;
+
+  samples_per_frame_ = ac3_header.GetNumSamples();
+
+  if (last_audio_decoder_config_) {
+    // Verify that the audio decoder config has not changed.
+    if (last_audio_decoder_config_->codec_config() == decoder_config) {
+      // Audio configuration has not changed.
+      return true;
+    }
+    NOTIMPLEMENTED() << "Varying audio configurations are not supported.";
+    return false;
+  }
+
+  const AudioCodec codec =
+      ac3_header.IsEac3() ? kCodecEAC3 : kCodecAC3;
+  int samples_per_second = ac3_header.GetSamplingFrequency();
+
+  last_audio_decoder_config_ = scoped_refptr<StreamInfo>(
+      new AudioStreamInfo(
+          pid(),
+          kMpeg2Timescale,
+          kInfiniteDuration,
+          codec,
+          AudioStreamInfo::GetCodecString(codec, 0),
+          std::string(),
+          kAc3SampleSizeBits,
+          ac3_header.GetNumChannels(),
+          samples_per_second,
+          0 /* seek preroll */,
+          0 /* codec delay */,
+          0 /* max bitrate */,
+          0 /* avg bitrate */,
+          decoder_config.data(),
+          decoder_config.size(),
+          false));
+
+  DVLOG(1) << "Sampling frequency: " << samples_per_second;
+  DVLOG(1) << "Number of channels: "
+           << static_cast<int>(ac3_header.GetNumChannels());
+  // Reset the timestamp helper to use a new sampling frequency.
+  if (audio_timestamp_helper_) {
+    int64_t base_timestamp = audio_timestamp_helper_->GetTimestamp();
+    audio_timestamp_helper_.reset(
+        new AudioTimestampHelper(kMpeg2Timescale, samples_per_second));
+    audio_timestamp_helper_->SetBaseTimestamp(base_timestamp);
+  } else {
+    audio_timestamp_helper_.reset(
+        new AudioTimestampHelper(kMpeg2Timescale, samples_per_second));
+  }
+
+  // Audio config notification.
+  new_stream_info_cb_.Run(last_audio_decoder_config_);
+
+  return true;
+}
+
+void EsParserAc3::DiscardEs(int nbytes) {
+  DCHECK_GE(nbytes, 0);
+  if (nbytes <= 0)
+    return;
+
+  // Adjust the ES position of each PTS.
+  for (EsPtsList::iterator it = pts_list_.begin(); it != pts_list_.end(); ++it)
+    it->first -= nbytes;
+
+  // Discard |nbytes| of ES.
+  es_byte_queue_.Pop(nbytes);
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
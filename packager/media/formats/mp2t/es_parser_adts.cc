@@ -5,6 +5,7 @@
 #include "packager/media/formats/mp2t/es_parser_adts.h"
 
 #include <stdint.h>
+#include <string.h>
 
 #include <list>
 
@@ -152,8 +153,12 @@ bool EsParserAdts::Parse(const uint8_t* buf,
     }
 
     int64_t current_pts = audio_timestamp_helper_->GetTimestamp();
+    // Advance the helper to the next frame up front; the exact frame
+    // duration is then the accumulated-tick delta, which saves redoing the
+    // rational frame-to-tick conversion for every frame.
+    audio_timestamp_helper_->AddFrames(kSamplesPerAACFrame);
     int64_t frame_duration =
-        audio_timestamp_helper_->GetFrameDuration(kSamplesPerAACFrame);
+        audio_timestamp_helper_->GetTimestamp() - current_pts;
 
     // Emit an audio frame.
     bool is_key_frame = true;
@@ -168,9 +173,6 @@ bool EsParserAdts::Parse(const uint8_t* buf,
     sample->set_duration(frame_duration);
     emit_sample_cb_.Run(pid(), sample);
 
-    // Update the PTS of the next frame.
-    audio_timestamp_helper_->AddFrames(kSamplesPerAACFrame);
-
     // Skip the current frame.
     es_position += frame_size;
   }
@@ -194,6 +196,17 @@ bool EsParserAdts::UpdateAudioConfiguration(const uint8_t* adts_frame,
                                             size_t adts_frame_size) {
   const uint8_t kAacSampleSizeBits(16);
 
+  // The fixed part of the ADTS header is invariant within a stream, so a
+  // frame whose header matches the last configured frame carries the same
+  // decoder configuration; skip re-parsing the header bit by bit. Only the
+  // frame length and buffer fullness, which live outside the compared bits,
+  // differ from frame to frame.
+  if (last_audio_decoder_config_ &&
+      memcmp(adts_frame, last_adts_fixed_header_, 3) == 0 &&
+      (adts_frame[3] & 0xc0) == last_adts_fixed_header_[3]) {
+    return true;
+  }
+
   AdtsHeader adts_header;
   if (!adts_header.Parse(adts_frame, adts_frame_size)) {
     LOG(ERROR) << "Error parsing ADTS frame header.";
@@ -203,6 +216,9 @@ bool EsParserAdts::UpdateAudioConfiguration(const uint8_t* adts_frame,
   if (!adts_header.GetAudioSpecificConfig(&audio_specific_config))
     return false;
 
+  memcpy(last_adts_fixed_header_, adts_frame, 3);
+  last_adts_fixed_header_[3] = adts_frame[3] & 0xc0;
+
   if (last_audio_decoder_config_) {
     // Verify that the audio decoder config has not changed.
     if (last_audio_decoder_config_->codec_config() == audio_specific_config) {
@@ -69,6 +69,13 @@ class EsParserAdts : public EsParser {
 
   scoped_refptr<StreamInfo> last_audio_decoder_config_;
 
+  // Fixed (frame-invariant) part of the ADTS header of the last configured
+  // frame: bytes 0 to 2 plus the top two bits of byte 3. The remaining
+  // header bits only carry the frame length and buffer fullness, so a frame
+  // whose header matches these bytes has the same decoder configuration.
+  // Only valid when |last_audio_decoder_config_| is set.
+  uint8_t last_adts_fixed_header_[4];
+
   DISALLOW_COPY_AND_ASSIGN(EsParserAdts);
 };
 
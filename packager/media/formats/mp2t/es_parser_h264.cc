@@ -5,9 +5,11 @@
 #include "packager/media/formats/mp2t/es_parser_h264.h"
 
 #include <stdint.h>
+#include <string.h>
 
 #include "packager/base/logging.h"
 #include "packager/media/base/media_sample.h"
+#include "packager/media/base/text_stream_info.h"
 #include "packager/media/base/timestamp.h"
 #include "packager/media/base/video_stream_info.h"
 #include "packager/media/codecs/avc_decoder_configuration_record.h"
@@ -18,6 +20,45 @@
 namespace shaka {
 namespace media {
 namespace mp2t {
+namespace {
+
+// Track id offset for the synthetic caption stream extracted from the video
+// elementary stream. TS PIDs are 13 bits wide, so the resulting track id
+// cannot collide with a real PID.
+const uint32_t kCaptionTrackIdOffset = 0x2000;
+
+// Appends the cc_data constructs of an ATSC A/72 caption payload carried in
+// a user_data_registered_itu_t_t35 SEI message to |cc_data|. Returns false
+// when the payload is not a caption payload.
+bool ExtractCcData(const uint8_t* payload,
+                   int payload_size,
+                   std::vector<uint8_t>* cc_data) {
+  // itu_t_t35_country_code 0xB5 (United States), provider code 0x0031
+  // (ATSC), ATSC user_identifier 'GA94' and user_data_type_code 0x03
+  // (MPEG_cc_data).
+  const uint8_t kAtscCcIdentifier[] = {0xb5, 0x00, 0x31, 'G',
+                                       'A',  '9',  '4',  0x03};
+  const int kIdentifierSize = static_cast<int>(sizeof(kAtscCcIdentifier));
+  // The identifier is followed by a flags byte carrying cc_count, an
+  // em_data byte and then cc_count 3-byte cc constructs.
+  if (payload_size < kIdentifierSize + 2 ||
+      memcmp(payload, kAtscCcIdentifier, kIdentifierSize) != 0) {
+    return false;
+  }
+  const uint8_t flags = payload[kIdentifierSize];
+  const bool process_cc_data_flag = (flags & 0x40) != 0;
+  const int cc_count = flags & 0x1f;
+  if (!process_cc_data_flag || cc_count == 0)
+    return false;
+  const int cc_data_offset = kIdentifierSize + 2;
+  if (payload_size < cc_data_offset + cc_count * 3)
+    return false;
+  cc_data->insert(cc_data->end(), payload + cc_data_offset,
+                  payload + cc_data_offset + cc_count * 3);
+  return true;
+}
+
+}  // namespace
 
 EsParserH264::EsParserH264(uint32_t pid,
                            const NewStreamInfoCB& new_stream_info_cb,
@@ -28,6 +69,7 @@ EsParserH264::EsParserH264(uint32_t pid,
                    pid,
                    emit_sample_cb),
       new_stream_info_cb_(new_stream_info_cb),
+      emit_sample_cb_(emit_sample_cb),
       decoder_config_check_pending_(false),
       h264_parser_(new H264Parser()) {}
 
@@ -38,6 +80,8 @@ void EsParserH264::Reset() {
   h264_parser_.reset(new H264Parser());
   last_video_decoder_config_ = scoped_refptr<StreamInfo>();
   decoder_config_check_pending_ = false;
+  caption_stream_info_ = scoped_refptr<StreamInfo>();
+  pending_caption_payload_.clear();
   EsParserH26x::Reset();
 }
 
@@ -74,7 +118,9 @@ bool EsParserH264::ProcessNalu(const Nalu& nalu,
       *is_key_frame = (nalu.type() == Nalu::H264_IDRSlice);
       DVLOG(LOG_LEVEL_ES) << "Nalu: slice IDR=" << is_key_frame;
       H264SliceHeader shdr;
-      if (h264_parser_->ParseSliceHeader(nalu, &shdr) != H264Parser::kOk) {
+      // Only the PPS id is needed here, so skip the bulk of the header.
+      if (h264_parser_->ParseSliceHeaderUpToPpsId(nalu, &shdr) !=
+          H264Parser::kOk) {
         // Only accept an invalid SPS/PPS at the beginning when the stream
         // does not necessarily start with an SPS/PPS/IDR.
         if (last_video_decoder_config_)
@@ -84,6 +130,26 @@ bool EsParserH264::ProcessNalu(const Nalu& nalu,
       }
       break;
     }
+    case Nalu::H264_SEIMessage: {
+      DVLOG(LOG_LEVEL_ES) << "Nalu: SEI";
+      // Collect CEA-708 caption payloads. SEI messages are not essential to
+      // decoding, so a malformed SEI NALU does not fail the stream.
+      std::vector<H264SEIMessage> sei_msgs;
+      if (h264_parser_->ParseAllSEI(nalu, &sei_msgs) == H264Parser::kOk) {
+        for (size_t i = 0; i < sei_msgs.size(); ++i) {
+          const H264SEIMessage& sei_msg = sei_msgs[i];
+          if (sei_msg.type == H264SEIMessage::kSEIUserDataRegisteredItuTT35 &&
+              sei_msg.user_data_registered.payload_size > 0) {
+            ExtractCcData(sei_msg.user_data_registered.payload,
+                          sei_msg.user_data_registered.payload_size,
+                          &pending_caption_payload_);
+          }
+        }
+      } else {
+        DVLOG(1) << "Error parsing SEI NALU.";
+      }
+      break;
+    }
     default: {
       DVLOG(LOG_LEVEL_ES) << "Nalu: " << nalu.type();
     }
@@ -151,6 +217,16 @@ bool EsParserH264::UpdateVideoDecoderConfig(int pps_id) {
       std::string(), coded_width, coded_height, pixel_width, pixel_height, 0,
       H264ByteToUnitStreamConverter::kUnitStreamNaluLengthSize,
       decoder_config_record.data(), decoder_config_record.size(), false));
+  if (sps->timing_info_present_flag && sps->time_scale > 0) {
+    // A frame spans two ticks with the default pic_struct (H.264 Table E-6),
+    // so seed the nominal sample duration from the declared frame rate; the
+    // muxer can then start with a correct default sample duration instead of
+    // waiting for the first frame delta.
+    static_cast<VideoStreamInfo*>(last_video_decoder_config_.get())
+        ->set_nominal_sample_duration(static_cast<uint32_t>(
+            2ULL * kMpeg2Timescale * sps->num_units_in_tick /
+            sps->time_scale));
+  }
   DVLOG(1) << "Profile IDC: " << sps->profile_idc;
   DVLOG(1) << "Level IDC: " << sps->level_idc;
   DVLOG(1) << "log2_max_frame_num_minus4: " << sps->log2_max_frame_num_minus4;
@@ -161,6 +237,34 @@ bool EsParserH264::UpdateVideoDecoderConfig(int pps_id) {
   return true;
 }
 
+void EsParserH264::OnAccessUnitProcessed(int64_t pts) {
+  if (pending_caption_payload_.empty())
+    return;
+  if (pts == kNoTimestamp) {
+    // The access unit was dropped; its captions cannot be timed and a
+    // stateful caption decoder could not use them anyway.
+    pending_caption_payload_.clear();
+    return;
+  }
+
+  if (!caption_stream_info_) {
+    // Announce the caption stream on the first caption payload. This happens
+    // together with the video config of the first emitted access unit, so
+    // the stream takes part in the init segment like the A/V streams.
+    caption_stream_info_ = scoped_refptr<StreamInfo>(new TextStreamInfo(
+        pid() + kCaptionTrackIdOffset, kMpeg2Timescale, kInfiniteDuration,
+        "cea708", std::string(), std::string(), 0, 0));
+    new_stream_info_cb_.Run(caption_stream_info_);
+  }
+
+  scoped_refptr<MediaSample> caption_sample = MediaSample::CopyFrom(
+      pending_caption_payload_.data(), pending_caption_payload_.size(), true);
+  caption_sample->set_pts(pts);
+  caption_sample->set_dts(pts);
+  emit_sample_cb_.Run(pid() + kCaptionTrackIdOffset, caption_sample);
+  pending_caption_payload_.clear();
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "packager/base/callback.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/formats/mp2t/es_parser_h26x.h"
@@ -44,12 +46,25 @@ class EsParserH264 : public EsParserH26x {
   // Return true if successful.
   bool UpdateVideoDecoderConfig(int sps_id) override;
 
+  // Emits the CEA-708 caption payload collected from the SEI messages of the
+  // access unit, if any, as a sample of a synthetic text stream.
+  void OnAccessUnitProcessed(int64_t pts) override;
+
   // Callback to pass the stream configuration.
   NewStreamInfoCB new_stream_info_cb_;
 
+  // Callback to pass caption samples; the base class owns the video samples.
+  EmitSampleCB emit_sample_cb_;
+
   scoped_refptr<StreamInfo> last_video_decoder_config_;
   bool decoder_config_check_pending_;
 
+  // Set when the first caption SEI message is seen.
+  scoped_refptr<StreamInfo> caption_stream_info_;
+  // CEA-708 cc_data collected from the SEI messages of the current access
+  // unit.
+  std::vector<uint8_t> pending_caption_payload_;
+
   scoped_ptr<H264Parser> h264_parser_;
 };
 
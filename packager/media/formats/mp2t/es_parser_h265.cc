@@ -77,14 +77,22 @@ bool EsParserH265::ProcessNalu(const Nalu& nalu,
         *is_key_frame = nalu.type() == Nalu::H265_IDR_W_RADL ||
                         nalu.type() == Nalu::H265_IDR_N_LP;
         DVLOG(LOG_LEVEL_ES) << "Nalu: slice KeyFrame=" << is_key_frame;
-        H265SliceHeader shdr;
-        if (h265_parser_->ParseSliceHeader(nalu, &shdr) != H265Parser::kOk) {
-          // Only accept an invalid SPS/PPS at the beginning when the stream
-          // does not necessarily start with an SPS/PPS/IDR.
-          if (last_video_decoder_config_)
-            return false;
-        } else {
-          *pps_id_for_access_unit = shdr.pic_parameter_set_id;
+        // The slice header is only parsed for the PPS id, which is only
+        // consumed when a decoder configuration check is pending; the key
+        // frame flag above comes from the NALU header alone. Skip the parse
+        // for the other slices, i.e. until the next in-band SPS/PPS.
+        if (!last_video_decoder_config_ || decoder_config_check_pending_) {
+          H265SliceHeader shdr;
+          // Only the PPS id is needed here, so skip the bulk of the header.
+          if (h265_parser_->ParseSliceHeaderUpToPpsId(nalu, &shdr) !=
+              H265Parser::kOk) {
+            // Only accept an invalid SPS/PPS at the beginning when the stream
+            // does not necessarily start with an SPS/PPS/IDR.
+            if (last_video_decoder_config_)
+              return false;
+          } else {
+            *pps_id_for_access_unit = shdr.pic_parameter_set_id;
+          }
         }
       } else {
         DVLOG(LOG_LEVEL_ES) << "Nalu: " << nalu.type();
@@ -145,45 +145,57 @@ bool EsParserH26x::SearchForNextNalu() {
   int es_size;
   es_queue_->PeekAt(current_search_position_, &es, &es_size);
 
-  // Find a start code.
-  uint64_t start_code_offset;
-  uint8_t start_code_size;
-  const bool start_code_found = NaluReader::FindStartCode(
-      es, es_size, &start_code_offset, &start_code_size);
-
-  if (!start_code_found) {
-    // We didn't find a start code, so we don't have to search this data again.
-    if (es_size > kStartCodeSize)
-      current_search_position_ += es_size - kStartCodeSize;
-    return false;
-  }
+  // Make a single pass over the peeked buffer: when a start code introduces
+  // an invalid NAL unit, continue scanning from the same buffer instead of
+  // peeking at the queue again.
+  uint64_t search_offset = 0;
+  while (true) {
+    // Find a start code.
+    uint64_t start_code_offset;
+    uint8_t start_code_size;
+    const bool start_code_found =
+        NaluReader::FindStartCode(es + search_offset, es_size - search_offset,
+                                  &start_code_offset, &start_code_size);
+
+    if (!start_code_found) {
+      current_search_position_ += search_offset;
+      // We didn't find a start code, so we don't have to search this data
+      // again.
+      if (es_size - search_offset > kStartCodeSize)
+        current_search_position_ += es_size - search_offset - kStartCodeSize;
+      return false;
+    }
+    start_code_offset += search_offset;
+
+    // Ensure the next NAL unit is a real NAL unit.
+    const uint8_t* nalu_ptr = es + start_code_offset + start_code_size;
+    // This size is likely inaccurate, this is just to get the header info.
+    const int64_t next_nalu_size =
+        es_size - start_code_offset - start_code_size;
+    if (next_nalu_size <
+        (type_ == Nalu::kH264 ? kH264NaluHeaderSize : kH265NaluHeaderSize)) {
+      // There was not enough data, wait for more.
+      current_search_position_ += search_offset;
+      return false;
+    }
 
-  // Ensure the next NAL unit is a real NAL unit.
-  const uint8_t* nalu_ptr = es + start_code_offset + start_code_size;
-  // This size is likely inaccurate, this is just to get the header info.
-  const int64_t next_nalu_size = es_size - start_code_offset - start_code_size;
-  if (next_nalu_size <
-      (type_ == Nalu::kH264 ? kH264NaluHeaderSize : kH265NaluHeaderSize)) {
-    // There was not enough data, wait for more.
-    return false;
-  }
+    Nalu next_nalu;
+    if (!next_nalu.Initialize(type_, nalu_ptr, next_nalu_size)) {
+      // The next NAL unit is invalid, skip it and search again.
+      search_offset = start_code_offset + start_code_size;
+      continue;
+    }
 
-  Nalu next_nalu;
-  if (!next_nalu.Initialize(type_, nalu_ptr, next_nalu_size)) {
-    // The next NAL unit is invalid, skip it and search again.
     current_search_position_ += start_code_offset + start_code_size;
-    return SearchForNextNalu();
-  }
-
-  current_search_position_ += start_code_offset + start_code_size;
 
-  NaluInfo info;
-  info.position = current_search_position_ - start_code_size;
-  info.start_code_size = start_code_size;
-  info.nalu = next_nalu;
-  access_unit_nalus_.push_back(info);
+    NaluInfo info;
+    info.position = current_search_position_ - start_code_size;
+    info.start_code_size = start_code_size;
+    info.nalu = next_nalu;
+    access_unit_nalus_.push_back(info);
 
-  return true;
+    return true;
+  }
 }
 
 bool EsParserH26x::ProcessAccessUnit(std::deque<NaluInfo>::iterator end) {
@@ -213,6 +225,8 @@ bool EsParserH26x::ProcessAccessUnit(std::deque<NaluInfo>::iterator end) {
   if (!waiting_for_key_frame_) {
     const uint64_t access_unit_size = end->position - begin->position;
     RCHECK(EmitFrame(begin->position, access_unit_size, is_key_frame, pps_id));
+  } else {
+    OnAccessUnitProcessed(kNoTimestamp);
   }
 
   return true;
@@ -304,8 +318,8 @@ bool EsParserH26x::EmitFrame(int64_t access_unit_pos,
 
   // Create the media sample, emitting always the previous sample after
   // calculating its duration.
-  scoped_refptr<MediaSample> media_sample = MediaSample::CopyFrom(
-      converted_frame.data(), converted_frame.size(), is_key_frame);
+  scoped_refptr<MediaSample> media_sample =
+      MediaSample::TransferData(&converted_frame, is_key_frame);
   media_sample->set_dts(current_timing_desc.dts);
   media_sample->set_pts(current_timing_desc.pts);
   if (pending_sample_) {
@@ -316,6 +330,8 @@ bool EsParserH26x::EmitFrame(int64_t access_unit_pos,
   }
   pending_sample_ = media_sample;
 
+  OnAccessUnitProcessed(current_timing_desc.pts);
+
   return true;
 }
 
@@ -43,6 +43,14 @@ class EsParserH26x : public EsParser {
     return stream_converter_.get();
   }
 
+  // Called after each processed access unit, with the access unit's
+  // presentation timestamp when a video frame was emitted for it, or with
+  // kNoTimestamp when the access unit was dropped (e.g. while waiting for a
+  // key frame). Lets codec specific parsers emit side data collected from
+  // the access unit, such as caption payloads carried in SEI messages, on a
+  // timestamp aligned with the video frame.
+  virtual void OnAccessUnitProcessed(int64_t pts) {}
+
  private:
   struct TimingDesc {
     int64_t dts;
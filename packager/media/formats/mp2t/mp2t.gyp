@@ -13,10 +13,14 @@
       'target_name': 'mp2t',
       'type': '<(component)',
       'sources': [
+        'ac3_header.cc',
+        'ac3_header.h',
         'adts_header.cc',
         'adts_header.h',
         'continuity_counter.cc',
         'continuity_counter.h',
+        'es_parser_ac3.cc',
+        'es_parser_ac3.h',
         'es_parser_adts.cc',
         'es_parser_adts.h',
         'es_parser_h264.cc',
@@ -58,10 +62,24 @@
         '../../codecs/codecs.gyp:codecs',
       ],
     },
+    {
+      'target_name': 'ts_bench',
+      'type': 'executable',
+      'sources': [
+        'mp2t_benchmark.cc',
+      ],
+      'dependencies': [
+        '../../../base/base.gyp:base',
+        '../../file/file.gyp:file',
+        '../../test/media_test.gyp:media_test_support',
+        'mp2t',
+      ],
+    },
     {
       'target_name': 'mp2t_unittest',
       'type': '<(gtest_target_type)',
       'sources': [
+        'ac3_header_unittest.cc',
         'adts_header_unittest.cc',
         'es_parser_h264_unittest.cc',
         'es_parser_h26x_unittest.cc',
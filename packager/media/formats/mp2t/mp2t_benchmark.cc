@@ -0,0 +1,201 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Throughput benchmark for the TS path. Each benchmark runs one stage — TS
+// packet dispatch and demuxing, H.264 elementary stream reassembly or PES to
+// TS packetization — repeatedly and reports MB/s, printing one JSON object
+// per line to stdout so results can be compared across releases:
+//
+//   ts_bench > ts_bench.json
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "packager/base/at_exit.h"
+#include "packager/base/bind.h"
+#include "packager/base/callback.h"
+#include "packager/base/memory/ref_counted.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/base/video_stream_info.h"
+#include "packager/media/file/memory_file.h"
+#include "packager/media/formats/mp2t/es_parser_h264.h"
+#include "packager/media/formats/mp2t/mp2t_media_parser.h"
+#include "packager/media/formats/mp2t/pes_packet.h"
+#include "packager/media/formats/mp2t/ts_writer.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+namespace {
+
+// Each benchmark is repeated until it has run at least this long, so short
+// inputs still produce stable numbers.
+const int64_t kMinBenchTimeMicroseconds = 1000000;
+
+// Synthetic payload used by the packetization benchmark: total bytes per
+// iteration and the size of each PES packet.
+const size_t kMuxBenchTotalSize = 1024 * 1024;
+const size_t kMuxBenchPesPayloadSize = 32 * 1024;
+
+const uint8_t kVideoStreamId = 0xE0;
+
+typedef base::Callback<bool(const std::vector<uint8_t>& data)> BenchFunc;
+
+void IgnoreStreams(const std::vector<scoped_refptr<StreamInfo> >& streams) {}
+
+bool CountSample(size_t* num_samples,
+                 uint32_t track_id,
+                 const scoped_refptr<MediaSample>& sample) {
+  ++*num_samples;
+  return true;
+}
+
+// Demuxes a whole TS file with a fresh parser, counting emitted samples.
+// This covers syncword scanning, packet dispatch, the section parsers and
+// the elementary stream parsers.
+bool BenchTsDemux(const std::vector<uint8_t>& data) {
+  Mp2tMediaParser parser;
+  size_t num_samples = 0;
+  parser.Init(base::Bind(&IgnoreStreams),
+              base::Bind(&CountSample, &num_samples),
+              NULL);
+  if (!parser.Parse(data.data(), data.size()))
+    return false;
+  if (!parser.Flush())
+    return false;
+  return num_samples > 0;
+}
+
+void IgnoreStreamInfo(const scoped_refptr<StreamInfo>& stream_info) {}
+
+void CountEmittedSample(size_t* num_samples,
+                        uint32_t pid,
+                        const scoped_refptr<MediaSample>& sample) {
+  ++*num_samples;
+}
+
+// Reassembles access units from an H.264 Annex B elementary stream, the way
+// the TS demuxer does after PES depacketization.
+bool BenchEsParserH264(const std::vector<uint8_t>& data) {
+  const uint32_t kPid = 0x50;
+  size_t num_samples = 0;
+  EsParserH264 es_parser(kPid,
+                         base::Bind(&IgnoreStreamInfo),
+                         base::Bind(&CountEmittedSample, &num_samples));
+  if (!es_parser.Parse(data.data(), data.size(), 0, 0))
+    return false;
+  es_parser.Flush();
+  return num_samples > 0;
+}
+
+// Packetizes synthetic PES packets into a TS segment in memory. This covers
+// PSI generation and the PES to TS packetizer, without touching the disk.
+bool BenchTsMux(const std::vector<uint8_t>& data) {
+  // Only the codec matters; other values are bogus.
+  scoped_refptr<VideoStreamInfo> stream_info(new VideoStreamInfo(
+      0, 90000, 180000, VideoCodec::kCodecH264, "avc1", "eng", 1280, 720, 1, 1,
+      1, 1, NULL, 0, false));
+
+  TsWriter ts_writer;
+  if (!ts_writer.Initialize(*stream_info))
+    return false;
+
+  const char kFileName[] = "memory://ts_bench.ts";
+  if (!ts_writer.NewSegment(kFileName))
+    return false;
+
+  int64_t timestamp = 0;
+  for (size_t pos = 0; pos < data.size(); pos += kMuxBenchPesPayloadSize) {
+    const size_t payload_size =
+        std::min(kMuxBenchPesPayloadSize, data.size() - pos);
+    scoped_ptr<PesPacket> pes(new PesPacket());
+    pes->set_stream_id(kVideoStreamId);
+    pes->set_pts(timestamp);
+    pes->set_dts(timestamp);
+    timestamp += 3000;
+    pes->mutable_data()->assign(data.begin() + pos,
+                                data.begin() + pos + payload_size);
+    if (!ts_writer.AddPesPacket(pes.Pass()))
+      return false;
+  }
+
+  if (!ts_writer.FinalizeSegment())
+    return false;
+  MemoryFile::Delete(kFileName);
+  return true;
+}
+
+void RunBenchmark(const char* name,
+                  const BenchFunc& func,
+                  const char* input_name,
+                  const std::vector<uint8_t>& data) {
+  if (data.empty()) {
+    fprintf(stderr, "Skipping %s: no input data from %s.\n", name, input_name);
+    return;
+  }
+  // Warm up and make sure the input actually parses before timing it.
+  if (!func.Run(data)) {
+    fprintf(stderr, "Skipping %s: failed to parse %s.\n", name, input_name);
+    return;
+  }
+
+  int iterations = 0;
+  int64_t elapsed_us = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  do {
+    func.Run(data);
+    ++iterations;
+    elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
+  } while (elapsed_us < kMinBenchTimeMicroseconds);
+
+  const double seconds = elapsed_us / 1000000.0;
+  const double megabytes =
+      static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+  printf(
+      "{\"name\": \"%s\", \"input\": \"%s\", \"iterations\": %d, "
+      "\"bytes_per_iteration\": %d, \"elapsed_us\": %lld, "
+      "\"throughput_mb_per_s\": %.2f}\n",
+      name, input_name, iterations, static_cast<int>(data.size()),
+      static_cast<long long>(elapsed_us), megabytes / seconds);
+}
+
+void RunAllBenchmarks() {
+  const char kTsFile[] = "bear-640x360.ts";
+  const char kH264File[] = "bear.h264";
+
+  RunBenchmark("ts_demux", base::Bind(&BenchTsDemux), kTsFile,
+               ReadTestDataFile(kTsFile));
+  RunBenchmark("es_parser_h264", base::Bind(&BenchEsParserH264), kH264File,
+               ReadTestDataFile(kH264File));
+
+  // Deterministic synthetic payload; the content does not matter for the
+  // packetizer.
+  std::vector<uint8_t> synthetic(kMuxBenchTotalSize);
+  uint32_t seed = 0x12345678;
+  for (size_t i = 0; i < synthetic.size(); ++i) {
+    seed = seed * 1664525 + 1013904223;
+    synthetic[i] = seed >> 24;
+  }
+  RunBenchmark("ts_mux", base::Bind(&BenchTsMux), "synthetic-1MiB", synthetic);
+}
+
+}  // namespace
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit;
+  shaka::media::mp2t::RunAllBenchmarks();
+  return 0;
+}
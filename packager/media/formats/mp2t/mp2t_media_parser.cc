@@ -10,6 +10,7 @@
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/media/formats/mp2t/es_parser.h"
+#include "packager/media/formats/mp2t/es_parser_ac3.h"
 #include "packager/media/formats/mp2t/es_parser_adts.h"
 #include "packager/media/formats/mp2t/es_parser_h264.h"
 #include "packager/media/formats/mp2t/es_parser_h265.h"
@@ -24,12 +25,20 @@ namespace shaka {
 namespace media {
 namespace mp2t {
 
+static const uint8_t kTsHeaderSyncword = 0x47;
+
+// The TS packet PID field is 13 bits wide.
+static const int kPidCount = 1 << 13;
+
 enum StreamType {
   // ISO-13818.1 / ITU H.222 Table 2.34 "Stream type assignments"
   kStreamTypeMpeg1Audio = 0x3,
   kStreamTypeAAC = 0xf,
   kStreamTypeAVC = 0x1b,
   kStreamTypeHEVC = 0x24,
+  // ATSC A/52 and user private stream types commonly used for Dolby Digital.
+  kStreamTypeAC3 = 0x81,
+  kStreamTypeEAC3 = 0x87,
 };
 
 class PidState {
@@ -39,6 +48,8 @@ class PidState {
     kPidPmt,
     kPidAudioPes,
     kPidVideoPes,
+    // Synthetic PID for captions extracted from a video elementary stream.
+    kPidCaption,
   };
 
   PidState(int pid, PidType pid_type,
@@ -79,6 +90,21 @@ class PidState {
   SampleQueue sample_queue_;
 };
 
+// Captions are carried inside the video PES and exposed as their own
+// synthetic PID so that their samples use the regular emission path, but no
+// TS packet ever carries that PID; this placeholder satisfies PidState.
+class NullTsSection : public TsSection {
+ public:
+  bool Parse(bool payload_unit_start_indicator,
+             const uint8_t* buf,
+             int size) override {
+    NOTREACHED();
+    return false;
+  }
+  void Flush() override {}
+  void Reset() override {}
+};
+
 PidState::PidState(int pid, PidType pid_type,
                    scoped_ptr<TsSection> section_parser)
     : pid_(pid),
@@ -148,6 +174,7 @@ void PidState::ResetState() {
 
 Mp2tMediaParser::Mp2tMediaParser()
     : sbr_in_mimetype_(false),
+      selected_pids_(kPidCount, false),
       is_initialized_(false) {
 }
 
@@ -180,6 +207,7 @@ bool Mp2tMediaParser::Flush() {
   }
   bool result = EmitRemainingSamples();
   STLDeleteValues(&pids_);
+  selected_pids_.assign(kPidCount, false);
 
   // Remove any bytes left in the TS buffer.
   // (i.e. any partial TS packet => less than 188 bytes).
@@ -209,6 +237,28 @@ bool Mp2tMediaParser::Parse(const uint8_t* buf, int size) {
       continue;
     }
 
+    // Fast path: discard whole runs of packets for PIDs that are neither
+    // the PAT nor a registered PID without parsing their headers and
+    // adaptation fields or allocating TsPackets. Streams commonly carry
+    // PIDs we do not consume (other programs of an MPTS, SDT, null packets)
+    // interleaved with the elementary streams; the run is scanned with a
+    // selected-PID lookup table and dropped with a single Pop().
+    int discarded_bytes = 0;
+    while (ts_buffer_size - discarded_bytes >= TsPacket::kPacketSize) {
+      const uint8_t* packet = &ts_buffer[discarded_bytes];
+      if (packet[0] != kTsHeaderSyncword)
+        break;
+      const int pid = ((packet[1] & 0x1F) << 8) | packet[2];
+      if (pid == TsSection::kPidPat || selected_pids_[pid])
+        break;
+      DVLOG(LOG_LEVEL_TS) << "Ignoring TS packet for pid: " << pid;
+      discarded_bytes += TsPacket::kPacketSize;
+    }
+    if (discarded_bytes > 0) {
+      ts_byte_queue_.Pop(discarded_bytes);
+      continue;
+    }
+
     // Parse the TS header, skipping 1 byte if the header is invalid.
     scoped_ptr<TsPacket> ts_packet(TsPacket::Parse(ts_buffer, ts_buffer_size));
     if (!ts_packet) {
@@ -236,6 +286,7 @@ bool Mp2tMediaParser::Parse(const uint8_t* buf, int size) {
       it = pids_.insert(
           std::pair<int, PidState*>(ts_packet->pid(),
                                     pat_pid_state.release())).first;
+      selected_pids_[ts_packet->pid()] = true;
     }
 
     if (it != pids_.end()) {
@@ -253,6 +304,12 @@ bool Mp2tMediaParser::Parse(const uint8_t* buf, int size) {
   return EmitRemainingSamples();
 }
 
+void Mp2tMediaParser::SetSelectedStreamTypes(
+    const std::set<StreamType>& stream_types) {
+  DCHECK(pids_.empty());
+  selected_stream_types_ = stream_types;
+}
+
 void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
   DVLOG(1) << "RegisterPmt:"
            << " program_number=" << program_number
@@ -279,6 +336,7 @@ void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
       new PidState(pmt_pid, PidState::kPidPmt, pmt_section_parser.Pass()));
   pmt_pid_state->Enable();
   pids_.insert(std::pair<int, PidState*>(pmt_pid, pmt_pid_state.release()));
+  selected_pids_[pmt_pid] = true;
 }
 
 void Mp2tMediaParser::RegisterPes(int pmt_pid,
@@ -291,6 +349,19 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
   if (it != pids_.end())
     return;
 
+  // Honor stream selection: PIDs of unselected stream types never get an ES
+  // parser, so their TS packets are dropped at the PID filter without any
+  // elementary stream parsing.
+  if (!selected_stream_types_.empty()) {
+    const bool is_audio_type = stream_type == kStreamTypeAAC ||
+                               stream_type == kStreamTypeAC3 ||
+                               stream_type == kStreamTypeEAC3;
+    const StreamType selection_type =
+        is_audio_type ? kStreamAudio : kStreamVideo;
+    if (selected_stream_types_.count(selection_type) == 0)
+      return;
+  }
+
   // Create a stream parser corresponding to the stream type.
   bool is_audio = false;
   scoped_ptr<EsParser> es_parser;
@@ -320,6 +391,16 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
                        base::Unretained(this)),
             sbr_in_mimetype_));
     is_audio = true;
+  } else if (stream_type == kStreamTypeAC3 ||
+             stream_type == kStreamTypeEAC3) {
+    es_parser.reset(
+        new EsParserAc3(
+            pes_pid,
+            base::Bind(&Mp2tMediaParser::OnNewStreamInfo,
+                       base::Unretained(this)),
+            base::Bind(&Mp2tMediaParser::OnEmitSample,
+                       base::Unretained(this))));
+    is_audio = true;
   } else {
     return;
   }
@@ -334,6 +415,7 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
       new PidState(pes_pid, pid_type, pes_section_parser.Pass()));
   pes_pid_state->Enable();
   pids_.insert(std::pair<int, PidState*>(pes_pid, pes_pid_state.release()));
+  selected_pids_[pes_pid] = true;
 }
 
 void Mp2tMediaParser::OnNewStreamInfo(
@@ -343,6 +425,27 @@ void Mp2tMediaParser::OnNewStreamInfo(
 
   PidMap::iterator pid_state = pids_.find(new_stream_info->track_id());
   if (pid_state == pids_.end()) {
+    if (new_stream_info->stream_type() == kStreamText) {
+      // Caption streams are announced by the video ES parser when it first
+      // sees a caption SEI message; they have no PID of their own in the TS.
+      scoped_ptr<PidState> caption_pid_state(new PidState(
+          new_stream_info->track_id(), PidState::kPidCaption,
+          scoped_ptr<TsSection>(new NullTsSection())));
+      if (is_initialized_) {
+        // The init callback has already fired without this stream, so the
+        // downstream consumer cannot accept it. Keep the PID state disabled
+        // so the caption samples are dropped.
+        LOG(WARNING) << "Captions detected after initialization; the caption "
+                        "stream is ignored.";
+      } else {
+        caption_pid_state->Enable();
+      }
+      caption_pid_state->set_config(new_stream_info);
+      pids_.insert(std::pair<int, PidState*>(new_stream_info->track_id(),
+                                             caption_pid_state.release()));
+      FinishInitializationIfNeeded();
+      return;
+    }
     LOG(ERROR) << "PID State for new stream not found (pid = "
                << new_stream_info->track_id() << ").";
     return;
@@ -369,7 +472,8 @@ bool Mp2tMediaParser::FinishInitializationIfNeeded() {
   for (PidMap::const_iterator iter = pids_.begin(); iter != pids_.end();
        ++iter) {
     if (((iter->second->pid_type() == PidState::kPidAudioPes) ||
-         (iter->second->pid_type() == PidState::kPidVideoPes))) {
+         (iter->second->pid_type() == PidState::kPidVideoPes) ||
+         (iter->second->pid_type() == PidState::kPidCaption))) {
       ++num_es;
       if (iter->second->config())
         all_stream_info.push_back(iter->second->config());
@@ -407,6 +511,12 @@ void Mp2tMediaParser::OnEmitSample(
                << pes_pid << ").";
     return;
   }
+  // Caption streams detected after initialization stay disabled; drop their
+  // samples since the downstream consumer does not know the stream.
+  if (!pid_state->second->IsEnabled()) {
+    DCHECK_EQ(PidState::kPidCaption, pid_state->second->pid_type());
+    return;
+  }
   pid_state->second->sample_queue().push_back(new_sample);
 }
 
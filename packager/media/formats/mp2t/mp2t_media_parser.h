@@ -7,6 +7,8 @@
 
 #include <deque>
 #include <map>
+#include <set>
+#include <vector>
 
 #include "packager/base/compiler_specific.h"
 #include "packager/base/memory/ref_counted.h"
@@ -40,6 +42,8 @@ class Mp2tMediaParser : public MediaParser {
             KeySource* decryption_key_source) override;
   bool Flush() override WARN_UNUSED_RESULT;
   bool Parse(const uint8_t* buf, int size) override WARN_UNUSED_RESULT;
+  void SetSelectedStreamTypes(
+      const std::set<StreamType>& stream_types) override;
   /// @}
 
  private:
@@ -86,6 +90,15 @@ class Mp2tMediaParser : public MediaParser {
   // List of PIDs and their states.
   PidMap pids_;
 
+  // Per-PID flags mirroring the keys of |pids_|. Used by Parse() to discard
+  // packets of unselected PIDs without a map lookup.
+  std::vector<bool> selected_pids_;
+
+  // Empty means all streams are selected. PIDs of other stream types never
+  // get an ES parser registered, so their TS packets are dropped at the PID
+  // filter.
+  std::set<StreamType> selected_stream_types_;
+
   // Whether |init_cb_| has been invoked.
   bool is_initialized_;
 
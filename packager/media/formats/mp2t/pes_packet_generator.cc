@@ -9,10 +9,16 @@
 #include <algorithm>
 #include <cstring>
 
+#include <gflags/gflags.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
+#include "packager/base/threading/worker_pool.h"
 #include "packager/media/base/aes_encryptor.h"
 #include "packager/media/base/aes_pattern_cryptor.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/cipher_engine.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/video_stream_info.h"
 #include "packager/media/codecs/aac_audio_specific_config.h"
@@ -20,6 +26,14 @@
 #include "packager/media/codecs/nalu_reader.h"
 #include "packager/media/formats/mp2t/pes_packet.h"
 
+DEFINE_int32(ts_encryption_threads,
+             1,
+             "Number of worker threads used to encrypt PES payloads for "
+             "SAMPLE-AES. With more than one thread, finalized payloads are "
+             "encrypted concurrently on the worker pool and delivered in "
+             "order, so TS packetization of one packet overlaps encryption "
+             "of the next.");
+
 namespace shaka {
 namespace media {
 namespace mp2t {
@@ -86,11 +100,23 @@ bool EncryptAacSample(AesCryptor* encryptor,
 }
 }  // namespace
 
+PesPacketGenerator::PendingPesPacket::PendingPesPacket()
+    : adts_converter(NULL), ok(false), done(false, false) {}
+
+PesPacketGenerator::PendingPesPacket::~PendingPesPacket() {}
+
 PesPacketGenerator::PesPacketGenerator()
     : pes_packets_deleter_(&pes_packets_) {}
-PesPacketGenerator::~PesPacketGenerator() {}
+
+PesPacketGenerator::~PesPacketGenerator() {
+  // Worker pool tasks hold pointers into the pending packets; wait for them
+  // before the members are destroyed.
+  DrainCompletedPesPackets(true);
+}
 
 bool PesPacketGenerator::Initialize(const StreamInfo& stream_info) {
+  DrainCompletedPesPackets(true);
+  encryption_error_ = false;
   STLDeleteElements(&pes_packets_);
   stream_type_ = stream_info.stream_type();
 
@@ -124,7 +150,13 @@ bool PesPacketGenerator::Initialize(const StreamInfo& stream_info) {
   return false;
 }
 
-bool PesPacketGenerator::PushSample(scoped_refptr<MediaSample> sample) {
+bool PesPacketGenerator::PushSample(const scoped_refptr<MediaSample>& sample) {
+  if (!timestamp_validator_.AddSample(sample->dts(), sample->duration())) {
+    LOG(ERROR) << "Sample timestamps violate the stream invariants; failing "
+                  "fast (--strict_timestamp_checks).";
+    return false;
+  }
+
   if (!current_processing_pes_)
     current_processing_pes_.reset(new PesPacket());
 
@@ -140,6 +172,11 @@ bool PesPacketGenerator::PushSample(scoped_refptr<MediaSample> sample) {
       return false;
     }
 
+    current_processing_pes_->set_stream_id(kVideoStreamId);
+    if (encryptor_ && FLAGS_ts_encryption_threads > 1) {
+      current_processing_pes_->mutable_data()->swap(byte_stream);
+      return EnqueuePesPacket(current_processing_pes_.Pass());
+    }
     if (encryptor_) {
       if (!EncryptH264Sample(encryptor_.get(), &byte_stream)) {
         LOG(ERROR) << "Failed to encrypt byte stream.";
@@ -147,33 +184,45 @@ bool PesPacketGenerator::PushSample(scoped_refptr<MediaSample> sample) {
       }
     }
     current_processing_pes_->mutable_data()->swap(byte_stream);
-    current_processing_pes_->set_stream_id(kVideoStreamId);
     pes_packets_.push_back(current_processing_pes_.release());
     return true;
   }
   DCHECK_EQ(stream_type_, kStreamAudio);
   DCHECK(adts_converter_);
 
-  std::vector<uint8_t> aac_frame(sample->data(),
-                                 sample->data() + sample->data_size());
+  if (encryptor_ && FLAGS_ts_encryption_threads > 1) {
+    // The payload holds the raw frame; encryption and the ADTS conversion
+    // both run on the worker pool.
+    current_processing_pes_->mutable_data()->assign(
+        sample->data(), sample->data() + sample->data_size());
+    current_processing_pes_->set_stream_id(kAudioStreamId);
+    return EnqueuePesPacket(current_processing_pes_.Pass());
+  }
 
+  std::vector<uint8_t> adts_frame;
   if (encryptor_) {
+    std::vector<uint8_t> aac_frame(sample->data(),
+                                   sample->data() + sample->data_size());
     if (!EncryptAacSample(encryptor_.get(), &aac_frame)) {
       LOG(ERROR) << "Failed to encrypt ADTS AAC.";
       return false;
     }
+    if (!adts_converter_->ConvertToADTS(aac_frame.data(), aac_frame.size(),
+                                        &adts_frame)) {
+      return false;
+    }
+  } else {
+    // The clear path converts straight from the sample buffer so the frame is
+    // copied only once.
+    if (!adts_converter_->ConvertToADTS(sample->data(), sample->data_size(),
+                                        &adts_frame)) {
+      return false;
+    }
   }
 
-  // TODO(rkuroiwa): ConvertToADTS() makes another copy of aac_frame internally.
-  // Optimize copying in this function, possibly by adding a method on
-  // AACAudioSpecificConfig that takes {pointer, length} pair and returns a
-  // vector that has the ADTS header.
-  if (!adts_converter_->ConvertToADTS(&aac_frame))
-    return false;
-
   // TODO(rkuriowa): Put multiple samples in the PES packet to reduce # of PES
   // packets.
-  current_processing_pes_->mutable_data()->swap(aac_frame);
+  current_processing_pes_->mutable_data()->swap(adts_frame);
   current_processing_pes_->set_stream_id(kAudioStreamId);
   pes_packets_.push_back(current_processing_pes_.release());
   return true;
@@ -181,29 +230,108 @@ bool PesPacketGenerator::PushSample(scoped_refptr<MediaSample> sample) {
 
 bool PesPacketGenerator::SetEncryptionKey(
     scoped_ptr<EncryptionKey> encryption_key) {
+  encryption_key_ = encryption_key.Pass();
+  encryptor_ = CreateEncryptor();
+  return encryptor_.get() != NULL;
+}
+
+scoped_ptr<AesCryptor> PesPacketGenerator::CreateEncryptor() {
+  DCHECK(encryption_key_);
+  scoped_ptr<AesCryptor> encryptor;
   if (stream_type_ == kStreamVideo) {
-    scoped_ptr<AesCbcEncryptor> cbc(
-        new AesCbcEncryptor(CbcPaddingScheme::kNoPadding));
+    scoped_ptr<AesCryptor> cbc = CipherEngine::GetInstance()->CreateCbcEncryptor(
+        CbcPaddingScheme::kNoPadding,
+        AesCryptor::ConstantIvFlag::kDontUseConstantIv);
 
     const uint8_t kEncryptedBlocks = 1;
     const uint8_t kClearBlocks = 9;
-    encryptor_.reset(new AesPatternCryptor(
+    encryptor.reset(new AesPatternCryptor(
         kEncryptedBlocks, kClearBlocks,
         AesPatternCryptor::kSkipIfCryptByteBlockRemaining,
         AesCryptor::ConstantIvFlag::kUseConstantIv, cbc.Pass()));
   } else if (stream_type_ == kStreamAudio) {
-    encryptor_.reset(
-        new AesCbcEncryptor(CbcPaddingScheme::kNoPadding,
-                            AesCryptor::ConstantIvFlag::kUseConstantIv));
+    encryptor = CipherEngine::GetInstance()->CreateCbcEncryptor(
+        CbcPaddingScheme::kNoPadding,
+        AesCryptor::ConstantIvFlag::kUseConstantIv);
   } else {
     LOG(ERROR) << "Cannot encrypt stream type: " << stream_type_;
+    return scoped_ptr<AesCryptor>();
+  }
+
+  if (!encryptor->InitializeWithIv(encryption_key_->key, encryption_key_->iv))
+    return scoped_ptr<AesCryptor>();
+  return encryptor.Pass();
+}
+
+bool PesPacketGenerator::EnqueuePesPacket(scoped_ptr<PesPacket> pes) {
+  // SAMPLE-AES uses a constant IV, so each payload's transform is
+  // independent and per-packet encryptors produce the same bytes as the
+  // serial path.
+  scoped_ptr<AesCryptor> encryptor = CreateEncryptor();
+  if (!encryptor) {
+    LOG(ERROR) << "Failed to create the encryptor.";
     return false;
   }
 
-  return encryptor_->InitializeWithIv(encryption_key->key, encryption_key->iv);
+  scoped_ptr<PendingPesPacket> pending(new PendingPesPacket);
+  pending->pes = pes.Pass();
+  pending->encryptor = encryptor.Pass();
+  pending->adts_converter =
+      stream_type_ == kStreamAudio ? adts_converter_.get() : NULL;
+
+  PendingPesPacket* pending_ptr = pending.release();
+  pending_pes_packets_.push_back(pending_ptr);
+  base::WorkerPool::PostTask(
+      FROM_HERE,
+      base::Bind(&PesPacketGenerator::EncryptPesPacketTask, pending_ptr),
+      true /* task_is_slow */);
+
+  // Bound the number of payloads in flight. Waiting on the oldest packet
+  // keeps delivery in order.
+  const size_t kMaxPendingPesPackets =
+      2 * static_cast<size_t>(FLAGS_ts_encryption_threads);
+  if (pending_pes_packets_.size() >= kMaxPendingPesPackets)
+    pending_pes_packets_.front()->done.Wait();
+  DrainCompletedPesPackets(false);
+  return !encryption_error_;
+}
+
+// static
+void PesPacketGenerator::EncryptPesPacketTask(PendingPesPacket* pending) {
+  std::vector<uint8_t>* data = pending->pes->mutable_data();
+  if (pending->adts_converter) {
+    pending->ok = EncryptAacSample(pending->encryptor.get(), data);
+    if (pending->ok) {
+      std::vector<uint8_t> adts_frame;
+      pending->ok = pending->adts_converter->ConvertToADTS(
+          data->data(), data->size(), &adts_frame);
+      if (pending->ok)
+        data->swap(adts_frame);
+    }
+  } else {
+    pending->ok = EncryptH264Sample(pending->encryptor.get(), data);
+  }
+  pending->done.Signal();
+}
+
+void PesPacketGenerator::DrainCompletedPesPackets(bool wait) {
+  while (!pending_pes_packets_.empty()) {
+    PendingPesPacket* pending = pending_pes_packets_.front();
+    if (wait)
+      pending->done.Wait();
+    else if (!pending->done.IsSignaled())
+      break;
+    if (pending->ok)
+      pes_packets_.push_back(pending->pes.release());
+    else
+      encryption_error_ = true;
+    pending_pes_packets_.pop_front();
+    delete pending;
+  }
 }
 
 size_t PesPacketGenerator::NumberOfReadyPesPackets() {
+  DrainCompletedPesPackets(false);
   return pes_packets_.size();
 }
 
@@ -215,7 +343,8 @@ scoped_ptr<PesPacket> PesPacketGenerator::GetNextPesPacket() {
 }
 
 bool PesPacketGenerator::Flush() {
-  return true;
+  DrainCompletedPesPackets(true);
+  return !encryption_error_;
 }
 
 }  // namespace mp2t
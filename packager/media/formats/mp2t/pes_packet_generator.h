@@ -11,10 +11,12 @@
 
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/base/stl_util.h"
+#include "packager/base/synchronization/waitable_event.h"
 #include "packager/media/base/aes_cryptor.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
+#include "packager/media/base/timestamp_validator.h"
 
 namespace shaka {
 namespace media {
@@ -45,7 +47,7 @@ class PesPacketGenerator {
   /// NumberOfReadyPesPackets().
   /// If this returns false, the object may end up in an undefined state.
   /// @return true on success, false otherwise.
-  virtual bool PushSample(scoped_refptr<MediaSample> sample);
+  virtual bool PushSample(const scoped_refptr<MediaSample>& sample);
 
   /// Sets the encryption key for encrypting samples.
   /// @param encryption_key is the key that will be used to encrypt further
@@ -69,6 +71,38 @@ class PesPacketGenerator {
  private:
   friend class PesPacketGeneratorTest;
 
+  // A PES packet whose payload transform (SAMPLE-AES encryption and, for
+  // audio, the trailing ADTS conversion) runs on the worker pool. |done| is
+  // signaled once |ok| and the payload are final.
+  struct PendingPesPacket {
+    PendingPesPacket();
+    ~PendingPesPacket();
+
+    scoped_ptr<PesPacket> pes;
+    scoped_ptr<AesCryptor> encryptor;
+    // NULL for video. For audio the payload holds the raw frame and the ADTS
+    // conversion runs after encryption, like on the serial path.
+    const AACAudioSpecificConfig* adts_converter;
+    bool ok;
+    base::WaitableEvent done;
+  };
+
+  // Transforms |pending|'s payload in place with its own encryptor; runs on
+  // the worker pool.
+  static void EncryptPesPacketTask(PendingPesPacket* pending);
+
+  // Returns an encryptor for the stream type, initialized with the current
+  // encryption key, or NULL on error.
+  scoped_ptr<AesCryptor> CreateEncryptor();
+
+  // Hands the finished clear payload of |pes| to the worker pool.
+  bool EnqueuePesPacket(scoped_ptr<PesPacket> pes);
+
+  // Moves packets whose transform has completed from the front of
+  // |pending_pes_packets_| to |pes_packets_|, preserving order. Waits for
+  // unfinished transforms if |wait| is true.
+  void DrainCompletedPesPackets(bool wait);
+
   StreamType stream_type_;
 
   // Calculated by 90000 / input stream's timescale. This is used to scale the
@@ -82,10 +116,21 @@ class PesPacketGenerator {
   // This can be used to create a PES from multiple audio samples.
   scoped_ptr<PesPacket> current_processing_pes_;
 
+  TimestampValidator timestamp_validator_;
+
   std::list<PesPacket*> pes_packets_;
   STLElementDeleter<decltype(pes_packets_)> pes_packets_deleter_;
 
-  // Current encryption key.
+  // PES packets handed to the worker pool, in order; owned.
+  std::list<PendingPesPacket*> pending_pes_packets_;
+
+  // Set when a worker pool transform fails; surfaced by PushSample() and
+  // Flush().
+  bool encryption_error_ = false;
+
+  // Current encryption key. Kept to initialize per-packet encryptors on the
+  // parallel path.
+  scoped_ptr<EncryptionKey> encryption_key_;
   scoped_ptr<AesCryptor> encryptor_;
 
   DISALLOW_COPY_AND_ASSIGN(PesPacketGenerator);
@@ -4,6 +4,7 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <gflags/gflags.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -16,12 +17,15 @@
 #include "packager/media/formats/mp2t/pes_packet.h"
 #include "packager/media/formats/mp2t/pes_packet_generator.h"
 
+DECLARE_int32(ts_encryption_threads);
+
 namespace shaka {
 namespace media {
 namespace mp2t {
 
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::Invoke;
 using ::testing::SetArgPointee;
 using ::testing::Return;
 
@@ -99,9 +103,21 @@ class MockNalUnitToByteStreamConverter : public NalUnitToByteStreamConverter {
 class MockAACAudioSpecificConfig : public AACAudioSpecificConfig {
  public:
   MOCK_METHOD1(Parse, bool(const std::vector<uint8_t>& data));
-  MOCK_CONST_METHOD1(ConvertToADTS, bool(std::vector<uint8_t>* buffer));
+  MOCK_CONST_METHOD3(ConvertToADTS,
+                     bool(const uint8_t* data,
+                          size_t data_size,
+                          std::vector<uint8_t>* audio_frame));
 };
 
+// An ADTS conversion that copies the input frame without adding a header, so
+// tests can verify the output against the input data.
+bool CopyFrameWithoutAdtsHeader(const uint8_t* data,
+                                size_t data_size,
+                                std::vector<uint8_t>* audio_frame) {
+  audio_frame->assign(data, data + data_size);
+  return true;
+}
+
 scoped_refptr<VideoStreamInfo> CreateVideoStreamInfo(VideoCodec codec) {
   scoped_refptr<VideoStreamInfo> stream_info(new VideoStreamInfo(
       kTrackId, kTimeScale, kDuration, codec, kCodecString, kLanguage,
@@ -169,6 +185,10 @@ class PesPacketGeneratorTest : public ::testing::Test {
     EXPECT_TRUE(generator_.SetEncryptionKey(encryption_key.Pass()));
 
     EXPECT_TRUE(generator_.PushSample(sample));
+    // With parallel encryption the payload may still be in flight; Flush()
+    // waits for it.
+    if (FLAGS_ts_encryption_threads > 1)
+      EXPECT_TRUE(generator_.Flush());
     EXPECT_EQ(1u, generator_.NumberOfReadyPesPackets());
     scoped_ptr<PesPacket> pes_packet = generator_.GetNextPesPacket();
     ASSERT_TRUE(pes_packet);
@@ -193,14 +213,16 @@ class PesPacketGeneratorTest : public ::testing::Test {
     EXPECT_TRUE(generator_.Initialize(*stream_info));
     EXPECT_EQ(0u, generator_.NumberOfReadyPesPackets());
 
-    // For aac, the input from MediaSample is used. Then ADTS header is added,
-    // so EXPECT_CALL does not return the |input| data.
+    // For aac, the input from MediaSample is used. The mock converter copies
+    // the (encrypted) frame without adding an ADTS header, so the expected
+    // output is just the encrypted input.
     scoped_refptr<MediaSample> sample = MediaSample::CopyFrom(
         input, input_size, kIsKeyFrame);
 
     scoped_ptr<MockAACAudioSpecificConfig> mock(
         new MockAACAudioSpecificConfig());
-    EXPECT_CALL(*mock, ConvertToADTS(_)).WillOnce(Return(true));
+    EXPECT_CALL(*mock, ConvertToADTS(_, _, _))
+        .WillOnce(Invoke(CopyFrameWithoutAdtsHeader));
 
     UseMockAACAudioSpecificConfig(mock.Pass());
 
@@ -211,6 +233,10 @@ class PesPacketGeneratorTest : public ::testing::Test {
     EXPECT_TRUE(generator_.SetEncryptionKey(encryption_key.Pass()));
 
     EXPECT_TRUE(generator_.PushSample(sample));
+    // With parallel encryption the payload may still be in flight; Flush()
+    // waits for it.
+    if (FLAGS_ts_encryption_threads > 1)
+      EXPECT_TRUE(generator_.Flush());
     EXPECT_EQ(1u, generator_.NumberOfReadyPesPackets());
     scoped_ptr<PesPacket> pes_packet = generator_.GetNextPesPacket();
     ASSERT_TRUE(pes_packet);
@@ -327,8 +353,8 @@ TEST_F(PesPacketGeneratorTest, AddAudioSample) {
   std::vector<uint8_t> expected_data(kAnyData, kAnyData + arraysize(kAnyData));
 
   scoped_ptr<MockAACAudioSpecificConfig> mock(new MockAACAudioSpecificConfig());
-  EXPECT_CALL(*mock, ConvertToADTS(_))
-      .WillOnce(DoAll(SetArgPointee<0>(expected_data), Return(true)));
+  EXPECT_CALL(*mock, ConvertToADTS(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(expected_data), Return(true)));
 
   UseMockAACAudioSpecificConfig(mock.Pass());
 
@@ -354,7 +380,7 @@ TEST_F(PesPacketGeneratorTest, AddAudioSampleFailedToConvert) {
       MediaSample::CopyFrom(kAnyData, arraysize(kAnyData), kIsKeyFrame);
 
   scoped_ptr<MockAACAudioSpecificConfig> mock(new MockAACAudioSpecificConfig());
-  EXPECT_CALL(*mock, ConvertToADTS(_)).WillOnce(Return(false));
+  EXPECT_CALL(*mock, ConvertToADTS(_, _, _)).WillOnce(Return(false));
 
   UseMockAACAudioSpecificConfig(mock.Pass());
 
@@ -722,6 +748,46 @@ TEST_F(PesPacketGeneratorTest, AacSampleEncryptionLastBytesAreEncrypted) {
                                             arraysize(kExpectedOutputData)));
 }
 
+// Verify that the parallel encryption path produces the same bytes as the
+// serial path.
+TEST_F(PesPacketGeneratorTest, AacSampleEncryptionParallel) {
+  // Same data as the AacSampleEncryption test.
+  const uint8_t kClearData[] = {
+      // First 16 bytes are always clear.
+      0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+      0x13, 0x14, 0x15, 0x16,
+
+      // Next 32 bytes (2 blocks) are encrypted.
+      0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22,
+      0x23, 0x24, 0x25, 0x26,
+      0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32,
+      0x33, 0x34, 0x35, 0x36,
+
+      // The last 2 bytes are in the clear.
+      0x37, 0x38,
+  };
+
+  const uint8_t kExpectedOutputData[] = {
+      // First 16 bytes are always clear.
+      0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+      0x13, 0x14, 0x15, 0x16,
+
+      // Encrypted bytes.
+      0xE3, 0x42, 0x9B, 0x27, 0x33, 0x67, 0x68, 0x08, 0xA5, 0xB3, 0x3E, 0xB1,
+      0xEE, 0xFC, 0x9E, 0x0A, 0x8E, 0x0C, 0x73, 0xC5, 0x57, 0xEE, 0x58, 0xC7,
+      0x48, 0x74, 0x2A, 0x12, 0x38, 0x4F, 0x4E, 0xAC,
+
+      // The last 2 bytes are in the clear.
+      0x37, 0x38,
+  };
+
+  FLAGS_ts_encryption_threads = 2;
+  ASSERT_NO_FATAL_FAILURE(AacEncryptionTest(kClearData, arraysize(kClearData),
+                                            kExpectedOutputData,
+                                            arraysize(kExpectedOutputData)));
+  FLAGS_ts_encryption_threads = 1;
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
@@ -12,12 +12,11 @@
 #include <vector>
 
 #include "packager/base/macros.h"
+#include "packager/media/base/buffer_writer.h"
 
 namespace shaka {
 namespace media {
 
-class BufferWriter;
-
 namespace mp2t {
 
 class ContinuityCounter;
@@ -58,6 +57,11 @@ class H264ProgramMapTableWriter : public ProgramMapTableWriter {
   // Set to true if ClearLeadSegmentPmt() has been called. This determines the
   // version number set in EncryptedSegmentPmt().
   bool has_clear_lead_ = false;
+  // Serialized PMT section for encrypted segments. The section is invariant
+  // for a given version, so it is built once and reused; only the TS
+  // packetization (continuity counter) differs between segments.
+  BufferWriter encrypted_pmt_;
+  int encrypted_pmt_version_ = -1;
 
   DISALLOW_COPY_AND_ASSIGN(H264ProgramMapTableWriter);
 };
@@ -86,6 +90,11 @@ class AacProgramMapTableWriter : public ProgramMapTableWriter {
   // Set to true if ClearLeadSegmentPmt() has been called. This determines the
   // version number set in EncryptedSegmentPmt().
   bool has_clear_lead_ = false;
+  // Serialized PMT section for encrypted segments, including the descriptors
+  // derived from |aac_audio_specific_config_|. Built once per version and
+  // reused; only the TS packetization differs between segments.
+  BufferWriter encrypted_pmt_;
+  int encrypted_pmt_version_ = -1;
 
   DISALLOW_COPY_AND_ASSIGN(AacProgramMapTableWriter);
 };
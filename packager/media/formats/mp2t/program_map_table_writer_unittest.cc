@@ -341,6 +341,30 @@ TEST_F(ProgramMapTableWriterTest, EncryptedSegmentsAacPmt) {
       buffer.Buffer()));
 }
 
+// The PMT section is cached across segments; repeated calls must produce
+// identical packets except for the continuity counter.
+TEST_F(ProgramMapTableWriterTest, EncryptedSegmentsPmtRepeated) {
+  ContinuityCounter counter;
+  H264ProgramMapTableWriter writer(&counter);
+  BufferWriter first_buffer;
+  EXPECT_TRUE(writer.EncryptedSegmentPmt(&first_buffer));
+  BufferWriter second_buffer;
+  EXPECT_TRUE(writer.EncryptedSegmentPmt(&second_buffer));
+
+  ASSERT_EQ(kTsPacketSize, first_buffer.Size());
+  ASSERT_EQ(kTsPacketSize, second_buffer.Size());
+  for (size_t i = 0; i < kTsPacketSize; ++i) {
+    if (i == 3) {
+      // Adaptation field control bits are the same but the continuity counter
+      // is incremented.
+      EXPECT_EQ(first_buffer.Buffer()[i] + 1, second_buffer.Buffer()[i]);
+      continue;
+    }
+    EXPECT_EQ(first_buffer.Buffer()[i], second_buffer.Buffer()[i])
+        << "at index " << i;
+  }
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
@@ -35,7 +35,7 @@ Status TsMuxer::Finalize() {
 }
 
 Status TsMuxer::DoAddSample(const MediaStream* stream,
-                            scoped_refptr<MediaSample> sample) {
+                            const scoped_refptr<MediaSample>& sample) {
   return segmenter_->AddSample(sample);
 }
 
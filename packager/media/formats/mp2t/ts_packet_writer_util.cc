@@ -122,42 +122,82 @@ void WritePayloadToBufferWriter(const uint8_t* payload,
                                 BufferWriter* writer) {
   size_t payload_bytes_written = 0;
 
-  do {
-    const bool must_write_adaptation_header = has_pcr;
-    const size_t bytes_left = payload_size - payload_bytes_written;
-    const bool has_adaptation_field = must_write_adaptation_header ||
-                                      bytes_left < kTsPacketMaximumPayloadSize;
-
-    writer->AppendInt(kSyncByte);
-    writer->AppendInt(static_cast<uint16_t>(
-        // transport_error_indicator and transport_priority are both '0'.
-        static_cast<int>(payload_unit_start_indicator) << 14 | pid));
-
+  // The first packet carries the PES header plus the PCR adaptation field if
+  // there is one; every following packet carries up to a full payload.
+  const size_t first_packet_payload_size =
+      has_pcr ? kTsPacketMaximumPayloadSize - kPcrFieldsSize - 2
+              : kTsPacketMaximumPayloadSize;
+  const size_t remaining_payload_size =
+      payload_size > first_packet_payload_size
+          ? payload_size - first_packet_payload_size
+          : 0;
+  const size_t num_packets =
+      1 + (remaining_payload_size + kTsPacketMaximumPayloadSize - 1) /
+              kTsPacketMaximumPayloadSize;
+  writer->Reserve(writer->Size() + num_packets * kTsPacketSize);
+
+  // The first three header bytes are constant for this payload except that
+  // payload_unit_start_indicator only applies to the first packet, so build
+  // the header once and patch the continuity counter (and the adaptation
+  // field control bits) per packet.
+  uint8_t header[kTsPacketHeaderSize];
+  header[0] = kSyncByte;
+  // transport_error_indicator and transport_priority are both '0'.
+  header[1] = static_cast<uint8_t>(
+      static_cast<int>(payload_unit_start_indicator) << 6 | (pid >> 8));
+  header[2] = static_cast<uint8_t>(pid & 0xFF);
+
+  // First packet. It is the only one that may carry the PCR adaptation field
+  // and the payload_unit_start_indicator, so handle it separately and keep
+  // the per-packet loop below branch free.
+  {
+    const bool has_adaptation_field =
+        has_pcr || payload_size < kTsPacketMaximumPayloadSize;
     const uint8_t adaptation_field_control =
-        ((has_adaptation_field ? 1 : 0) << 1) | ((bytes_left != 0) ? 1 : 0);
+        ((has_adaptation_field ? 1 : 0) << 1) | ((payload_size != 0) ? 1 : 0);
     // transport_scrambling_control is '00'.
-    writer->AppendInt(static_cast<uint8_t>(adaptation_field_control << 4 |
-                                           continuity_counter->GetNext()));
+    header[3] = static_cast<uint8_t>(adaptation_field_control << 4 |
+                                     continuity_counter->GetNext());
+    writer->AppendArray(header, kTsPacketHeaderSize);
 
     if (has_adaptation_field) {
       const size_t before = writer->Size();
-      WriteAdaptationField(has_pcr, pcr_base, bytes_left, writer);
+      WriteAdaptationField(has_pcr, pcr_base, payload_size, writer);
       const size_t bytes_for_adaptation_field = writer->Size() - before;
 
       const int write_bytes =
           kTsPacketMaximumPayloadSize - bytes_for_adaptation_field;
-      writer->AppendArray(payload + payload_bytes_written, write_bytes);
+      writer->AppendArray(payload, write_bytes);
       payload_bytes_written += write_bytes;
     } else {
-      writer->AppendArray(payload + payload_bytes_written,
-                          kTsPacketMaximumPayloadSize);
+      writer->AppendArray(payload, kTsPacketMaximumPayloadSize);
       payload_bytes_written += kTsPacketMaximumPayloadSize;
     }
+    header[1] &= 0xBF;  // Clear payload_unit_start_indicator.
+  }
 
-    // Once written, not needed for this payload.
-    has_pcr = false;
-    payload_unit_start_indicator = false;
-  } while (payload_bytes_written < payload_size);
+  // Middle packets: a full payload, no adaptation field; only the continuity
+  // counter changes between packets. adaptation_field_control is '01'.
+  while (payload_size - payload_bytes_written >= kTsPacketMaximumPayloadSize) {
+    header[3] =
+        static_cast<uint8_t>(1 << 4 | continuity_counter->GetNext());
+    writer->AppendArray(header, kTsPacketHeaderSize);
+    writer->AppendArray(payload + payload_bytes_written,
+                        kTsPacketMaximumPayloadSize);
+    payload_bytes_written += kTsPacketMaximumPayloadSize;
+  }
+
+  // Trailing short packet, padded out with a stuffing adaptation field.
+  // adaptation_field_control is '11'.
+  if (payload_bytes_written < payload_size) {
+    const size_t bytes_left = payload_size - payload_bytes_written;
+    header[3] =
+        static_cast<uint8_t>(3 << 4 | continuity_counter->GetNext());
+    writer->AppendArray(header, kTsPacketHeaderSize);
+    WriteAdaptationField(false, 0, bytes_left, writer);
+    writer->AppendArray(payload + payload_bytes_written, bytes_left);
+    payload_bytes_written += bytes_left;
+  }
 }
 
 }  // namespace mp2t
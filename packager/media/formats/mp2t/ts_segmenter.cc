@@ -6,6 +6,8 @@
 
 #include "packager/media/formats/mp2t/ts_segmenter.h"
 
+#include <gflags/gflags.h>
+
 #include <memory>
 
 #include "packager/media/base/aes_encryptor.h"
@@ -16,6 +18,15 @@
 #include "packager/media/event/muxer_listener.h"
 #include "packager/media/event/progress_listener.h"
 
+DEFINE_double(ts_segment_deadline_factor,
+              0,
+              "If positive, force a MPEG-2 TS segment boundary at the next "
+              "access unit once the current segment reaches segment_duration "
+              "times this factor, even if no key frame has arrived. This "
+              "bounds segment duration when the key frame cadence is "
+              "irregular, at the cost of segments that may not start with a "
+              "key frame. A value greater than 1, e.g. 1.5, is recommended.");
+
 namespace shaka {
 namespace media {
 namespace mp2t {
@@ -27,6 +38,7 @@ const double kTsTimescale = 90000;
 TsSegmenter::TsSegmenter(const MuxerOptions& options, MuxerListener* listener)
     : muxer_options_(options),
       listener_(listener),
+      segment_number_(options.initial_segment_number),
       ts_writer_(new TsWriter()),
       pes_packet_generator_(new PesPacketGenerator()) {}
 TsSegmenter::~TsSegmenter() {}
@@ -79,16 +91,58 @@ Status TsSegmenter::Initialize(const StreamInfo& stream_info,
 }
 
 Status TsSegmenter::Finalize() {
+  if (num_deadline_cuts_ > 0) {
+    LOG(INFO) << num_deadline_cuts_
+              << " segment(s) were cut at the segment deadline without a key "
+                 "frame.";
+  }
   return Flush();
 }
 
 // First checks whether the sample is a key frame. If so and the segment has
 // passed the segment duration, then flush the generator and write all the data
-// to file.
-Status TsSegmenter::AddSample(scoped_refptr<MediaSample> sample) {
-  const bool passed_segment_duration =
-      current_segment_total_sample_duration_ > muxer_options_.segment_duration;
-  if (sample->is_key_frame() && passed_segment_duration) {
+// to file. A segment is also cut, key frame or not, once the segment deadline
+// has passed (see --ts_segment_deadline_factor).
+Status TsSegmenter::AddSample(const scoped_refptr<MediaSample>& sample) {
+  const double segment_duration = muxer_options_.GetEffectiveSegmentDuration();
+  bool passed_segment_threshold =
+      current_segment_total_sample_duration_ > segment_duration;
+  if (muxer_options_.segment_target_size_bytes > 0 &&
+      !passed_segment_threshold &&
+      current_segment_total_sample_duration_ >
+          muxer_options_.segment_min_duration_seconds) {
+    // Byte-budget mode: predict the output size of the current segment from
+    // the sample bytes pushed so far, scaled by the packetization overhead
+    // observed on finalized segments; segment_duration above remains the
+    // upper duration bound.
+    const double ratio = output_to_es_ratio_ > 0 ? output_to_es_ratio_ : 1.0;
+    passed_segment_threshold =
+        current_segment_es_bytes_ * ratio >=
+        muxer_options_.segment_target_size_bytes;
+  }
+  const bool passed_segment_deadline =
+      FLAGS_ts_segment_deadline_factor > 0 &&
+      current_segment_total_sample_duration_ >
+          segment_duration * FLAGS_ts_segment_deadline_factor;
+  // Ad cue points force a segment boundary at the splice point, so ad
+  // periods can be stitched in on segment boundaries without restarting
+  // the pipeline.
+  const std::vector<double>& cue_points =
+      muxer_options_.ad_cue_points_seconds;
+  bool reached_cue_point = false;
+  if (next_cue_point_ < cue_points.size() && sample->is_key_frame() &&
+      sample->pts() * timescale_scale_ / kTsTimescale >=
+          cue_points[next_cue_point_]) {
+    reached_cue_point = true;
+    ++next_cue_point_;
+  }
+  if ((sample->is_key_frame() && passed_segment_threshold) ||
+      passed_segment_deadline || reached_cue_point) {
+    if (passed_segment_deadline && !sample->is_key_frame()) {
+      ++num_deadline_cuts_;
+      LOG(WARNING) << "Cutting segment at a non key frame; no key frame in "
+                   << current_segment_total_sample_duration_ << " seconds.";
+    }
     Status status = Flush();
     if (!status.ok())
       return status;
@@ -105,6 +159,7 @@ Status TsSegmenter::AddSample(scoped_refptr<MediaSample> sample) {
   const double scaled_sample_duration = sample->duration() * timescale_scale_;
   current_segment_total_sample_duration_ +=
       scaled_sample_duration / kTsTimescale;
+  current_segment_es_bytes_ += sample->data_size();
 
   return WritePesPacketsToFile();
 }
@@ -125,9 +180,12 @@ void TsSegmenter::SetTsWriterFileOpenedForTesting(bool value) {
 Status TsSegmenter::OpenNewSegmentIfClosed(uint32_t next_pts) {
   if (ts_writer_file_opened_)
     return Status::OK;
-  const std::string segment_name =
-      GetSegmentName(muxer_options_.segment_template, next_pts,
-                     segment_number_++, muxer_options_.bandwidth);
+  if (!segment_name_template_) {
+    segment_name_template_.reset(
+        new SegmentNameTemplate(muxer_options_.segment_template));
+  }
+  const std::string segment_name = segment_name_template_->GetName(
+      next_pts, segment_number_++, muxer_options_.bandwidth);
   if (!ts_writer_->NewSegment(segment_name))
     return Status(error::MUXER_FAILURE, "Failed to initilize TsPacketWriter.");
   current_segment_start_time_ = next_pts;
@@ -166,17 +224,26 @@ Status TsSegmenter::Flush() {
     if (!ts_writer_->FinalizeSegment()) {
       return Status(error::MUXER_FAILURE, "Failed to finalize TsWriter.");
     }
+    const int64_t file_size = File::GetFileSize(current_segment_path_.c_str());
     if (listener_) {
-      const int64_t file_size =
-          File::GetFileSize(current_segment_path_.c_str());
       listener_->OnNewSegment(
           current_segment_path_, current_segment_start_time_,
           current_segment_total_sample_duration_ * kTsTimescale, file_size);
     }
+    if (muxer_options_.segment_target_size_bytes > 0 && file_size > 0 &&
+        current_segment_es_bytes_ > 0) {
+      // Track the packetization overhead with a running average so the size
+      // predictor converges over the first few segments.
+      const double ratio =
+          static_cast<double>(file_size) / current_segment_es_bytes_;
+      output_to_es_ratio_ =
+          output_to_es_ratio_ > 0 ? (output_to_es_ratio_ + ratio) / 2 : ratio;
+    }
     ts_writer_file_opened_ = false;
     total_duration_in_seconds_ += current_segment_total_sample_duration_;
   }
   current_segment_total_sample_duration_ = 0.0;
+  current_segment_es_bytes_ = 0;
   current_segment_start_time_ = 0;
   current_segment_path_.clear();
   return NotifyEncrypted();
@@ -20,6 +20,7 @@ namespace media {
 
 class KeySource;
 class MuxerListener;
+class SegmentNameTemplate;
 
 namespace mp2t {
 
@@ -51,7 +52,7 @@ class TsSegmenter {
 
   /// @param sample gets added to this object.
   /// @return OK on success.
-  Status AddSample(scoped_refptr<MediaSample> sample);
+  Status AddSample(const scoped_refptr<MediaSample>& sample);
 
   /// Only for testing.
   void InjectTsWriterForTesting(scoped_ptr<TsWriter> writer);
@@ -91,8 +92,24 @@ class TsSegmenter {
   // written to the current segment in WritePesPacketsToFile().
   double current_segment_total_sample_duration_ = 0.0;
 
-  // Used for segment template.
-  uint64_t segment_number_ = 0;
+  // Elementary stream bytes added to the current segment, used for
+  // byte-budget segmentation (MuxerOptions::segment_target_size_bytes).
+  uint64_t current_segment_es_bytes_ = 0;
+
+  // Learned ratio of finalized segment file size to its elementary stream
+  // bytes. Predicts the output size of the current segment from the samples
+  // pushed so far, accounting for TS packetization overhead. Zero until the
+  // first segment has been finalized.
+  double output_to_es_ratio_ = 0.0;
+
+  // Used for segment template. Starts at
+  // MuxerOptions::initial_segment_number so a resumed live channel continues
+  // numbering.
+  uint64_t segment_number_;
+
+  // Precompiled form of |muxer_options_.segment_template|, built on first
+  // use.
+  scoped_ptr<SegmentNameTemplate> segment_name_template_;
 
   scoped_ptr<TsWriter> ts_writer_;
   // Set to true if TsWriter::NewFile() succeeds, set to false after
@@ -114,6 +131,14 @@ class TsSegmenter {
   // current segments duration.
   double total_duration_in_seconds_ = 0.0;
 
+  // Number of segments that were cut at the segment deadline without a key
+  // frame (see --ts_segment_deadline_factor). Reported in Finalize().
+  uint32_t num_deadline_cuts_ = 0;
+
+  // Index of the next ad cue point in MuxerOptions::ad_cue_points_seconds to
+  // cut a segment at.
+  size_t next_cue_point_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(TsSegmenter);
 };
 
@@ -4,6 +4,7 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <gflags/gflags.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -14,6 +15,8 @@
 #include "packager/media/event/mock_muxer_listener.h"
 #include "packager/media/formats/mp2t/ts_segmenter.h"
 
+DECLARE_double(ts_segment_deadline_factor);
+
 namespace shaka {
 namespace media {
 namespace mp2t {
@@ -53,7 +56,7 @@ const uint8_t kAnyData[] = {
 class MockPesPacketGenerator : public PesPacketGenerator {
  public:
   MOCK_METHOD1(Initialize, bool(const StreamInfo& info));
-  MOCK_METHOD1(PushSample, bool(scoped_refptr<MediaSample> sample));
+  MOCK_METHOD1(PushSample, bool(const scoped_refptr<MediaSample>& sample));
   MOCK_METHOD1(SetEncryptionKeyMock, bool(EncryptionKey* encryption_key));
   bool SetEncryptionKey(scoped_ptr<EncryptionKey> encryption_key) override {
     return SetEncryptionKeyMock(encryption_key.get());
@@ -278,6 +281,100 @@ TEST_F(TsSegmenterTest, PassedSegmentDuration) {
   EXPECT_OK(segmenter.AddSample(sample2));
 }
 
+// Verify that with --ts_segment_deadline_factor set, a segment is cut at a non
+// key frame once the deadline has passed.
+TEST_F(TsSegmenterTest, PassedSegmentDeadline) {
+  FLAGS_ts_segment_deadline_factor = 1.5;
+  scoped_refptr<VideoStreamInfo> stream_info(new VideoStreamInfo(
+      kTrackId, kTimeScale, kDuration, kH264VideoCodec, kCodecString, kLanguage,
+      kWidth, kHeight, kPixelWidth, kPixelHeight, kTrickPlayRate,
+      kNaluLengthSize, kExtraData, arraysize(kExtraData), kIsEncrypted));
+  MuxerOptions options;
+  options.segment_duration = 10.0;
+  options.segment_template = "file$Number$.ts";
+
+  TsSegmenter segmenter(options, nullptr);
+
+  const uint32_t kFirstPts = 1000;
+
+  EXPECT_CALL(*mock_ts_writer_, Initialize(_)).WillOnce(Return(true));
+  EXPECT_CALL(*mock_pes_packet_generator_, Initialize(_))
+      .WillOnce(Return(true));
+
+  scoped_refptr<MediaSample> sample1 =
+      MediaSample::CopyFrom(kAnyData, arraysize(kAnyData), kIsKeyFrame);
+  scoped_refptr<MediaSample> sample2 =
+      MediaSample::CopyFrom(kAnyData, arraysize(kAnyData), !kIsKeyFrame);
+
+  // 16 seconds > 15 seconds (segment duration times the deadline factor).
+  // Expect the segment to be finalized even though the next sample is not a
+  // key frame.
+  sample1->set_duration(kTimeScale * 16);
+  sample2->set_duration(kTimeScale * 7);
+
+  Sequence writer_sequence;
+  EXPECT_CALL(*mock_ts_writer_, NewSegment(StrEq("file1.ts")))
+      .InSequence(writer_sequence)
+      .WillOnce(Return(true));
+
+  EXPECT_CALL(*mock_pes_packet_generator_, PushSample(_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+
+  Sequence ready_pes_sequence;
+  // First AddSample().
+  EXPECT_CALL(*mock_pes_packet_generator_, NumberOfReadyPesPackets())
+      .InSequence(ready_pes_sequence)
+      .WillOnce(Return(1u));
+  EXPECT_CALL(*mock_pes_packet_generator_, NumberOfReadyPesPackets())
+      .InSequence(ready_pes_sequence)
+      .WillOnce(Return(0u));
+  // When Flush() is called, inside second AddSample().
+  EXPECT_CALL(*mock_pes_packet_generator_, NumberOfReadyPesPackets())
+      .InSequence(ready_pes_sequence)
+      .WillOnce(Return(0u));
+  // Still inside AddSample() but after Flush().
+  EXPECT_CALL(*mock_pes_packet_generator_, NumberOfReadyPesPackets())
+      .InSequence(ready_pes_sequence)
+      .WillOnce(Return(1u));
+  EXPECT_CALL(*mock_pes_packet_generator_, NumberOfReadyPesPackets())
+      .InSequence(ready_pes_sequence)
+      .WillOnce(Return(0u));
+
+  EXPECT_CALL(*mock_pes_packet_generator_, Flush())
+      .WillOnce(Return(true));
+
+  EXPECT_CALL(*mock_ts_writer_, FinalizeSegment())
+      .InSequence(writer_sequence)
+      .WillOnce(Return(true));
+  EXPECT_CALL(*mock_ts_writer_, NewSegment(StrEq("file2.ts")))
+      .InSequence(writer_sequence)
+      .WillOnce(Return(true));
+
+  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+
+  // The pointers are released inside the segmenter.
+  Sequence pes_packet_sequence;
+  PesPacket* first_pes = new PesPacket();
+  first_pes->set_pts(kFirstPts);
+  EXPECT_CALL(*mock_pes_packet_generator_, GetNextPesPacketMock())
+      .InSequence(pes_packet_sequence)
+      .WillOnce(Return(first_pes));
+  EXPECT_CALL(*mock_pes_packet_generator_, GetNextPesPacketMock())
+      .InSequence(pes_packet_sequence)
+      .WillOnce(Return(new PesPacket()));
+
+  segmenter.InjectTsWriterForTesting(mock_ts_writer_.Pass());
+  segmenter.InjectPesPacketGeneratorForTesting(
+      mock_pes_packet_generator_.Pass());
+  EXPECT_OK(segmenter.Initialize(*stream_info, nullptr, 0, 0));
+  EXPECT_OK(segmenter.AddSample(sample1));
+  EXPECT_OK(segmenter.AddSample(sample2));
+  FLAGS_ts_segment_deadline_factor = 0;
+}
+
 // Finalize right after Initialize(). The writer will not be initialized.
 TEST_F(TsSegmenterTest, InitializeThenFinalize) {
   scoped_refptr<VideoStreamInfo> stream_info(new VideoStreamInfo(
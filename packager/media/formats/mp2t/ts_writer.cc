@@ -87,9 +87,9 @@ void WritePtsOrDts(uint8_t leading_bits,
   writer->AppendInt(fifth_byte);
 }
 
-bool WritePesToFile(const PesPacket& pes,
-                    ContinuityCounter* continuity_counter,
-                    File* file) {
+void WritePesToBuffer(const PesPacket& pes,
+                      ContinuityCounter* continuity_counter,
+                      BufferWriter* writer) {
   // The size of the length field.
   const int kAdaptationFieldLengthSize = 1;
   // The size of the flags field.
@@ -141,20 +141,18 @@ bool WritePesToFile(const PesPacket& pes,
       std::min(static_cast<int>(pes.data().size()), available_payload);
   first_ts_packet_buffer.AppendArray(pes.data().data(), bytes_consumed);
 
-  BufferWriter output_writer;
   WritePayloadToBufferWriter(first_ts_packet_buffer.Buffer(),
                              first_ts_packet_buffer.Size(),
                              kPayloadUnitStartIndicator, pid, kHasPcr, pcr_base,
-                             continuity_counter, &output_writer);
+                             continuity_counter, writer);
 
   const size_t remaining_pes_data_size = pes.data().size() - bytes_consumed;
   if (remaining_pes_data_size > 0) {
     WritePayloadToBufferWriter(pes.data().data() + bytes_consumed,
                                remaining_pes_data_size,
                                !kPayloadUnitStartIndicator, pid, !kHasPcr, 0,
-                               continuity_counter, &output_writer);
+                               continuity_counter, writer);
   }
-  return output_writer.WriteToFile(file).ok();
 }
 
 }  // namespace
@@ -207,23 +205,20 @@ bool TsWriter::NewSegment(const std::string& file_name) {
     return false;
   }
 
-  BufferWriter psi;
-  WritePatToBuffer(kPat, arraysize(kPat), &pat_continuity_counter_, &psi);
+  // PSI and all the segment's PES packets go into |segment_buffer_| and are
+  // written out together when the segment is finalized.
+  WritePatToBuffer(kPat, arraysize(kPat), &pat_continuity_counter_,
+                   &segment_buffer_);
   if (encrypted_) {
-    if (!pmt_writer_->EncryptedSegmentPmt(&psi)) {
+    if (!pmt_writer_->EncryptedSegmentPmt(&segment_buffer_)) {
       return false;
     }
   } else {
-    if (!pmt_writer_->ClearSegmentPmt(&psi)) {
+    if (!pmt_writer_->ClearSegmentPmt(&segment_buffer_)) {
       return false;
     }
   }
 
-  if (!psi.WriteToFile(current_file_.get()).ok()) {
-    LOG(ERROR) << "Failed to write PSI to file.";
-    return false;
-  }
-
   return true;
 }
 
@@ -232,16 +227,19 @@ void TsWriter::SignalEncrypted() {
 }
 
 bool TsWriter::FinalizeSegment() {
+  // WriteToFile() clears |segment_buffer_| but keeps its allocation for the
+  // next segment.
+  if (!segment_buffer_.WriteToFile(current_file_.get()).ok()) {
+    LOG(ERROR) << "Failed to write segment to file.";
+    return false;
+  }
   return current_file_.release()->Close();
 }
 
 bool TsWriter::AddPesPacket(scoped_ptr<PesPacket> pes_packet) {
   DCHECK(current_file_);
-  if (!WritePesToFile(*pes_packet, &elementary_stream_continuity_counter_,
-                      current_file_.get())) {
-    LOG(ERROR) << "Failed to write pes to file.";
-    return false;
-  }
+  WritePesToBuffer(*pes_packet, &elementary_stream_continuity_counter_,
+                   &segment_buffer_);
 
   // No need to keep pes_packet around so not passing it anywhere.
   return true;
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/buffer_writer.h"
 #include "packager/media/base/media_stream.h"
 #include "packager/media/file/file.h"
 #include "packager/media/file/file_closer.h"
@@ -71,6 +72,11 @@ class TsWriter {
 
   scoped_ptr<File, FileCloser> current_file_;
 
+  // The current segment's TS packets, PSI included, accumulate here and are
+  // written out with a single write in FinalizeSegment(). The allocation is
+  // reused across segments.
+  BufferWriter segment_buffer_;
+
   DISALLOW_COPY_AND_ASSIGN(TsWriter);
 };
 
@@ -23,10 +23,15 @@ bool Box::Parse(BoxReader* reader) {
 }
 
 void Box::Write(BufferWriter* writer) {
-  DCHECK(writer);
   // Compute and update box size.
   uint32_t size = ComputeSize();
   DCHECK_EQ(size, box_size_);
+  WriteWithCachedSize(writer);
+}
+
+void Box::WriteWithCachedSize(BufferWriter* writer) {
+  DCHECK(writer);
+  DCHECK_NE(0u, box_size_);
 
   size_t buffer_size_before_write = writer->Size();
   BoxBuffer buffer(writer);
@@ -36,6 +36,13 @@ struct Box {
   /// @param writer points to a BufferWriter object which wraps the buffer for
   ///        writing.
   void Write(BufferWriter* writer);
+  /// Write the box to buffer using the box sizes from the last ComputeSize
+  /// call, skipping the recursive size computation that Write performs. The
+  /// box tree must not have been modified in a size-changing way since that
+  /// call; updating values of fixed-width fields, e.g. offsets, is fine.
+  /// @param writer points to a BufferWriter object which wraps the buffer for
+  ///        writing.
+  void WriteWithCachedSize(BufferWriter* writer);
   /// Write the box header to buffer. This function calls ComputeSize internally
   /// to compute and update box size.
   /// @param writer points to a BufferWriter object which wraps the buffer for
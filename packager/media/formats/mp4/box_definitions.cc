@@ -2241,6 +2241,36 @@ TrackFragmentDecodeTime::~TrackFragmentDecodeTime() {}
 FourCC TrackFragmentDecodeTime::BoxType() const { return FOURCC_tfdt; }
 
 bool TrackFragmentDecodeTime::ReadWriteInternal(BoxBuffer* buffer) {
+  if (!buffer->Reading()) {
+    // 'tfdt' has a fixed layout per version with flags always 0 and is
+    // rewritten for every fragment, so append a precomputed image of the
+    // constant fields and patch in the decode time instead of going through
+    // the generic per-field path.
+    static const uint8_t kBoxImageHeadVersion0[] = {
+        0x00, 0x00, 0x00, 0x10,  // box size
+        't',  'f',  'd',  't',   // box type
+        0x00, 0x00, 0x00, 0x00,  // version (0) and flags (0)
+    };
+    static const uint8_t kBoxImageHeadVersion1[] = {
+        0x00, 0x00, 0x00, 0x14,  // box size
+        't',  'f',  'd',  't',   // box type
+        0x01, 0x00, 0x00, 0x00,  // version (1) and flags (0)
+    };
+    DCHECK_EQ(0u, flags);
+    if (version == 1) {
+      DCHECK_EQ(sizeof(kBoxImageHeadVersion1) + sizeof(uint64_t), box_size());
+      buffer->writer()->AppendArray(kBoxImageHeadVersion1,
+                                    arraysize(kBoxImageHeadVersion1));
+      buffer->writer()->AppendInt(decode_time);
+    } else {
+      DCHECK_EQ(0, version);
+      DCHECK_EQ(sizeof(kBoxImageHeadVersion0) + sizeof(uint32_t), box_size());
+      buffer->writer()->AppendArray(kBoxImageHeadVersion0,
+                                    arraysize(kBoxImageHeadVersion0));
+      buffer->writer()->AppendInt(static_cast<uint32_t>(decode_time));
+    }
+    return true;
+  }
   RCHECK(ReadWriteHeaderInternal(buffer));
   size_t num_bytes = (version == 1) ? sizeof(uint64_t) : sizeof(uint32_t);
   RCHECK(buffer->ReadWriteUInt64NBytes(&decode_time, num_bytes));
@@ -2257,6 +2287,22 @@ MovieFragmentHeader::~MovieFragmentHeader() {}
 FourCC MovieFragmentHeader::BoxType() const { return FOURCC_mfhd; }
 
 bool MovieFragmentHeader::ReadWriteInternal(BoxBuffer* buffer) {
+  if (!buffer->Reading()) {
+    // 'mfhd' has a fixed 16-byte layout with version and flags always 0 and
+    // is rewritten for every fragment, so append a precomputed image of the
+    // constant fields and patch in the sequence number.
+    static const uint8_t kBoxImageHead[] = {
+        0x00, 0x00, 0x00, 0x10,  // box size
+        'm',  'f',  'h',  'd',   // box type
+        0x00, 0x00, 0x00, 0x00,  // version (0) and flags (0)
+    };
+    DCHECK_EQ(0, version);
+    DCHECK_EQ(0u, flags);
+    DCHECK_EQ(sizeof(kBoxImageHead) + sizeof(sequence_number), box_size());
+    buffer->writer()->AppendArray(kBoxImageHead, arraysize(kBoxImageHead));
+    buffer->writer()->AppendInt(sequence_number);
+    return true;
+  }
   return ReadWriteHeaderInternal(buffer) &&
          buffer->ReadWriteUInt32(&sequence_number);
 }
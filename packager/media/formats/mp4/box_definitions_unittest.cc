@@ -6,6 +6,8 @@
 
 #include <gtest/gtest.h>
 
+#include <string.h>
+
 #include <limits>
 
 #include "packager/base/memory/scoped_ptr.h"
@@ -1082,6 +1084,18 @@ TYPED_TEST_P(BoxDefinitionsTestGeneral, WriteReadbackCompare) {
   ASSERT_EQ(box, box_readback);
 }
 
+TYPED_TEST_P(BoxDefinitionsTestGeneral, WriteWithCachedSizeReadbackCompare) {
+  TypeParam box;
+  LOG(INFO) << "Processing " << FourCCToString(box.BoxType());
+  this->Fill(&box);
+  box.ComputeSize();
+  box.WriteWithCachedSize(this->buffer_.get());
+
+  TypeParam box_readback;
+  ASSERT_TRUE(this->ReadBack(&box_readback));
+  ASSERT_EQ(box, box_readback);
+}
+
 TYPED_TEST_P(BoxDefinitionsTestGeneral, WriteModifyWrite) {
   TypeParam box;
   LOG(INFO) << "Processing " << FourCCToString(box.BoxType());
@@ -1116,6 +1130,7 @@ TYPED_TEST_P(BoxDefinitionsTestGeneral, Empty) {
 REGISTER_TYPED_TEST_CASE_P(BoxDefinitionsTestGeneral,
                            WriteHeader,
                            WriteReadbackCompare,
+                           WriteWithCachedSizeReadbackCompare,
                            WriteModifyWrite,
                            Empty);
 
@@ -1256,6 +1271,49 @@ TEST_F(BoxDefinitionsTest, ChunkLargeOffsetSmallOffset) {
   ASSERT_EQ(co64, stco);
 }
 
+// 'mfhd' and 'tfdt' are written through precomputed box images; pin down the
+// exact wire format.
+TEST_F(BoxDefinitionsTest, MovieFragmentHeaderFixedImage) {
+  MovieFragmentHeader mfhd;
+  mfhd.sequence_number = 0x01020304;
+  mfhd.Write(this->buffer_.get());
+
+  const uint8_t kExpected[] = {
+      0x00, 0x00, 0x00, 0x10, 'm',  'f',  'h',  'd',
+      0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+  };
+  ASSERT_EQ(arraysize(kExpected), this->buffer_->Size());
+  EXPECT_EQ(0, memcmp(kExpected, this->buffer_->Buffer(), sizeof(kExpected)));
+}
+
+TEST_F(BoxDefinitionsTest, TrackFragmentDecodeTimeFixedImage) {
+  TrackFragmentDecodeTime tfdt;
+  tfdt.decode_time = 0x01020304;
+  tfdt.Write(this->buffer_.get());
+
+  const uint8_t kExpectedVersion0[] = {
+      0x00, 0x00, 0x00, 0x10, 't',  'f',  'd',  't',
+      0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+  };
+  ASSERT_EQ(arraysize(kExpectedVersion0), this->buffer_->Size());
+  EXPECT_EQ(0, memcmp(kExpectedVersion0, this->buffer_->Buffer(),
+                      sizeof(kExpectedVersion0)));
+
+  // A decode time that does not fit in 32 bits switches the box to version 1.
+  this->buffer_->Clear();
+  tfdt.decode_time = 0x0102030405060708ULL;
+  tfdt.Write(this->buffer_.get());
+
+  const uint8_t kExpectedVersion1[] = {
+      0x00, 0x00, 0x00, 0x14, 't',  'f',  'd',  't',
+      0x01, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+      0x05, 0x06, 0x07, 0x08,
+  };
+  ASSERT_EQ(arraysize(kExpectedVersion1), this->buffer_->Size());
+  EXPECT_EQ(0, memcmp(kExpectedVersion1, this->buffer_->Buffer(),
+                      sizeof(kExpectedVersion1)));
+}
+
 TEST_F(BoxDefinitionsTest, TrackFragmentHeader_NoSampleSize) {
   TrackFragmentHeader tfhd;
   Fill(&tfhd);
@@ -6,6 +6,7 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "packager/base/logging.h"
@@ -25,11 +26,8 @@ BoxReader::BoxReader(const uint8_t* buf, size_t size)
 
 BoxReader::~BoxReader() {
   if (scanned_ && !children_.empty()) {
-    for (ChildMap::iterator itr = children_.begin(); itr != children_.end();
-         ++itr) {
-      DVLOG(1) << "Skipping unknown box: " << FourCCToString(itr->first);
-      delete itr->second;
-    }
+    for (ChildIterator itr = children_.begin(); itr != children_.end(); ++itr)
+      DVLOG(1) << "Skipping unknown box: " << FourCCToString(itr->type);
   }
 }
 
@@ -70,18 +68,24 @@ bool BoxReader::ScanChildren() {
   scanned_ = true;
 
   while (pos() < size()) {
-    scoped_ptr<BoxReader> child(
-        new BoxReader(&data()[pos()], size() - pos()));
+    BoxReader child(&data()[pos()], size() - pos());
     bool err;
-    if (!child->ReadHeader(&err))
+    if (!child.ReadHeader(&err))
       return false;
 
-    FourCC box_type = child->type();
-    size_t box_size = child->size();
-    children_.insert(std::pair<FourCC, BoxReader*>(box_type, child.release()));
-    RCHECK(SkipBytes(box_size));
+    // Parent box sizes are capped at int32 max in ReadHeader(), so child
+    // offsets and sizes always fit in 32 bits.
+    ChildEntry entry;
+    entry.type = child.type();
+    entry.offset = static_cast<uint32_t>(pos());
+    entry.size = static_cast<uint32_t>(child.size());
+    children_.push_back(entry);
+    RCHECK(SkipBytes(entry.size));
   }
 
+  // Sort stably so same-type children keep their order in the file, matching
+  // the multimap behavior this replaces.
+  std::stable_sort(children_.begin(), children_.end(), ChildEntryLess);
   return true;
 }
 
@@ -89,25 +93,43 @@ bool BoxReader::ReadChild(Box* child) {
   DCHECK(scanned_);
   FourCC child_type = child->BoxType();
 
-  ChildMap::iterator itr = children_.find(child_type);
-  RCHECK(itr != children_.end());
+  std::pair<ChildIterator, ChildIterator> range = EqualRange(child_type);
+  RCHECK(range.first != range.second);
   DVLOG(2) << "Found a " << FourCCToString(child_type) << " box.";
-  RCHECK(child->Parse(itr->second));
-  delete itr->second;
-  children_.erase(itr);
+  RCHECK(ParseChild(*range.first, child));
+  children_.erase(range.first);
   return true;
 }
 
 bool BoxReader::ChildExist(Box* child) {
-  return children_.count(child->BoxType()) > 0;
+  std::pair<ChildIterator, ChildIterator> range =
+      EqualRange(child->BoxType());
+  return range.first != range.second;
 }
 
 bool BoxReader::TryReadChild(Box* child) {
-  if (!children_.count(child->BoxType()))
+  if (!ChildExist(child))
     return true;
   return ReadChild(child);
 }
 
+std::pair<BoxReader::ChildIterator, BoxReader::ChildIterator>
+BoxReader::EqualRange(FourCC type) {
+  ChildEntry key;
+  key.type = type;
+  key.offset = 0;
+  key.size = 0;
+  return std::equal_range(children_.begin(), children_.end(), key,
+                          ChildEntryLess);
+}
+
+bool BoxReader::ParseChild(const ChildEntry& entry, Box* child) {
+  BoxReader reader(&data()[entry.offset], entry.size);
+  bool err;
+  RCHECK(reader.ReadHeader(&err));
+  return child->Parse(&reader);
+}
+
 bool BoxReader::ReadHeader(bool* err) {
   uint64_t size = 0;
   *err = false;
@@ -5,7 +5,9 @@
 #ifndef MEDIA_FORMATS_MP4_BOX_READER_H_
 #define MEDIA_FORMATS_MP4_BOX_READER_H_
 
-#include <map>
+#include <algorithm>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 #include "packager/base/compiler_specific.h"
@@ -20,7 +22,12 @@ namespace mp4 {
 
 struct Box;
 
-/// Class for reading MP4 boxes.
+/// Class for reading MP4 boxes. Readers borrow the underlying buffer and
+/// parse in place; no box payload is copied. When parsing from a byte queue,
+/// the queue window therefore has to stay valid until the box (and any child
+/// readers produced by ScanChildren(), which alias the same buffer) has been
+/// fully parsed; parsed data that must outlive the window is copied by the
+/// individual box definitions instead.
 class BoxReader : public BufferReader {
  public:
   ~BoxReader();
@@ -112,11 +119,33 @@ class BoxReader : public BufferReader {
 
   FourCC type_;
 
-  typedef std::multimap<FourCC, BoxReader*> ChildMap;
+  // One scanned child box: its type and the byte range it occupies in this
+  // reader's buffer. ScanChildren() records an entry per child instead of
+  // allocating a BoxReader and a map node for each; a reader is built on the
+  // stack when the child is actually parsed.
+  struct ChildEntry {
+    FourCC type;
+    uint32_t offset;  // Offset of the child box header in data().
+    uint32_t size;    // Total size of the child box in bytes.
+  };
+  typedef std::vector<ChildEntry> ChildVector;
+  typedef ChildVector::iterator ChildIterator;
+
+  // Orders entries by type; scanning order of same-type entries is kept by
+  // sorting stably.
+  static bool ChildEntryLess(const ChildEntry& a, const ChildEntry& b) {
+    return a.type < b.type;
+  }
+
+  // @return the range of entries with type @a type in the sorted children_.
+  std::pair<ChildIterator, ChildIterator> EqualRange(FourCC type);
+
+  // Parse the child described by @a entry into @a child.
+  bool ParseChild(const ChildEntry& entry, Box* child) WARN_UNUSED_RESULT;
 
-  // The set of child box FourCCs and their corresponding buffer readers. Only
-  // valid if scanned_ is true.
-  ChildMap children_;
+  // Scanned children, sorted by type after ScanChildren(). Only valid if
+  // scanned_ is true.
+  ChildVector children_;
   bool scanned_;
 
   DISALLOW_COPY_AND_ASSIGN(BoxReader);
@@ -137,16 +166,14 @@ bool BoxReader::TryReadChildren(std::vector<T>* children) {
   children->resize(1);
   FourCC child_type = (*children)[0].BoxType();
 
-  ChildMap::iterator start_itr = children_.lower_bound(child_type);
-  ChildMap::iterator end_itr = children_.upper_bound(child_type);
-  children->resize(std::distance(start_itr, end_itr));
+  std::pair<ChildIterator, ChildIterator> range = EqualRange(child_type);
+  children->resize(std::distance(range.first, range.second));
   typename std::vector<T>::iterator child_itr = children->begin();
-  for (ChildMap::iterator itr = start_itr; itr != end_itr; ++itr) {
-    RCHECK(child_itr->Parse(itr->second));
-    delete itr->second;
+  for (ChildIterator itr = range.first; itr != range.second; ++itr) {
+    RCHECK(ParseChild(*itr, &*child_itr));
     ++child_itr;
   }
-  children_.erase(start_itr, end_itr);
+  children_.erase(range.first, range.second);
 
   DVLOG(2) << "Found " << children->size() << " " << FourCCToString(child_type)
            << " boxes.";
@@ -8,9 +8,16 @@
 
 #include <limits>
 
+#include <gflags/gflags.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/threading/worker_pool.h"
 #include "packager/media/base/aes_encryptor.h"
 #include "packager/media/base/aes_pattern_cryptor.h"
 #include "packager/media/base/buffer_reader.h"
+#include "packager/media/base/cipher_engine.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/codecs/nalu_reader.h"
@@ -18,6 +25,26 @@
 #include "packager/media/codecs/vp9_parser.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 
+DEFINE_int32(encryption_threads,
+             1,
+             "Number of worker threads used to encrypt samples. With more "
+             "than one thread, samples are parsed on the muxer thread and "
+             "encrypted concurrently on the worker pool, then added to the "
+             "fragment in order. Only applies to protection schemes whose "
+             "per-sample IVs can be derived up front; other streams are "
+             "encrypted serially.");
+DEFINE_bool(encryption_dry_run,
+            false,
+            "Compute and record subsample entries, IVs and the senc/saiz/saio "
+            "metadata exactly as production encryption would, but skip the "
+            "cipher itself, leaving sample payloads in the clear. The output "
+            "is layout-identical to an encrypted run except for payload "
+            "bytes, which makes repeated structural validation much cheaper. "
+            "With 16-byte CTR IVs the recorded IV values may differ from a "
+            "real run since the block counter does not advance; IV sizes and "
+            "all box layouts are unaffected. The output is NOT protected; "
+            "never serve it.");
+
 namespace shaka {
 namespace media {
 namespace mp4 {
@@ -102,9 +129,21 @@ EncryptingFragmenter::EncryptingFragmenter(
   }
 }
 
-EncryptingFragmenter::~EncryptingFragmenter() {}
+EncryptingFragmenter::~EncryptingFragmenter() {
+  // Worker tasks hold raw pointers into |pending_samples_|; wait for them
+  // before deleting, even on an error path.
+  for (size_t i = 0; i < pending_samples_.size(); ++i)
+    pending_samples_[i]->done.Wait();
+  STLDeleteElements(&pending_samples_);
+}
+
+EncryptingFragmenter::PendingEncryptedSample::PendingEncryptedSample()
+    : done(false, false) {}
+
+EncryptingFragmenter::PendingEncryptedSample::~PendingEncryptedSample() {}
 
-Status EncryptingFragmenter::AddSample(scoped_refptr<MediaSample> sample) {
+Status EncryptingFragmenter::AddSample(
+    const scoped_refptr<MediaSample>& sample) {
   DCHECK(sample);
   if (!fragment_initialized()) {
     Status status = InitializeFragment(sample->dts());
@@ -112,6 +151,8 @@ Status EncryptingFragmenter::AddSample(scoped_refptr<MediaSample> sample) {
       return status;
   }
   if (encryptor_) {
+    if (CanEncryptInParallel())
+      return EnqueueEncryptedSample(sample);
     Status status = EncryptSample(sample);
     if (!status.ok())
       return status;
@@ -124,6 +165,9 @@ Status EncryptingFragmenter::InitializeFragment(int64_t first_sample_dts) {
   if (!status.ok())
     return status;
 
+  // Encryption windows never span fragments.
+  DCHECK(pending_samples_.empty());
+
   if (header_parser_ && !header_parser_->Initialize(info_->codec_config()))
     return Status(error::MUXER_FAILURE, "Fail to read SPS and PPS data.");
 
@@ -155,6 +199,9 @@ Status EncryptingFragmenter::InitializeFragment(int64_t first_sample_dts) {
 void EncryptingFragmenter::FinalizeFragment() {
   if (encryptor_) {
     DCHECK_LE(clear_time_, 0);
+    // Parse errors are returned at enqueue time; a failure here means a
+    // cipher error on a worker, which mirrors the CHECK in EncryptBytes.
+    CHECK(FlushEncryptionWindow().ok());
     FinalizeFragmentForEncryption();
   } else {
     DCHECK_GT(clear_time_, 0);
@@ -207,39 +254,48 @@ void EncryptingFragmenter::FinalizeFragmentForEncryption() {
 
 Status EncryptingFragmenter::CreateEncryptor() {
   DCHECK(encryption_key_);
-  scoped_ptr<AesCryptor> encryptor;
+  scoped_ptr<AesCryptor> encryptor = CreateCryptor();
+  if (!encryptor)
+    return Status(error::MUXER_FAILURE, "Unsupported protection scheme.");
+
+  DCHECK(!encryption_key_->iv.empty());
+  const bool initialized =
+      encryptor->InitializeWithIv(encryption_key_->key, encryption_key_->iv);
+  if (!initialized)
+    return Status(error::MUXER_FAILURE, "Failed to create the encryptor.");
+  encryptor_ = encryptor.Pass();
+  return Status::OK;
+}
+
+scoped_ptr<AesCryptor> EncryptingFragmenter::CreateCryptor() {
+  CipherEngine* engine = CipherEngine::GetInstance();
+  scoped_ptr<AesCryptor> cryptor;
   switch (protection_scheme_) {
     case FOURCC_cenc:
-      encryptor.reset(new AesCtrEncryptor);
+      cryptor = engine->CreateCtrEncryptor();
       break;
     case FOURCC_cbc1:
-      encryptor.reset(new AesCbcEncryptor(kNoPadding));
+      cryptor = engine->CreateCbcEncryptor(kNoPadding,
+                                           AesCryptor::kDontUseConstantIv);
       break;
     case FOURCC_cens:
-      encryptor.reset(new AesPatternCryptor(
+      cryptor.reset(new AesPatternCryptor(
           crypt_byte_block(), skip_byte_block(),
           AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
-          AesCryptor::kDontUseConstantIv,
-          scoped_ptr<AesCryptor>(new AesCtrEncryptor())));
+          AesCryptor::kDontUseConstantIv, engine->CreateCtrEncryptor()));
       break;
     case FOURCC_cbcs:
-      encryptor.reset(new AesPatternCryptor(
+      cryptor.reset(new AesPatternCryptor(
           crypt_byte_block(), skip_byte_block(),
           AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
           AesCryptor::kUseConstantIv,
-          scoped_ptr<AesCryptor>(new AesCbcEncryptor(kNoPadding))));
+          engine->CreateCbcEncryptor(kNoPadding,
+                                     AesCryptor::kDontUseConstantIv)));
       break;
     default:
-      return Status(error::MUXER_FAILURE, "Unsupported protection scheme.");
+      break;
   }
-
-  DCHECK(!encryption_key_->iv.empty());
-  const bool initialized =
-      encryptor->InitializeWithIv(encryption_key_->key, encryption_key_->iv);
-  if (!initialized)
-    return Status(error::MUXER_FAILURE, "Failed to create the encryptor.");
-  encryptor_ = encryptor.Pass();
-  return Status::OK;
+  return cryptor.Pass();
 }
 
 void EncryptingFragmenter::EncryptBytes(uint8_t* data, uint32_t size) {
@@ -247,24 +303,48 @@ void EncryptingFragmenter::EncryptBytes(uint8_t* data, uint32_t size) {
   CHECK(encryptor_->Crypt(data, size, data));
 }
 
-Status EncryptingFragmenter::EncryptSample(scoped_refptr<MediaSample> sample) {
+Status EncryptingFragmenter::EncryptSample(
+    const scoped_refptr<MediaSample>& sample) {
   DCHECK(encryptor_);
 
   SampleEncryptionEntry sample_encryption_entry;
   // For 'cbcs' scheme, Constant IVs SHALL be used.
   if (protection_scheme_ != FOURCC_cbcs)
     sample_encryption_entry.initialization_vector = encryptor_->iv();
-  uint8_t* data = sample->writable_data();
+
+  cipher_ranges_.clear();
+  Status status = GenerateSubsampleInfo(sample.get(), &sample_encryption_entry,
+                                        &cipher_ranges_);
+  if (!status.ok())
+    return status;
+
+  if (!FLAGS_encryption_dry_run) {
+    uint8_t* data = sample->writable_data();
+    for (size_t i = 0; i < cipher_ranges_.size(); ++i) {
+      EncryptBytes(data + cipher_ranges_[i].offset,
+                   static_cast<uint32_t>(cipher_ranges_[i].size));
+    }
+  }
+
+  RecordSampleEncryptionEntry(&sample_encryption_entry);
+  encryptor_->UpdateIv();
+  return Status::OK;
+}
+
+Status EncryptingFragmenter::GenerateSubsampleInfo(
+    MediaSample* sample,
+    SampleEncryptionEntry* sample_encryption_entry,
+    std::vector<CipherRange>* cipher_ranges) {
+  const uint8_t* data = sample->data();
   if (IsSubsampleEncryptionRequired()) {
     if (vpx_parser_) {
-      std::vector<VPxFrameInfo> vpx_frames;
       if (!vpx_parser_->Parse(sample->data(), sample->data_size(),
-                              &vpx_frames)) {
+                              &vpx_frames_)) {
         return Status(error::MUXER_FAILURE, "Failed to parse vpx frame.");
       }
 
-      const bool is_superframe = vpx_frames.size() > 1;
-      for (const VPxFrameInfo& frame : vpx_frames) {
+      const bool is_superframe = vpx_frames_.size() > 1;
+      for (const VPxFrameInfo& frame : vpx_frames_) {
         SubsampleEntry subsample;
         subsample.clear_bytes = frame.uncompressed_header_size;
         subsample.cipher_bytes =
@@ -285,20 +365,24 @@ Status EncryptingFragmenter::EncryptSample(scoped_refptr<MediaSample> sample) {
           subsample.cipher_bytes -= misalign_bytes;
         }
 
-        sample_encryption_entry.subsamples.push_back(subsample);
-        if (subsample.cipher_bytes > 0)
-          EncryptBytes(data + subsample.clear_bytes, subsample.cipher_bytes);
+        sample_encryption_entry->subsamples.push_back(subsample);
+        if (subsample.cipher_bytes > 0) {
+          CipherRange range;
+          range.offset = data - sample->data() + subsample.clear_bytes;
+          range.size = subsample.cipher_bytes;
+          cipher_ranges->push_back(range);
+        }
         data += frame.frame_size;
       }
       // Add subsample for the superframe index if exists.
       if (is_superframe) {
         size_t index_size = sample->data() + sample->data_size() - data;
-        DCHECK_LE(index_size, 2 + vpx_frames.size() * 4);
-        DCHECK_GE(index_size, 2 + vpx_frames.size() * 1);
+        DCHECK_LE(index_size, 2 + vpx_frames_.size() * 4);
+        DCHECK_GE(index_size, 2 + vpx_frames_.size() * 1);
         SubsampleEntry subsample;
         subsample.clear_bytes = index_size;
         subsample.cipher_bytes = 0;
-        sample_encryption_entry.subsamples.push_back(subsample);
+        sample_encryption_entry->subsamples.push_back(subsample);
       }
     } else {
       const Nalu::CodecType nalu_type =
@@ -339,11 +423,16 @@ Status EncryptingFragmenter::EncryptSample(scoped_refptr<MediaSample> sample) {
           }
 
           const uint8_t* nalu_data = nalu.data() + current_clear_bytes;
-          EncryptBytes(const_cast<uint8_t*>(nalu_data), cipher_bytes);
+          if (cipher_bytes > 0) {
+            CipherRange range;
+            range.offset = nalu_data - sample->data();
+            range.size = cipher_bytes;
+            cipher_ranges->push_back(range);
+          }
 
           AddSubsamples(
               accumulated_clear_bytes + nalu_length_size_ + current_clear_bytes,
-              cipher_bytes, &sample_encryption_entry.subsamples);
+              cipher_bytes, &sample_encryption_entry->subsamples);
           accumulated_clear_bytes = 0;
         } else {
           // For non-video-slice NAL units, don't encrypt.
@@ -354,26 +443,116 @@ Status EncryptingFragmenter::EncryptSample(scoped_refptr<MediaSample> sample) {
       if (result != NaluReader::kEOStream)
         return Status(error::MUXER_FAILURE, "Failed to parse NAL units.");
       AddSubsamples(accumulated_clear_bytes, 0,
-                    &sample_encryption_entry.subsamples);
+                    &sample_encryption_entry->subsamples);
     }
-    DCHECK_EQ(sample_encryption_entry.GetTotalSizeOfSubsamples(),
+    DCHECK_EQ(sample_encryption_entry->GetTotalSizeOfSubsamples(),
               sample->data_size());
-
-    // The length of per-sample auxiliary datum, defined in CENC ch. 7.
-    traf()->auxiliary_size.sample_info_sizes.push_back(
-        sample_encryption_entry.ComputeSize());
   } else {
     DCHECK_LE(crypt_byte_block(), 1u);
     DCHECK_EQ(skip_byte_block(), 0u);
-    EncryptBytes(data, sample->data_size());
+    CipherRange range;
+    range.offset = 0;
+    range.size = sample->data_size();
+    cipher_ranges->push_back(range);
   }
+  return Status::OK;
+}
+
+void EncryptingFragmenter::RecordSampleEncryptionEntry(
+    SampleEncryptionEntry* sample_encryption_entry) {
+  if (IsSubsampleEncryptionRequired()) {
+    // The length of per-sample auxiliary datum, defined in CENC ch. 7.
+    traf()->auxiliary_size.sample_info_sizes.push_back(
+        sample_encryption_entry->ComputeSize());
+  }
+  // Swap the IV and subsample vectors into the track fragment instead of
+  // copying them; the caller's entry is done at this point.
+  std::vector<SampleEncryptionEntry>& entries =
+      traf()->sample_encryption.sample_encryption_entries;
+  entries.resize(entries.size() + 1);
+  entries.back().initialization_vector.swap(
+      sample_encryption_entry->initialization_vector);
+  entries.back().subsamples.swap(sample_encryption_entry->subsamples);
+}
+
+bool EncryptingFragmenter::CanEncryptInParallel() const {
+  // A dry run does no cipher work, so there is nothing to parallelize.
+  if (FLAGS_encryption_threads <= 1 || FLAGS_encryption_dry_run)
+    return false;
+  // Per-sample IVs must be known before a sample is parsed: with a constant
+  // IV all samples share one IV and an 8-byte IV is incremented by one per
+  // sample. A 16-byte IV advances by the number of blocks encrypted in the
+  // previous sample, so those streams stay on the serial path.
+  return encryptor_->use_constant_iv() || encryptor_->iv().size() == 8;
+}
+
+Status EncryptingFragmenter::EnqueueEncryptedSample(
+    const scoped_refptr<MediaSample>& sample) {
+  scoped_ptr<AesCryptor> cryptor = CreateCryptor();
+  // CreateEncryptor has already succeeded for the same protection scheme.
+  DCHECK(cryptor);
+  if (!cryptor->InitializeWithIv(encryption_key_->key, encryptor_->iv()))
+    return Status(error::MUXER_FAILURE, "Failed to create the encryptor.");
 
-  traf()->sample_encryption.sample_encryption_entries.push_back(
-      sample_encryption_entry);
+  scoped_ptr<PendingEncryptedSample> pending(new PendingEncryptedSample);
+  pending->sample = sample;
+  pending->encryptor = cryptor.Pass();
+  // For 'cbcs' scheme, Constant IVs SHALL be used.
+  if (protection_scheme_ != FOURCC_cbcs)
+    pending->entry.initialization_vector = encryptor_->iv();
+
+  Status status =
+      GenerateSubsampleInfo(sample.get(), &pending->entry,
+                            &pending->cipher_ranges);
+  if (!status.ok())
+    return status;
   encryptor_->UpdateIv();
+
+  PendingEncryptedSample* pending_ptr = pending.release();
+  pending_samples_.push_back(pending_ptr);
+  base::WorkerPool::PostTask(
+      FROM_HERE,
+      base::Bind(&EncryptingFragmenter::EncryptSampleTask, pending_ptr),
+      true /* task_is_slow */);
+
+  const size_t kWindowSize = 2 * static_cast<size_t>(FLAGS_encryption_threads);
+  if (pending_samples_.size() >= kWindowSize)
+    return FlushEncryptionWindow();
   return Status::OK;
 }
 
+Status EncryptingFragmenter::FlushEncryptionWindow() {
+  Status status;
+  for (size_t i = 0; i < pending_samples_.size(); ++i) {
+    PendingEncryptedSample* pending = pending_samples_[i];
+    // Wait even after an earlier error so no task is left holding a pointer
+    // into a deleted entry.
+    pending->done.Wait();
+    status.Update(pending->status);
+    if (status.ok()) {
+      RecordSampleEncryptionEntry(&pending->entry);
+      status.Update(Fragmenter::AddSample(pending->sample));
+    }
+  }
+  STLDeleteElements(&pending_samples_);
+  return status;
+}
+
+// static
+void EncryptingFragmenter::EncryptSampleTask(PendingEncryptedSample* pending) {
+  uint8_t* data = pending->sample->writable_data();
+  for (size_t i = 0; i < pending->cipher_ranges.size(); ++i) {
+    const CipherRange& range = pending->cipher_ranges[i];
+    if (!pending->encryptor->Crypt(data + range.offset,
+                                   static_cast<size_t>(range.size),
+                                   data + range.offset)) {
+      pending->status = Status(error::MUXER_FAILURE, "Failed to encrypt.");
+      break;
+    }
+  }
+  pending->done.Signal();
+}
+
 bool EncryptingFragmenter::IsSubsampleEncryptionRequired() {
   return vpx_parser_ || nalu_length_size_ != 0;
 }
@@ -7,12 +7,16 @@
 #ifndef MEDIA_FORMATS_MP4_ENCRYPTING_FRAGMENTER_H_
 #define MEDIA_FORMATS_MP4_ENCRYPTING_FRAGMENTER_H_
 
+#include <vector>
+
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/waitable_event.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/codecs/video_slice_header_parser.h"
 #include "packager/media/codecs/vpx_parser.h"
 #include "packager/media/event/muxer_listener.h"
+#include "packager/media/formats/mp4/box_definitions.h"
 #include "packager/media/formats/mp4/fragmenter.h"
 
 namespace shaka {
@@ -51,7 +55,7 @@ class EncryptingFragmenter : public Fragmenter {
 
   /// @name Fragmenter implementation overrides.
   /// @{
-  Status AddSample(scoped_refptr<MediaSample> sample) override;
+  Status AddSample(const scoped_refptr<MediaSample>& sample) override;
   Status InitializeFragment(int64_t first_sample_dts) override;
   void FinalizeFragment() override;
   /// @}
@@ -79,8 +83,55 @@ class EncryptingFragmenter : public Fragmenter {
   }
 
  private:
+  // A byte range of a sample to be encrypted.
+  struct CipherRange {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  // A sample being encrypted on the worker pool. |done| is signaled once
+  // |status| and the sample data are final.
+  struct PendingEncryptedSample {
+    PendingEncryptedSample();
+    ~PendingEncryptedSample();
+
+    scoped_refptr<MediaSample> sample;
+    scoped_ptr<AesCryptor> encryptor;
+    SampleEncryptionEntry entry;
+    std::vector<CipherRange> cipher_ranges;
+    Status status;
+    base::WaitableEvent done;
+  };
+
+  // Encrypts |pending|'s cipher ranges in place with its own encryptor; runs
+  // on the worker pool.
+  static void EncryptSampleTask(PendingEncryptedSample* pending);
+
   void EncryptBytes(uint8_t* data, uint32_t size);
-  Status EncryptSample(scoped_refptr<MediaSample> sample);
+  Status EncryptSample(const scoped_refptr<MediaSample>& sample);
+
+  // Parses |sample| and fills in the subsample entries of |entry| and the
+  // byte ranges to encrypt, without encrypting anything.
+  Status GenerateSubsampleInfo(MediaSample* sample,
+                               SampleEncryptionEntry* entry,
+                               std::vector<CipherRange>* cipher_ranges);
+  // Records a finished sample's encryption metadata in the track fragment.
+  // The IV and subsample vectors are swapped out of |entry|, which is left
+  // empty, so the metadata is not copied.
+  void RecordSampleEncryptionEntry(SampleEncryptionEntry* entry);
+
+  // Returns an uninitialized cryptor for the configured protection scheme,
+  // or NULL if the scheme is not supported.
+  scoped_ptr<AesCryptor> CreateCryptor();
+
+  // Whether samples can be encrypted concurrently: per-sample IVs must be
+  // derivable without parsing the sample, i.e. constant IVs or 8-byte IVs
+  // which increment by one per sample.
+  bool CanEncryptInParallel() const;
+  // Hands |sample| to the worker pool and flushes the window when full.
+  Status EnqueueEncryptedSample(const scoped_refptr<MediaSample>& sample);
+  // Waits for all in-flight samples, then records and adds them in order.
+  Status FlushEncryptionWindow();
 
   // Should we enable subsample encryption?
   bool IsSubsampleEncryptionRequired();
@@ -101,6 +152,16 @@ class EncryptingFragmenter : public Fragmenter {
 
   scoped_ptr<VPxParser> vpx_parser_;
   scoped_ptr<VideoSliceHeaderParser> header_parser_;
+  // Reused across samples to avoid a per-sample allocation. Only accessed
+  // from GenerateSubsampleInfo(), which runs on the muxer thread.
+  std::vector<VPxFrameInfo> vpx_frames_;
+  // Reused across samples on the serial encryption path; the parallel path
+  // keeps its ranges in PendingEncryptedSample. Muxer thread only.
+  std::vector<CipherRange> cipher_ranges_;
+
+  // Samples handed to the worker pool, in order; owned. Flushed at window
+  // boundaries and at fragment finalization.
+  std::vector<PendingEncryptedSample*> pending_samples_;
 
   DISALLOW_COPY_AND_ASSIGN(EncryptingFragmenter);
 };
@@ -6,9 +6,9 @@
 
 #include "packager/media/formats/mp4/fragmenter.h"
 
+#include <algorithm>
 #include <limits>
 
-#include "packager/media/base/buffer_writer.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/formats/mp4/box_definitions.h"
@@ -38,19 +38,26 @@ Fragmenter::Fragmenter(scoped_refptr<StreamInfo> info, TrackFragment* traf)
       fragment_duration_(0),
       presentation_start_time_(kInvalidTime),
       earliest_presentation_time_(kInvalidTime),
-      first_sap_time_(kInvalidTime) {
+      first_sap_time_(kInvalidTime),
+      data_size_(0) {
   DCHECK(traf);
 }
 
 Fragmenter::~Fragmenter() {}
 
-Status Fragmenter::AddSample(scoped_refptr<MediaSample> sample) {
+Status Fragmenter::AddSample(const scoped_refptr<MediaSample>& sample) {
   DCHECK(sample);
   if (sample->duration() == 0) {
     LOG(WARNING) << "Unexpected sample with zero duration @ dts "
                  << sample->dts();
   }
 
+  if (!timestamp_validator_.AddSample(sample->dts(), sample->duration())) {
+    return Status(error::MUXER_FAILURE,
+                  "Sample timestamps violate the stream invariants; failing "
+                  "fast (--strict_timestamp_checks).");
+  }
+
   if (!fragment_initialized_) {
     Status status = InitializeFragment(sample->dts());
     if (!status.ok())
@@ -66,7 +73,10 @@ Status Fragmenter::AddSample(scoped_refptr<MediaSample> sample) {
   traf_->runs[0].sample_flags.push_back(
       sample->is_key_frame() ? 0 : TrackFragmentHeader::kNonKeySampleMask);
 
-  data_->AppendArray(sample->data(), sample->data_size());
+  // Retain the sample instead of copying its payload into a staging buffer.
+  // The segmenter writes the payloads out when the fragment is finalized.
+  samples_.push_back(sample);
+  data_size_ += sample->data_size();
   fragment_duration_ += sample->duration();
 
   const int64_t pts = sample->pts();
@@ -104,7 +114,10 @@ Status Fragmenter::InitializeFragment(int64_t first_sample_dts) {
   fragment_duration_ = 0;
   earliest_presentation_time_ = kInvalidTime;
   first_sap_time_ = kInvalidTime;
-  data_.reset(new BufferWriter());
+  // Release the samples of the previous fragment; the segmenter has written
+  // their payloads out before initializing the next fragment.
+  samples_.clear();
+  data_size_ = 0;
   return Status::OK;
 }
 
@@ -124,9 +137,22 @@ void Fragmenter::FinalizeFragment() {
   } else {
     traf_->runs[0].flags |= TrackFragmentRun::kSampleSizePresentMask;
   }
-  if (OptimizeSampleEntries(&traf_->runs[0].sample_flags,
+  std::vector<uint32_t>& sample_flags = traf_->runs[0].sample_flags;
+  if (OptimizeSampleEntries(&sample_flags,
                             &traf_->header.default_sample_flags)) {
     traf_->header.flags |= TrackFragmentHeader::kDefaultSampleFlagsPresentMask;
+  } else if (sample_flags.size() > 1 &&
+             std::count(sample_flags.begin() + 1, sample_flags.end(),
+                        sample_flags[1]) ==
+                 static_cast<ptrdiff_t>(sample_flags.size() - 1)) {
+    // All samples after the first share the same flags, which is the common
+    // video pattern of a key frame followed by non-key frames. Emit the first
+    // sample's flags through first-sample-flags and the others through the
+    // default in tfhd, instead of a full per-sample flags table.
+    traf_->header.flags |= TrackFragmentHeader::kDefaultSampleFlagsPresentMask;
+    traf_->header.default_sample_flags = sample_flags[1];
+    sample_flags.resize(1);
+    traf_->runs[0].flags |= TrackFragmentRun::kFirstSampleFlagsPresentMask;
   } else {
     traf_->runs[0].flags |= TrackFragmentRun::kSampleFlagsPresentMask;
   }
@@ -183,7 +209,8 @@ void Fragmenter::GenerateSegmentReference(SegmentReference* reference) {
 bool Fragmenter::StartsWithSAP() {
   DCHECK(!traf_->runs.empty());
   uint32_t start_sample_flag;
-  if (traf_->runs[0].flags & TrackFragmentRun::kSampleFlagsPresentMask) {
+  if (traf_->runs[0].flags & (TrackFragmentRun::kSampleFlagsPresentMask |
+                              TrackFragmentRun::kFirstSampleFlagsPresentMask)) {
     DCHECK(!traf_->runs[0].sample_flags.empty());
     start_sample_flag = traf_->runs[0].sample_flags[0];
   } else {
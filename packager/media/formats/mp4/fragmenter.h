@@ -11,13 +11,12 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/memory/ref_counted.h"
-#include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/status.h"
+#include "packager/media/base/timestamp_validator.h"
 
 namespace shaka {
 namespace media {
 
-class BufferWriter;
 class MediaSample;
 class StreamInfo;
 
@@ -39,7 +38,7 @@ class Fragmenter {
   /// Add a sample to the fragmenter.
   /// @param sample points to the sample to be added.
   /// @return OK on success, an error status otherwise.
-  virtual Status AddSample(scoped_refptr<MediaSample> sample);
+  virtual Status AddSample(const scoped_refptr<MediaSample>& sample);
 
   /// Initialize the fragment with default data.
   /// @param first_sample_dts specifies the decoding timestamp for the first
@@ -60,7 +59,15 @@ class Fragmenter {
   }
   bool fragment_initialized() const { return fragment_initialized_; }
   bool fragment_finalized() const { return fragment_finalized_; }
-  BufferWriter* data() { return data_.get(); }
+  /// @return Total size in bytes of the sample data in this fragment.
+  uint64_t data_size() const { return data_size_; }
+  /// @return The samples added to this fragment. Sample payloads are not
+  ///         copied into a staging buffer; the samples themselves are retained
+  ///         until the next fragment is initialized and the segmenter writes
+  ///         the payloads out directly.
+  const std::vector<scoped_refptr<MediaSample> >& samples() const {
+    return samples_;
+  }
 
   /// Set the flag use_decoding_timestamp_in_timeline, which if set to true, use
   /// decoding timestamp instead of presentation timestamp in media timeline,
@@ -93,7 +100,9 @@ class Fragmenter {
   int64_t presentation_start_time_;
   int64_t earliest_presentation_time_;
   int64_t first_sap_time_;
-  scoped_ptr<BufferWriter> data_;
+  std::vector<scoped_refptr<MediaSample> > samples_;
+  TimestampValidator timestamp_validator_;
+  uint64_t data_size_;
 
   DISALLOW_COPY_AND_ASSIGN(Fragmenter);
 };
@@ -6,6 +6,9 @@
 
 #include "packager/media/formats/mp4/key_rotation_fragmenter.h"
 
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
+#include "packager/base/threading/worker_pool.h"
 #include "packager/media/base/aes_encryptor.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 
@@ -46,7 +49,60 @@ KeyRotationFragmenter::KeyRotationFragmenter(MovieFragment* moof,
   DCHECK(encryption_key_source);
 }
 
-KeyRotationFragmenter::~KeyRotationFragmenter() {}
+KeyRotationFragmenter::~KeyRotationFragmenter() {
+  // The worker task holds a raw pointer into |pending_key_|; wait for it.
+  if (pending_key_)
+    pending_key_->done.Wait();
+}
+
+KeyRotationFragmenter::PendingKey::PendingKey()
+    : crypto_period_index(0),
+      key_source(NULL),
+      track_type(KeySource::TRACK_TYPE_UNKNOWN),
+      done(false, false) {}
+
+KeyRotationFragmenter::PendingKey::~PendingKey() {}
+
+// static
+void KeyRotationFragmenter::FetchKeyTask(PendingKey* pending) {
+  pending->status = pending->key_source->GetCryptoPeriodKey(
+      pending->crypto_period_index, pending->track_type, pending->key.get());
+  pending->done.Signal();
+}
+
+Status KeyRotationFragmenter::FetchCryptoPeriodKey(
+    size_t crypto_period_index,
+    scoped_ptr<EncryptionKey>* key) {
+  DCHECK(key);
+  if (pending_key_) {
+    scoped_ptr<PendingKey> pending(pending_key_.Pass());
+    pending->done.Wait();
+    if (pending->status.ok() &&
+        pending->crypto_period_index == crypto_period_index) {
+      *key = pending->key.Pass();
+      return Status::OK;
+    }
+    // A failed or stale prefetch falls through to a synchronous fetch.
+  }
+
+  key->reset(new EncryptionKey());
+  return encryption_key_source_->GetCryptoPeriodKey(crypto_period_index,
+                                                    track_type_, key->get());
+}
+
+void KeyRotationFragmenter::PrefetchCryptoPeriodKey(
+    size_t crypto_period_index) {
+  DCHECK(!pending_key_);
+  pending_key_.reset(new PendingKey);
+  pending_key_->crypto_period_index = crypto_period_index;
+  pending_key_->key_source = encryption_key_source_;
+  pending_key_->track_type = track_type_;
+  pending_key_->key.reset(new EncryptionKey());
+  base::WorkerPool::PostTask(
+      FROM_HERE,
+      base::Bind(&KeyRotationFragmenter::FetchKeyTask, pending_key_.get()),
+      true /* task_is_slow */);
+}
 
 Status KeyRotationFragmenter::PrepareFragmentForEncryption(
     bool enable_encryption) {
@@ -55,11 +111,14 @@ Status KeyRotationFragmenter::PrepareFragmentForEncryption(
   size_t current_crypto_period_index =
       traf()->decode_time.decode_time / crypto_period_duration_;
   if (current_crypto_period_index != prev_crypto_period_index_) {
-    scoped_ptr<EncryptionKey> encryption_key(new EncryptionKey());
-    Status status = encryption_key_source_->GetCryptoPeriodKey(
-        current_crypto_period_index, track_type_, encryption_key.get());
+    scoped_ptr<EncryptionKey> encryption_key;
+    Status status =
+        FetchCryptoPeriodKey(current_crypto_period_index, &encryption_key);
     if (!status.ok())
       return status;
+    // Request the next period's key now, so the fetch overlaps this period's
+    // packaging instead of stalling the next boundary on the key server.
+    PrefetchCryptoPeriodKey(current_crypto_period_index + 1);
     if (encryption_key->iv.empty()) {
       if (!AesCryptor::GenerateRandomIv(protection_scheme(),
                                         &encryption_key->iv)) {
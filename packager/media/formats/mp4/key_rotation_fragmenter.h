@@ -7,6 +7,7 @@
 #ifndef MEDIA_FORMATS_MP4_KEY_ROTATION_FRAGMENTER_H_
 #define MEDIA_FORMATS_MP4_KEY_ROTATION_FRAGMENTER_H_
 
+#include "packager/base/synchronization/waitable_event.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/event/muxer_listener.h"
@@ -61,12 +62,39 @@ class KeyRotationFragmenter : public EncryptingFragmenter {
   /// @}
 
  private:
+  // A crypto period key being fetched on the worker pool. |done| is signaled
+  // once |status| and |key| are final.
+  struct PendingKey {
+    PendingKey();
+    ~PendingKey();
+
+    size_t crypto_period_index;
+    KeySource* key_source;
+    KeySource::TrackType track_type;
+    scoped_ptr<EncryptionKey> key;
+    Status status;
+    base::WaitableEvent done;
+  };
+
+  // Fetches |pending|'s key; runs on the worker pool.
+  static void FetchKeyTask(PendingKey* pending);
+
+  // Returns the key for |crypto_period_index| in |key|, consuming the
+  // prefetched key when it matches, otherwise fetching synchronously.
+  Status FetchCryptoPeriodKey(size_t crypto_period_index,
+                              scoped_ptr<EncryptionKey>* key);
+  // Starts a background fetch for |crypto_period_index|, so the key is
+  // already local when that period starts.
+  void PrefetchCryptoPeriodKey(size_t crypto_period_index);
+
   MovieFragment* moof_;
 
   KeySource* encryption_key_source_;
   KeySource::TrackType track_type_;
   const int64_t crypto_period_duration_;
   size_t prev_crypto_period_index_;
+  // The next period's key fetch, if one is in flight.
+  scoped_ptr<PendingKey> pending_key_;
 
   // For notifying new pssh boxes to the event handler.
   MuxerListener* const muxer_listener_;
@@ -54,6 +54,18 @@
         '../../event/media_event.gyp:media_event',
       ],
     },
+    {
+      'target_name': 'mp4_bench',
+      'type': 'executable',
+      'sources': [
+        'mp4_benchmark.cc',
+      ],
+      'dependencies': [
+        '../../../base/base.gyp:base',
+        '../../test/media_test.gyp:media_test_support',
+        'mp4',
+      ],
+    },
     {
       'target_name': 'mp4_unittest',
       'type': '<(gtest_target_type)',
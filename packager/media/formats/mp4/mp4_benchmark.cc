@@ -0,0 +1,211 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Throughput benchmark for the mp4 parsing path. Each benchmark runs one
+// stage — top-level box scanning, full moov parsing, sample table iteration
+// or complete demuxing — repeatedly over a file committed under
+// packager/media/test/data and reports MB/s, printing one JSON object per
+// line to stdout so results can be compared across releases:
+//
+//   mp4_bench > mp4_bench.json
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "packager/base/at_exit.h"
+#include "packager/base/bind.h"
+#include "packager/base/callback.h"
+#include "packager/base/memory/ref_counted.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/box_reader.h"
+#include "packager/media/formats/mp4/mp4_media_parser.h"
+#include "packager/media/formats/mp4/track_run_iterator.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+// Each benchmark is repeated until it has run at least this long, so short
+// inputs still produce stable numbers.
+const int64_t kMinBenchTimeMicroseconds = 1000000;
+
+typedef base::Callback<bool(const std::vector<uint8_t>& data)> BenchFunc;
+
+// Walks the top-level boxes of the file, reading only box headers.
+bool BenchBoxScan(const std::vector<uint8_t>& data) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    FourCC type;
+    uint64_t box_size;
+    bool err = false;
+    if (!BoxReader::StartBox(data.data() + pos, data.size() - pos, &type,
+                             &box_size, &err)) {
+      return false;
+    }
+    if (box_size == 0 || box_size > data.size() - pos)
+      return false;
+    pos += box_size;
+  }
+  return true;
+}
+
+// Parses a moov box, including all of its children, into box definitions.
+// |data| holds exactly the moov box.
+bool BenchMoovParse(const std::vector<uint8_t>& data) {
+  bool err = false;
+  scoped_ptr<BoxReader> reader(
+      BoxReader::ReadBox(data.data(), data.size(), &err));
+  if (!reader || err)
+    return false;
+  Movie moov;
+  return moov.Parse(reader.get());
+}
+
+// Iterates over every sample of a parsed moov. |data| is unused except for
+// throughput accounting; the moov is parsed once outside the timed loop.
+bool BenchTrackRunIteration(const Movie* moov,
+                            const std::vector<uint8_t>& data) {
+  TrackRunIterator runs(moov);
+  if (!runs.Init())
+    return false;
+  int64_t total_sample_size = 0;
+  while (runs.IsRunValid()) {
+    while (runs.IsSampleValid()) {
+      total_sample_size += runs.sample_size();
+      runs.AdvanceSample();
+    }
+    runs.AdvanceRun();
+  }
+  return total_sample_size > 0;
+}
+
+void IgnoreStreams(const std::vector<scoped_refptr<StreamInfo> >& streams) {}
+
+bool CountSample(size_t* num_samples,
+                 uint32_t track_id,
+                 const scoped_refptr<MediaSample>& sample) {
+  ++*num_samples;
+  return true;
+}
+
+// Demuxes the whole file with a fresh parser, counting emitted samples.
+bool BenchDemux(const std::vector<uint8_t>& data) {
+  MP4MediaParser parser;
+  size_t num_samples = 0;
+  parser.Init(base::Bind(&IgnoreStreams),
+              base::Bind(&CountSample, &num_samples),
+              NULL);
+  if (!parser.Parse(data.data(), data.size()))
+    return false;
+  return num_samples > 0;
+}
+
+// Returns the slice of |data| holding the first top-level box of |box_type|,
+// or an empty vector if there is none.
+std::vector<uint8_t> FindTopLevelBox(const std::vector<uint8_t>& data,
+                                     FourCC box_type) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    FourCC type;
+    uint64_t box_size;
+    bool err = false;
+    if (!BoxReader::StartBox(data.data() + pos, data.size() - pos, &type,
+                             &box_size, &err) ||
+        box_size == 0 || box_size > data.size() - pos) {
+      break;
+    }
+    if (type == box_type) {
+      return std::vector<uint8_t>(data.begin() + pos,
+                                  data.begin() + pos + box_size);
+    }
+    pos += box_size;
+  }
+  return std::vector<uint8_t>();
+}
+
+void RunBenchmark(const char* name,
+                  const BenchFunc& func,
+                  const char* file_name,
+                  const std::vector<uint8_t>& data) {
+  if (data.empty()) {
+    fprintf(stderr, "Skipping %s: no input data from %s.\n", name, file_name);
+    return;
+  }
+  // Warm up and make sure the input actually parses before timing it.
+  if (!func.Run(data)) {
+    fprintf(stderr, "Skipping %s: failed to parse %s.\n", name, file_name);
+    return;
+  }
+
+  int iterations = 0;
+  int64_t elapsed_us = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  do {
+    func.Run(data);
+    ++iterations;
+    elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
+  } while (elapsed_us < kMinBenchTimeMicroseconds);
+
+  const double seconds = elapsed_us / 1000000.0;
+  const double megabytes =
+      static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+  printf(
+      "{\"name\": \"%s\", \"input\": \"%s\", \"iterations\": %d, "
+      "\"bytes_per_iteration\": %d, \"elapsed_us\": %lld, "
+      "\"throughput_mb_per_s\": %.2f}\n",
+      name, file_name, iterations, static_cast<int>(data.size()),
+      static_cast<long long>(elapsed_us), megabytes / seconds);
+}
+
+void RunAllBenchmarks() {
+  const char kMp4File[] = "bear-640x360.mp4";
+  const char kFragmentedMp4File[] = "bear-640x360-av_frag.mp4";
+
+  const std::vector<uint8_t> data = ReadTestDataFile(kMp4File);
+  const std::vector<uint8_t> fragmented_data =
+      ReadTestDataFile(kFragmentedMp4File);
+
+  RunBenchmark("box_scan", base::Bind(&BenchBoxScan), kMp4File, data);
+
+  const std::vector<uint8_t> moov_data = FindTopLevelBox(data, FOURCC_moov);
+  RunBenchmark("moov_parse", base::Bind(&BenchMoovParse), kMp4File, moov_data);
+
+  // Parse the moov once so the iteration benchmark measures the sample table
+  // walk, not the parse.
+  Movie moov;
+  if (!moov_data.empty() && BenchMoovParse(moov_data)) {
+    bool err = false;
+    scoped_ptr<BoxReader> reader(
+        BoxReader::ReadBox(moov_data.data(), moov_data.size(), &err));
+    if (reader && !err && moov.Parse(reader.get())) {
+      RunBenchmark("track_run_iteration",
+                   base::Bind(&BenchTrackRunIteration, &moov), kMp4File,
+                   moov_data);
+    }
+  }
+
+  RunBenchmark("mp4_demux", base::Bind(&BenchDemux), kFragmentedMp4File,
+               fragmented_data);
+}
+
+}  // namespace
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit;
+  shaka::media::mp4::RunAllBenchmarks();
+  return 0;
+}
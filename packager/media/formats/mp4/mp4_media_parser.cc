@@ -4,13 +4,21 @@
 
 #include "packager/media/formats/mp4/mp4_media_parser.h"
 
+#include <gflags/gflags.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
 #include <limits>
 
 #include "packager/base/callback.h"
 #include "packager/base/callback_helpers.h"
+#include "packager/base/files/file_util.h"
 #include "packager/base/logging.h"
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/stringprintf.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/buffer_reader.h"
 #include "packager/media/base/decrypt_config.h"
@@ -29,6 +37,14 @@
 #include "packager/media/formats/mp4/box_reader.h"
 #include "packager/media/formats/mp4/track_run_iterator.h"
 
+DEFINE_bool(mp4_moov_index_sidecar,
+            false,
+            "Write a small index sidecar next to MP4 inputs whose 'moov' box "
+            "trails the media data, and use it on later runs of the same "
+            "input to seek straight to the 'moov' instead of scanning every "
+            "top-level box. The sidecar is keyed to the input's size and "
+            "modification time and is ignored when either changes.");
+
 namespace shaka {
 namespace media {
 namespace mp4 {
@@ -88,13 +104,90 @@ AudioCodec FourCCToAudioCodec(FourCC fourcc) {
 const uint8_t kDtsAudioNumChannels = 6;
 const uint64_t kNanosecondsPerSecond = 1000000000ull;
 
+// Suffix of the index sidecar written next to the input. It holds the input
+// file size, modification time and the offset of the trailing 'moov' box,
+// separated by spaces.
+const char kMoovIndexSidecarSuffix[] = ".moov_index";
+
+// Number of bytes read from the end of the file when probing for a trailing
+// 'moov' box. The probe only succeeds when the whole box fits in the window,
+// so the window is sized generously; the box walk covers the rest.
+const uint64_t kMoovTailProbeSize = 8 * 1024 * 1024;
+
+bool ReadMoovIndexSidecar(const std::string& file_path,
+                          uint64_t* moov_offset) {
+  base::File::Info info;
+  if (!base::GetFileInfo(base::FilePath(file_path), &info))
+    return false;
+
+  std::string contents;
+  if (!base::ReadFileToString(
+          base::FilePath(file_path + kMoovIndexSidecarSuffix), &contents)) {
+    return false;
+  }
+
+  std::vector<std::string> fields;
+  base::SplitString(contents, ' ', &fields);
+  int64_t cached_size;
+  int64_t cached_mtime;
+  if (fields.size() != 3 || !base::StringToInt64(fields[0], &cached_size) ||
+      !base::StringToInt64(fields[1], &cached_mtime) ||
+      !base::StringToUint64(fields[2], moov_offset)) {
+    LOG(WARNING) << "Malformed moov index sidecar for '" << file_path << "'";
+    return false;
+  }
+  if (cached_size != info.size ||
+      cached_mtime != info.last_modified.ToTimeT()) {
+    VLOG(1) << "Stale moov index sidecar for '" << file_path << "'";
+    return false;
+  }
+  return true;
+}
+
+void WriteMoovIndexSidecar(const std::string& file_path,
+                           uint64_t moov_offset) {
+  base::File::Info info;
+  if (!base::GetFileInfo(base::FilePath(file_path), &info))
+    return;
+  const std::string contents = base::StringPrintf(
+      "%" PRId64 " %" PRId64 " %" PRIu64, info.size,
+      static_cast<int64_t>(info.last_modified.ToTimeT()), moov_offset);
+  const base::FilePath path(file_path + kMoovIndexSidecarSuffix);
+  if (base::WriteFile(path, contents.data(), contents.size()) !=
+      static_cast<int>(contents.size())) {
+    LOG(WARNING) << "Failed to write moov index sidecar " << path.value();
+  }
+}
+
+// Release the per-sample and per-chunk table vectors once TrackRunIterator
+// has expanded them into its run table; they are never read again and can
+// account for megabytes on movies with hundreds of thousands of samples. The
+// sample descriptions are still referenced from the run table and must be
+// kept. For fragmented files these tables are empty, so this is a no-op.
+void ReleaseSampleTables(Movie* moov) {
+  for (std::vector<Track>::iterator track = moov->tracks.begin();
+       track != moov->tracks.end(); ++track) {
+    SampleTable& sample_table = track->media.information.sample_table;
+    std::vector<DecodingTime>().swap(
+        sample_table.decoding_time_to_sample.decoding_time);
+    std::vector<CompositionOffset>().swap(
+        sample_table.composition_time_to_sample.composition_offset);
+    std::vector<ChunkInfo>().swap(sample_table.sample_to_chunk.chunk_info);
+    std::vector<uint32_t>().swap(sample_table.sample_size.sizes);
+    std::vector<uint64_t>().swap(sample_table.chunk_large_offset.offsets);
+    std::vector<uint32_t>().swap(sample_table.sync_sample.sample_number);
+  }
+}
+
 }  // namespace
 
 MP4MediaParser::MP4MediaParser()
     : state_(kWaitingForInit),
       decryption_key_source_(NULL),
       moof_head_(0),
-      mdat_tail_(0) {}
+      mdat_tail_(0),
+      range_start_seconds_(0),
+      range_end_seconds_(0) {}
 
 MP4MediaParser::~MP4MediaParser() {}
 
@@ -175,6 +268,19 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
     return false;
   }
 
+  if (FLAGS_mp4_moov_index_sidecar) {
+    uint64_t moov_offset;
+    if (ReadMoovIndexSidecar(file_path, &moov_offset)) {
+      if (ParseMoovAt(file.get(), file_path, moov_offset))
+        return true;
+      // The sidecar did not point at a parseable 'moov'; rescan the file.
+      LOG(WARNING) << "Ignoring invalid moov index sidecar for '" << file_path
+                   << "'";
+      if (!file->Seek(0))
+        return false;
+    }
+  }
+
   uint64_t file_position(0);
   bool mdat_seen(false);
   while (true) {
@@ -198,36 +304,41 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
       return false;
     }
     if (box_type == FOURCC_mdat) {
-      mdat_seen = true;
+      if (!mdat_seen) {
+        mdat_seen = true;
+        // The 'moov' of an mdat-before-moov file almost always trails the
+        // file, so one ranged read of the tail usually finds it without
+        // walking the remaining top-level boxes, which costs a round trip
+        // each on high-latency storage.
+        uint64_t moov_offset;
+        if (TryLoadMoovFromTail(file.get(), file_path, &moov_offset)) {
+          if (FLAGS_mp4_moov_index_sidecar)
+            WriteMoovIndexSidecar(file_path, moov_offset);
+          return true;
+        }
+        // Not found in the tail; resume the walk. The seek at the bottom of
+        // the loop re-establishes the walk position.
+      }
     } else if (box_type == FOURCC_moov) {
       if (!mdat_seen) {
         // 'moov' is before 'mdat'. Nothing to do.
         break;
       }
       // 'mdat' before 'moov'. Read and parse 'moov'.
-      if (!Parse(&buffer[0], bytes_read)) {
-        LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
+      if (!ParseMoovAt(file.get(), file_path, file_position))
         return false;
-      }
-      uint64_t bytes_to_read = box_size - bytes_read;
-      buffer.resize(bytes_to_read);
-      while (bytes_to_read > 0) {
-        bytes_read = file->Read(&buffer[0], bytes_to_read);
-        if (bytes_read <= 0) {
-          LOG(ERROR) << "Error reading 'moov' contents from file '" << file_path
-                     << "'";
-          return false;
-        }
-        if (!Parse(&buffer[0], bytes_read)) {
-          LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
-          return false;
-        }
-        bytes_to_read -= bytes_read;
-      }
-      queue_.Reset();  // So that we don't need to adjust data offsets.
-      mdat_tail_ = 0;  // So it will skip boxes until mdat.
+      // Remember where the 'moov' is so later runs of the same input can
+      // seek straight to it.
+      if (FLAGS_mp4_moov_index_sidecar)
+        WriteMoovIndexSidecar(file_path, file_position);
       break;  // Done.
     }
+    if (box_size == 0) {
+      // The box extends to the end of the file, so there is no 'moov'
+      // behind it and the walk would not advance.
+      LOG(ERROR) << "Could not find 'moov' box in file '" << file_path << "'";
+      return false;
+    }
     file_position += box_size;
     if (!file->Seek(file_position)) {
       LOG(ERROR) << "Error skipping box in mp4 file '" << file_path << "'";
@@ -237,6 +348,97 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
   return true;
 }
 
+bool MP4MediaParser::TryLoadMoovFromTail(File* file,
+                                         const std::string& file_path,
+                                         uint64_t* moov_offset) {
+  DCHECK(moov_offset);
+  const int64_t file_size = file->Size();
+  if (file_size <= 0)
+    return false;
+
+  const uint64_t probe_size =
+      std::min(static_cast<uint64_t>(file_size), kMoovTailProbeSize);
+  const uint64_t probe_offset = file_size - probe_size;
+  if (!file->Seek(probe_offset))
+    return false;
+
+  std::vector<uint8_t> buffer(probe_size);
+  uint64_t buffer_filled = 0;
+  while (buffer_filled < probe_size) {
+    int64_t bytes_read =
+        file->Read(&buffer[buffer_filled], probe_size - buffer_filled);
+    if (bytes_read <= 0)
+      return false;
+    buffer_filled += bytes_read;
+  }
+
+  // Scan for a 'moov' box header whose box ends exactly at the end of the
+  // file, which is where muxers that write the media data first leave it.
+  // Matching both the type and the size makes a false positive unlikely;
+  // ParseMoovAt() then validates the candidate in full.
+  for (uint64_t i = 0; i + 8 <= probe_size; ++i) {
+    if (memcmp(&buffer[i + 4], "moov", 4) != 0)
+      continue;
+    const uint32_t box_size = static_cast<uint32_t>(buffer[i]) << 24 |
+                              static_cast<uint32_t>(buffer[i + 1]) << 16 |
+                              static_cast<uint32_t>(buffer[i + 2]) << 8 |
+                              static_cast<uint32_t>(buffer[i + 3]);
+    if (box_size < 8 || i + box_size != probe_size)
+      continue;
+    if (!ParseMoovAt(file, file_path, probe_offset + i))
+      continue;  // A false positive; keep scanning.
+    *moov_offset = probe_offset + i;
+    return true;
+  }
+  return false;
+}
+
+bool MP4MediaParser::ParseMoovAt(File* file,
+                                 const std::string& file_path,
+                                 uint64_t moov_offset) {
+  if (!file->Seek(moov_offset)) {
+    LOG(ERROR) << "Error seeking to 'moov' in mp4 file '" << file_path << "'";
+    return false;
+  }
+  const uint32_t kBoxHeaderReadSize(16);
+  std::vector<uint8_t> buffer(kBoxHeaderReadSize);
+  int64_t bytes_read = file->Read(&buffer[0], kBoxHeaderReadSize);
+  if (bytes_read < kBoxHeaderReadSize) {
+    LOG(ERROR) << "Error reading media file '" << file_path << "'";
+    return false;
+  }
+  uint64_t box_size;
+  FourCC box_type;
+  bool err;
+  if (!BoxReader::StartBox(&buffer[0], kBoxHeaderReadSize, &box_type,
+                           &box_size, &err) ||
+      box_type != FOURCC_moov) {
+    return false;
+  }
+  if (!Parse(&buffer[0], bytes_read)) {
+    LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
+    return false;
+  }
+  uint64_t bytes_to_read = box_size - bytes_read;
+  buffer.resize(bytes_to_read);
+  while (bytes_to_read > 0) {
+    bytes_read = file->Read(&buffer[0], bytes_to_read);
+    if (bytes_read <= 0) {
+      LOG(ERROR) << "Error reading 'moov' contents from file '" << file_path
+                 << "'";
+      return false;
+    }
+    if (!Parse(&buffer[0], bytes_read)) {
+      LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
+      return false;
+    }
+    bytes_to_read -= bytes_read;
+  }
+  queue_.Reset();  // So that we don't need to adjust data offsets.
+  mdat_tail_ = 0;  // So it will skip boxes until mdat.
+  return true;
+}
+
 bool MP4MediaParser::ParseBox(bool* err) {
   const uint8_t* buf;
   int size;
@@ -291,7 +493,25 @@ bool MP4MediaParser::ParseMoov(BoxReader* reader) {
 
   for (std::vector<Track>::const_iterator track = moov_->tracks.begin();
        track != moov_->tracks.end(); ++track) {
+    // Skip tracks outside the stream selection: no stream info is emitted
+    // for them and their sample runs are skipped wholesale in EnqueueSample,
+    // so none of their sample table or sample data is processed.
+    if (!selected_stream_types_.empty()) {
+      StreamType stream_type = kStreamUnknown;
+      const TrackType track_type =
+          track->media.information.sample_table.description.type;
+      if (track_type == kAudio)
+        stream_type = kStreamAudio;
+      else if (track_type == kVideo)
+        stream_type = kStreamVideo;
+      if (selected_stream_types_.count(stream_type) == 0) {
+        skipped_track_ids_.insert(track->header.track_id);
+        continue;
+      }
+    }
     const uint32_t timescale = track->media.header.timescale;
+    if (range_end_seconds_ > range_start_seconds_)
+      track_timescales_[track->header.track_id] = timescale;
 
     // Calculate duration (based on timescale).
     uint64_t duration = 0;
@@ -593,6 +813,7 @@ bool MP4MediaParser::ParseMoov(BoxReader* reader) {
     return false;
   runs_.reset(new TrackRunIterator(moov_.get()));
   RCHECK(runs_->Init());
+  ReleaseSampleTables(moov_.get());
   ChangeState(kEmittingSamples);
   return true;
 }
@@ -643,6 +864,24 @@ bool MP4MediaParser::FetchKeysIfNecessary(
   return false;
 }
 
+void MP4MediaParser::SetSelectedStreamTypes(
+    const std::set<StreamType>& stream_types) {
+  DCHECK_EQ(kWaitingForInit, state_);
+  selected_stream_types_ = stream_types;
+}
+
+void MP4MediaParser::SetTimeRange(double start_seconds, double end_seconds) {
+  DCHECK_EQ(kWaitingForInit, state_);
+  range_start_seconds_ = start_seconds;
+  range_end_seconds_ = end_seconds;
+}
+
+bool MP4MediaParser::IsParsingComplete() const {
+  return range_end_seconds_ > range_start_seconds_ &&
+         !track_timescales_.empty() &&
+         tracks_past_range_end_.size() == track_timescales_.size();
+}
+
 bool MP4MediaParser::EnqueueSample(bool* err) {
   if (!runs_->IsRunValid()) {
     // Remain in kEnqueueingSamples state, discarding data, until the end of
@@ -667,9 +906,32 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
   if (!buf_size)
     return false;
 
-  // Skip this entire track if it is not audio nor video.
-  if (!runs_->is_audio() && !runs_->is_video())
+  // Skip this entire track if it is not audio nor video, or if it was
+  // excluded by stream selection.
+  if ((!runs_->is_audio() && !runs_->is_video()) ||
+      skipped_track_ids_.count(runs_->track_id()) != 0) {
     runs_->AdvanceRun();
+    return true;
+  }
+
+  // Skip samples outside the configured time range without touching their
+  // data: no copy, no decryption, no emission. Downstream filters drop
+  // samples before the range start anyway, so skipping strictly-earlier
+  // samples cannot lose content.
+  if (range_end_seconds_ > range_start_seconds_) {
+    const uint32_t timescale = track_timescales_[runs_->track_id()];
+    const double pts_in_seconds =
+        timescale == 0 ? 0 : static_cast<double>(runs_->cts()) / timescale;
+    if (pts_in_seconds < range_start_seconds_) {
+      runs_->AdvanceSample();
+      return true;
+    }
+    if (pts_in_seconds >= range_end_seconds_) {
+      tracks_past_range_end_.insert(runs_->track_id());
+      runs_->AdvanceSample();
+      return true;
+    }
+  }
 
   // Attempt to cache the auxiliary information first. Aux info is usually
   // placed in a contiguous block before the sample data, rather than being
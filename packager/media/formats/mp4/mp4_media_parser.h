@@ -10,6 +10,7 @@
 #include <stdint.h>
 
 #include <map>
+#include <set>
 #include <vector>
 
 #include "packager/base/callback_forward.h"
@@ -23,6 +24,9 @@
 
 namespace shaka {
 namespace media {
+
+class File;
+
 namespace mp4 {
 
 class BoxReader;
@@ -42,6 +46,10 @@ class MP4MediaParser : public MediaParser {
             KeySource* decryption_key_source) override;
   bool Flush() override WARN_UNUSED_RESULT;
   bool Parse(const uint8_t* buf, int size) override WARN_UNUSED_RESULT;
+  void SetSelectedStreamTypes(
+      const std::set<StreamType>& stream_types) override;
+  void SetTimeRange(double start_seconds, double end_seconds) override;
+  bool IsParsingComplete() const override;
   /// @}
 
   /// Handles ISO-BMFF containers which have the 'moov' box trailing the
@@ -64,6 +72,22 @@ class MP4MediaParser : public MediaParser {
   bool ParseMoov(mp4::BoxReader* reader);
   bool ParseMoof(mp4::BoxReader* reader);
 
+  // Reads the 'moov' box at |moov_offset| in |file| and runs it through
+  // Parse(). Returns false without consuming any input if the box at
+  // |moov_offset| is not a 'moov'.
+  bool ParseMoovAt(File* file,
+                   const std::string& file_path,
+                   uint64_t moov_offset);
+
+  // Probes the tail of |file| for a trailing 'moov' box and parses it if
+  // found. Returns true on success and sets |moov_offset| to where the box
+  // starts; returns false when the tail does not contain the box, e.g.
+  // because the 'moov' is larger than the probe window or does not trail
+  // the file.
+  bool TryLoadMoovFromTail(File* file,
+                           const std::string& file_path,
+                           uint64_t* moov_offset);
+
   bool FetchKeysIfNecessary(
       const std::vector<ProtectionSystemSpecificHeader>& headers);
 
@@ -103,6 +127,20 @@ class MP4MediaParser : public MediaParser {
 
   scoped_ptr<Movie> moov_;
   scoped_ptr<TrackRunIterator> runs_;
+  // Empty means all streams are selected.
+  std::set<StreamType> selected_stream_types_;
+  // Tracks skipped by stream selection; their sample runs are skipped
+  // wholesale in EnqueueSample.
+  std::set<uint32_t> skipped_track_ids_;
+  // Presentation time range to emit; disabled when end <= start. Samples
+  // outside the range are skipped without data processing, and parsing is
+  // reported complete once every emitted track has passed the range end.
+  double range_start_seconds_;
+  double range_end_seconds_;
+  // Media timescale by track_id for emitted tracks, for range comparisons.
+  std::map<uint32_t, uint32_t> track_timescales_;
+  // Emitted tracks whose samples have reached the range end.
+  std::set<uint32_t> tracks_past_range_end_;
 
   DISALLOW_COPY_AND_ASSIGN(MP4MediaParser);
 };
@@ -173,8 +173,13 @@ Status MP4Muxer::Finalize() {
   return Status::OK;
 }
 
+Status MP4Muxer::DoFlush() {
+  DCHECK(segmenter_);
+  return segmenter_->Flush();
+}
+
 Status MP4Muxer::DoAddSample(const MediaStream* stream,
-                             scoped_refptr<MediaSample> sample) {
+                             const scoped_refptr<MediaSample>& sample) {
   DCHECK(segmenter_);
   return segmenter_->AddSample(stream, sample);
 }
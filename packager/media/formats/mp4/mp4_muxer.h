@@ -37,8 +37,9 @@ class MP4Muxer : public Muxer {
   // Muxer implementation overrides.
   Status Initialize() override;
   Status Finalize() override;
+  Status DoFlush() override;
   Status DoAddSample(const MediaStream* stream,
-                     scoped_refptr<MediaSample> sample) override;
+                     const scoped_refptr<MediaSample>& sample) override;
 
   // Generate Audio/Video Track box.
   void InitializeTrak(const StreamInfo* info, Track* trak);
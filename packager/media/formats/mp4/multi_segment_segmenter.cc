@@ -6,6 +6,7 @@
 
 #include "packager/media/formats/mp4/multi_segment_segmenter.h"
 
+#include "packager/base/bind.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_util.h"
 #include "packager/media/base/buffer_writer.h"
@@ -16,6 +17,12 @@
 #include "packager/media/file/file.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 
+namespace {
+// Maximum number of built segments waiting on the writer thread before
+// segment building blocks. Keeps memory bounded if the storage is slow.
+const size_t kMaxPendingSegments = 4;
+}  // namespace
+
 namespace shaka {
 namespace media {
 namespace mp4 {
@@ -25,13 +32,26 @@ MultiSegmentSegmenter::MultiSegmentSegmenter(const MuxerOptions& options,
                                              scoped_ptr<Movie> moov)
     : Segmenter(options, ftyp.Pass(), moov.Pass()),
       styp_(new SegmentType),
-      num_segments_(0) {
+      num_segments_(static_cast<uint32_t>(options.initial_segment_number)),
+      chunked_segment_file_(NULL),
+      chunked_segment_size_(0) {
   // Use the same brands for styp as ftyp.
   styp_->major_brand = Segmenter::ftyp()->major_brand;
   styp_->compatible_brands = Segmenter::ftyp()->compatible_brands;
 }
 
-MultiSegmentSegmenter::~MultiSegmentSegmenter() {}
+MultiSegmentSegmenter::~MultiSegmentSegmenter() {
+  if (chunked_segment_file_) {
+    // Only reachable on error paths; normal termination closes the file in
+    // FinalizeChunkedSegment().
+    if (!chunked_segment_file_->Close()) {
+      LOG(WARNING) << "Failed to close the file properly: "
+                   << chunked_segment_file_name_;
+    }
+    chunked_segment_file_ = NULL;
+  }
+  StopSegmentWriter();
+}
 
 bool MultiSegmentSegmenter::GetInitRange(size_t* offset, size_t* size) {
   DLOG(INFO) << "MultiSegmentSegmenter outputs init segment: "
@@ -65,11 +85,15 @@ Status MultiSegmentSegmenter::DoInitialize() {
 }
 
 Status MultiSegmentSegmenter::DoFinalize() {
+  Status status = StopSegmentWriter();
   SetComplete();
-  return Status::OK;
+  return status;
 }
 
 Status MultiSegmentSegmenter::DoFinalizeSegment() {
+  if (options().chunked_fragments && !options().segment_template.empty())
+    return FinalizeChunkedSegment();
+
   DCHECK(sidx());
   // earliest_presentation_time is the earliest presentation time of any
   // access unit in the reference stream in the first subsegment.
@@ -130,49 +154,125 @@ Status MultiSegmentSegmenter::DoFinalizeSegment() {
   return WriteSegment();
 }
 
+Status MultiSegmentSegmenter::DoWriteFragment() {
+  // Without a segment template the output is one continuous file and there
+  // is no live edge to chase; keep buffering until the segment completes.
+  if (!options().chunked_fragments || options().segment_template.empty())
+    return Status::OK;
+  return WriteChunk();
+}
+
+SegmentNameTemplate* MultiSegmentSegmenter::segment_name_template() {
+  if (!segment_name_template_) {
+    segment_name_template_.reset(
+        new SegmentNameTemplate(options().segment_template));
+  }
+  return segment_name_template_.get();
+}
+
+Status MultiSegmentSegmenter::WriteChunk() {
+  DCHECK(fragment_buffer());
+  if (!chunked_segment_file_) {
+    DCHECK(!sidx()->references.empty());
+    chunked_segment_file_name_ = segment_name_template()->GetName(
+        sidx()->references[0].earliest_presentation_time, num_segments_++,
+        options().bandwidth);
+    chunked_segment_file_ =
+        File::Open(chunked_segment_file_name_.c_str(), "w");
+    if (chunked_segment_file_ == NULL) {
+      return Status(
+          error::FILE_FAILURE,
+          "Cannot open file for write " + chunked_segment_file_name_);
+    }
+    // No sidx in chunked mode: the segment is delivered before its fragment
+    // sizes are known.
+    BufferWriter styp_buffer;
+    styp_->Write(&styp_buffer);
+    chunked_segment_size_ += styp_buffer.Size();
+    Status status = styp_buffer.WriteToFile(chunked_segment_file_);
+    if (!status.ok())
+      return status;
+  }
+
+  chunked_segment_size_ += fragment_buffer()->Size();
+  Status status = fragment_buffer()->WriteToFile(chunked_segment_file_);
+  if (!status.ok())
+    return status;
+  // Push the chunk out immediately so the origin can serve it with chunked
+  // transfer before the segment completes; that is the whole point of this
+  // mode.
+  if (!chunked_segment_file_->Flush()) {
+    return Status(error::FILE_FAILURE,
+                  "Fail to flush chunk to file " + chunked_segment_file_name_);
+  }
+  return Status::OK;
+}
+
+Status MultiSegmentSegmenter::FinalizeChunkedSegment() {
+  // The last fragment of the segment has already been written through by
+  // WriteChunk(); all that is left is to close the file and report it.
+  if (chunked_segment_file_ == NULL)
+    return Status::OK;
+
+  Status status;
+  if (!chunked_segment_file_->Close()) {
+    status = Status(error::FILE_FAILURE,
+                    "Cannot close file " + chunked_segment_file_name_);
+  }
+  chunked_segment_file_ = NULL;
+
+  uint64_t segment_duration = 0;
+  for (size_t i = 0; i < sidx()->references.size(); ++i)
+    segment_duration += sidx()->references[i].subsegment_duration;
+
+  UpdateProgress(segment_duration);
+  if (muxer_listener()) {
+    muxer_listener()->OnSampleDurationReady(sample_duration());
+    muxer_listener()->OnNewSegment(
+        chunked_segment_file_name_,
+        sidx()->references[0].earliest_presentation_time, segment_duration,
+        chunked_segment_size_);
+  }
+
+  chunked_segment_file_name_.clear();
+  chunked_segment_size_ = 0;
+  return status;
+}
+
 Status MultiSegmentSegmenter::WriteSegment() {
   DCHECK(sidx());
   DCHECK(fragment_buffer());
   DCHECK(styp_);
 
-  scoped_ptr<BufferWriter> buffer(new BufferWriter());
-  File* file;
+  scoped_ptr<PendingSegment> segment(new PendingSegment);
+  segment->header.reset(new BufferWriter());
+  segment->data.reset(new BufferWriter());
   std::string file_name;
   if (options().segment_template.empty()) {
     // Append the segment to output file if segment template is not specified.
-    file_name = options().output_file_name.c_str();
-    file = File::Open(file_name.c_str(), "a");
-    if (file == NULL) {
-      return Status(
-          error::FILE_FAILURE,
-          "Cannot open file for append " + options().output_file_name);
-    }
+    file_name = options().output_file_name;
   } else {
-    file_name = GetSegmentName(options().segment_template,
-                               sidx()->earliest_presentation_time,
-                               num_segments_++, options().bandwidth);
-    file = File::Open(file_name.c_str(), "w");
-    if (file == NULL) {
-      return Status(error::FILE_FAILURE,
-                    "Cannot open file for write " + file_name);
-    }
-    styp_->Write(buffer.get());
+    file_name = segment_name_template()->GetName(
+        sidx()->earliest_presentation_time, num_segments_++,
+        options().bandwidth);
+    segment->file_name = file_name;
+    styp_->Write(segment->header.get());
   }
 
   // If num_subsegments_per_sidx is negative, no SIDX box is generated.
   if (options().num_subsegments_per_sidx >= 0)
-    sidx()->Write(buffer.get());
+    sidx()->Write(segment->header.get());
 
-  const size_t segment_size = buffer->Size() + fragment_buffer()->Size();
-  DCHECK_NE(segment_size, 0u);
-
-  Status status = buffer->WriteToFile(file);
-  if (status.ok())
-    status = fragment_buffer()->WriteToFile(file);
+  // Take over the fragment data without copying; fragment_buffer() is left
+  // empty for the next segment.
+  segment->data->Swap(fragment_buffer());
 
-  if (!file->Close())
-    LOG(WARNING) << "Failed to close the file properly: " << file_name;
+  const size_t segment_size = segment->header->Size() + segment->data->Size();
+  DCHECK_NE(segment_size, 0u);
 
+  Status status = options().threaded_segment_write
+                      ? QueueSegmentForWrite(segment.Pass())
+                      : WritePendingSegment(segment.get());
   if (!status.ok())
     return status;
 
@@ -193,6 +293,109 @@ Status MultiSegmentSegmenter::WriteSegment() {
   return Status::OK;
 }
 
+Status MultiSegmentSegmenter::WritePendingSegment(PendingSegment* segment) {
+  const bool append = segment->file_name.empty();
+  const std::string& file_name =
+      append ? options().output_file_name : segment->file_name;
+  File* file = File::Open(file_name.c_str(), append ? "a" : "w");
+  if (file == NULL) {
+    return Status(error::FILE_FAILURE,
+                  std::string("Cannot open file for ") +
+                      (append ? "append " : "write ") + file_name);
+  }
+
+  if (!append) {
+    // The segment is fully built, so its exact size is known; preallocating
+    // keeps per-segment files in few extents even when many channels write
+    // to the same filesystem concurrently.
+    const uint64_t size_hint =
+        options().segment_size_hint
+            ? options().segment_size_hint
+            : segment->header->Size() + segment->data->Size();
+    file->SetSizeHint(size_hint);
+  }
+
+  // Write the segment header boxes and the fragment data with one
+  // scatter/gather call.
+  std::vector<File::Region> regions;
+  if (segment->header->Size() > 0) {
+    File::Region region;
+    region.buffer = segment->header->Buffer();
+    region.length = segment->header->Size();
+    regions.push_back(region);
+  }
+  if (segment->data->Size() > 0) {
+    File::Region region;
+    region.buffer = segment->data->Buffer();
+    region.length = segment->data->Size();
+    regions.push_back(region);
+  }
+  Status status;
+  if (file->WriteVectored(regions.data(), regions.size()) < 0) {
+    status = Status(error::FILE_FAILURE,
+                    "Fail to write segment to file " + file_name);
+  } else {
+    segment->header->Clear();
+    segment->data->Clear();
+  }
+
+  if (!file->Close())
+    LOG(WARNING) << "Failed to close the file properly: " << file_name;
+  return status;
+}
+
+Status MultiSegmentSegmenter::QueueSegmentForWrite(
+    scoped_ptr<PendingSegment> segment) {
+  if (!writer_thread_) {
+    write_queue_.reset(new SpscQueue<PendingSegment*>(kMaxPendingSegments));
+    writer_thread_.reset(new ClosureThread(
+        "SegmentWriter",
+        base::Bind(&MultiSegmentSegmenter::WriteSegmentsTask,
+                   base::Unretained(this))));
+    writer_thread_->Start();
+  }
+  Status status = write_queue_->Push(segment.release());
+  // A stopped queue means the writer exited on error; report the writer
+  // status instead of the generic STOPPED.
+  if (status.error_code() == error::STOPPED && !write_status_.ok())
+    return write_status_;
+  return status;
+}
+
+void MultiSegmentSegmenter::WriteSegmentsTask() {
+  Status status;
+  while (status.ok()) {
+    PendingSegment* segment = NULL;
+    Status pop_status = write_queue_->Pop(&segment);
+    if (pop_status.error_code() == error::STOPPED)
+      break;
+    if (!pop_status.ok()) {
+      status = pop_status;
+      break;
+    }
+    scoped_ptr<PendingSegment> owned_segment(segment);
+    status = WritePendingSegment(owned_segment.get());
+  }
+  write_status_ = status;
+  // Unblock the muxer thread if we exit on error.
+  if (!status.ok())
+    write_queue_->Stop();
+}
+
+Status MultiSegmentSegmenter::StopSegmentWriter() {
+  if (!writer_thread_)
+    return Status::OK;
+  write_queue_->Stop();
+  writer_thread_->Join();
+  writer_thread_.reset();
+  // Free any segments left in the queue if the writer exited on error.
+  PendingSegment* segment = NULL;
+  while (write_queue_->TryPop(&segment))
+    delete segment;
+  write_queue_.reset();
+  return write_status_;
+}
+
 }  // namespace mp4
 }  // namespace media
 }  // namespace shaka
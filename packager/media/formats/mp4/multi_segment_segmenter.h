@@ -7,10 +7,18 @@
 #ifndef MEDIA_FORMATS_MP4_MULTI_SEGMENT_SEGMENTER_H_
 #define MEDIA_FORMATS_MP4_MULTI_SEGMENT_SEGMENTER_H_
 
+#include <string>
+
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/spsc_queue.h"
 #include "packager/media/formats/mp4/segmenter.h"
 
 namespace shaka {
 namespace media {
+
+class File;
+class SegmentNameTemplate;
+
 namespace mp4 {
 
 struct SegmentType;
@@ -27,7 +35,20 @@ struct SegmentType;
 /// and yet meet SAP requirements. The generated segments are written to files
 /// defined by @b MuxerOptions.segment_template if specified; otherwise,
 /// the segments are appended to the main output file specified by @b
-/// MuxerOptions.output_file_name.
+/// MuxerOptions.output_file_name. With @b MuxerOptions.chunked_fragments
+/// each completed fragment is written through to the in-progress segment
+/// file immediately instead of being buffered until the segment completes,
+/// enabling chunked-transfer delivery of the live edge; no 'sidx' box is
+/// emitted for chunked segments.
+///
+/// Segments are built strictly in delivery order: samples arrive as a push
+/// stream from the demuxer, and per-segment metadata (moof sequence numbers,
+/// tfdt decode times, the accumulated sidx) depends on everything muxed
+/// before it, so disjoint segments cannot be packaged concurrently. The
+/// concurrency in this path comes from overlapping stages instead: sample
+/// encryption runs on a worker pool (see EncryptingFragmenter) and finished
+/// segments are written out on a dedicated thread while the next segment is
+/// built (see QueueSegmentForWrite()).
 class MultiSegmentSegmenter : public Segmenter {
  public:
   MultiSegmentSegmenter(const MuxerOptions& options,
@@ -42,16 +63,60 @@ class MultiSegmentSegmenter : public Segmenter {
   /// @}
 
  private:
+  // A fully built segment waiting to be written out.
+  struct PendingSegment {
+    // Empty if the segment is appended to the main output file.
+    std::string file_name;
+    // Segment header boxes (styp/sidx), followed by the fragment data.
+    scoped_ptr<BufferWriter> header;
+    scoped_ptr<BufferWriter> data;
+  };
+
   // Segmenter implementation overrides.
   Status DoInitialize() override;
   Status DoFinalize() override;
   Status DoFinalizeSegment() override;
+  Status DoWriteFragment() override;
 
   // Write segment to file.
   Status WriteSegment();
 
+  // Write the completed fragment in fragment_buffer() through to the
+  // in-progress segment file, opening the file and emitting 'styp' on the
+  // first fragment of the segment. Used in chunked_fragments mode so the
+  // origin can serve the growing segment via chunked transfer.
+  Status WriteChunk();
+  // Close the segment file built up by WriteChunk() and fire segment events.
+  Status FinalizeChunkedSegment();
+
+  // Write |segment| to its destination file. Consumes the segment buffers.
+  Status WritePendingSegment(PendingSegment* segment);
+  // Hand |segment| over to the writer thread, starting the thread on first
+  // use. Used when MuxerOptions::threaded_segment_write is set, so the next
+  // segment can be built while this one is written out.
+  Status QueueSegmentForWrite(scoped_ptr<PendingSegment> segment);
+  // Writer thread body: writes queued segments until the queue is stopped or
+  // a write fails.
+  void WriteSegmentsTask();
+  // Stop the writer thread, if started, and return its final status.
+  Status StopSegmentWriter();
+
+  // Returns the precompiled form of |options().segment_template|, compiling
+  // it on first use.
+  SegmentNameTemplate* segment_name_template();
+
   scoped_ptr<SegmentType> styp_;
   uint32_t num_segments_;
+  scoped_ptr<SegmentNameTemplate> segment_name_template_;
+  // In-progress segment in chunked_fragments mode; NULL between segments.
+  File* chunked_segment_file_;
+  std::string chunked_segment_file_name_;
+  uint64_t chunked_segment_size_;
+  // Segment writer pipeline, created on first use in threaded write mode.
+  scoped_ptr<SpscQueue<PendingSegment*> > write_queue_;
+  scoped_ptr<ClosureThread> writer_thread_;
+  // Written by the writer thread before it exits; read after Join.
+  Status write_status_;
 
   DISALLOW_COPY_AND_ASSIGN(MultiSegmentSegmenter);
 };
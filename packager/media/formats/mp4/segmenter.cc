@@ -177,7 +177,9 @@ Status Segmenter::Initialize(const std::vector<MediaStream*>& streams,
 
   moof_->tracks.resize(streams.size());
   segment_durations_.resize(streams.size());
+  segment_sizes_.resize(streams.size());
   fragmenters_.resize(streams.size());
+  next_cue_points_.resize(streams.size());
   const bool key_rotation_enabled = crypto_period_duration_in_seconds != 0;
   const bool kInitialEncryptionInfo = true;
 
@@ -188,6 +190,19 @@ Status Segmenter::Initialize(const std::vector<MediaStream*>& streams,
       // Use the first video stream as the reference stream (which is 1-based).
       if (sidx_->reference_id == 0)
         sidx_->reference_id = i + 1;
+      // Seed the default sample duration from codec-level timing when the
+      // parser supplied it, so the duration is known from the first sample
+      // on instead of being backfilled from the first frame delta.
+      const uint32_t nominal_sample_duration =
+          static_cast<const VideoStreamInfo*>(streams[i]->info().get())
+              ->nominal_sample_duration();
+      if (nominal_sample_duration > 0) {
+        if (moov_->extends.tracks[i].default_sample_duration == 0)
+          moov_->extends.tracks[i].default_sample_duration =
+              nominal_sample_duration;
+        if (sample_duration_ == 0)
+          sample_duration_ = nominal_sample_duration;
+      }
     }
     if (!encryption_key_source) {
       fragmenters_[i] = new Fragmenter(streams[i]->info(), &moof_->tracks[i]);
@@ -292,7 +307,10 @@ Status Segmenter::Initialize(const std::vector<MediaStream*>& streams,
   return DoInitialize();
 }
 
-Status Segmenter::Finalize() {
+Status Segmenter::Flush() {
+  // Finalize the in-progress fragment on every stream. FinalizeFragment
+  // writes the fragment and finalizes the segment once all the fragments are
+  // finalized, i.e. on the last iteration.
   for (std::vector<Fragmenter*>::iterator it = fragmenters_.begin();
        it != fragmenters_.end();
        ++it) {
@@ -300,6 +318,13 @@ Status Segmenter::Finalize() {
     if (!status.ok())
       return status;
   }
+  return Status::OK;
+}
+
+Status Segmenter::Finalize() {
+  Status status = Flush();
+  if (!status.ok())
+    return status;
 
   // Set tracks and moov durations.
   // Note that the updated moov box will be written to output file for VOD case
@@ -319,7 +344,7 @@ Status Segmenter::Finalize() {
 }
 
 Status Segmenter::AddSample(const MediaStream* stream,
-                            scoped_refptr<MediaSample> sample) {
+                            const scoped_refptr<MediaSample>& sample) {
   // Find the fragmenter for this stream.
   DCHECK(stream);
   DCHECK(stream_map_.find(stream) != stream_map_.end());
@@ -337,21 +362,57 @@ Status Segmenter::AddSample(const MediaStream* stream,
                   "Current fragment is finalized already.");
   }
 
+  // Audio may batch into longer fragments than video: its samples are tiny
+  // relative to the per-fragment moof overhead, and segment boundaries
+  // below still cut audio fragments short so streams stay aligned at
+  // segment granularity.
+  const double target_fragment_duration =
+      (stream->info()->stream_type() == kStreamAudio &&
+       options_.audio_fragment_duration > 0)
+          ? options_.audio_fragment_duration
+          : options_.fragment_duration;
+
   bool finalize_fragment = false;
   if (fragmenter->fragment_duration() >=
-      options_.fragment_duration * stream->info()->time_scale()) {
+      target_fragment_duration * stream->info()->time_scale()) {
     if (sample->is_key_frame() || !options_.fragment_sap_aligned) {
       finalize_fragment = true;
     }
   }
   bool finalize_segment = false;
-  if (segment_durations_[stream_id] >=
-      options_.segment_duration * stream->info()->time_scale()) {
+  bool passed_segment_target = false;
+  if (options_.segment_target_size_bytes > 0) {
+    // Byte-budget mode: cut once the accumulated sample bytes reach the
+    // target, bounded below by segment_min_duration_seconds; the regular
+    // duration check below then acts as the upper bound.
+    passed_segment_target =
+        segment_sizes_[stream_id] >= options_.segment_target_size_bytes &&
+        segment_durations_[stream_id] >=
+            options_.segment_min_duration_seconds *
+                stream->info()->time_scale();
+  }
+  if (passed_segment_target ||
+      segment_durations_[stream_id] >=
+          options_.GetEffectiveSegmentDuration() *
+              stream->info()->time_scale()) {
     if (sample->is_key_frame() || !options_.segment_sap_aligned) {
       finalize_segment = true;
       finalize_fragment = true;
     }
   }
+  // Ad cue points force a segment boundary at the splice point, so ad
+  // periods can be stitched in on segment boundaries without restarting
+  // the pipeline.
+  const std::vector<double>& cue_points = options_.ad_cue_points_seconds;
+  if (next_cue_points_[stream_id] < cue_points.size() &&
+      static_cast<double>(sample->pts()) / stream->info()->time_scale() >=
+          cue_points[next_cue_points_[stream_id]]) {
+    if (sample->is_key_frame() || !options_.segment_sap_aligned) {
+      ++next_cue_points_[stream_id];
+      finalize_segment = true;
+      finalize_fragment = true;
+    }
+  }
 
   Status status;
   if (finalize_fragment) {
@@ -368,6 +429,7 @@ Status Segmenter::AddSample(const MediaStream* stream,
     sample_duration_ = sample->duration();
   moov_->tracks[stream_id].media.header.duration += sample->duration();
   segment_durations_[stream_id] += sample->duration();
+  segment_sizes_[stream_id] += sample->data_size();
   DCHECK_GE(segment_durations_[stream_id], fragmenter->fragment_duration());
   return Status::OK;
 }
@@ -414,6 +476,8 @@ Status Segmenter::FinalizeSegment() {
   std::vector<uint64_t>::iterator it = segment_durations_.begin();
   for (; it != segment_durations_.end(); ++it)
     *it = 0;
+  for (it = segment_sizes_.begin(); it != segment_sizes_.end(); ++it)
+    *it = 0;
 
   return status;
 }
@@ -456,7 +520,7 @@ Status Segmenter::FinalizeFragment(bool finalize_segment,
           sizeof(uint32_t);  // for sample count field in 'senc'
     }
     traf.runs[0].data_offset = data_offset + mdat.data_size;
-    mdat.data_size += fragmenters_[i]->data()->Size();
+    mdat.data_size += fragmenters_[i]->data_size();
   }
 
   // Generate segment reference.
@@ -466,21 +530,33 @@ Status Segmenter::FinalizeFragment(bool finalize_segment,
   sidx_->references[sidx_->references.size() - 1].referenced_size =
       data_offset + mdat.data_size;
 
-  // Write the fragment to buffer.
-  moof_->Write(fragment_buffer_.get());
+  // Write the fragment to buffer. Box sizes have already been computed above
+  // and only fixed-width offset fields were updated since, so skip the second
+  // box tree walk that Write performs.
+  moof_->WriteWithCachedSize(fragment_buffer_.get());
   mdat.WriteHeader(fragment_buffer_.get());
-  for (Fragmenter* fragmenter : fragmenters_)
-    fragment_buffer_->AppendBuffer(*fragmenter->data());
+  for (Fragmenter* fragmenter : fragmenters_) {
+    for (const scoped_refptr<MediaSample>& sample : fragmenter->samples())
+      fragment_buffer_->AppendArray(sample->data(), sample->data_size());
+  }
 
   // Increase sequence_number for next fragment.
   ++moof_->header.sequence_number;
 
+  Status status = DoWriteFragment();
+  if (!status.ok())
+    return status;
+
   if (finalize_segment)
     return FinalizeSegment();
 
   return Status::OK;
 }
 
+Status Segmenter::DoWriteFragment() {
+  return Status::OK;
+}
+
 }  // namespace mp4
 }  // namespace media
 }  // namespace shaka
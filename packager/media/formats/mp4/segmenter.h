@@ -71,6 +71,12 @@ class Segmenter {
                     double crypto_period_duration_in_seconds,
                     FourCC protection_scheme);
 
+  /// Flush the in-progress fragment on every stream and write out the
+  /// current segment, without finalizing the segmenter. Used to bound
+  /// end-of-stream latency; more samples may be added afterwards.
+  /// @return OK on success, an error status otherwise.
+  Status Flush();
+
   /// Finalize the segmenter.
   /// @return OK on success, an error status otherwise.
   Status Finalize();
@@ -81,7 +87,7 @@ class Segmenter {
   /// @param sample points to the sample to be added.
   /// @return OK on success, an error status otherwise.
   Status AddSample(const MediaStream* stream,
-                   scoped_refptr<MediaSample> sample);
+                   const scoped_refptr<MediaSample>& sample);
 
   /// @return true if there is an initialization range, while setting @a offset
   ///         and @a size; or false if initialization range does not apply.
@@ -122,6 +128,11 @@ class Segmenter {
   virtual Status DoInitialize() = 0;
   virtual Status DoFinalize() = 0;
   virtual Status DoFinalizeSegment() = 0;
+  // Called after a completed fragment, i.e. a moof/mdat pair, has been
+  // appended to |fragment_buffer_|. Subclasses may write the fragment
+  // through to the output for low-latency chunked delivery; the default
+  // implementation keeps buffering until the segment is finalized.
+  virtual Status DoWriteFragment();
 
   Status FinalizeSegment();
   uint32_t GetReferenceStreamId();
@@ -136,6 +147,12 @@ class Segmenter {
   scoped_ptr<SegmentIndex> sidx_;
   std::vector<Fragmenter*> fragmenters_;
   std::vector<uint64_t> segment_durations_;
+  // Per-stream sample bytes accumulated in the current segment, used for
+  // byte-budget segmentation (MuxerOptions::segment_target_size_bytes).
+  std::vector<uint64_t> segment_sizes_;
+  // Per-stream index of the next ad cue point in
+  // MuxerOptions::ad_cue_points_seconds to cut a segment at.
+  std::vector<size_t> next_cue_points_;
   std::map<const MediaStream*, uint32_t> stream_map_;
   bool end_of_segment_;
   MuxerListener* muxer_listener_;
@@ -10,6 +10,8 @@
 #include <openssl/err.h>
 #include <openssl/rand.h>
 
+#include <gflags/gflags.h>
+
 #include "packager/base/files/file_util.h"
 #include "packager/base/strings/stringprintf.h"
 #include "packager/base/threading/platform_thread.h"
@@ -22,10 +24,37 @@
 #include "packager/media/file/file.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 
+DEFINE_bool(mp4_reserve_header_space,
+            false,
+            "Reserve space for the moov and sidx boxes at the beginning of "
+            "the single-segment output file and write media data directly "
+            "after it, instead of staging all media data in a temporary file "
+            "and copying it over once the header is written. Falls back to "
+            "the temporary-file copy if the header outgrows the reserved "
+            "space.");
+DEFINE_double(mp4_sidx_seconds_per_reference,
+              0,
+              "Coarse sidx granularity for single-segment output: merge "
+              "consecutive subsegments into one sidx reference until it "
+              "spans at least this many seconds. Clients download and parse "
+              "the whole index before the first seek, so long titles start "
+              "measurably faster with a coarse index, at the cost of seek "
+              "granularity. 0 keeps one reference per subsegment.");
+
 namespace shaka {
 namespace media {
 namespace mp4 {
 namespace {
+// Size of a 'free' box header: 32-bit size plus fourcc.
+const uint64_t kFreeBoxHeaderSize = 8;
+// Serialized size of a version 0 'sidx' box without references.
+const uint64_t kSidxBoxFixedSize = 32;
+// Serialized size of one 'sidx' segment reference.
+const uint64_t kSidxReferenceSize = 12;
+// Extra bytes reserved for boxes that can still grow between initialization
+// and finalization, e.g. durations spilling into 64-bit box versions.
+const uint64_t kReservedHeaderSlack = 4096;
+
 // Create a temp file name using process/thread id and current time.
 std::string TempFileName() {
   int32_t tid = static_cast<int32_t>(base::PlatformThread::CurrentId());
@@ -42,9 +71,11 @@ std::string TempFileName() {
 SingleSegmentSegmenter::SingleSegmentSegmenter(const MuxerOptions& options,
                                                scoped_ptr<FileType> ftyp,
                                                scoped_ptr<Movie> moov)
-    : Segmenter(options, ftyp.Pass(), moov.Pass()) {}
+    : Segmenter(options, ftyp.Pass(), moov.Pass()), reserved_header_size_(0) {}
 
 SingleSegmentSegmenter::~SingleSegmentSegmenter() {
+  if (output_file_)
+    output_file_.release()->Close();
   if (temp_file_)
     temp_file_.release()->Close();
   if (!temp_file_name_.empty()) {
@@ -69,6 +100,23 @@ bool SingleSegmentSegmenter::GetIndexRange(size_t* offset, size_t* size) {
 }
 
 Status SingleSegmentSegmenter::DoInitialize() {
+  if (FLAGS_mp4_reserve_header_space) {
+    // Media data goes straight into the output file after a reserved header
+    // region, so there is no second copy stage and no temp file unless the
+    // reservation overflows.
+    reserved_header_size_ = EstimateReservedHeaderSize();
+    output_file_.reset(File::Open(options().output_file_name.c_str(), "w+"));
+    if (!output_file_) {
+      return Status(error::FILE_FAILURE,
+                    "Cannot open file to write " + options().output_file_name);
+    }
+    if (!output_file_->Seek(reserved_header_size_)) {
+      return Status(error::FILE_FAILURE,
+                    "Cannot seek in file " + options().output_file_name);
+    }
+    return Status::OK;
+  }
+
   // Single segment segmentation involves two stages:
   //   Stage 1: Create media subsegments from media samples
   //   Stage 2: Update media header (moov) which involves copying of media
@@ -77,6 +125,10 @@ Status SingleSegmentSegmenter::DoInitialize() {
   // progress_target was set for stage 1. Times two to account for stage 2.
   set_progress_target(progress_target() * 2);
 
+  return OpenTempFile();
+}
+
+Status SingleSegmentSegmenter::OpenTempFile() {
   if (options().temp_dir.empty()) {
     base::FilePath temp_file_path;
     if (!base::CreateTemporaryFile(&temp_file_path)) {
@@ -95,12 +147,113 @@ Status SingleSegmentSegmenter::DoInitialize() {
                       "Cannot open file to write " + temp_file_name_);
 }
 
+uint64_t SingleSegmentSegmenter::EstimateReservedHeaderSize() {
+  // ftyp and moov are fully built at this point; only a bounded number of
+  // bytes can still be added at finalization, which the slack covers. sidx
+  // grows by one reference per subsegment, estimated from the stream duration
+  // and the segment cadence.
+  uint64_t estimated_references = 1;
+  const uint32_t timescale = GetReferenceTimeScale();
+  const double seconds_per_reference =
+      std::max(options().segment_duration, FLAGS_mp4_sidx_seconds_per_reference);
+  if (timescale > 0 && seconds_per_reference > 0) {
+    const double duration_in_seconds =
+        static_cast<double>(progress_target()) / timescale;
+    estimated_references +=
+        static_cast<uint64_t>(duration_in_seconds / seconds_per_reference) + 1;
+  }
+  return ftyp()->ComputeSize() + moov()->ComputeSize() + kSidxBoxFixedSize +
+         kSidxReferenceSize * estimated_references + kReservedHeaderSlack;
+}
+
+Status SingleSegmentSegmenter::CopyFragmentsToTempFile() {
+  Status status = OpenTempFile();
+  if (!status.ok())
+    return status;
+  if (!output_file_->Seek(reserved_header_size_)) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot seek in file " + options().output_file_name);
+  }
+
+  const int kBufSize = 0x200000;  // 2MB.
+  scoped_ptr<uint8_t[]> buf(new uint8_t[kBufSize]);
+  while (true) {
+    int64_t size = output_file_->Read(buf.get(), kBufSize);
+    if (size == 0) {
+      break;
+    } else if (size < 0) {
+      return Status(error::FILE_FAILURE,
+                    "Failed to read file " + options().output_file_name);
+    }
+    int64_t size_written = temp_file_->Write(buf.get(), size);
+    if (size_written != size) {
+      return Status(error::FILE_FAILURE,
+                    "Failed to write file " + temp_file_name_);
+    }
+  }
+  if (!output_file_.release()->Close()) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot close the file " + options().output_file_name);
+  }
+  return Status::OK;
+}
+
 Status SingleSegmentSegmenter::DoFinalize() {
-  DCHECK(temp_file_);
   DCHECK(ftyp());
   DCHECK(moov());
   DCHECK(vod_sidx_);
 
+  if (output_file_) {
+    const uint64_t header_size = ftyp()->ComputeSize() +
+                                 moov()->ComputeSize() +
+                                 vod_sidx_->ComputeSize();
+    const uint64_t free_size = header_size <= reserved_header_size_
+                                   ? reserved_header_size_ - header_size
+                                   : 0;
+    // A non-empty remainder has to hold at least a 'free' box header.
+    if (header_size <= reserved_header_size_ &&
+        (free_size == 0 || free_size >= kFreeBoxHeaderSize)) {
+      // sidx offsets are relative to the end of the box; point the first
+      // fragment past the padding. The padding is far smaller than 4GB, so
+      // this does not change the box version or size.
+      vod_sidx_->first_offset = free_size;
+
+      BufferWriter buffer;
+      ftyp()->Write(&buffer);
+      moov()->Write(&buffer);
+      vod_sidx_->Write(&buffer);
+      if (free_size > 0) {
+        buffer.AppendInt(static_cast<uint32_t>(free_size));
+        buffer.AppendInt(static_cast<uint32_t>(FOURCC_free));
+        buffer.AppendVector(
+            std::vector<uint8_t>(free_size - kFreeBoxHeaderSize, 0));
+      }
+      if (!output_file_->Seek(0)) {
+        return Status(error::FILE_FAILURE,
+                      "Cannot seek in file " + options().output_file_name);
+      }
+      Status status = buffer.WriteToFile(output_file_.get());
+      if (!status.ok())
+        return status;
+      if (!output_file_.release()->Close()) {
+        return Status(error::FILE_FAILURE,
+                      "Cannot close the file " + options().output_file_name);
+      }
+      SetComplete();
+      return Status::OK;
+    }
+
+    LOG(WARNING) << "Reserved header space (" << reserved_header_size_
+                 << " bytes) cannot hold the header (" << header_size
+                 << " bytes); falling back to rewriting the output file.";
+    vod_sidx_->first_offset = 0;
+    Status status = CopyFragmentsToTempFile();
+    if (!status.ok())
+      return status;
+  }
+
+  DCHECK(temp_file_);
+
   // Close the temp file to prepare for reading later.
   if (!temp_file_.release()->Close()) {
     return Status(error::FILE_FAILURE,
@@ -216,11 +369,37 @@ Status SingleSegmentSegmenter::DoFinalizeSegment() {
     // Force earliest_presentation_time to start from 0 for VOD.
     vod_sidx_->earliest_presentation_time = 0;
   }
-  vod_sidx_->references.push_back(vod_ref);
+  // With coarse indexing enabled, fold this subsegment into the previous
+  // reference until that reference spans the configured duration. Subsegments
+  // are finalized in presentation order, so the previous reference's earliest
+  // presentation time never moves.
+  SegmentReference* last_ref =
+      vod_sidx_->references.empty() ? NULL : &vod_sidx_->references.back();
+  if (FLAGS_mp4_sidx_seconds_per_reference > 0 && last_ref != NULL &&
+      static_cast<double>(last_ref->subsegment_duration) /
+              vod_sidx_->timescale <
+          FLAGS_mp4_sidx_seconds_per_reference) {
+    last_ref->referenced_size += vod_ref.referenced_size;
+    last_ref->subsegment_duration += vod_ref.subsegment_duration;
+    last_ref->earliest_presentation_time =
+        std::min(last_ref->earliest_presentation_time,
+                 vod_ref.earliest_presentation_time);
+    if (last_ref->sap_type == SegmentReference::TypeUnknown &&
+        vod_ref.sap_type != SegmentReference::TypeUnknown) {
+      last_ref->sap_type = vod_ref.sap_type;
+      last_ref->sap_delta_time = vod_ref.sap_delta_time +
+                                 vod_ref.earliest_presentation_time -
+                                 last_ref->earliest_presentation_time;
+    }
+  } else {
+    vod_sidx_->references.push_back(vod_ref);
+  }
 
-  // Append fragment buffer to temp file.
+  // Append fragment buffer to the output file directly in reserved-header
+  // mode, to the temp file otherwise.
   size_t segment_size = fragment_buffer()->Size();
-  Status status = fragment_buffer()->WriteToFile(temp_file_.get());
+  Status status = fragment_buffer()->WriteToFile(
+      output_file_ ? output_file_.get() : temp_file_.get());
   if (!status.ok()) return status;
 
   UpdateProgress(vod_ref.subsegment_duration);
@@ -44,9 +44,25 @@ class SingleSegmentSegmenter : public Segmenter {
   Status DoFinalize() override;
   Status DoFinalizeSegment() override;
 
+  // Creates and opens the temporary file that media data is staged in before
+  // the header is known.
+  Status OpenTempFile();
+  // Estimates how many bytes to reserve for ftyp, moov, sidx and padding at
+  // the head of the output file.
+  uint64_t EstimateReservedHeaderSize();
+  // Copies media data written after the reserved header region into the temp
+  // file and closes the output file, so the copy-based finalization can
+  // rewrite the file. Used when the header outgrows the reserved region.
+  Status CopyFragmentsToTempFile();
+
   scoped_ptr<SegmentIndex> vod_sidx_;
   std::string temp_file_name_;
   scoped_ptr<File, FileCloser> temp_file_;
+  // Only set in reserved-header mode: media data is written directly to the
+  // output file after a reserved header region of |reserved_header_size_|
+  // bytes, which is patched with the real header on finalization.
+  scoped_ptr<File, FileCloser> output_file_;
+  uint64_t reserved_header_size_;
 
   DISALLOW_COPY_AND_ASSIGN(SingleSegmentSegmenter);
 };
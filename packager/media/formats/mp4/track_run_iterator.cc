@@ -23,16 +23,28 @@ namespace shaka {
 namespace media {
 namespace mp4 {
 
-struct SampleInfo {
-  int64_t size;
-  int64_t duration;
-  int64_t cts_offset;
-  bool is_keyframe;
+// Per-sample fields of a run, stored as one column per field rather than an
+// array of structs. Large VOD movies carry hundreds of thousands of samples,
+// so the columnar layout keeps memory down (keyframe flags pack to bits) and
+// the advance loop walks small contiguous arrays.
+struct SampleTable {
+  std::vector<uint32_t> sizes;
+  std::vector<uint32_t> durations;
+  std::vector<int64_t> cts_offsets;
+  std::vector<bool> is_keyframe;
+
+  size_t size() const { return sizes.size(); }
+  void resize(size_t count) {
+    sizes.resize(count);
+    durations.resize(count);
+    cts_offsets.resize(count);
+    is_keyframe.resize(count);
+  }
 };
 
 struct TrackRunInfo {
   uint32_t track_id;
-  std::vector<SampleInfo> samples;
+  SampleTable samples;
   int64_t timescale;
   int64_t start_dts;
   int64_t sample_start_offset;
@@ -70,7 +82,7 @@ TrackRunInfo::TrackRunInfo()
 TrackRunInfo::~TrackRunInfo() {}
 
 TrackRunIterator::TrackRunIterator(const Movie* moov)
-    : moov_(moov), sample_dts_(0), sample_offset_(0) {
+    : moov_(moov), sample_index_(0), sample_dts_(0), sample_offset_(0) {
   CHECK(moov);
 }
 
@@ -80,27 +92,27 @@ static void PopulateSampleInfo(const TrackExtends& trex,
                                const TrackFragmentHeader& tfhd,
                                const TrackFragmentRun& trun,
                                const uint32_t i,
-                               SampleInfo* sample_info) {
+                               SampleTable* samples) {
   if (i < trun.sample_sizes.size()) {
-    sample_info->size = trun.sample_sizes[i];
+    samples->sizes[i] = trun.sample_sizes[i];
   } else if (tfhd.default_sample_size > 0) {
-    sample_info->size = tfhd.default_sample_size;
+    samples->sizes[i] = tfhd.default_sample_size;
   } else {
-    sample_info->size = trex.default_sample_size;
+    samples->sizes[i] = trex.default_sample_size;
   }
 
   if (i < trun.sample_durations.size()) {
-    sample_info->duration = trun.sample_durations[i];
+    samples->durations[i] = trun.sample_durations[i];
   } else if (tfhd.default_sample_duration > 0) {
-    sample_info->duration = tfhd.default_sample_duration;
+    samples->durations[i] = tfhd.default_sample_duration;
   } else {
-    sample_info->duration = trex.default_sample_duration;
+    samples->durations[i] = trex.default_sample_duration;
   }
 
   if (i < trun.sample_composition_time_offsets.size()) {
-    sample_info->cts_offset = trun.sample_composition_time_offsets[i];
+    samples->cts_offsets[i] = trun.sample_composition_time_offsets[i];
   } else {
-    sample_info->cts_offset = 0;
+    samples->cts_offsets[i] = 0;
   }
 
   uint32_t flags;
@@ -111,7 +123,7 @@ static void PopulateSampleInfo(const TrackExtends& trex,
   } else {
     flags = trex.default_sample_flags;
   }
-  sample_info->is_keyframe = !(flags & TrackFragmentHeader::kNonKeySampleMask);
+  samples->is_keyframe[i] = !(flags & TrackFragmentHeader::kNonKeySampleMask);
 }
 
 // In well-structured encrypted media, each track run will be immediately
@@ -203,11 +215,17 @@ bool TrackRunIterator::Init() {
       RCHECK(chunk_info.IsValid());
     }
 
+    // One run is appended per chunk; reserve them up front so large
+    // unfragmented files do not regrow the run table repeatedly.
+    runs_.reserve(runs_.size() + num_chunks);
+
     uint32_t sample_index = 0;
     for (uint32_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
       RCHECK(chunk_info.current_chunk() == chunk_index + 1);
 
-      TrackRunInfo tri;
+      // Build the run in place to avoid copying the per-chunk sample table.
+      runs_.push_back(TrackRunInfo());
+      TrackRunInfo& tri = runs_.back();
       tri.track_id = trak->header.track_id;
       tri.timescale = trak->media.header.timescale;
       tri.start_dts = run_start_dts;
@@ -239,16 +257,15 @@ bool TrackRunIterator::Init() {
       uint32_t samples_per_chunk = chunk_info.samples_per_chunk();
       tri.samples.resize(samples_per_chunk);
       for (uint32_t k = 0; k < samples_per_chunk; ++k) {
-        SampleInfo& sample = tri.samples[k];
-        sample.size = sample_size.sample_size != 0
-                          ? sample_size.sample_size
-                          : sample_size.sizes[sample_index];
-        sample.duration = decoding_time.sample_delta();
-        sample.cts_offset =
+        tri.samples.sizes[k] = sample_size.sample_size != 0
+                                   ? sample_size.sample_size
+                                   : sample_size.sizes[sample_index];
+        tri.samples.durations[k] = decoding_time.sample_delta();
+        tri.samples.cts_offsets[k] =
             has_composition_offset ? composition_offset.sample_offset() : 0;
-        sample.is_keyframe = sync_sample.IsSyncSample();
+        tri.samples.is_keyframe[k] = sync_sample.IsSyncSample();
 
-        run_start_dts += sample.duration;
+        run_start_dts += tri.samples.durations[k];
 
         // Advance to next sample. Should success except for last sample.
         ++sample_index;
@@ -265,8 +282,6 @@ bool TrackRunIterator::Init() {
             RCHECK(composition_offset.AdvanceSample());
         }
       }
-
-      runs_.push_back(tri);
     }
   }
 
@@ -410,8 +425,8 @@ bool TrackRunIterator::Init(const MovieFragment& moof) {
 
       tri.samples.resize(trun.sample_count);
       for (size_t k = 0; k < trun.sample_count; k++) {
-        PopulateSampleInfo(*trex, traf.header, trun, k, &tri.samples[k]);
-        run_start_dts += tri.samples[k].duration;
+        PopulateSampleInfo(*trex, traf.header, trun, k, &tri.samples);
+        run_start_dts += tri.samples.durations[k];
       }
       runs_.push_back(tri);
       sample_count_sum += trun.sample_count;
@@ -435,14 +450,14 @@ void TrackRunIterator::ResetRun() {
     return;
   sample_dts_ = run_itr_->start_dts;
   sample_offset_ = run_itr_->sample_start_offset;
-  sample_itr_ = run_itr_->samples.begin();
+  sample_index_ = 0;
 }
 
 void TrackRunIterator::AdvanceSample() {
   DCHECK(IsSampleValid());
-  sample_dts_ += sample_itr_->duration;
-  sample_offset_ += sample_itr_->size;
-  ++sample_itr_;
+  sample_dts_ += run_itr_->samples.durations[sample_index_];
+  sample_offset_ += run_itr_->samples.sizes[sample_index_];
+  ++sample_index_;
 }
 
 // This implementation only indicates a need for caching if CENC auxiliary
@@ -481,7 +496,7 @@ bool TrackRunIterator::CacheAuxInfo(const uint8_t* buf, int buf_size) {
 bool TrackRunIterator::IsRunValid() const { return run_itr_ != runs_.end(); }
 
 bool TrackRunIterator::IsSampleValid() const {
-  return IsRunValid() && (sample_itr_ != run_itr_->samples.end());
+  return IsRunValid() && (sample_index_ < run_itr_->samples.size());
 }
 
 // Because tracks are in sorted order and auxiliary information is cached when
@@ -558,7 +573,7 @@ int64_t TrackRunIterator::sample_offset() const {
 
 int TrackRunIterator::sample_size() const {
   DCHECK(IsSampleValid());
-  return sample_itr_->size;
+  return run_itr_->samples.sizes[sample_index_];
 }
 
 int64_t TrackRunIterator::dts() const {
@@ -568,17 +583,17 @@ int64_t TrackRunIterator::dts() const {
 
 int64_t TrackRunIterator::cts() const {
   DCHECK(IsSampleValid());
-  return sample_dts_ + sample_itr_->cts_offset;
+  return sample_dts_ + run_itr_->samples.cts_offsets[sample_index_];
 }
 
 int64_t TrackRunIterator::duration() const {
   DCHECK(IsSampleValid());
-  return sample_itr_->duration;
+  return run_itr_->samples.durations[sample_index_];
 }
 
 bool TrackRunIterator::is_keyframe() const {
   DCHECK(IsSampleValid());
-  return sample_itr_->is_keyframe;
+  return run_itr_->samples.is_keyframe[sample_index_];
 }
 
 const TrackEncryption& TrackRunIterator::track_encryption() const {
@@ -589,7 +604,7 @@ const TrackEncryption& TrackRunIterator::track_encryption() const {
 }
 
 scoped_ptr<DecryptConfig> TrackRunIterator::GetDecryptConfig() {
-  size_t sample_idx = sample_itr_ - run_itr_->samples.begin();
+  size_t sample_idx = sample_index_;
   DCHECK_LT(sample_idx, run_itr_->sample_encryption_entries.size());
   const SampleEncryptionEntry& sample_encryption_entry =
       run_itr_->sample_encryption_entries[sample_idx];
@@ -17,7 +17,6 @@ class DecryptConfig;
 
 namespace mp4 {
 
-struct SampleInfo;
 struct TrackRunInfo;
 
 class TrackRunIterator {
@@ -108,7 +107,8 @@ class TrackRunIterator {
 
   std::vector<TrackRunInfo> runs_;
   std::vector<TrackRunInfo>::const_iterator run_itr_;
-  std::vector<SampleInfo>::const_iterator sample_itr_;
+  // Index of the current sample in the current run's sample table.
+  size_t sample_index_;
 
   // Track the start dts of the next segment, only useful if decode_time box is
   // absent.
@@ -5,12 +5,15 @@
 #include "packager/media/formats/webm/single_segment_segmenter.h"
 #include "packager/media/formats/webm/two_pass_single_segment_segmenter.h"
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/fixed_key_source.h"
 #include "packager/media/formats/webm/segmenter_test_base.h"
 
+DECLARE_int32(webm_encryption_threads);
+
 namespace shaka {
 namespace media {
 namespace {
@@ -227,6 +230,26 @@ TEST_F(EncrypedSegmenterTest, BasicSupport) {
   ASSERT_FILE_EQ(OutputFileName().c_str(), kBasicSupportData);
 }
 
+// Parallel encryption derives the per-frame IVs up front, so the output must
+// be byte-identical to the serial output.
+TEST_F(EncrypedSegmenterTest, ParallelEncryptionMatchesSerialOutput) {
+  FLAGS_webm_encryption_threads = 2;
+
+  MuxerOptions options = CreateMuxerOptions();
+  ASSERT_NO_FATAL_FAILURE(InitializeSegmenter(options));
+
+  // Write the samples to the Segmenter.
+  for (int i = 0; i < 5; i++) {
+    scoped_refptr<MediaSample> sample =
+        CreateSample(kKeyFrame, kDuration, kNoSideData);
+    ASSERT_OK(segmenter_->AddSample(sample));
+  }
+  ASSERT_OK(segmenter_->Finalize());
+
+  ASSERT_FILE_EQ(OutputFileName().c_str(), kBasicSupportData);
+  FLAGS_webm_encryption_threads = 1;
+}
+
 }  // namespace media
 }  // namespace shaka
 
@@ -6,10 +6,25 @@
 
 #include "packager/media/formats/webm/encryptor.h"
 
+#include <gflags/gflags.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/threading/worker_pool.h"
 #include "packager/media/base/aes_encryptor.h"
+#include "packager/media/base/cipher_engine.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/media_sample.h"
 
+DEFINE_int32(webm_encryption_threads,
+             1,
+             "Number of worker threads used to encrypt WebM frames. With "
+             "more than one thread, frames are encrypted concurrently on the "
+             "worker pool and written to the Cluster in order. Only applies "
+             "when the per-frame IVs can be derived up front, i.e. 8-byte "
+             "IVs; other streams are encrypted serially.");
+
 namespace shaka {
 namespace media {
 namespace webm {
@@ -46,11 +61,40 @@ Status CreateContentEncryption(mkvmuxer::Track* track, EncryptionKey* key) {
   return Status::OK;
 }
 
+// Composes | 1 | iv | enc_data | in a single buffer and hands it to |sample|,
+// so the frame needs neither a resize of the existing payload nor a memmove
+// to make room for the prefix.
+bool EncryptSampleData(AesCryptor* encryptor, MediaSample* sample) {
+  const std::vector<uint8_t>& iv = encryptor->iv();
+  std::vector<uint8_t> buffer(1 + iv.size() + sample->data_size());
+  buffer[0] = 0x01;
+  memcpy(&buffer[1], iv.data(), iv.size());
+  if (!encryptor->Crypt(sample->data(), sample->data_size(),
+                        &buffer[1 + iv.size()])) {
+    return false;
+  }
+  sample->transfer_data(&buffer);
+  return true;
+}
+
 }  // namespace
 
-Encryptor::Encryptor() {}
+Encryptor::Encryptor() : can_encrypt_in_parallel_(false) {}
 
-Encryptor::~Encryptor() {}
+Encryptor::~Encryptor() {
+  // Worker tasks hold raw pointers into |pending_frames_|; wait for them
+  // before deleting, even on an error path.
+  for (std::list<PendingEncryptedFrame*>::iterator it = pending_frames_.begin();
+       it != pending_frames_.end(); ++it) {
+    (*it)->done.Wait();
+  }
+  STLDeleteElements(&pending_frames_);
+}
+
+Encryptor::PendingEncryptedFrame::PendingEncryptedFrame()
+    : done(true, false) {}
+
+Encryptor::PendingEncryptedFrame::~PendingEncryptedFrame() {}
 
 Status Encryptor::Initialize(MuxerListener* muxer_listener,
                              KeySource::TrackType track_type,
@@ -64,31 +108,20 @@ Status Encryptor::AddTrackInfo(mkvmuxer::Track* track) {
   return CreateContentEncryption(track, key_.get());
 }
 
-Status Encryptor::EncryptFrame(scoped_refptr<MediaSample> sample,
+Status Encryptor::EncryptFrame(const scoped_refptr<MediaSample>& sample,
                                bool encrypt_frame) {
   DCHECK(encryptor_);
 
-  const size_t sample_size = sample->data_size();
   if (encrypt_frame) {
-    // | 1 | iv | enc_data |
-    const size_t iv_size = encryptor_->iv().size();
-    sample->resize_data(sample_size + iv_size + 1);
-    uint8_t* sample_data = sample->writable_data();
+    if (can_encrypt_in_parallel_)
+      return EnqueueEncryptedFrame(sample);
 
-    // Encrypt the data in-place.
-    if (!encryptor_->Crypt(sample_data, sample_size, sample_data)) {
+    if (!EncryptSampleData(encryptor_.get(), sample.get()))
       return Status(error::MUXER_FAILURE, "Failed to encrypt the frame.");
-    }
-
-    // First move the sample data to after the IV; then write the IV and signal
-    // byte.
-    memmove(sample_data + iv_size + 1, sample_data, sample_size);
-    sample_data[0] = 0x01;
-    memcpy(sample_data + 1, encryptor_->iv().data(), iv_size);
-
     encryptor_->UpdateIv();
   } else {
     // | 0 | data |
+    const size_t sample_size = sample->data_size();
     sample->resize_data(sample_size + 1);
     uint8_t* sample_data = sample->writable_data();
     memmove(sample_data + 1, sample_data, sample_size);
@@ -98,6 +131,63 @@ Status Encryptor::EncryptFrame(scoped_refptr<MediaSample> sample,
   return Status::OK;
 }
 
+Status Encryptor::WaitForFrame(const scoped_refptr<MediaSample>& sample) {
+  // Frames are written in the order they were passed to EncryptFrame, so a
+  // pending |sample| is always the oldest in-flight frame. Clear frames and
+  // serially encrypted frames are never pending.
+  if (pending_frames_.empty() || pending_frames_.front()->sample != sample)
+    return Status::OK;
+
+  scoped_ptr<PendingEncryptedFrame> pending(pending_frames_.front());
+  pending_frames_.pop_front();
+  pending->done.Wait();
+  return pending->status;
+}
+
+bool Encryptor::IsFrameReady(const scoped_refptr<MediaSample>& sample) {
+  if (pending_frames_.empty() || pending_frames_.front()->sample != sample)
+    return true;
+  return pending_frames_.front()->done.IsSignaled();
+}
+
+size_t Encryptor::max_pending_frames() const {
+  if (!can_encrypt_in_parallel_)
+    return 0;
+  return 2 * static_cast<size_t>(FLAGS_webm_encryption_threads);
+}
+
+Status Encryptor::EnqueueEncryptedFrame(
+    const scoped_refptr<MediaSample>& sample) {
+  scoped_ptr<AesCryptor> cryptor =
+      CipherEngine::GetInstance()->CreateCtrEncryptor();
+  if (!cryptor->InitializeWithIv(key_->key, encryptor_->iv()))
+    return Status(error::MUXER_FAILURE, "Failed to create the encryptor.");
+  // An 8-byte IV increments by one per frame, so the next frame's IV is known
+  // before this frame is encrypted.
+  encryptor_->UpdateIv();
+
+  scoped_ptr<PendingEncryptedFrame> pending(new PendingEncryptedFrame);
+  pending->sample = sample;
+  pending->encryptor = cryptor.Pass();
+
+  PendingEncryptedFrame* pending_ptr = pending.release();
+  pending_frames_.push_back(pending_ptr);
+  base::WorkerPool::PostTask(FROM_HERE,
+                             base::Bind(&Encryptor::EncryptFrameTask,
+                                        pending_ptr),
+                             true /* task_is_slow */);
+  return Status::OK;
+}
+
+// static
+void Encryptor::EncryptFrameTask(PendingEncryptedFrame* pending) {
+  if (!EncryptSampleData(pending->encryptor.get(), pending->sample.get())) {
+    pending->status =
+        Status(error::MUXER_FAILURE, "Failed to encrypt the frame.");
+  }
+  pending->done.Signal();
+}
+
 Status Encryptor::CreateEncryptor(MuxerListener* muxer_listener,
                                   KeySource::TrackType track_type,
                                   KeySource* key_source) {
@@ -110,7 +200,8 @@ Status Encryptor::CreateEncryptor(MuxerListener* muxer_listener,
       return Status(error::INTERNAL_ERROR, "Failed to generate random iv.");
   }
 
-  scoped_ptr<AesCtrEncryptor> encryptor(new AesCtrEncryptor());
+  scoped_ptr<AesCryptor> encryptor =
+      CipherEngine::GetInstance()->CreateCtrEncryptor();
   const bool initialized =
       encryptor->InitializeWithIv(encryption_key->key, encryption_key->iv);
   if (!initialized)
@@ -123,6 +214,11 @@ Status Encryptor::CreateEncryptor(MuxerListener* muxer_listener,
         encryptor->iv(), encryption_key->key_system_info);
   }
 
+  // A 16-byte IV advances by the number of blocks encrypted in the previous
+  // frame, so those streams stay on the serial path.
+  can_encrypt_in_parallel_ =
+      FLAGS_webm_encryption_threads > 1 && encryptor->iv().size() == 8;
+
   key_ = encryption_key.Pass();
   encryptor_ = encryptor.Pass();
   return Status::OK;
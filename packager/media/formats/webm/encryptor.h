@@ -7,8 +7,11 @@
 #ifndef MEDIA_FORMATS_WEBM_ENCRYPTOR_H_
 #define MEDIA_FORMATS_WEBM_ENCRYPTOR_H_
 
+#include <list>
+
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/waitable_event.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/status.h"
 #include "packager/media/event/muxer_listener.h"
@@ -17,7 +20,7 @@
 namespace shaka {
 namespace media {
 
-class AesCtrEncryptor;
+class AesCryptor;
 class MediaSample;
 
 namespace webm {
@@ -41,12 +44,48 @@ class Encryptor {
   Status AddTrackInfo(mkvmuxer::Track* track);
 
   /// Encrypt the data.  This needs to be told whether the current frame will
-  /// be encrypted (e.g. for a clear lead).
+  /// be encrypted (e.g. for a clear lead).  The frame may be encrypted
+  /// asynchronously on the worker pool, in which case its data is not final
+  /// until WaitForFrame() returns.
   /// @return OK on success, an error status otherwise.
-  Status EncryptFrame(scoped_refptr<MediaSample> sample,
+  Status EncryptFrame(const scoped_refptr<MediaSample>& sample,
                       bool encrypt_frame);
 
+  /// Waits until @a sample, previously passed to EncryptFrame, has been
+  /// encrypted.  Frames must be waited on in the order they were passed to
+  /// EncryptFrame.  This is a no-op for frames that were handled inline.
+  /// @return OK on success, an error status otherwise.
+  Status WaitForFrame(const scoped_refptr<MediaSample>& sample);
+
+  /// @return true if WaitForFrame(@a sample) would return without blocking.
+  bool IsFrameReady(const scoped_refptr<MediaSample>& sample);
+
+  /// @return The number of frames that may be in flight on the worker pool
+  ///         at once, or 0 if frames are encrypted inline.
+  size_t max_pending_frames() const;
+
  private:
+  // A frame being encrypted on the worker pool. |done| is signaled once
+  // |status| and the sample data are final; it is manual-reset so it can be
+  // polled through IsFrameReady() before it is waited on.
+  struct PendingEncryptedFrame {
+    PendingEncryptedFrame();
+    ~PendingEncryptedFrame();
+
+    scoped_refptr<MediaSample> sample;
+    scoped_ptr<AesCryptor> encryptor;
+    Status status;
+    base::WaitableEvent done;
+  };
+
+  // Composes the signal byte, IV and ciphertext of |pending|'s sample with
+  // its own encryptor; runs on the worker pool.
+  static void EncryptFrameTask(PendingEncryptedFrame* pending);
+
+  // Hands |sample| to the worker pool with a cryptor seeded with this frame's
+  // IV.
+  Status EnqueueEncryptedFrame(const scoped_refptr<MediaSample>& sample);
+
   // Create the encryptor for the internal encryption key.
   Status CreateEncryptor(MuxerListener* muxer_listener,
                          KeySource::TrackType track_type,
@@ -54,7 +93,15 @@ class Encryptor {
 
  private:
   scoped_ptr<EncryptionKey> key_;
-  scoped_ptr<AesCtrEncryptor> encryptor_;
+  scoped_ptr<AesCryptor> encryptor_;
+
+  // Whether frames can be encrypted concurrently: per-frame IVs must be
+  // derivable without encrypting, i.e. 8-byte IVs which increment by one per
+  // frame.
+  bool can_encrypt_in_parallel_;
+  // Frames handed to the worker pool, in order; owned. Retired through
+  // WaitForFrame() as the segmenter writes frames.
+  std::list<PendingEncryptedFrame*> pending_frames_;
 };
 
 }  // namespace webm
@@ -6,10 +6,14 @@
 
 #include "packager/media/formats/webm/mkv_writer.h"
 
+#include <string.h>
+
 namespace shaka {
 namespace media {
 
-MkvWriter::MkvWriter() : position_(0) {}
+MkvWriter::MkvWriter()
+    : position_(0), buffering_(false), buffer_start_position_(0),
+      buffer_offset_(0) {}
 
 MkvWriter::~MkvWriter() {}
 
@@ -27,6 +31,9 @@ Status MkvWriter::Open(const std::string& name) {
 }
 
 Status MkvWriter::Close() {
+  Status status = FlushBufferedWrites();
+  if (!status.ok())
+    return status;
   const std::string file_name = file_->file_name();
   if (!file_.release()->Close()) {
     return Status(error::FILE_FAILURE, "Cannot close file " + file_name);
@@ -37,6 +44,15 @@ Status MkvWriter::Close() {
 mkvmuxer::int32 MkvWriter::Write(const void* buf, mkvmuxer::uint32 len) {
   DCHECK(file_);
 
+  if (buffering_) {
+    const size_t end = buffer_offset_ + len;
+    if (end > buffer_.size())
+      buffer_.resize(end);
+    memcpy(&buffer_[buffer_offset_], buf, len);
+    buffer_offset_ = end;
+    return 0;
+  }
+
   const char* data = reinterpret_cast<const char*>(buf);
   int64_t total_bytes_written = 0;
   while (total_bytes_written < len) {
@@ -53,6 +69,37 @@ mkvmuxer::int32 MkvWriter::Write(const void* buf, mkvmuxer::uint32 len) {
   return 0;
 }
 
+void MkvWriter::StartBufferedWrites() {
+  DCHECK(!buffering_);
+  buffering_ = true;
+  buffer_start_position_ = position_;
+  buffer_offset_ = 0;
+  DCHECK(buffer_.empty());
+}
+
+Status MkvWriter::FlushBufferedWrites() {
+  if (!buffering_)
+    return Status::OK;
+  buffering_ = false;
+
+  const char* data = reinterpret_cast<const char*>(buffer_.data());
+  size_t total_bytes_written = 0;
+  while (total_bytes_written < buffer_.size()) {
+    const int64_t written = file_->Write(data + total_bytes_written,
+                                         buffer_.size() - total_bytes_written);
+    if (written < 0) {
+      return Status(error::FILE_FAILURE,
+                    "Error writing buffered data to file.");
+    }
+    total_bytes_written += written;
+  }
+
+  position_ += buffer_.size();
+  // clear() retains the allocation for the next cluster.
+  buffer_.clear();
+  return Status::OK;
+}
+
 int64_t MkvWriter::WriteFromFile(File* source) {
   return WriteFromFile(source, kWholeFile);
 }
@@ -69,12 +116,26 @@ int64_t MkvWriter::WriteFromFile(File* source, uint64_t max_copy) {
 }
 
 mkvmuxer::int64 MkvWriter::Position() const {
+  if (buffering_)
+    return buffer_start_position_ + buffer_offset_;
   return position_;
 }
 
 mkvmuxer::int32 MkvWriter::Position(mkvmuxer::int64 position) {
   DCHECK(file_);
 
+  if (buffering_) {
+    // Seeks within the buffered region only, e.g. to patch the size of the
+    // cluster being assembled.
+    if (position < buffer_start_position_ ||
+        position > buffer_start_position_ +
+                       static_cast<mkvmuxer::int64>(buffer_.size())) {
+      return -1;
+    }
+    buffer_offset_ = position - buffer_start_position_;
+    return 0;
+  }
+
   if (file_->Seek(position)) {
     position_ = position;
     return 0;
@@ -84,6 +145,10 @@ mkvmuxer::int32 MkvWriter::Position(mkvmuxer::int64 position) {
 }
 
 bool MkvWriter::Seekable() const {
+  // Seeks within the buffered region are always supported, so clusters can
+  // be size-patched before they are flushed even if |file_| is not seekable.
+  if (buffering_)
+    return true;
   return seekable_;
 }
 
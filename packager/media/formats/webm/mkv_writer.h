@@ -8,6 +8,7 @@
 #define MEDIA_FORMATS_WEBM_MKV_WRITER_H_
 
 #include <string>
+#include <vector>
 
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/status.h"
@@ -40,7 +41,8 @@ class MkvWriter : public mkvmuxer::IMkvWriter {
   /// Set the current File position.
   /// @return 0 on success.
   mkvmuxer::int32 Position(mkvmuxer::int64 position) override;
-  /// @return true if the writer is seekable.
+  /// @return true if the writer is seekable.  Always true while buffering,
+  ///         since seeks within the buffered region are supported.
   bool Seekable() const override;
   /// Element start notification. Called whenever an element identifier is about
   /// to be written to the stream.  @a element_id is the element identifier, and
@@ -50,6 +52,17 @@ class MkvWriter : public mkvmuxer::IMkvWriter {
   void ElementStartNotify(mkvmuxer::uint64 element_id,
                           mkvmuxer::int64 position) override;
 
+  /// Starts buffering writes in memory. Further writes accumulate in a
+  /// reused buffer, and seeks within the buffered region are allowed even if
+  /// the underlying file is not seekable, so a whole cluster can be
+  /// assembled, size-patched and written to the file in one call. Must not
+  /// already be buffering.
+  void StartBufferedWrites();
+  /// Writes the buffered data to the file in a single write and stops
+  /// buffering. No-op if not buffering.
+  /// @return Whether the operation succeeded.
+  Status FlushBufferedWrites();
+
   /// Writes the contents of the given file to this file.
   /// @return The number of bytes written; or < 0 on error.
   int64_t WriteFromFile(File* source);
@@ -66,6 +79,15 @@ class MkvWriter : public mkvmuxer::IMkvWriter {
   mkvmuxer::int64 position_;
   bool seekable_;
 
+  // Whether writes currently accumulate in |buffer_| instead of going to
+  // |file_|. |position_| is not advanced while buffering; the buffered region
+  // starts at |buffer_start_position_| and |buffer_offset_| is the write
+  // position within it. The buffer's allocation is reused across clusters.
+  bool buffering_;
+  mkvmuxer::int64 buffer_start_position_;
+  size_t buffer_offset_;
+  std::vector<uint8_t> buffer_;
+
   DISALLOW_COPY_AND_ASSIGN(MkvWriter);
 };
 
@@ -45,6 +45,9 @@ Status MultiSegmentSegmenter::DoFinalize() {
 Status MultiSegmentSegmenter::FinalizeSegment() {
   if (!cluster()->Finalize())
     return Status(error::FILE_FAILURE, "Error finalizing segment.");
+  Status status = writer_->FlushBufferedWrites();
+  if (!status.ok())
+    return status;
 
   if (muxer_listener()) {
     const uint64_t size = cluster()->Size();
@@ -76,9 +79,12 @@ Status MultiSegmentSegmenter::NewSegment(uint64_t start_timescale) {
   }
 
   // Create a new file for the new segment.
-  std::string segment_name =
-      GetSegmentName(options().segment_template, start_timescale, num_segment_,
-                     options().bandwidth);
+  if (!segment_name_template_) {
+    segment_name_template_.reset(
+        new SegmentNameTemplate(options().segment_template));
+  }
+  std::string segment_name = segment_name_template_->GetName(
+      start_timescale, num_segment_, options().bandwidth);
   writer_.reset(new MkvWriter);
   Status status = writer_->Open(segment_name);
   if (!status.ok())
@@ -16,6 +16,7 @@
 namespace shaka {
 namespace media {
 
+class SegmentNameTemplate;
 struct MuxerOptions;
 
 namespace webm {
@@ -47,6 +48,8 @@ class MultiSegmentSegmenter : public Segmenter {
 
   scoped_ptr<MkvWriter> writer_;
   uint32_t num_segment_;
+  // Precompiled form of |options().segment_template|, built on first use.
+  scoped_ptr<SegmentNameTemplate> segment_name_template_;
 
   DISALLOW_COPY_AND_ASSIGN(MultiSegmentSegmenter);
 };
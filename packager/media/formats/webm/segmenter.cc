@@ -42,6 +42,7 @@ Segmenter::Segmenter(const MuxerOptions& options)
       segment_payload_pos_(0),
       cluster_length_sec_(0),
       segment_length_sec_(0),
+      finalized_cluster_length_sec_(0),
       track_id_(0) {}
 
 Segmenter::~Segmenter() {}
@@ -104,17 +105,24 @@ Status Segmenter::Initialize(scoped_ptr<MkvWriter> writer,
 }
 
 Status Segmenter::Finalize() {
-  Status status = WriteFrame(true /* write_duration */);
+  QueuedFrame queued_frame;
+  queued_frame.sample = prev_sample_;
+  queued_frame.write_duration = true;
+  queued_frames_.push_back(queued_frame);
+  Status status = DrainQueuedFrames(true /* drain_all */);
   if (!status.ok())
     return status;
 
+  // The final Cluster is finalized by DoFinalize below.
+  finalized_cluster_length_sec_ = cluster_length_sec_;
+
   uint64_t duration =
       prev_sample_->pts() - first_timestamp_ + prev_sample_->duration();
   segment_info_.set_duration(FromBMFFTimescale(duration));
   return DoFinalize();
 }
 
-Status Segmenter::AddSample(scoped_refptr<MediaSample> sample) {
+Status Segmenter::AddSample(const scoped_refptr<MediaSample>& sample) {
   if (sample_duration_ == 0) {
     first_timestamp_ = sample->pts();
     sample_duration_ = sample->duration();
@@ -124,41 +132,52 @@ Status Segmenter::AddSample(scoped_refptr<MediaSample> sample) {
 
   UpdateProgress(sample->duration());
 
-  // This writes frames in a delay.  Meaning that the previous frame is written
-  // on this call to AddSample.  The current frame is stored until the next
-  // call.  This is done to determine which frame is the last in a Cluster.
-  // This first block determines if this is a new Cluster and writes the
-  // previous frame first before creating the new Cluster.
-
-  Status status;
-  bool wrote_frame = false;
-  if (!cluster_) {
-    status = NewSegment(sample->pts());
-    // First frame, so no previous frame to write.
-    wrote_frame = true;
-  } else if (segment_length_sec_ >= options_.segment_duration) {
+  // This writes frames in a delay.  Meaning that the previous frame is queued
+  // for writing on this call to AddSample.  The current frame is stored until
+  // the next call.  This is done to determine which frame is the last in a
+  // Cluster.  This first block determines if this is a new Cluster and records
+  // that decision with the previous frame, so that the writes, which are
+  // deferred through |queued_frames_| while frames encrypt on the worker
+  // pool, replay in the original order.
+
+  QueuedFrame queued_frame;
+  bool queued = false;
+  if (!prev_sample_) {
+    // First frame, so no previous frame to write; only start the segment.
+    queued_frame.action = QueuedFrame::kActionNewSegment;
+    queued_frame.action_timescale = sample->pts();
+    queued = true;
+  } else if (segment_length_sec_ >= options_.GetEffectiveSegmentDuration()) {
     if (sample->is_key_frame() || !options_.segment_sap_aligned) {
-      status = WriteFrame(true /* write_duration */);
-      status.Update(NewSegment(sample->pts()));
+      queued_frame.sample = prev_sample_;
+      queued_frame.write_duration = true;
+      queued_frame.action = QueuedFrame::kActionNewSegment;
+      queued_frame.action_timescale = sample->pts();
+      queued_frame.cluster_length_sec = cluster_length_sec_;
       segment_length_sec_ = 0;
       cluster_length_sec_ = 0;
-      wrote_frame = true;
+      queued = true;
     }
   } else if (cluster_length_sec_ >= options_.fragment_duration) {
     if (sample->is_key_frame() || !options_.fragment_sap_aligned) {
-      status = WriteFrame(true /* write_duration */);
-      status.Update(NewSubsegment(sample->pts()));
+      queued_frame.sample = prev_sample_;
+      queued_frame.write_duration = true;
+      queued_frame.action = QueuedFrame::kActionNewSubsegment;
+      queued_frame.action_timescale = sample->pts();
+      queued_frame.cluster_length_sec = cluster_length_sec_;
       cluster_length_sec_ = 0;
-      wrote_frame = true;
+      queued = true;
     }
   }
-  if (!wrote_frame) {
-    status = WriteFrame(false /* write_duration */);
+  if (!queued) {
+    queued_frame.sample = prev_sample_;
+    queued_frame.write_duration = false;
   }
-  if (!status.ok())
-    return status;
+  queued_frames_.push_back(queued_frame);
 
-  // Encrypt the frame.
+  // Encrypt the frame.  With multiple encryption threads this hands the frame
+  // to the worker pool; the write is held back until the frame is ready.
+  Status status;
   if (encryptor_) {
     const bool encrypt_frame =
         static_cast<double>(sample->pts() - first_timestamp_) /
@@ -173,6 +192,9 @@ Status Segmenter::AddSample(scoped_refptr<MediaSample> sample) {
       muxer_listener_->OnEncryptionStart();
   }
 
+  status = DrainQueuedFrames(false /* drain_all */);
+  if (!status.ok())
+    return status;
 
   // Add the sample to the durations even though we have not written the frame
   // yet.  This is needed to make sure we split Clusters at the correct point.
@@ -186,6 +208,51 @@ Status Segmenter::AddSample(scoped_refptr<MediaSample> sample) {
   return Status::OK;
 }
 
+Status Segmenter::DrainQueuedFrames(bool drain_all) {
+  const size_t max_queued = encryptor_ ? encryptor_->max_pending_frames() : 0;
+  while (!queued_frames_.empty()) {
+    const QueuedFrame& queued_frame = queued_frames_.front();
+    // Let up to |max_queued| frames encrypt on the worker pool before
+    // blocking on the oldest one.
+    if (!drain_all && queued_frames_.size() <= max_queued &&
+        queued_frame.sample && !encryptor_->IsFrameReady(queued_frame.sample)) {
+      break;
+    }
+    Status status = WriteQueuedFrame(queued_frame);
+    queued_frames_.pop_front();
+    if (!status.ok())
+      return status;
+  }
+  return Status::OK;
+}
+
+Status Segmenter::WriteQueuedFrame(const QueuedFrame& queued_frame) {
+  Status status;
+  if (queued_frame.sample) {
+    if (encryptor_) {
+      status = encryptor_->WaitForFrame(queued_frame.sample);
+      if (!status.ok())
+        return status;
+    }
+    status = WriteFrame(queued_frame.sample, queued_frame.write_duration);
+    if (!status.ok())
+      return status;
+  }
+  switch (queued_frame.action) {
+    case QueuedFrame::kActionNone:
+      break;
+    case QueuedFrame::kActionNewSegment:
+      finalized_cluster_length_sec_ = queued_frame.cluster_length_sec;
+      status = NewSegment(queued_frame.action_timescale);
+      break;
+    case QueuedFrame::kActionNewSubsegment:
+      finalized_cluster_length_sec_ = queued_frame.cluster_length_sec;
+      status = NewSubsegment(queued_frame.action_timescale);
+      break;
+  }
+  return status;
+}
+
 float Segmenter::GetDuration() const {
   return static_cast<float>(segment_info_.duration()) *
          segment_info_.timecode_scale() / kSecondsToNs;
@@ -207,6 +274,10 @@ uint64_t Segmenter::FromWebMTimecode(uint64_t time_webm_timecode) {
 Status Segmenter::WriteSegmentHeader(uint64_t file_size, MkvWriter* writer) {
   Status error_status(error::FILE_FAILURE, "Error writing segment header.");
 
+  // The header is a run of many small elements; assemble it in the writer's
+  // buffer and write it to the file in one call.
+  writer->StartBufferedWrites();
+
   if (!WriteEbmlHeader(writer))
     return error_status;
 
@@ -239,14 +310,23 @@ Status Segmenter::WriteSegmentHeader(uint64_t file_size, MkvWriter* writer) {
   if (!tracks_.Write(writer))
     return error_status;
 
-  return Status::OK;
+  return writer->FlushBufferedWrites();
 }
 
 Status Segmenter::SetCluster(uint64_t start_webm_timecode,
                              uint64_t position,
                              MkvWriter* writer) {
+  // The previous cluster, if any, has been finalized by the caller; write it
+  // to the file in one go. The new cluster assembles in the writer's buffer
+  // so its many small block writes and the size patch in Finalize() do not
+  // hit the file.
+  Status status = writer->FlushBufferedWrites();
+  if (!status.ok())
+    return status;
+
   const uint64_t scale = segment_info_.timecode_scale();
   cluster_.reset(new mkvmuxer::Cluster(start_webm_timecode, position, scale));
+  writer->StartBufferedWrites();
   cluster_->Init(writer);
   return Status::OK;
 }
@@ -365,35 +445,36 @@ Status Segmenter::InitializeEncryptor(KeySource* key_source,
   return encryptor_->Initialize(muxer_listener_, track_type, key_source);
 }
 
-Status Segmenter::WriteFrame(bool write_duration) {
+Status Segmenter::WriteFrame(const scoped_refptr<MediaSample>& sample,
+                             bool write_duration) {
   // Create a frame manually so we can create non-SimpleBlock frames.  This
   // is required to allow the frame duration to be added.  If the duration
   // is not set, then a SimpleBlock will still be written.
   mkvmuxer::Frame frame;
 
-  if (!frame.Init(prev_sample_->data(), prev_sample_->data_size())) {
+  if (!frame.Init(sample->data(), sample->data_size())) {
     return Status(error::MUXER_FAILURE,
                   "Error adding sample to segment: Frame::Init failed");
   }
 
   if (write_duration) {
     const uint64_t duration_ns =
-        prev_sample_->duration() * kSecondsToNs / info_->time_scale();
+        sample->duration() * kSecondsToNs / info_->time_scale();
     frame.set_duration(duration_ns);
   }
-  frame.set_is_key(prev_sample_->is_key_frame());
-  frame.set_timestamp(prev_sample_->pts() * kSecondsToNs / info_->time_scale());
+  frame.set_is_key(sample->is_key_frame());
+  frame.set_timestamp(sample->pts() * kSecondsToNs / info_->time_scale());
   frame.set_track_number(track_id_);
 
-  if (prev_sample_->side_data_size() > 0) {
+  if (sample->side_data_size() > 0) {
     uint64_t block_add_id;
     // First 8 bytes of side_data is the BlockAddID element's value, which is
     // done to mimic ffmpeg behavior. See webm_cluster_parser.cc for details.
-    CHECK_GT(prev_sample_->side_data_size(), sizeof(block_add_id));
-    memcpy(&block_add_id, prev_sample_->side_data(), sizeof(block_add_id));
+    CHECK_GT(sample->side_data_size(), sizeof(block_add_id));
+    memcpy(&block_add_id, sample->side_data(), sizeof(block_add_id));
     if (!frame.AddAdditionalData(
-            prev_sample_->side_data() + sizeof(block_add_id),
-            prev_sample_->side_data_size() - sizeof(block_add_id),
+            sample->side_data() + sizeof(block_add_id),
+            sample->side_data_size() - sizeof(block_add_id),
             block_add_id)) {
       return Status(
           error::MUXER_FAILURE,
@@ -401,7 +482,7 @@ Status Segmenter::WriteFrame(bool write_duration) {
     }
   }
 
-  if (!prev_sample_->is_key_frame() && !frame.CanBeSimpleBlock()) {
+  if (!sample->is_key_frame() && !frame.CanBeSimpleBlock()) {
     const int64_t timestamp_ns =
         reference_frame_timestamp_ * kSecondsToNs / info_->time_scale();
     frame.set_reference_block_timestamp(timestamp_ns);
@@ -427,7 +508,7 @@ Status Segmenter::WriteFrame(bool write_duration) {
   // A reference frame is needed for non-keyframes.  Having a reference to the
   // previous block is good enough.
   // See libwebm Segment::AddGenericFrame
-  reference_frame_timestamp_ = prev_sample_->pts();
+  reference_frame_timestamp_ = sample->pts();
   return Status::OK;
 }
 
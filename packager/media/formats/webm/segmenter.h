@@ -7,6 +7,8 @@
 #ifndef MEDIA_FORMATS_WEBM_SEGMENTER_H_
 #define MEDIA_FORMATS_WEBM_SEGMENTER_H_
 
+#include <deque>
+
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/status.h"
@@ -65,7 +67,7 @@ class Segmenter {
   /// Add sample to the indicated stream.
   /// @param sample points to the sample to be added.
   /// @return OK on success, an error status otherwise.
-  Status AddSample(scoped_refptr<MediaSample> sample);
+  Status AddSample(const scoped_refptr<MediaSample>& sample);
 
   /// @return true if there is an initialization range, while setting @a start
   ///         and @a end; or false if initialization range does not apply.
@@ -104,18 +106,52 @@ class Segmenter {
 
   int track_id() const { return track_id_; }
   uint64_t segment_payload_pos() const { return segment_payload_pos_; }
-  double cluster_length_sec() const { return cluster_length_sec_; }
+  /// @return The length, in seconds, of the Cluster being finalized.
+  double cluster_length_sec() const { return finalized_cluster_length_sec_; }
 
   virtual Status DoInitialize(scoped_ptr<MkvWriter> writer) = 0;
   virtual Status DoFinalize() = 0;
 
  private:
+  // A frame whose write has been deferred so its encryption can run ahead on
+  // the worker pool.  The boundary decision made when the next sample arrived
+  // is recorded so the writes replay in the original order.
+  struct QueuedFrame {
+    enum Action {
+      kActionNone,
+      kActionNewSegment,
+      kActionNewSubsegment,
+    };
+
+    QueuedFrame()
+        : write_duration(false),
+          action(kActionNone),
+          action_timescale(0),
+          cluster_length_sec(0) {}
+
+    scoped_refptr<MediaSample> sample;  // NULL for an action-only entry.
+    bool write_duration;
+    Action action;  // Performed after the frame is written.
+    uint64_t action_timescale;
+    // The length of the Cluster closed by |action|, reported through
+    // cluster_length_sec() while the action runs.
+    double cluster_length_sec;
+  };
+
   Status CreateVideoTrack(VideoStreamInfo* info);
   Status CreateAudioTrack(AudioStreamInfo* info);
   Status InitializeEncryptor(KeySource* key_source, uint32_t max_sd_pixels);
 
-  // Writes the previous frame to the file.
-  Status WriteFrame(bool write_duration);
+  // Writes the given frame to the file.
+  Status WriteFrame(const scoped_refptr<MediaSample>& sample,
+                    bool write_duration);
+
+  // Writes queued frames whose encryption has finished.  If @a drain_all is
+  // true, or the queue has grown past the encryptor's window, blocks until
+  // the frames are ready.
+  Status DrainQueuedFrames(bool drain_all);
+  // Writes one queued frame and performs its recorded action.
+  Status WriteQueuedFrame(const QueuedFrame& queued_frame);
 
   // This is called when there needs to be a new subsegment.  This does nothing
   // in single-segment mode.  In multi-segment mode this creates a new Cluster
@@ -128,6 +164,9 @@ class Segmenter {
 
   // Store the previous sample so we know which one is the last frame.
   scoped_refptr<MediaSample> prev_sample_;
+  // Frames whose Cluster placement has been decided but which have not been
+  // written yet; drained in order as their encryption finishes.
+  std::deque<QueuedFrame> queued_frames_;
   // The reference frame timestamp; used to populate the ReferenceBlock element
   // when writing non-keyframe BlockGroups.
   uint64_t reference_frame_timestamp_;
@@ -153,8 +192,12 @@ class Segmenter {
   // file.  This is also the size of the header before the SeekHead.
   uint64_t segment_payload_pos_;
 
+  // Running lengths of the Cluster/segment being decided on; these include
+  // queued frames that have not been written yet.
   double cluster_length_sec_;
   double segment_length_sec_;
+  // The length of the Cluster being finalized; see cluster_length_sec().
+  double finalized_cluster_length_sec_;
 
   int track_id_;
 
@@ -6,9 +6,19 @@
 
 #include "packager/media/formats/webm/single_segment_segmenter.h"
 
+#include <gflags/gflags.h>
+
 #include "packager/media/base/muxer_options.h"
 #include "packager/third_party/libwebm/src/mkvmuxer.hpp"
 
+DEFINE_int32(webm_max_cue_points,
+             0,
+             "Maximum number of cue points kept in memory while muxing a "
+             "single-file WebM stream, or 0 for no limit. When the limit is "
+             "reached, every other cue point is dropped, halving the seek "
+             "granularity, so memory use stays bounded regardless of stream "
+             "duration.");
+
 namespace shaka {
 namespace media {
 namespace webm {
@@ -29,12 +39,23 @@ Status SingleSegmentSegmenter::DoInitialize(scoped_ptr<MkvWriter> writer) {
 Status SingleSegmentSegmenter::DoFinalize() {
   if (!cluster()->Finalize())
     return Status(error::FILE_FAILURE, "Error finalizing cluster.");
+  Status flush_status = writer_->FlushBufferedWrites();
+  if (!flush_status.ok())
+    return flush_status;
+
+  Status cues_status = BuildCues();
+  if (!cues_status.ok())
+    return cues_status;
 
-  // Write the Cues to the end of the file.
+  // Write the Cues to the end of the file, coalesced into a single write.
   index_start_ = writer_->Position();
   seek_head()->set_cues_pos(index_start_ - segment_payload_pos());
+  writer_->StartBufferedWrites();
   if (!cues()->Write(writer_.get()))
     return Status(error::FILE_FAILURE, "Error writing Cues data.");
+  flush_status = writer_->FlushBufferedWrites();
+  if (!flush_status.ok())
+    return flush_status;
 
   // The WebM index is at the end of the file.
   index_end_ = writer_->Position() - 1;
@@ -53,20 +74,42 @@ Status SingleSegmentSegmenter::NewSegment(uint64_t start_timescale) {
   if (cluster() && !cluster()->Finalize())
     return Status(error::FILE_FAILURE, "Error finalizing cluster.");
 
-  // Create a new Cue point.
+  // Stage a new Cue point.  The Cues element is only built at finalization,
+  // so old cue points can be evicted without rebuilding libwebm state.
   uint64_t position = writer_->Position();
   uint64_t start_webm_timecode = FromBMFFTimescale(start_timescale);
 
-  mkvmuxer::CuePoint* cue_point = new mkvmuxer::CuePoint;
-  cue_point->set_time(start_webm_timecode);
-  cue_point->set_track(track_id());
-  cue_point->set_cluster_pos(position - segment_payload_pos());
-  if (!cues()->AddCue(cue_point))
-    return Status(error::INTERNAL_ERROR, "Error adding CuePoint.");
+  StagedCuePoint cue_point;
+  cue_point.timecode = start_webm_timecode;
+  cue_point.cluster_pos = position - segment_payload_pos();
+  cue_points_.push_back(cue_point);
+
+  if (FLAGS_webm_max_cue_points > 0 &&
+      cue_points_.size() >= static_cast<size_t>(FLAGS_webm_max_cue_points)) {
+    // Drop every other cue point; amortized constant time per Cluster and
+    // bounded memory regardless of stream duration.
+    size_t kept = 0;
+    for (size_t i = 0; i < cue_points_.size(); i += 2)
+      cue_points_[kept++] = cue_points_[i];
+    cue_points_.resize(kept);
+  }
 
   return SetCluster(start_webm_timecode, position, writer_.get());
 }
 
+Status SingleSegmentSegmenter::BuildCues() {
+  for (size_t i = 0; i < cue_points_.size(); ++i) {
+    mkvmuxer::CuePoint* cue_point = new mkvmuxer::CuePoint;
+    cue_point->set_time(cue_points_[i].timecode);
+    cue_point->set_track(track_id());
+    cue_point->set_cluster_pos(cue_points_[i].cluster_pos);
+    if (!cues()->AddCue(cue_point))
+      return Status(error::INTERNAL_ERROR, "Error adding CuePoint.");
+  }
+  cue_points_.clear();
+  return Status::OK;
+}
+
 bool SingleSegmentSegmenter::GetInitRangeStartAndEnd(uint64_t* start,
                                                      uint64_t* end) {
   // The init range is the header, from the start of the file to the size of
@@ -9,6 +9,8 @@
 
 #include "packager/media/formats/webm/segmenter.h"
 
+#include <vector>
+
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/status.h"
 #include "packager/media/formats/webm/mkv_writer.h"
@@ -41,15 +43,28 @@ class SingleSegmentSegmenter : public Segmenter {
   void set_index_end(uint64_t end) { index_end_ = end; }
   void set_writer(scoped_ptr<MkvWriter> writer) { writer_ = writer.Pass(); }
 
+  /// Builds the Cues element from the cue points staged by NewSegment.  Must
+  /// be called before writing the Cues element.
+  Status BuildCues();
+
   // Segmenter implementation overrides.
   Status DoInitialize(scoped_ptr<MkvWriter> writer) override;
   Status DoFinalize() override;
 
  private:
+  // A cue point staged until the Cues element is written at finalization.
+  // The mkvmuxer::CuePoint objects are only built then, so old cue points
+  // can be evicted cheaply when --webm_max_cue_points is exceeded.
+  struct StagedCuePoint {
+    uint64_t timecode;
+    uint64_t cluster_pos;
+  };
+
   // Segmenter implementation overrides.
   Status NewSubsegment(uint64_t start_timescale) override;
   Status NewSegment(uint64_t start_timescale) override;
 
+  std::vector<StagedCuePoint> cue_points_;
   scoped_ptr<MkvWriter> writer_;
   uint64_t init_end_;
   uint64_t index_start_;
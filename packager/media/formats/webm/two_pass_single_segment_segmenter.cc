@@ -21,8 +21,6 @@
 #include "packager/media/base/muxer_options.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/third_party/libwebm/src/mkvmuxer.hpp"
-#include "packager/third_party/libwebm/src/mkvmuxerutil.hpp"
-#include "packager/third_party/libwebm/src/webmids.hpp"
 
 namespace shaka {
 namespace media {
@@ -91,16 +89,29 @@ TwoPassSingleSegmentSegmenter::DoInitialize(scoped_ptr<MkvWriter> writer) {
 Status TwoPassSingleSegmentSegmenter::DoFinalize() {
   if (!cluster()->Finalize())
     return Status(error::FILE_FAILURE, "Error finalizing cluster.");
+  Status flush_status = writer()->FlushBufferedWrites();
+  if (!flush_status.ok())
+    return flush_status;
 
-  // Write the Cues to the end of the temp file.
+  Status cues_status = BuildCues();
+  if (!cues_status.ok())
+    return cues_status;
+
+  // Write the Cues to the end of the temp file, coalesced into a single
+  // write.
   uint64_t cues_pos = writer()->Position();
   set_index_start(cues_pos);
   seek_head()->set_cues_pos(cues_pos - segment_payload_pos());
+  writer()->StartBufferedWrites();
   if (!cues()->Write(writer()))
     return Status(error::FILE_FAILURE, "Error writing Cues data.");
+  flush_status = writer()->FlushBufferedWrites();
+  if (!flush_status.ok())
+    return flush_status;
+  const uint64_t temp_file_size = writer()->Position();
 
   // Write the header to the real output file.
-  Status temp = WriteSegmentHeader(writer()->Position(), real_writer_.get());
+  Status temp = WriteSegmentHeader(temp_file_size, real_writer_.get());
   if (!temp.ok())
     return temp;
 
@@ -116,10 +127,13 @@ Status TwoPassSingleSegmentSegmenter::DoFinalize() {
   if (!ReadSkip(temp_reader.get(), header_size))
     return Status(error::FILE_FAILURE, "Error reading temp file.");
 
-  // Copy the rest of the data over.
-  if (!CopyFileWithClusterRewrite(temp_reader.get(), real_writer_.get(),
-                                  cluster()->Size()))
+  // Cluster sizes are patched in the write buffer before each cluster is
+  // flushed, so the temp file already contains the final bytes and can be
+  // copied over verbatim.
+  const int64_t copy_size = temp_file_size - header_size;
+  if (real_writer_->WriteFromFile(temp_reader.get()) != copy_size)
     return Status(error::FILE_FAILURE, "Error copying temp file.");
+  UpdateProgress(info()->duration());
 
   // Close and delete the temp file.
   temp_reader.reset();
@@ -132,53 +146,6 @@ Status TwoPassSingleSegmentSegmenter::DoFinalize() {
   return real_writer_->Close();
 }
 
-bool TwoPassSingleSegmentSegmenter::CopyFileWithClusterRewrite(
-    File* source,
-    MkvWriter* dest,
-    uint64_t last_size) {
-  const int cluster_id_size = mkvmuxer::GetUIntSize(mkvmuxer::kMkvCluster);
-  const int cluster_size_size = 8;  // The size of the Cluster size integer.
-  const int cluster_header_size = cluster_id_size + cluster_size_size;
-
-  // We are at the start of a cluster, so copy the ID.
-  if (dest->WriteFromFile(source, cluster_id_size) != cluster_id_size)
-    return false;
-
-  for (int i = 0; i < cues()->cue_entries_size() - 1; ++i) {
-    // Write the size of the cluster.
-    const mkvmuxer::CuePoint* cue = cues()->GetCueByIndex(i);
-    const mkvmuxer::CuePoint* next_cue = cues()->GetCueByIndex(i + 1);
-    const int64_t cluster_payload_size =
-        next_cue->cluster_pos() - cue->cluster_pos() - cluster_header_size;
-    if (mkvmuxer::WriteUIntSize(dest, cluster_payload_size, cluster_size_size))
-      return false;
-    if (!ReadSkip(source, cluster_size_size))
-      return false;
-
-    // Copy the cluster and the next cluster's ID.
-    int64_t to_copy = cluster_payload_size + cluster_id_size;
-    if (dest->WriteFromFile(source, to_copy) != to_copy)
-      return false;
-
-    // Update the progress; need to convert from WebM timecode to ISO BMFF.
-    const uint64_t webm_delta_time = next_cue->time() - cue->time();
-    const uint64_t delta_time = FromWebMTimecode(webm_delta_time);
-    UpdateProgress(delta_time);
-  }
-
-  // The last cluster takes up until the cues.
-  const uint64_t last_cluster_payload_size = last_size - cluster_header_size;
-  if (mkvmuxer::WriteUIntSize(dest, last_cluster_payload_size,
-                              cluster_size_size))
-    return false;
-  if (!ReadSkip(source, cluster_size_size))
-    return false;
-
-  // Copy the remaining data (i.e. Cues data).
-  return dest->WriteFromFile(source) ==
-         static_cast<int64_t>(last_cluster_payload_size + cues()->Size());
-}
-
 }  // namespace webm
 }  // namespace media
 }  // namespace shaka
@@ -22,8 +22,9 @@ struct MuxerOptions;
 
 namespace webm {
 
-/// An implementation of a Segmenter for a single-segment that performs two
-/// passes.  This does not use seeking and is used for non-seekable files.
+/// An implementation of a Segmenter for a single-segment that stages the
+/// media data in a temp file so the header can be written first.  This does
+/// not use seeking and is used for non-seekable files.
 class TwoPassSingleSegmentSegmenter : public SingleSegmentSegmenter {
  public:
   explicit TwoPassSingleSegmentSegmenter(const MuxerOptions& options);
@@ -34,14 +35,6 @@ class TwoPassSingleSegmentSegmenter : public SingleSegmentSegmenter {
   Status DoFinalize() override;
 
  private:
-  /// Copies the data from source to destination while rewriting the Cluster
-  /// sizes to the correct values.  This assumes that both @a source and
-  /// @a dest are at the same position and that the headers have already
-  /// been copied.
-  bool CopyFileWithClusterRewrite(File* source,
-                                  MkvWriter* dest,
-                                  uint64_t last_size);
-
   scoped_ptr<MkvWriter> real_writer_;
   std::string temp_file_name_;
 
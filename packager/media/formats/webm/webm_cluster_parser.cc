@@ -149,7 +149,7 @@ WebMParserClient* WebMClusterParser::OnListStart(int id) {
     cluster_timecode_ = -1;
     cluster_start_time_ = kNoTimestamp;
   } else if (id == kWebMIdBlockGroup) {
-    block_data_.reset();
+    block_data_.clear();
     block_data_size_ = -1;
     block_duration_ = -1;
     discard_padding_ = -1;
@@ -173,11 +173,11 @@ bool WebMClusterParser::OnListEnd(int id) {
     return false;
   }
 
-  bool result = ParseBlock(false, block_data_.get(), block_data_size_,
-                           block_additional_data_.get(),
+  bool result = ParseBlock(false, block_data_.data(), block_data_size_,
+                           &block_data_, block_additional_data_.get(),
                            block_additional_data_size_, block_duration_,
                            discard_padding_set_ ? discard_padding_ : 0);
-  block_data_.reset();
+  block_data_.clear();
   block_data_size_ = -1;
   block_duration_ = -1;
   block_add_id_ = -1;
@@ -212,6 +212,7 @@ bool WebMClusterParser::OnUInt(int id, int64_t val) {
 bool WebMClusterParser::ParseBlock(bool is_simple_block,
                                    const uint8_t* buf,
                                    int size,
+                                   std::vector<uint8_t>* buf_owner,
                                    const uint8_t* additional,
                                    int additional_size,
                                    int duration,
@@ -243,23 +244,22 @@ bool WebMClusterParser::ParseBlock(bool is_simple_block,
   const uint8_t* frame_data = buf + 4;
   int frame_size = size - (frame_data - buf);
   return OnBlock(is_simple_block, track_num, timecode, duration, flags,
-                 frame_data, frame_size, additional, additional_size,
-                 discard_padding);
+                 frame_data, frame_size, buf_owner, additional,
+                 additional_size, discard_padding);
 }
 
 bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
   switch (id) {
     case kWebMIdSimpleBlock:
-      return ParseBlock(true, data, size, NULL, 0, -1, 0);
+      return ParseBlock(true, data, size, NULL, NULL, 0, -1, 0);
 
     case kWebMIdBlock:
-      if (block_data_) {
+      if (block_data_size_ != -1) {
         LOG(ERROR) << "More than 1 Block in a BlockGroup is not "
                       "supported.";
         return false;
       }
-      block_data_.reset(new uint8_t[size]);
-      memcpy(block_data_.get(), data, size);
+      block_data_.assign(data, data + size);
       block_data_size_ = size;
       return true;
 
@@ -308,6 +308,7 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
                                 int flags,
                                 const uint8_t* data,
                                 int size,
+                                std::vector<uint8_t>* data_owner,
                                 const uint8_t* additional,
                                 int additional_size,
                                 int64_t discard_padding) {
@@ -387,8 +388,19 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
       return false;
     }
 
-    buffer = MediaSample::CopyFrom(data + data_offset, size - data_offset,
-                                   additional, additional_size, is_keyframe);
+    const uint8_t* frame_data = data + data_offset;
+    const int frame_size = size - data_offset;
+    if (data_owner && additional_size == 0 && frame_size > 0) {
+      // Adopt the staged Block payload instead of copying it into the sample.
+      // The block header and any encryption prefix are stripped in place.
+      const size_t frame_offset = frame_data - data_owner->data();
+      data_owner->erase(data_owner->begin(),
+                        data_owner->begin() + frame_offset);
+      buffer = MediaSample::TransferData(data_owner, is_keyframe);
+    } else {
+      buffer = MediaSample::CopyFrom(frame_data, frame_size, additional,
+                                     additional_size, is_keyframe);
+    }
 
     // An empty iv indicates that this sample is not encrypted.
     if (decrypt_config && !decrypt_config->iv().empty()) {
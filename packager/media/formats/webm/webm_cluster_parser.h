@@ -9,6 +9,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "packager/base/compiler_specific.h"
 #include "packager/base/memory/scoped_ptr.h"
@@ -157,9 +158,12 @@ class WebMClusterParser : public WebMParserClient {
   bool OnUInt(int id, int64_t val) override;
   bool OnBinary(int id, const uint8_t* data, int size) override;
 
+  // If |buf_owner| is not NULL, it owns the bytes at |buf| and its contents
+  // may be adopted into the emitted sample to avoid a payload copy.
   bool ParseBlock(bool is_simple_block,
                   const uint8_t* buf,
                   int size,
+                  std::vector<uint8_t>* buf_owner,
                   const uint8_t* additional,
                   int additional_size,
                   int duration,
@@ -171,6 +175,7 @@ class WebMClusterParser : public WebMParserClient {
                int flags,
                const uint8_t* data,
                int size,
+               std::vector<uint8_t>* data_owner,
                const uint8_t* additional,
                int additional_size,
                int64_t discard_padding);
@@ -202,7 +207,10 @@ class WebMClusterParser : public WebMParserClient {
   MediaParser::InitCB init_cb_;
 
   int64_t last_block_timecode_ = -1;
-  scoped_ptr<uint8_t[]> block_data_;
+  // The staged Block of the current BlockGroup; |block_data_size_| is -1 if
+  // no Block has been seen yet. The vector's contents may be adopted into the
+  // emitted sample, so it can be empty when |block_data_size_| is >= 0.
+  std::vector<uint8_t> block_data_;
   int block_data_size_ = -1;
   int64_t block_duration_ = -1;
   int64_t block_add_id_ = -1;
@@ -157,22 +157,41 @@ int WebMMediaParser::ParseInfoAndTracks(const uint8_t* data, int size) {
     case kWebMIdInfo:
       // We've found the element we are looking for.
       break;
+    case kWebMIdTracks:
+      if (!info_parser_) {
+        LOG(ERROR) << "Found Tracks element before Info.";
+        return -1;
+      }
+      break;
     default: {
       LOG(ERROR) << "Unexpected element ID 0x" << std::hex << id;
       return -1;
     }
   }
 
-  WebMInfoParser info_parser;
-  result = info_parser.Parse(cur, cur_size);
+  // Examine each input byte only once regardless of append granularity: wait
+  // until the whole element is buffered, then parse it in one shot. The Info
+  // and Tracks parsers do all or nothing parsing, so handing them a partial
+  // element would re-walk it on every append. Neither element may have an
+  // unknown size.
+  if (element_size == kWebMUnknownSize)
+    return -1;
+  if (cur_size < (result + element_size)) {
+    // We don't have the whole element yet. Signal we need more data.
+    return 0;
+  }
 
-  if (result <= 0)
+  if (id == kWebMIdInfo) {
+    scoped_ptr<WebMInfoParser> info_parser(new WebMInfoParser);
+    result = info_parser->Parse(cur, cur_size);
+    if (result <= 0)
+      return result;
+    // Keep the parsed Info around for when the Tracks element arrives.
+    info_parser_ = info_parser.Pass();
     return result;
+  }
 
-  cur += result;
-  cur_size -= result;
-  bytes_parsed += result;
-
+  DCHECK_EQ(id, kWebMIdTracks);
   WebMTracksParser tracks_parser(ignore_text_tracks_);
   result = tracks_parser.Parse(cur, cur_size);
 
@@ -181,8 +200,8 @@ int WebMMediaParser::ParseInfoAndTracks(const uint8_t* data, int size) {
 
   bytes_parsed += result;
 
-  double timecode_scale_in_us = info_parser.timecode_scale() / 1000.0;
-  int64_t duration_in_us = info_parser.duration() * timecode_scale_in_us;
+  double timecode_scale_in_us = info_parser_->timecode_scale() / 1000.0;
+  int64_t duration_in_us = info_parser_->duration() * timecode_scale_in_us;
 
   scoped_refptr<AudioStreamInfo> audio_stream_info =
       tracks_parser.audio_stream_info();
@@ -206,7 +225,7 @@ int WebMMediaParser::ParseInfoAndTracks(const uint8_t* data, int size) {
   }
 
   cluster_parser_.reset(new WebMClusterParser(
-      info_parser.timecode_scale(), audio_stream_info, video_stream_info,
+      info_parser_->timecode_scale(), audio_stream_info, video_stream_info,
       tracks_parser.GetAudioDefaultDuration(timecode_scale_in_us),
       tracks_parser.GetVideoDefaultDuration(timecode_scale_in_us),
       tracks_parser.text_tracks(), tracks_parser.ignored_tracks(),
@@ -15,6 +15,7 @@ namespace shaka {
 namespace media {
 
 class WebMClusterParser;
+class WebMInfoParser;
 
 class WebMMediaParser : public MediaParser {
  public:
@@ -71,6 +72,9 @@ class WebMMediaParser : public MediaParser {
 
   bool unknown_segment_size_;
 
+  // Set once the Info element has been fully parsed, so the bytes preceding
+  // Tracks are not re-walked while the Tracks element accumulates.
+  scoped_ptr<WebMInfoParser> info_parser_;
   scoped_ptr<WebMClusterParser> cluster_parser_;
   ByteQueue byte_queue_;
 
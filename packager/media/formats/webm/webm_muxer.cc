@@ -76,7 +76,7 @@ Status WebMMuxer::Finalize() {
 }
 
 Status WebMMuxer::DoAddSample(const MediaStream* stream,
-                              scoped_refptr<MediaSample> sample) {
+                              const scoped_refptr<MediaSample>& sample) {
   DCHECK(segmenter_);
   DCHECK(stream == streams()[0]);
   return segmenter_->AddSample(sample);
@@ -11,10 +11,14 @@
 // encrypted request for comments specification is here
 // http://wiki.webmproject.org/encryption/webm-encryption-rfc
 
+#include <string.h>
+
 #include <iomanip>
 
+#include "packager/base/bits.h"
 #include "packager/base/logging.h"
 #include "packager/base/numerics/safe_conversions.h"
+#include "packager/base/sys_byteorder.h"
 #include "packager/media/formats/webm/webm_constants.h"
 
 namespace shaka {
@@ -438,40 +442,40 @@ static int ParseWebMElementHeaderField(const uint8_t* buf,
   if (size == 0)
     return 0;
 
-  int mask = 0x80;
-  uint8_t ch = buf[0];
-  int extra_bytes = -1;
-  bool all_ones = false;
-  for (int i = 0; i < max_bytes; ++i) {
-    if ((ch & mask) != 0) {
-      mask = ~mask & 0xff;
-      *num = mask_first_byte ? ch & mask : ch;
-      all_ones = (ch & mask) == mask;
-      extra_bytes = i;
-      break;
-    }
-    mask = 0x80 | mask >> 1;
-  }
+  // The position of the first set bit in the first byte encodes the field
+  // length: 0x80-0xff is a one byte field, 0x40-0x7f two bytes, and so on
+  // down to 0x01 for eight bytes. 0x00 would start a field longer than
+  // eight bytes, which Matroska does not allow.
+  if (buf[0] == 0)
+    return -1;
 
-  if (extra_bytes == -1)
+  const int field_length = 8 - base::bits::Log2Floor(buf[0]);
+  if (field_length > max_bytes)
     return -1;
 
   // Return 0 if we need more data.
-  if ((1 + extra_bytes) > size)
+  if (field_length > size)
     return 0;
 
-  int bytes_used = 1;
-
-  for (int i = 0; i < extra_bytes; ++i) {
-    ch = buf[bytes_used++];
-    all_ones &= (ch == 0xff);
-    *num = (*num << 8) | ch;
-  }
-
-  if (all_ones)
-    *num = kint64max;
-
-  return bytes_used;
+  // Assemble the big-endian field with a single load and byte swap instead
+  // of shifting it in byte by byte.
+  uint64_t value = 0;
+  memcpy(reinterpret_cast<uint8_t*>(&value) + sizeof(value) - field_length,
+         buf, field_length);
+  value = base::NetToHost64(value);
+
+  // A field with all data bits set encodes the reserved value: the unknown
+  // size for element size fields and the reserved ID for ID fields. The ID
+  // fields keep their length descriptor bits, so their all-ones pattern is
+  // one bit wider.
+  const uint64_t all_ones =
+      mask_first_byte ? (UINT64_C(1) << (7 * field_length)) - 1
+                      : (UINT64_C(1) << (7 * field_length + 1)) - 1;
+  if (mask_first_byte)
+    value &= all_ones;
+
+  *num = (value == all_ones) ? kint64max : static_cast<int64_t>(value);
+  return field_length;
 }
 
 int WebMParseElementHeader(const uint8_t* buf,
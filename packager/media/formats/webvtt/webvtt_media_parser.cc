@@ -6,17 +6,27 @@
 
 #include "packager/media/formats/webvtt/webvtt_media_parser.h"
 
+#include <gflags/gflags.h>
+
 #include <string>
 #include <vector>
 
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_piece.h"
 #include "packager/base/strings/string_split.h"
 #include "packager/base/strings/string_util.h"
 #include "packager/media/base/macros.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/text_stream_info.h"
 
+DEFINE_int32(webvtt_max_pending_bytes,
+             1024 * 1024,
+             "Upper bound on the bytes the WebVTT parser may buffer for the "
+             "cue under construction, the header and unconsumed input. "
+             "Malformed files missing blank-line cue terminators otherwise "
+             "accumulate a single cue without bound. 0 disables the check.");
+
 namespace shaka {
 namespace media {
 
@@ -28,29 +38,29 @@ const int kTrackId = 0;
 const char kCR = 0x0D;
 const char kLF = 0x0A;
 
-// Reads the first line from |data| and removes the line. Returns false if there
-// isn't a line break. Sets |line| with the content of the first line without
-// the line break.
-bool ReadLine(std::string* data, std::string* line) {
-  if (data->size() == 0) {
-    return false;
-  }
-  size_t string_position = 0;
+// Reads the first line from |data| starting at |*position|, advancing
+// |*position| past the line break. Returns false if there isn't a line break.
+// Sets |line| to the content of the line, without the line break, as a view
+// into |data|; no per-line copy is made.
+bool ReadLine(const std::string& data,
+              size_t* position,
+              base::StringPiece* line) {
+  size_t string_position = *position;
   // Length of the line break mark. 1 for LF and CR, 2 for CRLF.
   int line_break_length = 1;
   bool found_line_break = false;
-  while (string_position < data->size()) {
-    if (data->at(string_position) == kLF) {
+  while (string_position < data.size()) {
+    if (data[string_position] == kLF) {
       found_line_break = true;
       break;
     }
 
-    if (data->at(string_position) == kCR) {
+    if (data[string_position] == kCR) {
       found_line_break = true;
-      if (string_position + 1 >= data->size())
+      if (string_position + 1 >= data.size())
         break;
 
-      if (data->at(string_position + 1) == kLF)
+      if (data[string_position + 1] == kLF)
         line_break_length = 2;
       break;
     }
@@ -61,12 +71,21 @@ bool ReadLine(std::string* data, std::string* line) {
   if (!found_line_break)
     return false;
 
-  *line = data->substr(0, string_position);
-  data->erase(0, string_position + line_break_length);
+  *line = base::StringPiece(data.data() + *position, string_position - *position);
+  *position = string_position + line_break_length;
   return true;
 }
 
-bool TimestampToMilliseconds(const std::string& original_str,
+// Appends |line| to |destination|, separated with a newline if |destination|
+// already has content. Multiline data is accumulated as the lines arrive so
+// emitting a sample does not have to join per-line strings.
+void AppendLine(const base::StringPiece& line, std::string* destination) {
+  if (!destination->empty())
+    destination->push_back('\n');
+  line.AppendToString(destination);
+}
+
+bool TimestampToMilliseconds(const base::StringPiece& str,
                              uint64_t* time_ms) {
   const size_t kMinimalHoursLength = 2;
   const size_t kMinutesLength = 2;
@@ -78,7 +97,6 @@ bool TimestampToMilliseconds(const std::string& original_str,
   const size_t kMinimalLength =
       kMinutesLength + kSecondsLength + kMillisecondsLength + 2;
 
-  base::StringPiece str(original_str);
   if (str.size() < kMinimalLength)
     return false;
 
@@ -144,14 +162,14 @@ bool TimestampToMilliseconds(const std::string& original_str,
 
 // Clears |settings| and 0s |start_time| and |duration| regardless of the
 // parsing result.
-bool ParseTimingAndSettingsLine(const std::string& line,
+bool ParseTimingAndSettingsLine(const base::StringPiece& line,
                                 uint64_t* start_time,
                                 uint64_t* duration,
                                 std::string* settings) {
   *start_time = 0;
   *duration = 0;
   settings->clear();
-  std::vector<std::string> entries = base::SplitString(
+  std::vector<base::StringPiece> entries = base::SplitStringPiece(
       line, " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
   if (entries.size() < 3) {
     // The timing is time1 --> time3 so if there aren't 3 entries, this is parse
@@ -165,13 +183,13 @@ bool ParseTimingAndSettingsLine(const std::string& line,
     return false;
   }
 
-  const std::string& start_time_str = entries[0];
+  const base::StringPiece& start_time_str = entries[0];
   if (!TimestampToMilliseconds(start_time_str, start_time)) {
     LOG(ERROR) << "Failed to parse " << start_time_str << " in " << line;
     return false;
   }
 
-  const std::string& end_time_str = entries[2];
+  const base::StringPiece& end_time_str = entries[2];
   uint64_t end_time = 0;
   if (!TimestampToMilliseconds(end_time_str, &end_time)) {
     LOG(ERROR) << "Failed to parse " << end_time_str << " in " << line;
@@ -179,8 +197,12 @@ bool ParseTimingAndSettingsLine(const std::string& line,
   }
   *duration = end_time - *start_time;
 
-  entries.erase(entries.begin(), entries.begin() + 3);
-  *settings = base::JoinString(entries, " ");
+  // The remaining entries are the settings.
+  for (size_t i = 3; i < entries.size(); ++i) {
+    if (!settings->empty())
+      settings->push_back(' ');
+    entries[i].AppendToString(settings);
+  }
   return true;
 }
 
@@ -191,15 +213,14 @@ bool ParseTimingAndSettingsLine(const std::string& line,
 scoped_refptr<MediaSample> CueToMediaSample(const Cue& cue) {
   const bool kKeyFrame = true;
   if (!cue.comment.empty()) {
-    const std::string comment = base::JoinString(cue.comment, "\n");
     return MediaSample::FromMetadata(
-        reinterpret_cast<const uint8_t*>(comment.data()), comment.size());
+        reinterpret_cast<const uint8_t*>(cue.comment.data()),
+        cue.comment.size());
   }
 
-  const std::string payload = base::JoinString(cue.payload, "\n");
   scoped_refptr<MediaSample> media_sample = MediaSample::CopyFrom(
-      reinterpret_cast<const uint8_t*>(payload.data()),
-      payload.size(),
+      reinterpret_cast<const uint8_t*>(cue.payload.data()),
+      cue.payload.size(),
       reinterpret_cast<const uint8_t*>(cue.settings.data()),
       cue.settings.size(),
       !kKeyFrame);
@@ -215,6 +236,15 @@ scoped_refptr<MediaSample> CueToMediaSample(const Cue& cue) {
 Cue::Cue() : start_time(0), duration(0) {}
 Cue::~Cue() {}
 
+void Cue::Reset() {
+  identifier.clear();
+  start_time = 0;
+  duration = 0;
+  settings.clear();
+  payload.clear();
+  comment.clear();
+}
+
 WebVttMediaParser::WebVttMediaParser() : state_(kHeader) {}
 WebVttMediaParser::~WebVttMediaParser() {}
 
@@ -234,15 +264,15 @@ bool WebVttMediaParser::Flush() {
     // If it was in the middle of the payload and the stream finished, then this
     // is an end of the payload. The rest of the data is part of the payload.
     if (state_ == kCuePayload) {
-      current_cue_.payload.push_back(data_);
+      AppendLine(data_, &current_cue_.payload);
     } else {
-      current_cue_.comment.push_back(data_);
+      AppendLine(data_, &current_cue_.comment);
     }
     data_.clear();
   }
 
   bool result = new_sample_cb_.Run(kTrackId, CueToMediaSample(current_cue_));
-  current_cue_ = Cue();
+  current_cue_.Reset();
   state_ = kCueIdentifierOrTimingOrComment;
   return result;
 }
@@ -255,11 +285,14 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
 
   data_.insert(data_.end(), buf, buf + size);
 
-  std::string line;
-  while (ReadLine(&data_, &line)) {
+  // Lines are views into |data_|; the consumed prefix is erased in one go
+  // after the loop instead of shifting the buffer once per line.
+  size_t position = 0;
+  base::StringPiece line;
+  while (ReadLine(data_, &position, &line)) {
     // Only kCueIdentifierOrTimingOrComment and kCueTiming states accept -->.
     // Error otherwise.
-    const bool has_arrow = line.find("-->") != std::string::npos;
+    const bool has_arrow = line.find("-->") != base::StringPiece::npos;
     if (state_ == kCueTiming) {
       if (!has_arrow) {
         LOG(ERROR) << "Expected --> in: " << line;
@@ -277,7 +310,7 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
     switch (state_) {
       case kHeader:
         // No check. This should be WEBVTT when this object was created.
-        header_.push_back(line);
+        header_.push_back(line.as_string());
         state_ = kMetadata;
         break;
       case kMetadata: {
@@ -309,7 +342,7 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
           break;
         }
 
-        header_.push_back(line);
+        header_.push_back(line.as_string());
         break;
       }
       case kCueIdentifierOrTimingOrComment: {
@@ -323,11 +356,11 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
           if (base::StartsWith(line, "NOTE",
                                       base::CompareCase::INSENSITIVE_ASCII)) {
             state_ = kComment;
-            current_cue_.comment.push_back(line);
+            AppendLine(line, &current_cue_.comment);
           } else {
             // A cue can start from a cue identifier.
             // https://w3c.github.io/webvtt/#webvtt-cue-identifier
-            current_cue_.identifier = line;
+            line.CopyToString(&current_cue_.identifier);
             // The next line must be a timing.
             state_ = kCueTiming;
           }
@@ -358,11 +391,11 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
             state_ = kParseError;
             return false;
           }
-          current_cue_ = Cue();
+          current_cue_.Reset();
           break;
         }
 
-        current_cue_.payload.push_back(line);
+        AppendLine(line, &current_cue_.payload);
         break;
       }
       case kComment: {
@@ -372,11 +405,11 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
             state_ = kParseError;
             return false;
           }
-          current_cue_ = Cue();
+          current_cue_.Reset();
           break;
         }
 
-        current_cue_.comment.push_back(line);
+        AppendLine(line, &current_cue_.comment);
         break;
       }
       case kParseError:
@@ -385,6 +418,29 @@ bool WebVttMediaParser::Parse(const uint8_t* buf, int size) {
     }
   }
 
+  data_.erase(0, position);
+
+  // Cues are emitted as soon as they complete, so the bytes held here are
+  // one partial cue plus the header and any unconsumed input. Cap them so a
+  // file that never terminates its cue cannot grow the parser without bound.
+  if (FLAGS_webvtt_max_pending_bytes > 0) {
+    size_t pending_bytes = data_.size() + current_cue_.identifier.size() +
+                           current_cue_.settings.size() +
+                           current_cue_.payload.size() +
+                           current_cue_.comment.size();
+    for (std::vector<std::string>::const_iterator it = header_.begin();
+         it != header_.end(); ++it) {
+      pending_bytes += it->size();
+    }
+    if (pending_bytes > static_cast<size_t>(FLAGS_webvtt_max_pending_bytes)) {
+      LOG(ERROR) << "WebVTT parser exceeded --webvtt_max_pending_bytes with "
+                 << pending_bytes
+                 << " bytes pending; the input is likely missing blank-line "
+                    "cue terminators.";
+      state_ = kParseError;
+      return false;
+    }
+  }
   return true;
 }
 
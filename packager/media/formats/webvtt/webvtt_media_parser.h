@@ -19,17 +19,21 @@ namespace media {
 
 // If comment is not empty, then this is metadata and other fields must
 // be empty.
-// Data that can be multiline are vector of strings.
+// Multiline data is accumulated with '\n' separators as the lines arrive.
 struct Cue {
   Cue();
   ~Cue();
 
+  // Clears all the fields, retaining the allocated buffers so a Cue can be
+  // reused across samples without reallocating.
+  void Reset();
+
   std::string identifier;
   uint64_t start_time;
   uint64_t duration;
   std::string settings;
-  std::vector<std::string> payload;
-  std::vector<std::string> comment;
+  std::string payload;
+  std::string comment;
 };
 
 // WebVTT parser.
@@ -4,6 +4,7 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <gflags/gflags.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -12,6 +13,8 @@
 #include "packager/media/base/stream_info.h"
 #include "packager/media/formats/webvtt/webvtt_media_parser.h"
 
+DECLARE_int32(webvtt_max_pending_bytes);
+
 namespace shaka {
 namespace media {
 
@@ -314,5 +317,26 @@ TEST_F(WebVttMediaParserTest, NoTimingAfterIdentifier) {
   EXPECT_TRUE(parser_.Flush());
 }
 
+// Verify that a cue that never sees its blank-line terminator cannot grow
+// the parser past --webvtt_max_pending_bytes.
+TEST_F(WebVttMediaParserTest, PendingBytesBounded) {
+  EXPECT_CALL(init_callback_, Call(_));
+  EXPECT_CALL(new_sample_callback_, Call(_, _)).Times(0);
+
+  const int original_limit = FLAGS_webvtt_max_pending_bytes;
+  FLAGS_webvtt_max_pending_bytes = 64;
+  const char kWebVtt[] =
+      "WEBVTT\n"
+      "\n"
+      "00:01:00.000 --> 01:00:00.000\n"
+      "a payload line without a terminating blank line\n"
+      "a payload line without a terminating blank line\n"
+      "a payload line without a terminating blank line\n";
+  InitializeParser();
+  EXPECT_FALSE(parser_.Parse(reinterpret_cast<const uint8_t*>(kWebVtt),
+                             arraysize(kWebVtt) - 1));
+  FLAGS_webvtt_max_pending_bytes = original_limit;
+}
+
 }  // namespace media
 }  // namespace shaka
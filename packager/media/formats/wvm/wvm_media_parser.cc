@@ -4,11 +4,19 @@
 
 #include "packager/media/formats/wvm/wvm_media_parser.h"
 
+#include <algorithm>
 #include <map>
 #include <sstream>
 #include <vector>
 
+#include <gflags/gflags.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/location.h"
+#include "packager/base/stl_util.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/worker_pool.h"
 #include "packager/media/base/aes_decryptor.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/key_source.h"
@@ -20,6 +28,14 @@
 #include "packager/media/codecs/es_descriptor.h"
 #include "packager/media/formats/mp2t/adts_header.h"
 
+DEFINE_int32(wvm_decryption_threads,
+             1,
+             "Number of threads used to decrypt WVM asset content. With more "
+             "than one thread, each crypto unit is split into block-aligned "
+             "chunks decrypted concurrently on the worker pool; CBC "
+             "decryption only needs the preceding ciphertext block per "
+             "chunk, so the result is identical to serial decryption.");
+
 #define HAS_HEADER_EXTENSION(x) ((x != 0xBC) && (x != 0xBE) && (x != 0xBF) \
          && (x != 0xF0) && (x != 0xF2) && (x != 0xF8) \
          && (x != 0xFF))
@@ -82,6 +98,21 @@ enum Type {
   Type_string = 9,
   Type_BinaryData = 10
 };
+
+// Decodes the 5-byte PES timestamp at |data| (33 bits spread over the
+// marker-bit layout shared by PTS and DTS).
+uint64_t ParsePesTimestamp(const uint8_t* data) {
+  uint64_t timestamp = data[0] & 0x0E;
+  timestamp <<= 7;
+  timestamp |= data[1];
+  timestamp <<= 7;
+  timestamp |= data[2] >> 1;
+  timestamp <<= 8;
+  timestamp |= data[3];
+  timestamp <<= 7;
+  timestamp |= data[4] >> 1;
+  return timestamp;
+}
 }  // namespace
 
 namespace shaka {
@@ -133,11 +164,20 @@ bool WvmMediaParser::Parse(const uint8_t* buf, int size) {
 
   while (read_ptr < end) {
     switch (parse_state_) {
-      case StartCode1:
-        if (*read_ptr == kStartCode1) {
-          parse_state_ = StartCode2;
+      case StartCode1: {
+        // Scan to the first zero byte in one step rather than one byte per
+        // loop iteration; in a well-formed stream this matches immediately,
+        // but it keeps resynchronization after garbage from going per-byte.
+        const uint8_t* zero = static_cast<const uint8_t*>(
+            memchr(read_ptr, kStartCode1, end - read_ptr));
+        if (zero == NULL) {
+          read_ptr = end;
+          continue;
         }
+        read_ptr = zero;
+        parse_state_ = StartCode2;
         break;
+      }
       case StartCode2:
         if (*read_ptr == kStartCode2) {
           parse_state_ = StartCode3;
@@ -169,6 +209,15 @@ bool WvmMediaParser::Parse(const uint8_t* buf, int size) {
         }
         break;
       case PackHeader1:
+        // Only the stuffing length in the last byte of the fixed part is
+        // used; consume the whole run in one step when it is buffered. The
+        // per-byte states below remain for buffers split mid-header.
+        if (end - read_ptr >= 10) {
+          read_ptr += 9;
+          skip_bytes_ = *read_ptr & 0x07;
+          parse_state_ = PackHeaderStuffingSkip;
+          break;
+        }
         parse_state_ = PackHeader2;
         break;
       case PackHeader2:
@@ -277,6 +326,21 @@ bool WvmMediaParser::Parse(const uint8_t* buf, int size) {
         }
         break;
       case Pts1:
+        // Decode the whole 5-byte timestamp at once when it is buffered; the
+        // per-byte states below remain for buffers split mid-timestamp.
+        if (end - read_ptr >= 5) {
+          pts_ = timestamp_ = ParsePesTimestamp(read_ptr);
+          pes_header_data_bytes_ -= 5;
+          pes_packet_bytes_ -= 5;
+          read_ptr += 4;
+          if (pes_flags_2_ & kPesOptDts) {
+            parse_state_ = Dts1;
+          } else {
+            dts_ = pts_;
+            parse_state_ = PesHeaderData;
+          }
+          break;
+        }
         timestamp_ = (*read_ptr & 0x0E);
         --pes_header_data_bytes_;
         --pes_packet_bytes_;
@@ -317,6 +381,14 @@ bool WvmMediaParser::Parse(const uint8_t* buf, int size) {
         }
         break;
       case Dts1:
+        if (end - read_ptr >= 5) {
+          dts_ = timestamp_ = ParsePesTimestamp(read_ptr);
+          pes_header_data_bytes_ -= 5;
+          pes_packet_bytes_ -= 5;
+          read_ptr += 4;
+          parse_state_ = PesHeaderData;
+          break;
+        }
         timestamp_ = (*read_ptr & 0x0E);
         --pes_header_data_bytes_;
         --pes_packet_bytes_;
@@ -773,6 +845,93 @@ bool WvmMediaParser::ParseIndexEntry() {
   return true;
 }
 
+namespace {
+
+// A block-aligned chunk of a crypto unit being decrypted on the worker pool.
+// |done| is signaled once |ok| and the chunk data are final.
+struct PendingDecryptChunk {
+  PendingDecryptChunk() : data(NULL), size(0), ok(false), done(false, false) {}
+
+  std::vector<uint8_t> key;
+  std::vector<uint8_t> iv;
+  uint8_t* data;
+  size_t size;
+  bool ok;
+  base::WaitableEvent done;
+};
+
+// Decrypts |chunk| in place with its own decryptor; runs on the worker pool.
+// The key schedule is computed on the worker as well, so the posting thread
+// does no cipher work for the chunk.
+void DecryptChunkTask(PendingDecryptChunk* chunk) {
+  AesCbcDecryptor decryptor(kCtsPadding, AesCryptor::kUseConstantIv);
+  chunk->ok = decryptor.InitializeWithIv(chunk->key, chunk->iv) &&
+              decryptor.Crypt(chunk->data, chunk->size, chunk->data);
+  chunk->done.Signal();
+}
+
+}  // namespace
+
+void WvmMediaParser::DecryptCryptoUnit(size_t start_pos) {
+  DCHECK(content_decryptor_);
+  const size_t unit_size = sample_data_.size() - start_pos;
+  if (unit_size == 0)
+    return;
+  uint8_t* data = &sample_data_[start_pos];
+
+  // Below this size the key schedule and task handoff cost more than the
+  // decryption they save.
+  const size_t kMinBytesPerChunk = 64 * 1024;
+  const size_t kAesBlockSize = 16;
+  const size_t max_chunks =
+      FLAGS_wvm_decryption_threads <= 1
+          ? 1
+          : std::min<size_t>(FLAGS_wvm_decryption_threads,
+                             unit_size / kMinBytesPerChunk);
+  if (max_chunks <= 1) {
+    content_decryptor_->Crypt(data, unit_size, data);
+    return;
+  }
+
+  // CBC decryption of a block only needs the preceding ciphertext block, so
+  // the unit can be cut at block boundaries and the chunks decrypted
+  // concurrently. All chunks but the last are whole multiples of the block
+  // size and decrypt as plain CBC; the last chunk keeps the ciphertext
+  // stealing handling of the residual bytes. Each chunk's IV (the ciphertext
+  // block preceding it) is snapshotted before any chunk is decrypted in
+  // place.
+  const size_t chunk_size =
+      (unit_size / max_chunks) / kAesBlockSize * kAesBlockSize;
+  std::vector<PendingDecryptChunk*> chunks;
+  for (size_t pos = 0; pos < unit_size; ) {
+    const bool last_chunk = unit_size - pos < 2 * chunk_size;
+    PendingDecryptChunk* chunk = new PendingDecryptChunk;
+    chunk->key = content_key_;
+    chunk->iv = pos == 0 ? content_decryptor_->iv()
+                         : std::vector<uint8_t>(data + pos - kAesBlockSize,
+                                                data + pos);
+    chunk->data = data + pos;
+    chunk->size = last_chunk ? unit_size - pos : chunk_size;
+    chunks.push_back(chunk);
+    pos += chunk->size;
+  }
+  for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+    base::WorkerPool::PostTask(FROM_HERE,
+                               base::Bind(&DecryptChunkTask, chunks[i]),
+                               true /* task_is_slow */);
+  }
+  // Decrypt the last chunk on this thread instead of idling on the pool.
+  DecryptChunkTask(chunks.back());
+
+  bool ok = true;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    chunks[i]->done.Wait();
+    ok = ok && chunks[i]->ok;
+  }
+  STLDeleteElements(&chunks);
+  LOG_IF(ERROR, !ok) << "Failed to decrypt crypto unit.";
+}
+
 bool WvmMediaParser::DemuxNextPes(bool is_program_end) {
   bool output_encrypted_sample = false;
   if (!sample_data_.empty() && (prev_pes_flags_1_ & kScramblingBitsMask)) {
@@ -780,9 +939,7 @@ bool WvmMediaParser::DemuxNextPes(bool is_program_end) {
     if (!content_decryptor_) {
       output_encrypted_sample = true;
     } else {
-      content_decryptor_->Crypt(&sample_data_[crypto_unit_start_pos_],
-                                sample_data_.size() - crypto_unit_start_pos_,
-                                &sample_data_[crypto_unit_start_pos_]);
+      DecryptCryptoUnit(crypto_unit_start_pos_);
     }
   }
   // Demux media sample if we are at program end or if we are not at a
@@ -1140,6 +1297,7 @@ bool WvmMediaParser::ProcessEcm() {
     return false;
   }
 
+  content_key_ = decrypted_content_key_vec;
   content_decryptor_ = content_decryptor.Pass();
   return true;
 }
@@ -63,6 +63,11 @@ class WvmMediaParser : public MediaParser {
   /// @}
 
  private:
+  // Decrypt the crypto unit at [start_pos, sample_data_.size()) in place,
+  // fanning block-aligned chunks out to the worker pool when the unit is
+  // large enough and --wvm_decryption_threads allows it.
+  void DecryptCryptoUnit(size_t start_pos);
+
   enum Tag {
     CypherVersion = 0,
     TrackOffset = 1,
@@ -253,6 +258,9 @@ class WvmMediaParser : public MediaParser {
   std::vector<uint8_t> sample_data_;
   KeySource* decryption_key_source_;
   scoped_ptr<AesCbcDecryptor> content_decryptor_;
+  // Content key of |content_decryptor_|, kept to initialize the per-chunk
+  // decryptors used for parallel decryption.
+  std::vector<uint8_t> content_key_;
 
   DISALLOW_COPY_AND_ASSIGN(WvmMediaParser);
 };
@@ -0,0 +1,323 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// End-to-end remux benchmark. Each benchmark runs a complete packaging job
+// (demux, remux, segment and optionally encrypt) with all input and output
+// going through MemoryFile, so disk speed does not pollute the numbers. One
+// JSON object per job is printed to stdout with throughput, peak RSS and the
+// per-stage rates from the pipeline stats surface:
+//
+//   packager_bench > packager_bench.json
+//
+// With a threshold file argument the benchmark exits non-zero if any job
+// falls below its configured floor, for automated regression detection:
+//
+//   packager_bench media/test/packager_bench_thresholds
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+#include "packager/base/at_exit.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/demuxer.h"
+#include "packager/media/base/fixed_key_source.h"
+#include "packager/media/base/fourccs.h"
+#include "packager/media/base/media_stream.h"
+#include "packager/media/base/muxer.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/file/file.h"
+#include "packager/media/file/memory_file.h"
+#include "packager/media/formats/mp2t/ts_muxer.h"
+#include "packager/media/formats/mp4/mp4_muxer.h"
+#include "packager/media/formats/webm/webm_muxer.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Each job is repeated until it has run at least this long, so the committed
+// test inputs still produce stable numbers. Multi-gigabyte inputs are
+// approximated by repetition rather than by materializing huge synthetic
+// files.
+const int64_t kMinBenchTimeMicroseconds = 1000000;
+
+// Muxer options shared by all jobs.
+const double kSegmentDurationInSeconds = 1.0;
+const double kFragmentDurationInSeconds = 0.1;
+
+// Encryption key for the encrypted job.
+const char kKeyIdHex[] = "e5007e6e9dcd5ac095202ed3758382cd";
+const char kKeyHex[] = "6fc96fe628a265b13aeddec0bc421f4d";
+const double kClearLeadInSeconds = 1.5;
+
+// Per-stage rates collected from one job run.
+struct StageRates {
+  StageRates() : demux_mb_per_s(0), mux_mb_per_s(0) {}
+  double demux_mb_per_s;
+  double mux_mb_per_s;
+};
+
+MediaStream* FindFirstStreamOfType(const std::vector<MediaStream*>& streams,
+                                   StreamType stream_type) {
+  for (size_t i = 0; i < streams.size(); ++i) {
+    if (streams[i]->info()->stream_type() == stream_type)
+      return streams[i];
+  }
+  return NULL;
+}
+
+// Publishes |data| under the memory file |file_name|.
+bool WriteMemoryFile(const std::string& file_name,
+                     const std::vector<uint8_t>& data) {
+  File* file = File::Open(file_name.c_str(), "w");
+  if (!file)
+    return false;
+  if (file->Write(data.data(), data.size()) !=
+      static_cast<int64_t>(data.size())) {
+    file->Close();
+    return false;
+  }
+  return file->Close();
+}
+
+MuxerOptions SetupOptions(const std::string& output,
+                          const std::string& segment_template) {
+  MuxerOptions options;
+  options.single_segment = false;
+  options.segment_duration = kSegmentDurationInSeconds;
+  options.fragment_duration = kFragmentDurationInSeconds;
+  options.segment_sap_aligned = true;
+  options.fragment_sap_aligned = true;
+  options.num_subsegments_per_sidx = 2;
+  options.output_file_name = output;
+  options.segment_template = segment_template;
+  return options;
+}
+
+double MegabytesPerSecond(const StageStats& stats) {
+  return stats.bytes_per_second() / (1024.0 * 1024.0);
+}
+
+// MP4 input remuxed into encrypted segmented MP4, the DASH media branch.
+bool RunMp4DashEncryptedJob(const std::string& input, StageRates* rates) {
+  Demuxer demuxer(input);
+  if (!demuxer.Initialize().ok())
+    return false;
+
+  scoped_ptr<KeySource> key_source(
+      FixedKeySource::CreateFromHexStrings(kKeyIdHex, kKeyHex, "", ""));
+  if (!key_source)
+    return false;
+
+  scoped_ptr<Muxer> muxer_video;
+  MediaStream* video = FindFirstStreamOfType(demuxer.streams(), kStreamVideo);
+  if (video) {
+    muxer_video.reset(new mp4::MP4Muxer(SetupOptions(
+        "memory://dash/video_init.mp4", "memory://dash/video_$Number$.m4s")));
+    muxer_video->AddStream(video);
+    muxer_video->SetKeySource(key_source.get(), KeySource::TRACK_TYPE_SD,
+                              kClearLeadInSeconds, 0, FOURCC_cenc);
+  }
+  scoped_ptr<Muxer> muxer_audio;
+  MediaStream* audio = FindFirstStreamOfType(demuxer.streams(), kStreamAudio);
+  if (audio) {
+    muxer_audio.reset(new mp4::MP4Muxer(SetupOptions(
+        "memory://dash/audio_init.mp4", "memory://dash/audio_$Number$.m4s")));
+    muxer_audio->AddStream(audio);
+    muxer_audio->SetKeySource(key_source.get(), KeySource::TRACK_TYPE_SD,
+                              kClearLeadInSeconds, 0, FOURCC_cenc);
+  }
+  if (!muxer_video && !muxer_audio)
+    return false;
+
+  if (!demuxer.Run().ok())
+    return false;
+  rates->demux_mb_per_s = MegabytesPerSecond(demuxer.stats());
+  rates->mux_mb_per_s = MegabytesPerSecond(
+      muxer_video ? muxer_video->stats() : muxer_audio->stats());
+  return true;
+}
+
+// TS input remuxed into segmented TS, the media side of an HLS job.
+bool RunTsToHlsJob(const std::string& input, StageRates* rates) {
+  Demuxer demuxer(input);
+  if (!demuxer.Initialize().ok())
+    return false;
+
+  MediaStream* video = FindFirstStreamOfType(demuxer.streams(), kStreamVideo);
+  if (!video)
+    return false;
+  scoped_ptr<Muxer> muxer(new mp2t::TsMuxer(
+      SetupOptions("", "memory://hls/segment_$Number$.ts")));
+  muxer->AddStream(video);
+
+  if (!demuxer.Run().ok())
+    return false;
+  rates->demux_mb_per_s = MegabytesPerSecond(demuxer.stats());
+  rates->mux_mb_per_s = MegabytesPerSecond(muxer->stats());
+  return true;
+}
+
+// WebM input remuxed into segmented WebM.
+bool RunWebMJob(const std::string& input, StageRates* rates) {
+  Demuxer demuxer(input);
+  if (!demuxer.Initialize().ok())
+    return false;
+
+  MediaStream* video = FindFirstStreamOfType(demuxer.streams(), kStreamVideo);
+  if (!video)
+    return false;
+  scoped_ptr<Muxer> muxer(new webm::WebMMuxer(SetupOptions(
+      "memory://webm/init.webm", "memory://webm/segment_$Number$.webm")));
+  muxer->AddStream(video);
+
+  if (!demuxer.Run().ok())
+    return false;
+  rates->demux_mb_per_s = MegabytesPerSecond(demuxer.stats());
+  rates->mux_mb_per_s = MegabytesPerSecond(muxer->stats());
+  return true;
+}
+
+// @return peak RSS of this process in kilobytes, or 0 if unavailable.
+int64_t GetPeakRssKilobytes() {
+#if !defined(_WIN32)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return usage.ru_maxrss;
+#else
+  return 0;
+#endif
+}
+
+typedef bool (*JobFunc)(const std::string& input, StageRates* rates);
+
+// Runs |func| repeatedly and records its throughput under |name|.
+void RunJob(const char* name,
+            JobFunc func,
+            const char* test_data_file,
+            std::map<std::string, double>* results) {
+  const std::vector<uint8_t> data = ReadTestDataFile(test_data_file);
+  if (data.empty()) {
+    fprintf(stderr, "Skipping %s: no input data from %s.\n", name,
+            test_data_file);
+    return;
+  }
+  const std::string input =
+      std::string("memory://input/") + test_data_file;
+  if (!WriteMemoryFile(input, data)) {
+    fprintf(stderr, "Skipping %s: cannot stage %s in memory.\n", name,
+            test_data_file);
+    return;
+  }
+
+  // Make sure the job actually works before timing it.
+  StageRates rates;
+  if (!func(input, &rates)) {
+    fprintf(stderr, "Skipping %s: job failed on %s.\n", name, test_data_file);
+    return;
+  }
+
+  int iterations = 0;
+  int64_t elapsed_us = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  do {
+    func(input, &rates);
+    ++iterations;
+    elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
+  } while (elapsed_us < kMinBenchTimeMicroseconds);
+
+  const double seconds = elapsed_us / 1000000.0;
+  const double megabytes =
+      static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0);
+  const double mb_per_s = megabytes / seconds;
+  (*results)[name] = mb_per_s;
+  printf(
+      "{\"name\": \"%s\", \"input\": \"%s\", \"iterations\": %d, "
+      "\"bytes_per_iteration\": %d, \"elapsed_us\": %lld, "
+      "\"throughput_mb_per_s\": %.2f, \"demux_mb_per_s\": %.2f, "
+      "\"mux_mb_per_s\": %.2f, \"peak_rss_kb\": %lld}\n",
+      name, test_data_file, iterations, static_cast<int>(data.size()),
+      static_cast<long long>(elapsed_us), mb_per_s, rates.demux_mb_per_s,
+      rates.mux_mb_per_s, static_cast<long long>(GetPeakRssKilobytes()));
+}
+
+// Threshold file format: one "job_name minimum_mb_per_s" pair per line;
+// blank lines and lines starting with '#' are ignored.
+// @return the number of jobs below their floor, or -1 if the file cannot be
+//         read.
+int CheckThresholds(const char* path,
+                    const std::map<std::string, double>& results) {
+  std::string content;
+  if (!File::ReadFileToString(path, &content)) {
+    fprintf(stderr, "Cannot read threshold file %s.\n", path);
+    return -1;
+  }
+
+  int num_failures = 0;
+  std::vector<std::string> lines;
+  base::SplitString(content, '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::string line;
+    base::TrimWhitespaceASCII(lines[i], base::TRIM_ALL, &line);
+    if (line.empty() || line[0] == '#')
+      continue;
+    const size_t separator = line.find(' ');
+    if (separator == std::string::npos)
+      continue;
+    const std::string job_name = line.substr(0, separator);
+    double min_mb_per_s = 0;
+    if (!base::StringToDouble(line.substr(separator + 1), &min_mb_per_s))
+      continue;
+    std::map<std::string, double>::const_iterator result =
+        results.find(job_name);
+    if (result == results.end()) {
+      fprintf(stderr, "Threshold check: job %s did not run.\n",
+              job_name.c_str());
+      ++num_failures;
+    } else if (result->second < min_mb_per_s) {
+      fprintf(stderr, "Threshold check: %s at %.2f MB/s, floor %.2f MB/s.\n",
+              job_name.c_str(), result->second, min_mb_per_s);
+      ++num_failures;
+    }
+  }
+  return num_failures;
+}
+
+int RunAllJobs(const char* threshold_path) {
+  std::map<std::string, double> results;
+  RunJob("mp4_to_dash_encrypted", &RunMp4DashEncryptedJob, "bear-640x360.mp4",
+         &results);
+  RunJob("ts_to_hls", &RunTsToHlsJob, "bear-640x360.ts", &results);
+  RunJob("webm_to_webm", &RunWebMJob, "bear-320x240.webm", &results);
+  MemoryFile::DeleteAll();
+
+  if (!threshold_path)
+    return results.empty() ? 1 : 0;
+  return CheckThresholds(threshold_path, results) == 0 ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit;
+  return shaka::media::RunAllJobs(argc > 1 ? argv[1] : NULL);
+}
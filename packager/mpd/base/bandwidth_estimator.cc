@@ -6,6 +6,7 @@
 
 #include "packager/mpd/base/bandwidth_estimator.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 
@@ -16,7 +17,14 @@ const int BandwidthEstimator::kUseAllBlocks = 0;
 BandwidthEstimator::BandwidthEstimator(int num_blocks)
     : num_blocks_for_estimation_(num_blocks),
       harmonic_mean_denominator_(0.0),
-      num_blocks_added_(0) {}
+      num_blocks_added_(0),
+      oldest_index_(0),
+      version_(0) {
+  // Reserve the full ring capacity so push_back never reallocates; a
+  // concurrent TakeSnapshot() may scan the buffer while a block is added.
+  if (num_blocks_for_estimation_ != kUseAllBlocks)
+    ring_buffer_.reserve(abs(num_blocks_for_estimation_));
+}
 BandwidthEstimator::~BandwidthEstimator() {}
 
 void BandwidthEstimator::AddBlock(uint64_t size, double duration) {
@@ -24,40 +32,109 @@ void BandwidthEstimator::AddBlock(uint64_t size, double duration) {
   DCHECK_GT(size, 0u);
 
   if (num_blocks_for_estimation_ < 0 &&
-      static_cast<int>(history_.size()) >= -1 * num_blocks_for_estimation_) {
+      static_cast<int>(ring_buffer_.size()) >= -1 * num_blocks_for_estimation_) {
     // Short circuiting the case where |num_blocks_for_estimation_| number of
     // blocks have been added already.
     return;
   }
 
   const int kBitsInByte = 8;
-  const double bits_per_second_reciprocal = duration / (kBitsInByte * size);
-  harmonic_mean_denominator_ += bits_per_second_reciprocal;
+  const double bits_per_second = (kBitsInByte * size) / duration;
+
+  // Seqlock write section: bump the version to an odd value, mutate, then
+  // publish the next even value. Queries that raced with the mutation see an
+  // odd or changed version and retry their snapshot, so accumulation never
+  // takes a lock.
+  const base::subtle::Atomic32 version =
+      base::subtle::NoBarrier_Load(&version_);
+  base::subtle::NoBarrier_Store(&version_, version + 1);
+  base::subtle::MemoryBarrier();
+
+  harmonic_mean_denominator_ += 1.0 / bits_per_second;
   if (num_blocks_for_estimation_ == kUseAllBlocks) {
-    DCHECK_EQ(history_.size(), 0u);
+    DCHECK_EQ(ring_buffer_.size(), 0u);
     ++num_blocks_added_;
-    return;
+  } else if (num_blocks_for_estimation_ > 0 &&
+             static_cast<int>(ring_buffer_.size()) ==
+                 num_blocks_for_estimation_) {
+    // At capacity; overwrite the oldest block in place.
+    harmonic_mean_denominator_ -= 1.0 / ring_buffer_[oldest_index_];
+    ring_buffer_[oldest_index_] = bits_per_second;
+    oldest_index_ = (oldest_index_ + 1) % ring_buffer_.size();
+  } else {
+    ring_buffer_.push_back(bits_per_second);
   }
 
-  history_.push_back(bits_per_second_reciprocal);
-  if (num_blocks_for_estimation_ > 0 &&
-      static_cast<int>(history_.size()) > num_blocks_for_estimation_) {
-    harmonic_mean_denominator_ -= history_.front();
-    history_.pop_front();
+  base::subtle::Release_Store(&version_, version + 2);
+
+  if (num_blocks_for_estimation_ != kUseAllBlocks) {
+    DCHECK_LE(static_cast<int>(ring_buffer_.size()),
+              abs(num_blocks_for_estimation_));
+    DCHECK_EQ(num_blocks_added_, 0u);
   }
+}
+
+void BandwidthEstimator::TakeSnapshot(Snapshot* snapshot) const {
+  while (true) {
+    const base::subtle::Atomic32 version_before =
+        base::subtle::Acquire_Load(&version_);
+    if (version_before & 1) {
+      // An AddBlock() is in flight; try again.
+      continue;
+    }
 
-  DCHECK_NE(num_blocks_for_estimation_, kUseAllBlocks);
-  DCHECK_LE(static_cast<int>(history_.size()), abs(num_blocks_for_estimation_));
-  DCHECK_EQ(num_blocks_added_, 0u);
-  return;
+    snapshot->harmonic_mean_denominator = harmonic_mean_denominator_;
+    snapshot->num_blocks_added = num_blocks_added_;
+    snapshot->blocks.assign(ring_buffer_.begin(), ring_buffer_.end());
+
+    // The copy is consistent only if no AddBlock() completed in between;
+    // otherwise parts of it may be torn and the whole copy is discarded.
+    base::subtle::MemoryBarrier();
+    if (base::subtle::NoBarrier_Load(&version_) == version_before)
+      return;
+  }
 }
 
 uint64_t BandwidthEstimator::Estimate() const {
-  if (harmonic_mean_denominator_ == 0.0)
+  Snapshot snapshot;
+  TakeSnapshot(&snapshot);
+  if (snapshot.harmonic_mean_denominator == 0.0)
     return 0;
 
   const uint64_t num_blocks = num_blocks_for_estimation_ == kUseAllBlocks
-                                  ? num_blocks_added_
-                                  : history_.size();
-  return static_cast<uint64_t>(ceil(num_blocks / harmonic_mean_denominator_));
+                                  ? snapshot.num_blocks_added
+                                  : snapshot.blocks.size();
+  return static_cast<uint64_t>(
+      ceil(num_blocks / snapshot.harmonic_mean_denominator));
+}
+
+uint64_t BandwidthEstimator::Max() const {
+  Snapshot snapshot;
+  TakeSnapshot(&snapshot);
+  if (snapshot.blocks.empty())
+    return 0;
+
+  const double max =
+      *std::max_element(snapshot.blocks.begin(), snapshot.blocks.end());
+  return static_cast<uint64_t>(ceil(max));
+}
+
+uint64_t BandwidthEstimator::Percentile(int percentile) const {
+  DCHECK_GE(percentile, 0);
+  DCHECK_LE(percentile, 100);
+  Snapshot snapshot;
+  TakeSnapshot(&snapshot);
+  if (snapshot.blocks.empty())
+    return 0;
+
+  // The snapshot is already a private copy, so selecting in place keeps
+  // AddBlock() constant time.
+  std::vector<double>& sorted = snapshot.blocks;
+  // Nearest-rank percentile: the smallest value such that |percentile| percent
+  // of the blocks are at or below it.
+  size_t index = 0;
+  if (percentile > 0)
+    index = (percentile * sorted.size() + 99) / 100 - 1;
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return static_cast<uint64_t>(ceil(sorted[index]));
 }
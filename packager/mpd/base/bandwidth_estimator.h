@@ -10,8 +10,16 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <list>
+#include <vector>
 
+#include "packager/base/atomicops.h"
+
+/// The estimator is safe for one thread calling AddBlock() concurrently with
+/// any number of threads calling the query methods: queries take a consistent
+/// snapshot of the accumulated blocks guarded by a sequence counter instead
+/// of a lock, so publishing a manifest never blocks segment notifications and
+/// vice versa. Concurrent AddBlock() calls still require external
+/// synchronization.
 class BandwidthEstimator {
  public:
   /// @param num_blocks is the number of latest blocks to use. Negative values
@@ -28,16 +36,51 @@ class BandwidthEstimator {
   //         rounded up to the nearest integer.
   uint64_t Estimate() const;
 
+  // @return The maximum block bitrate, in bits per second, over the blocks
+  //         kept by the estimator, rounded up to the nearest integer. Returns
+  //         0 if no blocks are kept, which includes estimators constructed
+  //         with kUseAllBlocks.
+  uint64_t Max() const;
+
+  // @param percentile should be in the range [0, 100].
+  // @return The given percentile of the block bitrates, in bits per second,
+  //         over the blocks kept by the estimator, rounded up to the nearest
+  //         integer. Returns 0 if no blocks are kept, which includes
+  //         estimators constructed with kUseAllBlocks.
+  uint64_t Percentile(int percentile) const;
+
   static const int kUseAllBlocks;
 
  private:
+  // A consistent copy of the accumulated state, taken by the query methods.
+  struct Snapshot {
+    double harmonic_mean_denominator;
+    size_t num_blocks_added;
+    std::vector<double> blocks;
+  };
+
+  // Copies the accumulated state into |*snapshot|, retrying until the copy
+  // did not race with an AddBlock() call.
+  void TakeSnapshot(Snapshot* snapshot) const;
+
   const int num_blocks_for_estimation_;
   double harmonic_mean_denominator_;
 
   // This is not used when num_blocks_for_estimation_ != 0. Therefore it should
   // always be 0 if num_blocks_for_estimation_ != 0.
   size_t num_blocks_added_;
-  std::list<double> history_;
+
+  // Ring buffer of block bitrates in bits per second. Once
+  // |num_blocks_for_estimation_| blocks have been added, the newest block
+  // overwrites the oldest in place, so adding a block never allocates. Empty
+  // when all blocks are used for the estimate. The full capacity is reserved
+  // up front so growing never reallocates under a concurrent snapshot.
+  std::vector<double> ring_buffer_;
+  size_t oldest_index_;
+
+  // Sequence counter guarding the members above: odd while AddBlock() is
+  // mutating them, incremented to the next even value when it is done.
+  base::subtle::Atomic32 version_;
 };
 
 #endif  // MPD_BASE_BANDWIDTH_ESTIMATOR_H_
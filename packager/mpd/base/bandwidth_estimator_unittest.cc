@@ -9,6 +9,7 @@
 #include <cmath>
 
 #include "packager/base/macros.h"
+#include "packager/base/threading/simple_thread.h"
 #include "packager/mpd/base/bandwidth_estimator.h"
 
 namespace shaka {
@@ -80,6 +81,45 @@ TEST(BandwidthEstimatorTest, AllBlocks) {
   EXPECT_EQ(kExptectedEstimate, be.Estimate());
 }
 
+// Max() and Percentile() cover the last 5 blocks only; older blocks slide out
+// of the window.
+TEST(BandwidthEstimatorTest, FiveBlocksMaxAndPercentile) {
+  BandwidthEstimator be(kNumBlocksForEstimate);
+  const double kDuration = 1.0;
+  const uint64_t kNumBlocksToAdd = 200;
+
+  // The last 5 blocks are 8000, 16000, ..., 40000 bits per second. Everything
+  // before them should not affect the results.
+  for (uint64_t i = 1; i <= kNumBlocksToAdd; ++i) {
+    if (i > kNumBlocksToAdd - kNumBlocksForEstimate) {
+      const uint64_t bytes =
+          (i - (kNumBlocksToAdd - kNumBlocksForEstimate)) * 1000;
+      be.AddBlock(bytes, kDuration);
+    } else {
+      be.AddBlock(1000000, kDuration);
+    }
+  }
+
+  EXPECT_EQ(40000u, be.Max());
+  EXPECT_EQ(8000u, be.Percentile(0));
+  EXPECT_EQ(24000u, be.Percentile(50));
+  EXPECT_EQ(40000u, be.Percentile(95));
+  EXPECT_EQ(40000u, be.Percentile(100));
+}
+
+// No blocks are kept when all blocks are used for the estimate, so Max() and
+// Percentile() have nothing to answer from.
+TEST(BandwidthEstimatorTest, AllBlocksMaxAndPercentile) {
+  BandwidthEstimator be(BandwidthEstimator::kUseAllBlocks);
+  const uint64_t kNumBlocksToAdd = 100;
+  const double kDuration = 1.0;
+  for (uint64_t i = 1; i <= kNumBlocksToAdd; ++i)
+    be.AddBlock(i, kDuration);
+
+  EXPECT_EQ(0u, be.Max());
+  EXPECT_EQ(0u, be.Percentile(95));
+}
+
 // Use only the first one.
 TEST(BandwidthEstimatorTest, FirstOneBlock) {
   BandwidthEstimator be(kFirstOneBlockForEstimate);
@@ -93,4 +133,61 @@ TEST(BandwidthEstimatorTest, FirstOneBlock) {
   EXPECT_EQ(kExptectedEstimate, be.Estimate());
 }
 
+namespace {
+
+// Adds blocks of a fixed bitrate from a separate thread.
+class AddBlockThread : public base::SimpleThread {
+ public:
+  AddBlockThread(BandwidthEstimator* estimator,
+                 int num_blocks,
+                 uint64_t block_size)
+      : base::SimpleThread("AddBlockThread"),
+        estimator_(estimator),
+        num_blocks_(num_blocks),
+        block_size_(block_size) {}
+
+  void Run() override {
+    const double kDuration = 1.0;
+    for (int i = 0; i < num_blocks_; ++i)
+      estimator_->AddBlock(block_size_, kDuration);
+  }
+
+ private:
+  BandwidthEstimator* const estimator_;
+  const int num_blocks_;
+  const uint64_t block_size_;
+};
+
+}  // namespace
+
+// Queries must return consistent values while blocks are added concurrently.
+// All blocks carry the same bitrate, chosen as a power of two so the harmonic
+// mean is exact, so every consistent snapshot yields either 0 (no blocks yet)
+// or exactly that bitrate.
+TEST(BandwidthEstimatorTest, ConcurrentQueriesDuringAddBlock) {
+  // 2^17 bytes over one second = 2^20 bits per second.
+  const uint64_t kBlockSize = 131072;
+  const uint64_t kBitrate = kBlockSize * kBitsInByte;
+  const int kNumBlocksToAdd = 10000;
+
+  BandwidthEstimator be(kNumBlocksForEstimate);
+  AddBlockThread thread(&be, kNumBlocksToAdd, kBlockSize);
+  thread.Start();
+
+  for (int i = 0; i < 1000; ++i) {
+    const uint64_t estimate = be.Estimate();
+    if (estimate != 0)
+      EXPECT_EQ(kBitrate, estimate);
+    const uint64_t max = be.Max();
+    if (max != 0)
+      EXPECT_EQ(kBitrate, max);
+    const uint64_t percentile = be.Percentile(95);
+    if (percentile != 0)
+      EXPECT_EQ(kBitrate, percentile);
+  }
+
+  thread.Join();
+  EXPECT_EQ(kBitrate, be.Estimate());
+}
+
 } // namespace shaka
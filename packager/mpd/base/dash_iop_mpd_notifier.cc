@@ -6,6 +6,7 @@
 
 #include "packager/mpd/base/dash_iop_mpd_notifier.h"
 
+#include "packager/base/logging.h"
 #include "packager/mpd/base/media_info.pb.h"
 #include "packager/mpd/base/mpd_notifier_util.h"
 #include "packager/mpd/base/mpd_utils.h"
@@ -16,15 +17,6 @@ namespace {
 
 const int kStartingGroupId = 1;
 
-// The easiest way to check whether two protobufs are equal, is to compare the
-// serialized version.
-bool ProtectedContentEq(
-    const MediaInfo::ProtectedContent& content_protection1,
-    const MediaInfo::ProtectedContent& content_protection2) {
-  return content_protection1.SerializeAsString() ==
-         content_protection2.SerializeAsString();
-}
-
 std::set<std::string> GetUUIDs(
     const MediaInfo::ProtectedContent& protected_content) {
   std::set<std::string> uuids;
@@ -50,6 +42,7 @@ DashIopMpdNotifier::DashIopMpdNotifier(
                                       ? MpdBuilder::kDynamic
                                       : MpdBuilder::kStatic,
                                   mpd_options)),
+      publisher_(new MpdPublisher(output_path)),
       next_group_id_(kStartingGroupId) {
   DCHECK(dash_profile == kLiveProfile || dash_profile == kOnDemandProfile);
   for (size_t i = 0; i < base_urls.size(); ++i)
@@ -155,44 +148,42 @@ bool DashIopMpdNotifier::AddContentProtectionElement(
 
 bool DashIopMpdNotifier::Flush() {
   base::AutoLock auto_lock(lock_);
-  return WriteMpdToFile(output_path_, mpd_builder_.get());
+  std::string mpd;
+  if (!mpd_builder_->ToString(&mpd)) {
+    LOG(ERROR) << "Failed to write MPD to string.";
+    return false;
+  }
+
+  // For live, the MPD is flushed after every segment, so queue the write on
+  // the publisher thread and keep manifest I/O off the segment path. For
+  // on-demand, the MPD is written once at the end; wait for the write and
+  // report its result.
+  publisher_->Publish(mpd);
+  if (dash_profile() == kLiveProfile)
+    return true;
+  return publisher_->WaitForPublished();
 }
 
 AdaptationSet* DashIopMpdNotifier::GetAdaptationSetForMediaInfo(
     const std::string& key,
     const MediaInfo& media_info) {
-  std::list<AdaptationSet*>& adaptation_sets = adaptation_set_list_map_[key];
-  if (adaptation_sets.empty())
-    return NewAdaptationSet(media_info, &adaptation_sets);
-
-  const bool has_protected_content = media_info.has_protected_content();
-
-  for (std::list<AdaptationSet*>::const_iterator adaptation_set_it =
-           adaptation_sets.begin();
-       adaptation_set_it != adaptation_sets.end(); ++adaptation_set_it) {
-    ProtectedContentMap::const_iterator protected_content_it =
-        protected_content_map_.find((*adaptation_set_it)->id());
-
-    // If the AdaptationSet ID is not registered in the map, then it is clear
-    // content (or encrypted but doesn't need <ContentProtection> element
-    // possibly because the player knows how to handle it).
-    if (protected_content_it == protected_content_map_.end()) {
-      // Can reuse the AdaptationSet without content protection.
-      if (!has_protected_content)
-        return *adaptation_set_it;
-      continue;
-    }
-
-    if (ProtectedContentEq(protected_content_it->second,
-                           media_info.protected_content())) {
-      // Content protection info matches. Reuse the AdaptationSet.
-      return *adaptation_set_it;
-    }
+  // AdaptationSets sharing the same |key| differ only in their content
+  // protection, so the serialized ProtectedContent identifies the one (if
+  // any) that can take this Representation. Clear content (or encrypted
+  // content that doesn't need a <ContentProtection> element) fingerprints to
+  // the empty string.
+  const std::string fingerprint =
+      media_info.has_protected_content()
+          ? media_info.protected_content().SerializeAsString()
+          : std::string();
+  AdaptationSet** adaptation_set =
+      &fingerprint_map_[std::make_pair(key, fingerprint)];
+  if (*adaptation_set == NULL) {
+    // No AdaptationSet matches the new content protection. Need a new one.
+    *adaptation_set =
+        NewAdaptationSet(media_info, &adaptation_set_list_map_[key]);
   }
-
-  // None of the adaptation sets match with the new content protection.
-  // Need a new one.
-  return NewAdaptationSet(media_info, &adaptation_sets);
+  return *adaptation_set;
 }
 
 // Get all the UUIDs of the AdaptationSet. If another AdaptationSet has the
@@ -12,11 +12,13 @@
 #include <list>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "packager/base/synchronization/lock.h"
 #include "packager/mpd/base/mpd_builder.h"
 #include "packager/mpd/base/mpd_notifier_util.h"
+#include "packager/mpd/base/mpd_publisher.h"
 #include "packager/mpd/base/mpd_options.h"
 
 namespace shaka {
@@ -65,6 +67,14 @@ class DashIopMpdNotifier : public MpdNotifier {
   // Maps AdaptationSet ID to ProtectedContent.
   typedef std::map<uint32_t, MediaInfo::ProtectedContent> ProtectedContentMap;
 
+  // Maps (AdaptationSet key, serialized ProtectedContent) to the
+  // AdaptationSet holding Representations with exactly that content
+  // protection. Clear content uses an empty serialization. This makes
+  // Representation placement a single lookup instead of a scan comparing the
+  // ProtectedContent proto against every existing AdaptationSet.
+  typedef std::map<std::pair<std::string, std::string>, AdaptationSet*>
+      ProtectedContentFingerprintMap;
+
   // Checks the protected_content field of media_info and returns a non-null
   // AdaptationSet* for a new Representation.
   // This does not necessarily return a new AdaptationSet. If
@@ -99,9 +109,13 @@ class DashIopMpdNotifier : public MpdNotifier {
   // Used to check whether a Representation should be added to an AdaptationSet.
   ProtectedContentMap protected_content_map_;
 
+  // Index for GetAdaptationSetForMediaInfo().
+  ProtectedContentFingerprintMap fingerprint_map_;
+
   // MPD output path.
   std::string output_path_;
   scoped_ptr<MpdBuilder> mpd_builder_;
+  scoped_ptr<MpdPublisher> publisher_;
   base::Lock lock_;
 
   // Next group ID to use for AdapationSets that can be grouped.
@@ -6,12 +6,19 @@
 
 #include "packager/mpd/base/language_utils.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "packager/base/lazy_instance.h"
 #include "packager/base/logging.h"
 
 namespace {
 
 // A map from 3-letter language codes (ISO 639-2) to 2-letter language codes
-// (ISO 639-1) for all languages which have both in the registry.
+// (ISO 639-1) for all languages which have both in the registry. Sorted by
+// |iso_639_2| so lookups can binary search.
 typedef struct {
   const char iso_639_2[4];  // 3 letters + nul
   const char iso_639_1[3];  // 2 letters + nul
@@ -70,6 +77,55 @@ const LanguageMapPairType kLanguageMap[] = {
   { "yor", "yo" }, { "zha", "za" }, { "zho", "zh" }, { "zul", "zu" },
 };
 
+bool LessByIso639_2(const LanguageMapPairType& pair, const std::string& code) {
+  return strcmp(pair.iso_639_2, code.c_str()) < 0;
+}
+
+bool LessByIso639_1(const LanguageMapPairType* pair, const std::string& code) {
+  return strcmp(pair->iso_639_1, code.c_str()) < 0;
+}
+
+// Index of |kLanguageMap| sorted by 2-letter code, built once on first use.
+// A few 2-letter codes map to both a bibliographic and a terminology
+// 3-letter variant, e.g. "fr" to "fra" and "fre"; the earliest table entry
+// wins, matching the linear scan this index replaced.
+class Iso639_1Index {
+ public:
+  Iso639_1Index() {
+    index_.reserve(arraysize(kLanguageMap));
+    for (size_t i = 0; i < arraysize(kLanguageMap); ++i) {
+      if (i > 0) {
+        DCHECK_LT(strcmp(kLanguageMap[i - 1].iso_639_2,
+                         kLanguageMap[i].iso_639_2),
+                  0)
+            << "kLanguageMap must stay sorted by iso_639_2.";
+      }
+      index_.push_back(&kLanguageMap[i]);
+    }
+    std::stable_sort(index_.begin(), index_.end(), OrderByIso639_1);
+  }
+
+  // Returns the first table entry with the given 2-letter code, or NULL.
+  const LanguageMapPairType* Find(const std::string& iso_639_1) const {
+    std::vector<const LanguageMapPairType*>::const_iterator it =
+        std::lower_bound(index_.begin(), index_.end(), iso_639_1,
+                         LessByIso639_1);
+    if (it == index_.end() || iso_639_1 != (*it)->iso_639_1)
+      return NULL;
+    return *it;
+  }
+
+ private:
+  static bool OrderByIso639_1(const LanguageMapPairType* a,
+                              const LanguageMapPairType* b) {
+    return strcmp(a->iso_639_1, b->iso_639_1) < 0;
+  }
+
+  std::vector<const LanguageMapPairType*> index_;
+};
+
+base::LazyInstance<Iso639_1Index> g_iso_639_1_index = LAZY_INSTANCE_INITIALIZER;
+
 void SplitLanguageTag(const std::string& tag,
                       std::string* main_language, std::string* subtag) {
   // Split the main language from its subtag (if any).
@@ -97,11 +153,11 @@ std::string LanguageToShortestForm(const std::string& language) {
     return main_language + subtag;
   }
 
-  for (size_t i = 0; i < arraysize(kLanguageMap); ++i) {
-    if (main_language == kLanguageMap[i].iso_639_2) {
-      return kLanguageMap[i].iso_639_1 + subtag;
-    }
-  }
+  const LanguageMapPairType* map_end = kLanguageMap + arraysize(kLanguageMap);
+  const LanguageMapPairType* entry =
+      std::lower_bound(kLanguageMap, map_end, main_language, LessByIso639_2);
+  if (entry != map_end && main_language == entry->iso_639_2)
+    return entry->iso_639_1 + subtag;
 
   // This could happen legitimately for languages which have no 2-letter code,
   // but that would imply that the input language code is a 3-letter code.
@@ -119,11 +175,10 @@ std::string LanguageToISO_639_2(const std::string& language) {
     return main_language + subtag;
   }
 
-  for (size_t i = 0; i < arraysize(kLanguageMap); ++i) {
-    if (main_language == kLanguageMap[i].iso_639_1) {
-      return kLanguageMap[i].iso_639_2 + subtag;
-    }
-  }
+  const LanguageMapPairType* entry =
+      g_iso_639_1_index.Get().Find(main_language);
+  if (entry)
+    return entry->iso_639_2 + subtag;
 
   LOG(WARNING) << "No equivalent 3-letter language code for " << main_language;
   // This is probably a mistake on the part of the user and should be treated
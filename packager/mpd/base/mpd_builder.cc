@@ -6,6 +6,7 @@
 
 #include "packager/mpd/base/mpd_builder.h"
 
+#include <gflags/gflags.h>
 #include <libxml/tree.h>
 #include <libxml/xmlstring.h>
 
@@ -31,6 +32,15 @@
 #include "packager/mpd/base/xml/xml_node.h"
 #include "packager/version/version.h"
 
+DEFINE_int32(bandwidth_window_size,
+             0,
+             "Number of most recent media segments used to compute the "
+             "bandwidth reported in the MPD when the muxer does not provide "
+             "one, or 0 to use all segments. With a window, the reported "
+             "bandwidth is the 95th percentile of the windowed segment "
+             "bitrates instead of the job-lifetime harmonic mean, so live "
+             "manifests track the actual recent bitrate.");
+
 namespace shaka {
 
 using base::FilePath;
@@ -171,7 +181,7 @@ uint64_t LastSegmentEndTime(const SegmentInfo& segment_info) {
          segment_info.duration * (segment_info.repeat + 1);
 }
 
-uint64_t LatestSegmentStartTime(const std::list<SegmentInfo>& segments) {
+uint64_t LatestSegmentStartTime(const SegmentInfos& segments) {
   DCHECK(!segments.empty());
   const SegmentInfo& latest_segment = segments.back();
   return LastSegmentStartTime(latest_segment);
@@ -403,7 +413,10 @@ MpdBuilder::MpdBuilder(MpdType type, const MpdOptions& mpd_options)
     : type_(type),
       mpd_options_(mpd_options),
       adaptation_sets_deleter_(&adaptation_sets_),
-      clock_(new base::DefaultClock()) {}
+      clock_(new base::DefaultClock()) {
+  // The implicit first period; single-period MPDs never call AddPeriod().
+  periods_.push_back(PeriodInfo(0.0));
+}
 
 MpdBuilder::~MpdBuilder() {}
 
@@ -418,9 +431,14 @@ AdaptationSet* MpdBuilder::AddAdaptationSet(const std::string& lang) {
 
   DCHECK(adaptation_set);
   adaptation_sets_.push_back(adaptation_set.get());
+  periods_.back().adaptation_sets.push_back(adaptation_set.get());
   return adaptation_set.release();
 }
 
+void MpdBuilder::AddPeriod(double start_time_in_seconds) {
+  periods_.push_back(PeriodInfo(start_time_in_seconds));
+}
+
 bool MpdBuilder::WriteMpdToFile(media::File* output_file) {
   DCHECK(output_file);
   return WriteMpdToOutput(output_file);
@@ -458,21 +476,6 @@ xmlDocPtr MpdBuilder::GenerateMpd() {
   xml::scoped_xml_ptr<xmlDoc> doc(xmlNewDoc(BAD_CAST kXmlVersion));
   XmlNode mpd("MPD");
 
-  // Iterate thru AdaptationSets and add them to one big Period element.
-  XmlNode period("Period");
-
-  // Always set id=0 for now. Since this class can only generate one Period
-  // at the moment, just use a constant.
-  // Required for 'dynamic' MPDs.
-  period.SetId(0);
-  std::list<AdaptationSet*>::iterator adaptation_sets_it =
-      adaptation_sets_.begin();
-  for (; adaptation_sets_it != adaptation_sets_.end(); ++adaptation_sets_it) {
-    xml::scoped_xml_ptr<xmlNode> child((*adaptation_sets_it)->GetXml());
-    if (!child.get() || !period.AddChild(child.Pass()))
-      return NULL;
-  }
-
   // Add baseurls to MPD.
   std::list<std::string>::const_iterator base_urls_it = base_urls_.begin();
   for (; base_urls_it != base_urls_.end(); ++base_urls_it) {
@@ -483,13 +486,39 @@ xmlDocPtr MpdBuilder::GenerateMpd() {
       return NULL;
   }
 
-  if (type_ == kDynamic) {
-    // This is the only Period and it is a regular period.
-    period.SetStringAttribute("start", "PT0S");
-  }
+  // Generate one Period element per period, in the order the periods were
+  // started. AdaptationSets were grouped into periods as they were added.
+  // Period ids are required for 'dynamic' MPDs.
+  uint32_t period_id = 0;
+  for (std::list<PeriodInfo>::iterator period_it = periods_.begin();
+       period_it != periods_.end(); ++period_it) {
+    // Extra periods that never received content are dropped; the first
+    // period is always emitted so single-period MPDs keep their shape.
+    if (period_it->adaptation_sets.empty() && period_it != periods_.begin())
+      continue;
+
+    XmlNode period("Period");
+    period.SetId(period_id++);
+    std::list<AdaptationSet*>::iterator adaptation_sets_it =
+        period_it->adaptation_sets.begin();
+    for (; adaptation_sets_it != period_it->adaptation_sets.end();
+         ++adaptation_sets_it) {
+      xml::scoped_xml_ptr<xmlNode> child((*adaptation_sets_it)->GetXml());
+      if (!child.get() || !period.AddChild(child.Pass()))
+        return NULL;
+    }
 
-  if (!mpd.AddChild(period.PassScopedPtr()))
-    return NULL;
+    // The start attribute anchors the period on the presentation timeline;
+    // it is required for 'dynamic' MPDs and for any MPD with several
+    // periods.
+    if (type_ == kDynamic || periods_.size() > 1) {
+      period.SetStringAttribute(
+          "start", SecondsToXmlDuration(period_it->start_time_seconds));
+    }
+
+    if (!mpd.AddChild(period.PassScopedPtr()))
+      return NULL;
+  }
 
   AddMpdNameSpaceInfo(&mpd);
   AddCommonMpdInfo(&mpd);
@@ -1040,11 +1069,12 @@ Representation::Representation(
     scoped_ptr<RepresentationStateChangeListener> state_change_listener)
     : media_info_(media_info),
       id_(id),
-      bandwidth_estimator_(BandwidthEstimator::kUseAllBlocks),
+      bandwidth_estimator_(FLAGS_bandwidth_window_size),
       mpd_options_(mpd_options),
       start_number_(1),
       state_change_listener_(state_change_listener.Pass()),
-      output_suppression_flags_(0) {}
+      output_suppression_flags_(0),
+      cached_suppression_flags_(0) {}
 
 Representation::~Representation() {}
 
@@ -1094,12 +1124,14 @@ void Representation::AddContentProtectionElement(
     const ContentProtectionElement& content_protection_element) {
   content_protection_elements_.push_back(content_protection_element);
   RemoveDuplicateAttributes(&content_protection_elements_.back());
+  InvalidateXmlCache();
 }
 
 void Representation::UpdateContentProtectionPssh(const std::string& drm_uuid,
                                                  const std::string& pssh) {
   UpdateContentProtectionPsshHelper(drm_uuid, pssh,
                                     &content_protection_elements_);
+  InvalidateXmlCache();
 }
 
 void Representation::AddNewSegment(uint64_t start_time,
@@ -1110,6 +1142,7 @@ void Representation::AddNewSegment(uint64_t start_time,
     return;
   }
 
+  InvalidateXmlCache();
   if (state_change_listener_)
     state_change_listener_->OnNewSegmentForRepresentation(start_time, duration);
   if (IsContiguous(start_time, duration, size)) {
@@ -1129,6 +1162,7 @@ void Representation::AddNewSegment(uint64_t start_time,
 void Representation::SetSampleDuration(uint32_t sample_duration) {
   if (media_info_.has_video_info()) {
     media_info_.mutable_video_info()->set_frame_duration(sample_duration);
+    InvalidateXmlCache();
     if (state_change_listener_) {
       state_change_listener_->OnSetFrameRateForRepresentation(
           sample_duration, media_info_.video_info().time_scale());
@@ -1136,21 +1170,48 @@ void Representation::SetSampleDuration(uint32_t sample_duration) {
   }
 }
 
+// Returns a copy of the cached <Representation> element, rebuilding it first
+// if any field affecting the XML output changed since the last call. For live,
+// MpdBuilder regenerates the whole MPD on every segment notification, but only
+// the Representation that got the segment actually changed; the rest are
+// served from the cache.
+xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
+  if (!cached_xml_ || cached_suppression_flags_ != output_suppression_flags_) {
+    cached_xml_ = BuildXml();
+    cached_suppression_flags_ = output_suppression_flags_;
+  }
+  output_suppression_flags_ = 0;
+
+  if (!cached_xml_)
+    return xml::scoped_xml_ptr<xmlNode>();
+  const int kCopyRecursively = 1;
+  return xml::scoped_xml_ptr<xmlNode>(
+      xmlCopyNode(cached_xml_.get(), kCopyRecursively));
+}
+
 // Uses info in |media_info_| and |content_protection_elements_| to create a
 // "Representation" node.
 // MPD schema has strict ordering. The following must be done in order.
 // AddVideoInfo() (possibly adds FramePacking elements), AddAudioInfo() (Adds
 // AudioChannelConfig elements), AddContentProtectionElements*(), and
 // AddVODOnlyInfo() (Adds segment info).
-xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
+xml::scoped_xml_ptr<xmlNode> Representation::BuildXml() {
   if (!HasRequiredMediaInfoFields()) {
     LOG(ERROR) << "MediaInfo missing required fields.";
     return xml::scoped_xml_ptr<xmlNode>();
   }
 
-  const uint64_t bandwidth = media_info_.has_bandwidth()
-                                 ? media_info_.bandwidth()
-                                 : bandwidth_estimator_.Estimate();
+  uint64_t bandwidth;
+  if (media_info_.has_bandwidth()) {
+    bandwidth = media_info_.bandwidth();
+  } else if (FLAGS_bandwidth_window_size > 0) {
+    // Report the 95th percentile of the windowed segment bitrates: it tracks
+    // the recent operating point without letting a single outlier segment
+    // set the value.
+    bandwidth = bandwidth_estimator_.Percentile(95);
+  } else {
+    bandwidth = bandwidth_estimator_.Estimate();
+  }
 
   DCHECK(!(HasVODOnlyFields(media_info_) && HasLiveOnlyFields(media_info_)));
 
@@ -1201,10 +1262,13 @@ xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
   // TODO(rkuroiwa): It is likely that all representations have the exact same
   // SegmentTemplate. Optimize and propagate the tag up to AdaptationSet level.
 
-  output_suppression_flags_ = 0;
   return representation.PassScopedPtr();
 }
 
+void Representation::InvalidateXmlCache() {
+  cached_xml_.reset();
+}
+
 void Representation::SuppressOnce(SuppressFlag flag) {
   output_suppression_flags_ |= flag;
 }
@@ -1305,8 +1369,8 @@ void Representation::SlideWindow() {
 
   // First remove all the SegmentInfos that are completely out of range, by
   // looking at the very last segment's end time.
-  std::list<SegmentInfo>::iterator first = segment_infos_.begin();
-  std::list<SegmentInfo>::iterator last = first;
+  SegmentInfos::iterator first = segment_infos_.begin();
+  SegmentInfos::iterator last = first;
   size_t num_segments_removed = 0;
   for (; last != segment_infos_.end(); ++last) {
     const uint64_t last_segment_end_time = LastSegmentEndTime(*last);
@@ -78,6 +78,16 @@ class MpdBuilder {
   /// @return The new adaptation set, which is owned by this instance.
   virtual AdaptationSet* AddAdaptationSet(const std::string& lang);
 
+  /// Starts a new Period. AdaptationSets added after this call belong to the
+  /// new period, and the generated MPD contains one <Period> element per
+  /// period in the order they were started. The builder begins with an
+  /// implicit period starting at time zero, so single-period MPDs never need
+  /// to call this. Used for ad-conditioned content where content blocks and
+  /// ad breaks are separate periods of one presentation.
+  /// @param start_time_in_seconds is the presentation time the new period
+  ///        starts at.
+  virtual void AddPeriod(double start_time_in_seconds);
+
   /// Write the MPD to specified file.
   /// @param[out] output_file is MPD destination. output_file will be
   ///             flushed but not closed.
@@ -144,10 +154,20 @@ class MpdBuilder {
   // successful, false otherwise.
   bool GetEarliestTimestamp(double* timestamp_seconds);
 
+  // A Period under construction: its start time and the AdaptationSets
+  // added while it was the latest period. The AdaptationSet objects are
+  // owned by |adaptation_sets_|.
+  struct PeriodInfo {
+    explicit PeriodInfo(double start_time) : start_time_seconds(start_time) {}
+    double start_time_seconds;
+    std::list<AdaptationSet*> adaptation_sets;
+  };
+
   MpdType type_;
   MpdOptions mpd_options_;
   std::list<AdaptationSet*> adaptation_sets_;
   STLElementDeleter<std::list<AdaptationSet*> > adaptation_sets_deleter_;
+  std::list<PeriodInfo> periods_;
 
   std::list<std::string> base_urls_;
   std::string availability_start_time_;
@@ -524,6 +544,14 @@ class Representation {
 
   bool AddLiveInfo(xml::RepresentationXmlNode* representation);
 
+  // Builds a new <Representation> element from the current state. Called by
+  // GetXml() when |cached_xml_| is missing or stale.
+  xml::scoped_xml_ptr<xmlNode> BuildXml();
+
+  // Drops |cached_xml_| so that the next GetXml() call rebuilds the element.
+  // Must be called whenever a field that affects the XML output changes.
+  void InvalidateXmlCache();
+
   // Returns true if |media_info_| has required fields to generate a valid
   // Representation. Otherwise returns false.
   bool HasRequiredMediaInfoFields();
@@ -553,7 +581,7 @@ class Representation {
   // any logic using this can assume only one set.
   MediaInfo media_info_;
   std::list<ContentProtectionElement> content_protection_elements_;
-  std::list<SegmentInfo> segment_infos_;
+  SegmentInfos segment_infos_;
 
   const uint32_t id_;
   std::string mime_type_;
@@ -572,6 +600,15 @@ class Representation {
   // Bit vector for tracking witch attributes should not be output.
   int output_suppression_flags_;
 
+  // <Representation> element built by the last call to GetXml(), kept until a
+  // field that affects the XML output changes. For live MPD updates only a few
+  // Representations change per update, so the unchanged ones are copied from
+  // this cache instead of being rebuilt.
+  xml::scoped_xml_ptr<xmlNode> cached_xml_;
+
+  // The suppression flags that were in effect when |cached_xml_| was built.
+  int cached_suppression_flags_;
+
   DISALLOW_COPY_AND_ASSIGN(Representation);
 };
 
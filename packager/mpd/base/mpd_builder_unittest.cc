@@ -316,7 +316,7 @@ class SegmentTemplateTest : public DynamicMpdBuilderTest {
         << "Expected " << expected_output << std::endl << "Actual: " << mpd_doc;
   }
 
-  std::list<SegmentInfo> segment_infos_for_expected_out_;
+  SegmentInfos segment_infos_for_expected_out_;
   std::string expected_s_elements_;
   BandwidthEstimator bandwidth_estimator_;
 };
@@ -851,6 +851,56 @@ TEST_F(CommonMpdBuilderTest, AdaptationAddRoleElementMain) {
       << "Actual: " << mpd_output;
 }
 
+// Verify that starting new periods with AddPeriod() groups the
+// AdaptationSets added after each call into their own Period element, with
+// the period start times carried through.
+TEST_F(CommonMpdBuilderTest, MultiplePeriods) {
+  MpdBuilder mpd_builder(MpdBuilder::kStatic, MpdOptions());
+  AdaptationSet* content_adaptation_set = mpd_builder.AddAdaptationSet("");
+  content_adaptation_set->AddRole(AdaptationSet::kRoleMain);
+  const double kAdBreakStartTimeSeconds = 600.5;
+  mpd_builder.AddPeriod(kAdBreakStartTimeSeconds);
+  mpd_builder.AddAdaptationSet("");
+
+  const char kExpectedOutput[] =
+     "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+     "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\"\n"
+     "    xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
+     "    xmlns:xlink=\"http://www.w3.org/1999/xlink\"\n"
+     "    xsi:schemaLocation=\"urn:mpeg:dash:schema:mpd:2011 DASH-MPD.xsd\"\n"
+     "    minBufferTime=\"PT2S\" type=\"static\"\n"
+     "    profiles=\"urn:mpeg:dash:profile:isoff-on-demand:2011\"\n"
+     "    mediaPresentationDuration=\"PT0S\">\n"
+     "  <Period id=\"0\" start=\"PT0S\">\n"
+     "    <AdaptationSet id=\"0\" contentType=\"\">\n"
+     "      <Role schemeIdUri=\"urn:mpeg:dash:role:2011\" value=\"main\"/>\n"
+     "    </AdaptationSet>\n"
+     "  </Period>\n"
+     "  <Period id=\"1\" start=\"PT600.5S\">\n"
+     "    <AdaptationSet id=\"1\" contentType=\"\"/>\n"
+     "  </Period>\n"
+     "</MPD>";
+  std::string mpd_output;
+  EXPECT_TRUE(mpd_builder.ToString(&mpd_output));
+  ASSERT_TRUE(ValidateMpdSchema(mpd_output));
+  EXPECT_TRUE(XmlEqual(kExpectedOutput, mpd_output))
+      << "Expected " << kExpectedOutput << std::endl
+      << "Actual: " << mpd_output;
+}
+
+// Verify that periods started but never populated with AdaptationSets are
+// not emitted.
+TEST_F(CommonMpdBuilderTest, EmptyExtraPeriodDropped) {
+  MpdBuilder mpd_builder(MpdBuilder::kStatic, MpdOptions());
+  mpd_builder.AddAdaptationSet("");
+  mpd_builder.AddPeriod(600.0);
+
+  std::string mpd_output;
+  EXPECT_TRUE(mpd_builder.ToString(&mpd_output));
+  ASSERT_TRUE(ValidateMpdSchema(mpd_output));
+  EXPECT_EQ(std::string::npos, mpd_output.find("id=\"1\""));
+}
+
 // Add Role, ContentProtection, and Representation elements. Verify that
 // ContentProtection -> Role -> Representation are in order.
 TEST_F(CommonMpdBuilderTest, CheckContentProtectionRoleRepresentationOrder) {
@@ -6,6 +6,8 @@
 
 #include "packager/mpd/base/mpd_notifier_util.h"
 
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_util.h"
 #include "packager/media/file/file_closer.h"
@@ -17,15 +19,10 @@ namespace shaka {
 using media::File;
 using media::FileCloser;
 
-bool WriteMpdToFile(const std::string& output_path, MpdBuilder* mpd_builder) {
-  CHECK(!output_path.empty());
-
-  std::string mpd;
-  if (!mpd_builder->ToString(&mpd)) {
-    LOG(ERROR) << "Failed to write MPD to string.";
-    return false;
-  }
+namespace {
 
+// Writes |mpd| to |output_path|.
+bool WriteToFile(const std::string& output_path, const std::string& mpd) {
   scoped_ptr<File, FileCloser> file(File::Open(output_path.c_str(), "w"));
   if (!file) {
     LOG(ERROR) << "Failed to open file for writing: " << output_path;
@@ -48,6 +45,56 @@ bool WriteMpdToFile(const std::string& output_path, MpdBuilder* mpd_builder) {
   return file.release()->Close();
 }
 
+// Returns the local filesystem path for |output_path|, or an empty string if
+// |output_path| refers to a non-local scheme.
+std::string GetLocalPath(const std::string& output_path) {
+  if (output_path.find("://") == std::string::npos)
+    return output_path;
+  const std::string local_file_prefix(media::kLocalFilePrefix);
+  if (output_path.compare(0, local_file_prefix.size(), local_file_prefix) == 0)
+    return output_path.substr(local_file_prefix.size());
+  return std::string();
+}
+
+}  // namespace
+
+bool WriteMpdToFile(const std::string& output_path, MpdBuilder* mpd_builder) {
+  CHECK(!output_path.empty());
+
+  std::string mpd;
+  if (!mpd_builder->ToString(&mpd)) {
+    LOG(ERROR) << "Failed to write MPD to string.";
+    return false;
+  }
+  return WriteMpdStringToFile(output_path, mpd);
+}
+
+bool WriteMpdStringToFile(const std::string& output_path,
+                          const std::string& mpd) {
+  CHECK(!output_path.empty());
+
+  // Renames are only atomic on the local filesystem; other schemes are
+  // written in place.
+  const std::string local_path = GetLocalPath(output_path);
+  if (local_path.empty())
+    return WriteToFile(output_path, mpd);
+
+  // Write to a temporary file and rename it over the output so that readers
+  // never observe a partially written manifest.
+  const std::string temp_path = local_path + ".tmp";
+  if (!WriteToFile(temp_path, mpd))
+    return false;
+
+  base::File::Error error;
+  if (!base::ReplaceFile(base::FilePath(temp_path), base::FilePath(local_path),
+                         &error)) {
+    LOG(ERROR) << "Failed to rename '" << temp_path << "' to '" << local_path
+               << "' (" << error << ").";
+    return false;
+  }
+  return true;
+}
+
 ContentType GetContentType(const MediaInfo& media_info) {
   const bool has_video = media_info.has_video_info();
   const bool has_audio = media_info.has_audio_info();
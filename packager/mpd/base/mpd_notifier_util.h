@@ -31,6 +31,14 @@ enum ContentType {
 /// @param mpd_builder is the MPD builder instance.
 bool WriteMpdToFile(const std::string& output_path, MpdBuilder* mpd_builder);
 
+/// Writes a serialized MPD to @a output_path. Local outputs are written to a
+/// temporary file which is then renamed over @a output_path, so concurrent
+/// readers never observe a partially written manifest.
+/// @param output_path is the path to the MPD output location.
+/// @param mpd is the serialized MPD.
+bool WriteMpdStringToFile(const std::string& output_path,
+                          const std::string& mpd);
+
 /// Determines the content type of |media_info|.
 /// @param media_info is the information about the media.
 /// @return content type of the @a media_info.
@@ -0,0 +1,76 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/mpd/base/mpd_publisher.h"
+
+#include "packager/base/logging.h"
+#include "packager/mpd/base/mpd_notifier_util.h"
+
+namespace shaka {
+
+MpdPublisher::MpdPublisher(const std::string& output_path)
+    : base::SimpleThread("MpdPublisher"),
+      output_path_(output_path),
+      pending_available_(&lock_),
+      published_(&lock_),
+      has_pending_(false),
+      write_in_progress_(false),
+      stopped_(false),
+      last_write_success_(true) {
+  Start();
+}
+
+MpdPublisher::~MpdPublisher() {
+  {
+    base::AutoLock auto_lock(lock_);
+    stopped_ = true;
+    pending_available_.Signal();
+  }
+  Join();
+}
+
+void MpdPublisher::Publish(const std::string& mpd) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK(!stopped_);
+  // Coalesce: replace any version that has not been written out yet.
+  pending_mpd_ = mpd;
+  has_pending_ = true;
+  pending_available_.Signal();
+}
+
+bool MpdPublisher::WaitForPublished() {
+  base::AutoLock auto_lock(lock_);
+  while (has_pending_ || write_in_progress_)
+    published_.Wait();
+  return last_write_success_;
+}
+
+void MpdPublisher::Run() {
+  base::AutoLock auto_lock(lock_);
+  while (true) {
+    while (!has_pending_ && !stopped_)
+      pending_available_.Wait();
+    // Write out the last queued version even when stopping.
+    if (!has_pending_)
+      return;
+
+    std::string mpd;
+    mpd.swap(pending_mpd_);
+    has_pending_ = false;
+    write_in_progress_ = true;
+    bool success;
+    {
+      base::AutoUnlock auto_unlock(lock_);
+      success = WriteMpdStringToFile(output_path_, mpd);
+    }
+    write_in_progress_ = false;
+    last_write_success_ = success;
+    LOG_IF(ERROR, !success) << "Failed to publish MPD to " << output_path_;
+    published_.Broadcast();
+  }
+}
+
+}  // namespace shaka
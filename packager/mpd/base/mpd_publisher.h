@@ -0,0 +1,66 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MPD_BASE_MPD_PUBLISHER_H_
+#define MPD_BASE_MPD_PUBLISHER_H_
+
+#include <string>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/threading/simple_thread.h"
+
+namespace shaka {
+
+/// Writes serialized MPDs to their output location from a dedicated thread so
+/// that manifest I/O stays off the segment notification path. If publishing
+/// falls behind, queued versions are coalesced: only the most recently queued
+/// version is written. Local outputs are written to a temporary file and
+/// renamed into place so that concurrent readers never observe a partially
+/// written manifest.
+class MpdPublisher : public base::SimpleThread {
+ public:
+  /// Constructs an MpdPublisher and starts the publishing thread.
+  /// @param output_path is the path to the MPD output location.
+  explicit MpdPublisher(const std::string& output_path);
+
+  /// The destructor publishes any queued version and then joins the thread.
+  ~MpdPublisher() override;
+
+  /// Queues @a mpd for publishing and returns immediately. If a previous
+  /// version has not been written out yet, it is replaced by @a mpd.
+  /// @param mpd is the serialized MPD to publish.
+  void Publish(const std::string& mpd);
+
+  /// Blocks until every queued version has been written out.
+  /// @return true if the most recent write succeeded, false otherwise.
+  bool WaitForPublished();
+
+ protected:
+  /// SimpleThread implementation override.
+  void Run() override;
+
+ private:
+  const std::string output_path_;
+
+  base::Lock lock_;
+  // Signaled when |pending_mpd_| is set or |stopped_| becomes true.
+  base::ConditionVariable pending_available_;
+  // Signaled when a write completes.
+  base::ConditionVariable published_;
+  std::string pending_mpd_;
+  bool has_pending_;
+  bool write_in_progress_;
+  bool stopped_;
+  bool last_write_success_;
+
+  DISALLOW_COPY_AND_ASSIGN(MpdPublisher);
+};
+
+}  // namespace shaka
+
+#endif  // MPD_BASE_MPD_PUBLISHER_H_
@@ -10,6 +10,7 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/media/base/string_codecs.h"
 #include "packager/mpd/base/xml/scoped_xml_ptr.h"
 
 namespace shaka {
@@ -181,8 +182,8 @@ bool HexToUUID(const std::string& data, std::string* uuid_format) {
     return false;
   }
 
-  const std::string hex_encoded =
-      base::StringToLowerASCII(base::HexEncode(data.data(), data.size()));
+  const std::string hex_encoded = media::HexEncodeLower(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
   DCHECK_EQ(hex_encoded.size(), kExpectedUUIDSize * 2);
   base::StringPiece all(hex_encoded);
   // Note UUID has 5 parts separated with dashes.
@@ -313,13 +314,11 @@ void AddContentProtectionElementsHelperTemplated(
       drm_content_protection.value = entry.name_version();
 
     if (entry.has_pssh()) {
-      std::string base64_encoded_pssh;
-      base::Base64Encode(
-          base::StringPiece(entry.pssh().data(), entry.pssh().size()),
-          &base64_encoded_pssh);
       Element cenc_pssh;
       cenc_pssh.name = kPsshElementName;
-      cenc_pssh.content = base64_encoded_pssh;
+      cenc_pssh.content = media::Base64EncodeData(
+          reinterpret_cast<const uint8_t*>(entry.pssh().data()),
+          entry.pssh().size());
       drm_content_protection.subelements.push_back(cenc_pssh);
     }
 
@@ -7,6 +7,8 @@
 #ifndef MPD_BASE_SEGMENT_INFO_H_
 #define MPD_BASE_SEGMENT_INFO_H_
 
+#include <deque>
+
 namespace shaka {
 /// Container for keeping track of information about a segment.
 /// Used for keeping track of all the segments used for generating MPD with
@@ -21,6 +23,12 @@ struct SegmentInfo {
   // in the DASH MPD spec.
   uint64_t repeat;
 };
+
+/// The SegmentTimeline of a Representation, in segment start time order.
+/// Entries are appended at the back and expired from the front as the
+/// timeshift window slides, so a deque keeps both ends constant-time without
+/// paying an allocation per entry.
+typedef std::deque<SegmentInfo> SegmentInfos;
 }  // namespace shaka
 
 #endif  // MPD_BASE_SEGMENT_INFO_H_
@@ -7,6 +7,7 @@
 #include "packager/mpd/base/simple_mpd_notifier.h"
 
 #include "packager/base/logging.h"
+#include "packager/base/stl_util.h"
 #include "packager/mpd/base/mpd_builder.h"
 #include "packager/mpd/base/mpd_notifier_util.h"
 #include "packager/mpd/base/mpd_utils.h"
@@ -22,13 +23,15 @@ SimpleMpdNotifier::SimpleMpdNotifier(DashProfile dash_profile,
       mpd_builder_(new MpdBuilder(dash_profile == kLiveProfile
                                       ? MpdBuilder::kDynamic
                                       : MpdBuilder::kStatic,
-                                  mpd_options)) {
+                                  mpd_options)),
+      publisher_(new MpdPublisher(output_path)) {
   DCHECK(dash_profile == kLiveProfile || dash_profile == kOnDemandProfile);
   for (size_t i = 0; i < base_urls.size(); ++i)
     mpd_builder_->AddBaseUrl(base_urls[i]);
 }
 
 SimpleMpdNotifier::~SimpleMpdNotifier() {
+  STLDeleteValues(&adaptation_set_locks_);
 }
 
 bool SimpleMpdNotifier::Init() {
@@ -67,18 +70,24 @@ bool SimpleMpdNotifier::NotifyNewContainer(const MediaInfo& media_info,
   *container_id = representation->id();
   DCHECK(!ContainsKey(representation_map_, representation->id()));
   representation_map_[representation->id()] = representation;
+
+  base::Lock** adaptation_set_lock = &adaptation_set_locks_[*adaptation_set];
+  if (*adaptation_set_lock == NULL)
+    *adaptation_set_lock = new base::Lock;
+  representation_lock_map_[representation->id()] = *adaptation_set_lock;
   return true;
 }
 
 bool SimpleMpdNotifier::NotifySampleDuration(uint32_t container_id,
                                              uint32_t sample_duration) {
-  base::AutoLock auto_lock(lock_);
-  RepresentationMap::iterator it = representation_map_.find(container_id);
-  if (it == representation_map_.end()) {
-    LOG(ERROR) << "Unexpected container_id: " << container_id;
+  base::Lock* adaptation_set_lock = NULL;
+  Representation* representation =
+      GetRepresentation(container_id, &adaptation_set_lock);
+  if (representation == NULL)
     return false;
-  }
-  it->second->SetSampleDuration(sample_duration);
+
+  base::AutoLock auto_lock(*adaptation_set_lock);
+  representation->SetSampleDuration(sample_duration);
   return true;
 }
 
@@ -86,13 +95,16 @@ bool SimpleMpdNotifier::NotifyNewSegment(uint32_t container_id,
                                          uint64_t start_time,
                                          uint64_t duration,
                                          uint64_t size) {
-  base::AutoLock auto_lock(lock_);
-  RepresentationMap::iterator it = representation_map_.find(container_id);
-  if (it == representation_map_.end()) {
-    LOG(ERROR) << "Unexpected container_id: " << container_id;
+  base::Lock* adaptation_set_lock = NULL;
+  Representation* representation =
+      GetRepresentation(container_id, &adaptation_set_lock);
+  if (representation == NULL)
     return false;
-  }
-  it->second->AddNewSegment(start_time, duration, size);
+
+  // Only Representations in the same AdaptationSet contend here; the
+  // AdaptationSet tracks segment alignment across them.
+  base::AutoLock auto_lock(*adaptation_set_lock);
+  representation->AddNewSegment(start_time, duration, size);
   return true;
 }
 
@@ -101,33 +113,75 @@ bool SimpleMpdNotifier::NotifyEncryptionUpdate(
     const std::string& drm_uuid,
     const std::vector<uint8_t>& new_key_id,
     const std::vector<uint8_t>& new_pssh) {
-  base::AutoLock auto_lock(lock_);
-  RepresentationMap::iterator it = representation_map_.find(container_id);
-  if (it == representation_map_.end()) {
-    LOG(ERROR) << "Unexpected container_id: " << container_id;
+  base::Lock* adaptation_set_lock = NULL;
+  Representation* representation =
+      GetRepresentation(container_id, &adaptation_set_lock);
+  if (representation == NULL)
     return false;
-  }
-  it->second->UpdateContentProtectionPssh(drm_uuid,
-                                          Uint8VectorToBase64(new_pssh));
+
+  base::AutoLock auto_lock(*adaptation_set_lock);
+  representation->UpdateContentProtectionPssh(drm_uuid,
+                                              Uint8VectorToBase64(new_pssh));
   return true;
 }
 
 bool SimpleMpdNotifier::AddContentProtectionElement(
     uint32_t container_id,
     const ContentProtectionElement& content_protection_element) {
-  base::AutoLock auto_lock(lock_);
-  RepresentationMap::iterator it = representation_map_.find(container_id);
-  if (it == representation_map_.end()) {
-    LOG(ERROR) << "Unexpected container_id: " << container_id;
+  base::Lock* adaptation_set_lock = NULL;
+  Representation* representation =
+      GetRepresentation(container_id, &adaptation_set_lock);
+  if (representation == NULL)
     return false;
-  }
-  it->second->AddContentProtectionElement(content_protection_element);
+
+  base::AutoLock auto_lock(*adaptation_set_lock);
+  representation->AddContentProtectionElement(content_protection_element);
   return true;
 }
 
 bool SimpleMpdNotifier::Flush() {
   base::AutoLock auto_lock(lock_);
-  return WriteMpdToFile(output_path_, mpd_builder_.get());
+
+  // Exclude in-flight per-representation updates while serializing. The
+  // update paths never wait for an AdaptationSet lock while holding |lock_|,
+  // so acquiring all of them here cannot deadlock.
+  for (AdaptationSetLockMap::iterator it = adaptation_set_locks_.begin();
+       it != adaptation_set_locks_.end(); ++it) {
+    it->second->Acquire();
+  }
+  std::string mpd;
+  const bool success = mpd_builder_->ToString(&mpd);
+  for (AdaptationSetLockMap::iterator it = adaptation_set_locks_.begin();
+       it != adaptation_set_locks_.end(); ++it) {
+    it->second->Release();
+  }
+  if (!success) {
+    LOG(ERROR) << "Failed to write MPD to string.";
+    return false;
+  }
+
+  // For live, the MPD is flushed after every segment, so queue the write on
+  // the publisher thread and keep manifest I/O off the segment path. For
+  // on-demand, the MPD is written once at the end; wait for the write and
+  // report its result.
+  publisher_->Publish(mpd);
+  if (dash_profile() == kLiveProfile)
+    return true;
+  return publisher_->WaitForPublished();
+}
+
+Representation* SimpleMpdNotifier::GetRepresentation(
+    uint32_t container_id,
+    base::Lock** adaptation_set_lock) {
+  base::AutoLock auto_lock(lock_);
+  RepresentationMap::iterator it = representation_map_.find(container_id);
+  if (it == representation_map_.end()) {
+    LOG(ERROR) << "Unexpected container_id: " << container_id;
+    return NULL;
+  }
+  *adaptation_set_lock = representation_lock_map_[container_id];
+  DCHECK(*adaptation_set_lock);
+  return it->second;
 }
 
 }  // namespace shaka
@@ -16,6 +16,7 @@
 #include "packager/base/synchronization/lock.h"
 #include "packager/mpd/base/mpd_notifier.h"
 #include "packager/mpd/base/mpd_notifier_util.h"
+#include "packager/mpd/base/mpd_publisher.h"
 
 namespace shaka {
 
@@ -69,14 +70,38 @@ class SimpleMpdNotifier : public MpdNotifier {
     mpd_builder_ = mpd_builder.Pass();
   }
 
+  // Looks up the Representation for |container_id| and the lock of the
+  // AdaptationSet it belongs to. Returns NULL and logs an error if
+  // |container_id| is unknown.
+  Representation* GetRepresentation(uint32_t container_id,
+                                    base::Lock** adaptation_set_lock);
+
   // MPD output path.
   std::string output_path_;
   scoped_ptr<MpdBuilder> mpd_builder_;
+  scoped_ptr<MpdPublisher> publisher_;
+
+  // Guards the maps below and any change to the MpdBuilder structure
+  // (new AdaptationSets and Representations). Per-segment updates hold it
+  // only to look up the Representation; the update itself is guarded by the
+  // lock of the AdaptationSet the Representation belongs to, so muxer
+  // threads feeding different AdaptationSets do not serialize on each other.
+  // When both are held, |lock_| is always acquired first.
   base::Lock lock_;
 
   typedef std::map<std::string, AdaptationSet*> AdaptationSetMap;
   AdaptationSetMap adaptation_set_map_;
 
+  // Per-AdaptationSet locks for segment updates. Representations in the same
+  // AdaptationSet share one lock because the AdaptationSet tracks segment
+  // alignment across them. Values are owned and deleted in the destructor.
+  typedef std::map<AdaptationSet*, base::Lock*> AdaptationSetLockMap;
+  AdaptationSetLockMap adaptation_set_locks_;
+
+  // Maps Representation ID to the lock of its AdaptationSet.
+  typedef std::map<uint32_t, base::Lock*> RepresentationLockMap;
+  RepresentationLockMap representation_lock_map_;
+
   typedef std::map<uint32_t, Representation*> RepresentationMap;
   RepresentationMap representation_map_;
 
@@ -31,9 +31,9 @@ std::string RangeToString(const Range& range) {
          base::Uint64ToString(range.end());
 }
 
-bool PopulateSegmentTimeline(const std::list<SegmentInfo>& segment_infos,
+bool PopulateSegmentTimeline(const SegmentInfos& segment_infos,
                              XmlNode* segment_timeline) {
-  for (std::list<SegmentInfo>::const_iterator it = segment_infos.begin();
+  for (SegmentInfos::const_iterator it = segment_infos.begin();
        it != segment_infos.end();
        ++it) {
     XmlNode s_element("S");
@@ -111,9 +111,16 @@ void XmlNode::SetStringAttribute(const char* attribute_name,
 void XmlNode::SetIntegerAttribute(const char* attribute_name, uint64_t number) {
   DCHECK(node_);
   DCHECK(attribute_name);
-  xmlSetProp(node_.get(),
-             BAD_CAST attribute_name,
-             BAD_CAST (base::Uint64ToString(number).c_str()));
+  // This is called for every <S> element in every SegmentTimeline rebuild, so
+  // format into a stack buffer instead of going through std::string.
+  char buffer[21];  // Maximum uint64_t is 20 digits, plus the terminator.
+  char* pos = buffer + arraysize(buffer) - 1;
+  *pos = '\0';
+  do {
+    *--pos = '0' + static_cast<char>(number % 10);
+    number /= 10;
+  } while (number != 0);
+  xmlSetProp(node_.get(), BAD_CAST attribute_name, BAD_CAST pos);
 }
 
 void XmlNode::SetFloatingPointAttribute(const char* attribute_name,
@@ -297,7 +304,7 @@ bool RepresentationXmlNode::AddVODOnlyInfo(const MediaInfo& media_info) {
 
 bool RepresentationXmlNode::AddLiveOnlyInfo(
     const MediaInfo& media_info,
-    const std::list<SegmentInfo>& segment_infos,
+    const SegmentInfos& segment_infos,
     uint32_t start_number) {
   XmlNode segment_template("SegmentTemplate");
   if (media_info.has_reference_time_scale()) {
@@ -17,12 +17,11 @@
 
 #include "packager/mpd/base/content_protection_element.h"
 #include "packager/mpd/base/media_info.pb.h"
+#include "packager/mpd/base/segment_info.h"
 #include "packager/mpd/base/xml/scoped_xml_ptr.h"
 
 namespace shaka {
 
-struct SegmentInfo;
-
 namespace xml {
 
 /// These classes are wrapper classes for XML elements for generating MPD.
@@ -157,7 +156,7 @@ class RepresentationXmlNode : public RepresentationBaseXmlNode {
   /// @param segment_infos is a set of SegmentInfos. This method assumes that
   ///        SegmentInfos are sorted by its start time.
   bool AddLiveOnlyInfo(const MediaInfo& media_info,
-                       const std::list<SegmentInfo>& segment_infos,
+                       const SegmentInfos& segment_infos,
                        uint32_t start_number);
 
  private:
@@ -78,7 +78,7 @@ class RepresentationTest : public ::testing::Test {
 
  protected:
   RepresentationXmlNode representation_;
-  std::list<SegmentInfo> segment_infos_;
+  SegmentInfos segment_infos_;
 };
 
 // Make sure XmlEqual() is functioning correctly.
@@ -29,6 +29,18 @@
         '../third_party/protobuf/protobuf.gyp:protobuf_full_do_not_use',
       ],
     },
+    {
+      'target_name': 'mpd_bench',
+      'type': 'executable',
+      'sources': [
+        'test/mpd_bench.cc',
+      ],
+      'dependencies': [
+        '../base/base.gyp:base',
+        '../third_party/gflags/gflags.gyp:gflags',
+        'mpd_builder',
+      ],
+    },
     {
       'target_name': 'mpd_builder',
       'type': 'static_library',
@@ -47,6 +59,8 @@
         'base/mpd_notifier_util.h',
         'base/mpd_notifier.h',
         'base/mpd_options.h',
+        'base/mpd_publisher.cc',
+        'base/mpd_publisher.h',
         'base/mpd_utils.cc',
         'base/mpd_utils.h',
         'base/segment_info.h',
@@ -58,7 +72,9 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
+        '../media/base/media_base.gyp:media_base',
         '../media/file/file.gyp:file',
+        '../third_party/gflags/gflags.gyp:gflags',
         '../third_party/libxml/libxml.gyp:libxml',
         '../version/version.gyp:version',
         'media_info_proto',
@@ -0,0 +1,165 @@
+// Copyright 2016 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Benchmark for live MPD generation. Builds a multi-representation MPD and
+// applies a long run of simulated segment updates, reporting the time spent
+// per update and the peak resident set size. The defaults simulate 24 hours
+// of 2 second segments on a 40 representation ladder.
+
+#include <ctype.h>
+#include <gflags/gflags.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/at_exit.h"
+#include "packager/base/command_line.h"
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/logging.h"
+#include "packager/base/macros.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/time/time.h"
+#include "packager/mpd/base/dash_iop_mpd_notifier.h"
+#include "packager/mpd/base/media_info.pb.h"
+#include "packager/mpd/base/mpd_notifier.h"
+#include "packager/mpd/base/mpd_options.h"
+#include "packager/mpd/base/simple_mpd_notifier.h"
+
+DEFINE_int32(num_representations,
+             40,
+             "Number of video Representations in the generated MPD.");
+DEFINE_int32(num_segment_updates,
+             43200,
+             "Number of segment updates applied to every Representation. The "
+             "default simulates 24 hours of 2 second segments.");
+DEFINE_double(segment_duration, 2.0, "Segment duration in seconds.");
+DEFINE_double(time_shift_buffer_depth,
+              60.0,
+              "MPD@timeShiftBufferDepth in seconds. Bounds the size of each "
+              "SegmentTimeline as the live window slides.");
+
+namespace shaka {
+namespace {
+
+const uint32_t kTimeScale = 1000;
+const uint64_t kSegmentSizeBytes = 100 * 1024;
+
+// Returns the peak resident set size in kilobytes, or 0 where unavailable
+// (VmHWM is Linux-specific).
+int64_t GetPeakRssKb() {
+  std::string status;
+  if (!base::ReadFileToString(base::FilePath("/proc/self/status"), &status))
+    return 0;
+
+  const char kField[] = "VmHWM:";
+  size_t pos = status.find(kField);
+  if (pos == std::string::npos)
+    return 0;
+  pos += arraysize(kField) - 1;
+  while (pos < status.size() && (status[pos] == ' ' || status[pos] == '\t'))
+    ++pos;
+  int64_t kilobytes = 0;
+  while (pos < status.size() && isdigit(status[pos]))
+    kilobytes = kilobytes * 10 + (status[pos++] - '0');
+  return kilobytes;
+}
+
+MediaInfo MakeVideoMediaInfo(int index) {
+  MediaInfo media_info;
+  media_info.set_reference_time_scale(kTimeScale);
+  media_info.set_container_type(MediaInfo::CONTAINER_MP4);
+  media_info.set_bandwidth(500000 + index * 100000);
+  media_info.set_init_segment_name(
+      base::StringPrintf("video_%d_init.mp4", index));
+  media_info.set_segment_template(
+      base::StringPrintf("video_%d_$Number$.m4s", index));
+
+  MediaInfo::VideoInfo* video_info = media_info.mutable_video_info();
+  video_info->set_codec("avc1.4d401f");
+  video_info->set_time_scale(kTimeScale);
+  video_info->set_frame_duration(33);
+  video_info->set_width(640 + 16 * index);
+  video_info->set_height(360 + 9 * index);
+  video_info->set_pixel_width(1);
+  video_info->set_pixel_height(1);
+  return media_info;
+}
+
+void RunBenchmark(const char* name, MpdNotifier* notifier) {
+  std::vector<uint32_t> container_ids;
+  for (int i = 0; i < FLAGS_num_representations; ++i) {
+    uint32_t container_id = 0;
+    CHECK(notifier->NotifyNewContainer(MakeVideoMediaInfo(i), &container_id));
+    container_ids.push_back(container_id);
+  }
+
+  const uint64_t segment_duration =
+      static_cast<uint64_t>(FLAGS_segment_duration * kTimeScale);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int update = 0; update < FLAGS_num_segment_updates; ++update) {
+    const uint64_t start_time = update * segment_duration;
+    for (size_t i = 0; i < container_ids.size(); ++i) {
+      CHECK(notifier->NotifyNewSegment(container_ids[i], start_time,
+                                       segment_duration, kSegmentSizeBytes));
+    }
+    // Serialize and publish once per segment, matching what
+    // MpdNotifyMuxerListener does for live.
+    CHECK(notifier->Flush());
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  const double per_update_us =
+      elapsed.InMicroseconds() / static_cast<double>(FLAGS_num_segment_updates);
+  printf("%s: %d representations, %d segment updates\n", name,
+         FLAGS_num_representations, FLAGS_num_segment_updates);
+  printf("  total %.1f s, %.1f us per update, peak RSS %" PRId64 " kB\n",
+         elapsed.InSecondsF(), per_update_us, GetPeakRssKb());
+}
+
+int BenchMain(int argc, char** argv) {
+  base::AtExitManager exit;
+  base::CommandLine::Init(argc, argv);
+  CHECK(logging::InitLogging(logging::LoggingSettings()));
+
+  google::SetUsageMessage("Benchmark live MPD generation.");
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  base::FilePath temp_dir;
+  CHECK(base::CreateNewTempDirectory(base::FilePath::StringType(), &temp_dir));
+  const std::string output_path =
+      temp_dir.AppendASCII("bench.mpd").AsUTF8Unsafe();
+
+  MpdOptions mpd_options;
+  mpd_options.minimum_update_period = FLAGS_segment_duration;
+  mpd_options.time_shift_buffer_depth = FLAGS_time_shift_buffer_depth;
+  const std::vector<std::string> base_urls;
+
+  {
+    SimpleMpdNotifier notifier(kLiveProfile, mpd_options, base_urls,
+                               output_path);
+    CHECK(notifier.Init());
+    RunBenchmark("SimpleMpdNotifier", &notifier);
+  }
+  {
+    DashIopMpdNotifier notifier(kLiveProfile, mpd_options, base_urls,
+                                output_path);
+    CHECK(notifier.Init());
+    RunBenchmark("DashIopMpdNotifier", &notifier);
+  }
+
+  base::DeleteFile(temp_dir, true);
+  return 0;
+}
+
+}  // namespace
+}  // namespace shaka
+
+int main(int argc, char** argv) {
+  return shaka::BenchMain(argc, argv);
+}
@@ -10,6 +10,8 @@
 #include <google/protobuf/text_format.h>
 #include <stdint.h>
 
+#include <map>
+
 #include "packager/base/files/file_path.h"
 #include "packager/base/files/file_util.h"
 #include "packager/media/file/file.h"
@@ -59,6 +61,37 @@ class SimpleMpdNotifierFactory : public MpdNotifierFactory {
   }
 };
 
+// Merges MediaInfo files produced by time-range shards of one stream into a
+// single entry. Shards of a stream share its segment template, so entries
+// with the same non-empty template describe one representation: durations
+// add up and the highest observed bandwidth wins.
+std::list<MediaInfo> MergeShardMediaInfos(
+    const std::list<MediaInfo>& media_infos) {
+  std::list<MediaInfo> merged;
+  std::map<std::string, MediaInfo*> by_template;
+  for (std::list<MediaInfo>::const_iterator it = media_infos.begin();
+       it != media_infos.end(); ++it) {
+    if (it->has_segment_template() && !it->segment_template().empty()) {
+      std::map<std::string, MediaInfo*>::iterator existing =
+          by_template.find(it->segment_template());
+      if (existing != by_template.end()) {
+        MediaInfo* target = existing->second;
+        target->set_media_duration_seconds(target->media_duration_seconds() +
+                                           it->media_duration_seconds());
+        if (it->bandwidth() > target->bandwidth())
+          target->set_bandwidth(it->bandwidth());
+        continue;
+      }
+    }
+    merged.push_back(*it);
+    if (merged.back().has_segment_template() &&
+        !merged.back().segment_template().empty()) {
+      by_template[merged.back().segment_template()] = &merged.back();
+    }
+  }
+  return merged;
+}
+
 }  // namespace
 
 MpdWriter::MpdWriter()
@@ -103,8 +136,9 @@ bool MpdWriter::WriteMpdToFile(const char* file_name) {
     return false;
   }
 
-  for (std::list<MediaInfo>::const_iterator it = media_infos_.begin();
-       it != media_infos_.end();
+  const std::list<MediaInfo> media_infos = MergeShardMediaInfos(media_infos_);
+  for (std::list<MediaInfo>::const_iterator it = media_infos.begin();
+       it != media_infos.end();
        ++it) {
     uint32_t unused_conatiner_id;
     if (!notifier->NotifyNewContainer(*it, &unused_conatiner_id)) {
@@ -9,6 +9,21 @@
     'common.gypi',
   ],
   'targets': [
+    {
+      'target_name': 'stream_descriptor_preset_proto',
+      'type': 'static_library',
+      'sources': [
+        'app/stream_descriptor_preset.proto',
+      ],
+      'variables': {
+        'proto_in_dir': 'app',
+        'proto_out_dir': 'packager/app',
+      },
+      'includes': ['build/protoc.gypi'],
+      'dependencies': [
+        'third_party/protobuf/protobuf.gyp:protobuf_full_do_not_use',
+      ],
+    },
     {
       'target_name': 'packager',
       'type': 'executable',
@@ -17,15 +32,21 @@
         'app/fixed_key_encryption_flags.h',
         'app/hls_flags.cc',
         'app/hls_flags.h',
+        'app/hot_config.cc',
+        'app/hot_config.h',
         'app/libcrypto_threading.cc',
         'app/libcrypto_threading.h',
         'app/mpd_flags.cc',
         'app/mpd_flags.h',
         'app/muxer_flags.cc',
         'app/muxer_flags.h',
+        'app/packager.cc',
+        'app/packager.h',
         'app/packager_main.cc',
         'app/packager_util.cc',
         'app/packager_util.h',
+        'app/sampling_profiler.cc',
+        'app/sampling_profiler.h',
         'app/stream_descriptor.cc',
         'app/stream_descriptor.h',
         'app/validate_flag.cc',
@@ -47,6 +68,7 @@
         'media/formats/webvtt/webvtt.gyp:webvtt',
         'media/formats/wvm/wvm.gyp:wvm',
         'mpd/mpd.gyp:mpd_builder',
+        'stream_descriptor_preset_proto',
         'third_party/boringssl/boringssl.gyp:boringssl',
         'third_party/gflags/gflags.gyp:gflags',
       ],
@@ -69,6 +91,7 @@
       ],
       'dependencies': [
         'base/base.gyp:base',
+        'media/file/file.gyp:file',
         'mpd/mpd.gyp:mpd_util',
         'third_party/gflags/gflags.gyp:gflags',
       ],
@@ -92,6 +115,32 @@
         'testing/gtest.gyp:gtest',
       ],
     },
+    {
+      'target_name': 'packager_bench',
+      'type': 'executable',
+      'sources': [
+        'media/test/packager_benchmark.cc',
+      ],
+      'dependencies': [
+        'base/base.gyp:base',
+        'media/base/media_base.gyp:media_base',
+        'media/codecs/codecs.gyp:codecs',
+        'media/file/file.gyp:file',
+        'media/formats/mp2t/mp2t.gyp:mp2t',
+        'media/formats/mp4/mp4.gyp:mp4',
+        'media/formats/mpeg/mpeg.gyp:mpeg',
+        'media/formats/webm/webm.gyp:webm',
+        'media/formats/webvtt/webvtt.gyp:webvtt',
+        'media/formats/wvm/wvm.gyp:wvm',
+        'media/test/media_test.gyp:media_test_support',
+      ],
+      'copies': [{
+        'destination': '<(PRODUCT_DIR)',
+        'files': [
+          'media/test/packager_bench_thresholds',
+        ],
+      }],
+    },
     {
       'target_name': 'packager_test_py_copy',
       'type': 'none',
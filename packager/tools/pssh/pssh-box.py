@@ -225,6 +225,77 @@ def _parse_playready_data(data):
   return ret
 
 
+def _read_box_header(reader):
+  """Reads an ISO-BMFF box header; returns (size, type, header_size)."""
+  start = reader.position
+  size = reader.read_int(4)
+  box_type = reader.read_bytes(4)
+  if size == 1:
+    size = reader.read_int(8)
+  elif size == 0:
+    size = len(reader.data) - start
+  return size, box_type, reader.position - start
+
+
+def _extract_pssh_from_mp4(data):
+  """Extracts the concatenated PSSH boxes from the moov box of an MP4 file."""
+  reader = BinaryReader(data, little_endian=False)
+  while reader.has_data():
+    start = reader.position
+    size, box_type, header_size = _read_box_header(reader)
+    if box_type == b'moov':
+      pssh_data = ''
+      end = start + size
+      pos = start + header_size
+      while pos < end:
+        reader.position = pos
+        child_size, child_type, _ = _read_box_header(reader)
+        if child_type == b'pssh':
+          pssh_data += data[pos:pos + child_size]
+        pos += child_size
+      return pssh_data
+    reader.position = start + size
+  raise Exception('No moov box found in the MP4 file')
+
+
+def _replace_pssh_in_mp4(data, pssh_data):
+  """Returns a copy of MP4 data with the moov box's PSSH boxes replaced.
+
+  The media data is untouched, so this derives a variant of a packaged file
+  that differs only in DRM signaling.  Only meant for fragmented MP4 files;
+  chunk offsets in progressive files are not adjusted for the size change.
+  """
+  reader = BinaryReader(data, little_endian=False)
+  while reader.has_data():
+    start = reader.position
+    size, box_type, header_size = _read_box_header(reader)
+    if box_type != b'moov':
+      reader.position = start + size
+      continue
+    if header_size != 8 or data[start:start + 4] == '\0\0\0\0':
+      raise Exception('Unsupported moov box size')
+
+    # Keep the other children in their original order; the packager writes
+    # pssh boxes last, so append the replacements at the end.
+    new_children = ''
+    end = start + size
+    pos = start + header_size
+    while pos < end:
+      reader.position = pos
+      child_size, child_type, _ = _read_box_header(reader)
+      if child_type != b'pssh':
+        new_children += data[pos:pos + child_size]
+      pos += child_size
+    new_moov = (_create_bin_int(8 + len(new_children) + len(pssh_data)) +
+                b'moov' + new_children + pssh_data)
+    if len(new_moov) != size and b'mdat' in data:
+      print >> sys.stderr, ('Warning: the moov box size changed; chunk '
+                            'offsets in progressive MP4 files are not '
+                            'adjusted')
+    return data[:start] + new_moov + data[start + size:]
+  raise Exception('No moov box found in the MP4 file')
+
+
 def _parse_boxes(data):
   """Parses one or more PSSH boxes for the given binary data."""
   reader = BinaryReader(data, little_endian=False)
@@ -276,6 +347,10 @@ def _create_argument_parser():
   def hex_bytes(string):
     return base64.b16decode(string.upper())
 
+  def mp4_pssh(string):
+    with open(string, 'rb') as f:
+      return _extract_pssh_from_mp4(f.read())
+
   parser = argparse.ArgumentParser(
       formatter_class=argparse.RawDescriptionHelpFormatter,
       usage='[--base64 | --hex | --human] options [-- options [-- ...]',
@@ -293,7 +368,14 @@ it will appear before the generated one.
 An alternative to --pssh-data is to generate Widevine PSSH data.  This is only
 valid with --widevine-system-id.  Passing --content-id will make it generate
 Widevine PSSH data instead.  You can optionally add --provider.  It will
-generate a v0 PSSH box for compatibility reasons.""")
+generate a v0 PSSH box for compatibility reasons.
+
+PSSH boxes can also be read from a packaged MP4 file with --from-mp4, and
+written back with --inject-mp4, which copies the input file and replaces the
+PSSH boxes in its moov box with the boxes assembled here.  This derives
+per-DRM variants of identical content from a single packaging pass by
+rewriting only the DRM signaling.  Injection is meant for init segments of
+fragmented MP4 files; chunk offsets in progressive files are not adjusted.""")
 
   formats = parser.add_mutually_exclusive_group()
   formats.add_argument('--base64',
@@ -311,6 +393,12 @@ generate a v0 PSSH box for compatibility reasons.""")
                        action='store_const',
                        const='human',
                        help='Output a human readable string')
+  formats.add_argument('--inject-mp4',
+                       metavar=('<input-mp4>', '<output-mp4>'),
+                       dest='inject_mp4',
+                       nargs=2,
+                       help='Copy the input MP4 file to the output path with '
+                            'its PSSH boxes replaced by the boxes given here')
 
   inputs = parser.add_mutually_exclusive_group()
   inputs.add_argument('--from-base64',
@@ -323,6 +411,11 @@ generate a v0 PSSH box for compatibility reasons.""")
                       dest='input',
                       type=hex_bytes,
                       help='Parse the given hexadecimal encoded PSSH box')
+  inputs.add_argument('--from-mp4',
+                      metavar='<file-name>',
+                      dest='input',
+                      type=mp4_pssh,
+                      help='Parse the PSSH boxes in the moov box of the file')
 
   system_ids = parser.add_mutually_exclusive_group()
   system_ids.add_argument('--system-id',
@@ -365,16 +458,24 @@ generate a v0 PSSH box for compatibility reasons.""")
 def main(all_args):
   boxes = []
   output_format = None
+  inject_mp4 = None
   parser = _create_argument_parser()
   arg_groups = _split_list_on(all_args, '--')
   for args in arg_groups:
     ns = parser.parse_args(args)
 
     if ns.format:
-      if output_format:
-        raise Exception('Can only specify one of: --base64, --hex, --human')
+      if output_format or inject_mp4:
+        raise Exception('Can only specify one of: --base64, --hex, --human, '
+                        '--inject-mp4')
       else:
         output_format = ns.format
+    if ns.inject_mp4:
+      if output_format or inject_mp4:
+        raise Exception('Can only specify one of: --base64, --hex, --human, '
+                        '--inject-mp4')
+      else:
+        inject_mp4 = ns.inject_mp4
 
     if ns.input:
       boxes.extend(_parse_boxes(ns.input))
@@ -396,7 +497,13 @@ def main(all_args):
     version = 1 if ns.key_id and not ns.content_id else 0
     boxes.append(Pssh(version, ns.system_id, ns.key_id, pssh_data))
 
-  if output_format == 'human' or not output_format:
+  if inject_mp4:
+    with open(inject_mp4[0], 'rb') as f:
+      mp4_data = f.read()
+    box_data = ''.join([x.binary_string() for x in boxes])
+    with open(inject_mp4[1], 'wb') as f:
+      f.write(_replace_pssh_in_mp4(mp4_data, box_data))
+  elif output_format == 'human' or not output_format:
     for box in boxes:
       print box.human_string()
   else: